@@ -77,9 +77,11 @@ static void exchange2ical_init(TALLOC_CTX *mem_ctx, struct exchange2ical *exchan
 	exchange2ical->SenderEmailAddress = NULL;
 	exchange2ical->ReminderSet = NULL;
 	exchange2ical->ReminderDelta = NULL;
+	exchange2ical->HasAttach = NULL;
 	exchange2ical->vevent = NULL;
 	exchange2ical->valarm = NULL;
 	exchange2ical->bodyHTML = NULL;
+	exchange2ical->message_open = false;
 	exchange2ical->idx=0;
 }
 
@@ -154,9 +156,11 @@ static void exchange2ical_reset(struct exchange2ical *exchange2ical)
 	exchange2ical->SenderEmailAddress = NULL;
 	exchange2ical->ReminderSet = NULL;
 	exchange2ical->ReminderDelta = NULL;
+	exchange2ical->HasAttach = NULL;
 	exchange2ical->vevent = NULL;
 	exchange2ical->valarm = NULL;
 	exchange2ical->bodyHTML = NULL;
+	exchange2ical->message_open = false;
 	exchange2ical->TimeZoneDesc = NULL;
 	exchange2ical->TimeZoneStruct = NULL;
 }
@@ -246,6 +250,7 @@ static int exchange2ical_get_properties(TALLOC_CTX *mem_ctx, struct SRow *aRow,
 		exchange2ical->OwnerApptId = (uint32_t *) octool_get_propval(aRow, PR_OWNER_APPT_ID);
 		exchange2ical->SenderName = (const char *) octool_get_propval(aRow, PR_SENDER_NAME);
 		exchange2ical->SenderEmailAddress = (const char *) octool_get_propval(aRow, PR_SENDER_EMAIL_ADDRESS);
+		exchange2ical->HasAttach = (uint8_t *) octool_get_propval(aRow, PR_HASATTACH);
 	}
 	
 	return 0;
@@ -455,7 +460,8 @@ static uint8_t exchange2ical_exception_from_EmbeddedObj(struct exchange2ical *ex
 						retval = OpenEmbeddedMessage(&obj_attach, &exception.obj_message, MAPI_READONLY);
 						if (retval != MAPI_E_SUCCESS) {
 							return 1;
-						}else {							
+						}else {
+							exception.message_open = true;							
  							SPropTagArray = set_SPropTagArray(exchange2ical->mem_ctx, 0x2d,
 												PidLidFExceptionalBody,
 												PidLidRecurring,
@@ -591,6 +597,241 @@ static uint8_t exchange2ical_exception_from_EmbeddedObj(struct exchange2ical *ex
 	return 0;	
 }
 
+/*
+   Properties needed to build a VEVENT. They are fetched as table
+   columns, except PidLidAppointmentRecur which is too large to be
+   returned reliably in a table row and is only read from the message.
+ */
+static const enum MAPITAGS exchange2ical_proptags[] = {
+	PidLidGlobalObjectId,
+	PidNameKeywords,
+	PidLidRecurring,
+	PidLidAppointmentRecur,
+	PidLidAppointmentStateFlags,
+	PidLidTimeZoneDescription,
+	PidLidTimeZoneStruct,
+	PidLidContacts,
+	PidLidAppointmentStartWhole,
+	PidLidAppointmentEndWhole,
+	PidLidAppointmentSubType,
+	PidLidOwnerCriticalChange,
+	PidLidLocation,
+	PidLidNonSendableBcc,
+	PidLidAppointmentSequence,
+	PidLidBusyStatus,
+	PidLidIntendedBusyStatus,
+	PidLidAttendeeCriticalChange,
+	PidLidAppointmentReplyTime,
+	PidLidAppointmentNotAllowPropose,
+	PidLidAllowExternalCheck,
+	PidLidAppointmentLastSequence,
+	PidLidAppointmentSequenceTime,
+	PidLidAutoFillLocation,
+	PidLidAutoStartCheck,
+	PidLidCollaborateDoc,
+	PidLidConferencingCheck,
+	PidLidConferencingType,
+	PidLidDirectory,
+	PidLidMeetingWorkspaceUrl,
+	PidLidNetShowUrl,
+	PidLidOnlinePassword,
+	PidLidOrganizerAlias,
+	PidLidReminderSet,
+	PidLidReminderDelta,
+	PidLidResponseStatus,
+	PR_MESSAGE_CLASS_UNICODE,
+	PR_SENSITIVITY,
+	PR_BODY_UNICODE,
+	PR_CREATION_TIME,
+	PR_LAST_MODIFICATION_TIME,
+	PR_IMPORTANCE,
+	PR_RESPONSE_REQUESTED,
+	PR_SUBJECT_UNICODE,
+	PR_OWNER_APPT_ID,
+	PR_SENDER_NAME,
+	PR_SENDER_EMAIL_ADDRESS,
+	PR_MESSAGE_LOCALE_ID,
+	PR_HASATTACH
+};
+
+/* Number of rows fetched per QueryRows call */
+#define	EXCHANGE2ICAL_BATCH	0x100
+
+/* Table cells are truncated to 255 characters */
+#define	EXCHANGE2ICAL_TRUNCATED	255
+
+static struct SPropTagArray *exchange2ical_get_proptags(TALLOC_CTX *mem_ctx, bool columns)
+{
+	struct SPropTagArray	*SPropTagArray;
+	uint32_t		i;
+
+	if (columns) {
+		SPropTagArray = set_SPropTagArray(mem_ctx, 0x3, PR_FID, PR_MID, PR_NATIVE_BODY_INFO);
+	} else {
+		SPropTagArray = set_SPropTagArray(mem_ctx, 0x0);
+	}
+
+	for (i = 0; i < sizeof (exchange2ical_proptags) / sizeof (exchange2ical_proptags[0]); i++) {
+		if (columns && exchange2ical_proptags[i] == PidLidAppointmentRecur) continue;
+		SPropTagArray_add(mem_ctx, SPropTagArray, exchange2ical_proptags[i]);
+	}
+
+	return SPropTagArray;
+}
+
+
+/*
+   Resolve the named properties of the columns array. SetColumns,
+   Restrict and QueryRows do not map named properties, unlike GetProps:
+   the mapped array is returned while columns keeps the canonical tags.
+ */
+static struct SPropTagArray *exchange2ical_map_columns(TALLOC_CTX *mem_ctx, mapi_object_t *obj_folder,
+						       struct SPropTagArray *columns)
+{
+	enum MAPISTATUS		retval;
+	struct mapi_nameid	*nameid;
+	struct SPropTagArray	*mapped;
+	struct SPropTagArray	*SPropTagArray;
+
+	mapped = talloc_zero(mem_ctx, struct SPropTagArray);
+	mapped->cValues = columns->cValues;
+	mapped->aulPropTag = talloc_memdup(mapped, columns->aulPropTag, columns->cValues * sizeof (enum MAPITAGS));
+
+	nameid = mapi_nameid_new(mem_ctx);
+	retval = mapi_nameid_lookup_SPropTagArray(nameid, mapped);
+	if (retval == MAPI_E_SUCCESS) {
+		SPropTagArray = talloc_zero(mem_ctx, struct SPropTagArray);
+		retval = GetIDsFromNames(obj_folder, nameid->count, nameid->nameid, 0, &SPropTagArray);
+		if (retval != MAPI_E_SUCCESS) {
+			talloc_free(nameid);
+			talloc_free(mapped);
+			return NULL;
+		}
+		mapi_nameid_map_SPropTagArray(nameid, mapped, SPropTagArray);
+		MAPIFreeBuffer(SPropTagArray);
+	}
+	talloc_free(nameid);
+
+	return mapped;
+}
+
+
+/*
+   Restore the canonical property tags of a table row. Unlike
+   mapi_nameid_unmap_SPropValue, errors keep their PT_ERROR type so
+   missing properties are not mistaken for values.
+ */
+static void exchange2ical_unmap_row(struct SRow *aRow, struct SPropTagArray *columns)
+{
+	uint32_t	i;
+
+	for (i = 0; i < aRow->cValues && i < columns->cValues; i++) {
+		if ((aRow->lpProps[i].ulPropTag & 0xFFFF) == PT_ERROR) {
+			aRow->lpProps[i].ulPropTag = (enum MAPITAGS)((columns->aulPropTag[i] & 0xFFFF0000) | PT_ERROR);
+		} else {
+			aRow->lpProps[i].ulPropTag = columns->aulPropTag[i];
+		}
+	}
+}
+
+
+/*
+   Push the date range to the server so only candidate appointments
+   are returned. Like checkEvent, a recurring series is selected by
+   the start of its first instance: checkEvent still runs on each row.
+ */
+static enum MAPISTATUS exchange2ical_restrict(TALLOC_CTX *mem_ctx, mapi_object_t *obj_table,
+					      struct SPropTagArray *columns, struct SPropTagArray *mapped,
+					      struct exchange2ical_check *exchange2ical_check)
+{
+	struct mapi_SRestriction	res;
+	struct mapi_SRestriction_and	*time_restrictions;
+	struct tm			*bounds[2];
+	enum MAPITAGS			proptag = 0;
+	time_t				t;
+	NTTIME				nt_time;
+	uint32_t			i;
+
+	for (i = 0; i < columns->cValues; i++) {
+		if (columns->aulPropTag[i] == PidLidAppointmentStartWhole) {
+			proptag = mapped->aulPropTag[i];
+			break;
+		}
+	}
+	if (!proptag || (proptag & 0xFFFF) != PT_SYSTIME) return MAPI_E_NOT_FOUND;
+
+	bounds[0] = exchange2ical_check->begin;
+	bounds[1] = exchange2ical_check->end;
+
+	time_restrictions = talloc_array(mem_ctx, struct mapi_SRestriction_and, 2);
+	res.rt = RES_AND;
+	res.res.resAnd.cRes = 0;
+	res.res.resAnd.res = time_restrictions;
+
+	for (i = 0; i < 2; i++) {
+		if (!bounds[i]) continue;
+		t = mktime(bounds[i]);
+		if (t == -1) continue;
+		unix_to_nt_time(&nt_time, t);
+
+		time_restrictions[res.res.resAnd.cRes].rt = RES_PROPERTY;
+		time_restrictions[res.res.resAnd.cRes].res.resProperty.relop = i ? RELOP_LE : RELOP_GE;
+		time_restrictions[res.res.resAnd.cRes].res.resProperty.ulPropTag = proptag;
+		time_restrictions[res.res.resAnd.cRes].res.resProperty.lpProp.ulPropTag = proptag;
+		time_restrictions[res.res.resAnd.cRes].res.resProperty.lpProp.value.ft.dwLowDateTime = (nt_time & 0xffffffff);
+		time_restrictions[res.res.resAnd.cRes].res.resProperty.lpProp.value.ft.dwHighDateTime = nt_time >> 32;
+		res.res.resAnd.cRes++;
+	}
+
+	if (!res.res.resAnd.cRes) {
+		talloc_free(time_restrictions);
+		return MAPI_E_SUCCESS;
+	}
+
+	return Restrict(obj_table, &res, NULL);
+}
+
+
+/*
+   Tell whether the table row is enough to build the VEVENT or if the
+   message has to be opened: recurrence blobs, attachments, recipients
+   and HTML bodies are not available as table columns, and long bodies
+   are truncated.
+ */
+static bool exchange2ical_need_message(struct SRow *aRow)
+{
+	const uint8_t	*recurring;
+	const uint8_t	*hasattach;
+	const uint32_t	*stateflags;
+	const uint32_t	*nativebody;
+	const uint32_t	*error;
+	const char	*body;
+
+	recurring = (const uint8_t *) octool_get_propval(aRow, PidLidRecurring);
+	if (recurring && *recurring) return true;
+
+	/* Attachments can only be listed from the message */
+	hasattach = (const uint8_t *) octool_get_propval(aRow, PR_HASATTACH);
+	if (!hasattach || *hasattach) return true;
+
+	/* Meetings need the recipient table for ATTENDEE and ORGANIZER */
+	stateflags = (const uint32_t *) octool_get_propval(aRow, PidLidAppointmentStateFlags);
+	if (stateflags && (*stateflags & 0x1)) return true;
+
+	/* RTF and HTML bodies provide X-ALT-DESC */
+	nativebody = (const uint32_t *) octool_get_propval(aRow, PR_NATIVE_BODY_INFO);
+	if (nativebody && (*nativebody == 0x2 || *nativebody == 0x3)) return true;
+
+	body = (const char *) octool_get_propval(aRow, PR_BODY_UNICODE);
+	if (body && strlen(body) >= EXCHANGE2ICAL_TRUNCATED) return true;
+
+	error = (const uint32_t *) octool_get_propval(aRow, (PR_BODY_UNICODE & 0xFFFF0000) | PT_ERROR);
+	if (error && *error != MAPI_E_NOT_FOUND) return true;
+
+	return false;
+}
+
+
 icalcomponent * _Exchange2Ical(mapi_object_t *obj_folder, struct exchange2ical_check *exchange2ical_check)
 {
 	TALLOC_CTX			*mem_ctx;
@@ -600,10 +841,16 @@ icalcomponent * _Exchange2Ical(mapi_object_t *obj_folder, struct exchange2ical_c
 	struct SRow			aRow;
 	struct SRow			aRowT;
 	struct SPropValue		*lpProps;
+	struct SPropValue		*lpPropsHTML;
 	struct SPropTagArray		*SPropTagArray = NULL;
+	struct SPropTagArray		*columns;
+	struct SPropTagArray		*mapped;
 	struct exchange2ical		exchange2ical;
 	mapi_object_t			obj_table;
 	uint32_t			count;
+	uint32_t			rows = 0;
+	uint32_t			opened = 0;
+	bool				open_message;
 	int				i;
 
 	mem_ctx = talloc_named(mapi_object_get_session(obj_folder), 0, "exchange2ical");
@@ -619,150 +866,132 @@ icalcomponent * _Exchange2Ical(mapi_object_t *obj_folder, struct exchange2ical_c
 	
 	DEBUG(0, ("MAILBOX (%d appointments)\n", count));
 	if (count == 0) {
+		mapi_object_release(&obj_table);
+		talloc_free(mem_ctx);
+		return NULL;
+	}
+
+	/* Fetch the appointment properties as columns */
+	columns = exchange2ical_get_proptags(mem_ctx, true);
+	mapped = exchange2ical_map_columns(mem_ctx, obj_folder, columns);
+	if (!mapped) {
+		mapi_errstr("GetIDsFromNames", GetLastError());
+		mapi_object_release(&obj_table);
 		talloc_free(mem_ctx);
 		return NULL;
 	}
 
-	SPropTagArray = set_SPropTagArray(mem_ctx, 0x2,
-					  PR_FID,
-					  PR_MID);
-					  
-	retval = SetColumns(&obj_table, SPropTagArray);
-	MAPIFreeBuffer(SPropTagArray);
+	retval = SetColumns(&obj_table, mapped);
 	if (retval != MAPI_E_SUCCESS) {
 		mapi_errstr("SetColumns", retval);
+		mapi_object_release(&obj_table);
 		talloc_free(mem_ctx);
 		return NULL;
 	}
-	
-	while ((retval = QueryRows(&obj_table, count, TBL_ADVANCE, &SRowSet)) != MAPI_E_NOT_FOUND && SRowSet.cRows) {
-		count -= SRowSet.cRows;
+
+	if (exchange2ical_check->eFlags & RangeFlag) {
+		retval = exchange2ical_restrict(mem_ctx, &obj_table, columns, mapped, exchange2ical_check);
+		if (retval != MAPI_E_SUCCESS) {
+			DEBUG(1, ("exchange2ical: date range filtered client side (%s)\n", mapi_get_errstr(retval)));
+		}
+	}
+
+	while ((retval = QueryRows(&obj_table, EXCHANGE2ICAL_BATCH, TBL_ADVANCE, &SRowSet)) != MAPI_E_NOT_FOUND && SRowSet.cRows) {
+		rows += SRowSet.cRows;
 		for (i = (SRowSet.cRows-1); i >= 0; i--) {
+			exchange2ical_unmap_row(&SRowSet.aRow[i], columns);
+
+			/*Get Vcal info if first event*/
+			if (!exchange2ical.vcalendar) {
+				ret = exchange2ical_get_properties(mem_ctx, &SRowSet.aRow[i], &exchange2ical, VcalFlag);
+				/*TODO: exit nicely*/
+				ical_component_VCALENDAR(&exchange2ical);
+			}
+
+			/*Get required properties to check if right event*/
+			ret = exchange2ical_get_properties(mem_ctx, &SRowSet.aRow[i], &exchange2ical, exchange2ical_check->eFlags);
+
+			/*Check to see if event is acceptable*/
+			if (!checkEvent(&exchange2ical, exchange2ical_check, get_tm_from_FILETIME(exchange2ical.apptStartWhole))){
+				continue;
+			}
+
+			lpProps = NULL;
+			lpPropsHTML = NULL;
 			mapi_object_init(&exchange2ical.obj_message);
-			retval = OpenMessage(obj_folder,
-					     SRowSet.aRow[i].lpProps[0].value.d,
-					     SRowSet.aRow[i].lpProps[1].value.d,
-					     &exchange2ical.obj_message, 0);
-			if (retval != MAPI_E_NOT_FOUND) {
-				SPropTagArray = set_SPropTagArray(mem_ctx, 0x30,
-								  PidLidGlobalObjectId,
-								  PidNameKeywords,
-								  PidLidRecurring,
-								  PidLidAppointmentRecur,
-								  PidLidAppointmentStateFlags,
-								  PidLidTimeZoneDescription,
-								  PidLidTimeZoneStruct,
-								  PidLidContacts,
-								  PidLidAppointmentStartWhole,
-								  PidLidAppointmentEndWhole,
-								  PidLidAppointmentSubType,
-								  PidLidOwnerCriticalChange,
-								  PidLidLocation,
-								  PidLidNonSendableBcc,
-								  PidLidAppointmentSequence,
-								  PidLidBusyStatus,
-								  PidLidIntendedBusyStatus,
-								  PidLidAttendeeCriticalChange,
-								  PidLidAppointmentReplyTime,
-								  PidLidAppointmentNotAllowPropose,
-								  PidLidAllowExternalCheck,
-								  PidLidAppointmentLastSequence,
-								  PidLidAppointmentSequenceTime,
-								  PidLidAutoFillLocation,
-								  PidLidAutoStartCheck,
-								  PidLidCollaborateDoc,
-								  PidLidConferencingCheck,
-								  PidLidConferencingType,
-								  PidLidDirectory,
-								  PidLidMeetingWorkspaceUrl,
-								  PidLidNetShowUrl,
-								  PidLidOnlinePassword,
-								  PidLidOrganizerAlias,
-								  PidLidReminderSet,
-								  PidLidReminderDelta,
-								  PidLidResponseStatus,
-								  PR_MESSAGE_CLASS_UNICODE,
-								  PR_SENSITIVITY,
-								  PR_BODY_UNICODE,
-								  PR_CREATION_TIME,
-								  PR_LAST_MODIFICATION_TIME,
-								  PR_IMPORTANCE,
-								  PR_RESPONSE_REQUESTED,
-								  PR_SUBJECT_UNICODE,
-								  PR_OWNER_APPT_ID,
-								  PR_SENDER_NAME,
-								  PR_SENDER_EMAIL_ADDRESS,
-								  PR_MESSAGE_LOCALE_ID
-								  );
-								  
-								  
-				retval = GetProps(&exchange2ical.obj_message, MAPI_UNICODE, SPropTagArray, &lpProps, &count);
+			open_message = exchange2ical_need_message(&SRowSet.aRow[i]);
+			if (open_message) {
+				retval = OpenMessage(obj_folder,
+						     SRowSet.aRow[i].lpProps[0].value.d,
+						     SRowSet.aRow[i].lpProps[1].value.d,
+						     &exchange2ical.obj_message, 0);
+				if (retval == MAPI_E_NOT_FOUND) {
+					mapi_object_release(&exchange2ical.obj_message);
+					continue;
+				}
+				exchange2ical.message_open = (retval == MAPI_E_SUCCESS);
+				opened++;
 
+				SPropTagArray = exchange2ical_get_proptags(mem_ctx, false);
+				retval = GetProps(&exchange2ical.obj_message, MAPI_UNICODE, SPropTagArray, &lpProps, &count);
 				MAPIFreeBuffer(SPropTagArray);
-	
-				if (retval == MAPI_E_SUCCESS) {
-					aRow.ulAdrEntryPad = 0;
-					aRow.cValues = count;
-					aRow.lpProps = lpProps;
-					
-					/*Get Vcal info if first event*/
-					if(i==(SRowSet.cRows-1)){
-						ret = exchange2ical_get_properties(mem_ctx, &aRow, &exchange2ical, VcalFlag);
-						/*TODO: exit nicely*/
-						ical_component_VCALENDAR(&exchange2ical);
-					}
-					
-					
-					/*Get required properties to check if right event*/
-					ret = exchange2ical_get_properties(mem_ctx, &aRow, &exchange2ical, exchange2ical_check->eFlags);
-					
-					/*Check to see if event is acceptable*/
-					if (!checkEvent(&exchange2ical, exchange2ical_check, get_tm_from_FILETIME(exchange2ical.apptStartWhole))){
-						continue;
-					}
-					
-					/*Set RecipientTable*/
-					retval = GetRecipientTable(&exchange2ical.obj_message, 
+				if (retval != MAPI_E_SUCCESS) {
+					mapi_object_release(&exchange2ical.obj_message);
+					continue;
+				}
+				aRow.ulAdrEntryPad = 0;
+				aRow.cValues = count;
+				aRow.lpProps = lpProps;
+
+				/*Set RecipientTable*/
+				retval = GetRecipientTable(&exchange2ical.obj_message, 
 							   &exchange2ical.Recipients.SRowSet,
 							   &exchange2ical.Recipients.SPropTagArray);
-					
-					/*Set PR_BODY_HTML for x_alt_desc property*/
-					SPropTagArray = set_SPropTagArray(mem_ctx, 0x1, PR_BODY_HTML_UNICODE);
-					retval = GetProps(&exchange2ical.obj_message, MAPI_UNICODE, SPropTagArray, &lpProps, &count);
-					MAPIFreeBuffer(SPropTagArray);
-					if (retval == MAPI_E_SUCCESS) {
-						aRowT.ulAdrEntryPad = 0;
-						aRowT.cValues = count;
-						aRowT.lpProps = lpProps;
-						exchange2ical.bodyHTML = (const char *)octool_get_propval(&aRowT, PR_BODY_HTML_UNICODE);
-					}
-					
-					/*Get rest of properties*/
-					ret = exchange2ical_get_properties(mem_ctx, &aRow, &exchange2ical, (exchange2ical_check->eFlags | EntireFlag));
-					
-					/*add new vevent*/
-					ical_component_VEVENT(&exchange2ical);
-					
-					/*Exceptions to event*/
-					if(exchange2ical_check->eFlags != EventFlag){
-						ret = exchange2ical_exception_from_EmbeddedObj(&exchange2ical, exchange2ical_check);
-						if (ret){
-							ret=exchange2ical_exception_from_ExceptionInfo(&exchange2ical, exchange2ical_check);
-						}
-					}
-					
-					/*REMOVE once globalobjid is fixed*/
-					exchange2ical.idx++;
-					
-					MAPIFreeBuffer(lpProps);
-					exchange2ical_reset(&exchange2ical);
+
+				/*Set PR_BODY_HTML for x_alt_desc property*/
+				SPropTagArray = set_SPropTagArray(mem_ctx, 0x1, PR_BODY_HTML_UNICODE);
+				retval = GetProps(&exchange2ical.obj_message, MAPI_UNICODE, SPropTagArray, &lpPropsHTML, &count);
+				MAPIFreeBuffer(SPropTagArray);
+				if (retval == MAPI_E_SUCCESS) {
+					aRowT.ulAdrEntryPad = 0;
+					aRowT.cValues = count;
+					aRowT.lpProps = lpPropsHTML;
+					exchange2ical.bodyHTML = (const char *)octool_get_propval(&aRowT, PR_BODY_HTML_UNICODE);
 				}
-				
+			} else {
+				/* The table row holds everything this event needs */
+				aRow = SRowSet.aRow[i];
+				memset(&exchange2ical.Recipients, 0, sizeof (struct message_recipients));
 			}
+
+			/*Get rest of properties*/
+			ret = exchange2ical_get_properties(mem_ctx, &aRow, &exchange2ical, (exchange2ical_check->eFlags | EntireFlag));
+
+			/*add new vevent*/
+			ical_component_VEVENT(&exchange2ical);
+
+			/*Exceptions to event*/
+			if (open_message && exchange2ical_check->eFlags != EventFlag){
+				ret = exchange2ical_exception_from_EmbeddedObj(&exchange2ical, exchange2ical_check);
+				if (ret){
+					ret=exchange2ical_exception_from_ExceptionInfo(&exchange2ical, exchange2ical_check);
+				}
+			}
+
+			/*REMOVE once globalobjid is fixed*/
+			exchange2ical.idx++;
+
+			if (lpPropsHTML) MAPIFreeBuffer(lpPropsHTML);
+			if (lpProps) MAPIFreeBuffer(lpProps);
+			exchange2ical_reset(&exchange2ical);
 			mapi_object_release(&exchange2ical.obj_message);
 		}
+		MAPIFreeBuffer(SRowSet.aRow);
 	}
 
+	DEBUG(1, ("exchange2ical: %u rows read, %u messages opened, %u events exported\n",
+		  rows, opened, exchange2ical.idx));
+
 	icalcomponent *icalendar = exchange2ical.vcalendar;
 	exchange2ical_clear(&exchange2ical);
 	
@@ -116,11 +116,13 @@ struct exchange2ical {
 	const char				*SenderEmailAddress;
 	uint8_t					*ReminderSet;
 	uint32_t				*ReminderDelta;	
+	uint8_t					*HasAttach;
 	icalcomponent				*vcalendar;
 	icalcomponent				*vevent;
 	icalcomponent				*vtimezone;
 	icalcomponent				*valarm;
 	mapi_object_t				obj_message;
+	bool					message_open;
 	const char				*bodyHTML;
 	uint32_t				idx;
 	struct	AppointmentRecurrencePattern	*AppointmentRecurrencePattern;
@@ -65,7 +65,13 @@ void ical_property_ATTACH(struct exchange2ical *exchange2ical)
 	uint32_t			count;
 	struct SRow			aRow2;
 
-	
+	/* Attachments are read from the message, which is only opened
+	   when the contents table row is not enough */
+	if (!exchange2ical->message_open) return;
+
+	/* Do not query the attachment table of messages without attachments */
+	if (exchange2ical->HasAttach && !*exchange2ical->HasAttach) return;
+
 	mapi_object_init(&obj_tb_attach);
 	retval = GetAttachmentTable(&exchange2ical->obj_message, &obj_tb_attach);
 	if (retval == MAPI_E_SUCCESS) {
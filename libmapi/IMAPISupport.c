@@ -360,6 +360,95 @@ _PUBLIC_ enum MAPISTATUS DispatchNotifications(struct mapi_session *session)
 }
 
 
+/**
+   \details Retrieve the notification socket of a session
+
+   The returned file descriptor becomes readable when the server
+   signals pending notifications. Applications running their own main
+   loop (poll, epoll, tevent, libuv...) can watch it for many sessions
+   at once and call ProcessPendingNotifications() when it is readable.
+
+   \param session the session registered for notifications
+   \param fd pointer to the returned file descriptor
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+
+   \note Developers may also call GetLastError() to retrieve the last
+   MAPI error code. Possible MAPI error codes are:
+   - MAPI_E_INVALID_PARAMETER: one of the parameters was not set
+     properly or RegisterNotification() was not called
+   - MAPI_E_NOT_FOUND: the session uses asynchronous notifications
+     and has no notification socket
+
+   \sa RegisterNotification, ProcessPendingNotifications
+*/
+_PUBLIC_ enum MAPISTATUS GetNotificationFd(struct mapi_session *session, int *fd)
+{
+	/* sanity checks */
+	OPENCHANGE_RETVAL_IF(!session, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!session->notify_ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!fd, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(session->notify_ctx->fd == -1, MAPI_E_NOT_FOUND, NULL);
+
+	*fd = session->notify_ctx->fd;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Process the notifications signaled on the notification
+   socket without blocking
+
+   This function drains the notification socket of the session. If
+   the server signaled pending notifications, a single transaction
+   retrieves all of them and the callbacks specified in Subscribe()
+   are called for the registered ones. It returns immediately when
+   nothing is pending.
+
+   \param session the session registered for notifications
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+
+   \note Developers may also call GetLastError() to retrieve the last
+   MAPI error code. Possible MAPI error codes are:
+   - MAPI_E_INVALID_PARAMETER: RegisterNotification() was not called
+   - MAPI_E_CALL_FAILED: A network problem was encountered during the
+     transaction
+
+   \sa GetNotificationFd, RegisterNotification, Subscribe
+*/
+_PUBLIC_ enum MAPISTATUS ProcessPendingNotifications(struct mapi_session *session)
+{
+	struct mapi_notify_ctx	*notify_ctx;
+	char			buf[512];
+	ssize_t			nread;
+	bool			pending = false;
+
+	/* sanity checks */
+	OPENCHANGE_RETVAL_IF(!session, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!session->notify_ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(session->notify_ctx->fd == -1, MAPI_E_INVALID_PARAMETER, NULL);
+
+	notify_ctx = session->notify_ctx;
+
+	/* Several signals are coalesced into one transaction */
+	do {
+		nread = recv(notify_ctx->fd, buf, sizeof(buf), MSG_DONTWAIT);
+		if (nread > 0) {
+			pending = true;
+		}
+	} while (nread > 0 || (nread == -1 && errno == EINTR));
+
+	errno = 0;
+	if (pending == false) {
+		return MAPI_E_SUCCESS;
+	}
+
+	return DispatchNotifications(session);
+}
+
+
 /**
    \details Wait for notifications and process them
 
@@ -390,14 +479,10 @@ _PUBLIC_ enum MAPISTATUS DispatchNotifications(struct mapi_session *session)
 _PUBLIC_ enum MAPISTATUS MonitorNotification(struct mapi_session *session, void *private_data, 
 					     struct mapi_notify_continue_callback_data *cb_data)
 {
-	struct mapi_response	*mapi_response;
 	struct mapi_notify_ctx	*notify_ctx;
-	NTSTATUS		status;
 	int			is_done;
 	int			err;
-	char			buf[512];
 	fd_set                  read_fds;
-	int                     nread;
         mapi_notify_continue_callback_t callback;
 	void                    *data;
 	struct timeval          *tv;
@@ -413,7 +498,6 @@ _PUBLIC_ enum MAPISTATUS MonitorNotification(struct mapi_session *session, void
 	data = cb_data ? cb_data->data : NULL;
 	tv = cb_data ? &tvi : NULL;
 
-	nread = 0;
 	is_done = 0;
 	while (!is_done) {
 		FD_ZERO(&read_fds);
@@ -421,20 +505,13 @@ _PUBLIC_ enum MAPISTATUS MonitorNotification(struct mapi_session *session, void
 		if( cb_data ) tvi = cb_data->tv;
 
 		err = select(notify_ctx->fd + 1, &read_fds, NULL, NULL, tv);
-		if (FD_ISSET(notify_ctx->fd, &read_fds)) {
-		        do {
-			         nread = read(notify_ctx->fd, buf, sizeof(buf));
-				 if (nread > 0) {
-			                status = emsmdb_transaction_null((struct emsmdb_context *)session->emsmdb->ctx,
-									 &mapi_response);
-					if (!NT_STATUS_IS_OK(status))
-					         err = -1;
-					else {
-					         retval = ProcessNotification(notify_ctx, mapi_response);
-						 OPENCHANGE_RETVAL_IF(retval, retval, NULL);
-					}
-				 }
-			} while (nread > 0 && err != -1);
+		if (err > 0 && FD_ISSET(notify_ctx->fd, &read_fds)) {
+			retval = ProcessPendingNotifications(session);
+			if (retval == MAPI_E_CALL_FAILED) {
+				err = -1;
+			} else {
+				OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+			}
 		}
 		if ((callback != NULL && callback (data)) || err < 0)
 		        is_done = 1;
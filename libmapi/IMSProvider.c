@@ -44,18 +44,21 @@ static NTSTATUS provider_rpc_connection(TALLOC_CTX *parent_ctx,
 					const char *binding,
 					struct cli_credentials *credentials,
 					const struct ndr_interface_table *table,
-					struct loadparm_context *lp_ctx)
+					struct loadparm_context *lp_ctx,
+					struct tevent_context *ev)
 {
 	NTSTATUS		status;
-	struct tevent_context	*ev;
 
 	if (!binding) {
 		DEBUG(3, ("You must specify a ncacn binding string\n"));
 		return NT_STATUS_INVALID_PARAMETER;
 	}
 
-	ev = tevent_context_init(parent_ctx);
-	tevent_loop_allow_nesting(ev);
+	/* Short-lived connections get their own event context */
+	if (!ev) {
+		ev = tevent_context_init(parent_ctx);
+		tevent_loop_allow_nesting(ev);
+	}
 
 	status = dcerpc_pipe_connect(parent_ctx, 
 				     p, binding, table,
@@ -158,7 +161,7 @@ _PUBLIC_ enum MAPISTATUS RfrGetNewDSA(struct mapi_context *mapi_ctx,
 	profile = session->profile;
 
 	binding = build_binding_string(mapi_ctx, mem_ctx, server, profile);
-	status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_ds_rfr, mapi_ctx->lp_ctx);
+	status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_ds_rfr, mapi_ctx->lp_ctx, NULL);
 	talloc_free(binding);
 	
 	if (!NT_STATUS_IS_OK(status)) {
@@ -217,7 +220,7 @@ _PUBLIC_ enum MAPISTATUS RfrGetFQDNFromLegacyDN(struct mapi_context *mapi_ctx, s
 	*serverFQDN = NULL;
 
 	binding = build_binding_string(mapi_ctx, mem_ctx, profile->server, profile);
-	status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_ds_rfr, mapi_ctx->lp_ctx);
+	status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_ds_rfr, mapi_ctx->lp_ctx, NULL);
 	talloc_free(binding);
 
 	OPENCHANGE_RETVAL_IF(NT_STATUS_EQUAL(status, NT_STATUS_CONNECTION_REFUSED), MAPI_E_NETWORK_ERROR, NULL);
@@ -269,7 +272,7 @@ enum MAPISTATUS Logon(struct mapi_session *session,
 	case PROVIDER_ID_EMSMDB:
 	emsmdb_retry:
 		binding = build_binding_string(mapi_ctx, mem_ctx, profile->server, profile);
-		status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_emsmdb, mapi_ctx->lp_ctx);
+		status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_emsmdb, mapi_ctx->lp_ctx, mapi_ctx->ev);
 		talloc_free(binding);
 		OPENCHANGE_RETVAL_IF(NT_STATUS_EQUAL(status, NT_STATUS_CONNECTION_REFUSED), MAPI_E_NETWORK_ERROR, NULL);
 		OPENCHANGE_RETVAL_IF(NT_STATUS_EQUAL(status, NT_STATUS_HOST_UNREACHABLE), MAPI_E_NETWORK_ERROR, NULL);
@@ -313,7 +316,7 @@ enum MAPISTATUS Logon(struct mapi_session *session,
 		OPENCHANGE_RETVAL_IF(mapistatus != MAPI_E_SUCCESS, mapistatus, NULL);
 		binding = build_binding_string(mapi_ctx, mem_ctx, server, profile);
 		talloc_free(server);
-		status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_nsp, mapi_ctx->lp_ctx);
+		status = provider_rpc_connection(mem_ctx, &pipe, binding, profile->credentials, &ndr_table_exchange_nsp, mapi_ctx->lp_ctx, NULL);
 		talloc_free(binding);
 		OPENCHANGE_RETVAL_IF(NT_STATUS_EQUAL(status, NT_STATUS_CONNECTION_REFUSED), MAPI_E_NETWORK_ERROR, NULL);
 		OPENCHANGE_RETVAL_IF(NT_STATUS_EQUAL(status, NT_STATUS_HOST_UNREACHABLE), MAPI_E_NETWORK_ERROR, NULL);
@@ -472,6 +475,21 @@ retry:
 	return MAPI_E_SUCCESS;
 }
 
+
+static void async_notification_init(struct mapi_session *session, struct emsmdb_context *emsmdb)
+{
+	if (session->notify_ctx) return;
+
+	session->notify_ctx = talloc_zero(emsmdb->mem_ctx, struct mapi_notify_ctx);
+	/* No UDP socket is bound in asynchronous mode */
+	session->notify_ctx->fd = -1;
+
+	session->notify_ctx->notifications = talloc_zero((TALLOC_CTX *)session->notify_ctx, struct notifications);
+	session->notify_ctx->notifications->prev = NULL;
+	session->notify_ctx->notifications->next = NULL;
+}
+
+
 /**
    \details Create an asynchronous notification
 
@@ -501,12 +519,7 @@ _PUBLIC_ enum MAPISTATUS RegisterAsyncNotification(struct mapi_session *session,
 	OPENCHANGE_RETVAL_IF(!session->emsmdb, MAPI_E_SESSION_LIMIT, NULL);
 
 	emsmdb = (struct emsmdb_context *)session->emsmdb->ctx;
-	
-	session->notify_ctx = talloc_zero(emsmdb->mem_ctx, struct mapi_notify_ctx);
-
-	session->notify_ctx->notifications = talloc_zero((TALLOC_CTX *)session->notify_ctx, struct notifications);
-	session->notify_ctx->notifications->prev = NULL;
-	session->notify_ctx->notifications->next = NULL;
+	async_notification_init(session, emsmdb);
 
 	mapistatus = emsmdb_async_waitex(emsmdb, 0, resultFlag);
 	OPENCHANGE_RETVAL_IF(mapistatus, mapistatus, NULL);
@@ -514,3 +527,63 @@ _PUBLIC_ enum MAPISTATUS RegisterAsyncNotification(struct mapi_session *session,
 	return MAPI_E_SUCCESS;
 }
 
+
+/**
+   \details Create an asynchronous notification without blocking
+
+   This function is the non-blocking version of
+   RegisterAsyncNotification, for applications running their own main
+   loop. The request is queued on the event context returned by
+   GetEventContext() and completes when the server reports pending
+   notifications, or after 5 minutes without changes. Call
+   RegisterAsyncNotificationRecv() from the completion callback, then
+   DispatchNotifications() if the result flag is set, and send a new
+   request to keep watching the mailbox.
+
+   \param mem_ctx pointer to the memory context
+   \param session the session context to register for notifications on.
+
+   \return the tevent request on success, otherwise NULL
+
+   \sa RegisterAsyncNotificationRecv, GetEventContext, DispatchNotifications
+*/
+_PUBLIC_ struct tevent_req *RegisterAsyncNotificationSend(TALLOC_CTX *mem_ctx, struct mapi_session *session)
+{
+	struct emsmdb_context	*emsmdb;
+
+	/* Sanity checks */
+	if (!session || !session->emsmdb || !session->emsmdb->ctx) return NULL;
+
+	emsmdb = (struct emsmdb_context *)session->emsmdb->ctx;
+	async_notification_init(session, emsmdb);
+
+	return emsmdb_async_waitex_send(mem_ctx, emsmdb, 0);
+}
+
+
+/**
+   \details Retrieve the result of an asynchronous notification
+   request
+
+   \param req the request returned by RegisterAsyncNotificationSend
+   \param resultFlag the result of the operation (non-zero if
+   notifications are pending on the server)
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+
+   \sa RegisterAsyncNotificationSend
+*/
+_PUBLIC_ enum MAPISTATUS RegisterAsyncNotificationRecv(struct tevent_req *req, uint32_t *resultFlag)
+{
+	enum MAPISTATUS		mapistatus;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!resultFlag, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapistatus = emsmdb_async_waitex_recv(req, resultFlag);
+	OPENCHANGE_RETVAL_IF(mapistatus, mapistatus, NULL);
+
+	return MAPI_E_SUCCESS;
+}
+
@@ -66,3 +66,105 @@ enum MAPISTATUS emsmdb_async_waitex(struct emsmdb_context *emsmdb_ctx, uint32_t
 
 	return MAPI_E_SUCCESS;
 }
+
+
+struct emsmdb_async_waitex_state {
+	uint32_t	flagsOut;
+	enum MAPISTATUS	result;
+};
+
+static void emsmdb_async_waitex_done(struct tevent_req *);
+
+/**
+   \details Park an asynchronous wait call without blocking
+
+   This is the non-blocking version of emsmdb_async_waitex: the call
+   is queued on the event context of the EMSMDB connection and the
+   request completes when the server reports changes or when the wait
+   times out.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdb_ctx pointer to the EMSMDB context
+   \param flagsIn input flags (currently must be 0x00000000)
+
+   \return the tevent request on success, otherwise NULL
+ */
+struct tevent_req *emsmdb_async_waitex_send(TALLOC_CTX *mem_ctx, struct emsmdb_context *emsmdb_ctx, uint32_t flagsIn)
+{
+	struct tevent_req			*req;
+	struct tevent_req			*subreq;
+	struct tevent_context			*ev;
+	struct emsmdb_async_waitex_state	*state;
+
+	/* Sanity Checks */
+	if (!emsmdb_ctx || !emsmdb_ctx->async_rpc_connection) return NULL;
+
+	ev = dcerpc_event_context(emsmdb_ctx->async_rpc_connection);
+	if (!ev) return NULL;
+
+	req = tevent_req_create(mem_ctx, &state, struct emsmdb_async_waitex_state);
+	if (!req) return NULL;
+
+	dcerpc_binding_handle_set_timeout(emsmdb_ctx->async_rpc_connection->binding_handle, 400);
+	subreq = dcerpc_EcDoAsyncWaitEx_send(state, ev, emsmdb_ctx->async_rpc_connection->binding_handle,
+					     &(emsmdb_ctx->async_handle), flagsIn, &state->flagsOut);
+	if (tevent_req_nomem(subreq, req)) {
+		return tevent_req_post(req, ev);
+	}
+	tevent_req_set_callback(subreq, emsmdb_async_waitex_done, req);
+
+	return req;
+}
+
+static void emsmdb_async_waitex_done(struct tevent_req *subreq)
+{
+	struct tevent_req			*req;
+	struct emsmdb_async_waitex_state	*state;
+	NTSTATUS				status;
+
+	req = tevent_req_callback_data(subreq, struct tevent_req);
+	state = tevent_req_data(req, struct emsmdb_async_waitex_state);
+
+	status = dcerpc_EcDoAsyncWaitEx_recv(subreq, state, &state->result);
+	talloc_free(subreq);
+	if (!NT_STATUS_IS_OK(status)) {
+		tevent_req_error(req, MAPI_E_CALL_FAILED);
+		return;
+	}
+	if (state->result != MAPI_E_SUCCESS) {
+		tevent_req_error(req, state->result);
+		return;
+	}
+
+	tevent_req_done(req);
+}
+
+/**
+   \details Retrieve the result of an asynchronous wait call
+
+   \param req the request returned by emsmdb_async_waitex_send
+   \param flagsOut output flags (zero for a call completion with no
+   changes, non-zero if there are changes)
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+enum MAPISTATUS emsmdb_async_waitex_recv(struct tevent_req *req, uint32_t *flagsOut)
+{
+	struct emsmdb_async_waitex_state	*state;
+	enum tevent_req_state			req_state;
+	uint64_t				error;
+
+	state = tevent_req_data(req, struct emsmdb_async_waitex_state);
+	if (tevent_req_is_error(req, &req_state, &error)) {
+		tevent_req_received(req);
+		if (req_state == TEVENT_REQ_USER_ERROR) {
+			return (enum MAPISTATUS) error;
+		}
+		return MAPI_E_CALL_FAILED;
+	}
+
+	*flagsOut = state->flagsOut;
+	tevent_req_received(req);
+
+	return MAPI_E_SUCCESS;
+}
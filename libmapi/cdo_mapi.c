@@ -240,6 +240,11 @@ _PUBLIC_ enum MAPISTATUS MAPIInitialize(struct mapi_context **_mapi_ctx, const c
 	mapi_ctx->session = NULL;
 	mapi_ctx->lp_ctx = loadparm_init_global(true);
 
+	/* Event context shared by all the provider connections */
+	mapi_ctx->ev = tevent_context_init(mem_ctx);
+	OPENCHANGE_RETVAL_IF(!mapi_ctx->ev, MAPI_E_NOT_ENOUGH_RESOURCES, mem_ctx);
+	tevent_loop_allow_nesting(mapi_ctx->ev);
+
 	/* Enable logging on stdout */
 	setup_logging(NULL, DEBUG_STDOUT);
 
@@ -276,11 +281,12 @@ _PUBLIC_ void MAPIUninitialize(struct mapi_context *mapi_ctx)
 
 	if (!mapi_ctx) return;
 
-	session = mapi_ctx->session;
-	if (session && session->notify_ctx && session->notify_ctx->fd != -1) {
-		DEBUG(3, ("emsmdb_disconnect_dtor: unbind udp\n"));
-		shutdown(session->notify_ctx->fd, SHUT_RDWR);
-		close(session->notify_ctx->fd);
+	for (session = mapi_ctx->session; session; session = session->next) {
+		if (session->notify_ctx && session->notify_ctx->fd != -1) {
+			DEBUG(3, ("emsmdb_disconnect_dtor: unbind udp\n"));
+			shutdown(session->notify_ctx->fd, SHUT_RDWR);
+			close(session->notify_ctx->fd);
+		}
 	}
 	
 	mem_ctx = mapi_ctx->mem_ctx;
@@ -363,3 +369,34 @@ _PUBLIC_ enum MAPISTATUS GetLoadparmContext(struct mapi_context *mapi_ctx,
 
 	return MAPI_E_SUCCESS;
 }
+
+
+/**
+   \details Retrieve the event context used by the connections of
+   the specified MAPI context
+
+   All the sessions opened within a MAPI context share this event
+   context. Applications running their own main loop can drive the
+   asynchronous notification requests of every session from it.
+
+   \param mapi_ctx pointer to the MAPI context
+   \param ev pointer to a pointer to the event context that the
+   function returns
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI_E_NOT_INITIALIZED
+   or MAPI_E_INVALID_PARAMETER
+
+   \sa RegisterAsyncNotificationSend
+ */
+_PUBLIC_ enum MAPISTATUS GetEventContext(struct mapi_context *mapi_ctx,
+					 struct tevent_context **ev)
+{
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!mapi_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_ctx->ev, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!ev, MAPI_E_INVALID_PARAMETER, NULL);
+
+	*ev = mapi_ctx->ev;
+
+	return MAPI_E_SUCCESS;
+}
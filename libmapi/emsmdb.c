@@ -517,17 +517,17 @@ _PUBLIC_ NTSTATUS emsmdb_transaction_ext2(struct emsmdb_context *emsmdb_ctx,
 	/* 	if (ndr_comp_rgbIn->offset > ndr_uncomp_rgbIn->offset) { */
 	/* 		talloc_free(ndr_comp_rgbIn); */
 	ndr_comp_rgbIn = ndr_uncomp_rgbIn;
-	obfuscate_data(ndr_comp_rgbIn->data, ndr_comp_rgbIn->offset, 0xA5);
 		
 	RPC_HEADER_EXT.Version = 0x0000;
 	RPC_HEADER_EXT.Flags = RHEF_XorMagic|RHEF_Last;
 	RPC_HEADER_EXT.Size = ndr_comp_rgbIn->offset;
 	RPC_HEADER_EXT.SizeActual = ndr_comp_rgbIn->offset;
 
+	/* The request is obfuscated while it is copied after the header */
 	ndr_rgbIn = ndr_push_init_ctx(mem_ctx);
 	ndr_set_flags(&ndr_rgbIn->flags, LIBNDR_FLAG_NOALIGN);
 	ndr_push_RPC_HEADER_EXT(ndr_rgbIn, NDR_SCALARS|NDR_BUFFERS, &RPC_HEADER_EXT);
-	ndr_push_bytes(ndr_rgbIn, ndr_comp_rgbIn->data, ndr_comp_rgbIn->offset);
+	ndr_push_obfuscated_bytes(ndr_rgbIn, ndr_comp_rgbIn->data, ndr_comp_rgbIn->offset, 0xA5);
 		/* 	} else { */
 		/* 		RPC_HEADER_EXT.Version = 0x0000; */
 		/* 		RPC_HEADER_EXT.Flags = RHEF_Compressed|RHEF_Last; */
@@ -621,6 +621,7 @@ struct mapi_notify_ctx *emsmdb_bind_notification(struct mapi_context *mapi_ctx,
 {
 	struct interface	*ifaces;
 	struct mapi_notify_ctx	*notify_ctx = NULL;
+	socklen_t		addrlen;
 	unsigned short		port = DFLT_NOTIF_PORT;
 	const char		*ipaddr = NULL;
 	uint32_t		attempt = 0;
@@ -648,6 +649,8 @@ struct mapi_notify_ctx *emsmdb_bind_notification(struct mapi_context *mapi_ctx,
 	((struct sockaddr_in *)(notify_ctx->addr))->sin_addr.s_addr = inet_addr(ipaddr);
 retry:
 	if (attempt) port++;
+	/* Let the system pick a port once the default range is busy */
+	if (attempt > 3) port = 0;
 	((struct sockaddr_in *)(notify_ctx->addr))->sin_port = htons(port);
 
 	notify_ctx->fd = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
@@ -663,7 +666,7 @@ retry:
 	if (bind(notify_ctx->fd, notify_ctx->addr, sizeof(struct sockaddr)) == -1) {
 		shutdown(notify_ctx->fd, SHUT_RDWR);
 		close(notify_ctx->fd);
-		if (attempt < 3) {
+		if (attempt < 4) {
 			attempt++;
 			errno = 0;
 			goto retry;
@@ -675,6 +678,12 @@ retry:
 		return NULL;
 	}
 
+	/* Retrieve the port picked by the system */
+	if (!port) {
+		addrlen = sizeof(struct sockaddr);
+		getsockname(notify_ctx->fd, notify_ctx->addr, &addrlen);
+	}
+
 	return notify_ctx;
 }
 
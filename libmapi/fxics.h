@@ -75,4 +75,24 @@
 #define	MetaTagIdsetRead			0x402D0102
 #define	MetaTagIdsetUnread			0x402E0102
 
+/* Bulk message import - libmapi/fximport.c */
+#define	FXIMPORT_BUFFER_SIZE			0x7800
+
+struct fx_import_message;
+
+struct fx_import_attachment {
+	uint32_t			cValues;
+	struct SPropValue		*lpProps;
+	struct fx_import_message	*embedded;	/* embedded message or NULL */
+};
+
+struct fx_import_message {
+	bool				fai;
+	uint32_t			cValues;
+	struct SPropValue		*lpProps;
+	struct SRowSet			*recipients;	/* one row per recipient or NULL */
+	uint32_t			attachment_count;
+	struct fx_import_attachment	*attachments;
+};
+
 #endif /* ! __FXICS_H__ */
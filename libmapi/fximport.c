@@ -0,0 +1,642 @@
+/*
+   OpenChange MAPI implementation.
+
+   Copyright (C) agent 2026.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmapi/libmapi.h"
+#include "libmapi/libmapi_private.h"
+#include "libmapi/fximport.h"
+#include "libmapi/fxics.h"
+
+/**
+   \file fximport.c
+
+   \brief Bulk message import through FastTransfer upload
+
+   Messages are serialized as a FastTransfer messageList stream
+   ([MS-OXCFXICS] 2.2.4.3) and uploaded with FXPutBuffer, filling each
+   buffer up to the configured size. Importing a message no longer
+   costs one round trip per CreateMessage, SetProps, ModifyRecipients,
+   CreateAttach and SaveChanges operation: many small messages share a
+   single FXPutBuffer call, and the amount of memory used does not
+   depend on the size of the messages.
+ */
+
+
+/**
+   \details Upload the pending part of the stream
+
+   \param ctx pointer to the import context
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_flush(struct fx_import_context *ctx)
+{
+	enum MAPISTATUS		retval;
+	DATA_BLOB		blob;
+	uint16_t		usedSize;
+
+	blob = ctx->buffer;
+	while (blob.length) {
+		usedSize = 0;
+		retval = FXPutBuffer(&ctx->obj_dest, &blob, &usedSize);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		OPENCHANGE_RETVAL_IF(!usedSize || usedSize > blob.length, MAPI_E_CALL_FAILED, NULL);
+
+		ctx->buffers++;
+		ctx->bytes += usedSize;
+		blob.data += usedSize;
+		blob.length -= usedSize;
+	}
+	ctx->buffer.length = 0;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Append data to the stream, uploading each buffer as soon
+   as it is full
+
+   \param ctx pointer to the import context
+   \param data pointer to the data to append
+   \param length size of the data
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push(struct fx_import_context *ctx, const uint8_t *data, uint32_t length)
+{
+	enum MAPISTATUS		retval;
+	uint32_t		len;
+
+	while (length) {
+		len = ctx->size - ctx->buffer.length;
+		if (len > length) {
+			len = length;
+		}
+		memcpy(ctx->buffer.data + ctx->buffer.length, data, len);
+		ctx->buffer.length += len;
+		data += len;
+		length -= len;
+
+		if (ctx->buffer.length == ctx->size) {
+			retval = fximport_flush(ctx);
+			OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		}
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS fximport_push_uint16(struct fx_import_context *ctx, uint16_t val)
+{
+	uint8_t	data[2];
+
+	data[0] = val & 0xFF;
+	data[1] = (val >> 8) & 0xFF;
+
+	return fximport_push(ctx, data, sizeof (data));
+}
+
+static enum MAPISTATUS fximport_push_uint32(struct fx_import_context *ctx, uint32_t val)
+{
+	uint8_t	data[4];
+
+	data[0] = val & 0xFF;
+	data[1] = (val >> 8) & 0xFF;
+	data[2] = (val >> 16) & 0xFF;
+	data[3] = (val >> 24) & 0xFF;
+
+	return fximport_push(ctx, data, sizeof (data));
+}
+
+static enum MAPISTATUS fximport_push_uint64(struct fx_import_context *ctx, uint64_t val)
+{
+	enum MAPISTATUS		retval;
+
+	retval = fximport_push_uint32(ctx, val & 0xFFFFFFFF);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	return fximport_push_uint32(ctx, val >> 32);
+}
+
+static enum MAPISTATUS fximport_push_guid(struct fx_import_context *ctx, const struct GUID *guid)
+{
+	uint8_t	data[16];
+
+	data[0] = guid->time_low & 0xFF;
+	data[1] = (guid->time_low >> 8) & 0xFF;
+	data[2] = (guid->time_low >> 16) & 0xFF;
+	data[3] = (guid->time_low >> 24) & 0xFF;
+	data[4] = guid->time_mid & 0xFF;
+	data[5] = (guid->time_mid >> 8) & 0xFF;
+	data[6] = guid->time_hi_and_version & 0xFF;
+	data[7] = (guid->time_hi_and_version >> 8) & 0xFF;
+	memcpy(data + 8, guid->clock_seq, 2);
+	memcpy(data + 10, guid->node, 6);
+
+	return fximport_push(ctx, data, sizeof (data));
+}
+
+
+/**
+   \details Append a variable size value: its length followed by the
+   data
+
+   \param ctx pointer to the import context
+   \param data pointer to the value
+   \param length size of the value
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push_varsize(struct fx_import_context *ctx, const uint8_t *data, uint32_t length)
+{
+	enum MAPISTATUS		retval;
+
+	retval = fximport_push_uint32(ctx, length);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	return fximport_push(ctx, data, length);
+}
+
+static enum MAPISTATUS fximport_push_string8(struct fx_import_context *ctx, const char *str)
+{
+	if (!str) {
+		str = "";
+	}
+
+	return fximport_push_varsize(ctx, (const uint8_t *)str, strlen(str) + 1);
+}
+
+static enum MAPISTATUS fximport_push_unicode(struct fx_import_context *ctx, const char *str, bool length)
+{
+	enum MAPISTATUS		retval;
+	uint8_t			*utf16;
+	size_t			utf16_len;
+	size_t			converted_size;
+
+	if (!str) {
+		str = "";
+	}
+
+	/* UTF-16LE string including the terminating null character */
+	utf16_len = strlen_m_ext(str, CH_UTF8, CH_UTF16LE) * 2;
+	utf16 = talloc_zero_array(ctx->mem_ctx, uint8_t, utf16_len + 2);
+	OPENCHANGE_RETVAL_IF(!utf16, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	convert_string(CH_UTF8, CH_UTF16LE, str, strlen(str), utf16, utf16_len, &converted_size);
+
+	if (length) {
+		retval = fximport_push_varsize(ctx, utf16, utf16_len + 2);
+	} else {
+		retval = fximport_push(ctx, utf16, utf16_len + 2);
+	}
+	talloc_free(utf16);
+
+	return retval;
+}
+
+
+/**
+   \details Append the name of a named property
+
+   Names are retrieved from the server the first time a property
+   identifier is used and cached in the import context.
+
+   \param ctx pointer to the import context
+   \param ulPropTag the mapped named property tag
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push_namedprop(struct fx_import_context *ctx, uint32_t ulPropTag)
+{
+	enum MAPISTATUS		retval;
+	struct MAPINAMEID	*nameid = NULL;
+	struct MAPINAMEID	*el = NULL;
+	uint16_t		propID = ulPropTag >> 16;
+	uint16_t		count = 0;
+	uint32_t		i;
+
+	for (i = 0; i < ctx->namedprops_count; i++) {
+		if (ctx->namedprops[i].propID == propID) {
+			el = &ctx->namedprops[i].nameid;
+			break;
+		}
+	}
+
+	if (!el) {
+		retval = GetNamesFromIDs(ctx->obj_folder, (enum MAPITAGS)ulPropTag, &count, &nameid);
+		OPENCHANGE_RETVAL_IF(retval, retval, nameid);
+		OPENCHANGE_RETVAL_IF(count != 1, MAPI_E_NOT_FOUND, nameid);
+
+		ctx->namedprops = talloc_realloc(ctx->mem_ctx, ctx->namedprops, struct fx_import_namedprop,
+						 ctx->namedprops_count + 1);
+		OPENCHANGE_RETVAL_IF(!ctx->namedprops, MAPI_E_NOT_ENOUGH_MEMORY, nameid);
+		ctx->namedprops[ctx->namedprops_count].propID = propID;
+		el = &ctx->namedprops[ctx->namedprops_count].nameid;
+		*el = nameid[0];
+		if (el->ulKind == MNID_STRING) {
+			el->kind.lpwstr.Name = talloc_strdup(ctx->namedprops, nameid[0].kind.lpwstr.Name);
+		}
+		ctx->namedprops_count++;
+		talloc_free(nameid);
+	}
+
+	retval = fximport_push_guid(ctx, &el->lpguid);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	switch (el->ulKind) {
+	case MNID_ID:
+		retval = fximport_push(ctx, (const uint8_t *)"\0", 1);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		return fximport_push_uint32(ctx, el->kind.lid);
+	case MNID_STRING:
+		retval = fximport_push(ctx, (const uint8_t *)"\1", 1);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		return fximport_push_unicode(ctx, el->kind.lpwstr.Name, false);
+	default:
+		break;
+	}
+
+	OPENCHANGE_RETVAL_ERR(MAPI_E_INVALID_PARAMETER, NULL);
+}
+
+
+/**
+   \details Append a property: its tag, its name for named properties
+   and its value
+
+   Error and object properties are skipped: the former do not carry a
+   value and the latter are sent as message children.
+
+   \param ctx pointer to the import context
+   \param lpProp pointer to the property to append
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push_property(struct fx_import_context *ctx, struct SPropValue *lpProp)
+{
+	enum MAPISTATUS		retval;
+	uint32_t		i;
+
+	switch (lpProp->ulPropTag & 0xFFFF) {
+	case PT_ERROR:
+	case PT_OBJECT:
+	case PT_NULL:
+		return MAPI_E_SUCCESS;
+	}
+
+	retval = fximport_push_uint32(ctx, lpProp->ulPropTag);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	if ((lpProp->ulPropTag >> 16) >= 0x8000) {
+		retval = fximport_push_namedprop(ctx, lpProp->ulPropTag);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	}
+
+	switch (lpProp->ulPropTag & 0xFFFF) {
+	case PT_SHORT:
+		return fximport_push_uint16(ctx, lpProp->value.i);
+	case PT_LONG:
+		return fximport_push_uint32(ctx, lpProp->value.l);
+	case PT_DOUBLE:
+		return fximport_push(ctx, (const uint8_t *)&lpProp->value.dbl, sizeof (double));
+	case PT_BOOLEAN:
+		/* booleans take 2 bytes in FastTransfer streams */
+		return fximport_push_uint16(ctx, lpProp->value.b ? 1 : 0);
+	case PT_I8:
+		return fximport_push_uint64(ctx, lpProp->value.d);
+	case PT_SYSTIME:
+		retval = fximport_push_uint32(ctx, lpProp->value.ft.dwLowDateTime);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		return fximport_push_uint32(ctx, lpProp->value.ft.dwHighDateTime);
+	case PT_CLSID:
+		OPENCHANGE_RETVAL_IF(!lpProp->value.lpguid, MAPI_E_INVALID_PARAMETER, NULL);
+		return fximport_push(ctx, lpProp->value.lpguid->ab, 16);
+	case PT_STRING8:
+		return fximport_push_string8(ctx, lpProp->value.lpszA);
+	case PT_UNICODE:
+		return fximport_push_unicode(ctx, lpProp->value.lpszW, true);
+	case PT_SVREID:
+	case PT_BINARY:
+		return fximport_push_varsize(ctx, lpProp->value.bin.lpb, lpProp->value.bin.cb);
+	case PT_MV_SHORT:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVi.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVi.cValues; i++) {
+			retval = fximport_push_uint16(ctx, lpProp->value.MVi.lpi[i]);
+		}
+		return retval;
+	case PT_MV_LONG:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVl.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVl.cValues; i++) {
+			retval = fximport_push_uint32(ctx, lpProp->value.MVl.lpl[i]);
+		}
+		return retval;
+	case PT_MV_I8:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVui8.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVui8.cValues; i++) {
+			retval = fximport_push_uint64(ctx, lpProp->value.MVui8.lpui8[i]);
+		}
+		return retval;
+	case PT_MV_SYSTIME:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVft.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVft.cValues; i++) {
+			retval = fximport_push_uint32(ctx, lpProp->value.MVft.lpft[i].dwLowDateTime);
+			if (retval) break;
+			retval = fximport_push_uint32(ctx, lpProp->value.MVft.lpft[i].dwHighDateTime);
+		}
+		return retval;
+	case PT_MV_CLSID:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVguid.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVguid.cValues; i++) {
+			retval = fximport_push(ctx, lpProp->value.MVguid.lpguid[i]->ab, 16);
+		}
+		return retval;
+	case PT_MV_STRING8:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVszA.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVszA.cValues; i++) {
+			retval = fximport_push_string8(ctx, (const char *)lpProp->value.MVszA.lppszA[i]);
+		}
+		return retval;
+	case PT_MV_UNICODE:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVszW.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVszW.cValues; i++) {
+			retval = fximport_push_unicode(ctx, (const char *)lpProp->value.MVszW.lppszW[i], true);
+		}
+		return retval;
+	case PT_MV_BINARY:
+		retval = fximport_push_uint32(ctx, lpProp->value.MVbin.cValues);
+		for (i = 0; !retval && i < lpProp->value.MVbin.cValues; i++) {
+			retval = fximport_push_varsize(ctx, lpProp->value.MVbin.lpbin[i].lpb,
+						       lpProp->value.MVbin.lpbin[i].cb);
+		}
+		return retval;
+	default:
+		break;
+	}
+
+	OPENCHANGE_RETVAL_ERR(MAPI_E_INVALID_PARAMETER, NULL);
+}
+
+
+/**
+   \details Append a property list, skipping one property tag
+
+   \param ctx pointer to the import context
+   \param lpProps pointer to the properties to append
+   \param cValues number of properties
+   \param skip property tag set by the importer itself, or 0
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push_proplist(struct fx_import_context *ctx, struct SPropValue *lpProps,
+					      uint32_t cValues, uint32_t skip)
+{
+	enum MAPISTATUS		retval;
+	uint32_t		i;
+
+	for (i = 0; i < cValues; i++) {
+		if (skip && lpProps[i].ulPropTag == skip) continue;
+		retval = fximport_push_property(ctx, &lpProps[i]);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Append a messageContent element: message properties,
+   recipients and attachments
+
+   \param ctx pointer to the import context
+   \param msg pointer to the message to append
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+static enum MAPISTATUS fximport_push_content(struct fx_import_context *ctx, const struct fx_import_message *msg)
+{
+	enum MAPISTATUS			retval;
+	struct fx_import_attachment	*attach;
+	uint32_t			i;
+
+	retval = fximport_push_proplist(ctx, msg->lpProps, msg->cValues, 0);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* Recipients */
+	retval = fximport_push_uint32(ctx, MetaTagFXDelProp);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	retval = fximport_push_uint32(ctx, PidTagMessageRecipients);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	for (i = 0; msg->recipients && i < msg->recipients->cRows; i++) {
+		retval = fximport_push_uint32(ctx, StartRecip);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_uint32(ctx, PidTagRowid);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_uint32(ctx, i);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_proplist(ctx, msg->recipients->aRow[i].lpProps,
+						msg->recipients->aRow[i].cValues, PidTagRowid);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_uint32(ctx, EndToRecip);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	}
+
+	/* Attachments */
+	retval = fximport_push_uint32(ctx, MetaTagFXDelProp);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	retval = fximport_push_uint32(ctx, PidTagMessageAttachments);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	for (i = 0; i < msg->attachment_count; i++) {
+		attach = &msg->attachments[i];
+		retval = fximport_push_uint32(ctx, NewAttach);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_uint32(ctx, PidTagAttachNumber);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_uint32(ctx, i);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		retval = fximport_push_proplist(ctx, attach->lpProps, attach->cValues, PidTagAttachNumber);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		if (attach->embedded) {
+			retval = fximport_push_uint32(ctx, StartEmbed);
+			OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+			retval = fximport_push_content(ctx, attach->embedded);
+			OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+			retval = fximport_push_uint32(ctx, EndEmbed);
+			OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		}
+		retval = fximport_push_uint32(ctx, EndAttach);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Initialize a bulk import into a folder
+
+   \param mem_ctx pointer to the memory context
+   \param obj_folder the folder where messages are imported
+   \param _ctx pointer on pointer to the import context to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+
+   \note Developers may also call GetLastError() to retrieve the last
+   MAPI error code. Possible MAPI error codes are:
+   - MAPI_E_INVALID_PARAMETER: one of the function parameters is
+     invalid
+   - MAPI_E_CALL_FAILED: A network problem was encountered during the
+   transaction
+
+   \sa fximport_add_message, fximport_commit
+ */
+_PUBLIC_ enum MAPISTATUS fximport_init(TALLOC_CTX *mem_ctx, mapi_object_t *obj_folder,
+				       struct fx_import_context **_ctx)
+{
+	enum MAPISTATUS			retval;
+	struct fx_import_context	*ctx;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!obj_folder, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!_ctx, MAPI_E_INVALID_PARAMETER, NULL);
+
+	ctx = talloc_zero(mem_ctx, struct fx_import_context);
+	OPENCHANGE_RETVAL_IF(!ctx, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	ctx->mem_ctx = (TALLOC_CTX *)ctx;
+	ctx->obj_folder = obj_folder;
+	ctx->size = FXIMPORT_BUFFER_SIZE;
+	ctx->buffer.data = talloc_array(ctx, uint8_t, ctx->size);
+	ctx->buffer.length = 0;
+	OPENCHANGE_RETVAL_IF(!ctx->buffer.data, MAPI_E_NOT_ENOUGH_MEMORY, ctx);
+
+	mapi_object_init(&ctx->obj_dest);
+	retval = FXDestConfigure(obj_folder, FastTransferDest_CopyMessages, &ctx->obj_dest);
+	OPENCHANGE_RETVAL_IF(retval, retval, ctx);
+
+	*_ctx = ctx;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Set the size of the buffers sent with FXPutBuffer
+
+   \param ctx pointer to the import context
+   \param size the buffer size, FXIMPORT_BUFFER_SIZE by default
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+_PUBLIC_ enum MAPISTATUS fximport_set_buffer_size(struct fx_import_context *ctx, uint16_t size)
+{
+	enum MAPISTATUS		retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size || size > FXIMPORT_BUFFER_SIZE, MAPI_E_INVALID_PARAMETER, NULL);
+
+	if (ctx->buffer.length >= size) {
+		retval = fximport_flush(ctx);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	}
+	ctx->size = size;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Import a message
+
+   The message is serialized in the upload buffer, which is sent to the
+   server each time it is full. The message may therefore only be
+   created on the server by a later call, at the latest by
+   fximport_commit.
+
+   \param ctx pointer to the import context
+   \param msg pointer to the message to import
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+
+   \sa fximport_init, fximport_commit
+ */
+_PUBLIC_ enum MAPISTATUS fximport_add_message(struct fx_import_context *ctx, const struct fx_import_message *msg)
+{
+	enum MAPISTATUS		retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!msg, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(msg->attachment_count && !msg->attachments, MAPI_E_INVALID_PARAMETER, NULL);
+
+	retval = fximport_push_uint32(ctx, msg->fai ? StartFAIMsg : StartMessage);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	retval = fximport_push_content(ctx, msg);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	retval = fximport_push_uint32(ctx, EndMessage);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	ctx->messages++;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Upload the end of the stream and terminate the import
+
+   \param ctx pointer to the import context
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+_PUBLIC_ enum MAPISTATUS fximport_commit(struct fx_import_context *ctx)
+{
+	enum MAPISTATUS		retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
+
+	retval = fximport_flush(ctx);
+	mapi_object_release(&ctx->obj_dest);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve import statistics
+
+   \param ctx pointer to the import context
+   \param messages pointer to the number of messages imported
+   \param buffers pointer to the number of FXPutBuffer calls
+   \param bytes pointer to the number of bytes uploaded
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error.
+ */
+_PUBLIC_ enum MAPISTATUS fximport_get_stats(struct fx_import_context *ctx, uint32_t *messages,
+					    uint32_t *buffers, uint64_t *bytes)
+{
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
+
+	if (messages) *messages = ctx->messages;
+	if (buffers) *buffers = ctx->buffers;
+	if (bytes) *bytes = ctx->bytes;
+
+	return MAPI_E_SUCCESS;
+}
@@ -0,0 +1,49 @@
+/*
+   OpenChange MAPI implementation.
+
+   Copyright (C) agent 2026.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+   
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBMAPI_FXIMPORT_H__
+#define __LIBMAPI_FXIMPORT_H__
+
+/* This header is private to the bulk importer. If you use this directly, you may suffer API or ABI breakage.
+
+   We mean it.
+*/
+
+/* named property definition sent along with mapped property identifiers */
+struct fx_import_namedprop {
+	uint16_t		propID;
+	struct MAPINAMEID	nameid;
+};
+
+struct fx_import_context {
+	TALLOC_CTX			*mem_ctx;
+	mapi_object_t			*obj_folder;
+	mapi_object_t			obj_dest;	/* FXDestConfigure context */
+	DATA_BLOB			buffer;		/* data not uploaded yet */
+	uint16_t			size;		/* FXPutBuffer chunk size */
+	uint32_t			namedprops_count;
+	struct fx_import_namedprop	*namedprops;
+
+	/* statistics */
+	uint32_t			messages;
+	uint32_t			buffers;
+	uint64_t			bytes;
+};
+
+#endif
@@ -83,12 +83,11 @@ static bool pull_tag(struct fx_parser_context *parser)
 
 static bool pull_uint8_data(struct fx_parser_context *parser, uint32_t read_len, uint8_t **data_read)
 {
-	uint32_t i;
-	for (i = 0; i < read_len; i++) {
-		if (!pull_uint8_t(parser, (uint8_t*)&((*data_read)[i]))) {
-			return false;
-		}
+	if ((parser->idx) + read_len > parser->data.length) {
+		return false;
 	}
+	memcpy(*data_read, &(parser->data.data[parser->idx]), read_len);
+	parser->idx += read_len;
 	return true;
 }
 
@@ -185,7 +184,7 @@ static bool pull_clsid(struct fx_parser_context *parser, struct FlatUID_r **pcls
 	if (parser->idx + 16 > parser->data.length)
 		return false;
 
-	clsid = talloc_zero(parser->mem_ctx, struct FlatUID_r);
+	clsid = talloc_zero(parser->value_ctx, struct FlatUID_r);
 	for (i = 0; i < 16; ++i) {
 		if (!pull_uint8_t(parser, &(clsid->ab[i])))
 			return false;
@@ -199,17 +198,15 @@ static bool pull_clsid(struct fx_parser_context *parser, struct FlatUID_r **pcls
 static bool pull_string8(struct fx_parser_context *parser, char **pstr)
 {
 	char *str;
-	uint32_t i, length;
+	uint32_t length;
 
 	if (!pull_uint32_t(parser, &length) ||
 	    parser->idx + length > parser->data.length)
 		return false;
 
-	str = talloc_array(parser->mem_ctx, char, length + 1);
-	for (i = 0; i < length; i++) {
-		if (!pull_uint8_t(parser, (uint8_t*)&(str[i]))) {
-			return false;
-		}
+	str = talloc_array(parser->value_ctx, char, length + 1);
+	if (!pull_uint8_data(parser, length, (uint8_t **)&str)) {
+		return false;
 	}
 	str[length] = '\0';
 
@@ -225,7 +222,7 @@ static bool fetch_ucs2_data(struct fx_parser_context *parser, uint32_t numbytes,
 		return false;
 	}
 
-	*data_read = talloc_zero_array(parser->mem_ctx, smb_ucs2_t, (numbytes/2) + 1);
+	*data_read = talloc_zero_array(parser->value_ctx, smb_ucs2_t, (numbytes/2) + 1);
 	memcpy(*data_read, &(parser->data.data[parser->idx]), numbytes);
 	parser->idx += numbytes;
 	return true;
@@ -262,12 +259,12 @@ static bool pull_unicode(struct fx_parser_context *parser, char **pstr)
 	    parser->idx + length > parser->data.length)
 		return false;
 
-	ucs2_data = talloc_zero_array(parser->mem_ctx, smb_ucs2_t, (length/2) + 1);
+	ucs2_data = talloc_zero_array(parser->value_ctx, smb_ucs2_t, (length/2) + 1);
 
 	if (!fetch_ucs2_data(parser, length, &ucs2_data)) {
 		return false;
 	}
-	pull_ucs2_talloc(parser->mem_ctx, &utf8_data, ucs2_data, &utf8_len);
+	pull_ucs2_talloc(parser->value_ctx, &utf8_data, ucs2_data, &utf8_len);
 
 	*pstr = utf8_data;
 
@@ -280,7 +277,7 @@ static bool pull_binary(struct fx_parser_context *parser, struct Binary_r *bin)
 	    parser->idx + bin->cb > parser->data.length)
 		return false;
 
-	bin->lpb = talloc_array(parser->mem_ctx, uint8_t, bin->cb + 1);
+	bin->lpb = talloc_array(parser->value_ctx, uint8_t, bin->cb + 1);
 
 	return pull_uint8_data(parser, bin->cb, &(bin->lpb));
 }
@@ -390,7 +387,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVbin.cValues)) ||
 		    parser->idx + prop->value.MVbin.cValues * 4 > parser->data.length)
 			return false;
-		prop->value.MVbin.lpbin = talloc_array(parser->mem_ctx, struct Binary_r, prop->value.MVbin.cValues);
+		prop->value.MVbin.lpbin = talloc_array(parser->value_ctx, struct Binary_r, prop->value.MVbin.cValues);
 		for (i = 0; i < prop->value.MVbin.cValues; i++) {
 			if (!pull_binary(parser, &(prop->value.MVbin.lpbin[i])))
 				return false;
@@ -403,7 +400,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVi.cValues)) ||
 		    parser->idx + prop->value.MVi.cValues * 2 > parser->data.length)
 			return false;
-		prop->value.MVi.lpi = talloc_array(parser->mem_ctx, uint16_t, prop->value.MVi.cValues);
+		prop->value.MVi.lpi = talloc_array(parser->value_ctx, uint16_t, prop->value.MVi.cValues);
 		for (i = 0; i < prop->value.MVi.cValues; i++) {
 			if (!pull_uint16_t(parser, &(prop->value.MVi.lpi[i])))
 				return false;
@@ -416,7 +413,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVl.cValues)) ||
 		    parser->idx + prop->value.MVl.cValues * 4 > parser->data.length)
 			return false;
-		prop->value.MVl.lpl = talloc_array(parser->mem_ctx, uint32_t, prop->value.MVl.cValues);
+		prop->value.MVl.lpl = talloc_array(parser->value_ctx, uint32_t, prop->value.MVl.cValues);
 		for (i = 0; i < prop->value.MVl.cValues; i++) {
 			if (!pull_uint32_t(parser, &(prop->value.MVl.lpl[i])))
 				return false;
@@ -430,7 +427,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVszA.cValues)) ||
 		    parser->idx + prop->value.MVszA.cValues * 4 > parser->data.length)
 			return false;
-		prop->value.MVszA.lppszA = (const char **) talloc_array(parser->mem_ctx, char *, prop->value.MVszA.cValues);
+		prop->value.MVszA.lppszA = (const char **) talloc_array(parser->value_ctx, char *, prop->value.MVszA.cValues);
 		for (i = 0; i < prop->value.MVszA.cValues; i++) {
 			str = NULL;
 			if (!pull_string8(parser, &str))
@@ -445,7 +442,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVguid.cValues)) ||
 		    parser->idx + prop->value.MVguid.cValues * 16 > parser->data.length)
 			return false;
-		prop->value.MVguid.lpguid = talloc_array(parser->mem_ctx, struct FlatUID_r *, prop->value.MVguid.cValues);
+		prop->value.MVguid.lpguid = talloc_array(parser->value_ctx, struct FlatUID_r *, prop->value.MVguid.cValues);
 		for (i = 0; i < prop->value.MVguid.cValues; i++) {
 			if (!pull_clsid(parser, &(prop->value.MVguid.lpguid[i])))
 				return false;
@@ -460,7 +457,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVszW.cValues)) ||
 		    parser->idx + prop->value.MVszW.cValues * 4 > parser->data.length)
 			return false;
-		prop->value.MVszW.lppszW = (const char **)  talloc_array(parser->mem_ctx, char *, prop->value.MVszW.cValues);
+		prop->value.MVszW.lppszW = (const char **)  talloc_array(parser->value_ctx, char *, prop->value.MVszW.cValues);
 		for (i = 0; i < prop->value.MVszW.cValues; i++) {
 			str = NULL;
 			if (!pull_unicode(parser, &str))
@@ -475,7 +472,7 @@ static bool fetch_property_value(struct fx_parser_context *parser, DATA_BLOB *bu
 		if (!pull_uint32_t(parser, &(prop->value.MVft.cValues)) ||
 		    parser->idx + prop->value.MVft.cValues * 8 > parser->data.length)
 			return false;
-		prop->value.MVft.lpft = talloc_array(parser->mem_ctx, struct FILETIME, prop->value.MVft.cValues);
+		prop->value.MVft.lpft = talloc_array(parser->value_ctx, struct FILETIME, prop->value.MVft.cValues);
 		for (i = 0; i < prop->value.MVft.cValues; i++) {
 			if (!pull_systime(parser, &(prop->value.MVft.lpft[i])))
 				return false;
@@ -508,7 +505,7 @@ static bool pull_named_property(struct fx_parser_context *parser, enum MAPISTATU
 		parser->namedprop.ulKind = MNID_STRING;
 		if (!fetch_ucs2_nullterminated(parser, &ucs2_data))
 			return false;
-		pull_ucs2_talloc(parser->mem_ctx, (char**)&(parser->namedprop.kind.lpwstr.Name), ucs2_data, &(utf8_len));
+		pull_ucs2_talloc(parser->value_ctx, (char**)&(parser->namedprop.kind.lpwstr.Name), ucs2_data, &(utf8_len));
 		parser->namedprop.kind.lpwstr.NameSize = utf8_len;
 		/* printf("named: %s\n", parser->namedprop.kind.lpwstr.Name); */
 	} else {
@@ -540,6 +537,9 @@ _PUBLIC_ void fxparser_set_delprop_callback(struct fx_parser_context *parser, fx
 
 /**
   \details set a callback function for named properties output
+
+  The name of MNID_STRING named properties is released once the
+  callback returns: callbacks must copy it to keep it.
 */
 _PUBLIC_ void fxparser_set_namedprop_callback(struct fx_parser_context *parser, fxparser_namedprop_callback_t namedprop_callback)
 {
@@ -548,21 +548,81 @@ _PUBLIC_ void fxparser_set_namedprop_callback(struct fx_parser_context *parser,
 
 /**
   \details set a callback function for property output
+
+  The property value, and any data it points to, is allocated on a
+  parser owned context which is emptied once the callback returns.
+  Callbacks keeping values beyond the call must copy them, for example
+  with mapi_copy_spropvalues(). Values used to live on the memory
+  context given to fxparser_init() until the parser was released.
 */
 _PUBLIC_ void fxparser_set_property_callback(struct fx_parser_context *parser, fxparser_property_callback_t property_callback)
 {
 	parser->op_property = property_callback;
 }
 
+/**
+  \details set a callback function for streamed property output
+
+  Single-valued PT_BINARY, PT_SVREID, PT_OBJECT, PT_STRING8 and
+  PT_UNICODE values of at least threshold bytes are not buffered:
+  they are delivered to the callback in chunks as the stream is
+  parsed, and the property callback is not invoked for them. The
+  callback receives the property tag, the offset of the chunk within
+  the value, the total length of the value and the chunk. PT_UNICODE
+  values are delivered as raw UTF-16LE bytes.
+
+  \param parser the parser context
+  \param stream_callback the callback function
+  \param threshold the smallest value length to stream
+*/
+_PUBLIC_ void fxparser_set_stream_callback(struct fx_parser_context *parser, fxparser_stream_callback_t stream_callback, uint32_t threshold)
+{
+	parser->op_stream = stream_callback;
+	parser->stream_threshold = threshold;
+}
+
+/**
+  \details parse and report a property under another tag
+
+  Some properties are serialized with a type which differs from the
+  one in their tag, such as MetaTagIdsetGiven which is declared as
+  PT_LONG but carries an IDSET. Values of tag are parsed and reported
+  as values of mapped_tag.
+
+  \param parser the parser context
+  \param tag the property tag found in the stream
+  \param mapped_tag the property tag to parse and report the value as
+
+  \return MAPI_E_SUCCESS on success, otherwise MAPI error
+*/
+_PUBLIC_ enum MAPISTATUS fxparser_set_tag_mapping(struct fx_parser_context *parser, uint32_t tag, uint32_t mapped_tag)
+{
+	OPENCHANGE_RETVAL_IF(!parser, MAPI_E_INVALID_PARAMETER, NULL);
+
+	parser->tag_map = talloc_realloc(parser, parser->tag_map, struct fx_parser_tag_map, parser->tag_map_count + 1);
+	OPENCHANGE_RETVAL_IF(!parser->tag_map, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	parser->tag_map[parser->tag_map_count].tag = tag;
+	parser->tag_map[parser->tag_map_count].mapped_tag = mapped_tag;
+	parser->tag_map_count++;
+
+	return MAPI_E_SUCCESS;
+}
+
 /**
   \details initialise a fast transfer parser
+
+  Property values passed to the callbacks are released once the
+  callback returns: callbacks must copy the values they keep.
 */
 _PUBLIC_ struct fx_parser_context* fxparser_init(TALLOC_CTX *mem_ctx, void *priv)
 {
 	struct fx_parser_context *parser = talloc_zero(mem_ctx, struct fx_parser_context);
 
 	parser->mem_ctx = mem_ctx;
-	parser->data = data_blob_talloc_named(parser->mem_ctx, NULL, 0, "fast transfer parser");
+	parser->value_ctx = talloc_named_const(parser, 0, "fast transfer parser values");
+	parser->data = data_blob_null;
+	parser->size = 0;
 	parser->state = ParserState_Entry;
 	parser->idx = 0;
 	parser->lpProp.ulPropTag = (enum MAPITAGS) 0;
@@ -573,14 +633,121 @@ _PUBLIC_ struct fx_parser_context* fxparser_init(TALLOC_CTX *mem_ctx, void *priv
 	return parser;
 }
 
+/*
+ append a fast transfer buffer to the parser buffer, after dropping the
+ bytes already delivered to the callbacks. The buffer only holds the
+ item being parsed and the new data: it shrinks back once a large
+ buffered value has been delivered.
+*/
+static bool fxparser_append(struct fx_parser_context *parser, DATA_BLOB *fxbuf)
+{
+	size_t	remainder;
+	size_t	needed;
+	size_t	size;
+	uint8_t	*data;
+
+	remainder = parser->data.length - parser->idx;
+	if (parser->idx && remainder) {
+		memmove(parser->data.data, &(parser->data.data[parser->idx]), remainder);
+	}
+	parser->data.length = remainder;
+	parser->idx = 0;
+
+	needed = remainder + fxbuf->length;
+	size = parser->size ? parser->size : FXPARSER_MIN_BUFFER;
+	while (size < needed) {
+		size *= 2;
+	}
+	while (size > FXPARSER_MIN_BUFFER && needed < size / 4) {
+		size /= 2;
+	}
+
+	if (size != parser->size) {
+		data = talloc_realloc(parser, parser->data.data, uint8_t, size);
+		if (!data) {
+			if (needed > parser->size) return false;
+		} else {
+			parser->data.data = data;
+			parser->size = size;
+		}
+	}
+
+	if (fxbuf->length) {
+		memcpy(&(parser->data.data[remainder]), fxbuf->data, fxbuf->length);
+	}
+	parser->data.length = needed;
+
+	return true;
+}
+
+/*
+ check whether the value of the current property can be streamed
+*/
+static bool fxparser_is_streamable(struct fx_parser_context *parser)
+{
+	if (!parser->op_stream) return false;
+
+	switch (parser->lpProp.ulPropTag & 0xFFFF) {
+	case PT_STRING8:
+	case PT_UNICODE:
+	case PT_SVREID:
+	case PT_BINARY:
+	case PT_OBJECT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ deliver the available part of the value being streamed
+*/
+static enum MAPISTATUS fxparser_stream_value(struct fx_parser_context *parser)
+{
+	enum MAPISTATUS	ms;
+	DATA_BLOB	chunk;
+	uint32_t	available;
+
+	available = parser->data.length - parser->idx;
+	chunk.length = parser->stream_length - parser->stream_offset;
+	if (chunk.length > available) {
+		chunk.length = available;
+	}
+	if (!chunk.length && parser->stream_offset < parser->stream_length) {
+		parser->enough_data = false;
+		return MAPI_E_SUCCESS;
+	}
+	chunk.data = &(parser->data.data[parser->idx]);
+
+	ms = parser->op_stream(parser->lpProp.ulPropTag, parser->stream_offset, parser->stream_length, chunk, parser->priv);
+	parser->idx += chunk.length;
+	parser->stream_offset += chunk.length;
+	if (parser->stream_offset == parser->stream_length) {
+		parser->state = ParserState_Entry;
+	}
+
+	return ms;
+}
+
 /**
   \details parse a fast transfer buffer
+
+  Bytes are released as soon as the marker, property or chunk they
+  hold has been delivered to the callbacks, so memory use is bounded
+  by the size of the largest buffered property and of the input
+  buffers, not by the size of the stream.
 */
 _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_BLOB *fxbuf)
 {
 	enum MAPISTATUS ms = MAPI_E_SUCCESS;
+	uint32_t	i;
 
-	data_blob_append(parser->mem_ctx, &(parser->data), fxbuf->data, fxbuf->length);
+	OPENCHANGE_RETVAL_IF(!parser, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!fxbuf, MAPI_E_INVALID_PARAMETER, NULL);
+
+	if (!fxparser_append(parser, fxbuf)) {
+		return MAPI_E_NOT_ENOUGH_MEMORY;
+	}
 	parser->enough_data = true;
 	while(ms == MAPI_E_SUCCESS && (parser->idx < parser->data.length) && parser->enough_data) {
 		uint32_t idx = parser->idx;
@@ -612,6 +779,16 @@ _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_B
 					case EndAttach:
 					case StartEmbed:
 					case EndEmbed:
+					case IncrSyncChg:
+					case IncrSyncChgPartial:
+					case IncrSyncDel:
+					case IncrSyncEnd:
+					case IncrSyncRead:
+					case IncrSyncStateBegin:
+					case IncrSyncStateEnd:
+					case IncrSyncProgressMode:
+					case IncrSyncProgressPerMsg:
+					case IncrSyncMessage:
 						if (parser->op_marker) {
 							ms = parser->op_marker(parser->tag, parser->priv);
 						}
@@ -636,6 +813,12 @@ _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_B
 						/* standard property thing */
 						parser->lpProp.ulPropTag = (enum MAPITAGS) parser->tag;
 						parser->lpProp.dwAlignPad = 0;
+						for (i = 0; i < parser->tag_map_count; i++) {
+							if (parser->tag_map[i].tag == parser->tag) {
+								parser->lpProp.ulPropTag = (enum MAPITAGS) parser->tag_map[i].mapped_tag;
+								break;
+							}
+						}
 						if ((parser->lpProp.ulPropTag >> 16) & 0x8000) {
 							/* this is a named property */
 							// printf("tag: 0x%08x\n", parser->tag);
@@ -644,6 +827,7 @@ _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_B
 							if (pull_named_property(parser, &ms)) {
 								parser->state = ParserState_HavePropTag;
 							} else {
+								talloc_free_children(parser->value_ctx);
 								parser->enough_data = false;
 								parser->idx = idx;
 							}
@@ -656,6 +840,24 @@ _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_B
 			}
 			case ParserState_HavePropTag:
 			{
+				if (fxparser_is_streamable(parser)) {
+					uint32_t length;
+					if (!pull_uint32_t(parser, &length)) {
+						parser->enough_data = false;
+						parser->idx = idx;
+						break;
+					}
+					if (length >= parser->stream_threshold) {
+						talloc_free_children(parser->value_ctx);
+						parser->stream_length = length;
+						parser->stream_offset = 0;
+						parser->state = ParserState_StreamValue;
+						ms = fxparser_stream_value(parser);
+						break;
+					}
+					/* small value: parse it as a whole */
+					parser->idx = idx;
+				}
 				if (fetch_property_value(parser, &(parser->data), &(parser->lpProp))) {
 					// printf("position %i of %zi\n", parser->idx, parser->data.length);
 					if (parser->op_property) {
@@ -666,18 +868,31 @@ _PUBLIC_ enum MAPISTATUS fxparser_parse(struct fx_parser_context *parser, DATA_B
 					parser->enough_data = false;
 					parser->idx = idx;
 				}
+				talloc_free_children(parser->value_ctx);
+				break;
+			}
+			case ParserState_StreamValue:
+			{
+				ms = fxparser_stream_value(parser);
 				break;
 			}
 		}
 	}
-	{
-		// Remove the part of the buffer that we've used
-		uint32_t remainder_len = parser->data.length - parser->idx;
-		DATA_BLOB remainder = data_blob_talloc_named(parser->mem_ctx, &(parser->data.data[parser->idx]), remainder_len, "fast transfer parser");
-		data_blob_free(&(parser->data));
-		parser->data = remainder;
-		parser->idx = 0;
-	}
 
 	return ms;
 }
+
+/**
+  \details Check whether the parser has delivered all the data it received
+
+  \param parser the parser context
+
+  \return true if the parser is between two items and does not hold
+  any partial data, otherwise false
+*/
+_PUBLIC_ bool fxparser_is_idle(struct fx_parser_context *parser)
+{
+	if (!parser) return false;
+
+	return (parser->state == ParserState_Entry && parser->idx >= parser->data.length);
+}
@@ -25,11 +25,21 @@
    We mean it.
 */
 
-enum fx_parser_state { ParserState_Entry, ParserState_HaveTag, ParserState_HavePropTag };
+enum fx_parser_state { ParserState_Entry, ParserState_HaveTag, ParserState_HavePropTag, ParserState_StreamValue };
+
+/* initial size of the parser buffer */
+#define	FXPARSER_MIN_BUFFER	0x8000
+
+struct fx_parser_tag_map {
+	uint32_t		tag;
+	uint32_t		mapped_tag;
+};
 
 struct fx_parser_context {
 	TALLOC_CTX		*mem_ctx;
+	TALLOC_CTX		*value_ctx;	/* values of the current property, released once delivered */
 	DATA_BLOB		data;	/* the data we have (so far) to parse */
+	size_t			size;	/* allocated size of the data buffer */
 	uint32_t		idx;	/* where we are up to in the data blob */
 	enum fx_parser_state	state;
 	struct SPropValue	lpProp;		/* the current property tag and value we are parsing */
@@ -37,12 +47,22 @@ struct fx_parser_context {
 	bool 			enough_data;
 	uint32_t		tag;
 	void			*priv;
+
+	/* streamed property values */
+	uint32_t		stream_threshold;	/* smallest value delivered through op_stream */
+	uint32_t		stream_length;		/* length of the value being streamed */
+	uint32_t		stream_offset;		/* bytes of the value already delivered */
+
+	/* properties parsed under another tag */
+	struct fx_parser_tag_map	*tag_map;
+	uint32_t			tag_map_count;
 	
 	/* callbacks for parser actions */
 	enum MAPISTATUS (*op_marker)(uint32_t, void *);
 	enum MAPISTATUS (*op_delprop)(uint32_t, void *);
 	enum MAPISTATUS (*op_namedprop)(uint32_t, struct MAPINAMEID, void *);
 	enum MAPISTATUS (*op_property)(struct SPropValue, void *);
+	enum MAPISTATUS (*op_stream)(uint32_t, uint32_t, uint32_t, DATA_BLOB, void *);
 };
 
 #endif
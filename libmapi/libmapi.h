@@ -46,6 +46,7 @@
 
 /* Samba4 includes */
 #include <talloc.h>
+#include <tevent.h>
 #include <dcerpc.h>
 #include <util/debug.h>
 #include <param.h>
@@ -130,6 +131,7 @@ void			MAPIUninitialize(struct mapi_context *);
 enum MAPISTATUS		SetMAPIDumpData(struct mapi_context *, bool);
 enum MAPISTATUS		SetMAPIDebugLevel(struct mapi_context *, uint32_t);
 enum MAPISTATUS		GetLoadparmContext(struct mapi_context *, struct loadparm_context **);
+enum MAPISTATUS		GetEventContext(struct mapi_context *, struct tevent_context **);
 
 /* The following public definitions come from libmapi/simple_mapi.c */
 enum MAPISTATUS		GetDefaultPublicFolder(mapi_object_t *, uint64_t *, const uint32_t);
@@ -382,6 +384,8 @@ enum MAPISTATUS		OpenUserMailbox(struct mapi_session *, const char *, mapi_objec
 enum MAPISTATUS		Subscribe(mapi_object_t *, uint32_t *, uint16_t, bool, mapi_notify_callback_t, void *);
 enum MAPISTATUS		Unsubscribe(struct mapi_session *, uint32_t);
 enum MAPISTATUS		DispatchNotifications(struct mapi_session *);
+enum MAPISTATUS		GetNotificationFd(struct mapi_session *, int *);
+enum MAPISTATUS		ProcessPendingNotifications(struct mapi_session *);
 enum MAPISTATUS		MonitorNotification(struct mapi_session *, void *, struct mapi_notify_continue_callback_data *);
 
 /* The following public definitions come from libmapi/IMAPITable.c */
@@ -411,6 +415,8 @@ enum MAPISTATUS		RfrGetFQDNFromLegacyDN(struct mapi_context *, struct mapi_sessi
 enum MAPISTATUS		Logoff(mapi_object_t *);
 enum MAPISTATUS		RegisterNotification(struct mapi_session *);
 enum MAPISTATUS		RegisterAsyncNotification(struct mapi_session *, uint32_t *);
+struct tevent_req	*RegisterAsyncNotificationSend(TALLOC_CTX *, struct mapi_session *);
+enum MAPISTATUS		RegisterAsyncNotificationRecv(struct tevent_req *, uint32_t *);
 
 /* The following public definitions come from libmapi/IMessage.c */
 enum MAPISTATUS		CreateAttach(mapi_object_t *, mapi_object_t *);
@@ -528,13 +534,27 @@ typedef enum MAPISTATUS (*fxparser_marker_callback_t)(uint32_t, void *);
 typedef enum MAPISTATUS (*fxparser_delprop_callback_t)(uint32_t, void *);
 typedef enum MAPISTATUS (*fxparser_namedprop_callback_t)(uint32_t, struct MAPINAMEID, void *);
 typedef enum MAPISTATUS (*fxparser_property_callback_t)(struct SPropValue, void *);
+typedef enum MAPISTATUS (*fxparser_stream_callback_t)(uint32_t, uint32_t, uint32_t, DATA_BLOB, void *);
 
 struct fx_parser_context *fxparser_init(TALLOC_CTX *, void *);
 void 			fxparser_set_marker_callback(struct fx_parser_context *, fxparser_marker_callback_t);
 void 			fxparser_set_delprop_callback(struct fx_parser_context *, fxparser_delprop_callback_t);
 void 			fxparser_set_namedprop_callback(struct fx_parser_context *, fxparser_namedprop_callback_t);
 void 			fxparser_set_property_callback(struct fx_parser_context *, fxparser_property_callback_t);
+void 			fxparser_set_stream_callback(struct fx_parser_context *, fxparser_stream_callback_t, uint32_t);
+enum MAPISTATUS		fxparser_set_tag_mapping(struct fx_parser_context *, uint32_t, uint32_t);
 enum MAPISTATUS		fxparser_parse(struct fx_parser_context *, DATA_BLOB *);
+bool			fxparser_is_idle(struct fx_parser_context *);
+
+/* The following public definitions come from libmapi/fximport.c */
+struct fx_import_context;
+struct fx_import_message;
+
+enum MAPISTATUS		fximport_init(TALLOC_CTX *, mapi_object_t *, struct fx_import_context **);
+enum MAPISTATUS		fximport_set_buffer_size(struct fx_import_context *, uint16_t);
+enum MAPISTATUS		fximport_add_message(struct fx_import_context *, const struct fx_import_message *);
+enum MAPISTATUS		fximport_commit(struct fx_import_context *);
+enum MAPISTATUS		fximport_get_stats(struct fx_import_context *, uint32_t *, uint32_t *, uint64_t *);
 
 /* The following public definitions come from libmapi/idset.c */
 uint64_t		exchange_globcnt(uint64_t);
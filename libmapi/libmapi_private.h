@@ -58,6 +58,8 @@ __BEGIN_DECLS
 
 /* The following private definitions come from ndr_mapi.c */
 void obfuscate_data(uint8_t *, uint32_t, uint8_t);
+void obfuscate_copy(uint8_t *, const uint8_t *, uint32_t, uint8_t);
+enum ndr_err_code ndr_push_obfuscated_bytes(struct ndr_push *, const uint8_t *, uint32_t, uint8_t);
 enum ndr_err_code ndr_pull_lzxpress_decompress(struct ndr_pull *, struct ndr_pull **, ssize_t);
 enum ndr_err_code ndr_push_lzxpress_compress(struct ndr_push *, struct ndr_push *);
 enum ndr_err_code ndr_push_ExtendedException(struct ndr_push *, int, uint16_t, const struct ExceptionInfo *, const struct ExtendedException *);
@@ -84,6 +86,8 @@ bool 			server_version_at_least(struct emsmdb_context *, uint16_t, uint16_t, uin
 
 /* The following private definition comes from libmapi/async_emsmdb.c */
 enum MAPISTATUS emsmdb_async_waitex(struct emsmdb_context *, uint32_t, uint32_t *);
+struct tevent_req *emsmdb_async_waitex_send(TALLOC_CTX *, struct emsmdb_context *, uint32_t);
+enum MAPISTATUS emsmdb_async_waitex_recv(struct tevent_req *, uint32_t *);
 
 /* The following private definitions come from auto-generated libmapi/mapicode.c */
 void			set_errno(enum MAPISTATUS);
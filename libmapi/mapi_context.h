@@ -26,6 +26,7 @@
 
 struct ldb_context;
 struct mapi_session;
+struct tevent_context;
 
 struct mapi_context
 {
@@ -34,6 +35,7 @@ struct mapi_context
   struct mapi_session	*session;
   bool			dumpdata;
   struct loadparm_context *lp_ctx;
+  struct tevent_context	*ev;
 };
 
 
@@ -134,6 +134,15 @@
 #define KEEP_OPEN_READWRITE	0x0A
 #define FORCE_SAVE		0x0C
 
+/* GetSearchCriteria search state */
+#define	SEARCH_RUNNING		0x00000001
+#define	SEARCH_REBUILD		0x00000002
+#define	SEARCH_RECURSIVE	0x00000004
+#define	SEARCH_FOREGROUND	0x00000008
+#define	SEARCH_COMPLETE		0x00001000
+#define	SEARCH_PARTIAL		0x00002000
+#define	SEARCH_STATIC		0x00010000
+
 /* OpenMessage flags */
 #define	MAPI_MODIFY             0x1
 /* see MAPI_CREATE above */
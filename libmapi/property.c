@@ -655,11 +655,12 @@ _PUBLIC_ uint32_t get_mapi_property_size(struct mapi_SPropValue *lpProp)
 /**
    \details Convenience function to copy an array of struct SPropValue or a
    part thereof into another array, by duplicating and properly parenting
-   pointer data. The destination array is considered to be preallocated.
+   pointer data, multi-valued properties included. The destination array
+   is considered to be preallocated.
 */
 _PUBLIC_ void mapi_copy_spropvalues(TALLOC_CTX *mem_ctx, struct SPropValue *source_values, struct SPropValue *dest_values, uint32_t count)
 {
-	uint32_t		i;
+	uint32_t		i, j;
 	struct SPropValue	*source_value, *dest_value;
 	uint16_t		prop_type;
 
@@ -669,25 +670,62 @@ _PUBLIC_ void mapi_copy_spropvalues(TALLOC_CTX *mem_ctx, struct SPropValue *sour
 		*dest_value = *source_value;
 
 		prop_type = (source_value->ulPropTag & 0xFFFF);
-		if ((prop_type & MV_FLAG)) {
-			DEBUG(5, ("multivalues not handled\n"));
-			abort();
-		}
-		else {
-			switch(prop_type) {
-			case PT_STRING8:
-				dest_value->value.lpszA = talloc_strdup(mem_ctx, source_value->value.lpszA);
-				break;
-			case PT_UNICODE:
-				dest_value->value.lpszW = talloc_strdup(mem_ctx, source_value->value.lpszW);
-				break;
-			case PT_BINARY:
-				dest_value->value.bin.cb = source_value->value.bin.cb;
-				dest_value->value.bin.lpb = talloc_memdup(mem_ctx, source_value->value.bin.lpb, sizeof(uint8_t) * source_value->value.bin.cb);
-				break;
-			default:
-				*dest_value = *source_value;
+		switch(prop_type) {
+		case PT_STRING8:
+			dest_value->value.lpszA = talloc_strdup(mem_ctx, source_value->value.lpszA);
+			break;
+		case PT_UNICODE:
+			dest_value->value.lpszW = talloc_strdup(mem_ctx, source_value->value.lpszW);
+			break;
+		case PT_SVREID:
+		case PT_BINARY:
+			dest_value->value.bin.cb = source_value->value.bin.cb;
+			dest_value->value.bin.lpb = talloc_memdup(mem_ctx, source_value->value.bin.lpb, sizeof(uint8_t) * source_value->value.bin.cb);
+			break;
+		case PT_CLSID:
+			dest_value->value.lpguid = talloc_memdup(mem_ctx, source_value->value.lpguid, sizeof(struct FlatUID_r));
+			break;
+		case PT_MV_SHORT:
+			dest_value->value.MVi.lpi = talloc_memdup(mem_ctx, source_value->value.MVi.lpi, sizeof(uint16_t) * source_value->value.MVi.cValues);
+			break;
+		case PT_MV_LONG:
+			dest_value->value.MVl.lpl = talloc_memdup(mem_ctx, source_value->value.MVl.lpl, sizeof(uint32_t) * source_value->value.MVl.cValues);
+			break;
+		case PT_MV_I8:
+			dest_value->value.MVui8.lpui8 = talloc_memdup(mem_ctx, source_value->value.MVui8.lpui8, sizeof(uint64_t) * source_value->value.MVui8.cValues);
+			break;
+		case PT_MV_SYSTIME:
+			dest_value->value.MVft.lpft = talloc_memdup(mem_ctx, source_value->value.MVft.lpft, sizeof(struct FILETIME) * source_value->value.MVft.cValues);
+			break;
+		case PT_MV_STRING8:
+			dest_value->value.MVszA.lppszA = talloc_array(mem_ctx, const char *, source_value->value.MVszA.cValues);
+			for (j = 0; j < source_value->value.MVszA.cValues; j++) {
+				dest_value->value.MVszA.lppszA[j] = talloc_strdup(dest_value->value.MVszA.lppszA, source_value->value.MVszA.lppszA[j]);
+			}
+			break;
+		case PT_MV_UNICODE:
+			dest_value->value.MVszW.lppszW = talloc_array(mem_ctx, const char *, source_value->value.MVszW.cValues);
+			for (j = 0; j < source_value->value.MVszW.cValues; j++) {
+				dest_value->value.MVszW.lppszW[j] = talloc_strdup(dest_value->value.MVszW.lppszW, source_value->value.MVszW.lppszW[j]);
+			}
+			break;
+		case PT_MV_BINARY:
+			dest_value->value.MVbin.lpbin = talloc_array(mem_ctx, struct Binary_r, source_value->value.MVbin.cValues);
+			for (j = 0; j < source_value->value.MVbin.cValues; j++) {
+				dest_value->value.MVbin.lpbin[j].cb = source_value->value.MVbin.lpbin[j].cb;
+				dest_value->value.MVbin.lpbin[j].lpb = talloc_memdup(dest_value->value.MVbin.lpbin, source_value->value.MVbin.lpbin[j].lpb,
+										     source_value->value.MVbin.lpbin[j].cb);
+			}
+			break;
+		case PT_MV_CLSID:
+			dest_value->value.MVguid.lpguid = talloc_array(mem_ctx, struct FlatUID_r *, source_value->value.MVguid.cValues);
+			for (j = 0; j < source_value->value.MVguid.cValues; j++) {
+				dest_value->value.MVguid.lpguid[j] = talloc_memdup(dest_value->value.MVguid.lpguid, source_value->value.MVguid.lpguid[j],
+										   sizeof(struct FlatUID_r));
 			}
+			break;
+		default:
+			break;
 		}
 	}
 }
@@ -22,8 +22,6 @@
 
 void ocpf_error_message (struct ocpf_context *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
 
-extern int error_flag;
-
 /* int ocpf_yylex(YYSTYPE *); */
 
 #endif /* __LEX_H_ */
@@ -32,6 +32,18 @@
 #define	OCPF_FLAGS_WRITE		2
 #define	OCPF_FLAGS_CREATE		3
 
+/**
+   Value bound to an OCPF variable when instantiating a template. The
+   value must match the type of the variable declared with SET in the
+   OCPF file.
+ */
+struct ocpf_binding {
+	const char	*name;
+	const void	*value;
+};
+
+struct ocpf_template;
+
 enum ocpf_recipClass {
 	OCPF_MAPI_TO = 0x1,
 	OCPF_MAPI_CC,
@@ -72,6 +84,17 @@ enum MAPISTATUS ocpf_OpenFolder(uint32_t, mapi_object_t *, mapi_object_t *);
 enum MAPISTATUS ocpf_set_Recipients(TALLOC_CTX *, uint32_t, mapi_object_t *);
 enum MAPISTATUS ocpf_clear_props (uint32_t context_id);
 
+/* The following public definitions come from libocpf/ocpf_template.c */
+int ocpf_template_load(const char *, struct ocpf_template **);
+int ocpf_template_cache_get(const char *, struct ocpf_template **);
+int ocpf_template_release(struct ocpf_template *);
+void ocpf_template_cache_flush(void);
+enum MAPISTATUS ocpf_template_get_nameid(TALLOC_CTX *, struct ocpf_template *, struct mapi_nameid **);
+enum MAPISTATUS ocpf_template_map_names(TALLOC_CTX *, struct ocpf_template *, mapi_object_t *, struct SPropTagArray **);
+enum MAPISTATUS ocpf_template_instantiate(TALLOC_CTX *, struct ocpf_template *, struct SPropTagArray *,
+					  const struct ocpf_binding *, uint32_t, struct SPropValue **, uint32_t *);
+enum MAPISTATUS ocpf_template_get_recipients(struct ocpf_template *, struct SRowSet **);
+
 /* The following public definitions come from libocpf/ocpf_server.c */
 enum MAPISTATUS ocpf_server_set_type(uint32_t, const char *);
 enum MAPISTATUS ocpf_server_set_SPropValue(TALLOC_CTX *, uint32_t);
@@ -74,7 +74,7 @@ int ocpf_propvalue_var(struct ocpf_context *ctx,
 	void			*value;
 	int			i;
 
-	if (!ocpf || !ocpf->mem_ctx) return -1;
+	if (!ctx) return -1;
 	if (!propname && !proptag) return -1;
 	if (propname && proptag) return -1;
 
@@ -96,6 +96,7 @@ int ocpf_propvalue_var(struct ocpf_context *ctx,
 				element = NULL;
 				element = talloc_zero(ctx->vars, struct ocpf_property);
 				element->aulPropTag = aulPropTag;
+				element->var = vel->name;
 				if (unescape && (((aulPropTag & 0xFFFF) == PT_STRING8) || 
 						 ((aulPropTag & 0xFFFF) == PT_UNICODE))) {
 					element->value = ocpf_write_unescape_string(ctx, vel->value);
@@ -312,7 +313,6 @@ int ocpf_propvalue(struct ocpf_context *ctx,
 	void			*value;
 	int			i;
 
-	if (!ocpf || !ocpf->mem_ctx) return OCPF_ERROR;
 	if (!ctx) return OCPF_ERROR;
 
 	switch (scope) {
@@ -373,7 +373,7 @@ int ocpf_new_recipient(struct ocpf_context *ctx)
 {
 	uint32_t	cRows;
 	
-	if (!ocpf || !ocpf->mem_ctx) return OCPF_ERROR;
+	if (!ctx) return OCPF_ERROR;
 	if (!ctx->recipients || !ctx->recipients->aRow) return OCPF_ERROR;
 
 	ctx->recipients->cRows += 1;
@@ -394,7 +394,7 @@ int ocpf_recipient_set_class(struct ocpf_context *ctx, enum ulRecipClass class)
 	struct SRow		aRow;
 	int			i;
 
-	if (!ocpf || !ocpf->mem_ctx) return OCPF_ERROR;
+	if (!ctx) return OCPF_ERROR;
 	if (!ctx->recipients || !ctx->recipients->aRow) return OCPF_ERROR;
 
 	cRows = ctx->recipients->cRows;
@@ -470,7 +470,7 @@ int ocpf_nproperty_add(struct ocpf_context *ctx,
 	struct ocpf_nproperty	*el;
 	struct ocpf_var		*vel;
 
-	if (!ocpf || !ocpf->mem_ctx) return -1;
+	if (!ctx) return -1;
 
 	element = talloc_zero(ctx, struct ocpf_nproperty);
 
@@ -543,6 +543,7 @@ int ocpf_nproperty_add(struct ocpf_context *ctx,
 			if (vel->name && !strcmp(vel->name, var_name)) {
 				OCPF_RETVAL_IF(element->propType != vel->propType, ctx, OCPF_WARN_PROPVALUE_MISMATCH, element);
 				element->value = vel->value;
+				element->var = vel->name;
 			}
 		}
 		OCPF_RETVAL_IF(!element->value, ctx, OCPF_WARN_VAR_NOT_REGISTERED, element);
@@ -571,7 +572,7 @@ int ocpf_nproperty_add(struct ocpf_context *ctx,
  */
 int ocpf_type_add(struct ocpf_context *ctx, const char *type)
 {
-	if (!ocpf || !ocpf->mem_ctx || !type) return OCPF_ERROR;
+	if (!ctx || !type) return OCPF_ERROR;
 
 	if (ctx->type) {
 		talloc_free((void *)ctx->type);
@@ -675,7 +676,7 @@ int ocpf_oleguid_add(struct ocpf_context *ctx,
 	struct GUID		guid;
 
 	/* Sanity checks */
-	if (!ocpf || !ocpf->mem_ctx) return OCPF_ERROR;
+	if (!ctx) return OCPF_ERROR;
 	if (!name) return OCPF_ERROR;
 
 	/* Sanity check: Do not insert twice the same name or guid */
@@ -765,7 +766,7 @@ int ocpf_variable_add(struct ocpf_context *ctx,
 	struct ocpf_var		*element;
 	int			ret;
 
-	if (!ocpf || !ocpf->mem_ctx) return OCPF_ERROR;
+	if (!ctx) return OCPF_ERROR;
 	if (!name) return OCPF_ERROR;
 
 	/* Sanity check: Do not insert twice the same variable */
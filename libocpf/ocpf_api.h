@@ -45,6 +45,7 @@ struct ocpf_property
 	struct ocpf_property	*next;
 	uint32_t		aulPropTag;
 	const void		*value;
+	const char		*var;
 };
 
 struct ocpf_nprop
@@ -74,6 +75,7 @@ struct ocpf_nproperty
 	uint16_t		propType;
 	const char		*oleguid;
 	const void		*value;
+	const char		*var;
 };
 
 struct ocpf_olfolder
@@ -94,6 +96,7 @@ struct ocpf_context
 	struct ocpf_nprop	nprop;
 	unsigned int		lineno;
 	int			result;
+	int			error_flag;
 	/* ocpf */
 	const char		*type;
 	struct ocpf_var		*vars;
@@ -129,6 +132,19 @@ struct ocpf
 	uint32_t		last_id;
 };
 
+struct ocpf_template
+{
+	struct ocpf_context	*ctx;
+	const char		*filename;
+	time_t			mtime;
+	uint32_t		nprops;
+	bool			*nameid_mapped;
+	uint32_t		ref_count;
+	bool			cached;
+	struct ocpf_template	*prev;
+	struct ocpf_template	*next;
+};
+
 
 #include "libocpf/ocpf_private.h"
 
@@ -202,6 +218,9 @@ do {								\
 
 #define	OCPF_INVALID_RECIPIENTS		"Invalid recipients"
 
+#define	OCPF_INVALID_TEMPLATE		"Invalid OCPF template"
+#define	OCPF_WARN_PARSE			"Unable to parse file"
+
 #define	OCPF_PROPERTY_BEGIN		"PROPERTY {\n"
 #define	OCPF_NPROPERTY_BEGIN		"NPROPERTY {\n"
 #define	OCPF_END			"};\n"
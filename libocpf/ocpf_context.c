@@ -37,7 +37,8 @@
    \param filename the OCPF filename used for this context
    \param flags Flags controlling how the OCPF should be opened
    \param context_id the identifier representing the context
-   \param context_id the context identifier to use for this context
+   \param context_id the context identifier to use for this context,
+   or 0 for a context which is not registered in the global list
 
    \return new allocated OCPF context on success, otherwise NULL
  */
@@ -50,7 +51,6 @@ struct ocpf_context *ocpf_context_init(TALLOC_CTX *mem_ctx,
 	struct stat		sb;
 
 	OCPF_RETVAL_TYPE(!mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL, NULL);
-	OCPF_RETVAL_TYPE(!context_id, NULL, OCPF_INVALID_CONTEXT, NULL, NULL);
 	OCPF_RETVAL_TYPE(!filename, NULL, OCPF_WARN_FILENAME_INVALID, NULL, NULL);
 
 	switch (flags) {
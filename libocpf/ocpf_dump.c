@@ -55,7 +55,7 @@ _PUBLIC_ void ocpf_dump_type(uint32_t context_id)
 {
 	struct ocpf_context	*ctx;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "TYPE", OCPF_DUMP_TOPLEVEL);
@@ -64,6 +64,8 @@ _PUBLIC_ void ocpf_dump_type(uint32_t context_id)
 	INDENT();
 	OCPF_DUMP(("* %s", ctx->type ? ctx->type : "Undefined"));
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 
@@ -76,7 +78,7 @@ _PUBLIC_ void ocpf_dump_folder(uint32_t context_id)
 {
 	struct ocpf_context	*ctx;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "FOLDER", OCPF_DUMP_TOPLEVEL);
@@ -85,6 +87,8 @@ _PUBLIC_ void ocpf_dump_folder(uint32_t context_id)
 	INDENT();
 	OCPF_DUMP(("* 0x%llx", ctx->folder ? ctx->folder : 0xFFFFFFFF));
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 
@@ -100,7 +104,7 @@ _PUBLIC_ void ocpf_dump_recipients(uint32_t context_id)
 	struct SPropValue	*lpProps;
 	uint32_t		*RecipClass;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "RECIPIENTS", OCPF_DUMP_TOPLEVEL);
@@ -129,6 +133,8 @@ _PUBLIC_ void ocpf_dump_recipients(uint32_t context_id)
 
 	indent--;
 	printf("\n");
+
+	ocpf_context_release(ctx);
 }
 
 
@@ -142,7 +148,7 @@ _PUBLIC_ void ocpf_dump_oleguid(uint32_t context_id)
 	struct ocpf_context	*ctx;
 	struct ocpf_oleguid	*element;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "OLEGUID", OCPF_DUMP_TOPLEVEL);
@@ -152,6 +158,8 @@ _PUBLIC_ void ocpf_dump_oleguid(uint32_t context_id)
 		printf("%-25s: %s\n", element->name, element->guid);
 	}
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 
@@ -160,7 +168,7 @@ _PUBLIC_ void ocpf_dump_variable(uint32_t context_id)
 	struct ocpf_context	*ctx;
 	struct ocpf_var		*element;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "VARIABLE", OCPF_DUMP_TOPLEVEL);
@@ -170,6 +178,8 @@ _PUBLIC_ void ocpf_dump_variable(uint32_t context_id)
 		printf("%s\n", element->name);
 	}
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 _PUBLIC_ void ocpf_dump_property(uint32_t context_id)
@@ -178,7 +188,7 @@ _PUBLIC_ void ocpf_dump_property(uint32_t context_id)
 	struct ocpf_property	*element;
 	const char		*proptag;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "PROPERTIES", OCPF_DUMP_TOPLEVEL);
@@ -191,6 +201,8 @@ _PUBLIC_ void ocpf_dump_property(uint32_t context_id)
 	
 	}
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 
@@ -199,7 +211,7 @@ _PUBLIC_ void ocpf_dump_named_property(uint32_t context_id)
 	struct ocpf_context	*ctx;
 	struct ocpf_nproperty	*element;
 
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	if (!ctx) return;
 
 	OCPF_DUMP_TITLE(indent, "NAMED PROPERTIES", OCPF_DUMP_TOPLEVEL);
@@ -236,6 +248,8 @@ _PUBLIC_ void ocpf_dump_named_property(uint32_t context_id)
 	indent--;
 
 	indent--;
+
+	ocpf_context_release(ctx);
 }
 
 
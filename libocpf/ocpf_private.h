@@ -24,6 +24,17 @@
 #include <stdlib.h>
 #include <libocpf/ocpf.tab.h>
 
+#if defined(HAVE_PTHREADS)
+#include <pthread.h>
+#define	OCPF_MUTEX(m)		static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER
+#define	OCPF_LOCK(m)		pthread_mutex_lock(&(m))
+#define	OCPF_UNLOCK(m)		pthread_mutex_unlock(&(m))
+#else
+#define	OCPF_MUTEX(m)		static int m
+#define	OCPF_LOCK(m)		(void)(m)
+#define	OCPF_UNLOCK(m)		(void)(m)
+#endif
+
 #ifndef HAVE_COMPARISON_FN_T
 #define HAVE_COMPARISON_FN_T
 typedef int (*comparison_fn_t)(const void *, const void *);
@@ -66,6 +77,11 @@ int ocpf_add_filetime(const char *, struct FILETIME *);
 int ocpf_variable_add(struct ocpf_context *, const char *, union SPropValue_CTR, uint16_t, bool);
 int ocpf_binary_add(struct ocpf_context *, const char *, struct Binary_r *);
 
+/* The following private definitions come from libocpf/ocpf_public.c */
+int ocpf_context_parse(struct ocpf_context *);
+struct ocpf_context *ocpf_context_lookup(uint32_t);
+void ocpf_context_release(struct ocpf_context *);
+
 /* The following private definitions come from libocpf/ocpf_write.c */
 char *ocpf_write_unescape_string(TALLOC_CTX *, const char *);
 
@@ -35,7 +35,9 @@ int ocpf_yylex_destroy(void *);
 int ocpf_yyparse(struct ocpf_context *, void *);
 
 struct ocpf	*ocpf;
-int		error_flag;
+
+/* Protects the global context list and the context identifiers */
+OCPF_MUTEX(ocpf_mutex);
 
 
 /**
@@ -50,8 +52,12 @@ int		error_flag;
 _PUBLIC_ int ocpf_init(void)
 {
 	TALLOC_CTX	*mem_ctx;
-	
-	OCPF_RETVAL_IF(ocpf, NULL, OCPF_INITIALIZED, NULL);
+
+	OCPF_LOCK(ocpf_mutex);
+	if (ocpf) {
+		OCPF_UNLOCK(ocpf_mutex);
+		OCPF_RETVAL_IF(1, NULL, OCPF_INITIALIZED, NULL);
+	}
 
 	mem_ctx = talloc_named(NULL, 0, "ocpf");
 	ocpf = talloc_zero(mem_ctx, struct ocpf);
@@ -60,6 +66,7 @@ _PUBLIC_ int ocpf_init(void)
 	ocpf->context = talloc_zero(mem_ctx, struct ocpf_context);
 	ocpf->free_id = talloc_zero(mem_ctx, struct ocpf_freeid);
 	ocpf->last_id = 1;
+	OCPF_UNLOCK(ocpf_mutex);
 
 	return OCPF_SUCCESS;
 }
@@ -76,10 +83,15 @@ _PUBLIC_ int ocpf_init(void)
  */
 _PUBLIC_ int ocpf_release(void)
 {
-	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);	
+	OCPF_LOCK(ocpf_mutex);
+	if (!ocpf || !ocpf->mem_ctx) {
+		OCPF_UNLOCK(ocpf_mutex);
+		OCPF_RETVAL_IF(1, NULL, OCPF_NOT_INITIALIZED, NULL);
+	}
 
 	talloc_free(ocpf->mem_ctx);
 	ocpf = NULL;
+	OCPF_UNLOCK(ocpf_mutex);
 
 	return OCPF_SUCCESS;
 }
@@ -101,15 +113,19 @@ _PUBLIC_ int ocpf_new_context(const char *filename, uint32_t *context_id, uint8_
 
 	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
 
+	OCPF_LOCK(ocpf_mutex);
 	ctx = ocpf_context_add(ocpf, filename, context_id, flags, &existing);
 	if (!ctx) {
+		OCPF_UNLOCK(ocpf_mutex);
 		return OCPF_ERROR;
 	}
 
 	if (existing == false) {
 		DLIST_ADD_END(ocpf->context, ctx, struct ocpf_context *);
+		OCPF_UNLOCK(ocpf_mutex);
 		return OCPF_SUCCESS;
-	} 
+	}
+	OCPF_UNLOCK(ocpf_mutex);
 
 	return OCPF_E_EXIST;
 }
@@ -132,10 +148,15 @@ _PUBLIC_ int ocpf_del_context(uint32_t context_id)
 	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
 
 	/* Search the context */
+	OCPF_LOCK(ocpf_mutex);
 	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
+	if (!ctx) {
+		OCPF_UNLOCK(ocpf_mutex);
+		OCPF_RETVAL_IF(1, NULL, OCPF_INVALID_CONTEXT, NULL);
+	}
 
 	ret = ocpf_context_delete(ocpf, ctx);
+	OCPF_UNLOCK(ocpf_mutex);
 	if (ret == -1) return OCPF_ERROR;
 
 	return OCPF_SUCCESS;
@@ -156,17 +177,40 @@ _PUBLIC_ int ocpf_del_context(uint32_t context_id)
  */
 _PUBLIC_ int ocpf_parse(uint32_t context_id)
 {
-	int			ret;
 	struct ocpf_context	*ctx;
-	void			*scanner;
+	int			ret;
 
 	/* Sanity checks */
 	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
 
 	/* Step 1. Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
 
+	ret = ocpf_context_parse(ctx);
+	ocpf_context_release(ctx);
+
+	return ret;
+}
+
+
+/**
+   \details Run the OCPF parser on a context
+
+   Each call uses its own scanner and only touches the given context,
+   so different contexts can be parsed concurrently.
+
+   \param ctx pointer to the OCPF context holding the file to parse
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+ */
+int ocpf_context_parse(struct ocpf_context *ctx)
+{
+	int			ret;
+	void			*scanner;
+
+	if (!ctx || !ctx->fp) return OCPF_ERROR;
+
 	ret = ocpf_yylex_init(&scanner);
 	ret = ocpf_yylex_init_extra(ctx, &scanner);
 	ocpf_yyset_in(ctx->fp, scanner);
@@ -177,6 +221,56 @@ _PUBLIC_ int ocpf_parse(uint32_t context_id)
 }
 
 
+/**
+   \details Search a context in the global list given its identifier
+
+   The context reference counter is incremented, so the context is
+   not released by a concurrent ocpf_del_context while the caller uses
+   it. Each successful lookup must be balanced by a call to
+   ocpf_context_release.
+
+   \param context_id the identifier of the context to search
+
+   \return pointer to the OCPF context on success, otherwise NULL
+
+   \sa ocpf_context_release
+ */
+struct ocpf_context *ocpf_context_lookup(uint32_t context_id)
+{
+	struct ocpf_context	*ctx;
+
+	if (!ocpf) return NULL;
+
+	OCPF_LOCK(ocpf_mutex);
+	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	if (ctx) {
+		ctx->ref_count += 1;
+	}
+	OCPF_UNLOCK(ocpf_mutex);
+
+	return ctx;
+}
+
+
+/**
+   \details Release a context returned by ocpf_context_lookup
+
+   The context is freed if it was deleted while in use.
+
+   \param ctx pointer to the OCPF context to release
+
+   \sa ocpf_context_lookup
+ */
+void ocpf_context_release(struct ocpf_context *ctx)
+{
+	if (!ocpf || !ctx) return;
+
+	OCPF_LOCK(ocpf_mutex);
+	ocpf_context_delete(ocpf, ctx);
+	OCPF_UNLOCK(ocpf_mutex);
+}
+
+
 #define	MAX_READ_SIZE	0x1000
 
 static enum MAPISTATUS ocpf_stream(TALLOC_CTX *mem_ctx,
@@ -226,50 +320,18 @@ static enum MAPISTATUS ocpf_stream(TALLOC_CTX *mem_ctx,
 }
 
 
-/**
-   \details Build a SPropValue array from ocpf context
-
-   This function builds a SPropValue array from the ocpf context and
-   information stored.
-
-   \param mem_ctx the memory context to use for memory allocation
-   \param context_id identifier of the context to build a SPropValue
-   array for
-   \param obj_folder pointer the folder object we use for internal
-   MAPI operations
-   \param obj_message pointer to the message object we use for
-   internal MAPI operations
-
-   \return MAPI_E_SUCCESS on success, otherwise -1.
-
-   \note Developers should call GetLastError() to retrieve the last
-   MAPI error code. Possible MAPI error codes are:
-   - MAPI_E_NOT_INITIALIZED: MAPI subsystem has not been initialized
-
-   \sa ocpf_get_SPropValue
- */
-
-_PUBLIC_ enum MAPISTATUS ocpf_set_SPropValue(TALLOC_CTX *mem_ctx,
-					     uint32_t context_id,
-					     mapi_object_t *obj_folder,
-					     mapi_object_t *obj_message)
+static enum MAPISTATUS ocpf_context_set_SPropValue(TALLOC_CTX *mem_ctx,
+						  struct ocpf_context *ctx,
+						  mapi_object_t *obj_folder,
+						  mapi_object_t *obj_message)
 {
 	enum MAPISTATUS		retval;
 	struct mapi_nameid	*nameid;
 	struct SPropTagArray	*SPropTagArray;
 	struct ocpf_property	*pel;
 	struct ocpf_nproperty	*nel;
-	struct ocpf_context	*ctx;
 	uint32_t		i;
 
-	/* sanity checks */
-	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
-	MAPI_RETVAL_IF(!obj_folder, MAPI_E_INVALID_PARAMETER, NULL);
-	
-	/* Step 0. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
-
 	if (!mem_ctx) {
 		mem_ctx = (TALLOC_CTX *) ctx;
 	}
@@ -347,6 +409,52 @@ _PUBLIC_ enum MAPISTATUS ocpf_set_SPropValue(TALLOC_CTX *mem_ctx,
 	return MAPI_E_SUCCESS;
 }
 
+
+/**
+   \details Build a SPropValue array from ocpf context
+
+   This function builds a SPropValue array from the ocpf context and
+   information stored.
+
+   \param mem_ctx the memory context to use for memory allocation
+   \param context_id identifier of the context to build a SPropValue
+   array for
+   \param obj_folder pointer the folder object we use for internal
+   MAPI operations
+   \param obj_message pointer to the message object we use for
+   internal MAPI operations
+
+   \return MAPI_E_SUCCESS on success, otherwise -1.
+
+   \note Developers should call GetLastError() to retrieve the last
+   MAPI error code. Possible MAPI error codes are:
+   - MAPI_E_NOT_INITIALIZED: MAPI subsystem has not been initialized
+
+   \sa ocpf_get_SPropValue
+ */
+
+_PUBLIC_ enum MAPISTATUS ocpf_set_SPropValue(TALLOC_CTX *mem_ctx,
+					     uint32_t context_id,
+					     mapi_object_t *obj_folder,
+					     mapi_object_t *obj_message)
+{
+	enum MAPISTATUS		retval;
+	struct ocpf_context	*ctx;
+
+	/* sanity checks */
+	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
+	MAPI_RETVAL_IF(!obj_folder, MAPI_E_INVALID_PARAMETER, NULL);
+
+	/* Step 0. Search for the context */
+	ctx = ocpf_context_lookup(context_id);
+	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
+
+	retval = ocpf_context_set_SPropValue(mem_ctx, ctx, obj_folder, obj_message);
+	ocpf_context_release(ctx);
+
+	return retval;
+}
+
 /**
   \details Clear the known properties from the OCPF entity
   
@@ -362,13 +470,14 @@ enum MAPISTATUS ocpf_clear_props (uint32_t context_id)
 	MAPI_RETVAL_IF(!ocpf->mem_ctx, MAPI_E_NOT_INITIALIZED, NULL);
 
 	/* Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	MAPI_RETVAL_IF(!ctx, MAPI_E_NOT_FOUND, NULL);
 
 	if (ctx->props) {
 		talloc_free(ctx->props);
 	}
 	ctx->props = talloc_zero(ctx, struct ocpf_property);
+	ocpf_context_release(ctx);
 
 	return MAPI_E_SUCCESS;
 }
@@ -391,18 +500,25 @@ enum MAPISTATUS ocpf_clear_props (uint32_t context_id)
 _PUBLIC_ struct SPropValue *ocpf_get_SPropValue(uint32_t context_id, uint32_t *cValues)
 {
 	struct ocpf_context	*ctx;
+	struct SPropValue	*lpProps;
 
 	OCPF_RETVAL_TYPE(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL, NULL);
 
 	/* Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_TYPE(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL, NULL);
 
-	OCPF_RETVAL_TYPE(!ctx->lpProps || !ctx->cValues, ctx, OCPF_INVALID_PROPARRAY, NULL, NULL);
+	if (!ctx->lpProps || !ctx->cValues) {
+		ocpf_do_debug(ctx, "%s", OCPF_INVALID_PROPARRAY);
+		ocpf_context_release(ctx);
+		return NULL;
+	}
 
 	*cValues = ctx->cValues;
+	lpProps = ctx->lpProps;
+	ocpf_context_release(ctx);
 
-	return ctx->lpProps;
+	return lpProps;
 }
 
 
@@ -460,6 +576,37 @@ static enum MAPISTATUS ocpf_folder_lookup(TALLOC_CTX *mem_ctx,
 }
 
 
+static enum MAPISTATUS ocpf_context_OpenFolder(struct ocpf_context *ctx,
+					       mapi_object_t *obj_store,
+					       mapi_object_t *obj_folder)
+{
+	enum MAPISTATUS		retval;
+	mapi_id_t		id_folder;
+	mapi_id_t		id_tis;
+
+	MAPI_RETVAL_IF(!ctx->folder, MAPI_E_NOT_FOUND, NULL);
+
+	mapi_object_init(obj_folder);
+	if (ctx->folder >= 1 && ctx->folder <= 26) {
+		retval = GetDefaultFolder(obj_store, &id_folder, ctx->folder);
+		MAPI_RETVAL_IF(retval, retval, NULL);
+
+		retval = OpenFolder(obj_store, id_folder, obj_folder);
+		MAPI_RETVAL_IF(retval, retval, NULL);
+
+	} else {
+		retval = GetDefaultFolder(obj_store, &id_tis, olFolderTopInformationStore);
+		MAPI_RETVAL_IF(retval, retval, NULL);
+
+		retval = ocpf_folder_lookup((TALLOC_CTX *)ctx, ctx->folder, 
+					    obj_store, id_tis, obj_folder);
+		MAPI_RETVAL_IF(retval, retval, NULL);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
 /**
    \details Open OCPF folder
 
@@ -487,36 +634,19 @@ _PUBLIC_ enum MAPISTATUS ocpf_OpenFolder(uint32_t context_id,
 {
 	enum MAPISTATUS		retval;
 	struct ocpf_context	*ctx;
-	mapi_id_t		id_folder;
-	mapi_id_t		id_tis;
 
 	/* Sanity checks */
 	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
 	MAPI_RETVAL_IF(!obj_store, MAPI_E_INVALID_PARAMETER, NULL);
 
 	/* Step 1. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	MAPI_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
-	MAPI_RETVAL_IF(!ctx->folder, MAPI_E_NOT_FOUND, NULL);
 
-	mapi_object_init(obj_folder);
-	if (ctx->folder >= 1 && ctx->folder <= 26) {
-		retval = GetDefaultFolder(obj_store, &id_folder, ctx->folder);
-		MAPI_RETVAL_IF(retval, retval, NULL);
-
-		retval = OpenFolder(obj_store, id_folder, obj_folder);
-		MAPI_RETVAL_IF(retval, retval, NULL);
+	retval = ocpf_context_OpenFolder(ctx, obj_store, obj_folder);
+	ocpf_context_release(ctx);
 
-	} else {
-		retval = GetDefaultFolder(obj_store, &id_tis, olFolderTopInformationStore);
-		MAPI_RETVAL_IF(retval, retval, NULL);
-
-		retval = ocpf_folder_lookup((TALLOC_CTX *)ctx, ctx->folder, 
-					    obj_store, id_tis, obj_folder);
-		MAPI_RETVAL_IF(retval, retval, NULL);
-	}
-
-	return MAPI_E_SUCCESS;
+	return retval;
 }
 
 
@@ -575,27 +705,11 @@ static bool set_external_recipients(TALLOC_CTX *mem_ctx, struct SRowSet *SRowSet
 }
 
 
-/**
-   \details Set the message recipients from ocpf context
-
-   This function sets the recipient (To, Cc, Bcc) from the ocpf
-   context and information stored.
-
-   \param mem_ctx the memory context to use for memory allocation
-   \param context_id identifier to the context to set recipients for
-   \param obj_message pointer to the message object we use for
-   internal MAPI operations
-
-   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR.
-
-   \sa ocpf
- */
-_PUBLIC_ enum MAPISTATUS ocpf_set_Recipients(TALLOC_CTX *mem_ctx,
-					     uint32_t context_id,
-					     mapi_object_t *obj_message)
+static enum MAPISTATUS ocpf_context_set_Recipients(TALLOC_CTX *mem_ctx,
+						  struct ocpf_context *ctx,
+						  mapi_object_t *obj_message)
 {
 	enum MAPISTATUS			retval;
-	struct ocpf_context		*ctx;
 	struct SPropTagArray		*SPropTagArray;
 	struct SPropValue		SPropValue;
 	struct SPropValue		*lpProps;
@@ -608,13 +722,6 @@ _PUBLIC_ enum MAPISTATUS ocpf_set_Recipients(TALLOC_CTX *mem_ctx,
 	uint32_t			i;
 	const void			*propdata;
 
-	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
-	MAPI_RETVAL_IF(!obj_message, MAPI_E_INVALID_PARAMETER, NULL);
-
-	/* Step 1. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	MAPI_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
-
 	MAPI_RETVAL_IF(!ctx->recipients->cRows, MAPI_E_NOT_FOUND, NULL);
 
 	SPropTagArray = set_SPropTagArray(mem_ctx, 0x8,
@@ -676,6 +783,42 @@ _PUBLIC_ enum MAPISTATUS ocpf_set_Recipients(TALLOC_CTX *mem_ctx,
 }
 
 
+/**
+   \details Set the message recipients from ocpf context
+
+   This function sets the recipient (To, Cc, Bcc) from the ocpf
+   context and information stored.
+
+   \param mem_ctx the memory context to use for memory allocation
+   \param context_id identifier to the context to set recipients for
+   \param obj_message pointer to the message object we use for
+   internal MAPI operations
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR.
+
+   \sa ocpf
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_set_Recipients(TALLOC_CTX *mem_ctx,
+					     uint32_t context_id,
+					     mapi_object_t *obj_message)
+{
+	enum MAPISTATUS			retval;
+	struct ocpf_context		*ctx;
+
+	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
+	MAPI_RETVAL_IF(!obj_message, MAPI_E_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search for the context */
+	ctx = ocpf_context_lookup(context_id);
+	MAPI_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
+
+	retval = ocpf_context_set_Recipients(mem_ctx, ctx, obj_message);
+	ocpf_context_release(ctx);
+
+	return retval;
+}
+
+
 /**
    \details Get the message recipients from ocpf context
 
@@ -701,11 +844,15 @@ _PUBLIC_ enum MAPISTATUS ocpf_get_recipients(TALLOC_CTX *mem_ctx,
 	MAPI_RETVAL_IF(!SRowSet, MAPI_E_INVALID_PARAMETER, NULL);
 
 	/* Step 1. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	MAPI_RETVAL_IF(!ctx, MAPI_E_INVALID_PARAMETER, NULL);
-	MAPI_RETVAL_IF(!ctx->recipients->cRows, MAPI_E_NOT_FOUND, NULL);
+	if (!ctx->recipients->cRows) {
+		ocpf_context_release(ctx);
+		MAPI_RETVAL_IF(1, MAPI_E_NOT_FOUND, NULL);
+	}
 
 	*SRowSet = ctx->recipients;
+	ocpf_context_release(ctx);
 
 	return MAPI_E_SUCCESS;
 }
@@ -40,15 +40,19 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_set_type(uint32_t context_id,
 					      const char *type)
 {
 	struct ocpf_context	*ctx;
+	int			ret;
 
 	/* Sanity checks */
 	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
 
 	/* Step 1. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
 
-	return ocpf_type_add(ctx, type);
+	ret = ocpf_type_add(ctx, type);
+	ocpf_context_release(ctx);
+
+	return ret;
 }
 
 /**
@@ -81,7 +85,7 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_set_SPropValue(TALLOC_CTX *mem_ctx,
 	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
 
 	/* Step 1. Search for the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
 
 	/* Step 2. Allocate SPropValue */
@@ -108,43 +112,20 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_set_SPropValue(TALLOC_CTX *mem_ctx,
 		ctx->lpProps = add_SPropValue(ctx, ctx->lpProps, &ctx->cValues,
 					      PidTagMessageClass, (const void *)ctx->type);
 	}
-	
+	ocpf_context_release(ctx);
+
 	return MAPI_E_SUCCESS;	
 }
 
 
-/**
-   \details Add a SPropValue structure to the context
-
-   This functions adds a SPropValue to the ocpf context. This property
-   must be part of the known property namespace. If the property
-   already exists in the list, it is automatically replaced with the
-   new one.
-
-   \param context_id identifier of the ocpf context
-   \param lpProps pointer to the SPropValue structure to add to the context
-
-   \return MAPI_E_SUCCESS on success, otheriwse MAPI/OCPF error
-
-   \sa ocpf_server_add_named_SPropValue
- */
-_PUBLIC_ enum MAPISTATUS ocpf_server_add_SPropValue(uint32_t context_id, 
-						    struct SPropValue *lpProps)
+static enum MAPISTATUS ocpf_context_add_SPropValue(struct ocpf_context *ctx,
+						  struct SPropValue *lpProps)
 {
 	int			ret;
-	struct ocpf_context	*ctx;
 	struct ocpf_property	*pel;
 	struct ocpf_property	*element;
 	bool			found = false;
 
-	/* Sanity checks */
-	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
-	MAPI_RETVAL_IF(!lpProps, MAPI_E_INVALID_PARAMETER, NULL);
-
-	/* Step 1. Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
-
 	if (ctx->props && ctx->props->next) {
 		for (pel = ctx->props; pel->next; pel = pel->next) {
 			if (pel->aulPropTag == lpProps->ulPropTag) {
@@ -181,6 +162,42 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_add_SPropValue(uint32_t context_id,
 }
 
 
+/**
+   \details Add a SPropValue structure to the context
+
+   This functions adds a SPropValue to the ocpf context. This property
+   must be part of the known property namespace. If the property
+   already exists in the list, it is automatically replaced with the
+   new one.
+
+   \param context_id identifier of the ocpf context
+   \param lpProps pointer to the SPropValue structure to add to the context
+
+   \return MAPI_E_SUCCESS on success, otheriwse MAPI/OCPF error
+
+   \sa ocpf_server_add_named_SPropValue
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_server_add_SPropValue(uint32_t context_id, 
+						    struct SPropValue *lpProps)
+{
+	enum MAPISTATUS		retval;
+	struct ocpf_context	*ctx;
+
+	/* Sanity checks */
+	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
+	MAPI_RETVAL_IF(!lpProps, MAPI_E_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search the context */
+	ctx = ocpf_context_lookup(context_id);
+	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
+
+	retval = ocpf_context_add_SPropValue(ctx, lpProps);
+	ocpf_context_release(ctx);
+
+	return retval;
+}
+
+
 /**
    \details Synchronize data on filesystem
 
@@ -196,7 +213,7 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_sync(uint32_t context_id)
 	MAPI_RETVAL_IF(!ocpf, MAPI_E_NOT_INITIALIZED, NULL);
 
 	/* Step 1. Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);	
 
 	if (ctx->flags == OCPF_FLAGS_CREATE) {
@@ -218,6 +235,7 @@ _PUBLIC_ enum MAPISTATUS ocpf_server_sync(uint32_t context_id)
 		ctx->fp = fopen(ctx->filename, "w");
 		break;
 	}
+	ocpf_context_release(ctx);
 
 	return MAPI_E_SUCCESS;
 }
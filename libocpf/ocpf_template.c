@@ -0,0 +1,512 @@
+/*
+   OpenChange OCPF (OpenChange Property File) implementation.
+
+   Copyright (C) agent 2026.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   \file ocpf_template.c
+
+   \brief OCPF template API
+
+   A template is an OCPF file parsed once and kept in memory. Property
+   arrays are then built from the template as many times as needed,
+   optionally replacing the values of the variables declared in the
+   file, without running the parser again.
+
+   Templates are not registered in the global context list and do not
+   require ocpf_init. Each template is a separate talloc hierarchy which
+   is never modified once parsed, so it can be shared by several
+   threads as long as each thread instantiates it with its own memory
+   context.
+ */
+
+#include <sys/stat.h>
+
+#include "libocpf/ocpf.h"
+#include "libocpf/ocpf_api.h"
+
+static struct ocpf_template	*ocpf_templates = NULL;
+
+/* Protects the template cache and the template reference counters */
+OCPF_MUTEX(ocpf_template_mutex);
+
+
+/**
+   \details Add a named property of a template to a named properties
+   list
+
+   \param nameid pointer to the named properties list
+   \param nel pointer to the named property to add
+
+   \return true if an entry was added to the list, otherwise false
+ */
+static bool ocpf_template_nameid_add(struct mapi_nameid *nameid,
+				     struct ocpf_nproperty *nel)
+{
+	uint16_t	count;
+
+	count = nameid->count;
+	if (nel->OOM) {
+		mapi_nameid_OOM_add(nameid, nel->OOM, nel->oleguid);
+	} else if (nel->mnid_id) {
+		mapi_nameid_custom_lid_add(nameid, nel->mnid_id, nel->propType, nel->oleguid);
+	} else if (nel->mnid_string) {
+		mapi_nameid_custom_string_add(nameid, nel->mnid_string, nel->propType, nel->oleguid);
+	}
+
+	return (nameid->count != count);
+}
+
+
+/**
+   \details Parse an OCPF file into a new template
+
+   \param filename the OCPF file to parse
+   \param _tmpl pointer on pointer to the template to return
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+ */
+static int ocpf_template_parse(const char *filename, struct ocpf_template **_tmpl)
+{
+	struct ocpf_template	*tmpl;
+	struct ocpf_context	*ctx;
+	struct ocpf_nproperty	*nel;
+	struct mapi_nameid	*nameid;
+	struct stat		sb;
+	uint32_t		i;
+	int			ret;
+
+	OCPF_RETVAL_IF(!filename || stat(filename, &sb) == -1, NULL, OCPF_WARN_FILENAME_INVALID, NULL);
+
+	tmpl = talloc_zero(NULL, struct ocpf_template);
+	OCPF_RETVAL_IF(!tmpl, NULL, OCPF_INVALID_TEMPLATE, NULL);
+
+	ctx = ocpf_context_init(tmpl, filename, OCPF_FLAGS_READ, 0);
+	OCPF_RETVAL_IF(!ctx, NULL, OCPF_WARN_FILENAME_INVALID, tmpl);
+
+	ret = ocpf_context_parse(ctx);
+	fclose(ctx->fp);
+	ctx->fp = NULL;
+	OCPF_RETVAL_IF(ret || ctx->error_flag, ctx, OCPF_WARN_PARSE, tmpl);
+
+	tmpl->ctx = ctx;
+	tmpl->filename = ctx->filename;
+	tmpl->mtime = sb.st_mtime;
+	for (nel = ctx->nprops; nel->next; nel = nel->next) {
+		tmpl->nprops++;
+	}
+
+	/* Record which named properties get an entry in the named
+	 * properties list, so instantiate can walk the mapping with
+	 * its own index */
+	if (tmpl->nprops) {
+		tmpl->nameid_mapped = talloc_array(tmpl, bool, tmpl->nprops);
+		nameid = mapi_nameid_new(tmpl);
+		OCPF_RETVAL_IF(!tmpl->nameid_mapped || !nameid, ctx, OCPF_INVALID_TEMPLATE, tmpl);
+		for (nel = ctx->nprops, i = 0; nel->next; nel = nel->next, i++) {
+			tmpl->nameid_mapped[i] = ocpf_template_nameid_add(nameid, nel);
+		}
+		talloc_free(nameid);
+	}
+
+	*_tmpl = tmpl;
+
+	return OCPF_SUCCESS;
+}
+
+
+/**
+   \details Load an OCPF template
+
+   The file is parsed on each call and the template is not cached.
+
+   \param filename the OCPF file to load
+   \param tmpl pointer on pointer to the template to return
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+
+   \sa ocpf_template_cache_get, ocpf_template_release
+ */
+_PUBLIC_ int ocpf_template_load(const char *filename, struct ocpf_template **tmpl)
+{
+	int	ret;
+
+	OCPF_RETVAL_IF(!tmpl, NULL, OCPF_INVALID_TEMPLATE, NULL);
+
+	ret = ocpf_template_parse(filename, tmpl);
+	if (ret) return ret;
+
+	(*tmpl)->ref_count = 1;
+
+	return OCPF_SUCCESS;
+}
+
+
+/**
+   \details Release a template from the cache
+
+   The template is freed when it is no longer referenced, otherwise
+   the last call to ocpf_template_release frees it.
+
+   \param tmpl pointer to the template to remove from the cache
+
+   \note The template mutex must be held
+ */
+static void ocpf_template_uncache(struct ocpf_template *tmpl)
+{
+	DLIST_REMOVE(ocpf_templates, tmpl);
+	tmpl->cached = false;
+	if (!tmpl->ref_count) {
+		talloc_free(tmpl);
+	}
+}
+
+
+/**
+   \details Retrieve an OCPF template from the cache
+
+   The file is only parsed the first time it is requested, or when its
+   modification time changed since it was parsed. Each successful call
+   must be balanced with a call to ocpf_template_release.
+
+   \param filename the OCPF file to load
+   \param tmpl pointer on pointer to the template to return
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+
+   \sa ocpf_template_release, ocpf_template_cache_flush
+ */
+_PUBLIC_ int ocpf_template_cache_get(const char *filename, struct ocpf_template **tmpl)
+{
+	struct ocpf_template	*el;
+	struct ocpf_template	*parsed;
+	struct stat		sb;
+	int			ret;
+
+	OCPF_RETVAL_IF(!tmpl, NULL, OCPF_INVALID_TEMPLATE, NULL);
+	OCPF_RETVAL_IF(!filename || stat(filename, &sb) == -1, NULL, OCPF_WARN_FILENAME_INVALID, NULL);
+
+	/* Step 1. Search for an up to date template */
+	OCPF_LOCK(ocpf_template_mutex);
+	for (el = ocpf_templates; el; el = el->next) {
+		if (!strcmp(el->filename, filename)) break;
+	}
+	if (el && el->mtime == sb.st_mtime) {
+		el->ref_count++;
+		*tmpl = el;
+		OCPF_UNLOCK(ocpf_template_mutex);
+		return OCPF_SUCCESS;
+	}
+	OCPF_UNLOCK(ocpf_template_mutex);
+
+	/* Step 2. Parse the file without holding the lock */
+	ret = ocpf_template_parse(filename, &parsed);
+	if (ret) return ret;
+
+	/* Step 3. Replace the stale entry unless another thread already did */
+	OCPF_LOCK(ocpf_template_mutex);
+	for (el = ocpf_templates; el; el = el->next) {
+		if (!strcmp(el->filename, filename)) break;
+	}
+	if (el && el->mtime == parsed->mtime) {
+		talloc_free(parsed);
+	} else {
+		if (el) {
+			ocpf_template_uncache(el);
+		}
+		parsed->cached = true;
+		DLIST_ADD(ocpf_templates, parsed);
+		el = parsed;
+	}
+	el->ref_count++;
+	*tmpl = el;
+	OCPF_UNLOCK(ocpf_template_mutex);
+
+	return OCPF_SUCCESS;
+}
+
+
+/**
+   \details Release an OCPF template
+
+   \param tmpl pointer to the template returned by ocpf_template_load
+   or ocpf_template_cache_get
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+ */
+_PUBLIC_ int ocpf_template_release(struct ocpf_template *tmpl)
+{
+	OCPF_RETVAL_IF(!tmpl, NULL, OCPF_INVALID_TEMPLATE, NULL);
+
+	OCPF_LOCK(ocpf_template_mutex);
+	if (!tmpl->ref_count) {
+		OCPF_UNLOCK(ocpf_template_mutex);
+		OCPF_RETVAL_IF(1, NULL, OCPF_INVALID_TEMPLATE, NULL);
+	}
+	tmpl->ref_count--;
+	if (!tmpl->ref_count && tmpl->cached == false) {
+		talloc_free(tmpl);
+	}
+	OCPF_UNLOCK(ocpf_template_mutex);
+
+	return OCPF_SUCCESS;
+}
+
+
+/**
+   \details Remove all templates from the cache
+
+   Templates still referenced remain valid until they are released.
+ */
+_PUBLIC_ void ocpf_template_cache_flush(void)
+{
+	OCPF_LOCK(ocpf_template_mutex);
+	while (ocpf_templates) {
+		ocpf_template_uncache(ocpf_templates);
+	}
+	OCPF_UNLOCK(ocpf_template_mutex);
+}
+
+
+/**
+   \details Build the list of named properties used by a template
+
+   Entries are added in the order expected by
+   ocpf_template_instantiate.
+
+   \param mem_ctx the memory context to use for memory allocation
+   \param tmpl pointer to the template
+   \param nameid pointer on pointer to the named properties list to
+   return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if the template
+   does not have named properties, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_template_get_nameid(TALLOC_CTX *mem_ctx,
+						  struct ocpf_template *tmpl,
+						  struct mapi_nameid **nameid)
+{
+	struct ocpf_nproperty	*nel;
+
+	/* Sanity checks */
+	MAPI_RETVAL_IF(!tmpl || !tmpl->ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!nameid, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!tmpl->nprops, MAPI_E_NOT_FOUND, NULL);
+
+	*nameid = mapi_nameid_new(mem_ctx);
+	MAPI_RETVAL_IF(!*nameid, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	for (nel = tmpl->ctx->nprops; nel->next; nel = nel->next) {
+		ocpf_template_nameid_add(*nameid, nel);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Map the named properties of a template
+
+   The mapping only depends on the store, callers creating many
+   messages in the same store should map named properties once and
+   reuse the result for each ocpf_template_instantiate call.
+
+   \param mem_ctx the memory context to use for memory allocation
+   \param tmpl pointer to the template
+   \param obj_folder pointer to a folder of the store where messages
+   will be created
+   \param SPropTagArray pointer on pointer to the property tags array
+   to return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if the template
+   does not have named properties, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_template_map_names(TALLOC_CTX *mem_ctx,
+						 struct ocpf_template *tmpl,
+						 mapi_object_t *obj_folder,
+						 struct SPropTagArray **SPropTagArray)
+{
+	enum MAPISTATUS		retval;
+	struct mapi_nameid	*nameid;
+
+	/* Sanity checks */
+	MAPI_RETVAL_IF(!obj_folder, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!SPropTagArray, MAPI_E_INVALID_PARAMETER, NULL);
+
+	retval = ocpf_template_get_nameid(mem_ctx, tmpl, &nameid);
+	MAPI_RETVAL_IF(retval, retval, NULL);
+
+	*SPropTagArray = talloc_zero(mem_ctx, struct SPropTagArray);
+	retval = GetIDsFromNames(obj_folder, nameid->count, nameid->nameid, 0, SPropTagArray);
+	if (retval != MAPI_E_SUCCESS) {
+		MAPIFreeBuffer(*SPropTagArray);
+		MAPIFreeBuffer(nameid);
+		return retval;
+	}
+	mapi_nameid_SPropTagArray(nameid, *SPropTagArray);
+	MAPIFreeBuffer(nameid);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Return the value of a template property, replaced with
+   the bound value when it comes from a variable
+
+   \param var name of the variable the value comes from, or NULL
+   \param value the value stored in the template
+   \param bindings array of values bound to variables
+   \param count number of entries in bindings
+
+   \return pointer to the value to use
+ */
+static const void *ocpf_template_value(const char *var, const void *value,
+				       const struct ocpf_binding *bindings,
+				       uint32_t count)
+{
+	uint32_t	i;
+
+	if (!var) return value;
+
+	for (i = 0; i < count; i++) {
+		if (bindings[i].name && !strcmp(bindings[i].name, var)) {
+			return bindings[i].value;
+		}
+	}
+
+	return value;
+}
+
+
+/**
+   \details Build a SPropValue array from a template
+
+   Properties are added in the same order as ocpf_set_SPropValue:
+   named properties, known properties and the message class. Values
+   are not duplicated, the array references the template and the
+   bindings and must not outlive them. Binary values are not streamed,
+   callers must write large binary properties with OpenStream.
+
+   \param mem_ctx the memory context to use for memory allocation
+   \param tmpl pointer to the template
+   \param named the named properties mapping returned by
+   ocpf_template_map_names, or NULL to skip named properties
+   \param bindings array of values replacing the template variables,
+   or NULL
+   \param count number of entries in bindings
+   \param lpProps pointer on pointer to the property array to return
+   \param cValues pointer to the number of properties to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_template_instantiate(TALLOC_CTX *mem_ctx,
+						   struct ocpf_template *tmpl,
+						   struct SPropTagArray *named,
+						   const struct ocpf_binding *bindings,
+						   uint32_t count,
+						   struct SPropValue **lpProps,
+						   uint32_t *cValues)
+{
+	struct ocpf_context	*ctx;
+	struct ocpf_property	*pel;
+	struct ocpf_nproperty	*nel;
+	struct SPropValue	*props;
+	const void		*value;
+	uint32_t		aulPropTag;
+	uint32_t		size;
+	uint32_t		n = 0;
+	uint32_t		i;
+	uint32_t		j;
+
+	/* Sanity checks */
+	MAPI_RETVAL_IF(!tmpl || !tmpl->ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!lpProps || !cValues, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(count && !bindings, MAPI_E_INVALID_PARAMETER, NULL);
+
+	ctx = tmpl->ctx;
+
+	/* Step 1. Allocate the array once */
+	size = tmpl->nprops + 1;
+	for (pel = ctx->props; pel->next; pel = pel->next) {
+		size++;
+	}
+	props = talloc_array(mem_ctx, struct SPropValue, size);
+	MAPI_RETVAL_IF(!props, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	/* Step 2. Add named properties */
+	if (named) {
+		/* named only has entries for the properties added by
+		 * ocpf_template_get_nameid: i walks the template, j
+		 * walks the mapping */
+		for (nel = ctx->nprops, i = 0, j = 0; nel->next && j < named->cValues; nel = nel->next, i++) {
+			if (!tmpl->nameid_mapped[i]) continue;
+			aulPropTag = named->aulPropTag[j++];
+			if (!aulPropTag || ((aulPropTag & 0xFFFF) == PT_ERROR)) continue;
+			value = ocpf_template_value(nel->var, nel->value, bindings, count);
+			if (set_SPropValue_proptag(&props[n], aulPropTag, value) == true) {
+				n++;
+			}
+		}
+	}
+
+	/* Step 3. Add known properties */
+	for (pel = ctx->props; pel->next; pel = pel->next) {
+		aulPropTag = pel->aulPropTag;
+		if ((aulPropTag & 0xFFFF) == PT_STRING8) {
+			aulPropTag = (aulPropTag & 0xFFFF0000) | PT_UNICODE;
+		}
+		value = ocpf_template_value(pel->var, pel->value, bindings, count);
+		if (set_SPropValue_proptag(&props[n], aulPropTag, value) == true) {
+			n++;
+		}
+	}
+
+	/* Step 4. Add message class */
+	if (ctx->type) {
+		set_SPropValue_proptag(&props[n], PidTagMessageClass, (const void *)ctx->type);
+		n++;
+	}
+
+	*lpProps = props;
+	*cValues = n;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Get the recipients of a template
+
+   \param tmpl pointer to the template
+   \param SRowSet pointer on pointer to the set of recipients to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS ocpf_template_get_recipients(struct ocpf_template *tmpl,
+						      struct SRowSet **SRowSet)
+{
+	/* Sanity checks */
+	MAPI_RETVAL_IF(!tmpl || !tmpl->ctx, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!SRowSet, MAPI_E_INVALID_PARAMETER, NULL);
+	MAPI_RETVAL_IF(!tmpl->ctx->recipients->cRows, MAPI_E_NOT_FOUND, NULL);
+
+	*SRowSet = tmpl->ctx->recipients;
+
+	return MAPI_E_SUCCESS;
+}
@@ -504,40 +504,22 @@ _PUBLIC_ int ocpf_write_init(uint32_t context_id,
 	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
 
 	/* Search the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
+	ctx = ocpf_context_lookup(context_id);
 	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);	
 
 	ctx->folder = folder_id;
+	ocpf_context_release(ctx);
 
 	return OCPF_SUCCESS;
 }
 
 
-/**
-   \details Create the OCPF structure required for the commit
-   operation
-
-   This function process properties and named properties from the
-   specified mapi_SPropValue_array and generates an OCPF structure
-   with all the attributes required to create an OCPF file in the
-   commit operation.
-
-   \param context_id the identifier representing the context
-   \param obj_message the message object
-   \param mapi_lpProps the array of mapi properties returned by
-   GetPropsAll
-
-   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
-
-   \sa GetPropsAll, ocpf_write_commit
- */
-_PUBLIC_ int ocpf_write_auto(uint32_t context_id,
-			     mapi_object_t *obj_message,
-			     struct mapi_SPropValue_array *mapi_lpProps)
+static int ocpf_context_write_auto(struct ocpf_context *ctx,
+				   mapi_object_t *obj_message,
+				   struct mapi_SPropValue_array *mapi_lpProps)
 {
 	enum MAPISTATUS		retval;
 	int			ret;
-	struct ocpf_context	*ctx;
 	uint32_t		i;
 	uint16_t		propID;
 	struct SPropValue	lpProps;
@@ -549,12 +531,6 @@ _PUBLIC_ int ocpf_write_auto(uint32_t context_id,
 	uint16_t		count;
 	struct ocpf_nprop	nprop;
 
-	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
-	OCPF_RETVAL_IF(!mapi_lpProps, NULL, OCPF_INVALID_PROPARRAY, NULL);
-	
-	/* Find the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
 	OCPF_RETVAL_IF(!ctx->filename, ctx, OCPF_WRITE_NOT_INITIALIZED, NULL);
 
 	/* store message type */
@@ -620,21 +596,47 @@ _PUBLIC_ int ocpf_write_auto(uint32_t context_id,
 
 
 /**
-   \details Write OCPF structure to OCPF file
+   \details Create the OCPF structure required for the commit
+   operation
 
-   This function dumps the OCPF structure content into the OCPF file
-   defined in ocpf_write_init.
+   This function process properties and named properties from the
+   specified mapi_SPropValue_array and generates an OCPF structure
+   with all the attributes required to create an OCPF file in the
+   commit operation.
 
    \param context_id the identifier representing the context
+   \param obj_message the message object
+   \param mapi_lpProps the array of mapi properties returned by
+   GetPropsAll
 
    \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
 
-   \sa ocpf_write_init, ocpf_write_auto
+   \sa GetPropsAll, ocpf_write_commit
  */
-_PUBLIC_ int ocpf_write_commit(uint32_t context_id)
+_PUBLIC_ int ocpf_write_auto(uint32_t context_id,
+			     mapi_object_t *obj_message,
+			     struct mapi_SPropValue_array *mapi_lpProps)
 {
-	FILE			*fp;
+	int			ret;
 	struct ocpf_context	*ctx;
+
+	OCPF_RETVAL_IF(!ocpf || !ocpf->mem_ctx, NULL, OCPF_NOT_INITIALIZED, NULL);
+	OCPF_RETVAL_IF(!mapi_lpProps, NULL, OCPF_INVALID_PROPARRAY, NULL);
+	
+	/* Find the context */
+	ctx = ocpf_context_lookup(context_id);
+	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
+
+	ret = ocpf_context_write_auto(ctx, obj_message, mapi_lpProps);
+	ocpf_context_release(ctx);
+
+	return ret;
+}
+
+
+static int ocpf_context_write_commit(struct ocpf_context *ctx)
+{
+	FILE			*fp;
 	struct ocpf_property	*element;
 	struct ocpf_nproperty	*nelement;
 	struct ocpf_oleguid	*nguid;
@@ -642,9 +644,6 @@ _PUBLIC_ int ocpf_write_commit(uint32_t context_id)
 	bool			found = false;
 	char			*definition = NULL;
 
-	/* Find the context */
-	ctx = ocpf_context_search_by_context_id(ocpf->context, context_id);
-	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
 	OCPF_RETVAL_IF(!ctx->filename, ctx, OCPF_WRITE_NOT_INITIALIZED, NULL);
 	OCPF_RETVAL_IF(ctx->flags == OCPF_FLAGS_READ, ctx, OCPF_WRITE_NOT_INITIALIZED, NULL);
 
@@ -736,3 +735,31 @@ _PUBLIC_ int ocpf_write_commit(uint32_t context_id)
 
 	return OCPF_SUCCESS;
 }
+
+
+/**
+   \details Write OCPF structure to OCPF file
+
+   This function dumps the OCPF structure content into the OCPF file
+   defined in ocpf_write_init.
+
+   \param context_id the identifier representing the context
+
+   \return OCPF_SUCCESS on success, otherwise OCPF_ERROR
+
+   \sa ocpf_write_init, ocpf_write_auto
+ */
+_PUBLIC_ int ocpf_write_commit(uint32_t context_id)
+{
+	int			ret;
+	struct ocpf_context	*ctx;
+
+	/* Find the context */
+	ctx = ocpf_context_lookup(context_id);
+	OCPF_RETVAL_IF(!ctx, NULL, OCPF_INVALID_CONTEXT, NULL);
+
+	ret = ocpf_context_write_commit(ctx);
+	ocpf_context_release(ctx);
+
+	return ret;
+}
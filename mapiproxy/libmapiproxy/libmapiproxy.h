@@ -129,12 +129,42 @@ struct mapi_handles_context {
 	struct mapi_handles    	*handles;
 };
 
+/* type is PT_UNSPECIFIED when the property is missing from the row */
+struct openchangedb_table_value {
+	uint16_t			type;
+	union {
+		uint64_t		i;
+		const char		*str;
+		DATA_BLOB		bin;
+	} value;
+};
+
+/* returns false when the property does not exist */
+typedef bool (*openchangedb_restriction_get_value_t)(TALLOC_CTX *, void *, uint32_t, struct openchangedb_table_value *);
+
+struct openchangedb_table_row {
+	struct ldb_message		*msg;
+	uint64_t			fmid;
+	uint32_t			ldb_index;
+	uint32_t			position;
+	uint32_t			view_position;
+	bool				match;
+	struct SSortOrderSet		*sort;
+	struct openchangedb_table_value	*keys;
+};
+
 struct openchangedb_table {
 	uint64_t			folderID;
 	uint8_t				table_type;
 	struct SSortOrderSet		*lpSortCriteria;
 	struct mapi_SRestriction	*restrictions;
 	struct ldb_result		*res;
+	struct openchangedb_table_row	**rows;
+	uint32_t			row_count;
+	struct openchangedb_table_row	**view;
+	uint32_t			view_count;
+	struct openchangedb_table_row	**index;
+	uint64_t			seq_num;
 };
 
 enum openchangedb_message_status {
@@ -255,6 +285,7 @@ enum MAPISTATUS openchangedb_set_ReceiveFolder(struct ldb_context *, const char
 enum MAPISTATUS openchangedb_create_mailbox(struct ldb_context *, const char *, int, uint64_t *);
 enum MAPISTATUS openchangedb_create_folder(struct ldb_context *, uint64_t, uint64_t, uint64_t, const char *, int);
 enum MAPISTATUS openchangedb_delete_folder(struct ldb_context *, uint64_t);
+enum MAPISTATUS openchangedb_empty_folder(TALLOC_CTX *, struct ldb_context *, uint64_t, bool, struct UI8Array_r **, struct StringArrayW_r **);
 enum MAPISTATUS openchangedb_get_fid_from_partial_uri(struct ldb_context *, const char *, uint64_t *);
 enum MAPISTATUS openchangedb_get_users_from_partial_uri(TALLOC_CTX *, struct ldb_context *, const char *, uint32_t *, char ***, char ***);
 void *openchangedb_get_special_property(TALLOC_CTX *, struct ldb_context *, struct ldb_result *, uint32_t, const char *);
@@ -266,6 +297,21 @@ enum MAPISTATUS openchangedb_table_init(TALLOC_CTX *, uint8_t, uint64_t, void **
 enum MAPISTATUS openchangedb_table_set_sort_order(void *, struct SSortOrderSet *);
 enum MAPISTATUS openchangedb_table_set_restrictions(void *, struct mapi_SRestriction *);
 enum MAPISTATUS openchangedb_table_get_property(TALLOC_CTX *, void *, struct ldb_context *, enum MAPITAGS, uint32_t, bool live_filtered, void **);
+enum MAPISTATUS openchangedb_table_get_row_count(void *, struct ldb_context *, uint32_t *);
+enum MAPISTATUS openchangedb_table_get_row_position(void *, struct ldb_context *, uint64_t, bool, uint32_t *);
+enum MAPISTATUS openchangedb_table_find_row(void *, struct ldb_context *, struct mapi_SRestriction *, enum FindRow_ulFlags, uint32_t, uint32_t *);
+bool openchangedb_restriction_match(TALLOC_CTX *, struct mapi_SRestriction *, openchangedb_restriction_get_value_t, void *);
+int openchangedb_table_compare_keys(struct openchangedb_table_value *, struct openchangedb_table_value *);
+
+/* definitions from openchangedb_search.c */
+enum MAPISTATUS openchangedb_set_search_criteria(struct ldb_context *, uint64_t, struct mapi_SRestriction *, uint16_t, uint64_t *, uint32_t, uint32_t);
+enum MAPISTATUS openchangedb_get_search_criteria(TALLOC_CTX *, struct ldb_context *, uint64_t, struct mapi_SRestriction **, uint16_t *, uint64_t **, uint32_t *, uint32_t *);
+enum MAPISTATUS openchangedb_set_search_state(struct ldb_context *, uint64_t, uint32_t);
+enum MAPISTATUS openchangedb_get_search_folders(TALLOC_CTX *, struct ldb_context *, const char *, uint32_t *, uint64_t **);
+enum MAPISTATUS openchangedb_search_add_match(struct ldb_context *, uint64_t, uint64_t, uint64_t);
+enum MAPISTATUS openchangedb_search_del_match(struct ldb_context *, uint64_t, uint64_t, uint64_t);
+enum MAPISTATUS openchangedb_search_clear_matches(struct ldb_context *, uint64_t);
+enum MAPISTATUS openchangedb_get_search_matches(TALLOC_CTX *, struct ldb_context *, uint64_t, uint32_t *, uint64_t **, uint64_t **);
 
 /* definitions from openchangedb_message.c */
 enum MAPISTATUS openchangedb_message_open(TALLOC_CTX *, struct ldb_context *, uint64_t, uint64_t, void **, void **);
@@ -273,6 +319,8 @@ enum MAPISTATUS openchangedb_message_create(TALLOC_CTX *, struct ldb_context *,
 enum MAPISTATUS openchangedb_message_save(void *, uint8_t);
 enum MAPISTATUS openchangedb_message_get_property(TALLOC_CTX *, void *, uint32_t, void **);
 enum MAPISTATUS openchangedb_message_set_properties(TALLOC_CTX *, void *, struct SRow *);
+enum MAPISTATUS openchangedb_message_get_available_properties(TALLOC_CTX *, void *, struct SPropTagArray **);
+enum MAPISTATUS openchangedb_delete_messages(struct ldb_context *, uint64_t, uint32_t, const uint64_t *);
 
 /* definitions from auto-generated openchangedb_property.c */
 const char *openchangedb_property_get_attribute(uint32_t);
@@ -1674,6 +1674,13 @@ _PUBLIC_ enum MAPISTATUS openchangedb_delete_folder(struct ldb_context *ldb_ctx,
 		goto end;
 	}
 
+	/* Remove the match records of search folders first */
+	ret = openchangedb_search_clear_matches(ldb_ctx, fid);
+	if (ret != MAPI_E_SUCCESS) {
+		ret = MAPI_E_CORRUPT_STORE;
+		goto end;
+	}
+
 	dn = ldb_dn_new(mem_ctx, ldb_ctx, dnstr);
 	retval = ldb_delete(ldb_ctx, dn);
 	if (retval == LDB_SUCCESS) {
@@ -1689,6 +1696,131 @@ end:
 	return ret;
 }
 
+/**
+   \details Compare two ldb messages by decreasing DN depth, so that
+   children are deleted before their parent
+ */
+static int openchangedb_empty_folder_cmp(const void *a, const void *b)
+{
+	const struct ldb_message	*msg_a = *(struct ldb_message * const *) a;
+	const struct ldb_message	*msg_b = *(struct ldb_message * const *) b;
+
+	return ldb_dn_get_comp_num(msg_b->dn) - ldb_dn_get_comp_num(msg_a->dn);
+}
+
+/**
+   \details Remove the messages and subfolders of a folder, recursively
+
+   All the records below the folder are deleted within a single ldb
+   transaction: either the folder is emptied or it is left untouched.
+   Subfolders which are mapistore roots only have their openchangedb
+   record removed; their fid and mapistore URI are returned so the
+   caller can purge the backend content.
+
+   \param mem_ctx pointer to the memory context
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the identifier of the folder to empty
+   \param delete_associated whether the FAI messages of the folder
+   must be deleted too
+   \param root_fidsp pointer on pointer to the fids of the removed
+   mapistore roots
+   \param root_urisp pointer on pointer to the mapistore URIs of the
+   removed mapistore roots
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_empty_folder(TALLOC_CTX *mem_ctx, struct ldb_context *ldb_ctx, uint64_t fid,
+						   bool delete_associated, struct UI8Array_r **root_fidsp,
+						   struct StringArrayW_r **root_urisp)
+{
+	TALLOC_CTX		*local_mem_ctx;
+	struct ldb_result	*res = NULL;
+	struct ldb_dn		*dn;
+	const char * const	attrs[] = { "objectClass", "PidTagFolderId", "MAPIStoreURI", NULL };
+	const char		*objectClass;
+	const char		*uri;
+	char			*dnstr;
+	struct UI8Array_r	*root_fids;
+	struct StringArrayW_r	*root_uris;
+	enum MAPISTATUS		retval;
+	int			comp_num;
+	int			ret;
+	unsigned int		i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!root_fidsp || !root_urisp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	local_mem_ctx = talloc_named(NULL, 0, "openchangedb_empty_folder");
+
+	retval = openchangedb_get_distinguishedName(local_mem_ctx, ldb_ctx, fid, &dnstr);
+	OPENCHANGE_RETVAL_IF(retval, retval, local_mem_ctx);
+	dn = ldb_dn_new(local_mem_ctx, ldb_ctx, dnstr);
+	OPENCHANGE_RETVAL_IF(!ldb_dn_validate(dn), MAPI_E_CORRUPT_STORE, local_mem_ctx);
+	comp_num = ldb_dn_get_comp_num(dn);
+
+	ret = ldb_search(ldb_ctx, local_mem_ctx, &res, dn, LDB_SCOPE_SUBTREE, attrs, "(objectClass=*)");
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_NOT_FOUND, local_mem_ctx);
+
+	root_fids = talloc_zero(mem_ctx, struct UI8Array_r);
+	root_fids->lpui8 = talloc_array(root_fids, uint64_t, res->count);
+	root_uris = talloc_zero(mem_ctx, struct StringArrayW_r);
+	root_uris->lppszW = talloc_array(root_uris, const char *, res->count);
+
+	qsort(res->msgs, res->count, sizeof (struct ldb_message *), openchangedb_empty_folder_cmp);
+
+	ret = ldb_transaction_start(ldb_ctx);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(root_fids);
+		talloc_free(root_uris);
+		talloc_free(local_mem_ctx);
+		return MAPI_E_CALL_FAILED;
+	}
+
+	for (i = 0; i < res->count; i++) {
+		/* Keep the folder itself and, unless requested, its own FAI messages */
+		if (ldb_dn_get_comp_num(res->msgs[i]->dn) <= comp_num) continue;
+		objectClass = ldb_msg_find_attr_as_string(res->msgs[i], "objectClass", NULL);
+		if (!delete_associated && objectClass && !strcmp(objectClass, "faiMessage")
+		    && ldb_dn_get_comp_num(res->msgs[i]->dn) == comp_num + 1) {
+			continue;
+		}
+
+		ret = ldb_delete(ldb_ctx, res->msgs[i]->dn);
+		if (ret != LDB_SUCCESS) {
+			DEBUG(3, ("[%s:%d]: unable to delete %s: %s\n", __FUNCTION__, __LINE__,
+				  ldb_dn_get_linearized(res->msgs[i]->dn), ldb_errstring(ldb_ctx)));
+			ldb_transaction_cancel(ldb_ctx);
+			talloc_free(root_fids);
+			talloc_free(root_uris);
+			talloc_free(local_mem_ctx);
+			return MAPI_E_CORRUPT_STORE;
+		}
+
+		uri = ldb_msg_find_attr_as_string(res->msgs[i], "MAPIStoreURI", NULL);
+		if (uri) {
+			root_fids->lpui8[root_fids->cValues] = ldb_msg_find_attr_as_uint64(res->msgs[i], "PidTagFolderId", 0);
+			root_fids->cValues++;
+			root_uris->lppszW[root_uris->cValues] = talloc_strdup(root_uris, uri);
+			root_uris->cValues++;
+		}
+	}
+
+	ret = ldb_transaction_commit(ldb_ctx);
+	if (ret != LDB_SUCCESS) {
+		talloc_free(root_fids);
+		talloc_free(root_uris);
+		talloc_free(local_mem_ctx);
+		return MAPI_E_CALL_FAILED;
+	}
+
+	*root_fidsp = root_fids;
+	*root_urisp = root_uris;
+	talloc_free(local_mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
 /**
    \details Set the receive folder for a specific message class.
 
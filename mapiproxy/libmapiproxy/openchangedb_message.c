@@ -386,3 +386,130 @@ _PUBLIC_ enum MAPISTATUS openchangedb_message_set_properties(TALLOC_CTX *mem_ctx
 	DEBUG(5, ("openchangedb_message_set_properties end\n"));
 	return MAPI_E_SUCCESS;
 }
+
+/**
+   \details Retrieve the list of properties stored on a message
+
+   \param mem_ctx pointer to the memory context
+   \param message_object pointer to the openchangedb message object
+   \param propertiesp pointer on pointer to the property tag array to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_message_get_available_properties(TALLOC_CTX *mem_ctx,
+								       void *message_object,
+								       struct SPropTagArray **propertiesp)
+{
+	struct openchangedb_message	*msg = (struct openchangedb_message *) message_object;
+	struct ldb_message		*message;
+	struct SPropTagArray		*properties;
+	const char			*name;
+	uint32_t			proptag;
+	unsigned int			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!msg, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!propertiesp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	/* Get results from correct location */
+	switch (msg->status) {
+	case OPENCHANGEDB_MESSAGE_CREATE:
+		OPENCHANGE_RETVAL_IF(!msg->msg, MAPI_E_NOT_INITIALIZED, NULL);
+		message = msg->msg;
+		break;
+	case OPENCHANGEDB_MESSAGE_OPEN:
+		OPENCHANGE_RETVAL_IF(!msg->res, MAPI_E_NOT_INITIALIZED, NULL);
+		OPENCHANGE_RETVAL_IF(!msg->res->count, MAPI_E_NOT_INITIALIZED, NULL);
+		message = msg->res->msgs[0];
+		break;
+	}
+
+	properties = talloc_zero(mem_ctx, struct SPropTagArray);
+	OPENCHANGE_RETVAL_IF(!properties, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	properties->aulPropTag = talloc_array(properties, enum MAPITAGS, message->num_elements);
+	OPENCHANGE_RETVAL_IF(!properties->aulPropTag, MAPI_E_NOT_ENOUGH_MEMORY, properties);
+
+	/* Properties are stored either under their PidTag name or
+	 * under their hexadecimal tag, other attributes are
+	 * openchangedb internals */
+	for (i = 0; i < message->num_elements; i++) {
+		name = message->elements[i].name;
+		if (!strncmp(name, "PidTag", 6)) {
+			proptag = get_proptag_value(name);
+		} else if (strlen(name) == 8 && strspn(name, "0123456789abcdefABCDEF") == 8) {
+			proptag = strtoul(name, NULL, 16);
+		} else {
+			continue;
+		}
+		if (proptag) {
+			properties->aulPropTag[properties->cValues] = proptag;
+			properties->cValues++;
+		}
+	}
+
+	*propertiesp = properties;
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details Delete a set of messages from a folder
+
+   The messages are removed within a single ldb transaction. Messages
+   which no longer exist are silently skipped.
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param folderID the identifier of the folder holding the messages
+   \param count the number of messages to delete
+   \param mids the identifiers of the messages to delete
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_delete_messages(struct ldb_context *ldb_ctx, uint64_t folderID,
+						      uint32_t count, const uint64_t *mids)
+{
+	TALLOC_CTX		*mem_ctx;
+	enum MAPISTATUS		retval;
+	struct ldb_dn		*dn;
+	char			*parentDN;
+	uint32_t		i;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(count && !mids, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_delete_messages");
+
+	retval = openchangedb_get_distinguishedName(mem_ctx, ldb_ctx, folderID, &parentDN);
+	OPENCHANGE_RETVAL_IF(retval, retval, mem_ctx);
+
+	ret = ldb_transaction_start(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	for (i = 0; i < count; i++) {
+		dn = ldb_dn_new_fmt(mem_ctx, ldb_ctx, "CN=%"PRIu64",%s", mids[i], parentDN);
+		if (!dn) {
+			ldb_transaction_cancel(ldb_ctx);
+			talloc_free(mem_ctx);
+			return MAPI_E_NOT_ENOUGH_MEMORY;
+		}
+		ret = ldb_delete(ldb_ctx, dn);
+		if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_OBJECT) {
+			DEBUG(3, ("[%s:%d]: unable to delete %s: %s\n", __FUNCTION__, __LINE__,
+				  ldb_dn_get_linearized(dn), ldb_errstring(ldb_ctx)));
+			ldb_transaction_cancel(ldb_ctx);
+			talloc_free(mem_ctx);
+			return MAPI_E_CORRUPT_STORE;
+		}
+		talloc_free(dn);
+	}
+
+	ret = ldb_transaction_commit(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	talloc_free(mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
@@ -0,0 +1,583 @@
+/*
+   OpenChange Server implementation
+
+   OpenChangeDB search folder routines
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+   \file openchangedb_search.c
+
+   \brief OpenChange Dispatcher database search folder routines
+
+   A search folder record stores its criteria:
+
+   - SearchRestriction: the NDR encoded restriction, in base64
+   - SearchFolderId: the folders the search applies to (multi-valued)
+   - SearchFlags: the flags given to SetSearchCriteria
+   - SearchState: the search state returned by GetSearchCriteria
+   - PidTagContentCount: the number of matching messages
+
+   Each message matching the criteria has its own record below the
+   search folder, CN=<mid>,<search folder DN>, with the searchMatch
+   object class and the SearchMatchFolderId and SearchMatchMessageId
+   attributes. Adding or removing a match only adds or deletes that
+   record and updates the count of the search folder, whatever the
+   number of matches.
+ */
+
+#include <inttypes.h>
+
+#include "mapiproxy/dcesrv_mapiproxy.h"
+#include "libmapiproxy.h"
+#include "libmapi/libmapi.h"
+#include "libmapi/libmapi_private.h"
+#include "gen_ndr/ndr_exchange.h"
+
+static struct ldb_message *openchangedb_search_get_record(TALLOC_CTX *mem_ctx,
+							  struct ldb_context *ldb_ctx,
+							  uint64_t fid,
+							  const char * const *attrs)
+{
+	struct ldb_result	*res = NULL;
+	int			ret;
+
+	ret = ldb_search(ldb_ctx, mem_ctx, &res, ldb_get_default_basedn(ldb_ctx),
+			 LDB_SCOPE_SUBTREE, attrs, "(PidTagFolderId=%"PRIu64")", fid);
+	if (ret != LDB_SUCCESS || res->count != 1) {
+		return NULL;
+	}
+
+	return res->msgs[0];
+}
+
+
+static int openchangedb_search_delete_matches(TALLOC_CTX *mem_ctx, struct ldb_context *ldb_ctx, struct ldb_dn *dn)
+{
+	struct ldb_result	*res = NULL;
+	const char * const	attrs[] = { "distinguishedName", NULL };
+	unsigned int		i;
+	int			ret;
+
+	ret = ldb_search(ldb_ctx, mem_ctx, &res, dn, LDB_SCOPE_ONELEVEL, attrs, "(objectClass=searchMatch)");
+	if (ret != LDB_SUCCESS) {
+		return ret;
+	}
+
+	for (i = 0; i < res->count; i++) {
+		ret = ldb_delete(ldb_ctx, res->msgs[i]->dn);
+		if (ret != LDB_SUCCESS && ret != LDB_ERR_NO_SUCH_OBJECT) {
+			return ret;
+		}
+	}
+
+	return LDB_SUCCESS;
+}
+
+
+/**
+   \details Remove the match index of a folder
+
+   This is called before the folder record is deleted, so no match
+   record is left without its search folder. Nothing is done for
+   folders which are not search folders.
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the folder identifier
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_search_clear_matches(struct ldb_context *ldb_ctx, uint64_t fid)
+{
+	TALLOC_CTX		*mem_ctx;
+	const char * const	attrs[] = { "distinguishedName", NULL };
+	struct ldb_message	*record;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_search_clear_matches");
+
+	record = openchangedb_search_get_record(mem_ctx, ldb_ctx, fid, attrs);
+	OPENCHANGE_RETVAL_IF(!record, MAPI_E_NOT_FOUND, mem_ctx);
+
+	ret = openchangedb_search_delete_matches(mem_ctx, ldb_ctx, record->dn);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	talloc_free(mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Store the criteria of a search folder
+
+   The match index of the folder is emptied: the caller is expected to
+   populate it again.
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param res pointer to the search restriction
+   \param FolderIdCount the number of folders in the search scope
+   \param FolderIds pointer to the folders in the search scope
+   \param SearchFlags the SetSearchCriteria flags
+   \param SearchState the initial search state
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_set_search_criteria(struct ldb_context *ldb_ctx,
+							  uint64_t fid,
+							  struct mapi_SRestriction *res,
+							  uint16_t FolderIdCount,
+							  uint64_t *FolderIds,
+							  uint32_t SearchFlags,
+							  uint32_t SearchState)
+{
+	TALLOC_CTX		*mem_ctx;
+	const char * const	attrs[] = { "distinguishedName", NULL };
+	struct ldb_message	*record;
+	struct ldb_message	*msg;
+	enum ndr_err_code	ndr_err;
+	DATA_BLOB		blob;
+	char			*b64;
+	uint16_t		i;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!res, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(FolderIdCount && !FolderIds, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_set_search_criteria");
+
+	record = openchangedb_search_get_record(mem_ctx, ldb_ctx, fid, attrs);
+	OPENCHANGE_RETVAL_IF(!record, MAPI_E_NOT_FOUND, mem_ctx);
+
+	ndr_err = ndr_push_struct_blob(&blob, mem_ctx, res, (ndr_push_flags_fn_t)ndr_push_mapi_SRestriction);
+	OPENCHANGE_RETVAL_IF(!NDR_ERR_CODE_IS_SUCCESS(ndr_err), MAPI_E_INVALID_PARAMETER, mem_ctx);
+	b64 = ldb_base64_encode(mem_ctx, (const char *)blob.data, blob.length);
+	OPENCHANGE_RETVAL_IF(!b64, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+
+	msg = ldb_msg_new(mem_ctx);
+	OPENCHANGE_RETVAL_IF(!msg, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+	msg->dn = record->dn;
+
+	ldb_msg_add_string(msg, "SearchRestriction", b64);
+	msg->elements[msg->num_elements - 1].flags = LDB_FLAG_MOD_REPLACE;
+
+	ldb_msg_add_empty(msg, "SearchFolderId", LDB_FLAG_MOD_REPLACE, NULL);
+	for (i = 0; i < FolderIdCount; i++) {
+		ldb_msg_add_fmt(msg, "SearchFolderId", "%"PRIu64, FolderIds[i]);
+	}
+
+	ldb_msg_add_fmt(msg, "SearchFlags", "%u", SearchFlags);
+	msg->elements[msg->num_elements - 1].flags = LDB_FLAG_MOD_REPLACE;
+	ldb_msg_add_fmt(msg, "SearchState", "%u", SearchState);
+	msg->elements[msg->num_elements - 1].flags = LDB_FLAG_MOD_REPLACE;
+
+	ldb_msg_add_string(msg, "PidTagContentCount", "0");
+	msg->elements[msg->num_elements - 1].flags = LDB_FLAG_MOD_REPLACE;
+
+	ret = ldb_transaction_start(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	ret = openchangedb_search_delete_matches(mem_ctx, ldb_ctx, record->dn);
+	if (ret == LDB_SUCCESS) {
+		ret = ldb_modify(ldb_ctx, msg);
+	}
+	if (ret != LDB_SUCCESS) {
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_CALL_FAILED, mem_ctx);
+	}
+
+	ret = ldb_transaction_commit(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	talloc_free(mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the criteria of a search folder
+
+   \param mem_ctx pointer to the memory context
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param resp pointer on pointer to the search restriction to return
+   \param FolderIdCount pointer to the number of folders to return
+   \param FolderIds pointer on pointer to the folders to return
+   \param SearchFlags pointer to the SetSearchCriteria flags to return
+   \param SearchState pointer to the search state to return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_INITIALIZED if the
+   criteria of the folder were never set, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_get_search_criteria(TALLOC_CTX *mem_ctx,
+							  struct ldb_context *ldb_ctx,
+							  uint64_t fid,
+							  struct mapi_SRestriction **resp,
+							  uint16_t *FolderIdCount,
+							  uint64_t **FolderIds,
+							  uint32_t *SearchFlags,
+							  uint32_t *SearchState)
+{
+	TALLOC_CTX			*local_mem_ctx;
+	const char * const		attrs[] = { "SearchRestriction", "SearchFolderId", "SearchFlags", "SearchState", NULL };
+	struct ldb_message		*record;
+	struct ldb_message_element	*el;
+	struct mapi_SRestriction	*res;
+	enum ndr_err_code		ndr_err;
+	DATA_BLOB			blob;
+	const char			*str;
+	char				*b64;
+	uint64_t			*fids;
+	unsigned int			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!resp || !FolderIdCount || !FolderIds, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!SearchFlags || !SearchState, MAPI_E_INVALID_PARAMETER, NULL);
+
+	local_mem_ctx = talloc_named(NULL, 0, "openchangedb_get_search_criteria");
+
+	record = openchangedb_search_get_record(local_mem_ctx, ldb_ctx, fid, attrs);
+	OPENCHANGE_RETVAL_IF(!record, MAPI_E_NOT_FOUND, local_mem_ctx);
+
+	str = ldb_msg_find_attr_as_string(record, "SearchRestriction", NULL);
+	OPENCHANGE_RETVAL_IF(!str, MAPI_E_NOT_INITIALIZED, local_mem_ctx);
+
+	b64 = talloc_strdup(local_mem_ctx, str);
+	blob.length = ldb_base64_decode(b64);
+	blob.data = (uint8_t *) b64;
+
+	res = talloc_zero(mem_ctx, struct mapi_SRestriction);
+	OPENCHANGE_RETVAL_IF(!res, MAPI_E_NOT_ENOUGH_MEMORY, local_mem_ctx);
+	ndr_err = ndr_pull_struct_blob(&blob, res, res, (ndr_pull_flags_fn_t)ndr_pull_mapi_SRestriction);
+	if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		talloc_free(res);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_CORRUPT_STORE, local_mem_ctx);
+	}
+
+	el = ldb_msg_find_element(record, "SearchFolderId");
+	fids = talloc_array(mem_ctx, uint64_t, el ? el->num_values : 0);
+	for (i = 0; el && i < el->num_values; i++) {
+		fids[i] = strtoull((const char *)el->values[i].data, NULL, 10);
+	}
+
+	*resp = res;
+	*FolderIdCount = el ? el->num_values : 0;
+	*FolderIds = fids;
+	*SearchFlags = ldb_msg_find_attr_as_uint(record, "SearchFlags", 0);
+	*SearchState = ldb_msg_find_attr_as_uint(record, "SearchState", 0);
+
+	talloc_free(local_mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Update the state of a search folder
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param SearchState the search state
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_set_search_state(struct ldb_context *ldb_ctx,
+						       uint64_t fid,
+						       uint32_t SearchState)
+{
+	TALLOC_CTX		*mem_ctx;
+	const char * const	attrs[] = { "distinguishedName", NULL };
+	struct ldb_message	*record;
+	struct ldb_message	*msg;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_set_search_state");
+
+	record = openchangedb_search_get_record(mem_ctx, ldb_ctx, fid, attrs);
+	OPENCHANGE_RETVAL_IF(!record, MAPI_E_NOT_FOUND, mem_ctx);
+
+	msg = ldb_msg_new(mem_ctx);
+	OPENCHANGE_RETVAL_IF(!msg, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+	msg->dn = record->dn;
+	ldb_msg_add_fmt(msg, "SearchState", "%u", SearchState);
+	msg->elements[0].flags = LDB_FLAG_MOD_REPLACE;
+
+	ret = ldb_modify(ldb_ctx, msg);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	talloc_free(mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the search folders of a mailbox
+
+   \param mem_ctx pointer to the memory context
+   \param ldb_ctx pointer to the openchange LDB context
+   \param recipient the mailbox username
+   \param count pointer to the number of search folders to return
+   \param fids pointer on pointer to the search folder identifiers to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_get_search_folders(TALLOC_CTX *mem_ctx,
+							 struct ldb_context *ldb_ctx,
+							 const char *recipient,
+							 uint32_t *count,
+							 uint64_t **fids)
+{
+	TALLOC_CTX		*local_mem_ctx;
+	struct ldb_result	*res = NULL;
+	const char * const	attrs[] = { "PidTagFolderId", NULL };
+	struct ldb_dn		*dn;
+	uint32_t		i;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!recipient || !count || !fids, MAPI_E_INVALID_PARAMETER, NULL);
+
+	local_mem_ctx = talloc_named(NULL, 0, "openchangedb_get_search_folders");
+
+	/* Step 1. Search Mailbox Root DN */
+	ret = ldb_search(ldb_ctx, local_mem_ctx, &res, ldb_get_default_basedn(ldb_ctx),
+			 LDB_SCOPE_SUBTREE, attrs, "CN=%s", recipient);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS || !res->count, MAPI_E_NOT_FOUND, local_mem_ctx);
+	dn = res->msgs[0]->dn;
+
+	/* Step 2. Search folders with criteria within the mailbox */
+	ret = ldb_search(ldb_ctx, local_mem_ctx, &res, dn, LDB_SCOPE_SUBTREE, attrs, "(SearchRestriction=*)");
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_NOT_FOUND, local_mem_ctx);
+
+	*count = res->count;
+	*fids = talloc_array(mem_ctx, uint64_t, res->count);
+	for (i = 0; i < res->count; i++) {
+		(*fids)[i] = ldb_msg_find_attr_as_uint64(res->msgs[i], "PidTagFolderId", 0);
+	}
+
+	talloc_free(local_mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+static enum MAPISTATUS openchangedb_search_update_match(struct ldb_context *ldb_ctx,
+							uint64_t fid,
+							uint64_t folderID,
+							uint64_t messageID,
+							bool add)
+{
+	TALLOC_CTX		*mem_ctx;
+	const char * const	attrs[] = { "PidTagContentCount", NULL };
+	struct ldb_message	*record;
+	struct ldb_message	*msg;
+	struct ldb_dn		*dn;
+	uint32_t		count;
+	int			ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_search_update_match");
+
+	ret = ldb_transaction_start(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	/* The search folder record no longer holds the matches: reading it is cheap */
+	record = openchangedb_search_get_record(mem_ctx, ldb_ctx, fid, attrs);
+	if (!record) {
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_NOT_FOUND, mem_ctx);
+	}
+	count = ldb_msg_find_attr_as_uint(record, "PidTagContentCount", 0);
+
+	dn = ldb_dn_new_fmt(mem_ctx, ldb_ctx, "CN=%"PRIu64",%s", messageID, ldb_dn_get_linearized(record->dn));
+	if (!dn) {
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+	}
+
+	if (add) {
+		msg = ldb_msg_new(mem_ctx);
+		if (!msg) {
+			ldb_transaction_cancel(ldb_ctx);
+			OPENCHANGE_RETVAL_ERR(MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+		}
+		msg->dn = dn;
+		ldb_msg_add_string(msg, "objectClass", "searchMatch");
+		ldb_msg_add_fmt(msg, "cn", "%"PRIu64, messageID);
+		ldb_msg_add_fmt(msg, "SearchMatchFolderId", "%"PRIu64, folderID);
+		ldb_msg_add_fmt(msg, "SearchMatchMessageId", "%"PRIu64, messageID);
+		ret = ldb_add(ldb_ctx, msg);
+	} else {
+		ret = ldb_delete(ldb_ctx, dn);
+	}
+
+	if (ret == LDB_ERR_ENTRY_ALREADY_EXISTS || ret == LDB_ERR_NO_SUCH_OBJECT) {
+		/* Nothing to do */
+		ldb_transaction_cancel(ldb_ctx);
+		talloc_free(mem_ctx);
+		return MAPI_E_SUCCESS;
+	}
+	if (ret != LDB_SUCCESS) {
+		DEBUG(3, ("[%s:%d]: unable to update %s: %s\n", __FUNCTION__, __LINE__,
+			  ldb_dn_get_linearized(dn), ldb_errstring(ldb_ctx)));
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_CALL_FAILED, mem_ctx);
+	}
+
+	msg = ldb_msg_new(mem_ctx);
+	if (!msg) {
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+	}
+	msg->dn = record->dn;
+	ldb_msg_add_fmt(msg, "PidTagContentCount", "%u", add ? count + 1 : (count ? count - 1 : 0));
+	msg->elements[0].flags = LDB_FLAG_MOD_REPLACE;
+	ret = ldb_modify(ldb_ctx, msg);
+	if (ret != LDB_SUCCESS) {
+		ldb_transaction_cancel(ldb_ctx);
+		OPENCHANGE_RETVAL_ERR(MAPI_E_CALL_FAILED, mem_ctx);
+	}
+
+	ret = ldb_transaction_commit(ldb_ctx);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, mem_ctx);
+
+	talloc_free(mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Add a message to the match index of a search folder
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param folderID the identifier of the folder holding the message
+   \param messageID the message identifier
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_search_add_match(struct ldb_context *ldb_ctx,
+						       uint64_t fid,
+						       uint64_t folderID,
+						       uint64_t messageID)
+{
+	return openchangedb_search_update_match(ldb_ctx, fid, folderID, messageID, true);
+}
+
+
+/**
+   \details Remove a message from the match index of a search folder
+
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param folderID the identifier of the folder holding the message
+   \param messageID the message identifier
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_search_del_match(struct ldb_context *ldb_ctx,
+						       uint64_t fid,
+						       uint64_t folderID,
+						       uint64_t messageID)
+{
+	return openchangedb_search_update_match(ldb_ctx, fid, folderID, messageID, false);
+}
+
+
+/**
+   \details Retrieve the match index of a search folder
+
+   \param mem_ctx pointer to the memory context
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fid the search folder identifier
+   \param count pointer to the number of matching messages to return
+   \param folderIDs pointer on pointer to the folder of each matching
+   message to return
+   \param messageIDs pointer on pointer to the matching messages to
+   return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_INITIALIZED if the
+   folder is not a search folder, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_get_search_matches(TALLOC_CTX *mem_ctx,
+							 struct ldb_context *ldb_ctx,
+							 uint64_t fid,
+							 uint32_t *count,
+							 uint64_t **folderIDs,
+							 uint64_t **messageIDs)
+{
+	TALLOC_CTX			*local_mem_ctx;
+	const char * const		attrs[] = { "SearchRestriction", NULL };
+	const char * const		match_attrs[] = { "SearchMatchFolderId", "SearchMatchMessageId", NULL };
+	struct ldb_message		*record;
+	struct ldb_result		*res = NULL;
+	uint64_t			*fids;
+	uint64_t			*mids;
+	unsigned int			i;
+	uint32_t			j;
+	int				ret;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!count || !folderIDs || !messageIDs, MAPI_E_INVALID_PARAMETER, NULL);
+
+	local_mem_ctx = talloc_named(NULL, 0, "openchangedb_get_search_matches");
+
+	record = openchangedb_search_get_record(local_mem_ctx, ldb_ctx, fid, attrs);
+	OPENCHANGE_RETVAL_IF(!record, MAPI_E_NOT_FOUND, local_mem_ctx);
+	OPENCHANGE_RETVAL_IF(!ldb_msg_find_element(record, "SearchRestriction"), MAPI_E_NOT_INITIALIZED, local_mem_ctx);
+
+	ret = ldb_search(ldb_ctx, local_mem_ctx, &res, record->dn, LDB_SCOPE_ONELEVEL, match_attrs, "(objectClass=searchMatch)");
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_CALL_FAILED, local_mem_ctx);
+
+	fids = talloc_array(mem_ctx, uint64_t, res->count);
+	mids = talloc_array(mem_ctx, uint64_t, res->count);
+	for (i = 0, j = 0; i < res->count; i++) {
+		fids[j] = ldb_msg_find_attr_as_uint64(res->msgs[i], "SearchMatchFolderId", 0);
+		mids[j] = ldb_msg_find_attr_as_uint64(res->msgs[i], "SearchMatchMessageId", 0);
+		if (!fids[j] || !mids[j]) {
+			DEBUG(5, ("[%s:%d]: invalid match: %s\n", __FUNCTION__, __LINE__, ldb_dn_get_linearized(res->msgs[i]->dn)));
+			continue;
+		}
+		j++;
+	}
+
+	*count = j;
+	*folderIDs = fids;
+	*messageIDs = mids;
+
+	talloc_free(local_mem_ctx);
+
+	return MAPI_E_SUCCESS;
+}
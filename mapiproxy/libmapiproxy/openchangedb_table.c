@@ -32,6 +32,9 @@
 #include "libmapi/libmapi.h"
 #include "libmapi/libmapi_private.h"
 
+extern struct ldb_val ldb_binary_decode(TALLOC_CTX *, const char *);
+extern const char *openchangedb_nil_string;
+
 /**
    /details Initialize an openchangedb table
 
@@ -60,6 +63,11 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_init(TALLOC_CTX *mem_ctx, uint8_t ta
 	table->lpSortCriteria = NULL;
 	table->restrictions = NULL;
 	table->res = NULL;
+	table->rows = NULL;
+	table->row_count = 0;
+	table->view = NULL;
+	table->view_count = 0;
+	table->index = NULL;
 
 	*table_object = (void *)table;
 
@@ -67,11 +75,49 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_init(TALLOC_CTX *mem_ctx, uint8_t ta
 }
 
 
+/**
+   \details Release the rows and the view computed for an openchangedb
+   table object
+
+   \param table pointer to the table object
+ */
+static void openchangedb_table_reset_rows(struct openchangedb_table *table)
+{
+	/* rows, view and index are allocated under res */
+	if (table->res) {
+		talloc_free(table->res);
+		table->res = NULL;
+	}
+	table->rows = NULL;
+	table->row_count = 0;
+	table->view = NULL;
+	table->view_count = 0;
+	table->index = NULL;
+}
+
+
+/**
+   \details Release the view computed for an openchangedb table object,
+   keeping the sorted rows
+
+   \param table pointer to the table object
+ */
+static void openchangedb_table_reset_view(struct openchangedb_table *table)
+{
+	if (table->view) {
+		talloc_free(table->view);
+		table->view = NULL;
+	}
+	table->view_count = 0;
+}
+
+
 /**
    \details Set sort order to specified openchangedb table object
 
    \param table_object pointer to the table object
-   \param lpSortCriteria pointer to the sort order to save
+   \param lpSortCriteria pointer to the sort order to save, NULL to
+   reset the sort order
 
    \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
@@ -82,14 +128,10 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_set_sort_order(void *table_object,
 
 	/* Sanity checks */
 	MAPI_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
-	MAPI_RETVAL_IF(!lpSortCriteria, MAPI_E_INVALID_PARAMETER, NULL);
 
 	table = (struct openchangedb_table *) table_object;
 
-	if (table->res) {
-		talloc_free(table->res);
-		table->res = NULL;
-	}
+	openchangedb_table_reset_rows(table);
 
 	if (table->lpSortCriteria) {
 		talloc_free(table->lpSortCriteria);
@@ -100,7 +142,7 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_set_sort_order(void *table_object,
 			return MAPI_E_NOT_ENOUGH_MEMORY;
 		}
 		table->lpSortCriteria->aSort = talloc_memdup((TALLOC_CTX *)table->lpSortCriteria, lpSortCriteria->aSort, lpSortCriteria->cSorts * sizeof(struct SSortOrder));
-		if (!table->lpSortCriteria->aSort) {
+		if (lpSortCriteria->cSorts && !table->lpSortCriteria->aSort) {
 			return MAPI_E_NOT_ENOUGH_MEMORY;
 		}
 	}
@@ -112,6 +154,143 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_set_sort_order(void *table_object,
 }
 
 
+/**
+   \details Copy a restriction property value
+
+   Types which can't be evaluated against openchangedb records are
+   turned into PT_NULL so the restriction never matches them.
+
+   \param mem_ctx pointer to the memory context
+   \param dst pointer to the property value to fill
+   \param src pointer to the property value to copy
+ */
+static void openchangedb_table_copy_property(TALLOC_CTX *mem_ctx,
+					     struct mapi_SPropValue *dst,
+					     struct mapi_SPropValue *src)
+{
+	*dst = *src;
+
+	switch (src->ulPropTag & 0xFFFF) {
+	case PT_BOOLEAN:
+	case PT_I2:
+	case PT_LONG:
+	case PT_DOUBLE:
+	case PT_I8:
+	case PT_SYSTIME:
+	case PT_ERROR:
+	case PT_CLSID:
+		break;
+	case PT_STRING8:
+		dst->value.lpszA = talloc_strdup(mem_ctx, src->value.lpszA);
+		break;
+	case PT_UNICODE:
+		dst->value.lpszW = talloc_strdup(mem_ctx, src->value.lpszW);
+		break;
+	case PT_BINARY:
+		dst->value.bin.lpb = talloc_memdup(mem_ctx, src->value.bin.lpb, src->value.bin.cb);
+		break;
+	default:
+		DEBUG(5, ("[%s:%d]: Unsupported restriction property type: 0x%.4x\n", __FUNCTION__, __LINE__,
+			  (src->ulPropTag & 0xFFFF)));
+		dst->ulPropTag = (src->ulPropTag & 0xFFFF0000) | PT_NULL;
+		break;
+	}
+}
+
+
+/**
+   \details Deep copy a restriction tree
+
+   \param mem_ctx pointer to the memory context
+   \param dst pointer to the restriction to fill
+   \param src pointer to the restriction to copy
+ */
+static void openchangedb_table_copy_restriction(TALLOC_CTX *mem_ctx,
+						struct mapi_SRestriction *dst,
+						struct mapi_SRestriction *src)
+{
+	struct mapi_SRestriction_comment	*comment;
+	uint32_t				i;
+
+	dst->rt = src->rt;
+
+	switch (src->rt) {
+	case RES_AND:
+		dst->res.resAnd.cRes = src->res.resAnd.cRes;
+		dst->res.resAnd.res = talloc_array(mem_ctx, struct mapi_SRestriction_and, src->res.resAnd.cRes);
+		for (i = 0; i < src->res.resAnd.cRes; i++) {
+			openchangedb_table_copy_restriction(mem_ctx, (struct mapi_SRestriction *)&dst->res.resAnd.res[i],
+							    (struct mapi_SRestriction *)&src->res.resAnd.res[i]);
+		}
+		break;
+	case RES_OR:
+		dst->res.resOr.cRes = src->res.resOr.cRes;
+		dst->res.resOr.res = talloc_array(mem_ctx, struct mapi_SRestriction_or, src->res.resOr.cRes);
+		for (i = 0; i < src->res.resOr.cRes; i++) {
+			openchangedb_table_copy_restriction(mem_ctx, (struct mapi_SRestriction *)&dst->res.resOr.res[i],
+							    (struct mapi_SRestriction *)&src->res.resOr.res[i]);
+		}
+		break;
+	case RES_NOT:
+		openchangedb_table_copy_restriction(mem_ctx, (struct mapi_SRestriction *)&dst->res.resNot.res,
+						    (struct mapi_SRestriction *)&src->res.resNot.res);
+		break;
+	case RES_CONTENT:
+		dst->res.resContent.fuzzy = src->res.resContent.fuzzy;
+		dst->res.resContent.ulPropTag = src->res.resContent.ulPropTag;
+		openchangedb_table_copy_property(mem_ctx, &dst->res.resContent.lpProp, &src->res.resContent.lpProp);
+		break;
+	case RES_PROPERTY:
+		dst->res.resProperty.relop = src->res.resProperty.relop;
+		dst->res.resProperty.ulPropTag = src->res.resProperty.ulPropTag;
+		openchangedb_table_copy_property(mem_ctx, &dst->res.resProperty.lpProp, &src->res.resProperty.lpProp);
+		break;
+	case RES_COMPAREPROPS:
+		dst->res.resCompareProps = src->res.resCompareProps;
+		break;
+	case RES_BITMASK:
+		dst->res.resBitmask = src->res.resBitmask;
+		break;
+	case RES_SIZE:
+		dst->res.resSize = src->res.resSize;
+		break;
+	case RES_EXIST:
+		dst->res.resExist = src->res.resExist;
+		break;
+	case RES_SUBRESTRICTION:
+		dst->res.resSub.ulSubObject = src->res.resSub.ulSubObject;
+		dst->res.resSub.res = talloc_zero(mem_ctx, struct mapi_SRestriction_sub);
+		openchangedb_table_copy_restriction(mem_ctx, (struct mapi_SRestriction *)dst->res.resSub.res,
+						    (struct mapi_SRestriction *)src->res.resSub.res);
+		break;
+	case RES_COMMENT:
+		/* Tagged values are annotations and are not evaluated */
+		dst->res.resComment.TaggedValuesCount = 0;
+		dst->res.resComment.TaggedValues = NULL;
+		dst->res.resComment.RestrictionPresent = src->res.resComment.RestrictionPresent;
+		if (src->res.resComment.RestrictionPresent) {
+			comment = talloc_zero(mem_ctx, struct mapi_SRestriction_comment);
+			openchangedb_table_copy_restriction(mem_ctx, (struct mapi_SRestriction *)comment,
+							    (struct mapi_SRestriction *)src->res.resComment.Restriction.res);
+			dst->res.resComment.Restriction.res = comment;
+		}
+		break;
+	default:
+		DEBUG(0, ("Unsupported restriction type: 0x%x\n", src->rt));
+		break;
+	}
+}
+
+
+/**
+   \details Set restrictions to specified openchangedb table object
+
+   \param table_object pointer to the table object
+   \param res pointer to the restriction to save, NULL to reset
+   restrictions
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
 _PUBLIC_ enum MAPISTATUS openchangedb_table_set_restrictions(void *table_object,
 							     struct mapi_SRestriction *res)
 {
@@ -119,14 +298,11 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_set_restrictions(void *table_object,
 
 	/* Sanity checks */
 	MAPI_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
-	MAPI_RETVAL_IF(!res, MAPI_E_INVALID_PARAMETER, NULL);
 
 	table = (struct openchangedb_table *) table_object;
 
-	if (table->res) {
-		talloc_free(table->res);
-		table->res = NULL;
-	}
+	/* Sorted rows are kept, only the view is computed again */
+	openchangedb_table_reset_view(table);
 
 	if (table->restrictions) {
 		talloc_free(table->restrictions);
@@ -136,194 +312,914 @@ _PUBLIC_ enum MAPISTATUS openchangedb_table_set_restrictions(void *table_object,
 	MAPI_RETVAL_IF(!res, MAPI_E_SUCCESS, NULL);
 
 	table->restrictions = talloc_zero((TALLOC_CTX *)table_object, struct mapi_SRestriction);
+	MAPI_RETVAL_IF(!table->restrictions, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
 
-	switch (res->rt) {
-	case RES_PROPERTY:
-		table->restrictions->rt = res->rt;
-		table->restrictions->res.resProperty.relop = res->res.resProperty.relop;
-		table->restrictions->res.resProperty.ulPropTag = res->res.resProperty.ulPropTag;
-		table->restrictions->res.resProperty.lpProp.ulPropTag = res->res.resProperty.lpProp.ulPropTag;
-
-		switch (table->restrictions->res.resProperty.lpProp.ulPropTag & 0xFFFF) {
-		case PT_STRING8:
-			table->restrictions->res.resProperty.lpProp.value.lpszA = talloc_strdup((TALLOC_CTX *)table->restrictions, res->res.resProperty.lpProp.value.lpszA);
-			break;
-		case PT_UNICODE:
-			table->restrictions->res.resProperty.lpProp.value.lpszW = talloc_strdup((TALLOC_CTX *)table->restrictions, res->res.resProperty.lpProp.value.lpszW);
-			break;
-		default:
-			DEBUG(0, ("Unsupported property type for RES_PROPERTY restriction\n"));
-			break;
-		}
-		break;
-	default:
-		DEBUG(0, ("Unsupported restriction type: 0x%x\n", res->rt));
-	}
+	openchangedb_table_copy_restriction((TALLOC_CTX *)table->restrictions, table->restrictions, res);
 
 	return MAPI_E_SUCCESS;
 }
 
-static char *openchangedb_table_build_filter(TALLOC_CTX *mem_ctx, struct openchangedb_table *table, uint64_t row_fmid, struct mapi_SRestriction *restrictions)
+static char *openchangedb_table_build_filter(TALLOC_CTX *mem_ctx, struct openchangedb_table *table)
 {
 	char		*filter = NULL;
-	const char	*PidTagAttr = NULL;
 
 	switch (table->table_type) {
 	case 0x3 /* EMSMDBP_TABLE_FAI_TYPE */:
-		filter = talloc_asprintf(mem_ctx, "(&(objectClass=faiMessage)(PidTagParentFolderId=%"PRIu64")(PidTagMessageId=", table->folderID);
+		filter = talloc_asprintf(mem_ctx, "(&(objectClass=faiMessage)(PidTagParentFolderId=%"PRIu64")(PidTagMessageId=*))", table->folderID);
 		break;
 	case 0x2 /* EMSMDBP_TABLE_MESSAGE_TYPE */:
-		filter = talloc_asprintf(mem_ctx, "(&(objectClass=systemMessage)(PidTagParentFolderId=%"PRIu64")(PidTagMessageId=", table->folderID);
+		filter = talloc_asprintf(mem_ctx, "(&(objectClass=systemMessage)(PidTagParentFolderId=%"PRIu64")(PidTagMessageId=*))", table->folderID);
 		break;
 	case 0x1 /* EMSMDBP_TABLE_FOLDER_TYPE */:
-		filter = talloc_asprintf(mem_ctx, "(&(PidTagParentFolderId=%"PRIu64")(PidTagFolderId=", table->folderID);
+		filter = talloc_asprintf(mem_ctx, "(&(PidTagParentFolderId=%"PRIu64")(PidTagFolderId=*))", table->folderID);
 		break;
 	}
 
-	if (row_fmid == 0) {
-		filter = talloc_asprintf_append(filter, "*)");
+	return filter;
+}
+
+
+/**
+   \details Convert a property tag into the PidTag attribute used in
+   table records
+
+   \param table pointer to the table object
+   \param proptag pointer to the property tag, updated when the
+   property is an alias
+
+   \return the PidTag attribute name on success, otherwise NULL
+ */
+static const char *openchangedb_table_get_attribute(struct openchangedb_table *table, uint32_t *proptag)
+{
+	/* hacks for some attributes specific to tables */
+	if (*proptag == PR_INST_ID) {
+		if (table->table_type == 1) {
+			*proptag = PR_FID;
+		}
+		else {
+			*proptag = PR_MID;
+		}
 	}
-	else {
-		filter = talloc_asprintf_append(filter, "%"PRIu64")", row_fmid);
+
+	if ((table->table_type != 0x1) && *proptag == PR_FID) {
+		*proptag = PR_PARENT_FID;
 	}
 
-	if (restrictions) {
-		switch (restrictions->rt) {
-		case RES_PROPERTY:
-			/* Retrieve PidTagName */
-			PidTagAttr = openchangedb_property_get_attribute(restrictions->res.resProperty.ulPropTag);
-			if (!PidTagAttr) {
-				talloc_free(filter);
-				return NULL;
-			}
-			filter = talloc_asprintf_append(filter, "(%s=", PidTagAttr);
-			switch (restrictions->res.resProperty.ulPropTag & 0xFFFF) {
-			case PT_STRING8:
-				filter = talloc_asprintf_append(filter, "%s)", restrictions->res.resProperty.lpProp.value.lpszA);
-				break;
-			case PT_UNICODE:
-				filter = talloc_asprintf_append(filter, "%s)", restrictions->res.resProperty.lpProp.value.lpszW);
-				break;
-			default:
-				DEBUG(0, ("Unsupported RES_PROPERTY property type: 0x%.4x\n", (restrictions->res.resProperty.ulPropTag & 0xFFFF)));
-				talloc_free(filter);
-				return NULL;
+	return openchangedb_property_get_attribute(*proptag);
+}
+
+
+/**
+   \details Retrieve a comparable property value from a table record
+
+   \param mem_ctx pointer to the memory context
+   \param table pointer to the table object
+   \param msg pointer to the LDB record
+   \param proptag the property to retrieve
+   \param value pointer to the value to fill
+
+   \return true if the property exists, otherwise false. The value
+   type is PT_UNSPECIFIED when the property cannot be compared.
+ */
+static bool openchangedb_table_get_value(TALLOC_CTX *mem_ctx,
+					 struct openchangedb_table *table,
+					 struct ldb_message *msg,
+					 uint32_t proptag,
+					 struct openchangedb_table_value *value)
+{
+	const char	*PidTagAttr;
+	const char	*str;
+	char		*bin;
+	struct ldb_val	val;
+
+	value->type = PT_UNSPECIFIED;
+
+	PidTagAttr = openchangedb_table_get_attribute(table, &proptag);
+	if (!PidTagAttr || !ldb_msg_find_element(msg, PidTagAttr)) {
+		return false;
+	}
+
+	switch (proptag & 0xFFFF) {
+	case PT_BOOLEAN:
+		value->value.i = ldb_msg_find_attr_as_bool(msg, PidTagAttr, 0x0);
+		break;
+	case PT_I2:
+	case PT_LONG:
+		value->value.i = ldb_msg_find_attr_as_uint(msg, PidTagAttr, 0x0);
+		break;
+	case PT_I8:
+	case PT_SYSTIME:
+		value->value.i = ldb_msg_find_attr_as_uint64(msg, PidTagAttr, 0x0);
+		break;
+	case PT_STRING8:
+	case PT_UNICODE:
+		str = ldb_msg_find_attr_as_string(msg, PidTagAttr, NULL);
+		if (!str) return false;
+		val = ldb_binary_decode(mem_ctx, str);
+		value->value.str = talloc_strndup(mem_ctx, (char *) val.data, val.length);
+		break;
+	case PT_BINARY:
+		str = ldb_msg_find_attr_as_string(msg, PidTagAttr, NULL);
+		if (!str) return false;
+		if (strcmp(str, openchangedb_nil_string) == 0) {
+			value->value.bin = data_blob_null;
+		}
+		else {
+			bin = talloc_strdup(mem_ctx, str);
+			value->value.bin.length = ldb_base64_decode(bin);
+			value->value.bin.data = (uint8_t *) bin;
+		}
+		break;
+	default:
+		return true;
+	}
+	value->type = proptag & 0xFFFF;
+
+	return true;
+}
+
+
+/**
+   \details Retrieve a comparable value from a restriction property
+
+   \param lpProp pointer to the restriction property
+   \param value pointer to the value to fill
+
+   \return true if the property has a comparable type, otherwise false
+ */
+static bool openchangedb_table_get_prop_value(struct mapi_SPropValue *lpProp,
+					      struct openchangedb_table_value *value)
+{
+	value->type = lpProp->ulPropTag & 0xFFFF;
+
+	switch (value->type) {
+	case PT_BOOLEAN:
+		value->value.i = lpProp->value.b;
+		break;
+	case PT_I2:
+		value->value.i = lpProp->value.i;
+		break;
+	case PT_LONG:
+		value->value.i = lpProp->value.l;
+		break;
+	case PT_I8:
+		value->value.i = lpProp->value.d;
+		break;
+	case PT_SYSTIME:
+		value->value.i = ((uint64_t)lpProp->value.ft.dwHighDateTime << 32) | lpProp->value.ft.dwLowDateTime;
+		break;
+	case PT_STRING8:
+		value->value.str = lpProp->value.lpszA;
+		if (!value->value.str) return false;
+		break;
+	case PT_UNICODE:
+		value->value.str = lpProp->value.lpszW;
+		if (!value->value.str) return false;
+		break;
+	case PT_BINARY:
+		value->value.bin.data = lpProp->value.bin.lpb;
+		value->value.bin.length = lpProp->value.bin.cb;
+		break;
+	default:
+		value->type = PT_UNSPECIFIED;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+   \details Compare two values
+
+   Integer types compare with each other, so do PT_STRING8 and
+   PT_UNICODE. Strings are compared case-insensitively.
+
+   \param value1 pointer to the first value
+   \param value2 pointer to the second value
+   \param result pointer to the comparison result, lower than, equal
+   to or greater than 0
+
+   \return true if both values are comparable, otherwise false
+ */
+static bool openchangedb_table_compare_values(struct openchangedb_table_value *value1,
+					      struct openchangedb_table_value *value2,
+					      int *result)
+{
+	size_t	length;
+
+	switch (value1->type) {
+	case PT_BOOLEAN:
+	case PT_I2:
+	case PT_LONG:
+	case PT_I8:
+	case PT_SYSTIME:
+		switch (value2->type) {
+		case PT_BOOLEAN:
+		case PT_I2:
+		case PT_LONG:
+		case PT_I8:
+		case PT_SYSTIME:
+			*result = (value1->value.i > value2->value.i) - (value1->value.i < value2->value.i);
+			return true;
+		}
+		break;
+	case PT_STRING8:
+	case PT_UNICODE:
+		if (value2->type == PT_STRING8 || value2->type == PT_UNICODE) {
+			*result = strcasecmp(value1->value.str, value2->value.str);
+			return true;
+		}
+		break;
+	case PT_BINARY:
+		if (value2->type == PT_BINARY) {
+			length = MIN(value1->value.bin.length, value2->value.bin.length);
+			*result = length ? memcmp(value1->value.bin.data, value2->value.bin.data, length) : 0;
+			if (*result == 0) {
+				*result = (value1->value.bin.length > value2->value.bin.length) - (value1->value.bin.length < value2->value.bin.length);
 			}
+			return true;
 		}
+		break;
 	}
 
-	/* Close filter */
-	filter = talloc_asprintf_append(filter, ")");
+	return false;
+}
 
-	return filter;
+
+/**
+   \details Compare two sort keys
+
+   Missing values sort before existing ones. Values which cannot be
+   compared are considered equal.
+
+   \param key1 pointer to the first key
+   \param key2 pointer to the second key
+
+   \return lower than, equal to or greater than 0
+ */
+_PUBLIC_ int openchangedb_table_compare_keys(struct openchangedb_table_value *key1,
+					     struct openchangedb_table_value *key2)
+{
+	int	result;
+
+	if (key1->type == PT_UNSPECIFIED || key2->type == PT_UNSPECIFIED) {
+		return (key1->type != PT_UNSPECIFIED) - (key2->type != PT_UNSPECIFIED);
+	}
+	if (!openchangedb_table_compare_values(key1, key2, &result)) {
+		return 0;
+	}
+
+	return result;
 }
 
-_PUBLIC_ enum MAPISTATUS openchangedb_table_get_property(TALLOC_CTX *mem_ctx,
-							 void *table_object,
-							 struct ldb_context *ldb_ctx,
-							 enum MAPITAGS proptag,
-							 uint32_t pos,
-							 bool live_filtered,
-							 void **data)
+
+/**
+   \details Apply a relational operator to a comparison result
+
+   \param relop the relational operator
+   \param result the comparison result
+
+   \return true if the relation is verified, otherwise false
+ */
+static bool openchangedb_table_relop(uint8_t relop, int result)
 {
+	switch (relop) {
+	case RELOP_LT:
+		return result < 0;
+	case RELOP_LE:
+		return result <= 0;
+	case RELOP_GT:
+		return result > 0;
+	case RELOP_GE:
+		return result >= 0;
+	case RELOP_EQ:
+		return result == 0;
+	case RELOP_NE:
+		return result != 0;
+	default:
+		DEBUG(5, ("[%s:%d]: Unsupported relational operator: 0x%x\n", __FUNCTION__, __LINE__, relop));
+		return false;
+	}
+}
+
+
+/**
+   \details Evaluate a content restriction
+
+   \param value pointer to the row value
+   \param pattern pointer to the restriction value
+   \param fuzzy the fuzzy level of the restriction
+
+   \return true if the value matches, otherwise false
+ */
+static bool openchangedb_table_match_content(struct openchangedb_table_value *value,
+					     struct openchangedb_table_value *pattern,
+					     uint32_t fuzzy)
+{
+	bool	ignorecase;
+	size_t	length;
+
+	ignorecase = (fuzzy & (FL_IGNORECASE|FL_LOOSE)) ? true : false;
+
+	if ((value->type == PT_STRING8 || value->type == PT_UNICODE) &&
+	    (pattern->type == PT_STRING8 || pattern->type == PT_UNICODE)) {
+		switch (fuzzy & 0xFFFF) {
+		case FL_FULLSTRING:
+			return ignorecase ? !strcasecmp(value->value.str, pattern->value.str) : !strcmp(value->value.str, pattern->value.str);
+		case FL_PREFIX:
+			length = strlen(pattern->value.str);
+			return ignorecase ? !strncasecmp(value->value.str, pattern->value.str, length) : !strncmp(value->value.str, pattern->value.str, length);
+		case FL_SUBSTRING:
+			return ignorecase ? (strcasestr(value->value.str, pattern->value.str) != NULL) : (strstr(value->value.str, pattern->value.str) != NULL);
+		}
+	}
+	else if (value->type == PT_BINARY && pattern->type == PT_BINARY) {
+		switch (fuzzy & 0xFFFF) {
+		case FL_FULLSTRING:
+			return data_blob_cmp(&value->value.bin, &pattern->value.bin) == 0;
+		case FL_PREFIX:
+			return (value->value.bin.length >= pattern->value.bin.length) &&
+				!memcmp(value->value.bin.data, pattern->value.bin.data, pattern->value.bin.length);
+		case FL_SUBSTRING:
+			return !pattern->value.bin.length ||
+				memmem(value->value.bin.data, value->value.bin.length,
+				       pattern->value.bin.data, pattern->value.bin.length) != NULL;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+   \details Evaluate a restriction against a set of property values
+
+   Values are retrieved on demand through get_value, which returns
+   false when the property does not exist. This lets openchangedb
+   tables and callers holding values from other sources share the
+   same evaluation rules.
+
+   \param mem_ctx pointer to the memory context
+   \param res pointer to the restriction
+   \param get_value the function retrieving property values
+   \param private_data pointer passed to get_value
+
+   \return true if the values match the restriction, otherwise false
+ */
+_PUBLIC_ bool openchangedb_restriction_match(TALLOC_CTX *mem_ctx,
+					     struct mapi_SRestriction *res,
+					     openchangedb_restriction_get_value_t get_value,
+					     void *private_data)
+{
+	struct openchangedb_table_value	value1;
+	struct openchangedb_table_value	value2;
+	uint32_t			size;
+	uint32_t			i;
+	int				result;
+
+	switch (res->rt) {
+	case RES_AND:
+		for (i = 0; i < res->res.resAnd.cRes; i++) {
+			if (!openchangedb_restriction_match(mem_ctx, (struct mapi_SRestriction *)&res->res.resAnd.res[i], get_value, private_data)) {
+				return false;
+			}
+		}
+		return true;
+	case RES_OR:
+		for (i = 0; i < res->res.resOr.cRes; i++) {
+			if (openchangedb_restriction_match(mem_ctx, (struct mapi_SRestriction *)&res->res.resOr.res[i], get_value, private_data)) {
+				return true;
+			}
+		}
+		return false;
+	case RES_NOT:
+		return !openchangedb_restriction_match(mem_ctx, (struct mapi_SRestriction *)&res->res.resNot.res, get_value, private_data);
+	case RES_CONTENT:
+		if (!get_value(mem_ctx, private_data, res->res.resContent.ulPropTag, &value1) ||
+		    !openchangedb_table_get_prop_value(&res->res.resContent.lpProp, &value2)) {
+			return false;
+		}
+		return openchangedb_table_match_content(&value1, &value2, res->res.resContent.fuzzy);
+	case RES_PROPERTY:
+		if (!get_value(mem_ctx, private_data, res->res.resProperty.ulPropTag, &value1) ||
+		    !openchangedb_table_get_prop_value(&res->res.resProperty.lpProp, &value2) ||
+		    !openchangedb_table_compare_values(&value1, &value2, &result)) {
+			return false;
+		}
+		return openchangedb_table_relop(res->res.resProperty.relop, result);
+	case RES_COMPAREPROPS:
+		if (!get_value(mem_ctx, private_data, res->res.resCompareProps.ulPropTag1, &value1) ||
+		    !get_value(mem_ctx, private_data, res->res.resCompareProps.ulPropTag2, &value2) ||
+		    !openchangedb_table_compare_values(&value1, &value2, &result)) {
+			return false;
+		}
+		return openchangedb_table_relop(res->res.resCompareProps.relop, result);
+	case RES_BITMASK:
+		if (!get_value(mem_ctx, private_data, res->res.resBitmask.ulPropTag, &value1) ||
+		    value1.type != PT_LONG) {
+			return false;
+		}
+		if (res->res.resBitmask.relMBR == BMR_EQZ) {
+			return (value1.value.i & res->res.resBitmask.ulMask) == 0;
+		}
+		return (value1.value.i & res->res.resBitmask.ulMask) != 0;
+	case RES_SIZE:
+		if (!get_value(mem_ctx, private_data, res->res.resSize.ulPropTag, &value1)) {
+			return false;
+		}
+		switch (value1.type) {
+		case PT_BOOLEAN:
+		case PT_I2:
+			size = sizeof (uint16_t);
+			break;
+		case PT_LONG:
+			size = sizeof (uint32_t);
+			break;
+		case PT_I8:
+		case PT_SYSTIME:
+			size = sizeof (uint64_t);
+			break;
+		case PT_STRING8:
+			size = strlen(value1.value.str) + 1;
+			break;
+		case PT_UNICODE:
+			size = (strlen(value1.value.str) + 1) * 2;
+			break;
+		case PT_BINARY:
+			size = value1.value.bin.length;
+			break;
+		default:
+			return false;
+		}
+		result = (size > res->res.resSize.size) - (size < res->res.resSize.size);
+		return openchangedb_table_relop(res->res.resSize.relop, result);
+	case RES_EXIST:
+		return get_value(mem_ctx, private_data, res->res.resExist.ulPropTag, &value1);
+	case RES_SUBRESTRICTION:
+		/* recipients and attachments are not evaluated */
+		return false;
+	case RES_COMMENT:
+		if (!res->res.resComment.RestrictionPresent) {
+			return true;
+		}
+		return openchangedb_restriction_match(mem_ctx, (struct mapi_SRestriction *)res->res.resComment.Restriction.res, get_value, private_data);
+	default:
+		DEBUG(5, ("[%s:%d]: Unsupported restriction type: 0x%x\n", __FUNCTION__, __LINE__, res->rt));
+		return false;
+	}
+}
+
+
+struct openchangedb_table_record {
 	struct openchangedb_table	*table;
-	char				*ldb_filter = NULL;
-	struct ldb_result		*res = NULL, *live_res = NULL;
+	struct ldb_message		*msg;
+};
+
+static bool openchangedb_table_record_get_value(TALLOC_CTX *mem_ctx, void *private_data,
+						uint32_t proptag, struct openchangedb_table_value *value)
+{
+	struct openchangedb_table_record	*record = (struct openchangedb_table_record *)private_data;
+
+	return openchangedb_table_get_value(mem_ctx, record->table, record->msg, proptag, value);
+}
+
+
+/**
+   \details Evaluate a restriction against a table record
+
+   \param mem_ctx pointer to the memory context
+   \param table pointer to the table object
+   \param msg pointer to the LDB record
+   \param res pointer to the restriction
+
+   \return true if the record matches the restriction, otherwise false
+ */
+static bool openchangedb_table_match(TALLOC_CTX *mem_ctx,
+				     struct openchangedb_table *table,
+				     struct ldb_message *msg,
+				     struct mapi_SRestriction *res)
+{
+	struct openchangedb_table_record	record;
+
+	record.table = table;
+	record.msg = msg;
+
+	return openchangedb_restriction_match(mem_ctx, res, openchangedb_table_record_get_value, &record);
+}
+
+
+/**
+   \details Compare two table rows using the table sort order
+
+   Missing values sort before existing ones. Rows with identical sort
+   keys keep the order returned by LDB.
+ */
+static int openchangedb_table_row_cmp(const void *p1, const void *p2)
+{
+	struct openchangedb_table_row	*row1 = *(struct openchangedb_table_row **)p1;
+	struct openchangedb_table_row	*row2 = *(struct openchangedb_table_row **)p2;
+	uint32_t			i;
+	int				result;
+
+	for (i = 0; row1->sort && i < row1->sort->cSorts; i++) {
+		result = openchangedb_table_compare_keys(&row1->keys[i], &row2->keys[i]);
+		if (result) {
+			return (row1->sort->aSort[i].ulOrder & TABLE_SORT_DESCEND) ? -result : result;
+		}
+	}
+
+	return (row1->ldb_index > row2->ldb_index) - (row1->ldb_index < row2->ldb_index);
+}
+
+
+static int openchangedb_table_fmid_cmp(const void *p1, const void *p2)
+{
+	struct openchangedb_table_row	*row1 = *(struct openchangedb_table_row **)p1;
+	struct openchangedb_table_row	*row2 = *(struct openchangedb_table_row **)p2;
+
+	return (row1->fmid > row2->fmid) - (row1->fmid < row2->fmid);
+}
+
+
+/**
+   \details Fetch the table records and sort them
+
+   Category columns are leading sort keys: rows of a category are
+   therefore contiguous in the sorted row set.
+
+   \param table pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS openchangedb_table_build_rows(struct openchangedb_table *table,
+						     struct ldb_context *ldb_ctx)
+{
+	struct openchangedb_table_row	*row;
+	char				*ldb_filter;
 	const char * const		attrs[] = { "*", NULL };
-	const char			*PidTagAttr = NULL, *childIdAttr;
-	uint64_t			*row_fmid;
+	const char			*childIdAttr;
+	uint32_t			i;
+	uint32_t			j;
 	int				ret;
 
-	/* Sanity checks */
-	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
-	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
-	OPENCHANGE_RETVAL_IF(!data, MAPI_E_NOT_INITIALIZED, NULL);
+	ldb_filter = openchangedb_table_build_filter(NULL, table);
+	OPENCHANGE_RETVAL_IF(!ldb_filter, MAPI_E_INVALID_OBJECT, NULL);
+	DEBUG(5, ("[%s:%d]: ldb_filter = %s\n", __FUNCTION__, __LINE__, ldb_filter));
+	ret = ldb_search(ldb_ctx, (TALLOC_CTX *)table, &table->res, ldb_get_default_basedn(ldb_ctx), LDB_SCOPE_SUBTREE, attrs, "%s", ldb_filter);
+	talloc_free(ldb_filter);
+	OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_INVALID_OBJECT, NULL);
 
-	table = (struct openchangedb_table *)table_object;
+	childIdAttr = (table->table_type == 0x1) ? "PidTagFolderId" : "PidTagMessageId";
 
-	/* Fetch results */
-	if (!table->res) {
-		/* Build ldb filter */
-		if (live_filtered) {
-			ldb_filter = openchangedb_table_build_filter(NULL, table, 0, NULL);
-			DEBUG(0, ("(live-filtered) ldb_filter = %s\n", ldb_filter));
+	table->row_count = table->res->count;
+	table->rows = talloc_array(table->res, struct openchangedb_table_row *, table->row_count + 1);
+	table->index = talloc_array(table->res, struct openchangedb_table_row *, table->row_count + 1);
+	OPENCHANGE_RETVAL_IF(!table->rows || !table->index, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	for (i = 0; i < table->row_count; i++) {
+		row = talloc_zero(table->rows, struct openchangedb_table_row);
+		OPENCHANGE_RETVAL_IF(!row, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		row->msg = table->res->msgs[i];
+		row->fmid = ldb_msg_find_attr_as_uint64(row->msg, childIdAttr, 0x0);
+		row->ldb_index = i;
+		row->sort = table->lpSortCriteria;
+		if (row->sort && row->sort->cSorts) {
+			row->keys = talloc_array(row, struct openchangedb_table_value, row->sort->cSorts);
+			OPENCHANGE_RETVAL_IF(!row->keys, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+			for (j = 0; j < row->sort->cSorts; j++) {
+				openchangedb_table_get_value(row->keys, table, row->msg, row->sort->aSort[j].ulPropTag, &row->keys[j]);
+			}
+		}
+		table->rows[i] = row;
+		table->index[i] = row;
+	}
+
+	if (table->lpSortCriteria && table->lpSortCriteria->cSorts) {
+		qsort(table->rows, table->row_count, sizeof (struct openchangedb_table_row *), openchangedb_table_row_cmp);
+	}
+	for (i = 0; i < table->row_count; i++) {
+		table->rows[i]->position = i;
+	}
+	qsort(table->index, table->row_count, sizeof (struct openchangedb_table_row *), openchangedb_table_fmid_cmp);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Evaluate the table restrictions against the sorted rows
+
+   \param table pointer to the table object
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS openchangedb_table_build_view(struct openchangedb_table *table)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct openchangedb_table_row	*row;
+	uint32_t			i;
+
+	table->view = talloc_array(table->res, struct openchangedb_table_row *, table->row_count + 1);
+	OPENCHANGE_RETVAL_IF(!table->view, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	table->view_count = 0;
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_table_build_view");
+	for (i = 0; i < table->row_count; i++) {
+		row = table->rows[i];
+		row->match = table->restrictions ? openchangedb_table_match(mem_ctx, table, row->msg, table->restrictions) : true;
+		if (row->match) {
+			row->view_position = table->view_count;
+			table->view[table->view_count++] = row;
 		}
 		else {
-			ldb_filter = openchangedb_table_build_filter(NULL, table, 0, table->restrictions);
-			DEBUG(0, ("(pre-filtered) ldb_filter = %s\n", ldb_filter));
+			row->view_position = (uint32_t) -1;
 		}
-		OPENCHANGE_RETVAL_IF(!ldb_filter, MAPI_E_TOO_COMPLEX, NULL);
-		ret = ldb_search(ldb_ctx, (TALLOC_CTX *)table_object, &table->res, ldb_get_default_basedn(ldb_ctx), LDB_SCOPE_SUBTREE, attrs, ldb_filter, NULL);
-		talloc_free(ldb_filter);
-		OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS, MAPI_E_INVALID_OBJECT, NULL);
+		talloc_free_children(mem_ctx);
 	}
-	res = table->res;
+	talloc_free(mem_ctx);
 
-	/* Ensure position is within search results range */
-	OPENCHANGE_RETVAL_IF(pos >= res->count, MAPI_E_INVALID_OBJECT, NULL);
+	DEBUG(5, ("[%s:%d]: %d rows, %d matching restrictions\n", __FUNCTION__, __LINE__, table->row_count, table->view_count));
 
-	/* If live filtering, make sure the specified row match the restrictions */
-	if (live_filtered) {
-		TALLOC_CTX *local_mem_ctx;
+	return MAPI_E_SUCCESS;
+}
 
-		switch (table->table_type) {
-		case 0x3 /* EMSMDBP_TABLE_FAI_TYPE */:
-		case 0x2 /* EMSMDBP_TABLE_MESSAGE_TYPE */:
-			childIdAttr = "PidTagMessageId";
-			break;
-		case 0x1 /* EMSMDBP_TABLE_FOLDER_TYPE */:
-			childIdAttr = "PidTagFolderId";
-			break;
-		default:
-			DEBUG(0, ("unsupported table type for openchangedb: %d\n", table->table_type));
-			abort();
+
+/**
+   \details Compute the sorted and restricted view of an openchangedb
+   table if needed
+
+   Records are fetched and sorted once, until the sort order changes
+   or the database is modified, and restrictions are evaluated once,
+   until they change. Modifications are detected with the LDB sequence
+   number, which is bumped on every write to openchangedb; when it
+   cannot be read, rows are fetched again on each call.
+
+   \param table pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS openchangedb_table_materialize(struct openchangedb_table *table,
+						      struct ldb_context *ldb_ctx)
+{
+	enum MAPISTATUS		retval;
+	uint64_t		seq_num = 0;
+	int			ret;
+
+	ret = ldb_sequence_number(ldb_ctx, LDB_SEQ_HIGHEST_SEQ, &seq_num);
+	if (table->res && (ret != LDB_SUCCESS || seq_num != table->seq_num)) {
+		DEBUG(5, ("[%s:%d]: openchangedb modified, fetching rows again\n", __FUNCTION__, __LINE__));
+		openchangedb_table_reset_rows(table);
+	}
+
+	if (!table->res) {
+		table->seq_num = seq_num;
+		retval = openchangedb_table_build_rows(table, ldb_ctx);
+		if (retval) {
+			openchangedb_table_reset_rows(table);
+			return retval;
 		}
-		row_fmid = openchangedb_get_property_data(mem_ctx, res, pos, PR_MID, childIdAttr);
-		if (!row_fmid || !*row_fmid) {
-			DEBUG(0, ("ldb object must have a '%s' field\n", childIdAttr));
-			abort();
+	}
+
+	if (!table->view) {
+		retval = openchangedb_table_build_view(table);
+		if (retval) {
+			openchangedb_table_reset_view(table);
+			return retval;
 		}
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the number of rows matching the restrictions of
+   an openchangedb table
+
+   \param table_object pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+   \param row_count pointer to the number of rows to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_table_get_row_count(void *table_object,
+							  struct ldb_context *ldb_ctx,
+							  uint32_t *row_count)
+{
+	struct openchangedb_table	*table;
+	enum MAPISTATUS			retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!row_count, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = (struct openchangedb_table *)table_object;
+
+	retval = openchangedb_table_materialize(table, ldb_ctx);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	*row_count = table->view_count;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the position of a row in an openchangedb table
+
+   \param table_object pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+   \param fmid the folder or message identifier of the row
+   \param live_filtered whether the position is in the whole sorted
+   row set or in the set of rows matching the restrictions
+   \param pos pointer to the position to return
 
-		local_mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if the row is
+   not in the table, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_table_get_row_position(void *table_object,
+							     struct ldb_context *ldb_ctx,
+							     uint64_t fmid,
+							     bool live_filtered,
+							     uint32_t *pos)
+{
+	struct openchangedb_table	*table;
+	struct openchangedb_table_row	key;
+	struct openchangedb_table_row	*keyp = &key;
+	struct openchangedb_table_row	**row;
+	enum MAPISTATUS			retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!pos, MAPI_E_INVALID_PARAMETER, NULL);
 
-		ldb_filter = openchangedb_table_build_filter(local_mem_ctx, table, *row_fmid, table->restrictions);
-		OPENCHANGE_RETVAL_IF(!ldb_filter, MAPI_E_TOO_COMPLEX, NULL);
-		DEBUG(0, ("  row ldb_filter = %s\n", ldb_filter));
-		ret = ldb_search(ldb_ctx, local_mem_ctx, &live_res, ldb_get_default_basedn(ldb_ctx), LDB_SCOPE_SUBTREE, attrs, ldb_filter, NULL);
-		OPENCHANGE_RETVAL_IF(ret != LDB_SUCCESS || live_res->count == 0, MAPI_E_INVALID_OBJECT, local_mem_ctx);
-		talloc_free(local_mem_ctx);
+	table = (struct openchangedb_table *)table_object;
+
+	retval = openchangedb_table_materialize(table, ldb_ctx);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	key.fmid = fmid;
+	row = bsearch(&keyp, table->index, table->row_count, sizeof (struct openchangedb_table_row *), openchangedb_table_fmid_cmp);
+	OPENCHANGE_RETVAL_IF(!row, MAPI_E_NOT_FOUND, NULL);
+
+	if (live_filtered) {
+		*pos = (*row)->position;
+	}
+	else {
+		OPENCHANGE_RETVAL_IF(!(*row)->match, MAPI_E_NOT_FOUND, NULL);
+		*pos = (*row)->view_position;
 	}
 
-	/* hacks for some attributes specific to tables */
-	if (proptag == PR_INST_ID) {
-		if (table->table_type == 1) {
-			proptag = PR_FID;
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Find the next row matching a restriction in an openchangedb
+   table
+
+   Only rows matching the table restrictions are examined and
+   positions are within this set of rows.
+
+   \param table_object pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+   \param res pointer to the restriction rows must match
+   \param flags the search direction (DIR_FORWARD or DIR_BACKWARD)
+   \param start the position of the first row to examine
+   \param pos pointer to the position of the matching row to return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if no row
+   matches, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_table_find_row(void *table_object,
+						     struct ldb_context *ldb_ctx,
+						     struct mapi_SRestriction *res,
+						     enum FindRow_ulFlags flags,
+						     uint32_t start,
+						     uint32_t *pos)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct openchangedb_table	*table;
+	enum MAPISTATUS			retval;
+	uint32_t			i;
+	bool				found;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!res, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!pos, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = (struct openchangedb_table *)table_object;
+
+	retval = openchangedb_table_materialize(table, ldb_ctx);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	OPENCHANGE_RETVAL_IF(start >= table->view_count, MAPI_E_NOT_FOUND, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "openchangedb_table_find_row");
+	i = start;
+	for (;;) {
+		found = openchangedb_table_match(mem_ctx, table, table->view[i]->msg, res);
+		talloc_free_children(mem_ctx);
+		if (found) break;
+
+		if (flags & DIR_BACKWARD) {
+			if (i == 0) break;
+			i--;
 		}
 		else {
-			proptag = PR_MID;
+			if (i + 1 >= table->view_count) break;
+			i++;
 		}
 	}
-	else if (proptag == PR_INSTANCE_NUM) {
+	talloc_free(mem_ctx);
+
+	OPENCHANGE_RETVAL_IF(!found, MAPI_E_NOT_FOUND, NULL);
+	*pos = i;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve a property from a row of an openchangedb table
+
+   Pre-filtered queries address the rows matching the restrictions.
+   Live-filtered queries address the whole sorted row set and fail
+   with MAPI_E_INVALID_OBJECT on rows not matching the restrictions.
+
+   \param mem_ctx pointer to the memory context
+   \param table_object pointer to the table object
+   \param ldb_ctx pointer to the openchange LDB context
+   \param proptag the property to retrieve
+   \param pos the row position
+   \param live_filtered the type of query
+   \param data pointer on pointer to the property value to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS openchangedb_table_get_property(TALLOC_CTX *mem_ctx,
+							 void *table_object,
+							 struct ldb_context *ldb_ctx,
+							 enum MAPITAGS proptag,
+							 uint32_t pos,
+							 bool live_filtered,
+							 void **data)
+{
+	struct openchangedb_table	*table;
+	struct openchangedb_table_row	*row;
+	const char			*PidTagAttr = NULL;
+	uint32_t			tag;
+	enum MAPISTATUS			retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!ldb_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!data, MAPI_E_NOT_INITIALIZED, NULL);
+
+	table = (struct openchangedb_table *)table_object;
+
+	/* Fetch, sort and filter results */
+	retval = openchangedb_table_materialize(table, ldb_ctx);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* Ensure position is within results range and, if live
+	 * filtering, make sure the specified row match the
+	 * restrictions */
+	if (live_filtered) {
+		OPENCHANGE_RETVAL_IF(pos >= table->row_count, MAPI_E_INVALID_OBJECT, NULL);
+		row = table->rows[pos];
+		OPENCHANGE_RETVAL_IF(!row->match, MAPI_E_INVALID_OBJECT, NULL);
+	}
+	else {
+		OPENCHANGE_RETVAL_IF(pos >= table->view_count, MAPI_E_INVALID_OBJECT, NULL);
+		row = table->view[pos];
+	}
+
+	if (proptag == PR_INSTANCE_NUM) {
 		*data = talloc_zero(mem_ctx, uint32_t);
 		return MAPI_E_SUCCESS;
 	}
 
 	/* Convert proptag into PidTag attribute */
-	if ((table->table_type != 0x1) && proptag == PR_FID) {
-		proptag = PR_PARENT_FID;
-	}
-	PidTagAttr = openchangedb_property_get_attribute(proptag);
+	tag = proptag;
+	PidTagAttr = openchangedb_table_get_attribute(table, &tag);
 	OPENCHANGE_RETVAL_IF(!PidTagAttr, MAPI_E_NOT_FOUND, NULL);
 
 	/* Ensure the element exists */
-	OPENCHANGE_RETVAL_IF(!ldb_msg_find_element(res->msgs[pos], PidTagAttr), MAPI_E_NOT_FOUND, NULL);
+	OPENCHANGE_RETVAL_IF(!ldb_msg_find_element(row->msg, PidTagAttr), MAPI_E_NOT_FOUND, NULL);
 
 	/* Check if this is a "special property" */
-	*data = openchangedb_get_special_property(mem_ctx, ldb_ctx, res, proptag, PidTagAttr);
+	*data = openchangedb_get_special_property(mem_ctx, ldb_ctx, table->res, tag, PidTagAttr);
 	OPENCHANGE_RETVAL_IF(*data != NULL, MAPI_E_SUCCESS, NULL);
 
 	/* Check if this is NOT a "special property" */
-	*data = openchangedb_get_property_data(mem_ctx, res, pos, proptag, PidTagAttr);
+	*data = openchangedb_get_property_data_message(mem_ctx, row->msg, tag, PidTagAttr);
 	OPENCHANGE_RETVAL_IF(*data != NULL, MAPI_E_SUCCESS, NULL);
 
 	return MAPI_E_NOT_FOUND;
@@ -143,6 +143,12 @@
  */
 #define	SIZE_DFLT_ROPSETMESSAGEREADFLAG		1
 
+/**
+   \details: SetReadFlagsRop has fixed response size for:
+   -# PartialCompletion: uint8_t
+ */
+#define	SIZE_DFLT_ROPSETREADFLAGS		1
+
 /**
    \details: CreateAttachRop has fixed response size for:
    -# AttachmentId: uint32_t
@@ -185,6 +191,12 @@
  */
 #define	SIZE_DFLT_ROPQUERYROWS			3
 
+/**
+   \details GetStatusRop has fixed response size for:
+   -# TableStatus: uint8_t
+ */
+#define	SIZE_DFLT_ROPGETSTATUS			1
+
 /**
    \details QueryPositionRop has fixed response size for:
    -# Numerator: uint32_t
@@ -199,6 +211,20 @@
  */
 #define	SIZE_DFLT_ROPSEEKROW			5
 
+/**
+   \details SeekRowBookmark has fixed response size for:
+   -# RowNoLongerVisible: uint8_t
+   -# HasSoughtLess: uint8_t
+   -# RowsSought: uint32_t
+ */
+#define	SIZE_DFLT_ROPSEEKROWBOOKMARK		6
+
+/**
+   \details CreateBookmark has fixed response size for:
+   -# BookmarkSize: uint16_t
+ */
+#define	SIZE_DFLT_ROPCREATEBOOKMARK		2
+
 /**
    \details CreateFolderRop has fixed response size for:
    -# folder_id: uint64_t
@@ -243,6 +269,19 @@
  */
 #define	SIZE_DFLT_ROPSEEKSTREAM 		8
 
+/**
+   \details CopyToStream has fixed response size for:
+   -# ReadByteCount: uint64_t
+   -# WrittenByteCount: uint64_t
+ */
+#define	SIZE_DFLT_ROPCOPYTOSTREAM		16
+
+/**
+   \details WriteAndCommitStream has fixed response size for:
+   -# WrittenSize: uint16_t
+ */
+#define	SIZE_DFLT_ROPWRITEANDCOMMITSTREAM	2
+
 /**
    \details GetReceiveFolder has fixed response size for:
    -# folder_id: uint64_t
@@ -283,6 +322,37 @@
  */
 #define	SIZE_DFLT_ROPFINDROW			2
 
+/**
+   \details AbortRop has fixed response size for:
+   -# TableStatus: uint8_t
+ */
+#define	SIZE_DFLT_ROPABORT			1
+
+/**
+   \details ExpandRow has fixed response size for:
+   -# ExpandedRowCount: uint32_t
+   -# RowCount: uint16_t
+ */
+#define	SIZE_DFLT_ROPEXPANDROW			6
+
+/**
+   \details CollapseRow has fixed response size for:
+   -# CollapsedRowCount: uint32_t
+ */
+#define	SIZE_DFLT_ROPCOLLAPSEROW		4
+
+/**
+   \details GetCollapseState has fixed response size for:
+   -# CollapseStateSize: uint16_t
+ */
+#define	SIZE_DFLT_ROPGETCOLLAPSESTATE		2
+
+/**
+   \details SetCollapseState has fixed response size for:
+   -# BookmarkSize: uint16_t
+ */
+#define	SIZE_DFLT_ROPSETCOLLAPSESTATE		2
+
 /**
    \details GetNamesFromIDs has fixed response size for:
    -# PropertyNameCount: uint16_t
@@ -328,6 +398,18 @@
 */
 #define SIZE_DFLT_ROPCOPYFOLDER                 1 
 
+/**
+   \details HardDeleteMessages Rop has fixed response size for:
+   -# PartialCompletion: uint8_t
+ */
+#define	SIZE_DFLT_ROPHARDDELETEMESSAGES		1
+
+/**
+   \details HardDeleteMessagesAndSubfolders Rop has fixed response size for:
+   -# PartialCompletion: uint8_t
+ */
+#define	SIZE_DFLT_ROPHARDDELETEMESSAGESANDSUBFOLDERS	1
+
 /**
    \details DeleteMessage Rop has fixed response size for:
    -# PartialCompletion: uint8_t
@@ -449,6 +531,16 @@
  */
 #define SIZE_DFLT_ROPFASTTRANSFERSOURCEGETBUFFER 9
 
+/**
+   \details FastTransferDestinationPutBuffer has a fixed size for:
+   -# TransferStatus: uint16_t
+   -# InProgressCount: uint16_t
+   -# TotalStepCount: uint16_t
+   -# Reserved (1 byte): uint8_t
+   -# BufferUsedCount: uint16_t
+ */
+#define SIZE_DFLT_ROPFASTTRANSFERDESTINATIONPUTBUFFER 9
+
 /**
    \details SyncImportMessageChange has a fixed size for:
    -# FolderId: uint64_t
@@ -489,6 +581,8 @@ uint16_t libmapiserver_RopEmptyFolder_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopMoveCopyMessages_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopMoveFolder_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopCopyFolder_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopHardDeleteMessages_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopHardDeleteMessagesAndSubfolders_size(struct EcDoRpc_MAPI_REPL *);
 
 
 /* definitions from libmapiserver_oxcmsg.c */
@@ -504,6 +598,7 @@ uint16_t libmapiserver_RopOpenAttach_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopCreateAttach_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSaveChangesAttachment_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopOpenEmbeddedMessage_size(struct EcDoRpc_MAPI_REPL *response);
+uint16_t libmapiserver_RopSetReadFlags_size(struct EcDoRpc_MAPI_REPL *);
 
 /* definitions from libmapiserver_oxcnotif.c */
 uint16_t libmapiserver_RopRegisterNotification_size(void);
@@ -529,6 +624,11 @@ uint16_t libmapiserver_RopCommitStream_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopGetStreamSize_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSeekStream_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSetStreamSize_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopCopyToStream_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopCloneStream_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopLockRegionStream_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopUnlockRegionStream_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopWriteAndCommitStream_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopGetNamesFromIDs_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopGetPropertyIdsFromNames_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopDeletePropertiesNoReplicate_size(struct EcDoRpc_MAPI_REPL *);
@@ -554,10 +654,20 @@ uint16_t libmapiserver_RopSetColumns_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSortTable_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopRestrict_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopQueryRows_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopGetStatus_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopQueryPosition_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSeekRow_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopSeekRowBookmark_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopSeekRowApprox_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopCreateBookmark_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopAbort_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopFindRow_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopResetTable_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFreeBookmark_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopExpandRow_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopCollapseRow_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopGetCollapseState_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopSetCollapseState_size(struct EcDoRpc_MAPI_REPL *);
 
 /* definitions from libmapiserver_oxomsg.c */
 uint16_t libmapiserver_RopSubmitMessage_size(struct EcDoRpc_MAPI_REPL *);
@@ -577,7 +687,12 @@ uint16_t libmapiserver_RopModifyPermissions_size(struct EcDoRpc_MAPI_REPL *);
 
 /* definitions from libmapiserver_oxcfxics.c */
 uint16_t libmapiserver_RopFastTransferSourceCopyTo_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFastTransferSourceCopyMessages_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFastTransferSourceCopyFolder_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFastTransferSourceCopyProperties_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopFastTransferSourceGetBuffer_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFastTransferDestinationConfigure_size(struct EcDoRpc_MAPI_REPL *);
+uint16_t libmapiserver_RopFastTransferDestinationPutBuffer_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSyncConfigure_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSyncImportMessageChange_size(struct EcDoRpc_MAPI_REPL *);
 uint16_t libmapiserver_RopSyncImportHierarchyChange_size(struct EcDoRpc_MAPI_REPL *);
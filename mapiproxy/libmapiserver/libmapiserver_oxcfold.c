@@ -293,3 +293,45 @@ uint16_t libmapiserver_RopCopyFolder_size(struct EcDoRpc_MAPI_REPL *response)
 
 	return size;
 }
+
+/**
+   \details Calculate HardDeleteMessages (0x91) Rop size
+
+   \param response pointer to the HardDeleteMessages EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of HardDeleteMessages response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopHardDeleteMessages_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPHARDDELETEMESSAGES;
+
+	return size;
+}
+
+/**
+   \details Calculate HardDeleteMessagesAndSubfolders (0x92) Rop size
+
+   \param response pointer to the HardDeleteMessagesAndSubfolders
+   EcDoRpc_MAPI_REPL structure
+
+   \return Size of HardDeleteMessagesAndSubfolders response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopHardDeleteMessagesAndSubfolders_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPHARDDELETEMESSAGESANDSUBFOLDERS;
+
+	return size;
+}
@@ -41,6 +41,48 @@ _PUBLIC_ uint16_t libmapiserver_RopFastTransferSourceCopyTo_size(struct EcDoRpc_
 }
 
 
+/**
+   \details Calculate FastTransferSourceCopyMessages (0x4b) Rop size
+
+   \param response pointer to the FastTransferSourceCopyMessages EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of FastTransferSourceCopyMessages response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFastTransferSourceCopyMessages_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+
+/**
+   \details Calculate FastTransferSourceCopyFolder (0x4c) Rop size
+
+   \param response pointer to the FastTransferSourceCopyFolder EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of FastTransferSourceCopyFolder response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFastTransferSourceCopyFolder_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+
+/**
+   \details Calculate FastTransferSourceCopyProperties (0x69) Rop size
+
+   \param response pointer to the FastTransferSourceCopyProperties EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of FastTransferSourceCopyProperties response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFastTransferSourceCopyProperties_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+
 /**
    \details Calculate FastTransferSourceGetBuffer (0x4d) Rop size
 
@@ -65,6 +107,40 @@ _PUBLIC_ uint16_t libmapiserver_RopFastTransferSourceGetBuffer_size(struct EcDoR
 	return size;
 }
 
+/**
+   \details Calculate FastTransferDestinationConfigure (0x53) Rop size
+
+   \param response pointer to the FastTransferDestinationConfigure
+   EcDoRpc_MAPI_REPL structure
+
+   \return Size of FastTransferDestinationConfigure response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFastTransferDestinationConfigure_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+/**
+   \details Calculate FastTransferDestinationPutBuffer (0x54) Rop size
+
+   \param response pointer to the FastTransferDestinationPutBuffer
+   EcDoRpc_MAPI_REPL structure
+
+   \return Size of FastTransferDestinationPutBuffer response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFastTransferDestinationPutBuffer_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPFASTTRANSFERDESTINATIONPUTBUFFER;
+
+	return size;
+}
+
 /**
    \details Calculate SyncConfigure (0x70) Rop size
 
@@ -302,3 +302,25 @@ _PUBLIC_ uint16_t libmapiserver_RopOpenEmbeddedMessage_size(struct EcDoRpc_MAPI_
         
         return size;
 }
+
+
+/**
+   \details Calculate SetReadFlags (0x66) Rop size
+
+   \param response pointer to the SetReadFlags EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of SetReadFlags response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopSetReadFlags_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPSETREADFLAGS;
+
+	return size;
+}
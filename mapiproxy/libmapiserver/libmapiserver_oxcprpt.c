@@ -311,6 +311,82 @@ _PUBLIC_ uint16_t libmapiserver_RopSetStreamSize_size(struct EcDoRpc_MAPI_REPL *
         return SIZE_DFLT_MAPI_RESPONSE;
 }
 
+/**
+   \details Calculate CopyToStream Rop size
+
+   \param response pointer to the CopyToStream EcDoRpc_MAPI_REPL structure
+
+   \return Size of CopyToStream response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopCopyToStream_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPCOPYTOSTREAM;
+
+	return size;
+}
+
+/**
+   \details Calculate CloneStream Rop size
+
+   \param response pointer to the CloneStream EcDoRpc_MAPI_REPL structure
+
+   \return Size of CloneStream response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopCloneStream_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+/**
+   \details Calculate LockRegionStream Rop size
+
+   \param response pointer to the LockRegionStream EcDoRpc_MAPI_REPL structure
+
+   \return Size of LockRegionStream response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopLockRegionStream_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+/**
+   \details Calculate UnlockRegionStream Rop size
+
+   \param response pointer to the UnlockRegionStream EcDoRpc_MAPI_REPL structure
+
+   \return Size of UnlockRegionStream response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopUnlockRegionStream_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+/**
+   \details Calculate WriteAndCommitStream Rop size
+
+   \param response pointer to the WriteAndCommitStream EcDoRpc_MAPI_REPL structure
+
+   \return Size of WriteAndCommitStream response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopWriteAndCommitStream_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPWRITEANDCOMMITSTREAM;
+
+	return size;
+}
+
 /**
    \details Calculate GetNamesFromIDs Rop size
 
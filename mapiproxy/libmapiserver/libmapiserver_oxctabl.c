@@ -116,6 +116,28 @@ _PUBLIC_ uint16_t libmapiserver_RopQueryRows_size(struct EcDoRpc_MAPI_REPL *resp
 }
 
 
+/**
+   \details Calculate GetStatus (0x16) Rop size
+
+   \param response pointer to the GetStatus EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of GetStatus response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopGetStatus_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPGETSTATUS;
+
+	return size;
+}
+
+
 /**
    \details Calculate QueryPosition Rop size
 
@@ -160,6 +182,86 @@ _PUBLIC_ uint16_t libmapiserver_RopSeekRow_size(struct EcDoRpc_MAPI_REPL *respon
 }
 
 
+/**
+   \details Calculate SeekRowBookmark (0x19) Rop size
+
+   \param response pointer to the SeekRowBookmark EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of SeekRowBookmark response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopSeekRowBookmark_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPSEEKROWBOOKMARK;
+
+	return size;
+}
+
+
+/**
+   \details Calculate SeekRowApprox (0x1a) Rop size
+
+   \param response pointer to the SeekRowApprox EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of SeekRowApprox response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopSeekRowApprox_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+
+/**
+   \details Calculate CreateBookmark (0x1b) Rop size
+
+   \param response pointer to the CreateBookmark EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of CreateBookmark response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopCreateBookmark_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPCREATEBOOKMARK;
+	size += response->u.mapi_CreateBookmark.bookmark.cb;
+
+	return size;
+}
+
+
+/**
+   \details Calculate Abort (0x38) Rop size
+
+   \param response pointer to the Abort EcDoRpc_MAPI_REPL structure
+
+   \return Size of Abort response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopAbort_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPABORT;
+
+	return size;
+}
+
+
 /**
    \details Calculate FindRow Rop size
 
@@ -196,3 +298,106 @@ _PUBLIC_ uint16_t libmapiserver_RopResetTable_size(struct EcDoRpc_MAPI_REPL *res
 {
 	return SIZE_DFLT_MAPI_RESPONSE;
 }
+
+
+/**
+   \details Calculate FreeBookmark (0x89) Rop size
+
+   \param response pointer to the FreeBookmark EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of FreeBookmark response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopFreeBookmark_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	return SIZE_DFLT_MAPI_RESPONSE;
+}
+
+
+/**
+   \details Calculate ExpandRow (0x59) Rop size
+
+   \param response pointer to the ExpandRow EcDoRpc_MAPI_REPL structure
+
+   \return Size of ExpandRow response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopExpandRow_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPEXPANDROW;
+	size += response->u.mapi_ExpandRow.RowData.length;
+
+	return size;
+}
+
+
+/**
+   \details Calculate CollapseRow (0x5a) Rop size
+
+   \param response pointer to the CollapseRow EcDoRpc_MAPI_REPL structure
+
+   \return Size of CollapseRow response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopCollapseRow_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPCOLLAPSEROW;
+
+	return size;
+}
+
+
+/**
+   \details Calculate GetCollapseState (0x6b) Rop size
+
+   \param response pointer to the GetCollapseState EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of GetCollapseState response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopGetCollapseState_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPGETCOLLAPSESTATE;
+	size += response->u.mapi_GetCollapseState.CollapseState.cb;
+
+	return size;
+}
+
+
+/**
+   \details Calculate SetCollapseState (0x6c) Rop size
+
+   \param response pointer to the SetCollapseState EcDoRpc_MAPI_REPL
+   structure
+
+   \return Size of SetCollapseState response
+ */
+_PUBLIC_ uint16_t libmapiserver_RopSetCollapseState_size(struct EcDoRpc_MAPI_REPL *response)
+{
+	uint16_t	size = SIZE_DFLT_MAPI_RESPONSE;
+
+	if (!response || response->error_code) {
+		return size;
+	}
+
+	size += SIZE_DFLT_ROPSETCOLLAPSESTATE;
+	size += response->u.mapi_SetCollapseState.bookmark.cb;
+
+	return size;
+}
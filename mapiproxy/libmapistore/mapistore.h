@@ -175,9 +175,11 @@ struct mapistore_backend {
 		enum mapistore_error	(*open_folder)(void *, TALLOC_CTX *, uint64_t, void **);
 		enum mapistore_error	(*create_folder)(void *, TALLOC_CTX *, uint64_t, struct SRow *, void **);
 		enum mapistore_error	(*delete)(void *);
+		enum mapistore_error	(*empty)(void *, TALLOC_CTX *, bool, uint8_t, struct UI8Array_r **);
 		enum mapistore_error	(*open_message)(void *, TALLOC_CTX *, uint64_t, bool, void **);
 		enum mapistore_error	(*create_message)(void *, TALLOC_CTX *, uint64_t, uint8_t, void **);
 		enum mapistore_error	(*delete_message)(void *, uint64_t, uint8_t);
+		enum mapistore_error	(*delete_messages)(void *, uint32_t, const uint64_t *, uint8_t);
 		enum mapistore_error	(*move_copy_messages)(void *, void *, TALLOC_CTX *, uint32_t, uint64_t *, uint64_t *, struct Binary_r **, uint8_t);
  		enum mapistore_error	(*move_folder)(void *, void *, TALLOC_CTX *, const char *);
  		enum mapistore_error	(*copy_folder)(void *, void *, TALLOC_CTX *, bool, const char *);
@@ -187,6 +189,7 @@ struct mapistore_backend {
 		enum mapistore_error	(*modify_permissions)(void *, uint8_t, uint16_t, struct PermissionData *);
 
 		enum mapistore_error	(*preload_message_bodies)(void *, enum mapistore_table_type, const struct UI8Array_r *);
+		enum mapistore_error	(*set_read_flags)(void *, uint8_t, uint16_t, const uint64_t *, const struct UI8Array_r *);
         } folder;
 
         /** oxcmsg operations */
@@ -214,6 +217,7 @@ struct mapistore_backend {
                 enum mapistore_error	(*get_row)(void *, TALLOC_CTX *, enum mapistore_query_type, uint32_t, struct mapistore_property_data **);
                 enum mapistore_error	(*get_row_count)(void *, enum mapistore_query_type, uint32_t *);
 		enum mapistore_error	(*handle_destructor)(void *, uint32_t);
+		enum mapistore_error	(*find_row)(void *, struct mapi_SRestriction *, enum FindRow_ulFlags, uint32_t, uint32_t *);
         } table;
 
         /** oxcprpt operations */
@@ -239,6 +243,7 @@ struct backend_context {
 	uint32_t			context_id;
 	uint32_t			ref_count;
 	char				*uri;
+	struct mapistore_context	*mstore_ctx;
 };
 
 struct backend_context_list {
@@ -255,9 +260,11 @@ struct mapistore_context {
 	struct indexing_context_list		*indexing_list;
 	struct replica_mapping_context_list	*replica_mapping_list;
 	struct mapistore_subscription_list	*subscriptions;
+	struct mapistore_subscription_index	*subscription_index;
 	struct mapistore_notification_list	*notifications;
 	struct ldb_context			*nprops_ctx;
 	struct mapistore_connection_info	*conn_info;
+	uint64_t				backend_elapsed_time;
 #if 0
 	mqd_t					mq_ipc;
 #endif
@@ -310,9 +317,11 @@ enum mapistore_error mapistore_create_root_folder(const char *, enum mapistore_c
 enum mapistore_error mapistore_folder_open_folder(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, uint64_t, void **);
 enum mapistore_error mapistore_folder_create_folder(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, uint64_t, struct SRow *, void **);
 enum mapistore_error mapistore_folder_delete(struct mapistore_context *, uint32_t, void *, uint8_t);
+enum mapistore_error mapistore_folder_empty(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, bool, uint8_t, struct UI8Array_r **);
 enum mapistore_error mapistore_folder_open_message(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, uint64_t, bool, void **);
 enum mapistore_error mapistore_folder_create_message(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, uint64_t, uint8_t, void **);
 enum mapistore_error mapistore_folder_delete_message(struct mapistore_context *, uint32_t, void *, uint64_t, uint8_t);
+enum mapistore_error mapistore_folder_delete_messages(struct mapistore_context *, uint32_t, void *, uint32_t, const uint64_t *, uint8_t);
 enum mapistore_error mapistore_folder_move_copy_messages(struct mapistore_context *, uint32_t, void *, void *, TALLOC_CTX *, uint32_t, uint64_t *, uint64_t *, struct Binary_r **, uint8_t);
 enum mapistore_error mapistore_folder_move_folder(struct mapistore_context *, uint32_t, void *, void *, TALLOC_CTX *, const char *);
 enum mapistore_error mapistore_folder_copy_folder(struct mapistore_context *, uint32_t, void *, void *, TALLOC_CTX *, bool, const char *);
@@ -323,6 +332,8 @@ enum mapistore_error mapistore_folder_get_child_fid_by_name(struct mapistore_con
 enum mapistore_error mapistore_folder_open_table(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, enum mapistore_table_type, uint32_t, void **, uint32_t *);
 enum mapistore_error mapistore_folder_modify_permissions(struct mapistore_context *, uint32_t, void *, uint8_t, uint16_t, struct PermissionData *);
 enum mapistore_error mapistore_folder_preload_message_bodies(struct mapistore_context *, uint32_t, void *, enum mapistore_table_type, const struct UI8Array_r *);
+bool mapistore_folder_has_set_read_flags(struct mapistore_context *, uint32_t);
+enum mapistore_error mapistore_folder_set_read_flags(struct mapistore_context *, uint32_t, void *, uint8_t, uint16_t, const uint64_t *, const struct UI8Array_r *);
 enum mapistore_error mapistore_folder_fetch_freebusy_properties(struct mapistore_context *, uint32_t, void *, struct tm *, struct tm *, TALLOC_CTX *, struct mapistore_freebusy_properties **);
 
 enum mapistore_error mapistore_message_get_message_data(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, struct mapistore_message **);
@@ -343,6 +354,7 @@ enum mapistore_error mapistore_table_set_sort_order(struct mapistore_context *,
 enum mapistore_error mapistore_table_get_row(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, enum mapistore_query_type, uint32_t, struct mapistore_property_data **);
 enum mapistore_error mapistore_table_get_row_count(struct mapistore_context *, uint32_t, void *, enum mapistore_query_type, uint32_t *);
 enum mapistore_error mapistore_table_handle_destructor(struct mapistore_context *, uint32_t, void *, uint32_t);
+enum mapistore_error mapistore_table_find_row(struct mapistore_context *, uint32_t, void *, struct mapi_SRestriction *, enum FindRow_ulFlags, uint32_t, uint32_t *);
 
 enum mapistore_error mapistore_properties_get_available_properties(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, struct SPropTagArray **);
 enum mapistore_error mapistore_properties_get_properties(struct mapistore_context *, uint32_t, void *, TALLOC_CTX *, uint16_t, enum MAPITAGS *, struct mapistore_property_data *);
@@ -362,6 +374,8 @@ struct backend_context *mapistore_backend_lookup(struct backend_context_list *,
 struct backend_context *mapistore_backend_lookup_by_uri(struct backend_context_list *, const char *);
 struct backend_context *mapistore_backend_lookup_by_name(TALLOC_CTX *, const char *);
 bool		mapistore_backend_run_init(init_backend_fn *);
+uint64_t	mapistore_backend_get_elapsed_time(struct mapistore_context *);
+void		mapistore_backend_set_timing(bool);
 
 /* definitions from mapistore_backend_defaults */
 enum mapistore_error mapistore_backend_init_defaults(struct mapistore_backend *);
@@ -371,6 +385,8 @@ enum mapistore_error mapistore_indexing_record_add_fid(struct mapistore_context
 enum mapistore_error mapistore_indexing_record_del_fid(struct mapistore_context *, uint32_t, const char *, uint64_t, uint8_t);
 enum mapistore_error mapistore_indexing_record_add_mid(struct mapistore_context *, uint32_t, const char *, uint64_t);
 enum mapistore_error mapistore_indexing_record_del_mid(struct mapistore_context *, uint32_t, const char *, uint64_t, uint8_t);
+enum mapistore_error mapistore_indexing_record_del_mids(struct mapistore_context *, uint32_t, const char *, uint32_t, const uint64_t *, uint8_t);
+enum mapistore_error mapistore_indexing_record_del_fmids(struct mapistore_context *, uint32_t, const char *, uint32_t, const uint64_t *, uint8_t);
 enum mapistore_error mapistore_indexing_record_get_uri(struct mapistore_context *, const char *, TALLOC_CTX *, uint64_t, char **, bool *);
 enum mapistore_error mapistore_indexing_record_get_fmid(struct mapistore_context *, const char *, const char *, bool, uint64_t *, bool *);
 
@@ -429,6 +445,7 @@ struct mapistore_subscription {
 };
 
 struct mapistore_subscription *mapistore_new_subscription(TALLOC_CTX *, struct mapistore_context *, const char *, uint32_t, uint16_t, void *);
+enum mapistore_error mapistore_add_subscription(struct mapistore_context *, struct mapistore_subscription_list *);
 
 /* notifications (implementation) */
 
@@ -24,6 +24,7 @@
  */
 
 #include <sys/types.h>
+#include <time.h>
 #include <string.h>
 #include <dlfcn.h>
 #include <dirent.h>
@@ -49,6 +50,59 @@ static struct mstore_backend {
 
 int					num_backends;
 
+static bool				backend_timing = false;
+
+static inline uint64_t backend_timer_start(void)
+{
+	struct timespec	ts;
+
+	if (backend_timing == false) return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline enum mapistore_error backend_timer_stop(struct backend_context *bctx, uint64_t tv_start, enum mapistore_error ret)
+{
+	if (backend_timing == false || !bctx->mstore_ctx) return ret;
+
+	bctx->mstore_ctx->backend_elapsed_time += backend_timer_start() - tv_start;
+
+	return ret;
+}
+
+
+/**
+   \details Enable or disable the measurement of the time spent inside
+   backend operations
+
+   Timing is disabled by default so backend calls do not pay for clock
+   reads when nobody collects the figures.
+
+   \param enabled true to enable timing, false to disable it
+ */
+_PUBLIC_ void mapistore_backend_set_timing(bool enabled)
+{
+	backend_timing = enabled;
+}
+
+
+/**
+   \details Return the cumulated time spent inside backend operations
+   on behalf of a mapistore context
+
+   \param mstore_ctx pointer to the mapistore context
+
+   \return elapsed time in microseconds
+ */
+_PUBLIC_ uint64_t mapistore_backend_get_elapsed_time(struct mapistore_context *mstore_ctx)
+{
+	if (!mstore_ctx) return 0;
+
+	return mstore_ctx->backend_elapsed_time;
+}
+
 
 /**
    \details Register mapistore backends
@@ -369,6 +423,7 @@ enum mapistore_error mapistore_backend_create_context(TALLOC_CTX *mem_ctx, struc
 	}
 
 	context->ref_count = 1;
+	context->mstore_ctx = conn_info->mstore_ctx;
 	context->uri = talloc_asprintf(context, "%s%s", namespace, uri);
 	*context_p = context;
 
@@ -520,8 +575,9 @@ enum mapistore_error mapistore_backend_get_path(struct backend_context *bctx, TA
 {
 	enum mapistore_error	ret;
 	char			*bpath = NULL;
+	uint64_t		tv_start = backend_timer_start();
 
-	ret = bctx->backend->context.get_path(bctx->backend_object, mem_ctx, fmid, &bpath);
+	ret = backend_timer_stop(bctx, tv_start, bctx->backend->context.get_path(bctx->backend_object, mem_ctx, fmid, &bpath));
 
 	if (!ret) {
 		*path = talloc_asprintf(mem_ctx, "%s%s", bctx->backend->backend.namespace, bpath);
@@ -534,59 +590,110 @@ enum mapistore_error mapistore_backend_get_path(struct backend_context *bctx, TA
 
 enum mapistore_error mapistore_backend_folder_open_folder(struct backend_context *bctx, void *folder, TALLOC_CTX *mem_ctx, uint64_t fid, void **child_folder)
 {
-	return bctx->backend->folder.open_folder(folder, mem_ctx, fid, child_folder);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.open_folder(folder, mem_ctx, fid, child_folder));
 }
 
 enum mapistore_error mapistore_backend_folder_create_folder(struct backend_context *bctx, void *folder,
 					   TALLOC_CTX *mem_ctx, uint64_t fid, struct SRow *aRow, void **child_folder)
 {
-	return bctx->backend->folder.create_folder(folder, mem_ctx, fid, aRow, child_folder);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.create_folder(folder, mem_ctx, fid, aRow, child_folder));
 }
 
 enum mapistore_error mapistore_backend_folder_delete(struct backend_context *bctx, void *folder)
 {
-	return bctx->backend->folder.delete(folder);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.delete(folder));
+}
+
+enum mapistore_error mapistore_backend_folder_empty(struct backend_context *bctx, void *folder, TALLOC_CTX *mem_ctx,
+						    bool delete_associated, uint8_t flags, struct UI8Array_r **fmidsp)
+{
+        uint64_t	tv_start;
+
+        /* empty is optional, backends registered without
+         * mapistore_backend_init_defaults may not provide it */
+        if (!bctx->backend->folder.empty) {
+                return MAPISTORE_ERR_NOT_IMPLEMENTED;
+        }
+
+        tv_start = backend_timer_start();
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.empty(folder, mem_ctx, delete_associated, flags, fmidsp));
 }
 
 enum mapistore_error mapistore_backend_folder_open_message(struct backend_context *bctx, void *folder,
 					  TALLOC_CTX *mem_ctx, uint64_t mid, bool read_write, void **messagep)
 {
-	return bctx->backend->folder.open_message(folder, mem_ctx, mid, read_write, messagep);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.open_message(folder, mem_ctx, mid, read_write, messagep));
 }
 
 enum mapistore_error mapistore_backend_folder_create_message(struct backend_context *bctx, void *folder, TALLOC_CTX *mem_ctx, uint64_t mid, uint8_t associated, void **messagep)
 {
-	return bctx->backend->folder.create_message(folder, mem_ctx, mid, associated, messagep);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.create_message(folder, mem_ctx, mid, associated, messagep));
 }
 
 enum mapistore_error mapistore_backend_folder_delete_message(struct backend_context *bctx, void *folder, uint64_t mid, uint8_t flags)
 {
-        return bctx->backend->folder.delete_message(folder, mid, flags);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.delete_message(folder, mid, flags));
+}
+
+enum mapistore_error mapistore_backend_folder_delete_messages(struct backend_context *bctx, void *folder, uint32_t count, const uint64_t *mids, uint8_t flags)
+{
+        uint64_t	tv_start;
+
+        /* delete_messages is optional, backends registered without
+         * mapistore_backend_init_defaults may not provide it */
+        if (!bctx->backend->folder.delete_messages) {
+                return MAPISTORE_ERR_NOT_IMPLEMENTED;
+        }
+
+        tv_start = backend_timer_start();
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.delete_messages(folder, count, mids, flags));
 }
 
 enum mapistore_error mapistore_backend_folder_move_copy_messages(struct backend_context *bctx, void *target_folder, void *source_folder, TALLOC_CTX *mem_ctx, uint32_t mid_count, uint64_t *source_mids, uint64_t *target_mids, struct Binary_r **target_change_keys, uint8_t want_copy)
 {
-	return bctx->backend->folder.move_copy_messages(target_folder, source_folder, mem_ctx, mid_count, source_mids, target_mids, target_change_keys, want_copy);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.move_copy_messages(target_folder, source_folder, mem_ctx, mid_count, source_mids, target_mids, target_change_keys, want_copy));
 }
 
 enum mapistore_error mapistore_backend_folder_move_folder(struct backend_context *bctx, void *move_folder, void *target_folder, TALLOC_CTX *mem_ctx, const char *new_folder_name)
 {
-        return bctx->backend->folder.move_folder(move_folder, target_folder, mem_ctx, new_folder_name);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.move_folder(move_folder, target_folder, mem_ctx, new_folder_name));
 }
 
 enum mapistore_error mapistore_backend_folder_copy_folder(struct backend_context *bctx, void *move_folder, void *target_folder, TALLOC_CTX *mem_ctx, bool recursive, const char *new_folder_name)
 {
-        return bctx->backend->folder.copy_folder(move_folder, target_folder, mem_ctx, recursive, new_folder_name);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.copy_folder(move_folder, target_folder, mem_ctx, recursive, new_folder_name));
 }
 
 enum mapistore_error mapistore_backend_folder_get_deleted_fmids(struct backend_context *bctx, void *folder, TALLOC_CTX *mem_ctx, enum mapistore_table_type table_type, uint64_t change_num, struct UI8Array_r **fmidsp, uint64_t *cnp)
 {
-        return bctx->backend->folder.get_deleted_fmids(folder, mem_ctx, table_type, change_num, fmidsp, cnp);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.get_deleted_fmids(folder, mem_ctx, table_type, change_num, fmidsp, cnp));
 }
 
 enum mapistore_error mapistore_backend_folder_get_child_count(struct backend_context *bctx, void *folder, enum mapistore_table_type table_type, uint32_t *RowCount)
 {
-	return bctx->backend->folder.get_child_count(folder, table_type, RowCount);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->folder.get_child_count(folder, table_type, RowCount));
 }
 
 enum mapistore_error mapistore_backend_folder_get_child_fid_by_name(struct backend_context *bctx, void *folder, const char *name, uint64_t *fidp)
@@ -634,110 +741,185 @@ enum mapistore_error mapistore_backend_folder_get_child_fid_by_name(struct backe
 enum mapistore_error mapistore_backend_folder_open_table(struct backend_context *bctx, void *folder,
 							 TALLOC_CTX *mem_ctx, enum mapistore_table_type table_type, uint32_t handle_id, void **table, uint32_t *row_count)
 {
-        return bctx->backend->folder.open_table(folder, mem_ctx, table_type, handle_id, table, row_count);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.open_table(folder, mem_ctx, table_type, handle_id, table, row_count));
 }
 
 enum mapistore_error mapistore_backend_folder_modify_permissions(struct backend_context *bctx, void *folder,
 						uint8_t flags, uint16_t pcount, struct PermissionData *permissions)
 {
-        return bctx->backend->folder.modify_permissions(folder, flags, pcount, permissions);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.modify_permissions(folder, flags, pcount, permissions));
 }
 
 enum mapistore_error mapistore_backend_folder_preload_message_bodies(struct backend_context *bctx, void *folder, enum mapistore_table_type table_type, const struct UI8Array_r *mids)
 {
-        return bctx->backend->folder.preload_message_bodies(folder, table_type, mids);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.preload_message_bodies(folder, table_type, mids));
+}
+
+bool mapistore_backend_folder_has_set_read_flags(struct backend_context *bctx)
+{
+        return (bctx->backend->folder.set_read_flags != NULL);
+}
+
+enum mapistore_error mapistore_backend_folder_set_read_flags(struct backend_context *bctx, void *folder, uint8_t flags,
+							     uint16_t mid_count, const uint64_t *mids, const struct UI8Array_r *cns)
+{
+        uint64_t	tv_start;
+
+        /* set_read_flags is optional and has no default */
+        if (!bctx->backend->folder.set_read_flags) {
+                return MAPISTORE_ERR_NOT_IMPLEMENTED;
+        }
+
+        tv_start = backend_timer_start();
+        return backend_timer_stop(bctx, tv_start, bctx->backend->folder.set_read_flags(folder, flags, mid_count, mids, cns));
 }
 
 enum mapistore_error mapistore_backend_message_get_message_data(struct backend_context *bctx, void *message, TALLOC_CTX *mem_ctx, struct mapistore_message **msg)
 {
-	return bctx->backend->message.get_message_data(message, mem_ctx, msg);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->message.get_message_data(message, mem_ctx, msg));
 }
 
 enum mapistore_error mapistore_backend_message_modify_recipients(struct backend_context *bctx, void *message, struct SPropTagArray *columns, uint16_t count, struct mapistore_message_recipient *recipients)
 {
-	return bctx->backend->message.modify_recipients(message, columns, count, recipients);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->message.modify_recipients(message, columns, count, recipients));
 }
 
 enum mapistore_error mapistore_backend_message_set_read_flag(struct backend_context *bctx, void *message, uint8_t flag)
 {
-	return bctx->backend->message.set_read_flag(message, flag);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->message.set_read_flag(message, flag));
 }
 
 enum mapistore_error mapistore_backend_message_save(struct backend_context *bctx, void *message, TALLOC_CTX *mem_ctx)
 {
-	return bctx->backend->message.save(message, mem_ctx);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->message.save(message, mem_ctx));
 }
 
 enum mapistore_error mapistore_backend_message_submit(struct backend_context *bctx, void *message, enum SubmitFlags flags)
 {
-	return bctx->backend->message.submit(message, flags);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->message.submit(message, flags));
 }
 
 enum mapistore_error mapistore_backend_message_open_attachment(struct backend_context *bctx, void *message, TALLOC_CTX *mem_ctx, uint32_t aid, void **attachment)
 {
-        return bctx->backend->message.open_attachment(message, mem_ctx, aid, attachment);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->message.open_attachment(message, mem_ctx, aid, attachment));
 }
 
 enum mapistore_error mapistore_backend_message_create_attachment(struct backend_context *bctx, void *message, TALLOC_CTX *mem_ctx, void **attachment, uint32_t *aid)
 {
-        return bctx->backend->message.create_attachment(message, mem_ctx, attachment, aid);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->message.create_attachment(message, mem_ctx, attachment, aid));
 }
 
 enum mapistore_error mapistore_backend_message_get_attachment_table(struct backend_context *bctx, void *message, TALLOC_CTX *mem_ctx, void **table, uint32_t *row_count)
 {
-        return bctx->backend->message.get_attachment_table(message, mem_ctx, table, row_count);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->message.get_attachment_table(message, mem_ctx, table, row_count));
 }
 
 enum mapistore_error mapistore_backend_message_attachment_open_embedded_message(struct backend_context *bctx, void *attachment, TALLOC_CTX *mem_ctx, void **embedded_message, uint64_t *mid, struct mapistore_message **msg)
 {
-        return bctx->backend->message.open_embedded_message(attachment, mem_ctx, embedded_message, mid, msg);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->message.open_embedded_message(attachment, mem_ctx, embedded_message, mid, msg));
 }
 
 enum mapistore_error mapistore_backend_message_attachment_create_embedded_message(struct backend_context *bctx, void *attachment, TALLOC_CTX *mem_ctx, void **embedded_message, struct mapistore_message **msg)
 {
-        return bctx->backend->message.create_embedded_message(attachment, mem_ctx, embedded_message, msg);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->message.create_embedded_message(attachment, mem_ctx, embedded_message, msg));
 }
 
 enum mapistore_error mapistore_backend_table_get_available_properties(struct backend_context *bctx, void *table, TALLOC_CTX *mem_ctx, struct SPropTagArray **propertiesp)
 {
-        return bctx->backend->table.get_available_properties(table, mem_ctx, propertiesp);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.get_available_properties(table, mem_ctx, propertiesp));
 }
 
 enum mapistore_error mapistore_backend_table_set_columns(struct backend_context *bctx, void *table, uint16_t count, enum MAPITAGS *properties)
 {
-        return bctx->backend->table.set_columns(table, count, properties);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.set_columns(table, count, properties));
 }
 
 enum mapistore_error mapistore_backend_table_set_restrictions(struct backend_context *bctx, void *table, struct mapi_SRestriction *restrictions, uint8_t *table_status)
 {
-        return bctx->backend->table.set_restrictions(table, restrictions, table_status);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.set_restrictions(table, restrictions, table_status));
 }
 
 enum mapistore_error mapistore_backend_table_set_sort_order(struct backend_context *bctx, void *table, struct SSortOrderSet *sort_order, uint8_t *table_status)
 {
-        return bctx->backend->table.set_sort_order(table, sort_order, table_status);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.set_sort_order(table, sort_order, table_status));
 }
 
 enum mapistore_error mapistore_backend_table_get_row(struct backend_context *bctx, void *table, TALLOC_CTX *mem_ctx,
 						     enum mapistore_query_type query_type, uint32_t rowid,
 						     struct mapistore_property_data **data)
 {
-        return bctx->backend->table.get_row(table, mem_ctx, query_type, rowid, data);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.get_row(table, mem_ctx, query_type, rowid, data));
 }
 
 enum mapistore_error mapistore_backend_table_get_row_count(struct backend_context *bctx, void *table, enum mapistore_query_type query_type, uint32_t *row_countp)
 {
-        return bctx->backend->table.get_row_count(table, query_type, row_countp);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.get_row_count(table, query_type, row_countp));
+}
+
+enum mapistore_error mapistore_backend_table_find_row(struct backend_context *bctx, void *table, struct mapi_SRestriction *res, enum FindRow_ulFlags flags, uint32_t start, uint32_t *rowp)
+{
+        uint64_t	tv_start;
+
+        /* find_row is optional, backends registered without
+         * mapistore_backend_init_defaults may not provide it */
+        if (!bctx->backend->table.find_row) {
+                return MAPISTORE_ERR_NOT_IMPLEMENTED;
+        }
+
+        tv_start = backend_timer_start();
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.find_row(table, res, flags, start, rowp));
 }
 
 enum mapistore_error mapistore_backend_table_handle_destructor(struct backend_context *bctx, void *table, uint32_t handle_id)
 {
-        return bctx->backend->table.handle_destructor(table, handle_id);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->table.handle_destructor(table, handle_id));
 }
 
 enum mapistore_error mapistore_backend_properties_get_available_properties(struct backend_context *bctx, void *object, TALLOC_CTX *mem_ctx, struct SPropTagArray **propertiesp)
 {
-        return bctx->backend->properties.get_available_properties(object, mem_ctx, propertiesp);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->properties.get_available_properties(object, mem_ctx, propertiesp));
 }
 
 enum mapistore_error mapistore_backend_properties_get_properties(struct backend_context *bctx,
@@ -746,17 +928,23 @@ enum mapistore_error mapistore_backend_properties_get_properties(struct backend_
 						*properties,
 						struct mapistore_property_data *data)
 {
-        return bctx->backend->properties.get_properties(object, mem_ctx, count, properties, data);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->properties.get_properties(object, mem_ctx, count, properties, data));
 }
 
 enum mapistore_error mapistore_backend_properties_set_properties(struct backend_context *bctx, void *object, struct SRow *aRow)
 {
-        return bctx->backend->properties.set_properties(object, aRow);
+        uint64_t	tv_start = backend_timer_start();
+
+        return backend_timer_stop(bctx, tv_start, bctx->backend->properties.set_properties(object, aRow));
 }
 
 enum mapistore_error mapistore_backend_manager_generate_uri(struct backend_context *bctx, TALLOC_CTX *mem_ctx, 
 					   const char *username, const char *folder, 
 					   const char *message, const char *root_uri, char **uri)
 {
-	return bctx->backend->manager.generate_uri(mem_ctx, username, folder, message, root_uri, uri);
+	uint64_t	tv_start = backend_timer_start();
+
+	return backend_timer_stop(bctx, tv_start, bctx->backend->manager.generate_uri(mem_ctx, username, folder, message, root_uri, uri));
 }
@@ -105,6 +105,16 @@ static enum mapistore_error mapistore_op_defaults_delete_folder(void *folder_obj
 	return MAPISTORE_ERR_NOT_IMPLEMENTED;
 }
 
+static enum mapistore_error mapistore_op_defaults_empty_folder(void *folder_object,
+							       TALLOC_CTX *mem_ctx,
+							       bool delete_associated,
+							       uint8_t flags,
+							       struct UI8Array_r **fmidsp)
+{
+	DEBUG(3, ("[%s:%d] MAPISTORE defaults - MAPISTORE_ERR_NOT_IMPLEMENTED\n", __FUNCTION__, __LINE__));
+	return MAPISTORE_ERR_NOT_IMPLEMENTED;
+}
+
 static enum mapistore_error mapistore_op_defaults_open_message(void *folder_object,
 							       TALLOC_CTX *mem_ctx,
 							       uint64_t mid,
@@ -133,6 +143,15 @@ static enum mapistore_error mapistore_op_defaults_delete_message(void *folder_ob
 	return MAPISTORE_ERR_NOT_IMPLEMENTED;
 }
 
+static enum mapistore_error mapistore_op_defaults_delete_messages(void *folder_object,
+								  uint32_t count,
+								  const uint64_t *mids,
+								  uint8_t flags)
+{
+	DEBUG(3, ("[%s:%d] MAPISTORE defaults - MAPISTORE_ERR_NOT_IMPLEMENTED\n", __FUNCTION__, __LINE__));
+	return MAPISTORE_ERR_NOT_IMPLEMENTED;
+}
+
 static enum mapistore_error mapistore_op_defaults_move_copy_messages(void *target_folder,
 								     void *source_folder,
                                                                      TALLOC_CTX *mem_ctx,
@@ -314,6 +333,16 @@ static enum mapistore_error mapistore_op_defaults_handle_destructor(void *table_
 	return MAPISTORE_ERR_NOT_IMPLEMENTED;
 }
 
+static enum mapistore_error mapistore_op_defaults_find_row(void *table_object,
+							   struct mapi_SRestriction *res,
+							   enum FindRow_ulFlags flags,
+							   uint32_t start,
+							   uint32_t *rowp)
+{
+	DEBUG(3, ("[%s:%d] MAPISTORE defaults - MAPISTORE_ERR_NOT_IMPLEMENTED\n", __FUNCTION__, __LINE__));
+	return MAPISTORE_ERR_NOT_IMPLEMENTED;
+}
+
 static enum mapistore_error mapistore_op_defaults_get_properties(void *x_object,
 								 TALLOC_CTX *mem_ctx,
 								 uint16_t count,
@@ -364,14 +393,19 @@ extern enum mapistore_error mapistore_backend_init_defaults(struct mapistore_bac
 	backend->folder.open_folder = mapistore_op_defaults_open_folder;
 	backend->folder.create_folder = mapistore_op_defaults_create_folder;
 	backend->folder.delete = mapistore_op_defaults_delete_folder;
+	backend->folder.empty = mapistore_op_defaults_empty_folder;
 	backend->folder.open_message = mapistore_op_defaults_open_message;
 	backend->folder.create_message = mapistore_op_defaults_create_message;
 	backend->folder.delete_message = mapistore_op_defaults_delete_message;
+	backend->folder.delete_messages = mapistore_op_defaults_delete_messages;
 	backend->folder.move_copy_messages = mapistore_op_defaults_move_copy_messages;
 	backend->folder.get_deleted_fmids = mapistore_op_defaults_get_deleted_fmids;
 	backend->folder.get_child_count = mapistore_op_defaults_get_child_count;
 	backend->folder.open_table = mapistore_op_defaults_open_table;
 	backend->folder.modify_permissions = mapistore_op_defaults_modify_permissions;
+	/* set_read_flags has no default: callers check whether the
+	 * backend provides it before allocating change numbers */
+	backend->folder.set_read_flags = NULL;
 
 	/* oxcmsg operations */
 	backend->message.get_message_data = mapistore_op_defaults_get_message_data;
@@ -392,6 +426,7 @@ extern enum mapistore_error mapistore_backend_init_defaults(struct mapistore_bac
 	backend->table.get_row = mapistore_op_defaults_get_row;
 	backend->table.get_row_count = mapistore_op_defaults_get_row_count;
 	backend->table.handle_destructor = mapistore_op_defaults_handle_destructor;
+	backend->table.find_row = mapistore_op_defaults_find_row;
 
 	/* oxcprpt operations */
 	backend->properties.get_available_properties = mapistore_op_defaults_get_available_properties;
@@ -277,58 +277,43 @@ enum mapistore_error mapistore_indexing_record_add_fmid(struct mapistore_context
 
 
 /**
-   \details Remove a folder or message record from the indexing database
+   \details Remove or soft delete a single record of an opened
+   indexing database
 
-   \param mstore_ctx pointer to the mapistore context
-   \param context_id the context identifier referencing the indexing
-   database to update
+   \param mem_ctx pointer to the memory context
+   \param ictx pointer to the indexing context
    \param fmid the folder or message ID to delete
    \param flags the type of deletion MAPISTORE_SOFT_DELETE or MAPISTORE_PERMANENT_DELETE
 
    \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
  */
-enum mapistore_error mapistore_indexing_record_del_fmid(struct mapistore_context *mstore_ctx,
-							uint32_t context_id, const char *username, uint64_t fmid,
-							uint8_t flags)
+static enum mapistore_error mapistore_indexing_record_del(TALLOC_CTX *mem_ctx,
+							  struct indexing_context_list *ictx,
+							  uint64_t fmid, uint8_t flags)
 {
 	int				ret;
-	struct backend_context		*backend_ctx;
-	struct indexing_context_list	*ictx;
 	TDB_DATA			key;
 	TDB_DATA			newkey;
 	TDB_DATA			dbuf;
 	bool				IsSoftDeleted = false;
 
-	/* Sanity checks */
-	MAPISTORE_RETVAL_IF(!mstore_ctx, MAPISTORE_ERROR, NULL);
-	MAPISTORE_RETVAL_IF(!context_id, MAPISTORE_ERROR, NULL);
-	MAPISTORE_RETVAL_IF(!fmid, MAPISTORE_ERROR, NULL);
-
-	/* Ensure the context exists */
-	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
-	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
-	MAPISTORE_RETVAL_IF(!backend_ctx->indexing, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
-
 	/* Check if the fid/mid still exists within the database */
-	ret = mapistore_indexing_add(mstore_ctx, username, &ictx);
-	MAPISTORE_RETVAL_IF(ret, MAPISTORE_ERROR, NULL);
-	MAPISTORE_RETVAL_IF(!ictx, MAPISTORE_ERROR, NULL);
 	ret = mapistore_indexing_search_existing_fmid(ictx, fmid, &IsSoftDeleted);
 	MAPISTORE_RETVAL_IF(!ret, ret, NULL);
 
 	if (IsSoftDeleted == true) {
-		key.dptr = (unsigned char *) talloc_asprintf(mstore_ctx, "%s0x%.16"PRIx64, 
+		key.dptr = (unsigned char *) talloc_asprintf(mem_ctx, "%s0x%.16"PRIx64, 
 							     MAPISTORE_SOFT_DELETED_TAG, fmid);
 	} else {
-		key.dptr = (unsigned char *) talloc_asprintf(mstore_ctx, "0x%.16"PRIx64, fmid);
+		key.dptr = (unsigned char *) talloc_asprintf(mem_ctx, "0x%.16"PRIx64, fmid);
 	}
 	key.dsize = strlen((const char *) key.dptr);
 
 	switch (flags) {
 	case MAPISTORE_SOFT_DELETE:
 		/* nothing to do if the record is already soft deleted */
-		MAPISTORE_RETVAL_IF(IsSoftDeleted == true, MAPISTORE_SUCCESS, NULL);
-		newkey.dptr = (unsigned char *) talloc_asprintf(mstore_ctx, "%s0x%.16"PRIx64, 
+		MAPISTORE_RETVAL_IF(IsSoftDeleted == true, MAPISTORE_SUCCESS, key.dptr);
+		newkey.dptr = (unsigned char *) talloc_asprintf(mem_ctx, "%s0x%.16"PRIx64, 
 								MAPISTORE_SOFT_DELETED_TAG,
 								fmid);
 		newkey.dsize = strlen ((const char *)newkey.dptr);
@@ -352,6 +337,42 @@ enum mapistore_error mapistore_indexing_record_del_fmid(struct mapistore_context
 	return MAPISTORE_SUCCESS;
 }
 
+/**
+   \details Remove a folder or message record from the indexing database
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the indexing
+   database to update
+   \param fmid the folder or message ID to delete
+   \param flags the type of deletion MAPISTORE_SOFT_DELETE or MAPISTORE_PERMANENT_DELETE
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+enum mapistore_error mapistore_indexing_record_del_fmid(struct mapistore_context *mstore_ctx,
+							uint32_t context_id, const char *username, uint64_t fmid,
+							uint8_t flags)
+{
+	int				ret;
+	struct backend_context		*backend_ctx;
+	struct indexing_context_list	*ictx;
+
+	/* Sanity checks */
+	MAPISTORE_RETVAL_IF(!mstore_ctx, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(!context_id, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(!fmid, MAPISTORE_ERROR, NULL);
+
+	/* Ensure the context exists */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+	MAPISTORE_RETVAL_IF(!backend_ctx->indexing, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	ret = mapistore_indexing_add(mstore_ctx, username, &ictx);
+	MAPISTORE_RETVAL_IF(ret, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(!ictx, MAPISTORE_ERROR, NULL);
+
+	return mapistore_indexing_record_del(mstore_ctx, ictx, fmid, flags);
+}
+
 /**
    \details Returns record data
 
@@ -645,3 +666,101 @@ _PUBLIC_ enum mapistore_error mapistore_indexing_record_del_mid(struct mapistore
 {
 	return mapistore_indexing_record_del_fmid(mstore_ctx, context_id, username, mid, flags);
 }
+
+
+/**
+   \details Delete a set of folder or message records from the
+   indexing database
+
+   All the records are removed within a single TDB transaction, so
+   deleting n objects costs one commit instead of n.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the indexing
+   database to update
+   \param username the name of the account owning the indexing database
+   \param count the number of identifiers in \p fmids
+   \param fmids the folder and message identifiers to remove
+   \param flags the type of deletion MAPISTORE_SOFT_DELETE or
+   MAPISTORE_PERMANENT_DELETE
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error mapistore_indexing_record_del_fmids(struct mapistore_context *mstore_ctx,
+								  uint32_t context_id, const char *username,
+								  uint32_t count, const uint64_t *fmids,
+								  uint8_t flags)
+{
+	TALLOC_CTX			*mem_ctx;
+	enum mapistore_error		ret;
+	struct backend_context		*backend_ctx;
+	struct indexing_context_list	*ictx;
+	uint32_t			i;
+
+	/* Sanity checks */
+	MAPISTORE_RETVAL_IF(!mstore_ctx, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(!context_id, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(count && !fmids, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+	MAPISTORE_RETVAL_IF(!count, MAPISTORE_SUCCESS, NULL);
+
+	/* Ensure the context exists */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+	MAPISTORE_RETVAL_IF(!backend_ctx->indexing, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	ret = mapistore_indexing_add(mstore_ctx, username, &ictx);
+	MAPISTORE_RETVAL_IF(ret, MAPISTORE_ERROR, NULL);
+	MAPISTORE_RETVAL_IF(!ictx, MAPISTORE_ERROR, NULL);
+
+	if (tdb_transaction_start(ictx->index_ctx->tdb) != 0) {
+		DEBUG(3, ("[%s:%d]: unable to start transaction: %s\n", __FUNCTION__, __LINE__,
+			  tdb_errorstr(ictx->index_ctx->tdb)));
+		return MAPISTORE_ERR_DATABASE_OPS;
+	}
+
+	mem_ctx = talloc_named(NULL, 0, "mapistore_indexing_record_del_fmids");
+	for (i = 0; i < count; i++) {
+		if (!fmids[i]) continue;
+		ret = mapistore_indexing_record_del(mem_ctx, ictx, fmids[i], flags);
+		if (ret != MAPISTORE_SUCCESS) {
+			DEBUG(3, ("[%s:%d]: unable to delete 0x%.16"PRIx64" record\n", __FUNCTION__, __LINE__, fmids[i]));
+			tdb_transaction_cancel(ictx->index_ctx->tdb);
+			talloc_free(mem_ctx);
+			return ret;
+		}
+	}
+	talloc_free(mem_ctx);
+
+	if (tdb_transaction_commit(ictx->index_ctx->tdb) != 0) {
+		DEBUG(3, ("[%s:%d]: unable to commit transaction: %s\n", __FUNCTION__, __LINE__,
+			  tdb_errorstr(ictx->index_ctx->tdb)));
+		return MAPISTORE_ERR_DATABASE_OPS;
+	}
+
+	return MAPISTORE_SUCCESS;
+}
+
+
+/**
+   \details Delete a set of mid records from the indexing database
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the indexing
+   database to update
+   \param username the name of the account owning the indexing database
+   \param count the number of mids in \p mids
+   \param mids the mids to remove
+   \param flags the type of deletion MAPISTORE_SOFT_DELETE or
+   MAPISTORE_PERMANENT_DELETE
+
+   \note This is a wrapper to mapistore_indexing_record_del_fmids.
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error mapistore_indexing_record_del_mids(struct mapistore_context *mstore_ctx,
+								 uint32_t context_id, const char *username,
+								 uint32_t count, const uint64_t *mids,
+								 uint8_t flags)
+{
+	return mapistore_indexing_record_del_fmids(mstore_ctx, context_id, username, count, mids, flags);
+}
@@ -90,6 +90,7 @@ _PUBLIC_ struct mapistore_context *mapistore_init(TALLOC_CTX *mem_ctx, struct lo
 	mstore_ctx->replica_mapping_list = talloc_zero(mstore_ctx, struct replica_mapping_context_list);
 	mstore_ctx->notifications = NULL;
 	mstore_ctx->subscriptions = NULL;
+	mstore_ctx->subscription_index = NULL;
 	mstore_ctx->conn_info = NULL;
 
 	mstore_ctx->nprops_ctx = NULL;
@@ -528,6 +529,41 @@ _PUBLIC_ enum mapistore_error mapistore_folder_create_folder(struct mapistore_co
 }
 
 
+/**
+   \details Delete a set of messages from a backend folder
+
+   Use the backend delete_messages operation when available, otherwise
+   delete the messages one at a time. Messages which no longer exist
+   are skipped by the fallback.
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE errors
+ */
+static enum mapistore_error mapistore_folder_delete_messages_internal(struct backend_context *backend_ctx, void *folder,
+								      uint32_t count, const uint64_t *mids, uint8_t flags)
+{
+	enum mapistore_error	ret;
+	uint32_t		i;
+
+	if (!count) {
+		return MAPISTORE_SUCCESS;
+	}
+
+	ret = mapistore_backend_folder_delete_messages(backend_ctx, folder, count, mids, flags);
+	if (ret != MAPISTORE_ERR_NOT_IMPLEMENTED) {
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = mapistore_backend_folder_delete_message(backend_ctx, folder, mids[i], flags);
+		if (ret != MAPISTORE_SUCCESS && ret != MAPISTORE_ERR_NOT_FOUND) {
+			return ret;
+		}
+	}
+
+	return MAPISTORE_SUCCESS;
+}
+
+
 /**
    \details Remove a directory in mapistore
 
@@ -569,11 +605,9 @@ _PUBLIC_ enum mapistore_error mapistore_folder_delete(struct mapistore_context *
 	}
 	if (child_count > 0) {
 		if ((flags & DEL_MESSAGES)) {
-			for (i = 0; i < child_count; i++) {
-				ret = mapistore_backend_folder_delete_message(backend_ctx, folder, child_fmids[i], 0);
-				if (ret != MAPISTORE_SUCCESS) {
-					goto end;
-				}
+			ret = mapistore_folder_delete_messages_internal(backend_ctx, folder, child_count, child_fmids, 0);
+			if (ret != MAPISTORE_SUCCESS) {
+				goto end;
 			}
 		}
 		else {
@@ -589,11 +623,9 @@ _PUBLIC_ enum mapistore_error mapistore_folder_delete(struct mapistore_context *
 	}
 	if (child_count > 0) {
 		if ((flags & DEL_MESSAGES)) {
-			for (i = 0; i < child_count; i++) {
-				ret = mapistore_backend_folder_delete_message(backend_ctx, folder, child_fmids[i], 0);
-				if (ret != MAPISTORE_SUCCESS) {
-					goto end;
-				}
+			ret = mapistore_folder_delete_messages_internal(backend_ctx, folder, child_count, child_fmids, 0);
+			if (ret != MAPISTORE_SUCCESS) {
+				goto end;
 			}
 		}
 		else {
@@ -636,6 +668,162 @@ end:
 	return ret;
 }
 
+/**
+   \details Append the children identifiers of a folder table to an array
+ */
+static enum mapistore_error mapistore_folder_append_child_fmids(struct mapistore_context *mstore_ctx, uint32_t context_id,
+								void *folder, enum mapistore_table_type table_type,
+								struct UI8Array_r *fmids, uint64_t **childrenp, uint32_t *countp)
+{
+	enum mapistore_error	ret;
+	uint64_t		*children;
+	uint32_t		count;
+
+	ret = mapistore_folder_get_child_fmids(mstore_ctx, context_id, folder, table_type, fmids, &children, &count);
+	MAPISTORE_RETVAL_IF(ret, ret, NULL);
+
+	if (count) {
+		fmids->lpui8 = talloc_realloc(fmids, fmids->lpui8, uint64_t, fmids->cValues + count);
+		MAPISTORE_RETVAL_IF(!fmids->lpui8, MAPISTORE_ERR_NO_MEMORY, children);
+		memcpy(fmids->lpui8 + fmids->cValues, children, count * sizeof (uint64_t));
+		fmids->cValues += count;
+	}
+
+	if (childrenp) {
+		*childrenp = children;
+		*countp = count;
+	} else {
+		talloc_free(children);
+	}
+
+	return MAPISTORE_SUCCESS;
+}
+
+/**
+   \details Collect the identifiers of every message and folder below a
+   backend folder
+ */
+static enum mapistore_error mapistore_folder_collect_fmids(struct mapistore_context *mstore_ctx, uint32_t context_id,
+							   struct backend_context *backend_ctx, void *folder,
+							   struct UI8Array_r *fmids)
+{
+	enum mapistore_error	ret;
+	TALLOC_CTX		*mem_ctx;
+	uint64_t		*children;
+	uint32_t		count;
+	uint32_t		i;
+	void			*subfolder;
+
+	ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_MESSAGE_TABLE, fmids, NULL, NULL);
+	MAPISTORE_RETVAL_IF(ret, ret, NULL);
+	ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_FAI_TABLE, fmids, NULL, NULL);
+	MAPISTORE_RETVAL_IF(ret, ret, NULL);
+
+	mem_ctx = talloc_new(NULL);
+	ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_FOLDER_TABLE, fmids, &children, &count);
+	MAPISTORE_RETVAL_IF(ret, ret, mem_ctx);
+	(void) talloc_steal(mem_ctx, children);
+
+	for (i = 0; i < count; i++) {
+		ret = mapistore_backend_folder_open_folder(backend_ctx, folder, mem_ctx, children[i], &subfolder);
+		MAPISTORE_RETVAL_IF(ret, ret, mem_ctx);
+		ret = mapistore_folder_collect_fmids(mstore_ctx, context_id, backend_ctx, subfolder, fmids);
+		MAPISTORE_RETVAL_IF(ret, ret, mem_ctx);
+		talloc_free(subfolder);
+	}
+	talloc_free(mem_ctx);
+
+	return MAPISTORE_SUCCESS;
+}
+
+/**
+   \details Remove the messages and subfolders of a folder, recursively
+
+   Backends implementing the empty operation remove the whole content
+   of the folder in a single backend transaction. For other backends
+   the content is deleted with one bulk delete per table and one
+   delete per direct subfolder.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the backend
+   \param folder pointer to the folder object
+   \param mem_ctx pointer to the memory context
+   \param delete_associated whether the FAI messages of the folder
+   must be deleted too
+   \param flags MAPISTORE_SOFT_DELETE or MAPISTORE_PERMANENT_DELETE
+   \param fmidsp pointer on pointer to the identifiers of the removed
+   messages and folders, for the update of the indexing records
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE errors
+ */
+_PUBLIC_ enum mapistore_error mapistore_folder_empty(struct mapistore_context *mstore_ctx, uint32_t context_id, void *folder,
+						     TALLOC_CTX *mem_ctx, bool delete_associated, uint8_t flags,
+						     struct UI8Array_r **fmidsp)
+{
+	struct backend_context	*backend_ctx;
+	enum mapistore_error	ret;
+	TALLOC_CTX		*local_mem_ctx;
+	struct UI8Array_r	*fmids;
+	uint64_t		*children;
+	uint32_t		count;
+	uint32_t		i;
+	void			*subfolder;
+
+	/* Sanity checks */
+	MAPISTORE_SANITY_CHECKS(mstore_ctx, NULL);
+	MAPISTORE_RETVAL_IF(!fmidsp, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search the context */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 2. Call backend operation */
+	ret = mapistore_backend_folder_empty(backend_ctx, folder, mem_ctx, delete_associated, flags, fmidsp);
+	if (ret != MAPISTORE_ERR_NOT_IMPLEMENTED) {
+		return ret;
+	}
+
+	/* Step 3. Fallback: delete the messages, then each subfolder with its content */
+	fmids = talloc_zero(mem_ctx, struct UI8Array_r);
+	MAPISTORE_RETVAL_IF(!fmids, MAPISTORE_ERR_NO_MEMORY, NULL);
+	local_mem_ctx = talloc_new(NULL);
+
+	ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_MESSAGE_TABLE, fmids, &children, &count);
+	if (ret) goto end;
+	(void) talloc_steal(local_mem_ctx, children);
+	ret = mapistore_folder_delete_messages_internal(backend_ctx, folder, count, children, flags);
+	if (ret) goto end;
+
+	if (delete_associated) {
+		ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_FAI_TABLE, fmids, &children, &count);
+		if (ret) goto end;
+		(void) talloc_steal(local_mem_ctx, children);
+		ret = mapistore_folder_delete_messages_internal(backend_ctx, folder, count, children, flags);
+		if (ret) goto end;
+	}
+
+	ret = mapistore_folder_append_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_FOLDER_TABLE, fmids, &children, &count);
+	if (ret) goto end;
+	(void) talloc_steal(local_mem_ctx, children);
+	for (i = 0; i < count; i++) {
+		ret = mapistore_backend_folder_open_folder(backend_ctx, folder, local_mem_ctx, children[i], &subfolder);
+		if (ret) goto end;
+		ret = mapistore_folder_collect_fmids(mstore_ctx, context_id, backend_ctx, subfolder, fmids);
+		if (ret) goto end;
+		ret = mapistore_folder_delete(mstore_ctx, context_id, subfolder, DEL_MESSAGES | DEL_FOLDERS);
+		if (ret) goto end;
+		talloc_free(subfolder);
+	}
+
+end:
+	talloc_free(local_mem_ctx);
+	/* Report what was removed, even on failure, so the indexing
+	   database can be kept in sync */
+	*fmidsp = fmids;
+
+	return ret;
+}
+
 /**
    \details Open a message in mapistore
 
@@ -721,6 +909,39 @@ _PUBLIC_ enum mapistore_error mapistore_folder_delete_message(struct mapistore_c
 	return mapistore_backend_folder_delete_message(backend_ctx, folder, mid, flags);
 }
 
+/**
+   \details Delete a set of messages from mapistore
+
+   Backends implementing the delete_messages operation remove the whole
+   set in a single call. Other backends are called once per message.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the backend
+   \param folder pointer to the folder object
+   \param count the number of messages to delete
+   \param mids the message identifiers to delete
+   \param flags flags that control the behaviour of the operation (MAPISTORE_SOFT_DELETE
+   or MAPISTORE_PERMANENT_DELETE)
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE errors
+ */
+_PUBLIC_ enum mapistore_error mapistore_folder_delete_messages(struct mapistore_context *mstore_ctx, uint32_t context_id,
+							       void *folder, uint32_t count, const uint64_t *mids, uint8_t flags)
+{
+	struct backend_context	*backend_ctx;
+
+	/* Sanity checks */
+	MAPISTORE_SANITY_CHECKS(mstore_ctx, NULL);
+	MAPISTORE_RETVAL_IF(count && !mids, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search the context */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 2. Call backend operation */
+	return mapistore_folder_delete_messages_internal(backend_ctx, folder, count, mids, flags);
+}
+
 /**
 
  */
@@ -967,6 +1188,112 @@ _PUBLIC_ enum mapistore_error mapistore_folder_preload_message_bodies(struct map
 	return mapistore_backend_folder_preload_message_bodies(backend_ctx, folder, table_type, mids);
 }
 
+/**
+   \details Check whether a backend updates the read flag of several
+   messages in a single call
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the backend
+
+   \return true if the backend implements the set_read_flags operation,
+   otherwise false
+
+   \sa mapistore_folder_set_read_flags
+ */
+_PUBLIC_ bool mapistore_folder_has_set_read_flags(struct mapistore_context *mstore_ctx, uint32_t context_id)
+{
+	struct backend_context	*backend_ctx;
+
+	if (!mstore_ctx) return false;
+
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	if (!backend_ctx) return false;
+
+	return mapistore_backend_folder_has_set_read_flags(backend_ctx);
+}
+
+/**
+   \details Set or clear the read flag of several messages of a folder
+
+   Backends implementing the set_read_flags operation apply the change
+   in a single call. For other backends, each message is opened and
+   updated with the per-message set_read_flag operation.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the backend
+   \param folder pointer to the folder object
+   \param flags the read flags to apply, as in RopSetMessageReadFlag
+   \param mid_count the number of messages in \p mids
+   \param mids the message identifiers, or NULL for all the messages of
+   the folder
+   \param cns the change numbers allocated for the read state changes,
+   one per message in the order of \p mids (or of the folder contents
+   table when \p mids is NULL), or NULL. They are only used by the
+   set_read_flags operation: the per-message fallback leaves change
+   numbers to the backend, so callers should only allocate them when
+   mapistore_folder_has_set_read_flags returns true
+
+   \return MAPISTORE_SUCCESS if every message was updated, otherwise the
+   error of the first message which could not be updated
+ */
+_PUBLIC_ enum mapistore_error mapistore_folder_set_read_flags(struct mapistore_context *mstore_ctx, uint32_t context_id, void *folder,
+							      uint8_t flags, uint16_t mid_count, const uint64_t *mids,
+							      const struct UI8Array_r *cns)
+{
+	TALLOC_CTX		*local_mem_ctx;
+	struct backend_context	*backend_ctx;
+	enum mapistore_error	ret;
+	enum mapistore_error	retval;
+	uint64_t		*child_mids;
+	uint32_t		count;
+	uint32_t		i;
+	void			*message;
+
+	/* Sanity checks */
+	MAPISTORE_SANITY_CHECKS(mstore_ctx, NULL);
+	MAPISTORE_RETVAL_IF(!mids && mid_count, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search the context */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 2. Call backend operation */
+	ret = mapistore_backend_folder_set_read_flags(backend_ctx, folder, flags, mid_count, mids, cns);
+	if (ret != MAPISTORE_ERR_NOT_IMPLEMENTED) {
+		return ret;
+	}
+
+	/* Step 3. Fallback to updating messages one at a time */
+	local_mem_ctx = talloc_named(NULL, 0, "mapistore_folder_set_read_flags");
+	if (mids) {
+		count = mid_count;
+	} else {
+		ret = mapistore_folder_get_child_fmids(mstore_ctx, context_id, folder, MAPISTORE_MESSAGE_TABLE,
+						       local_mem_ctx, &child_mids, &count);
+		MAPISTORE_RETVAL_IF(ret, ret, local_mem_ctx);
+		mids = child_mids;
+	}
+
+	retval = MAPISTORE_SUCCESS;
+	for (i = 0; i < count; i++) {
+		ret = mapistore_backend_folder_open_message(backend_ctx, folder, local_mem_ctx, mids[i], true, &message);
+		if (ret == MAPISTORE_SUCCESS) {
+			ret = mapistore_backend_message_set_read_flag(backend_ctx, message, flags);
+			talloc_free(message);
+		}
+		if (ret != MAPISTORE_SUCCESS) {
+			DEBUG(5, ("[%s:%d]: unable to set read flag on message 0x%.16"PRIx64": %s\n", __FUNCTION__, __LINE__,
+				  mids[i], mapistore_errstr(ret)));
+			if (retval == MAPISTORE_SUCCESS) {
+				retval = ret;
+			}
+		}
+	}
+	talloc_free(local_mem_ctx);
+
+	return retval;
+}
+
 /* freebusy helper */
 static int mapistore_days_in_month(int month, int year)
 {
@@ -1686,6 +2013,43 @@ _PUBLIC_ enum mapistore_error mapistore_table_get_row_count(struct mapistore_con
 	return mapistore_backend_table_get_row_count(backend_ctx, table, query_type, row_countp);
 }
 
+/**
+   \details Find the next row matching a restriction in a table
+
+   Backends able to evaluate restrictions natively, for example using
+   an index, implement this operation. Other backends return
+   MAPISTORE_ERR_NOT_IMPLEMENTED and the caller falls back to scanning
+   the table rows.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param context_id the context identifier referencing the backend
+   \param table pointer to the table object
+   \param res pointer to the restriction rows must match
+   \param flags the search direction (DIR_FORWARD or DIR_BACKWARD)
+   \param start the position of the first row to examine
+   \param rowp pointer to the position of the matching row to return
+
+   \return MAPISTORE_SUCCESS on success, MAPISTORE_ERR_NOT_FOUND if no
+   row matches, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error mapistore_table_find_row(struct mapistore_context *mstore_ctx, uint32_t context_id, void *table,
+						       struct mapi_SRestriction *res, enum FindRow_ulFlags flags,
+						       uint32_t start, uint32_t *rowp)
+{
+	struct backend_context	*backend_ctx;
+
+	/* Sanity checks */
+	MAPISTORE_SANITY_CHECKS(mstore_ctx, NULL);
+	MAPISTORE_RETVAL_IF(!res || !rowp, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 1. Search the context */
+	backend_ctx = mapistore_backend_lookup(mstore_ctx->context_list, context_id);
+	MAPISTORE_RETVAL_IF(!backend_ctx, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	/* Step 2. Call backend operation */
+	return mapistore_backend_table_find_row(backend_ctx, table, res, flags, start, rowp);
+}
+
 _PUBLIC_ enum mapistore_error mapistore_table_handle_destructor(struct mapistore_context *mstore_ctx, uint32_t context_id, void *table, uint32_t handle_id)
 {
 	struct backend_context	*backend_ctx;
@@ -28,6 +28,262 @@
 #include "mapiproxy/libmapistore/mgmt/mapistore_mgmt.h"
 #include "mapiproxy/libmapistore/mgmt/gen_ndr/ndr_mapistore_mgmt.h"
 
+/**
+   \file mapistore_notification.c
+
+   \brief Notification subscriptions and pending notifications
+
+   Subscriptions are stored in the mstore_ctx->subscriptions list and
+   indexed in a registry so matching a notification does not require
+   walking every subscription of the session:
+
+   - all subscriptions are hashed by handle, which table notifications
+     carry and which is used to delete subscriptions;
+   - folder and message subscriptions are hashed by folder identifier;
+   - whole store subscriptions are kept in a separate bucket.
+
+   Pending table notifications are hashed in the same registry by
+   handle, object and instance identifiers, so coalescing a new table
+   notification does not walk mstore_ctx->notifications either.
+ */
+
+/* Initial number of buckets, the registry grows past 2 entries per bucket */
+#define	MAPISTORE_SUBSCRIPTION_INDEX_SIZE	64
+
+struct mapistore_subscription_entry;
+
+struct mapistore_subscription_node {
+	struct mapistore_subscription_entry	*entry;
+	struct mapistore_subscription_node	*prev;
+	struct mapistore_subscription_node	*next;
+};
+
+struct mapistore_subscription_entry {
+	struct mapistore_subscription_index	*index;
+	struct mapistore_subscription_list	*element;
+	bool					table;
+	struct mapistore_subscription_node	handle_node;
+	struct mapistore_subscription_node	folder_node;
+	struct mapistore_subscription_entry	*prev;
+	struct mapistore_subscription_entry	*next;
+};
+
+struct mapistore_pending_entry {
+	struct mapistore_subscription_index	*index;
+	struct mapistore_notification_list	*element;
+	uint32_t				bucket;
+	struct mapistore_pending_entry		*prev;
+	struct mapistore_pending_entry		*next;
+};
+
+struct mapistore_subscription_index {
+	uint32_t				size;
+	uint32_t				count;
+	struct mapistore_subscription_node	**handles;
+	struct mapistore_subscription_node	**folders;
+	struct mapistore_subscription_node	*whole_store;
+	struct mapistore_subscription_entry	*entries;
+	uint32_t				pending_size;
+	uint32_t				pending_count;
+	struct mapistore_pending_entry		**pending;
+};
+
+static uint32_t mapistore_key_hash(uint64_t key, uint32_t size)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+
+	return (uint32_t)key & (size - 1);
+}
+
+static uint32_t mapistore_subscription_hash(struct mapistore_subscription_index *index, uint64_t key)
+{
+	return mapistore_key_hash(key, index->size);
+}
+
+static uint32_t mapistore_pending_hash(uint32_t size, struct mapistore_table_notification_parameters *parameters)
+{
+	uint64_t	key;
+
+	key = parameters->object_id;
+	key ^= (uint64_t)parameters->instance_id * 0x9e3779b97f4a7c15ULL;
+	key ^= (uint64_t)parameters->handle << 32;
+
+	return mapistore_key_hash(key, size);
+}
+
+static void mapistore_subscription_link(struct mapistore_subscription_index *index,
+					struct mapistore_subscription_entry *entry)
+{
+	struct mapistore_subscription	*subscription = entry->element->subscription;
+	uint32_t			bucket;
+
+	bucket = mapistore_subscription_hash(index, subscription->handle);
+	DLIST_ADD(index->handles[bucket], &entry->handle_node);
+
+	if (entry->table) return;
+
+	if (subscription->parameters.object_parameters.whole_store) {
+		DLIST_ADD(index->whole_store, &entry->folder_node);
+	} else {
+		bucket = mapistore_subscription_hash(index, subscription->parameters.object_parameters.folder_id);
+		DLIST_ADD(index->folders[bucket], &entry->folder_node);
+	}
+}
+
+static void mapistore_subscription_unlink(struct mapistore_subscription_index *index,
+					  struct mapistore_subscription_entry *entry)
+{
+	struct mapistore_subscription	*subscription = entry->element->subscription;
+	uint32_t			bucket;
+
+	bucket = mapistore_subscription_hash(index, subscription->handle);
+	DLIST_REMOVE(index->handles[bucket], &entry->handle_node);
+
+	if (entry->table) return;
+
+	if (subscription->parameters.object_parameters.whole_store) {
+		DLIST_REMOVE(index->whole_store, &entry->folder_node);
+	} else {
+		bucket = mapistore_subscription_hash(index, subscription->parameters.object_parameters.folder_id);
+		DLIST_REMOVE(index->folders[bucket], &entry->folder_node);
+	}
+}
+
+/**
+   \details Double the number of buckets of the registry and rehash
+   existing entries. The registry is left unchanged if memory can't be
+   allocated.
+
+   \param index pointer to the subscription registry
+ */
+static void mapistore_subscription_index_grow(struct mapistore_subscription_index *index)
+{
+	struct mapistore_subscription_node	**handles;
+	struct mapistore_subscription_node	**folders;
+	struct mapistore_subscription_entry	*entry;
+
+	handles = talloc_zero_array(index, struct mapistore_subscription_node *, index->size * 2);
+	folders = talloc_zero_array(index, struct mapistore_subscription_node *, index->size * 2);
+	if (!handles || !folders) {
+		talloc_free(handles);
+		talloc_free(folders);
+		return;
+	}
+
+	talloc_free(index->handles);
+	talloc_free(index->folders);
+	index->handles = handles;
+	index->folders = folders;
+	index->size *= 2;
+	index->whole_store = NULL;
+
+	for (entry = index->entries; entry; entry = entry->next) {
+		mapistore_subscription_link(index, entry);
+	}
+}
+
+static int mapistore_subscription_entry_destructor(struct mapistore_subscription_entry *entry)
+{
+	struct mapistore_subscription_index	*index = entry->index;
+
+	if (!index) return 0;
+
+	mapistore_subscription_unlink(index, entry);
+	DLIST_REMOVE(index->entries, entry);
+	index->count--;
+
+	return 0;
+}
+
+/**
+   \details Double the number of buckets of the pending notifications
+   table and rehash existing entries. The table is left unchanged if
+   memory can't be allocated.
+
+   \param index pointer to the subscription registry
+ */
+static void mapistore_pending_index_grow(struct mapistore_subscription_index *index)
+{
+	struct mapistore_pending_entry	**pending;
+	struct mapistore_pending_entry	*entry;
+	uint32_t			i;
+
+	pending = talloc_zero_array(index, struct mapistore_pending_entry *, index->pending_size * 2);
+	if (!pending) return;
+
+	for (i = 0; i < index->pending_size; i++) {
+		while ((entry = index->pending[i])) {
+			DLIST_REMOVE(index->pending[i], entry);
+			entry->bucket = mapistore_pending_hash(index->pending_size * 2,
+							       &entry->element->notification->parameters.table_parameters);
+			DLIST_ADD(pending[entry->bucket], entry);
+		}
+	}
+	talloc_free(index->pending);
+	index->pending = pending;
+	index->pending_size *= 2;
+}
+
+static int mapistore_pending_entry_destructor(struct mapistore_pending_entry *entry)
+{
+	struct mapistore_subscription_index	*index = entry->index;
+
+	if (!index) return 0;
+
+	DLIST_REMOVE(index->pending[entry->bucket], entry);
+	index->pending_count--;
+
+	return 0;
+}
+
+static int mapistore_subscription_index_destructor(struct mapistore_subscription_index *index)
+{
+	struct mapistore_subscription_entry	*entry;
+	struct mapistore_pending_entry		*pending;
+	uint32_t				i;
+
+	/* subscriptions may outlive the registry when mstore_ctx is released */
+	for (entry = index->entries; entry; entry = entry->next) {
+		entry->index = NULL;
+	}
+	for (i = 0; i < index->pending_size; i++) {
+		for (pending = index->pending[i]; pending; pending = pending->next) {
+			pending->index = NULL;
+		}
+	}
+
+	return 0;
+}
+
+static struct mapistore_subscription_index *mapistore_subscription_index_get(struct mapistore_context *mstore_ctx)
+{
+	struct mapistore_subscription_index	*index;
+
+	if (mstore_ctx->subscription_index) {
+		return mstore_ctx->subscription_index;
+	}
+
+	index = talloc_zero(mstore_ctx, struct mapistore_subscription_index);
+	if (!index) return NULL;
+
+	index->size = MAPISTORE_SUBSCRIPTION_INDEX_SIZE;
+	index->handles = talloc_zero_array(index, struct mapistore_subscription_node *, index->size);
+	index->folders = talloc_zero_array(index, struct mapistore_subscription_node *, index->size);
+	index->pending_size = MAPISTORE_SUBSCRIPTION_INDEX_SIZE;
+	index->pending = talloc_zero_array(index, struct mapistore_pending_entry *, index->pending_size);
+	if (!index->handles || !index->folders || !index->pending) {
+		talloc_free(index);
+		return NULL;
+	}
+	talloc_set_destructor(index, mapistore_subscription_index_destructor);
+
+	mstore_ctx->subscription_index = index;
+
+	return index;
+}
+
 #if 0
 static int mapistore_subscription_destructor(void *data)
 {
@@ -51,29 +307,45 @@ static int mapistore_subscription_destructor(void *data)
 }
 #endif
 
-struct mapistore_subscription *mapistore_new_subscription(TALLOC_CTX *mem_ctx, 
-							  struct mapistore_context *mstore_ctx,
-							  const char *username,
-							  uint32_t handle,
-                                                          uint16_t notification_types,
-                                                          void *notification_parameters)
+/**
+   \details Create a new notification subscription
+
+   \param mem_ctx pointer to the memory context
+   \param mstore_ctx pointer to the mapistore context
+   \param username the name of the user owning the subscription
+   \param handle the handle of the object the subscription is attached to
+   \param notification_types the notification types to subscribe to
+   \param notification_parameters pointer to the table or object
+   subscription parameters
+
+   \return Allocated subscription on success, otherwise NULL
+ */
+_PUBLIC_ struct mapistore_subscription *mapistore_new_subscription(TALLOC_CTX *mem_ctx, 
+								   struct mapistore_context *mstore_ctx,
+								   const char *username,
+								   uint32_t handle,
+								   uint16_t notification_types,
+								   void *notification_parameters)
 {
+        struct mapistore_subscription			*new_subscription;
+        struct mapistore_table_subscription_parameters	*table_parameters;
+        struct mapistore_object_subscription_parameters *object_parameters;
 #if 0
 	int						ret;
 	struct mapistore_connection_info		c;
 	struct mapistore_mgmt_notif			n;
-        struct mapistore_subscription			*new_subscription;
-        struct mapistore_table_subscription_parameters	*table_parameters;
-        struct mapistore_object_subscription_parameters *object_parameters;
 	unsigned int					prio;
 	struct mq_attr					attr;
 	DATA_BLOB					data;
+#endif
+
+	if (!notification_parameters) return NULL;
 
         new_subscription = talloc_zero(mem_ctx, struct mapistore_subscription);
+	if (!new_subscription) return NULL;
+
         new_subscription->handle = handle;
         new_subscription->notification_types = notification_types;
-	new_subscription->mqueue = -1;
-	new_subscription->mqueue_name = NULL;
         if (notification_types == fnevTableModified) {
                 table_parameters = notification_parameters;
                 new_subscription->parameters.table_parameters = *table_parameters;
@@ -81,6 +353,9 @@ struct mapistore_subscription *mapistore_new_subscription(TALLOC_CTX *mem_ctx,
         else {
                 object_parameters = notification_parameters;
                 new_subscription->parameters.object_parameters = *object_parameters;
+#if 0
+		new_subscription->mqueue = -1;
+		new_subscription->mqueue_name = NULL;
 
 		/* NewMail POC: open newmail mail queue */
 		if (notification_types & fnevNewMail || notification_types & fnevObjectCreated) {
@@ -132,23 +407,132 @@ struct mapistore_subscription *mapistore_new_subscription(TALLOC_CTX *mem_ctx,
 			ret = mapistore_mgmt_interface_register_subscription(&c, &n);
 			DEBUG(0, ("[%s:%d]: registering notification: %d\n", __FUNCTION__, __LINE__, ret));
 		}
+#endif
 	}
 
         return new_subscription;
-#endif
+}
+
+/**
+   \details Add a subscription to the mapistore context
+
+   The subscription is inserted in mstore_ctx->subscriptions and
+   indexed in the subscription registry. Releasing the list element
+   with talloc_free removes the subscription from the registry.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param subscription_list pointer to the list element holding the
+   subscription
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error mapistore_add_subscription(struct mapistore_context *mstore_ctx,
+							 struct mapistore_subscription_list *subscription_list)
+{
+	struct mapistore_subscription_index	*index;
+	struct mapistore_subscription_entry	*entry;
+
+	/* Sanity checks */
+	MAPISTORE_RETVAL_IF(!mstore_ctx, MAPISTORE_ERR_NOT_INITIALIZED, NULL);
+	MAPISTORE_RETVAL_IF(!subscription_list, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+	MAPISTORE_RETVAL_IF(!subscription_list->subscription, MAPISTORE_ERR_INVALID_PARAMETER, NULL);
+
+	index = mapistore_subscription_index_get(mstore_ctx);
+	MAPISTORE_RETVAL_IF(!index, MAPISTORE_ERR_NO_MEMORY, NULL);
 
-	return NULL;
+	entry = talloc_zero(subscription_list, struct mapistore_subscription_entry);
+	MAPISTORE_RETVAL_IF(!entry, MAPISTORE_ERR_NO_MEMORY, NULL);
+
+	entry->element = subscription_list;
+	entry->table = (subscription_list->subscription->notification_types == fnevTableModified);
+	entry->handle_node.entry = entry;
+	entry->folder_node.entry = entry;
+
+	if (index->count >= index->size * 2) {
+		mapistore_subscription_index_grow(index);
+	}
+
+	entry->index = index;
+	mapistore_subscription_link(index, entry);
+	DLIST_ADD(index->entries, entry);
+	index->count++;
+	talloc_set_destructor(entry, mapistore_subscription_entry_destructor);
+
+	DLIST_ADD(mstore_ctx->subscriptions, subscription_list);
+
+	return MAPISTORE_SUCCESS;
 }
 
+/**
+   \details Check whether a pending table notification already
+   describes the change of a new one
+
+   \param notification pointer to the pending notification
+   \param event the event of the new notification
+   \param parameters pointer to the parameters of the new notification
+
+   \return true if the notifications describe the same change, otherwise false
+ */
+static bool mapistore_table_notification_equal(struct mapistore_notification *notification,
+					       enum mapistore_notification_type event,
+					       struct mapistore_table_notification_parameters *parameters)
+{
+	struct mapistore_table_notification_parameters	*pending;
+
+	if (notification->object_type != MAPISTORE_TABLE || notification->event != event) {
+		return false;
+	}
+
+	pending = &notification->parameters.table_parameters;
+
+	return (pending->handle == parameters->handle
+		&& pending->table_type == parameters->table_type
+		&& pending->folder_id == parameters->folder_id
+		&& pending->object_id == parameters->object_id
+		&& pending->instance_id == parameters->instance_id);
+}
+
+/**
+   \details Queue a notification until the end of the current transaction
+
+   Repeated table notifications for the same row are coalesced: only
+   the last row position is kept. Pending table notifications are
+   looked up in the registry rather than by walking the pending list.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param object_type the type of the object the notification is about
+   \param event the notification event
+   \param parameters pointer to the table or object notification parameters
+ */
 _PUBLIC_ void mapistore_push_notification(struct mapistore_context *mstore_ctx, uint8_t object_type, enum mapistore_notification_type event, void *parameters)
 {
-#if 0
         struct mapistore_notification *new_notification;
         struct mapistore_notification_list *new_list;
         struct mapistore_table_notification_parameters *table_parameters;
         struct mapistore_object_notification_parameters *object_parameters;
+	struct mapistore_subscription_index *index = NULL;
+	struct mapistore_pending_entry *entry;
+	uint32_t bucket = 0;
 
-        if (!mstore_ctx) return;
+        if (!mstore_ctx || !parameters) return;
+
+	if (object_type == MAPISTORE_TABLE) {
+		table_parameters = parameters;
+		index = mapistore_subscription_index_get(mstore_ctx);
+		if (index) {
+			if (index->pending_count >= index->pending_size * 2) {
+				mapistore_pending_index_grow(index);
+			}
+			bucket = mapistore_pending_hash(index->pending_size, table_parameters);
+			for (entry = index->pending[bucket]; entry; entry = entry->next) {
+				if (mapistore_table_notification_equal(entry->element->notification, event, table_parameters)) {
+					entry->element->notification->parameters.table_parameters.row_id = table_parameters->row_id;
+					DEBUG(5, ("[%s:%d]: table notification coalesced\n", __FUNCTION__, __LINE__));
+					return;
+				}
+			}
+		}
+	}
 
 	new_list = talloc_zero(mstore_ctx, struct mapistore_notification_list);
 	new_notification = talloc_zero(new_list, struct mapistore_notification);
@@ -158,6 +542,17 @@ _PUBLIC_ void mapistore_push_notification(struct mapistore_context *mstore_ctx,
 	if (object_type == MAPISTORE_TABLE) {
 		table_parameters = parameters;
 		new_notification->parameters.table_parameters = *table_parameters;
+
+		/* Releasing the list element removes it from the registry */
+		entry = index ? talloc_zero(new_list, struct mapistore_pending_entry) : NULL;
+		if (entry) {
+			entry->index = index;
+			entry->element = new_list;
+			entry->bucket = bucket;
+			DLIST_ADD(index->pending[bucket], entry);
+			index->pending_count++;
+			talloc_set_destructor(entry, mapistore_pending_entry_destructor);
+		}
 	}
 	else {
 		object_parameters = parameters;
@@ -170,7 +565,6 @@ _PUBLIC_ void mapistore_push_notification(struct mapistore_context *mstore_ctx,
 		}
 	}
 	DLIST_ADD_END(mstore_ctx->notifications, new_list, void);
-#endif
 }
 
 #if 0
@@ -419,7 +813,6 @@ _PUBLIC_ enum MAPISTATUS mapistore_get_queued_notifications(struct mapistore_con
 	return (found == false) ? MAPISTORE_ERR_NOT_FOUND : MAPISTORE_SUCCESS;
 }
 
-#if 0
 static bool notification_matches_subscription(struct mapistore_notification *notification, struct mapistore_subscription *subscription)
 {
         bool result;
@@ -474,26 +867,35 @@ static bool notification_matches_subscription(struct mapistore_notification *not
 
         return result;
 }
-#endif
 
+/**
+   \details Delete the subscription attached to a given handle
+
+   \param mstore_ctx pointer to the mapistore context
+   \param identifier the handle of the subscription
+   \param NotificationFlags the notification types of the subscription
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
 _PUBLIC_ enum mapistore_error mapistore_delete_subscription(struct mapistore_context *mstore_ctx, uint32_t identifier, 
 							    uint16_t NotificationFlags)
 {
-	struct mapistore_subscription_list *el;
+	struct mapistore_subscription_index	*index;
+	struct mapistore_subscription_node	*node;
+	struct mapistore_subscription_list	*el;
 
 	/* Sanity checks */
 	MAPISTORE_RETVAL_IF(!mstore_ctx, MAPISTORE_ERR_NOT_INITIALIZED, NULL);
 
-	for (el = mstore_ctx->subscriptions; el; el = el->next) {
+	index = mstore_ctx->subscription_index;
+	MAPISTORE_RETVAL_IF(!index, MAPISTORE_ERR_NOT_FOUND, NULL);
+
+	for (node = index->handles[mapistore_subscription_hash(index, identifier)]; node; node = node->next) {
+		el = node->entry->element;
 		if ((el->subscription->handle == identifier) &&
 		    (el->subscription->notification_types == NotificationFlags)) {
-			DEBUG(0, ("*** DELETING SUBSCRIPTION ***\n"));
-			DEBUG(0, ("subscription: handle = 0x%x\n", el->subscription->handle));
-			DEBUG(0, ("subscription: types = 0x%x\n", el->subscription->notification_types));
-#if 0
-			DEBUG(0, ("subscription: mqueue = %d\n", el->subscription->mqueue));
-			DEBUG(0, ("subscription: mqueue name = %s\n", el->subscription->mqueue_name));
-#endif
+			DEBUG(5, ("[%s:%d]: deleting subscription: handle = 0x%x, types = 0x%x\n",
+				  __FUNCTION__, __LINE__, identifier, NotificationFlags));
 			DLIST_REMOVE(mstore_ctx->subscriptions, el);
 			talloc_free(el);
 			return MAPISTORE_SUCCESS;
@@ -503,25 +905,69 @@ _PUBLIC_ enum mapistore_error mapistore_delete_subscription(struct mapistore_con
 	return MAPISTORE_ERR_NOT_FOUND;
 }
 
+static void mapistore_match_subscriptions(struct mapistore_context *mstore_ctx,
+					  struct mapistore_subscription_node *node,
+					  struct mapistore_notification *notification,
+					  bool table,
+					  struct mapistore_subscription_list **matching_subscriptions)
+{
+	struct mapistore_subscription_list	*new_element;
+
+	for (; node; node = node->next) {
+		if (node->entry->table != table) continue;
+		if (notification_matches_subscription(notification, node->entry->element->subscription)) {
+			new_element = talloc_memdup(mstore_ctx, node->entry->element, sizeof(struct mapistore_subscription_list));
+			if (!new_element) return;
+			DLIST_ADD(*matching_subscriptions, new_element);
+		}
+	}
+}
+
+/**
+   \details Return the list of subscriptions matching a notification
+
+   Only the registry buckets which can match the notification are
+   examined: the handle bucket for table notifications, the folder
+   bucket and the whole store bucket for folder and message
+   notifications.
+
+   \param mstore_ctx pointer to the mapistore context
+   \param notification pointer to the notification
+
+   \return list of copies of the matching subscription elements, to be
+   released by the caller, or NULL if no subscription matches
+ */
 _PUBLIC_ struct mapistore_subscription_list *mapistore_find_matching_subscriptions(struct mapistore_context *mstore_ctx, struct mapistore_notification *notification)
 {
-#if 0
-        struct mapistore_subscription_list *matching_subscriptions, *new_element, *current_element;
+	struct mapistore_subscription_index	*index;
+	struct mapistore_subscription_list	*matching_subscriptions = NULL;
+	uint64_t				folder_id;
 
-	if (!mstore_ctx) return NULL;
+	if (!mstore_ctx || !notification) return NULL;
 
-        matching_subscriptions = NULL;
+	index = mstore_ctx->subscription_index;
+	if (!index || !index->count) return NULL;
 
-        current_element = mstore_ctx->subscriptions;
-        while (current_element) {
-                if (notification_matches_subscription(notification, current_element->subscription)) {
-                        new_element = talloc_memdup(mstore_ctx, current_element, sizeof(struct mapistore_subscription_list));
-                        DLIST_ADD_END(matching_subscriptions, new_element, void);
-                }
-                current_element = current_element->next;
-        }
-        
-        return matching_subscriptions;
-#endif
-	return NULL;
+	if (notification->object_type == MAPISTORE_TABLE) {
+		mapistore_match_subscriptions(mstore_ctx, index->handles[mapistore_subscription_hash(index, notification->parameters.table_parameters.handle)],
+					      notification, true, &matching_subscriptions);
+		return matching_subscriptions;
+	}
+
+	mapistore_match_subscriptions(mstore_ctx, index->whole_store, notification, false, &matching_subscriptions);
+
+	if (notification->object_type == MAPISTORE_FOLDER) {
+		folder_id = notification->parameters.object_parameters.object_id;
+	}
+	else if (notification->object_type == MAPISTORE_MESSAGE) {
+		folder_id = notification->parameters.object_parameters.folder_id;
+	}
+	else {
+		return matching_subscriptions;
+	}
+
+	mapistore_match_subscriptions(mstore_ctx, index->folders[mapistore_subscription_hash(index, folder_id)],
+				      notification, false, &matching_subscriptions);
+
+	return matching_subscriptions;
 }
@@ -164,9 +164,11 @@ enum mapistore_error mapistore_backend_get_path(struct backend_context *, TALLOC
 enum mapistore_error mapistore_backend_folder_open_folder(struct backend_context *, void *, TALLOC_CTX *, uint64_t, void **);
 enum mapistore_error mapistore_backend_folder_create_folder(struct backend_context *, void *, TALLOC_CTX *, uint64_t, struct SRow *, void **);
 enum mapistore_error mapistore_backend_folder_delete(struct backend_context *, void *);
+enum mapistore_error mapistore_backend_folder_empty(struct backend_context *, void *, TALLOC_CTX *, bool, uint8_t, struct UI8Array_r **);
 enum mapistore_error mapistore_backend_folder_open_message(struct backend_context *, void *, TALLOC_CTX *, uint64_t, bool, void **);
 enum mapistore_error mapistore_backend_folder_create_message(struct backend_context *, void *, TALLOC_CTX *, uint64_t, uint8_t, void **);
 enum mapistore_error mapistore_backend_folder_delete_message(struct backend_context *, void *, uint64_t, uint8_t);
+enum mapistore_error mapistore_backend_folder_delete_messages(struct backend_context *, void *, uint32_t, const uint64_t *, uint8_t);
 enum mapistore_error mapistore_backend_folder_move_copy_messages(struct backend_context *, void *, void *, TALLOC_CTX *, uint32_t, uint64_t *, uint64_t *, struct Binary_r **, uint8_t);
 enum mapistore_error mapistore_backend_folder_move_folder(struct backend_context *, void *, void *, TALLOC_CTX *, const char *);
 enum mapistore_error mapistore_backend_folder_copy_folder(struct backend_context *, void *, void *, TALLOC_CTX *, bool, const char *);
@@ -176,6 +178,8 @@ enum mapistore_error mapistore_backend_folder_get_child_fid_by_name(struct backe
 enum mapistore_error mapistore_backend_folder_open_table(struct backend_context *, void *, TALLOC_CTX *, enum mapistore_table_type, uint32_t, void **, uint32_t *);
 enum mapistore_error mapistore_backend_folder_modify_permissions(struct backend_context *, void *, uint8_t, uint16_t, struct PermissionData *);
 enum mapistore_error mapistore_backend_folder_preload_message_bodies(struct backend_context *, void *, enum mapistore_table_type, const struct UI8Array_r *);
+bool mapistore_backend_folder_has_set_read_flags(struct backend_context *);
+enum mapistore_error mapistore_backend_folder_set_read_flags(struct backend_context *, void *, uint8_t, uint16_t, const uint64_t *, const struct UI8Array_r *);
 
 enum mapistore_error mapistore_backend_message_get_message_data(struct backend_context *, void *, TALLOC_CTX *, struct mapistore_message **);
 enum mapistore_error mapistore_backend_message_modify_recipients(struct backend_context *, void *, struct SPropTagArray *, uint16_t, struct mapistore_message_recipient *);
@@ -194,6 +198,7 @@ enum mapistore_error mapistore_backend_table_set_restrictions(struct backend_con
 enum mapistore_error mapistore_backend_table_set_sort_order(struct backend_context *, void *, struct SSortOrderSet *, uint8_t *);
 enum mapistore_error mapistore_backend_table_get_row(struct backend_context *, void *, TALLOC_CTX *, enum mapistore_query_type, uint32_t, struct mapistore_property_data **);
 enum mapistore_error mapistore_backend_table_get_row_count(struct backend_context *, void *, enum mapistore_query_type, uint32_t *);
+enum mapistore_error mapistore_backend_table_find_row(struct backend_context *, void *, struct mapi_SRestriction *, enum FindRow_ulFlags, uint32_t, uint32_t *);
 enum mapistore_error mapistore_backend_table_handle_destructor(struct backend_context *, void *, uint32_t);
 
 enum mapistore_error mapistore_backend_properties_get_available_properties(struct backend_context *, void *, TALLOC_CTX *, struct SPropTagArray **);
@@ -0,0 +1,304 @@
+/*
+   OpenChange Storage Abstraction Layer library test tool
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapiproxy/libmapistore/mapistore.h"
+#include "mapiproxy/libmapistore/mapistore_errors.h"
+#include <talloc.h>
+#include <dlinklist.h>
+#include <core/ntstatus.h>
+#include <popt.h>
+#include <param.h>
+#include <util/debug.h>
+#include <time.h>
+
+/**
+   \file mapistore_notification_test.c
+
+   \brief Stress test of the mapistore subscription registry
+
+   Registers a large number of table, folder and whole store
+   subscriptions on a standalone mapistore context, then checks and
+   times notification matching, table notification coalescing and
+   subscription deletion.
+ */
+
+#define	TEST_FOLDERS		100
+#define	TEST_FOLDER_BASE	0x10001ULL
+
+static uint64_t test_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t test_count_matches(struct mapistore_context *mstore_ctx,
+				   struct mapistore_notification *notification)
+{
+	struct mapistore_subscription_list	*list;
+	struct mapistore_subscription_list	*el;
+	uint32_t				count = 0;
+
+	list = mapistore_find_matching_subscriptions(mstore_ctx, notification);
+	while ((el = list)) {
+		DLIST_REMOVE(list, el);
+		talloc_free(el);
+		count++;
+	}
+
+	return count;
+}
+
+static bool test_register(struct mapistore_context *mstore_ctx, uint32_t handle,
+			  uint16_t types, void *parameters)
+{
+	struct mapistore_subscription_list	*subscription_list;
+
+	subscription_list = talloc_zero(mstore_ctx, struct mapistore_subscription_list);
+	subscription_list->subscription = mapistore_new_subscription(subscription_list, mstore_ctx, "test",
+								     handle, types, parameters);
+	if (mapistore_add_subscription(mstore_ctx, subscription_list) != MAPISTORE_SUCCESS) {
+		talloc_free(subscription_list);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+   \details Check the subscriptions matching a message created
+   notification in each folder
+
+   \return the number of folders with an unexpected result
+ */
+static uint32_t test_folders(struct mapistore_context *mstore_ctx, uint32_t *expected,
+			     uint32_t whole_store, uint64_t *usec)
+{
+	struct mapistore_notification	notification;
+	uint64_t			start;
+	uint32_t			count;
+	uint32_t			errors = 0;
+	uint32_t			f;
+
+	memset(&notification, 0, sizeof (struct mapistore_notification));
+	notification.object_type = MAPISTORE_MESSAGE;
+	notification.event = MAPISTORE_OBJECT_CREATED;
+
+	start = test_now();
+	for (f = 0; f < TEST_FOLDERS; f++) {
+		notification.parameters.object_parameters.folder_id = TEST_FOLDER_BASE + f;
+		notification.parameters.object_parameters.object_id = 0x42;
+		count = test_count_matches(mstore_ctx, &notification);
+		if (count != expected[f] + whole_store) {
+			DEBUG(0, ("folder 0x%"PRIx64": %u matches, expected %u\n",
+				  TEST_FOLDER_BASE + f, count, expected[f] + whole_store));
+			errors++;
+		}
+	}
+	*usec = test_now() - start;
+
+	return errors;
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX					*mem_ctx;
+	struct mapistore_context			*mstore_ctx;
+	struct loadparm_context				*lp_ctx;
+	struct mapistore_table_subscription_parameters	table_parameters;
+	struct mapistore_object_subscription_parameters	object_parameters;
+	struct mapistore_table_notification_parameters	table_notification;
+	struct mapistore_notification			notification;
+	struct mapistore_notification_list		*nl;
+	struct mapistore_subscription_list		*el;
+	poptContext					pc;
+	int						opt;
+	const char					*opt_debug = NULL;
+	uint32_t					opt_count = 10000;
+	uint32_t					expected[TEST_FOLDERS];
+	uint32_t					whole_store = 0;
+	uint32_t					tables = 0;
+	uint32_t					errors = 0;
+	uint32_t					count;
+	uint32_t					i;
+	uint64_t					start;
+	uint64_t					usec;
+
+	enum { OPT_DEBUG=1000, OPT_COUNT };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "debuglevel",	'd', POPT_ARG_STRING, NULL, OPT_DEBUG,	"set the debug level", NULL },
+		{ "count",	'c', POPT_ARG_STRING, NULL, OPT_COUNT,	"number of subscriptions (default: 10000)", NULL },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	mem_ctx = talloc_named(NULL, 0, "mapistore_notification_test");
+	lp_ctx = loadparm_init_global(true);
+	setup_logging(NULL, DEBUG_STDOUT);
+
+	pc = poptGetContext("mapistore_notification_test", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_DEBUG:
+			opt_debug = poptGetOptArg(pc);
+			break;
+		case OPT_COUNT:
+			opt_count = strtoul(poptGetOptArg(pc), NULL, 10);
+			break;
+		}
+	}
+
+	poptFreeContext(pc);
+
+	if (opt_debug) {
+		lpcfg_set_cmdline(lp_ctx, "log level", opt_debug);
+	}
+
+	/* The registry does not need any backend */
+	mstore_ctx = talloc_zero(mem_ctx, struct mapistore_context);
+	memset(expected, 0, sizeof (expected));
+
+	/* Step 1. Register table, folder and whole store subscriptions */
+	start = test_now();
+	for (i = 0; i < opt_count; i++) {
+		switch (i % 10) {
+		case 0: case 1: case 2: case 3: case 4: case 5:
+			table_parameters.table_type = MAPISTORE_MESSAGE_TABLE;
+			table_parameters.folder_id = TEST_FOLDER_BASE + (i % TEST_FOLDERS);
+			if (test_register(mstore_ctx, i + 1, fnevTableModified, &table_parameters)) {
+				tables++;
+			}
+			break;
+		case 6: case 7: case 8:
+			object_parameters.whole_store = false;
+			object_parameters.folder_id = TEST_FOLDER_BASE + (i % TEST_FOLDERS);
+			object_parameters.object_id = 0;
+			if (test_register(mstore_ctx, i + 1, fnevObjectCreated|fnevObjectModified, &object_parameters)) {
+				expected[i % TEST_FOLDERS]++;
+			}
+			break;
+		default:
+			object_parameters.whole_store = true;
+			object_parameters.folder_id = 0;
+			object_parameters.object_id = 0;
+			if (test_register(mstore_ctx, i + 1, fnevObjectCreated, &object_parameters)) {
+				whole_store++;
+			}
+			break;
+		}
+	}
+	usec = test_now() - start;
+	printf("registered %u subscriptions in %"PRIu64" usec\n", opt_count, usec);
+
+	/* Step 2. Folder and message notifications */
+	errors += test_folders(mstore_ctx, expected, whole_store, &usec);
+	printf("matched %u message notifications in %"PRIu64" usec\n", TEST_FOLDERS, usec);
+
+	/* Step 3. Table notifications, one subscription per handle */
+	memset(&notification, 0, sizeof (struct mapistore_notification));
+	notification.object_type = MAPISTORE_TABLE;
+	notification.event = MAPISTORE_OBJECT_MODIFIED;
+	notification.parameters.table_parameters.table_type = MAPISTORE_MESSAGE_TABLE;
+
+	start = test_now();
+	for (i = 0; i < opt_count; i++) {
+		if ((i % 10) > 5) continue;
+		notification.parameters.table_parameters.handle = i + 1;
+		notification.parameters.table_parameters.folder_id = TEST_FOLDER_BASE + (i % TEST_FOLDERS);
+		if (test_count_matches(mstore_ctx, &notification) != 1) {
+			DEBUG(0, ("table notification on handle 0x%x did not match\n", i + 1));
+			errors++;
+		}
+	}
+	usec = test_now() - start;
+	printf("matched %u table notifications in %"PRIu64" usec\n", tables, usec);
+
+	/* Step 4. Repeated table notifications are coalesced */
+	memset(&table_notification, 0, sizeof (struct mapistore_table_notification_parameters));
+	table_notification.table_type = MAPISTORE_MESSAGE_TABLE;
+	table_notification.handle = 1;
+	table_notification.folder_id = TEST_FOLDER_BASE;
+	table_notification.object_id = 0x42;
+	for (i = 0; i < 100; i++) {
+		table_notification.row_id = i;
+		mapistore_push_notification(mstore_ctx, MAPISTORE_TABLE, MAPISTORE_OBJECT_MODIFIED, &table_notification);
+	}
+	for (count = 0, nl = mstore_ctx->notifications; nl; nl = nl->next) {
+		count++;
+	}
+	if (count != 1 || mstore_ctx->notifications->notification->parameters.table_parameters.row_id != 99) {
+		DEBUG(0, ("%u pending table notifications, expected 1\n", count));
+		errors++;
+	}
+	while ((nl = mstore_ctx->notifications)) {
+		DLIST_REMOVE(mstore_ctx->notifications, nl);
+		talloc_free(nl);
+	}
+
+	/* Released notifications are no longer coalesced */
+	mapistore_push_notification(mstore_ctx, MAPISTORE_TABLE, MAPISTORE_OBJECT_MODIFIED, &table_notification);
+	if (!mstore_ctx->notifications || mstore_ctx->notifications->next) {
+		DEBUG(0, ("released table notification was coalesced\n"));
+		errors++;
+	}
+	while ((nl = mstore_ctx->notifications)) {
+		DLIST_REMOVE(mstore_ctx->notifications, nl);
+		talloc_free(nl);
+	}
+
+	/* Step 5. Delete every other folder subscription by handle */
+	start = test_now();
+	for (i = 0; i < opt_count; i++) {
+		if ((i % 10) < 6 || (i % 10) > 8 || (i % 2)) continue;
+		if (mapistore_delete_subscription(mstore_ctx, i + 1, fnevObjectCreated|fnevObjectModified) != MAPISTORE_SUCCESS) {
+			DEBUG(0, ("unable to delete subscription 0x%x\n", i + 1));
+			errors++;
+			continue;
+		}
+		expected[i % TEST_FOLDERS]--;
+	}
+	usec = test_now() - start;
+	printf("deleted folder subscriptions in %"PRIu64" usec\n", usec);
+
+	if (mapistore_delete_subscription(mstore_ctx, 1, fnevObjectCreated) != MAPISTORE_ERR_NOT_FOUND) {
+		DEBUG(0, ("deleted a subscription with mismatching notification types\n"));
+		errors++;
+	}
+
+	errors += test_folders(mstore_ctx, expected, whole_store, &usec);
+
+	/* Step 6. Releasing the list element unregisters the subscription */
+	while ((el = mstore_ctx->subscriptions)) {
+		DLIST_REMOVE(mstore_ctx->subscriptions, el);
+		talloc_free(el);
+	}
+	memset(expected, 0, sizeof (expected));
+	errors += test_folders(mstore_ctx, expected, 0, &usec);
+
+	talloc_free(mem_ctx);
+
+	printf("%s: %u error(s)\n", errors ? "FAILURE" : "SUCCESS", errors);
+
+	return errors ? 1 : 0;
+}
@@ -27,16 +27,52 @@
 
 #include "mapiproxy/dcesrv_mapiproxy.h"
 #include "mapiproxy/libmapiproxy/libmapiproxy.h"
+#include "gen_ndr/ndr_exchange_c.h"
 #include <util/debug.h>
+#include <dlinklist.h>
+#include <tevent.h>
 
 #define	MPM_NAME	"mpm_pack"
 #define	MPM_PACK_ERROR	"[ERROR] mpm_pack:"
 
+#define	MPM_PACK_COALESCE_WINDOW	500
+#define	MPM_PACK_COALESCE_MAX		64
+
 NTSTATUS samba_init_module(void);
 
+/**
+   Per-session coalescing state: Release calls received from the
+   client and not yet forwarded upstream
+ */
+struct mpm_pack_session {
+	struct mpm_session		*session;
+	uint32_t			*handles;
+	uint8_t				*logon_ids;
+	uint32_t			count;
+	struct timeval			tv_first;
+	struct tevent_timer		*te;
+	struct dcerpc_pipe		*c_pipe;
+	struct policy_handle		handle;
+	uint32_t			size;
+	uint16_t			max_data;
+	uint32_t			appended;
+	uint32_t			upstream_calls;
+	uint32_t			deferred_calls;
+	uint32_t			coalesced_rops;
+	struct mpm_pack_session		*prev;
+	struct mpm_pack_session		*next;
+};
+
 static struct mpm_pack {
-	uint8_t		*mapi_calls;
-	bool		lasthop;
+	uint8_t				*mapi_calls;
+	bool				lasthop;
+	bool				coalesce;
+	uint32_t			coalesce_window;
+	uint32_t			coalesce_max;
+	uint32_t			upstream_calls;
+	uint32_t			deferred_calls;
+	uint32_t			coalesced_rops;
+	struct mpm_pack_session		*sessions;
 } *mpm = NULL;
 
 
@@ -227,9 +263,390 @@ static bool pack(TALLOC_CTX *mem_ctx, struct EcDoRpc *EcDoRpc)
 	return true;
 }
 
+/**
+   \details Dump round trip statistics for a session and for the
+   whole module
+
+   \param psession pointer to the session to report
+ */
+static void coalesce_dump_stat(struct mpm_pack_session *psession)
+{
+	DEBUG(1, ("%s: session: %d upstream calls, %d calls answered locally, %d Release coalesced\n",
+		  MPM_NAME, psession->upstream_calls, psession->deferred_calls, psession->coalesced_rops));
+	DEBUG(1, ("%s: total: %d upstream calls, %d round trips saved (%d%%), %d Release coalesced\n",
+		  MPM_NAME, mpm->upstream_calls, mpm->deferred_calls,
+		  (mpm->upstream_calls + mpm->deferred_calls) ?
+		  (mpm->deferred_calls * 100) / (mpm->upstream_calls + mpm->deferred_calls) : 0,
+		  mpm->coalesced_rops));
+}
+
+
+/**
+   \details Retrieve the coalescing state associated to the current
+   session, create it if it does not exist yet
+
+   \param dce_call pointer to the session context
+
+   \return pointer to the mpm_pack_session on success, otherwise NULL
+ */
+static struct mpm_pack_session *coalesce_session(struct dcesrv_call_state *dce_call)
+{
+	struct mpm_pack_session	*psession;
+
+	for (psession = mpm->sessions; psession; psession = psession->next) {
+		if (mpm_session_cmp(psession->session, dce_call) == true) {
+			return psession;
+		}
+	}
+
+	psession = talloc_zero(mpm, struct mpm_pack_session);
+	if (!psession) return NULL;
+
+	psession->session = mpm_session_init(psession, dce_call);
+	if (!psession->session) {
+		talloc_free(psession);
+		return NULL;
+	}
+	psession->handles = talloc_array(psession, uint32_t, mpm->coalesce_max);
+	psession->logon_ids = talloc_array(psession, uint8_t, mpm->coalesce_max);
+
+	DLIST_ADD_END(mpm->sessions, psession, struct mpm_pack_session *);
+
+	return psession;
+}
+
+
+/**
+   \details Check whether a request only contains Release calls
+
+   Release calls do not produce any response buffer, so such a
+   request can be acknowledged locally and its handles released later
+   along with the next request sent upstream. Requests referencing a
+   handle index outside of their handle table are left to the server.
+
+   \param mapi_request pointer to the MAPI request
+
+   \return number of Release calls if the request only contains
+   valid Release calls, otherwise 0
+ */
+static uint32_t coalesce_release_only(struct mapi_request *mapi_request)
+{
+	struct EcDoRpc_MAPI_REQ	*mapi_req;
+	uint32_t		handles_count;
+	uint32_t		i;
+
+	if (mapi_request->mapi_len < mapi_request->length) return 0;
+	handles_count = (mapi_request->mapi_len - mapi_request->length) / sizeof (uint32_t);
+
+	mapi_req = mapi_request->mapi_req;
+	for (i = 0; mapi_req[i].opnum; i++) {
+		if (mapi_req[i].opnum != op_MAPI_Release) {
+			return 0;
+		}
+		if (mapi_req[i].handle_idx >= handles_count) {
+			return 0;
+		}
+	}
+
+	return i;
+}
+
+
+/**
+   \details Send the deferred Release calls of a session upstream in
+   a request of their own
+
+   This is used when no other request of the session came in before
+   the end of the coalescing window, and when the session is torn
+   down.
+
+   \param psession pointer to the coalescing state of the session
+ */
+static void coalesce_flush(struct mpm_pack_session *psession)
+{
+	TALLOC_CTX		*mem_ctx;
+	struct EcDoRpc		r;
+	struct mapi_request	*mapi_request;
+	uint16_t		length;
+	NTSTATUS		status;
+	uint32_t		i;
+
+	if (!psession->count || !psession->c_pipe) return;
+
+	mem_ctx = talloc_named(NULL, 0, "coalesce_flush");
+
+	mapi_request = talloc_zero(mem_ctx, struct mapi_request);
+	mapi_request->mapi_req = talloc_array(mem_ctx, struct EcDoRpc_MAPI_REQ, psession->count + 1);
+	mapi_request->handles = talloc_array(mem_ctx, uint32_t, psession->count);
+	for (i = 0; i < psession->count; i++) {
+		mapi_request->mapi_req[i].opnum = op_MAPI_Release;
+		mapi_request->mapi_req[i].logon_id = psession->logon_ids[i];
+		mapi_request->mapi_req[i].handle_idx = i;
+		mapi_request->handles[i] = psession->handles[i];
+	}
+	mapi_request->mapi_req[psession->count].opnum = 0;
+
+	/* opnum, logon_id and handle_idx for each Release call */
+	mapi_request->length = sizeof (uint16_t) + psession->count * 3;
+	mapi_request->mapi_len = mapi_request->length + psession->count * sizeof (uint32_t);
+
+	length = mapi_request->mapi_len;
+	ZERO_STRUCT(r);
+	r.in.handle = r.out.handle = &psession->handle;
+	r.in.size = psession->size;
+	r.in.offset = 0x0;
+	r.in.mapi_request = mapi_request;
+	r.in.length = r.out.length = &length;
+	r.in.max_data = psession->max_data;
+
+	DEBUG(5, ("%s: flushing %d deferred Release calls\n", MPM_NAME, psession->count));
+
+	status = dcerpc_EcDoRpc_r(psession->c_pipe->binding_handle, mem_ctx, &r);
+	if (!NT_STATUS_IS_OK(status) || r.out.result != MAPI_E_SUCCESS) {
+		DEBUG(1, ("%s: failed to flush deferred Release calls: %s\n", MPM_NAME, nt_errstr(status)));
+	}
+
+	psession->coalesced_rops += psession->count;
+	mpm->coalesced_rops += psession->count;
+	psession->upstream_calls++;
+	mpm->upstream_calls++;
+	psession->count = 0;
+
+	talloc_free(mem_ctx);
+}
+
+
+/**
+   \details Flush the deferred Release calls of an idle session once
+   the coalescing window has elapsed
+ */
+static void coalesce_timer(struct tevent_context *ev, struct tevent_timer *te,
+			   struct timeval current_time, void *private_data)
+{
+	struct mpm_pack_session	*psession = (struct mpm_pack_session *) private_data;
+
+	psession->te = NULL;
+	coalesce_flush(psession);
+}
+
+
+/**
+   \details Store the handles released by the request for later
+   submission and build an empty response
+
+   \param dce_call pointer to the session context
+   \param mem_ctx pointer to the memory context
+   \param psession pointer to the coalescing state of the session
+   \param EcDoRpc pointer to the EcDoRpc operation
+ */
+static void coalesce_defer(struct dcesrv_call_state *dce_call, TALLOC_CTX *mem_ctx,
+			   struct mpm_pack_session *psession, struct EcDoRpc *EcDoRpc)
+{
+	struct dcesrv_mapiproxy_private	*private;
+	struct mapi_request	*mapi_request;
+	struct mapi_response	*mapi_response;
+	uint32_t		handles_count;
+	uint32_t		i;
+
+	mapi_request = EcDoRpc->in.mapi_request;
+	mapi_response = EcDoRpc->out.mapi_response;
+
+	if (!psession->count) {
+		psession->tv_first = timeval_current();
+	}
+
+	/* Keep what is needed to send the Release calls on our own if
+	   the session stays idle */
+	private = (struct dcesrv_mapiproxy_private *) dce_call->context->private_data;
+	psession->c_pipe = private->c_pipe;
+	psession->handle = *EcDoRpc->in.handle;
+	psession->size = EcDoRpc->in.size;
+	psession->max_data = EcDoRpc->in.max_data;
+	if (!psession->te) {
+		psession->te = tevent_add_timer(dce_call->event_ctx, psession,
+						timeval_current_ofs(mpm->coalesce_window / 1000, (mpm->coalesce_window % 1000) * 1000),
+						coalesce_timer, psession);
+	}
+
+	for (i = 0; mapi_request->mapi_req[i].opnum; i++) {
+		psession->handles[psession->count] = mapi_request->handles[mapi_request->mapi_req[i].handle_idx];
+		psession->logon_ids[psession->count] = mapi_request->mapi_req[i].logon_id;
+		psession->count++;
+	}
+
+	/* Release calls have no response: send back the handle table only,
+	   Release leaves the handle slots untouched */
+	handles_count = (mapi_request->mapi_len - mapi_request->length) / sizeof (uint32_t);
+	mapi_response->mapi_repl = talloc_zero(mem_ctx, struct EcDoRpc_MAPI_REPL);
+	mapi_response->handles = talloc_array(mem_ctx, uint32_t, handles_count + 1);
+	for (i = 0; i < handles_count; i++) {
+		mapi_response->handles[i] = mapi_request->handles[i];
+	}
+	mapi_response->length = sizeof (uint16_t);
+	mapi_response->mapi_len = mapi_response->length + handles_count * sizeof (uint32_t);
+
+	*EcDoRpc->out.length = mapi_response->mapi_len;
+	EcDoRpc->out.size = EcDoRpc->in.size;
+	EcDoRpc->out.offset = EcDoRpc->in.offset;
+	EcDoRpc->out.result = MAPI_E_SUCCESS;
+
+	psession->deferred_calls++;
+	mpm->deferred_calls++;
+}
+
+
+/**
+   \details Append the deferred Release calls of the session to the
+   request being forwarded upstream
+
+   Released handles are appended at the end of the request handle
+   table and the handle_idx of each Release call rewritten
+   accordingly. The extra handles are stripped from the response in
+   coalesce_push.
+
+   \param mem_ctx pointer to the memory context
+   \param psession pointer to the coalescing state of the session
+   \param EcDoRpc pointer to the EcDoRpc operation
+ */
+static void coalesce_merge(TALLOC_CTX *mem_ctx, struct mpm_pack_session *psession, struct EcDoRpc *EcDoRpc)
+{
+	struct mapi_request	*mapi_request;
+	struct EcDoRpc_MAPI_REQ	*mapi_req;
+	uint32_t		*handles;
+	uint32_t		handles_count;
+	uint32_t		count;
+	uint32_t		i;
+
+	if (!psession->count) return;
+
+	mapi_request = EcDoRpc->in.mapi_request;
+	handles_count = (mapi_request->mapi_len - mapi_request->length) / sizeof (uint32_t);
+	if (handles_count + psession->count > 0xFF) return;
+
+	for (count = 0; mapi_request->mapi_req[count].opnum; count++);
+
+	mapi_req = talloc_array(mem_ctx, struct EcDoRpc_MAPI_REQ, count + psession->count + 1);
+	handles = talloc_array(mem_ctx, uint32_t, handles_count + psession->count + 1);
+	if (!mapi_req || !handles) return;
+
+	memcpy(mapi_req, mapi_request->mapi_req, count * sizeof (struct EcDoRpc_MAPI_REQ));
+	memcpy(handles, mapi_request->handles, handles_count * sizeof (uint32_t));
+
+	/* Release calls do not produce any reply: append them at the end */
+	for (i = 0; i < psession->count; i++) {
+		mapi_req[count + i].opnum = op_MAPI_Release;
+		mapi_req[count + i].logon_id = psession->logon_ids[i];
+		mapi_req[count + i].handle_idx = handles_count + i;
+		handles[handles_count + i] = psession->handles[i];
+	}
+	mapi_req[count + psession->count].opnum = 0;
+
+	/* opnum, logon_id and handle_idx for each Release call */
+	mapi_request->length += psession->count * 3;
+	mapi_request->mapi_len += psession->count * (3 + sizeof (uint32_t));
+	mapi_request->mapi_req = mapi_req;
+	mapi_request->handles = handles;
+
+	DEBUG(5, ("%s: %d Release calls coalesced into upstream request\n", MPM_NAME, psession->count));
+
+	psession->appended = psession->count;
+	psession->coalesced_rops += psession->count;
+	mpm->coalesced_rops += psession->count;
+	psession->count = 0;
+
+	/* Nothing left for the idle timer to flush */
+	talloc_free(psession->te);
+	psession->te = NULL;
+}
+
+
+/**
+   \details Decide whether the current EcDoRpc call can be
+   acknowledged locally or must be forwarded upstream along with
+   pending Release calls
+
+   \param dce_call pointer to the session context
+   \param mem_ctx pointer to the memory context
+   \param EcDoRpc pointer to the EcDoRpc operation
+   \param mapiproxy pointer to the mapiproxy structure controlling
+   mapiproxy behavior
+ */
+static void coalesce_dispatch(struct dcesrv_call_state *dce_call, TALLOC_CTX *mem_ctx,
+			      struct EcDoRpc *EcDoRpc, struct mapiproxy *mapiproxy)
+{
+	struct dcesrv_mapiproxy_private	*private;
+	struct mpm_pack_session		*psession;
+	uint32_t			count;
+
+	/* Deferred Release calls can only be flushed through an upstream pipe */
+	private = (struct dcesrv_mapiproxy_private *) dce_call->context->private_data;
+	if (!private || private->server_mode == true || !private->c_pipe) return;
+
+	psession = coalesce_session(dce_call);
+	if (!psession) return;
+
+	/* Subsequent read-ahead iterations of other modules */
+	if (mapiproxy->ahead == true) return;
+
+	psession->appended = 0;
+
+	count = coalesce_release_only(EcDoRpc->in.mapi_request);
+	if (count && (psession->count + count <= mpm->coalesce_max) &&
+	    (!psession->count || timeval_elapsed(&psession->tv_first) * 1000 < mpm->coalesce_window)) {
+		coalesce_defer(dce_call, mem_ctx, psession, EcDoRpc);
+		mapiproxy->norelay = true;
+		return;
+	}
+
+	coalesce_merge(mem_ctx, psession, EcDoRpc);
+	psession->upstream_calls++;
+	mpm->upstream_calls++;
+	if (!(mpm->upstream_calls % 1000)) {
+		coalesce_dump_stat(psession);
+	}
+}
+
+
+/**
+   \details Remove from the response the handles of Release calls
+   coalesced into the request
+
+   \param dce_call pointer to the session context
+   \param EcDoRpc pointer to the EcDoRpc operation
+ */
+static void coalesce_push(struct dcesrv_call_state *dce_call, struct EcDoRpc *EcDoRpc)
+{
+	struct mpm_pack_session	*psession;
+	struct mapi_response	*mapi_response;
+	uint32_t		size;
+
+	for (psession = mpm->sessions; psession; psession = psession->next) {
+		if (mpm_session_cmp(psession->session, dce_call) == true) break;
+	}
+	if (!psession || !psession->appended) return;
+
+	mapi_response = EcDoRpc->out.mapi_response;
+	size = psession->appended * sizeof (uint32_t);
+	psession->appended = 0;
+
+	if (!mapi_response || (mapi_response->mapi_len < mapi_response->length + size)) return;
+
+	mapi_response->mapi_len -= size;
+	*EcDoRpc->out.length -= size;
+}
+
+
 static NTSTATUS pack_push(struct dcesrv_call_state *dce_call,
 			  TALLOC_CTX *mem_ctx, void *r)
 {
+	if (mpm->coalesce == false) return NT_STATUS_OK;
+
+	if (dce_call->pkt.u.request.opnum != 0x2) {
+		return NT_STATUS_OK;
+	}
+
+	coalesce_push(dce_call, (struct EcDoRpc *) r);
+
 	return NT_STATUS_OK;
 }
 
@@ -277,6 +694,76 @@ static NTSTATUS pack_pull(struct dcesrv_call_state *dce_call, TALLOC_CTX *mem_ct
 }
 
 
+/**
+   \details Coalesce Release-only EcDoRpc requests
+
+   Requests only made of Release calls are acknowledged locally and
+   their handles released upstream with the next forwarded request of
+   the same session, saving one round trip each.
+
+   \param dce_call pointer to the session context
+   \param mem_ctx pointer to the memory context
+   \param r generic pointer on EcDoRpc operation
+   \param mapiproxy pointer to the mapiproxy structure controlling
+   mapiproxy behavior
+
+   \return NT_STATUS_OK
+ */
+static NTSTATUS pack_dispatch(struct dcesrv_call_state *dce_call, TALLOC_CTX *mem_ctx,
+			      void *r, struct mapiproxy *mapiproxy)
+{
+	struct EcDoRpc		*EcDoRpc;
+
+	if (mpm->coalesce == false) return NT_STATUS_OK;
+
+	if (dce_call->pkt.u.request.opnum != 0x2) {
+		return NT_STATUS_OK;
+	}
+
+	EcDoRpc = (struct EcDoRpc *) r;
+	if (!EcDoRpc->in.mapi_request->mapi_req) return NT_STATUS_OK;
+
+	/* If this is an idle request, do not go further */
+	if (EcDoRpc->in.mapi_request->length == 2) {
+		return NT_STATUS_OK;
+	}
+
+	coalesce_dispatch(dce_call, mem_ctx, EcDoRpc, mapiproxy);
+
+	return NT_STATUS_OK;
+}
+
+
+/**
+   \details Release coalescing state associated to a session
+
+   Pending Release calls are sent upstream before the state is
+   released, the upstream pipe is still connected at this point.
+
+   \param server_id reference to the server identifier structure
+   \param context_id the connection context identifier
+
+   \return NT_STATUS_OK
+ */
+static NTSTATUS pack_unbind(struct server_id server_id, uint32_t context_id)
+{
+	struct mpm_pack_session	*psession;
+
+	for (psession = mpm->sessions; psession; psession = psession->next) {
+		if (mpm_session_cmp_sub(psession->session, server_id, context_id) == true) {
+			coalesce_flush(psession);
+			coalesce_dump_stat(psession);
+			DLIST_REMOVE(mpm->sessions, psession);
+			mpm_session_release(psession->session);
+			talloc_free(psession);
+			break;
+		}
+	}
+
+	return NT_STATUS_OK;
+}
+
+
 /**
    \details Initialize the pack module and retrieve configuration from
    smb.conf.
@@ -284,6 +771,9 @@ static NTSTATUS pack_pull(struct dcesrv_call_state *dce_call, TALLOC_CTX *mem_ct
    Possible parameters:
    * mpm_pack:opnums = 0x1, 0x2, 0x3
    * mpm_pack:lasthop = true|false
+   * mpm_pack:coalesce = true|false
+   * mpm_pack:coalesce_window = 500
+   * mpm_pack:coalesce_max = 64
    
  */
 static NTSTATUS pack_init(struct dcesrv_context *dce_ctx)
@@ -323,6 +813,16 @@ static NTSTATUS pack_init(struct dcesrv_context *dce_ctx)
 	/* Fetch the lasthop parameter from smb.conf */
 	mpm->lasthop = lpcfg_parm_bool(dce_ctx->lp_ctx, NULL, MPM_NAME, "lasthop", true);
 
+	/* Fetch the coalescing parameters from smb.conf */
+	mpm->coalesce = lpcfg_parm_bool(dce_ctx->lp_ctx, NULL, MPM_NAME, "coalesce", false);
+	mpm->coalesce_window = lpcfg_parm_int(dce_ctx->lp_ctx, NULL, MPM_NAME, "coalesce_window", MPM_PACK_COALESCE_WINDOW);
+	mpm->coalesce_max = lpcfg_parm_int(dce_ctx->lp_ctx, NULL, MPM_NAME, "coalesce_max", MPM_PACK_COALESCE_MAX);
+	if (!mpm->coalesce_max || mpm->coalesce_max > 0xFF) {
+		DEBUG(0, ("%s: invalid coalesce_max value: %d\n", MPM_PACK_ERROR, mpm->coalesce_max));
+		talloc_free(mpm);
+		return NT_STATUS_INVALID_PARAMETER;
+	}
+
 	lp_ctx = loadparm_init(dce_ctx);
 	lpcfg_load_default(lp_ctx);
 	dcerpc_init();
@@ -348,11 +848,11 @@ NTSTATUS samba_init_module(void)
 
 	/* Fill in all the operations */
 	module.init = pack_init;
-	module.unbind = NULL;
+	module.unbind = pack_unbind;
 	module.push = pack_push;
 	module.ndr_pull = pack_ndr_pull;
 	module.pull = pack_pull;
-	module.dispatch = NULL;
+	module.dispatch = pack_dispatch;
 
 	/* Register ourselves with the MAPIPROXY subsystem */
 	ret = mapiproxy_module_register(&module);
@@ -359,6 +359,16 @@ static bool emsmdbp_fill_notification(TALLOC_CTX *mem_ctx,
                         }
                 }
 
+                /* Positional bookmarks are best-effort: they follow their row
+                   for the insertions and deletions reported here only. Rows
+                   changed by a restriction or a collapsed category, and rows of
+                   categorized views whose positions are not backend positions,
+                   are not tracked. */
+                if (!table->categories && (notification->event == MAPISTORE_OBJECT_CREATED || notification->event == MAPISTORE_OBJECT_DELETED)) {
+                        emsmdbp_object_table_move_bookmarks(handle_object, notification->parameters.table_parameters.row_id,
+                                                            (notification->event == MAPISTORE_OBJECT_CREATED));
+                }
+
                 if (notification->parameters.table_parameters.table_type == MAPISTORE_FOLDER_TABLE) {
                         if (notification->event == MAPISTORE_OBJECT_CREATED || notification->event == MAPISTORE_OBJECT_MODIFIED) {
                                 if (notification->parameters.table_parameters.row_id > 0) {
@@ -657,9 +667,14 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 	struct mapistore_subscription_list	*subscription_holder;
 	uint32_t		handles_length;
 	uint16_t		size = 0;
+	uint16_t		rop_size;
 	uint32_t		i;
 	uint32_t		idx;
 	bool			needs_realloc = true;
+	uint64_t		transaction_start;
+	uint64_t		rop_start;
+	uint64_t		backend_start;
+	uint64_t		rop_backend_start;
 
 	/* Sanity checks */
 	if (!emsmdbp_ctx) return NULL;
@@ -669,6 +684,13 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 	mapi_response = talloc_zero(mem_ctx, struct mapi_response);
 	mapi_response->handles = mapi_request->handles;
 
+	transaction_start = emsmdbp_stats_now();
+	backend_start = mapistore_backend_get_elapsed_time(emsmdbp_ctx->mstore_ctx);
+
+	/* The handles table and the RopSize field share the ROP buffer with the responses */
+	handles_length = mapi_request->mapi_len - mapi_request->length;
+	emsmdbp_ctx->rop_buffer_size = EMSMDB_MAX_ROP_BUFFER_SIZE - sizeof (uint16_t) - handles_length;
+
 	/* Step 1. Handle Idle requests case */
 	if (mapi_request->mapi_len <= 2) {
 		mapi_response->mapi_len = 2;
@@ -686,6 +708,11 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 								  struct EcDoRpc_MAPI_REPL, idx + 2);
 		}
 
+		retval = MAPI_E_NO_SUPPORT;
+		rop_size = size;
+		rop_start = emsmdbp_stats_now();
+		rop_backend_start = mapistore_backend_get_elapsed_time(emsmdbp_ctx->mstore_ctx);
+
 		switch (mapi_request->mapi_req[i].opnum) {
 		case op_MAPI_Release: /* 0x01 */
 			retval = EcDoRpc_RopRelease(mem_ctx, emsmdbp_ctx, 
@@ -808,7 +835,12 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 						      &(mapi_response->mapi_repl[idx]),
 						      mapi_response->handles, &size);
 			break;
-		/* op_MAPI_GetStatus: 0x16 */
+		case op_MAPI_GetStatus: /* 0x16 */
+			retval = EcDoRpc_RopGetStatus(mem_ctx, emsmdbp_ctx,
+						      &(mapi_request->mapi_req[i]),
+						      &(mapi_response->mapi_repl[idx]),
+						      mapi_response->handles, &size);
+			break;
 		case op_MAPI_QueryPosition: /* 0x17 */
 			retval = EcDoRpc_RopQueryPosition(mem_ctx, emsmdbp_ctx,
 							  &(mapi_request->mapi_req[i]),
@@ -821,9 +853,24 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 						    &(mapi_response->mapi_repl[idx]),
 						    mapi_response->handles, &size);
 			break;
-		/* op_MAPI_SeekRowBookmark: 0x19 */
-		/* op_MAPI_SeekRowApprox: 0x1a */
-		/* op_MAPI_CreateBookmark: 0x1b */
+		case op_MAPI_SeekRowBookmark: /* 0x19 */
+			retval = EcDoRpc_RopSeekRowBookmark(mem_ctx, emsmdbp_ctx,
+							    &(mapi_request->mapi_req[i]),
+							    &(mapi_response->mapi_repl[idx]),
+							    mapi_response->handles, &size);
+			break;
+		case op_MAPI_SeekRowApprox: /* 0x1a */
+			retval = EcDoRpc_RopSeekRowApprox(mem_ctx, emsmdbp_ctx,
+							  &(mapi_request->mapi_req[i]),
+							  &(mapi_response->mapi_repl[idx]),
+							  mapi_response->handles, &size);
+			break;
+		case op_MAPI_CreateBookmark: /* 0x1b */
+			retval = EcDoRpc_RopCreateBookmark(mem_ctx, emsmdbp_ctx,
+							   &(mapi_request->mapi_req[i]),
+							   &(mapi_response->mapi_repl[idx]),
+							   mapi_response->handles, &size);
+			break;
 		case op_MAPI_CreateFolder: /* 0x1c */
 			retval = EcDoRpc_RopCreateFolder(mem_ctx, emsmdbp_ctx,
 							 &(mapi_request->mapi_req[i]),
@@ -956,15 +1003,30 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 						       mapi_response->handles, &size);
 		        break;
 		/* op_MAPI_QueryColumnsAll: 0x37 */
-		/* op_MAPI_Abort: 0x38 */
+		case op_MAPI_Abort: /* 0x38 */
+			retval = EcDoRpc_RopAbort(mem_ctx, emsmdbp_ctx,
+						  &(mapi_request->mapi_req[i]),
+						  &(mapi_response->mapi_repl[idx]),
+						  mapi_response->handles, &size);
+			break;
 		case op_MAPI_CopyTo: /* 0x39 */
                         retval = EcDoRpc_RopCopyTo(mem_ctx, emsmdbp_ctx,
                                                    &(mapi_request->mapi_req[i]),
                                                    &(mapi_response->mapi_repl[idx]),
                                                    mapi_response->handles, &size);
 			break;
-		/* op_MAPI_CopyToStream: 0x3a */
-		/* op_MAPI_CloneStream: 0x3b */
+		case op_MAPI_CopyToStream: /* 0x3a */
+			retval = EcDoRpc_RopCopyToStream(mem_ctx, emsmdbp_ctx,
+							 &(mapi_request->mapi_req[i]),
+							 &(mapi_response->mapi_repl[idx]),
+							 mapi_response->handles, &size);
+			break;
+		case op_MAPI_CloneStream: /* 0x3b */
+			retval = EcDoRpc_RopCloneStream(mem_ctx, emsmdbp_ctx,
+							&(mapi_request->mapi_req[i]),
+							&(mapi_response->mapi_repl[idx]),
+							mapi_response->handles, &size);
+			break;
 		case op_MAPI_GetPermissionsTable: /* 0x3e */
 			retval = EcDoRpc_RopGetPermissionsTable(mem_ctx, emsmdbp_ctx,
 								&(mapi_request->mapi_req[i]),
@@ -1028,8 +1090,18 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 							  &(mapi_response->mapi_repl[idx]),
 							  mapi_response->handles, &size);
 			break;
-		/* op_MAPI_FastTransferSourceCopyMessages: 0x4b */
-		/* op_MAPI_FastTransferSourceCopyFolder: 0x4c */
+		case op_MAPI_FastTransferSourceCopyMessages: /* 0x4b */
+			retval = EcDoRpc_RopFastTransferSourceCopyMessages(mem_ctx, emsmdbp_ctx,
+									   &(mapi_request->mapi_req[i]),
+									   &(mapi_response->mapi_repl[idx]),
+									   mapi_response->handles, &size);
+			break;
+		case op_MAPI_FastTransferSourceCopyFolder: /* 0x4c */
+			retval = EcDoRpc_RopFastTransferSourceCopyFolder(mem_ctx, emsmdbp_ctx,
+									 &(mapi_request->mapi_req[i]),
+									 &(mapi_response->mapi_repl[idx]),
+									 mapi_response->handles, &size);
+			break;
 		case op_MAPI_FastTransferSourceCopyTo: /* 0x4d */
 			retval = EcDoRpc_RopFastTransferSourceCopyTo(mem_ctx, emsmdbp_ctx, 
 								     &(mapi_request->mapi_req[i]),
@@ -1051,6 +1123,18 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 		/* op_MAPI_Progress: 0x50 */
 		/* op_MAPI_TransportNewMail: 0x51 */
 		/* op_MAPI_GetValidAttachments: 0x52 */
+		case op_MAPI_FastTransferDestConfigure: /* 0x53 */
+			retval = EcDoRpc_RopFastTransferDestinationConfigure(mem_ctx, emsmdbp_ctx,
+									     &(mapi_request->mapi_req[i]),
+									     &(mapi_response->mapi_repl[idx]),
+									     mapi_response->handles, &size);
+			break;
+		case op_MAPI_FastTransferDestPutBuffer: /* 0x54 */
+			retval = EcDoRpc_RopFastTransferDestinationPutBuffer(mem_ctx, emsmdbp_ctx,
+									     &(mapi_request->mapi_req[i]),
+									     &(mapi_response->mapi_repl[idx]),
+									     mapi_response->handles, &size);
+			break;
 		case op_MAPI_GetNamesFromIDs: /* 0x55 */
 			retval = EcDoRpc_RopGetNamesFromIDs(mem_ctx, emsmdbp_ctx,
 							    &(mapi_request->mapi_req[i]),
@@ -1070,10 +1154,30 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 						&(mapi_response->mapi_repl[idx]),
 						mapi_response->handles, &size);
 			break;
-		/* op_MAPI_ExpandRow: 0x59 */
-		/* op_MAPI_CollapseRow: 0x5a */
-		/* op_MAPI_LockRegionStream: 0x5b */
-		/* op_MAPI_UnlockRegionStream: 0x5c */
+		case op_MAPI_ExpandRow: /* 0x59 */
+			retval = EcDoRpc_RopExpandRow(mem_ctx, emsmdbp_ctx,
+						      &(mapi_request->mapi_req[i]),
+						      &(mapi_response->mapi_repl[idx]),
+						      mapi_response->handles, &size);
+			break;
+		case op_MAPI_CollapseRow: /* 0x5a */
+			retval = EcDoRpc_RopCollapseRow(mem_ctx, emsmdbp_ctx,
+							&(mapi_request->mapi_req[i]),
+							&(mapi_response->mapi_repl[idx]),
+							mapi_response->handles, &size);
+			break;
+		case op_MAPI_LockRegionStream: /* 0x5b */
+			retval = EcDoRpc_RopLockRegionStream(mem_ctx, emsmdbp_ctx,
+							     &(mapi_request->mapi_req[i]),
+							     &(mapi_response->mapi_repl[idx]),
+							     mapi_response->handles, &size);
+			break;
+		case op_MAPI_UnlockRegionStream: /* 0x5c */
+			retval = EcDoRpc_RopUnlockRegionStream(mem_ctx, emsmdbp_ctx,
+							       &(mapi_request->mapi_req[i]),
+							       &(mapi_response->mapi_repl[idx]),
+							       mapi_response->handles, &size);
+			break;
 		case op_MAPI_CommitStream: /* 0x5d */
 			retval = EcDoRpc_RopCommitStream(mem_ctx, emsmdbp_ctx,
 							 &(mapi_request->mapi_req[i]),
@@ -1106,11 +1210,32 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 								   mapi_response->handles, &size);
 			break;
 		/* op_MAPI_ReadPerUserInformation: 0x63 */
-		/* op_MAPI_SetReadFlags: 0x66 */
+		case op_MAPI_SetReadFlags: /* 0x66 */
+			retval = EcDoRpc_RopSetReadFlags(mem_ctx, emsmdbp_ctx,
+							 &(mapi_request->mapi_req[i]),
+							 &(mapi_response->mapi_repl[idx]),
+							 mapi_response->handles, &size);
+			break;
 		/* op_MAPI_CopyProperties: 0x67 */
 		/* op_MAPI_GetReceiveFolderTable: 0x68 */
-		/* op_MAPI_GetCollapseState: 0x6b */
-		/* op_MAPI_SetCollapseState: 0x6c */
+		case op_MAPI_FastTransferSourceCopyProps: /* 0x69 */
+			retval = EcDoRpc_RopFastTransferSourceCopyProperties(mem_ctx, emsmdbp_ctx,
+									     &(mapi_request->mapi_req[i]),
+									     &(mapi_response->mapi_repl[idx]),
+									     mapi_response->handles, &size);
+			break;
+		case op_MAPI_GetCollapseState: /* 0x6b */
+			retval = EcDoRpc_RopGetCollapseState(mem_ctx, emsmdbp_ctx,
+							     &(mapi_request->mapi_req[i]),
+							     &(mapi_response->mapi_repl[idx]),
+							     mapi_response->handles, &size);
+			break;
+		case op_MAPI_SetCollapseState: /* 0x6c */
+			retval = EcDoRpc_RopSetCollapseState(mem_ctx, emsmdbp_ctx,
+							     &(mapi_request->mapi_req[i]),
+							     &(mapi_response->mapi_repl[idx]),
+							     mapi_response->handles, &size);
+			break;
 		case op_MAPI_GetTransportFolder: /* 0x6d */
 			retval = EcDoRpc_RopGetTransportFolder(mem_ctx, emsmdbp_ctx,
 							       &(mapi_request->mapi_req[i]),
@@ -1217,10 +1342,30 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 			break;
 		/* op_MAPI_OpenPublicFolderByName: 0x87 */
 		/* op_MAPI_SetSyncNotificationGuid: 0x88 */
-		/* op_MAPI_FreeBookmark: 0x89 */
-		/* op_MAPI_WriteAndCommitStream: 0x90 */
-		/* op_MAPI_HardDeleteMessages: 0x91 */
-		/* op_MAPI_HardDeleteMessagesAndSubfolders: 0x92 */
+		case op_MAPI_FreeBookmark: /* 0x89 */
+			retval = EcDoRpc_RopFreeBookmark(mem_ctx, emsmdbp_ctx,
+							 &(mapi_request->mapi_req[i]),
+							 &(mapi_response->mapi_repl[idx]),
+							 mapi_response->handles, &size);
+			break;
+		case op_MAPI_WriteAndCommitStream: /* 0x90 */
+			retval = EcDoRpc_RopWriteAndCommitStream(mem_ctx, emsmdbp_ctx,
+								 &(mapi_request->mapi_req[i]),
+								 &(mapi_response->mapi_repl[idx]),
+								 mapi_response->handles, &size);
+			break;
+		case op_MAPI_HardDeleteMessages: /* 0x91 */
+			retval = EcDoRpc_RopHardDeleteMessages(mem_ctx, emsmdbp_ctx,
+							       &(mapi_request->mapi_req[i]),
+							       &(mapi_response->mapi_repl[idx]),
+							       mapi_response->handles, &size);
+			break;
+		case op_MAPI_HardDeleteMessagesAndSubfolders: /* 0x92 */
+			retval = EcDoRpc_RopHardDeleteMessagesAndSubfolders(mem_ctx, emsmdbp_ctx,
+									    &(mapi_request->mapi_req[i]),
+									    &(mapi_response->mapi_repl[idx]),
+									    mapi_response->handles, &size);
+			break;
 		case op_MAPI_SetLocalReplicaMidsetDeleted: /* 0x93 */
 			retval = EcDoRpc_RopSetLocalReplicaMidsetDeleted(mem_ctx, emsmdbp_ctx,
 									 &(mapi_request->mapi_req[i]),
@@ -1238,6 +1383,11 @@ static struct mapi_response *EcDoRpc_process_transaction(TALLOC_CTX *mem_ctx,
 				  mapi_request->mapi_req[i].opnum));
 		}
 
+		emsmdbp_stats_rop(mapi_request->mapi_req[i].opnum, retval,
+				  emsmdbp_stats_now() - rop_start,
+				  mapistore_backend_get_elapsed_time(emsmdbp_ctx->mstore_ctx) - rop_backend_start,
+				  size - rop_size);
+
 		if (mapi_request->mapi_req[i].opnum != op_MAPI_Release) {
 			idx++;
 		}
@@ -1251,6 +1401,7 @@ notif:
 	/* Step 3. Notifications/Pending calls should be processed here */
 	/* Note: GetProps and GetRows are filled with flag NDR_REMAINING, which may hide the content of the following replies. */
 	while ((notification_holder = emsmdbp_ctx->mstore_ctx->notifications)) {
+		emsmdbp_search_notification(emsmdbp_ctx, notification_holder->notification);
 		subscription_list = mapistore_find_matching_subscriptions(emsmdbp_ctx->mstore_ctx, notification_holder->notification);
 		while ((subscription_holder = subscription_list)) {
 			if (needs_realloc) {
@@ -1265,6 +1416,9 @@ notif:
 		DLIST_REMOVE(emsmdbp_ctx->mstore_ctx->notifications, notification_holder);
 		talloc_free(notification_holder);
 	}
+
+	/* Populate the search folders still being crawled */
+	emsmdbp_search_crawl(emsmdbp_ctx, EMSMDBP_SEARCH_CRAWL_BUDGET);
 	
 #if 0
 	DEBUG(0, ("subscriptions: %p\n", emsmdbp_ctx->mstore_ctx->subscriptions));
@@ -1299,10 +1453,13 @@ notif:
 	}
 	
 	/* Step 4. Fill mapi_response structure */
-	handles_length = mapi_request->mapi_len - mapi_request->length;
 	mapi_response->length = size + sizeof (mapi_response->length);
 	mapi_response->mapi_len = mapi_response->length + handles_length;
 
+	emsmdbp_stats_transaction(mapi_request->length, mapi_response->length,
+				  emsmdbp_stats_now() - transaction_start,
+				  mapistore_backend_get_elapsed_time(emsmdbp_ctx->mstore_ctx) - backend_start);
+
 	return mapi_response;
 }
 
@@ -1347,6 +1504,9 @@ static enum MAPISTATUS dcesrv_EcDoRpc(struct dcesrv_call_state *dce_call,
 		return MAPI_E_LOGON_FAILED;
 	}
 
+	/* Asynchronous table operations run on the connection event loop */
+	emsmdbp_ctx->ev = dce_call->event_ctx;
+
 	/* Step 1. Process EcDoRpc requests */
 	mapi_request = r->in.mapi_request;
 	mapi_response = EcDoRpc_process_transaction(mem_ctx, emsmdbp_ctx, mapi_request);
@@ -1368,6 +1528,10 @@ static enum MAPISTATUS dcesrv_EcDoRpc(struct dcesrv_call_state *dce_call,
 /**
    \details exchange_emsmdb EcGetMoreRpc (0x3) function
 
+   This call is not used on the wire (MS-OXCRPC): responses
+   which do not fit in a single ROP buffer are returned as chained
+   buffers by EcDoRpcExt2.
+
    \param dce_call pointer to the session context
    \param mem_ctx pointer to the memory context
    \param r pointer to the EcGetMoreRpc request data
@@ -1378,7 +1542,7 @@ static void dcesrv_EcGetMoreRpc(struct dcesrv_call_state *dce_call,
 				TALLOC_CTX *mem_ctx,
 				struct EcGetMoreRpc *r)
 {
-	DEBUG(3, ("exchange_emsmdb: EcGetMoreRpc (0x3) not implemented\n"));
+	DEBUG(3, ("exchange_emsmdb: EcGetMoreRpc (0x3) not used on the wire\n"));
 	DCESRV_FAULT_VOID(DCERPC_FAULT_OP_RNG_ERROR);
 }
 
@@ -1696,9 +1860,71 @@ static enum MAPISTATUS dcesrv_EcDoConnectEx(struct dcesrv_call_state *dce_call,
 	return MAPI_E_SUCCESS;
 }
 
+/**
+   \details Return the ROP whose responses can be packed in additional
+   ROP buffers
+
+   When the last ROP of a request is RopQueryRows or
+   RopFastTransferSourceGetBuffer and it did not reach the end of the
+   table or stream, the server can execute it again and return the
+   results in chained buffers of the same response (extended
+   buffer packing in MS-OXCRPC). This saves the client one round trip
+   per buffer.
+
+   \param mapi_request pointer to the MAPI request
+   \param mapi_response pointer to the MAPI response of the last buffer
+
+   \return pointer to the ROP request to execute again, NULL otherwise
+ */
+static struct EcDoRpc_MAPI_REQ *EcDoRpc_packable_rop(struct mapi_request *mapi_request,
+						     struct mapi_response *mapi_response)
+{
+	struct EcDoRpc_MAPI_REQ		*mapi_req = NULL;
+	struct EcDoRpc_MAPI_REPL	*mapi_repl = NULL;
+	uint32_t			i;
+
+	if (!mapi_request->mapi_req || !mapi_response->mapi_repl) return NULL;
+
+	for (i = 0; mapi_request->mapi_req[i].opnum != 0; i++) {
+		mapi_req = &(mapi_request->mapi_req[i]);
+	}
+	if (!mapi_req) return NULL;
+
+	/* Notifications may follow the response of the last ROP */
+	for (i = 0; mapi_response->mapi_repl[i].opnum != 0; i++) {
+		if (mapi_response->mapi_repl[i].opnum == mapi_req->opnum) {
+			mapi_repl = &(mapi_response->mapi_repl[i]);
+		}
+	}
+	if (!mapi_repl || mapi_repl->error_code != MAPI_E_SUCCESS) return NULL;
+
+	switch (mapi_req->opnum) {
+	case op_MAPI_QueryRows:
+		if (!mapi_req->u.mapi_QueryRows.ForwardRead
+		    || (mapi_req->u.mapi_QueryRows.QueryRowsFlags & TBL_NOADVANCE)) {
+			return NULL;
+		}
+		if (!mapi_repl->u.mapi_QueryRows.RowCount || mapi_repl->u.mapi_QueryRows.Origin == BOOKMARK_END) {
+			return NULL;
+		}
+		return mapi_req;
+	case op_MAPI_FastTransferSourceGetBuffer:
+		if (mapi_repl->u.mapi_FastTransferSourceGetBuffer.TransferStatus != TransferStatus_Partial) {
+			return NULL;
+		}
+		return mapi_req;
+	default:
+		return NULL;
+	}
+}
+
 /**
    \details exchange_emsmdb EcDoRpcExt2 (0xB) function
 
+   The response is made of one or more ROP buffers, each preceded by
+   its RPC_HEADER_EXT. Additional buffers are only returned when the
+   client sets pulFlags_Chain and pcbOut leaves room for them.
+
    \param dce_call pointer to the session context
    \param mem_ctx pointer to the memory context
    \param r pointer to the EcDoRpcExt2 request data
@@ -1712,18 +1938,30 @@ static enum MAPISTATUS dcesrv_EcDoRpcExt2(struct dcesrv_call_state *dce_call,
 	struct exchange_emsmdb_session	*session;
 	struct emsmdbp_context		*emsmdbp_ctx = NULL;
 	struct mapi2k7_request		mapi2k7_request;
+	struct mapi_request		*mapi_request;
+	struct mapi_request		*chained_request;
 	struct mapi_response		*mapi_response;
+	struct EcDoRpc_MAPI_REQ		*mapi_req;
 	struct RPC_HEADER_EXT		RPC_HEADER_EXT;
 	struct ndr_pull			*ndr_pull = NULL;
 	struct ndr_push			*ndr_uncomp_rgbOut;
 	struct ndr_push			*ndr_comp_rgbOut;
 	struct ndr_push			*ndr_rgbOut;
+	TALLOC_CTX			*transaction_ctx;
 	uint32_t			pulFlags = 0x0;
 	uint32_t			pulTransTime = 0;
+	uint32_t			cbOutMax;
+	uint32_t			buffers;
+	bool				chain;
 	DATA_BLOB			rgbIn;
+	uint64_t			ndr_start;
 
 	DEBUG(3, ("exchange_emsmdb: EcDoRpcExt2 (0xB)\n"));
 
+	/* in and out parameters may share the same storage */
+	cbOutMax = *r->in.pcbOut;
+	chain = (*r->in.pulFlags & pulFlags_Chain) ? true : false;
+
 	r->out.rgbOut = NULL;
 	*r->out.pcbOut = 0;
 	r->out.rgbAuxOut = NULL;
@@ -1747,48 +1985,101 @@ static enum MAPISTATUS dcesrv_EcDoRpcExt2(struct dcesrv_call_state *dce_call,
 		return MAPI_E_LOGON_FAILED;
 	}
 	emsmdbp_ctx = (struct emsmdbp_context *)session->session->private_data;
+	emsmdbp_ctx->ev = dce_call->event_ctx;
+
+	/* The decoded request and the ROP responses only live until rgbOut
+	   is built: allocate them from a pool sized from the request.
+
+	   ROP request data (property values, names, stream data pointing
+	   into rgbIn) must not outlive the transaction. Handlers that keep
+	   any of it copy it onto a long-lived context; they must neither
+	   talloc_steal nor talloc_reference request data, which would keep
+	   the whole pool alive. */
+	transaction_ctx = talloc_pool(mem_ctx, EMSMDB_TRANSACTION_POOL_BASE + r->in.cbIn * EMSMDB_TRANSACTION_POOL_RATIO);
+	if (!transaction_ctx) {
+		transaction_ctx = talloc_new(mem_ctx);
+	}
 
-	/* Extract mapi_request from rgbIn */
+	/* Extract mapi_request from rgbIn. Stream data is not copied and
+	   points into rgbIn or into the decompressed buffer owned by
+	   ndr_pull, which is kept until the transaction is complete */
+	ndr_start = emsmdbp_stats_now();
 	rgbIn.data = r->in.rgbIn;
 	rgbIn.length = r->in.cbIn;
-	ndr_pull = ndr_pull_init_blob(&rgbIn, mem_ctx);
+	ndr_pull = ndr_pull_init_blob(&rgbIn, transaction_ctx);
 	ndr_set_flags(&ndr_pull->flags, LIBNDR_FLAG_NOALIGN|LIBNDR_FLAG_REF_ALLOC);
 	ndr_pull_mapi2k7_request(ndr_pull, NDR_SCALARS|NDR_BUFFERS, &mapi2k7_request);
-	talloc_free(ndr_pull);
+	emsmdbp_stats_ndr(emsmdbp_stats_now() - ndr_start);
 
-	mapi_response = EcDoRpc_process_transaction(mem_ctx, emsmdbp_ctx, mapi2k7_request.mapi_request);
-	talloc_free(mapi2k7_request.mapi_request);
+	mapi_request = mapi2k7_request.mapi_request;
+	mapi_response = EcDoRpc_process_transaction(transaction_ctx, emsmdbp_ctx, mapi_request);
 
 	/* Fill EcDoRpcExt2 reply */
 	r->out.handle = r->in.handle;
 	*r->out.pulFlags = pulFlags;
 
-	/* Push MAPI response into a DATA blob */
-	ndr_uncomp_rgbOut = ndr_push_init_ctx(mem_ctx);
-	ndr_set_flags(&ndr_uncomp_rgbOut->flags, LIBNDR_FLAG_NOALIGN);
-	ndr_push_mapi_response(ndr_uncomp_rgbOut, NDR_SCALARS|NDR_BUFFERS, mapi_response);
-	talloc_free(mapi_response);
-
-	/* TODO: compress if requested */
-	ndr_comp_rgbOut = ndr_uncomp_rgbOut;
-
-	/* Build RPC_HEADER_EXT header for MAPI response DATA blob */
-	RPC_HEADER_EXT.Version = 0x0000;
-	RPC_HEADER_EXT.Flags = RHEF_Last;
-	RPC_HEADER_EXT.Flags |= (mapi2k7_request.header.Flags & RHEF_XorMagic);
-	RPC_HEADER_EXT.Size = ndr_comp_rgbOut->offset;
-	RPC_HEADER_EXT.SizeActual = ndr_comp_rgbOut->offset;
-
-	/* Obfuscate content if applicable*/
-	if (RPC_HEADER_EXT.Flags & RHEF_XorMagic) {
-		obfuscate_data(ndr_comp_rgbOut->data, ndr_comp_rgbOut->offset, 0xA5);
-	}
-
-	/* Push the constructed blob */
 	ndr_rgbOut = ndr_push_init_ctx(mem_ctx);
 	ndr_set_flags(&ndr_rgbOut->flags, LIBNDR_FLAG_NOALIGN);
-	ndr_push_RPC_HEADER_EXT(ndr_rgbOut, NDR_SCALARS|NDR_BUFFERS, &RPC_HEADER_EXT);
-	ndr_push_bytes(ndr_rgbOut, ndr_comp_rgbOut->data, ndr_comp_rgbOut->offset);
+
+	for (buffers = 0; mapi_response; buffers++) {
+		/* Push MAPI response into a DATA blob */
+		ndr_start = emsmdbp_stats_now();
+		ndr_uncomp_rgbOut = ndr_push_init_ctx(transaction_ctx);
+		ndr_set_flags(&ndr_uncomp_rgbOut->flags, LIBNDR_FLAG_NOALIGN);
+		ndr_push_mapi_response(ndr_uncomp_rgbOut, NDR_SCALARS|NDR_BUFFERS, mapi_response);
+		emsmdbp_stats_ndr(emsmdbp_stats_now() - ndr_start);
+
+		/* Execute the last ROP again if a full buffer still fits in rgbOut */
+		chained_request = NULL;
+		mapi_req = chain ? EcDoRpc_packable_rop(mapi_request, mapi_response) : NULL;
+		if (mapi_req && (ndr_rgbOut->offset + ndr_uncomp_rgbOut->offset
+				 + 2 * EMSMDB_RPC_HEADER_EXT_SIZE + EMSMDB_MAX_ROP_BUFFER_SIZE) <= cbOutMax) {
+			chained_request = talloc_zero(transaction_ctx, struct mapi_request);
+			chained_request->mapi_len = mapi_request->mapi_len;
+			chained_request->length = mapi_request->length;
+			chained_request->handles = mapi_request->handles;
+			chained_request->mapi_req = talloc_zero_array(chained_request, struct EcDoRpc_MAPI_REQ, 2);
+			chained_request->mapi_req[0] = *mapi_req;
+		}
+		talloc_free(mapi_response);
+
+		/* TODO: compress if requested */
+		ndr_comp_rgbOut = ndr_uncomp_rgbOut;
+
+		/* Build RPC_HEADER_EXT header for MAPI response DATA blob */
+		RPC_HEADER_EXT.Version = 0x0000;
+		RPC_HEADER_EXT.Flags = chained_request ? 0 : RHEF_Last;
+		RPC_HEADER_EXT.Flags |= (mapi2k7_request.header.Flags & RHEF_XorMagic);
+		RPC_HEADER_EXT.Size = ndr_comp_rgbOut->offset;
+		RPC_HEADER_EXT.SizeActual = ndr_comp_rgbOut->offset;
+
+		/* Push the constructed blob, obfuscating content while copying if applicable */
+		ndr_push_RPC_HEADER_EXT(ndr_rgbOut, NDR_SCALARS|NDR_BUFFERS, &RPC_HEADER_EXT);
+		if (RPC_HEADER_EXT.Flags & RHEF_XorMagic) {
+			ndr_push_obfuscated_bytes(ndr_rgbOut, ndr_comp_rgbOut->data, ndr_comp_rgbOut->offset, 0xA5);
+		}
+		else {
+			ndr_push_bytes(ndr_rgbOut, ndr_comp_rgbOut->data, ndr_comp_rgbOut->offset);
+		}
+		talloc_free(ndr_uncomp_rgbOut);
+
+		if (chained_request) {
+			mapi_request = chained_request;
+			mapi_response = EcDoRpc_process_transaction(transaction_ctx, emsmdbp_ctx, mapi_request);
+		}
+		else {
+			mapi_response = NULL;
+		}
+	}
+	if (talloc_free(transaction_ctx) == -1) {
+		DEBUG(0, ("[%s:%d]: transaction memory is still referenced, pool not released\n",
+			  __FUNCTION__, __LINE__));
+	}
+
+	emsmdbp_stats_rpc(buffers);
+	if (buffers > 1) {
+		DEBUG(5, ("exchange_emsmdb: EcDoRpcExt2 returned %u chained buffers (%u bytes)\n", buffers, ndr_rgbOut->offset));
+	}
 
 	/* Push MAPI response into a DATA blob */
 	r->out.rgbOut = ndr_rgbOut->data;
@@ -1954,6 +2245,9 @@ static NTSTATUS dcesrv_exchange_emsmdb_init(struct dcesrv_context *dce_ctx)
 		smb_panic("unable to initialize 'openchange.ldb' context");
 	}
 
+	/* Initialize per-ROP statistics */
+	emsmdbp_stats_init(dce_ctx, dce_ctx->lp_ctx);
+
 	return NT_STATUS_OK;
 }
 
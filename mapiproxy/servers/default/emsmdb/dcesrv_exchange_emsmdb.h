@@ -56,9 +56,44 @@ struct emsmdbp_context {
 	struct mapistore_context		*mstore_ctx;
 	struct mapi_handles_context		*handles_ctx;
 
+	/* bytes available for ROP responses in the buffer being filled */
+	uint16_t				rop_buffer_size;
+
+	/* event context of the connection, runs asynchronous table operations */
+	struct tevent_context			*ev;
+
+	/* search folders of the mailbox, loaded on first use */
+	bool					search_loaded;
+	struct emsmdbp_object			*search_mailbox;
+	struct emsmdbp_search_folder		*search_folders;
+
 	TALLOC_CTX				*mem_ctx;
 };
 
+/* messages evaluated per search folder and per transaction while crawling */
+#define	EMSMDBP_SEARCH_CRAWL_BUDGET	128
+
+struct emsmdbp_search_folder {
+	uint64_t				folderID;
+	struct mapi_SRestriction		*restriction;
+	struct SPropTagArray			*columns; /* properties referenced by the restriction */
+	uint16_t				scope_count;
+	uint64_t				*scope;
+	uint32_t				flags;
+	uint32_t				state;
+
+	/* crawl state: folders left to visit and messages left in the current one */
+	uint64_t				*crawl_fids;
+	uint32_t				crawl_fid_count;
+	uint64_t				crawl_folderID;
+	uint64_t				*crawl_mids;
+	uint32_t				crawl_mid_count;
+	uint32_t				crawl_mid_idx;
+
+	struct emsmdbp_search_folder		*prev;
+	struct emsmdbp_search_folder		*next;
+};
+
 struct exchange_emsmdb_session {
 	uint32_t			pullTimeStamp;
 	struct mpm_session		*session;
@@ -140,15 +175,104 @@ struct emsmdbp_object_message {
 	struct mapistore_freebusy_properties	*fb_properties;
 };
 
+struct emsmdbp_table_bookmark {
+	uint32_t				id;
+	uint32_t				position;
+	uint64_t				fmid; /* 0 when the row can't be tracked */
+	bool					row_deleted; /* the untracked row was removed from the table */
+	struct emsmdbp_table_bookmark		*prev;
+	struct emsmdbp_table_bookmark		*next;
+};
+
+struct emsmdbp_search_row {
+	uint64_t				folderID;
+	uint64_t				messageID;
+	uint32_t				index;
+	bool					match;
+	struct SSortOrderSet			*sort;
+	struct openchangedb_table_value		*keys;
+};
+
+struct emsmdbp_search_table {
+	uint32_t				row_count;
+	struct emsmdbp_search_row		**rows; /* sorted */
+	uint32_t				view_count;
+	struct emsmdbp_search_row		**view; /* sorted rows matching the restriction */
+};
+
+#define	EMSMDBP_CATEGORY_NONE	0xFFFFFFFF
+
+struct emsmdbp_category_header {
+	uint64_t				id; /* PidTagInstID of the header row */
+	uint32_t				parent; /* EMSMDBP_CATEGORY_NONE for a top level category */
+	uint8_t					level;
+	bool					expanded;
+	struct openchangedb_table_value		key;
+	uint32_t				first_leaf;
+	uint32_t				leaf_count;
+	uint32_t				unread_count;
+};
+
+struct emsmdbp_category_row {
+	uint32_t				header; /* EMSMDBP_CATEGORY_NONE for a leaf row */
+	uint32_t				leaf;
+};
+
+struct emsmdbp_category_table {
+	uint16_t				category_count;
+	uint16_t				expanded_count;
+	enum MAPITAGS				*columns;
+	uint32_t				header_count;
+	struct emsmdbp_category_header		*headers; /* depth-first order */
+	uint32_t				leaf_count;
+	uint64_t				*leaf_ids;
+	uint32_t				view_count;
+	struct emsmdbp_category_row		*view; /* rows not hidden by a collapsed category */
+};
+
+/* A categorized view being built, the backend rows are read in chunks */
+struct emsmdbp_category_build {
+	struct emsmdbp_category_table		*categories; /* installed on the table once every row is read */
+	uint64_t				*toggled;
+	uint32_t				toggled_count;
+	enum MAPITAGS				*columns; /* category columns, PR_MESSAGE_FLAGS and PR_MID */
+	uint16_t				column_count;
+	uint32_t				*current; /* current header of each level */
+	struct openchangedb_table_value		*keys;
+	uint32_t				row; /* next backend row to read */
+	uint32_t				row_count;
+};
+
 struct emsmdbp_object_table {
 	enum mapistore_table_type		ulType;
 	uint32_t				handle;
 	bool					restricted;
+	struct mapi_SRestriction		*restriction; /* committed restriction, NULL when unrestricted */
 	uint16_t				prop_count;
 	enum MAPITAGS				*properties;
 	uint32_t				numerator;
 	uint32_t				denominator;
         struct mapistore_subscription_list	*subscription_list;
+	struct emsmdbp_table_bookmark		*bookmarks;
+	uint32_t				last_bookmark;
+	struct emsmdbp_search_table		*search; /* contents table of a search folder */
+	struct emsmdbp_category_table		*categories; /* categorized view, NULL if not categorized */
+	uint8_t					status; /* TableStatus of the last asynchronous operation */
+	struct emsmdbp_table_async		*async; /* pending TBL_ASYNC SortTable or Restrict */
+};
+
+/* A SortTable or Restrict requested with TBL_ASYNC. The table keeps its
+   committed sort order and restriction until the operation runs, then
+   its categorized view is built across several event loop runs. */
+struct emsmdbp_table_async {
+	struct emsmdbp_context			*emsmdbp_ctx;
+	struct emsmdbp_object			*table_object;
+	bool					started; /* cannot be aborted any more */
+	uint8_t					status; /* TBLSTAT_SORTING or TBLSTAT_RESTRICTING while build is set */
+	struct SSortOrderSet			*sort;
+	struct mapi_SRestriction		*restriction;
+	struct emsmdbp_category_build		*build;
+	struct tevent_timer			*te;
 };
 
 struct emsmdbp_object_stream {
@@ -215,6 +339,9 @@ struct emsmdbp_object_ftcontext {
 	struct emsmdbp_stream	stream;
 	uint32_t		*cutmarks;
 	uint32_t		next_cutmark_idx;
+
+	/* data upload */
+	void			*dest_data;
 };
 
 union emsmdbp_objects {
@@ -242,6 +369,14 @@ struct emsmdbp_object {
 #define	EMSMDB_PCRETRY			6
 #define	EMSMDB_PCRETRYDELAY		10000
 
+/* Maximum size of a ROP buffer, RPC_HEADER_EXT excluded (MS-OXCRPC) */
+#define	EMSMDB_MAX_ROP_BUFFER_SIZE	0x8000
+#define	EMSMDB_RPC_HEADER_EXT_SIZE	8
+
+/* Size of the per-transaction memory pool: base plus ratio * request length */
+#define	EMSMDB_TRANSACTION_POOL_BASE	0x10000
+#define	EMSMDB_TRANSACTION_POOL_RATIO	8
+
 enum emsmdbp_mailbox_systemidx {
 	EMSMDBP_MAILBOX_ROOT = 1,
 	EMSMDBP_DEFERRED_ACTION,
@@ -304,6 +439,7 @@ const struct GUID *const	MagicGUIDp;
 int				emsmdbp_guid_to_replid(struct emsmdbp_context *, const char *username, const struct GUID *, uint16_t *);
 int				emsmdbp_replid_to_guid(struct emsmdbp_context *, const char *username, const uint16_t, struct GUID *);
 int				emsmdbp_source_key_from_fmid(TALLOC_CTX *, struct emsmdbp_context *, const char *username, uint64_t, struct Binary_r **);
+uint16_t			emsmdbp_rop_buffer_available(struct emsmdbp_context *, uint16_t, uint16_t);
 
 /* definitions from emsmdbp_object.c */
 const char	      *emsmdbp_getstr_type(struct emsmdbp_object *);
@@ -314,6 +450,39 @@ char                  *emsmdbp_get_owner(struct emsmdbp_object *object);
 int		      emsmdbp_get_uri_from_fid(TALLOC_CTX *, struct emsmdbp_context *, uint64_t, char **);
 int		      emsmdbp_get_fid_from_uri(struct emsmdbp_context *, const char *, uint64_t *);
 uint32_t	      emsmdbp_get_contextID(struct emsmdbp_object *);
+int		      emsmdbp_get_parent_fid(struct emsmdbp_context *, uint64_t, uint64_t *);
+
+/* definitions from emsmdbp_stats.c */
+void		      emsmdbp_stats_init(TALLOC_CTX *, struct loadparm_context *);
+uint64_t	      emsmdbp_stats_now(void);
+void		      emsmdbp_stats_rop(uint8_t, enum MAPISTATUS, uint64_t, uint64_t, uint32_t);
+void		      emsmdbp_stats_transaction(uint32_t, uint32_t, uint64_t, uint64_t);
+void		      emsmdbp_stats_ndr(uint64_t);
+void		      emsmdbp_stats_rpc(uint32_t);
+
+/* definitions from emsmdbp_search.c */
+bool		      emsmdbp_search_is_search_folder(struct emsmdbp_context *, uint64_t);
+enum MAPISTATUS	      emsmdbp_search_set_criteria(struct emsmdbp_context *, uint64_t, struct mapi_SRestriction *, uint16_t, uint64_t *, uint32_t);
+enum MAPISTATUS	      emsmdbp_search_get_criteria(TALLOC_CTX *, struct emsmdbp_context *, uint64_t, struct mapi_SRestriction **, uint16_t *, uint64_t **, uint32_t *);
+void		      emsmdbp_search_crawl(struct emsmdbp_context *, uint32_t);
+void		      emsmdbp_search_notification(struct emsmdbp_context *, struct mapistore_notification *);
+enum MAPISTATUS	      emsmdbp_search_table_init(struct emsmdbp_context *, struct emsmdbp_object *, uint64_t);
+void		      **emsmdbp_search_table_get_row_props(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, uint32_t, enum MAPISTATUS **);
+enum MAPISTATUS	      emsmdbp_search_table_set_sort_order(struct emsmdbp_context *, struct emsmdbp_object *, struct SSortOrderSet *);
+enum MAPISTATUS	      emsmdbp_search_table_set_restrictions(struct emsmdbp_context *, struct emsmdbp_object *, struct mapi_SRestriction *);
+enum MAPISTATUS	      emsmdbp_search_table_find_row(struct emsmdbp_context *, struct emsmdbp_object *, struct mapi_SRestriction *, enum FindRow_ulFlags, uint32_t, uint32_t *);
+
+/* definitions from emsmdbp_category.c */
+enum MAPISTATUS	      emsmdbp_category_table_init(struct emsmdbp_context *, struct emsmdbp_object *, struct SSortOrderSet *);
+enum MAPISTATUS	      emsmdbp_category_table_rebuild(struct emsmdbp_context *, struct emsmdbp_object *);
+enum MAPISTATUS	      emsmdbp_category_table_init_start(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, struct SSortOrderSet *, struct emsmdbp_category_build **);
+enum MAPISTATUS	      emsmdbp_category_table_rebuild_start(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, struct emsmdbp_category_build **);
+enum MAPISTATUS	      emsmdbp_category_build_step(struct emsmdbp_context *, struct emsmdbp_object *, struct emsmdbp_category_build *, uint32_t, bool *);
+void		      **emsmdbp_category_table_get_row_props(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, uint32_t, enum mapistore_query_type, enum MAPISTATUS **);
+enum MAPISTATUS	      emsmdbp_category_table_expand(struct emsmdbp_object *, uint64_t, uint32_t *, uint32_t *);
+enum MAPISTATUS	      emsmdbp_category_table_collapse(struct emsmdbp_object *, uint64_t, uint32_t *, uint32_t *);
+enum MAPISTATUS	      emsmdbp_category_table_get_state(TALLOC_CTX *, struct emsmdbp_object *, uint64_t, uint32_t, struct SBinary_short *);
+enum MAPISTATUS	      emsmdbp_category_table_set_state(struct emsmdbp_context *, struct emsmdbp_object *, struct SBinary_short *, uint32_t *);
 
 /* definitions from emsmdbp_privisioning.c */
 enum MAPISTATUS       emsmdbp_mailbox_provision(struct emsmdbp_context *, const char *);
@@ -331,13 +500,20 @@ struct emsmdbp_object *emsmdbp_object_mailbox_init(TALLOC_CTX *, struct emsmdbp_
 struct emsmdbp_object *emsmdbp_object_folder_init(TALLOC_CTX *, struct emsmdbp_context *, uint64_t, struct emsmdbp_object *);
 int emsmdbp_folder_get_folder_count(struct emsmdbp_context *, struct emsmdbp_object *, uint32_t *);
 enum mapistore_error emsmdbp_folder_delete(struct emsmdbp_context *, struct emsmdbp_object *, uint64_t, uint8_t);
+enum mapistore_error emsmdbp_folder_delete_mapistore_root(struct emsmdbp_context *, uint64_t, const char *, uint8_t);
 enum mapistore_error emsmdbp_folder_move_folder(struct emsmdbp_context *, struct emsmdbp_object *, struct emsmdbp_object *, TALLOC_CTX *, const char *);
 struct emsmdbp_object *emsmdbp_folder_open_table(TALLOC_CTX *, struct emsmdbp_object *, uint32_t, uint32_t);
 struct emsmdbp_object *emsmdbp_object_table_init(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *);
 int emsmdbp_object_table_get_available_properties(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, struct SPropTagArray **);
 void **emsmdbp_object_table_get_row_props(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, uint32_t, enum mapistore_query_type, enum MAPISTATUS **);
+enum MAPISTATUS emsmdbp_object_table_create_bookmark(struct emsmdbp_object *, uint32_t, uint32_t *);
+enum MAPISTATUS emsmdbp_object_table_get_bookmark(struct emsmdbp_object *, uint32_t, uint32_t *, bool *);
+enum MAPISTATUS emsmdbp_object_table_free_bookmark(struct emsmdbp_object *, uint32_t);
+void emsmdbp_object_table_move_bookmarks(struct emsmdbp_object *, uint32_t, bool);
+void emsmdbp_object_table_reset_bookmarks(struct emsmdbp_object *);
 struct emsmdbp_object *emsmdbp_object_message_init(TALLOC_CTX *, struct emsmdbp_context *, uint64_t, struct emsmdbp_object *);
 enum mapistore_error emsmdbp_object_message_open(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *, uint64_t, uint64_t, bool, struct emsmdbp_object **, struct mapistore_message **);
+enum mapistore_error emsmdbp_object_message_copy(struct emsmdbp_context *, struct emsmdbp_object *, uint64_t, struct emsmdbp_object *, uint64_t);
 struct emsmdbp_object *emsmdbp_object_message_open_attachment_table(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *);
 struct emsmdbp_object *emsmdbp_object_stream_init(TALLOC_CTX *, struct emsmdbp_context *, struct emsmdbp_object *);
 int emsmdbp_object_stream_commit(struct emsmdbp_object *);
@@ -368,6 +544,8 @@ enum MAPISTATUS EcDoRpc_RopEmptyFolder(TALLOC_CTX *, struct emsmdbp_context *, s
 enum MAPISTATUS EcDoRpc_RopMoveCopyMessages(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopMoveFolder(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopCopyFolder(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopHardDeleteMessages(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopHardDeleteMessagesAndSubfolders(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 
 
 /* definitions from oxcmsg.c */
@@ -383,6 +561,7 @@ enum MAPISTATUS EcDoRpc_RopOpenAttach(TALLOC_CTX *, struct emsmdbp_context *, st
 enum MAPISTATUS EcDoRpc_RopCreateAttach(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSaveChangesAttachment(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopOpenEmbeddedMessage(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopSetReadFlags(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 
 /* definitions from oxcnotif.c */
 enum MAPISTATUS EcDoRpc_RopRegisterNotification(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
@@ -400,6 +579,11 @@ enum MAPISTATUS EcDoRpc_RopCommitStream(TALLOC_CTX *, struct emsmdbp_context *,
 enum MAPISTATUS EcDoRpc_RopGetStreamSize(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSeekStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSetStreamSize(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopCopyToStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopCloneStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopLockRegionStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopUnlockRegionStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopWriteAndCommitStream(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopGetNamesFromIDs(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopGetPropertyIdsFromNames(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopDeletePropertiesNoReplicate(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
@@ -422,10 +606,20 @@ enum MAPISTATUS EcDoRpc_RopSetColumns(TALLOC_CTX *, struct emsmdbp_context *, st
 enum MAPISTATUS EcDoRpc_RopSortTable(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopRestrict(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopQueryRows(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopGetStatus(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopQueryPosition(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSeekRow(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopSeekRowBookmark(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopSeekRowApprox(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopCreateBookmark(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopAbort(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopFindRow(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopResetTable(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFreeBookmark(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopExpandRow(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopCollapseRow(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopGetCollapseState(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopSetCollapseState(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 
 /* definition from oxomsg.c */
 enum MAPISTATUS	EcDoRpc_RopSubmitMessage(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
@@ -445,7 +639,12 @@ enum MAPISTATUS EcDoRpc_RopModifyPermissions(TALLOC_CTX *, struct emsmdbp_contex
 
 /* definitions from oxcfxics.c */
 enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyTo(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyMessages(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyFolder(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyProperties(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopFastTransferSourceGetBuffer(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFastTransferDestinationConfigure(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
+enum MAPISTATUS EcDoRpc_RopFastTransferDestinationPutBuffer(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSyncConfigure(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSyncImportMessageChange(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
 enum MAPISTATUS EcDoRpc_RopSyncImportHierarchyChange(TALLOC_CTX *, struct emsmdbp_context *, struct EcDoRpc_MAPI_REQ *, struct EcDoRpc_MAPI_REPL *, uint32_t *, uint16_t *);
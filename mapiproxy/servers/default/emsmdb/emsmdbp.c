@@ -110,6 +110,7 @@ _PUBLIC_ struct emsmdbp_context *emsmdbp_init(struct loadparm_context *lp_ctx,
 	}
 
 	emsmdbp_ctx->mem_ctx = mem_ctx;
+	emsmdbp_ctx->rop_buffer_size = EMSMDB_MAX_ROP_BUFFER_SIZE;
 
 	ev = tevent_context_init(mem_ctx);
 	if (!ev) {
@@ -527,3 +528,27 @@ _PUBLIC_ int emsmdbp_source_key_from_fmid(TALLOC_CTX *mem_ctx, struct emsmdbp_co
 
 	return MAPISTORE_SUCCESS;
 }
+
+/**
+   \details Return the number of bytes a ROP response can still add to
+   the ROP buffer being filled
+
+   Operations returning variable-length data (rows, stream chunks) use
+   it to fill the buffer the client allows without overflowing it.
+
+   \param emsmdbp_ctx pointer to the EMSMDB provider context
+   \param size size of the ROP responses already in the buffer
+   \param rop_size size of the ROP response without its variable data
+
+   \return the number of bytes available, 0 if the buffer is full
+ */
+_PUBLIC_ uint16_t emsmdbp_rop_buffer_available(struct emsmdbp_context *emsmdbp_ctx, uint16_t size, uint16_t rop_size)
+{
+	if (!emsmdbp_ctx) return 0;
+
+	if ((uint32_t) size + rop_size >= emsmdbp_ctx->rop_buffer_size) {
+		return 0;
+	}
+
+	return emsmdbp_ctx->rop_buffer_size - size - rop_size;
+}
@@ -0,0 +1,1384 @@
+/*
+   OpenChange Server implementation
+
+   EMSMDBP: EMSMDB Provider implementation
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+   \file emsmdbp_category.c
+
+   \brief Categorized table views
+
+   A contents table sorted with cCategories > 0 is grouped on its first
+   cCategories sort columns. The rows of the backend table (the leaf
+   rows) are read once, on their category columns only, to build the
+   tree of category header rows with their message and unread counts.
+   The view exposed to the client is the list of header and leaf rows
+   which are not hidden by a collapsed category: leaf rows are only
+   fetched from the backend when they are queried.
+
+   Category identifiers are derived from the category values of the
+   header and its ancestors, so a category keeps its identifier, and
+   its expanded state, when the view is rebuilt by Restrict or
+   restored by SetCollapseState.
+ */
+
+#include <ctype.h>
+
+#include "mapiproxy/dcesrv_mapiproxy.h"
+#include "dcesrv_exchange_emsmdb.h"
+
+/* collapse state blob: cCategories, cExpanded, RowId, RowInstanceNumber, count */
+#define	EMSMDBP_CATEGORY_STATE_SIZE	(2 + 2 + 8 + 4 + 4)
+
+
+static uint64_t emsmdbp_category_hash(uint64_t hash, const uint8_t *data, size_t length)
+{
+	size_t	i;
+
+	for (i = 0; i < length; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+/**
+   \details Compute the identifier of a category header
+
+   Strings are compared without case by openchangedb_table_compare_keys
+   and are hashed accordingly.
+
+   \param parent_id the identifier of the parent category, 0 for a top
+   level category
+   \param level the depth of the category
+   \param key the category value
+
+   \return the category identifier, never 0
+ */
+static uint64_t emsmdbp_category_id(uint64_t parent_id, uint8_t level, struct openchangedb_table_value *key)
+{
+	uint64_t	hash = 0xcbf29ce484222325ULL;
+	uint8_t		buffer[8];
+	uint8_t		c;
+	const char	*str;
+	uint32_t	i;
+
+	for (i = 0; i < 8; i++) {
+		buffer[i] = (parent_id >> (i * 8)) & 0xFF;
+	}
+	hash = emsmdbp_category_hash(hash, buffer, 8);
+	hash = emsmdbp_category_hash(hash, &level, 1);
+	buffer[0] = key->type & 0xFF;
+	buffer[1] = (key->type >> 8) & 0xFF;
+	hash = emsmdbp_category_hash(hash, buffer, 2);
+
+	switch (key->type) {
+	case PT_UNSPECIFIED:
+		break;
+	case PT_STRING8:
+	case PT_UNICODE:
+		for (str = key->value.str; str && *str; str++) {
+			c = tolower((unsigned char) *str);
+			hash = emsmdbp_category_hash(hash, &c, 1);
+		}
+		break;
+	case PT_BINARY:
+		hash = emsmdbp_category_hash(hash, key->value.bin.data, key->value.bin.length);
+		break;
+	default:
+		for (i = 0; i < 8; i++) {
+			buffer[i] = (key->value.i >> (i * 8)) & 0xFF;
+		}
+		hash = emsmdbp_category_hash(hash, buffer, 8);
+		break;
+	}
+
+	return hash ? hash : 1;
+}
+
+
+/**
+   \details Convert a property value to a category value. Strings and
+   binaries are not copied.
+
+   \param proptag the property tag
+   \param data pointer to the property value, NULL if missing
+   \param value pointer to the category value to return
+ */
+static void emsmdbp_category_get_value(uint32_t proptag, void *data, struct openchangedb_table_value *value)
+{
+	struct FILETIME		*ft;
+	struct Binary_r		*bin;
+
+	value->type = PT_UNSPECIFIED;
+	if (!data) return;
+
+	switch (proptag & 0xFFFF) {
+	case PT_BOOLEAN:
+		value->value.i = *(uint8_t *)data;
+		break;
+	case PT_I2:
+		value->value.i = *(uint16_t *)data;
+		break;
+	case PT_LONG:
+		value->value.i = *(uint32_t *)data;
+		break;
+	case PT_I8:
+		value->value.i = *(uint64_t *)data;
+		break;
+	case PT_SYSTIME:
+		ft = (struct FILETIME *)data;
+		value->value.i = ((uint64_t)ft->dwHighDateTime << 32) | ft->dwLowDateTime;
+		break;
+	case PT_STRING8:
+	case PT_UNICODE:
+		value->value.str = (const char *)data;
+		break;
+	case PT_BINARY:
+		bin = (struct Binary_r *)data;
+		value->value.bin.data = bin->lpb;
+		value->value.bin.length = bin->cb;
+		break;
+	default:
+		/* other types are not grouped */
+		return;
+	}
+	value->type = proptag & 0xFFFF;
+}
+
+
+static void emsmdbp_category_copy_value(TALLOC_CTX *mem_ctx, struct openchangedb_table_value *value)
+{
+	switch (value->type) {
+	case PT_STRING8:
+	case PT_UNICODE:
+		value->value.str = talloc_strdup(mem_ctx, value->value.str);
+		break;
+	case PT_BINARY:
+		value->value.bin.data = talloc_memdup(mem_ctx, value->value.bin.data, value->value.bin.length);
+		break;
+	}
+}
+
+
+/**
+   \details Convert a category value back to a property value
+
+   \param mem_ctx pointer to the memory context
+   \param value pointer to the category value
+
+   \return pointer to the property value, NULL if the category has no value
+ */
+static void *emsmdbp_category_put_value(TALLOC_CTX *mem_ctx, struct openchangedb_table_value *value)
+{
+	struct FILETIME		*ft;
+	struct Binary_r		*bin;
+	uint8_t			*b;
+	uint16_t		*s;
+	uint32_t		*l;
+	uint64_t		*d;
+
+	switch (value->type) {
+	case PT_BOOLEAN:
+		b = talloc_zero(mem_ctx, uint8_t);
+		*b = value->value.i;
+		return b;
+	case PT_I2:
+		s = talloc_zero(mem_ctx, uint16_t);
+		*s = value->value.i;
+		return s;
+	case PT_LONG:
+		l = talloc_zero(mem_ctx, uint32_t);
+		*l = value->value.i;
+		return l;
+	case PT_I8:
+		d = talloc_zero(mem_ctx, uint64_t);
+		*d = value->value.i;
+		return d;
+	case PT_SYSTIME:
+		ft = talloc_zero(mem_ctx, struct FILETIME);
+		ft->dwLowDateTime = value->value.i & 0xFFFFFFFF;
+		ft->dwHighDateTime = value->value.i >> 32;
+		return ft;
+	case PT_STRING8:
+	case PT_UNICODE:
+		return talloc_strdup(mem_ctx, value->value.str);
+	case PT_BINARY:
+		bin = talloc_zero(mem_ctx, struct Binary_r);
+		bin->cb = value->value.bin.length;
+		bin->lpb = talloc_memdup(bin, value->value.bin.data, value->value.bin.length);
+		return bin;
+	default:
+		return NULL;
+	}
+}
+
+
+/**
+   \details Retrieve the number of rows of the backend table
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param row_count pointer to the row count to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_leaf_count(struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_object *table_object,
+						   uint32_t *row_count)
+{
+	struct emsmdbp_object_table	*table = table_object->object.table;
+	enum mapistore_error		ret;
+
+	*row_count = 0;
+
+	if (emsmdbp_is_mapistore(table_object)) {
+		ret = mapistore_table_get_row_count(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(table_object),
+						    table_object->backend_object, MAPISTORE_PREFILTERED_QUERY, row_count);
+		OPENCHANGE_RETVAL_IF(ret != MAPISTORE_SUCCESS, mapistore_error_to_mapi(ret), NULL);
+	} else if (table->search) {
+		*row_count = table->search->view_count;
+	} else {
+		return openchangedb_table_get_row_count(table_object->backend_object, emsmdbp_ctx->oc_ctx, row_count);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+static bool emsmdbp_category_is_toggled(uint64_t id, uint64_t *toggled, uint32_t toggled_count)
+{
+	uint32_t	i;
+
+	for (i = 0; i < toggled_count; i++) {
+		if (toggled[i] == id) return true;
+	}
+
+	return false;
+}
+
+
+/**
+   \details Build the list of visible rows from the category headers
+
+   A header is visible when all its ancestors are expanded, the leaf
+   rows of a deepest level header are visible when it is visible and
+   expanded.
+
+   \param categories pointer to the categorized view
+ */
+static void emsmdbp_category_update_view(struct emsmdbp_category_table *categories)
+{
+	struct emsmdbp_category_header	*header;
+	uint32_t			hidden_level;
+	uint32_t			count;
+	uint32_t			i;
+	uint32_t			j;
+
+	/* count the visible rows */
+	count = 0;
+	hidden_level = categories->category_count;
+	for (i = 0; i < categories->header_count; i++) {
+		header = &categories->headers[i];
+		if (header->level > hidden_level) continue;
+		count++;
+		if (header->expanded) {
+			hidden_level = categories->category_count;
+			if (header->level == categories->category_count - 1) {
+				count += header->leaf_count;
+			}
+		}
+		else {
+			hidden_level = header->level;
+		}
+	}
+
+	talloc_free(categories->view);
+	categories->view = talloc_array(categories, struct emsmdbp_category_row, count ? count : 1);
+	categories->view_count = count;
+
+	count = 0;
+	hidden_level = categories->category_count;
+	for (i = 0; i < categories->header_count; i++) {
+		header = &categories->headers[i];
+		if (header->level > hidden_level) continue;
+		categories->view[count].header = i;
+		categories->view[count].leaf = header->first_leaf;
+		count++;
+		if (header->expanded) {
+			hidden_level = categories->category_count;
+			if (header->level == categories->category_count - 1) {
+				for (j = 0; j < header->leaf_count; j++) {
+					categories->view[count].header = EMSMDBP_CATEGORY_NONE;
+					categories->view[count].leaf = header->first_leaf + j;
+					count++;
+				}
+			}
+		}
+		else {
+			hidden_level = header->level;
+		}
+	}
+}
+
+
+/**
+   \details Prepare the grouping of the backend table rows into
+   category headers
+
+   \param mem_ctx pointer to the memory context of the build
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param categories pointer to the categorized view to fill, owned by
+   the build from now on
+   \param toggled array of the categories whose expanded state differs
+   from the default
+   \param toggled_count number of elements in toggled
+   \param buildp pointer to the build to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_build_init(TALLOC_CTX *mem_ctx,
+						   struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_object *table_object,
+						   struct emsmdbp_category_table *categories,
+						   uint64_t *toggled, uint32_t toggled_count,
+						   struct emsmdbp_category_build **buildp)
+{
+	struct emsmdbp_category_build	*build;
+	enum MAPISTATUS			retval;
+	uint32_t			level;
+
+	build = talloc_zero(mem_ctx, struct emsmdbp_category_build);
+	OPENCHANGE_RETVAL_IF(!build, MAPI_E_NOT_ENOUGH_MEMORY, categories);
+	build->categories = talloc_steal(build, categories);
+
+	retval = emsmdbp_category_leaf_count(emsmdbp_ctx, table_object, &build->row_count);
+	OPENCHANGE_RETVAL_IF(retval, retval, build);
+
+	categories->leaf_count = build->row_count;
+	categories->leaf_ids = talloc_array(categories, uint64_t, build->row_count ? build->row_count : 1);
+	OPENCHANGE_RETVAL_IF(!categories->leaf_ids, MAPI_E_NOT_ENOUGH_MEMORY, build);
+	categories->header_count = 0;
+	categories->headers = talloc_array(categories, struct emsmdbp_category_header, 1);
+	OPENCHANGE_RETVAL_IF(!categories->headers, MAPI_E_NOT_ENOUGH_MEMORY, build);
+
+	if (toggled_count) {
+		build->toggled = talloc_memdup(build, toggled, sizeof (uint64_t) * toggled_count);
+		OPENCHANGE_RETVAL_IF(!build->toggled, MAPI_E_NOT_ENOUGH_MEMORY, build);
+	}
+	build->toggled_count = toggled_count;
+
+	/* category columns, then PR_MESSAGE_FLAGS and PR_MID */
+	build->column_count = categories->category_count + 2;
+	build->columns = talloc_array(build, enum MAPITAGS, build->column_count);
+	OPENCHANGE_RETVAL_IF(!build->columns, MAPI_E_NOT_ENOUGH_MEMORY, build);
+	memcpy(build->columns, categories->columns, sizeof (enum MAPITAGS) * categories->category_count);
+	build->columns[build->column_count - 2] = PR_MESSAGE_FLAGS;
+	build->columns[build->column_count - 1] = PR_MID;
+
+	/* index of the current header of each level */
+	build->current = talloc_array(build, uint32_t, categories->category_count);
+	OPENCHANGE_RETVAL_IF(!build->current, MAPI_E_NOT_ENOUGH_MEMORY, build);
+	build->keys = talloc_array(build, struct openchangedb_table_value, categories->category_count);
+	OPENCHANGE_RETVAL_IF(!build->keys, MAPI_E_NOT_ENOUGH_MEMORY, build);
+	for (level = 0; level < categories->category_count; level++) {
+		build->current[level] = EMSMDBP_CATEGORY_NONE;
+	}
+
+	*buildp = build;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Group the next rows of the backend table into category
+   headers
+
+   The category columns of the backend rows are read with the table
+   columns temporarily replaced, the client columns are restored
+   before returning.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object, categories detached
+   \param build pointer to the build
+   \param max_rows the maximum number of backend rows to read
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_build_rows(struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_object *table_object,
+						   struct emsmdbp_category_build *build,
+						   uint32_t max_rows)
+{
+	struct emsmdbp_object_table	*table = table_object->object.table;
+	struct emsmdbp_category_table	*categories = build->categories;
+	struct emsmdbp_category_header	*header;
+	struct openchangedb_table_value	*keys = build->keys;
+	enum MAPISTATUS			retval;
+	enum MAPISTATUS			*retvals;
+	enum MAPITAGS			*client_columns;
+	enum MAPITAGS			*columns = build->columns;
+	TALLOC_CTX			*mem_ctx;
+	void				**data_pointers;
+	uint16_t			client_count;
+	uint16_t			count = build->column_count;
+	uint32_t			*current = build->current;
+	uint32_t			contextID = 0;
+	uint32_t			flags;
+	uint32_t			level;
+	uint32_t			last;
+	uint32_t			i;
+	uint32_t			j;
+
+	last = build->row_count;
+	if (max_rows < last - build->row) {
+		last = build->row + max_rows;
+	}
+
+	mem_ctx = talloc_new(NULL);
+	OPENCHANGE_RETVAL_IF(!mem_ctx, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	client_count = table->prop_count;
+	client_columns = table->properties;
+	table->prop_count = count;
+	table->properties = columns;
+	if (emsmdbp_is_mapistore(table_object)) {
+		contextID = emsmdbp_get_contextID(table_object);
+		mapistore_table_set_columns(emsmdbp_ctx->mstore_ctx, contextID, table_object->backend_object, count, columns);
+	}
+
+	for (i = build->row; i < last; i++) {
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, table_object, i, MAPISTORE_PREFILTERED_QUERY, &retvals);
+
+		for (level = 0; level < categories->category_count; level++) {
+			emsmdbp_category_get_value(columns[level],
+						   (data_pointers && retvals[level] == MAPI_E_SUCCESS) ? data_pointers[level] : NULL,
+						   &keys[level]);
+		}
+
+		/* find the first category which changes with this row */
+		for (level = 0; level < categories->category_count; level++) {
+			if (current[level] == EMSMDBP_CATEGORY_NONE
+			    || openchangedb_table_compare_keys(&categories->headers[current[level]].key, &keys[level])) {
+				break;
+			}
+		}
+
+		/* open a new header for this category and the deeper ones */
+		for (; level < categories->category_count; level++) {
+			categories->headers = talloc_realloc(categories, categories->headers, struct emsmdbp_category_header,
+							     categories->header_count + 1);
+			if (!categories->headers) {
+				retval = MAPI_E_NOT_ENOUGH_MEMORY;
+				goto end;
+			}
+			header = &categories->headers[categories->header_count];
+			header->parent = level ? current[level - 1] : EMSMDBP_CATEGORY_NONE;
+			header->level = level;
+			header->key = keys[level];
+			emsmdbp_category_copy_value(categories, &header->key);
+			header->id = emsmdbp_category_id(level ? categories->headers[header->parent].id : 0, level, &header->key);
+			header->expanded = (level < categories->expanded_count);
+			if (emsmdbp_category_is_toggled(header->id, build->toggled, build->toggled_count)) {
+				header->expanded = !header->expanded;
+			}
+			header->first_leaf = i;
+			header->leaf_count = 0;
+			header->unread_count = 0;
+			current[level] = categories->header_count;
+			categories->header_count++;
+		}
+
+		flags = MSGFLAG_READ;
+		categories->leaf_ids[i] = 0;
+		if (data_pointers) {
+			if (retvals[count - 2] == MAPI_E_SUCCESS && data_pointers[count - 2]) {
+				flags = *(uint32_t *)data_pointers[count - 2];
+			}
+			if (retvals[count - 1] == MAPI_E_SUCCESS && data_pointers[count - 1]) {
+				categories->leaf_ids[i] = *(uint64_t *)data_pointers[count - 1];
+			}
+			talloc_free(retvals);
+			talloc_free(data_pointers);
+		}
+
+		for (j = 0; j < categories->category_count; j++) {
+			header = &categories->headers[current[j]];
+			header->leaf_count++;
+			if (!(flags & MSGFLAG_READ)) {
+				header->unread_count++;
+			}
+		}
+	}
+
+	build->row = last;
+	retval = MAPI_E_SUCCESS;
+
+end:
+	table->prop_count = client_count;
+	table->properties = client_columns;
+	if (emsmdbp_is_mapistore(table_object)) {
+		mapistore_table_set_columns(emsmdbp_ctx->mstore_ctx, contextID, table_object->backend_object,
+					    client_count, client_columns);
+	}
+	talloc_free(mem_ctx);
+
+	return retval;
+}
+
+
+/**
+   \details Read the next rows of a categorized view build and install
+   the view on the table once every backend row has been read
+
+   The backend rows are read max_rows at a time, so a large view can be
+   built across several calls. The table keeps its previous view until
+   the build completes, and also when it fails.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param build pointer to the build returned by
+   emsmdbp_category_table_init_start or emsmdbp_category_table_rebuild_start
+   \param max_rows the maximum number of backend rows to read
+   \param donep pointer to the boolean set when the view is installed
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_build_step(struct emsmdbp_context *emsmdbp_ctx,
+						     struct emsmdbp_object *table_object,
+						     struct emsmdbp_category_build *build,
+						     uint32_t max_rows, bool *donep)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_category_table	*old;
+	enum MAPISTATUS			retval;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!build || !build->categories || !donep, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+	*donep = false;
+
+	/* leaf rows are read from the backend table, not from the current view */
+	old = table->categories;
+	table->categories = NULL;
+	retval = emsmdbp_category_build_rows(emsmdbp_ctx, table_object, build, max_rows);
+	table->categories = old;
+	if (retval) {
+		if (!old) {
+			emsmdbp_category_leaf_count(emsmdbp_ctx, table_object, &table->denominator);
+		}
+		return retval;
+	}
+
+	if (build->row < build->row_count) {
+		return MAPI_E_SUCCESS;
+	}
+
+	emsmdbp_category_update_view(build->categories);
+	talloc_free(old);
+	table->categories = talloc_steal(table, build->categories);
+	build->categories = NULL;
+	table->denominator = table->categories->view_count;
+	if (table->numerator > table->denominator) {
+		table->numerator = table->denominator;
+	}
+	*donep = true;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Read every remaining row of a categorized view build and
+   release it
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param build pointer to the build, NULL if there is nothing to build
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_build_complete(struct emsmdbp_context *emsmdbp_ctx,
+						       struct emsmdbp_object *table_object,
+						       struct emsmdbp_category_build *build)
+{
+	enum MAPISTATUS	retval;
+	bool		done;
+
+	if (!build) {
+		return MAPI_E_SUCCESS;
+	}
+
+	retval = emsmdbp_category_build_step(emsmdbp_ctx, table_object, build, build->row_count, &done);
+	talloc_free(build);
+
+	return retval;
+}
+
+
+/**
+   \details Set up or drop the categorized view of a table after it
+   has been sorted, the rows of the new view are read by
+   emsmdbp_category_build_step
+
+   The previous view is dropped immediately since it does not match the
+   new sort order.
+
+   \param mem_ctx pointer to the memory context of the build
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param criteria pointer to the sort order of the table
+   \param buildp pointer to the build to return, NULL if the table is
+   not categorized
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_init_start(TALLOC_CTX *mem_ctx,
+							   struct emsmdbp_context *emsmdbp_ctx,
+							   struct emsmdbp_object *table_object,
+							   struct SSortOrderSet *criteria,
+							   struct emsmdbp_category_build **buildp)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_category_table	*categories;
+	enum MAPISTATUS			retval;
+	uint32_t			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!buildp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+	*buildp = NULL;
+
+	if (!criteria || !criteria->cCategories) {
+		if (!table->categories) {
+			return MAPI_E_SUCCESS;
+		}
+		talloc_free(table->categories);
+		table->categories = NULL;
+		return emsmdbp_category_leaf_count(emsmdbp_ctx, table_object, &table->denominator);
+	}
+
+	talloc_free(table->categories);
+	table->categories = NULL;
+
+	OPENCHANGE_RETVAL_IF(criteria->cCategories > criteria->cSorts, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(criteria->cExpanded > criteria->cCategories, MAPI_E_INVALID_PARAMETER, NULL);
+	for (i = 0; i < criteria->cCategories; i++) {
+		/* multi-valued categories (MV_INSTANCE) are not supported */
+		OPENCHANGE_RETVAL_IF(criteria->aSort[i].ulPropTag & MV_FLAG, MAPI_E_TOO_COMPLEX, NULL);
+	}
+
+	categories = talloc_zero(NULL, struct emsmdbp_category_table);
+	OPENCHANGE_RETVAL_IF(!categories, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	categories->category_count = criteria->cCategories;
+	categories->expanded_count = criteria->cExpanded;
+	categories->columns = talloc_array(categories, enum MAPITAGS, criteria->cCategories);
+	OPENCHANGE_RETVAL_IF(!categories->columns, MAPI_E_NOT_ENOUGH_MEMORY, categories);
+	for (i = 0; i < criteria->cCategories; i++) {
+		categories->columns[i] = criteria->aSort[i].ulPropTag;
+	}
+
+	retval = emsmdbp_category_build_init(mem_ctx, emsmdbp_ctx, table_object, categories, NULL, 0, buildp);
+	if (retval) {
+		emsmdbp_category_leaf_count(emsmdbp_ctx, table_object, &table->denominator);
+	}
+
+	return retval;
+}
+
+
+/**
+   \details Set up or drop the categorized view of a table after it
+   has been sorted
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param criteria pointer to the sort order of the table
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_init(struct emsmdbp_context *emsmdbp_ctx,
+						     struct emsmdbp_object *table_object,
+						     struct SSortOrderSet *criteria)
+{
+	struct emsmdbp_category_build	*build;
+	enum MAPISTATUS			retval;
+
+	retval = emsmdbp_category_table_init_start(NULL, emsmdbp_ctx, table_object, criteria, &build);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	return emsmdbp_category_build_complete(emsmdbp_ctx, table_object, build);
+}
+
+
+/**
+   \details Prepare the rebuild of the categorized view of a table
+
+   \param mem_ctx pointer to the memory context of the build
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param toggled array of the categories whose expanded state differs
+   from the default, NULL to keep the current states
+   \param toggled_count number of elements in toggled
+   \param buildp pointer to the build to return, NULL if the table is
+   not categorized
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_table_build_states_start(TALLOC_CTX *mem_ctx,
+								 struct emsmdbp_context *emsmdbp_ctx,
+								 struct emsmdbp_object *table_object,
+								 uint64_t *toggled, uint32_t toggled_count,
+								 struct emsmdbp_category_build **buildp)
+{
+	struct emsmdbp_object_table	*table = table_object->object.table;
+	struct emsmdbp_category_table	*categories;
+	struct emsmdbp_category_table	*old;
+	struct emsmdbp_category_header	*header;
+	uint32_t			i;
+
+	*buildp = NULL;
+	old = table->categories;
+	OPENCHANGE_RETVAL_IF(!old, MAPI_E_SUCCESS, NULL);
+
+	categories = talloc_zero(NULL, struct emsmdbp_category_table);
+	OPENCHANGE_RETVAL_IF(!categories, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	categories->category_count = old->category_count;
+	categories->expanded_count = old->expanded_count;
+	categories->columns = talloc_memdup(categories, old->columns, sizeof (enum MAPITAGS) * old->category_count);
+	OPENCHANGE_RETVAL_IF(!categories->columns, MAPI_E_NOT_ENOUGH_MEMORY, categories);
+
+	if (!toggled) {
+		toggled = talloc_array(categories, uint64_t, old->header_count ? old->header_count : 1);
+		OPENCHANGE_RETVAL_IF(!toggled, MAPI_E_NOT_ENOUGH_MEMORY, categories);
+		toggled_count = 0;
+		for (i = 0; i < old->header_count; i++) {
+			header = &old->headers[i];
+			if (header->expanded != (header->level < old->expanded_count)) {
+				toggled[toggled_count++] = header->id;
+			}
+		}
+	}
+
+	return emsmdbp_category_build_init(mem_ctx, emsmdbp_ctx, table_object, categories, toggled, toggled_count, buildp);
+}
+
+
+/**
+   \details Rebuild the categorized view of a table, keeping the
+   expanded state of its categories
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param toggled array of the categories whose expanded state differs
+   from the default, NULL to keep the current states
+   \param toggled_count number of elements in toggled
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_category_table_build_states(struct emsmdbp_context *emsmdbp_ctx,
+							   struct emsmdbp_object *table_object,
+							   uint64_t *toggled, uint32_t toggled_count)
+{
+	struct emsmdbp_category_build	*build;
+	enum MAPISTATUS			retval;
+
+	retval = emsmdbp_category_table_build_states_start(NULL, emsmdbp_ctx, table_object, toggled, toggled_count, &build);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	return emsmdbp_category_build_complete(emsmdbp_ctx, table_object, build);
+}
+
+
+/**
+   \details Prepare the rebuild of the categorized view of a table
+   after its content has changed, the rows of the new view are read by
+   emsmdbp_category_build_step. The expanded state of the categories is
+   kept.
+
+   \param mem_ctx pointer to the memory context of the build
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param buildp pointer to the build to return, NULL if the table is
+   not categorized
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_rebuild_start(TALLOC_CTX *mem_ctx,
+							      struct emsmdbp_context *emsmdbp_ctx,
+							      struct emsmdbp_object *table_object,
+							      struct emsmdbp_category_build **buildp)
+{
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!buildp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	return emsmdbp_category_table_build_states_start(mem_ctx, emsmdbp_ctx, table_object, NULL, 0, buildp);
+}
+
+
+/**
+   \details Rebuild the categorized view of a table after its content
+   has changed. The expanded state of the categories is kept.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_rebuild(struct emsmdbp_context *emsmdbp_ctx,
+							struct emsmdbp_object *table_object)
+{
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+
+	return emsmdbp_category_table_build_states(emsmdbp_ctx, table_object, NULL, 0);
+}
+
+
+/**
+   \details Retrieve the properties of a row of a categorized view
+
+   Header rows only carry the category values, the counts and the row
+   identification properties, other columns are returned as
+   MAPI_E_NOT_FOUND. Leaf rows are read from the backend table.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param row_id the position of the row in the view
+   \param query_type the type of the backend query for leaf rows
+   \param retvalsp pointer to the array of property errors to return
+
+   \return array of property values on success, otherwise NULL
+ */
+_PUBLIC_ void **emsmdbp_category_table_get_row_props(TALLOC_CTX *mem_ctx,
+						     struct emsmdbp_context *emsmdbp_ctx,
+						     struct emsmdbp_object *table_object,
+						     uint32_t row_id,
+						     enum mapistore_query_type query_type,
+						     enum MAPISTATUS **retvalsp)
+{
+	struct emsmdbp_object_table	*table = table_object->object.table;
+	struct emsmdbp_category_table	*categories = table->categories;
+	struct emsmdbp_category_header	*header;
+	struct emsmdbp_category_row	*row;
+	enum MAPISTATUS			*retvals;
+	void				**data_pointers;
+	uint32_t			*l;
+	uint64_t			*d;
+	uint32_t			i;
+	uint32_t			j;
+
+	if (!categories || row_id >= categories->view_count) {
+		return NULL;
+	}
+	row = &categories->view[row_id];
+
+	if (row->header == EMSMDBP_CATEGORY_NONE) {
+		table->categories = NULL;
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, table_object, row->leaf, query_type, &retvals);
+		table->categories = categories;
+		if (!data_pointers) {
+			return NULL;
+		}
+		for (i = 0; i < table->prop_count; i++) {
+			switch (table->properties[i]) {
+			case PR_ROW_TYPE:
+				l = talloc_zero(data_pointers, uint32_t);
+				*l = TBL_LEAF_ROW;
+				break;
+			case PR_DEPTH:
+				l = talloc_zero(data_pointers, uint32_t);
+				*l = categories->category_count;
+				break;
+			case PR_INSTANCE_NUM:
+				if (retvals[i] == MAPI_E_SUCCESS) continue;
+				l = talloc_zero(data_pointers, uint32_t);
+				*l = 0;
+				break;
+			case PR_INST_ID:
+				if (retvals[i] == MAPI_E_SUCCESS || !categories->leaf_ids[row->leaf]) continue;
+				d = talloc_zero(data_pointers, uint64_t);
+				*d = categories->leaf_ids[row->leaf];
+				data_pointers[i] = d;
+				retvals[i] = MAPI_E_SUCCESS;
+				continue;
+			default:
+				continue;
+			}
+			data_pointers[i] = l;
+			retvals[i] = MAPI_E_SUCCESS;
+		}
+		goto end;
+	}
+
+	header = &categories->headers[row->header];
+
+	data_pointers = talloc_array(mem_ctx, void *, table->prop_count);
+	retvals = talloc_array(mem_ctx, enum MAPISTATUS, table->prop_count);
+	if (!data_pointers || !retvals) {
+		talloc_free(data_pointers);
+		talloc_free(retvals);
+		return NULL;
+	}
+
+	for (i = 0; i < table->prop_count; i++) {
+		data_pointers[i] = NULL;
+		retvals[i] = MAPI_E_SUCCESS;
+		l = NULL;
+
+		switch (table->properties[i]) {
+		case PR_INST_ID:
+			d = talloc_zero(data_pointers, uint64_t);
+			*d = header->id;
+			data_pointers[i] = d;
+			continue;
+		case PR_INSTANCE_NUM:
+			l = talloc_zero(data_pointers, uint32_t);
+			*l = 0;
+			break;
+		case PR_ROW_TYPE:
+			l = talloc_zero(data_pointers, uint32_t);
+			if (!header->leaf_count) {
+				*l = TBL_EMPTY_CATEGORY;
+			} else {
+				*l = header->expanded ? TBL_EXPANDED_CATEGORY : TBL_COLLAPSED_CATEGORY;
+			}
+			break;
+		case PR_DEPTH:
+			l = talloc_zero(data_pointers, uint32_t);
+			*l = header->level;
+			break;
+		case PR_CONTENT_COUNT:
+			l = talloc_zero(data_pointers, uint32_t);
+			*l = header->leaf_count;
+			break;
+		case PR_CONTENT_UNREAD:
+			l = talloc_zero(data_pointers, uint32_t);
+			*l = header->unread_count;
+			break;
+		default:
+			/* category values of this header and its ancestors */
+			for (j = row->header; j != EMSMDBP_CATEGORY_NONE; j = categories->headers[j].parent) {
+				if (categories->columns[categories->headers[j].level] == table->properties[i]) {
+					data_pointers[i] = emsmdbp_category_put_value(data_pointers, &categories->headers[j].key);
+					break;
+				}
+			}
+			if (!data_pointers[i]) {
+				retvals[i] = MAPI_E_NOT_FOUND;
+			}
+			continue;
+		}
+		data_pointers[i] = l;
+	}
+
+end:
+	if (retvalsp) {
+		*retvalsp = retvals;
+	}
+
+	return data_pointers;
+}
+
+
+/**
+   \details Find a category header by identifier
+
+   \param categories pointer to the categorized view
+   \param category_id the category identifier
+
+   \return the index of the header, EMSMDBP_CATEGORY_NONE if not found
+ */
+static uint32_t emsmdbp_category_find_header(struct emsmdbp_category_table *categories, uint64_t category_id)
+{
+	uint32_t	i;
+
+	for (i = 0; i < categories->header_count; i++) {
+		if (categories->headers[i].id == category_id) return i;
+	}
+
+	return EMSMDBP_CATEGORY_NONE;
+}
+
+
+/**
+   \details Find the position of a header row in the view
+
+   \return the position of the header row, EMSMDBP_CATEGORY_NONE if it
+   is hidden
+ */
+static uint32_t emsmdbp_category_header_position(struct emsmdbp_category_table *categories, uint32_t index)
+{
+	uint32_t	i;
+
+	for (i = 0; i < categories->view_count; i++) {
+		if (categories->view[i].header == index) return i;
+	}
+
+	return EMSMDBP_CATEGORY_NONE;
+}
+
+
+static uint32_t emsmdbp_category_shift_position(uint32_t row, uint32_t position, uint32_t count, bool inserted)
+{
+	if (row < position) {
+		return row;
+	}
+	if (inserted) {
+		return row + count;
+	}
+	if (row >= position + count) {
+		return row - count;
+	}
+
+	/* the row is now hidden, move to the row following the category */
+	return position;
+}
+
+
+/**
+   \details Move the cursor and the bookmarks of a table after rows
+   were inserted in or removed from its view
+
+   \param table pointer to the table
+   \param position the position of the first inserted or removed row
+   \param count the number of rows
+   \param inserted whether the rows were inserted or removed
+ */
+static void emsmdbp_category_shift(struct emsmdbp_object_table *table, uint32_t position,
+				   uint32_t count, bool inserted)
+{
+	struct emsmdbp_table_bookmark	*bookmark;
+
+	table->numerator = emsmdbp_category_shift_position(table->numerator, position, count, inserted);
+	for (bookmark = table->bookmarks; bookmark; bookmark = bookmark->next) {
+		bookmark->position = emsmdbp_category_shift_position(bookmark->position, position, count, inserted);
+	}
+}
+
+
+/**
+   \details Expand a collapsed category of a view
+
+   \param table_object pointer to the table object
+   \param category_id the identifier of the category to expand
+   \param positionp pointer to the position of the category header to
+   return
+   \param countp pointer to the number of rows added to the view to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_expand(struct emsmdbp_object *table_object,
+						       uint64_t category_id,
+						       uint32_t *positionp,
+						       uint32_t *countp)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_category_table	*categories;
+	uint32_t			index;
+	uint32_t			position;
+	uint32_t			view_count;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!positionp || !countp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+	categories = table->categories;
+	OPENCHANGE_RETVAL_IF(!categories, MAPI_E_NO_SUPPORT, NULL);
+
+	index = emsmdbp_category_find_header(categories, category_id);
+	OPENCHANGE_RETVAL_IF(index == EMSMDBP_CATEGORY_NONE, MAPI_E_NOT_FOUND, NULL);
+	OPENCHANGE_RETVAL_IF(categories->headers[index].expanded, ecNotCollapsed, NULL);
+	position = emsmdbp_category_header_position(categories, index);
+	OPENCHANGE_RETVAL_IF(position == EMSMDBP_CATEGORY_NONE, MAPI_E_NOT_FOUND, NULL);
+
+	view_count = categories->view_count;
+	categories->headers[index].expanded = true;
+	emsmdbp_category_update_view(categories);
+
+	*positionp = position;
+	*countp = categories->view_count - view_count;
+	table->denominator = categories->view_count;
+	emsmdbp_category_shift(table, position + 1, *countp, true);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Collapse an expanded category of a view
+
+   \param table_object pointer to the table object
+   \param category_id the identifier of the category to collapse
+   \param positionp pointer to the position of the category header to
+   return
+   \param countp pointer to the number of rows removed from the view to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_collapse(struct emsmdbp_object *table_object,
+							 uint64_t category_id,
+							 uint32_t *positionp,
+							 uint32_t *countp)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_category_table	*categories;
+	uint32_t			index;
+	uint32_t			position;
+	uint32_t			view_count;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!positionp || !countp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+	categories = table->categories;
+	OPENCHANGE_RETVAL_IF(!categories, MAPI_E_NO_SUPPORT, NULL);
+
+	index = emsmdbp_category_find_header(categories, category_id);
+	OPENCHANGE_RETVAL_IF(index == EMSMDBP_CATEGORY_NONE, MAPI_E_NOT_FOUND, NULL);
+	OPENCHANGE_RETVAL_IF(!categories->headers[index].expanded, ecNotExpanded, NULL);
+	position = emsmdbp_category_header_position(categories, index);
+	OPENCHANGE_RETVAL_IF(position == EMSMDBP_CATEGORY_NONE, MAPI_E_NOT_FOUND, NULL);
+
+	view_count = categories->view_count;
+	categories->headers[index].expanded = false;
+	emsmdbp_category_update_view(categories);
+
+	*positionp = position;
+	*countp = view_count - categories->view_count;
+	table->denominator = categories->view_count;
+	emsmdbp_category_shift(table, position + 1, *countp, false);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Save the expanded state of the categories of a view
+
+   The collapse state holds the category layout of the view, the row to
+   position the cursor on once restored and the identifiers of the
+   categories whose state differs from the cExpanded default.
+
+   \param mem_ctx pointer to the memory context
+   \param table_object pointer to the table object
+   \param row_id the PidTagInstID of the row to restore the cursor on
+   \param instance the PidTagInstanceNum of the row
+   \param state pointer to the collapse state to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_get_state(TALLOC_CTX *mem_ctx,
+							  struct emsmdbp_object *table_object,
+							  uint64_t row_id,
+							  uint32_t instance,
+							  struct SBinary_short *state)
+{
+	struct emsmdbp_category_table	*categories;
+	struct emsmdbp_category_header	*header;
+	uint8_t				*data;
+	uint32_t			count;
+	uint32_t			length;
+	uint32_t			i;
+	uint32_t			j;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!state, MAPI_E_INVALID_PARAMETER, NULL);
+
+	categories = table_object->object.table->categories;
+	OPENCHANGE_RETVAL_IF(!categories, MAPI_E_NO_SUPPORT, NULL);
+
+	count = 0;
+	for (i = 0; i < categories->header_count; i++) {
+		header = &categories->headers[i];
+		if (header->expanded != (header->level < categories->expanded_count)) {
+			count++;
+		}
+	}
+
+	/* the state must fit a SBinary_short */
+	length = EMSMDBP_CATEGORY_STATE_SIZE + count * sizeof (uint64_t);
+	OPENCHANGE_RETVAL_IF(length > 0xFFFF, MAPI_E_TOO_BIG, NULL);
+
+	data = talloc_array(mem_ctx, uint8_t, length);
+	OPENCHANGE_RETVAL_IF(!data, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	data[0] = categories->category_count & 0xFF;
+	data[1] = categories->category_count >> 8;
+	data[2] = categories->expanded_count & 0xFF;
+	data[3] = categories->expanded_count >> 8;
+	for (j = 0; j < 8; j++) {
+		data[4 + j] = (row_id >> (j * 8)) & 0xFF;
+	}
+	for (j = 0; j < 4; j++) {
+		data[12 + j] = (instance >> (j * 8)) & 0xFF;
+		data[16 + j] = (count >> (j * 8)) & 0xFF;
+	}
+
+	length = EMSMDBP_CATEGORY_STATE_SIZE;
+	for (i = 0; i < categories->header_count; i++) {
+		header = &categories->headers[i];
+		if (header->expanded == (header->level < categories->expanded_count)) continue;
+		for (j = 0; j < 8; j++) {
+			data[length + j] = (header->id >> (j * 8)) & 0xFF;
+		}
+		length += 8;
+	}
+
+	state->cb = length;
+	state->lpb = data;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+static uint64_t emsmdbp_category_pull_uint64(const uint8_t *data)
+{
+	uint64_t	value = 0;
+	int		i;
+
+	for (i = 7; i >= 0; i--) {
+		value = (value << 8) | data[i];
+	}
+
+	return value;
+}
+
+
+/**
+   \details Restore the expanded state of the categories of a view
+
+   The cursor is moved to the row saved in the collapse state or, when
+   this row is hidden, to the header of its outermost collapsed
+   category.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param state pointer to the collapse state
+   \param positionp pointer to the position of the restored row to
+   return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_category_table_set_state(struct emsmdbp_context *emsmdbp_ctx,
+							  struct emsmdbp_object *table_object,
+							  struct SBinary_short *state,
+							  uint32_t *positionp)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_category_table	*categories;
+	struct emsmdbp_category_header	*header;
+	enum MAPISTATUS			retval;
+	uint64_t			*toggled;
+	uint64_t			row_id;
+	uint32_t			count;
+	uint32_t			index;
+	uint32_t			position;
+	uint32_t			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!state || !positionp, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+	OPENCHANGE_RETVAL_IF(!table->categories, MAPI_E_NO_SUPPORT, NULL);
+
+	OPENCHANGE_RETVAL_IF(state->cb < EMSMDBP_CATEGORY_STATE_SIZE || !state->lpb, ecInvClpsState, NULL);
+	OPENCHANGE_RETVAL_IF((state->lpb[0] | (state->lpb[1] << 8)) != table->categories->category_count, ecInvClpsState, NULL);
+	OPENCHANGE_RETVAL_IF((state->lpb[2] | (state->lpb[3] << 8)) != table->categories->expanded_count, ecInvClpsState, NULL);
+	row_id = emsmdbp_category_pull_uint64(state->lpb + 4);
+	count = state->lpb[16] | (state->lpb[17] << 8) | (state->lpb[18] << 16) | ((uint32_t)state->lpb[19] << 24);
+	OPENCHANGE_RETVAL_IF(count > (state->cb - EMSMDBP_CATEGORY_STATE_SIZE) / 8, ecInvClpsState, NULL);
+	OPENCHANGE_RETVAL_IF(state->cb != EMSMDBP_CATEGORY_STATE_SIZE + count * 8, ecInvClpsState, NULL);
+
+	toggled = talloc_array(NULL, uint64_t, count ? count : 1);
+	OPENCHANGE_RETVAL_IF(!toggled, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	for (i = 0; i < count; i++) {
+		toggled[i] = emsmdbp_category_pull_uint64(state->lpb + EMSMDBP_CATEGORY_STATE_SIZE + i * 8);
+	}
+
+	retval = emsmdbp_category_table_build_states(emsmdbp_ctx, table_object, toggled, count);
+	talloc_free(toggled);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	categories = table->categories;
+	*positionp = 0;
+
+	/* the saved row is a header row */
+	index = emsmdbp_category_find_header(categories, row_id);
+	if (index == EMSMDBP_CATEGORY_NONE) {
+		/* or a leaf row, identified from its deepest category */
+		for (i = 0; row_id && i < categories->leaf_count; i++) {
+			if (categories->leaf_ids[i] == row_id) break;
+		}
+		if (!row_id || i == categories->leaf_count) {
+			return MAPI_E_SUCCESS;
+		}
+		for (index = 0; index < categories->header_count; index++) {
+			header = &categories->headers[index];
+			if (header->level == categories->category_count - 1
+			    && i >= header->first_leaf && i < header->first_leaf + header->leaf_count) {
+				break;
+			}
+		}
+		if (index == categories->header_count) {
+			return MAPI_E_SUCCESS;
+		}
+		if (categories->headers[index].expanded) {
+			position = emsmdbp_category_header_position(categories, index);
+			if (position != EMSMDBP_CATEGORY_NONE) {
+				*positionp = position + 1 + (i - categories->headers[index].first_leaf);
+				return MAPI_E_SUCCESS;
+			}
+		}
+	}
+
+	/* the row is hidden: use its outermost collapsed category */
+	position = emsmdbp_category_header_position(categories, index);
+	for (i = categories->headers[index].parent; i != EMSMDBP_CATEGORY_NONE; i = categories->headers[i].parent) {
+		if (!categories->headers[i].expanded) {
+			position = emsmdbp_category_header_position(categories, i);
+		}
+	}
+	if (position != EMSMDBP_CATEGORY_NONE) {
+		*positionp = position;
+	}
+
+	return MAPI_E_SUCCESS;
+}
@@ -359,6 +359,24 @@ _PUBLIC_ enum MAPISTATUS emsmdbp_object_create_folder(struct emsmdbp_context *em
 			return MAPI_E_COLLISION;
 		}
 
+		value = get_SPropValue_SRow(rowp, PR_FOLDER_TYPE);
+		if (value && value->value.l == FOLDER_SEARCH) {
+			/* search folders have no content of their own and no mapistore context */
+			value = get_SPropValue_SRow(rowp, PidTagChangeNumber);
+			if (!value) {
+				talloc_free(new_folder);
+				return MAPI_E_INVALID_PARAMETER;
+			}
+			retval = openchangedb_create_folder(emsmdbp_ctx->oc_ctx, parentFolderID, fid, value->value.d, NULL, -1);
+			if (retval != MAPI_E_SUCCESS) {
+				talloc_free(new_folder);
+				return retval;
+			}
+			openchangedb_set_folder_properties(emsmdbp_ctx->oc_ctx, fid, rowp);
+			*new_folderp = new_folder;
+			return MAPI_E_SUCCESS;
+		}
+
 		value = get_SPropValue_SRow(rowp, PidTagChangeNumber);
 		if (value) {
 			postponed_props = talloc_zero(new_folder, struct SRow);
@@ -511,7 +529,16 @@ static char *emsmdbp_compute_parent_uri(TALLOC_CTX *mem_ctx, char *uri)
 	return parent_uri;
 }
 
-static int emsmdbp_get_parent_fid(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid, uint64_t *parent_fidp)
+/**
+   \details Retrieve the identifier of the parent of a folder
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the folder identifier
+   \param parent_fidp pointer to the parent folder identifier to return
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ int emsmdbp_get_parent_fid(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid, uint64_t *parent_fidp)
 {
 	TALLOC_CTX	*mem_ctx;
 	int		retval = MAPISTORE_SUCCESS;
@@ -1247,6 +1274,39 @@ _PUBLIC_ enum mapistore_error emsmdbp_folder_move_folder(struct emsmdbp_context
 	return ret;
 }
 
+/**
+   \details Delete the backend folder behind a mapistore root whose
+   openchangedb record has already been removed
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the folder identifier of the mapistore root
+   \param mapistoreURL the mapistore URI of the root
+   \param flags the folder deletion flags
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error emsmdbp_folder_delete_mapistore_root(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid, const char *mapistoreURL, uint8_t flags)
+{
+	enum mapistore_error	ret;
+	uint32_t		context_id;
+	void			*subfolder;
+
+	ret = mapistore_search_context_by_uri(emsmdbp_ctx->mstore_ctx, mapistoreURL, &context_id, &subfolder);
+	if (ret == MAPISTORE_SUCCESS) {
+		mapistore_add_context_ref_count(emsmdbp_ctx->mstore_ctx, context_id);
+	} else {
+		ret = mapistore_add_context(emsmdbp_ctx->mstore_ctx, emsmdbp_ctx->username, mapistoreURL, fid, &context_id, &subfolder);
+		if (ret != MAPISTORE_SUCCESS) {
+			return ret;
+		}
+	}
+
+	ret = mapistore_folder_delete(emsmdbp_ctx->mstore_ctx, context_id, subfolder, flags);
+	mapistore_del_context(emsmdbp_ctx->mstore_ctx, context_id);
+
+	return ret;
+}
+
 _PUBLIC_ enum mapistore_error emsmdbp_folder_delete(struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object *parent_folder, uint64_t fid, uint8_t flags)
 {
 	enum mapistore_error	ret;
@@ -1289,22 +1349,10 @@ _PUBLIC_ enum mapistore_error emsmdbp_folder_delete(struct emsmdbp_context *emsm
 		}
 
 		if (mapistoreURL) {	/* fid is mapistore root */
-			ret = mapistore_search_context_by_uri(emsmdbp_ctx->mstore_ctx, mapistoreURL, &context_id, &subfolder);
-			if (ret == MAPISTORE_SUCCESS) {
-				mapistore_add_context_ref_count(emsmdbp_ctx->mstore_ctx, context_id);
-			} else {
-				ret = mapistore_add_context(emsmdbp_ctx->mstore_ctx, emsmdbp_ctx->username, mapistoreURL, fid, &context_id, &subfolder);
-				if (ret != MAPISTORE_SUCCESS) {
-					goto end;
-				}
-			}
-
-			ret = mapistore_folder_delete(emsmdbp_ctx->mstore_ctx, context_id, subfolder, flags);
+			ret = emsmdbp_folder_delete_mapistore_root(emsmdbp_ctx, fid, mapistoreURL, flags);
 			if (ret != MAPISTORE_SUCCESS) {
 				goto end;
 			}
-
-			 mapistore_del_context(emsmdbp_ctx->mstore_ctx, context_id);
 		}
 	}
 
@@ -1383,6 +1431,12 @@ _PUBLIC_ struct emsmdbp_object *emsmdbp_folder_open_table(TALLOC_CTX *mem_ctx,
 					return table_object;
 				}
 
+				/* Contents tables of search folders are read from the match index */
+				if (table_type == MAPISTORE_MESSAGE_TABLE && parent_object->type == EMSMDBP_OBJECT_FOLDER &&
+				    emsmdbp_search_table_init(parent_object->emsmdbp_ctx, table_object, folderID) == MAPI_E_SUCCESS) {
+					return table_object;
+				}
+
 				/* Non-mapistore message tables */
 				switch (table_type) {
 				case MAPISTORE_MESSAGE_TABLE:
@@ -1463,7 +1517,10 @@ _PUBLIC_ struct emsmdbp_object *emsmdbp_object_table_init(TALLOC_CTX *mem_ctx,
 	object->object.table->denominator = 0;
 	object->object.table->ulType = 0;
 	object->object.table->restricted = false;
+	object->object.table->restriction = NULL;
 	object->object.table->subscription_list = NULL;
+	object->object.table->bookmarks = NULL;
+	object->object.table->last_bookmark = 0;
 
 	return object;
 }
@@ -1557,6 +1614,14 @@ _PUBLIC_ void **emsmdbp_object_table_get_row_props(TALLOC_CTX *mem_ctx, struct e
         table = table_object->object.table;
         num_props = table_object->object.table->prop_count;
 
+	if (table->categories) {
+		return emsmdbp_category_table_get_row_props(mem_ctx, emsmdbp_ctx, table_object, row_id, query_type, retvalsp);
+	}
+
+	if (table->search) {
+		return emsmdbp_search_table_get_row_props(mem_ctx, emsmdbp_ctx, table_object, row_id, retvalsp);
+	}
+
         data_pointers = talloc_array(mem_ctx, void *, num_props);
         memset(data_pointers, 0, sizeof(void *) * num_props);
         retvals = talloc_array(mem_ctx, enum MAPISTATUS, num_props);
@@ -1794,6 +1859,204 @@ _PUBLIC_ void emsmdbp_fill_table_row_blob(TALLOC_CTX *mem_ctx, struct emsmdbp_co
         }
 }
 
+/**
+   \details Create a bookmark on a table row
+
+   Rows of openchangedb tables are tracked by identifier and can be
+   found again after the table content changes. Other bookmarks,
+   including those of categorized views, refer to a row position which
+   is only moved by emsmdbp_object_table_move_bookmarks when the table
+   is told about inserted and deleted rows.
+
+   \param table_object pointer to the table object
+   \param position the position of the row to bookmark
+   \param bookmark_id pointer to the bookmark identifier to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_object_table_create_bookmark(struct emsmdbp_object *table_object,
+							      uint32_t position,
+							      uint32_t *bookmark_id)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_table_bookmark	*bookmark;
+	uint64_t			*fmid;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!bookmark_id, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+
+	bookmark = talloc_zero(table, struct emsmdbp_table_bookmark);
+	OPENCHANGE_RETVAL_IF(!bookmark, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	bookmark->id = ++table->last_bookmark;
+	bookmark->position = position;
+	bookmark->fmid = 0;
+
+	if (!emsmdbp_is_mapistore(table_object) && !table->categories && table_object->backend_object &&
+	    openchangedb_table_get_property(bookmark, table_object->backend_object, table_object->emsmdbp_ctx->oc_ctx,
+					    PR_INST_ID, position, false, (void **) &fmid) == MAPI_E_SUCCESS) {
+		bookmark->fmid = *fmid;
+		talloc_free(fmid);
+	}
+
+	DLIST_ADD_END(table->bookmarks, bookmark, struct emsmdbp_table_bookmark *);
+	*bookmark_id = bookmark->id;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the position of a bookmarked table row
+
+   \param table_object pointer to the table object
+   \param bookmark_id the bookmark identifier
+   \param position pointer to the row position to return
+   \param row_visible pointer to the row visibility to return: false
+   when the bookmarked row is known to be no longer in the table,
+   position then refers to the row which followed it
+
+   Bookmarks tracked by identifier return the current position of
+   their row. Positional bookmarks return the recorded position, as
+   adjusted by emsmdbp_object_table_move_bookmarks: changes the table
+   was not told about are not reflected, and the position is then
+   clamped to the table size.
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_object_table_get_bookmark(struct emsmdbp_object *table_object,
+							   uint32_t bookmark_id,
+							   uint32_t *position,
+							   bool *row_visible)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_table_bookmark	*bookmark;
+	uint32_t			pos;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+	OPENCHANGE_RETVAL_IF(!position || !row_visible, MAPI_E_INVALID_PARAMETER, NULL);
+
+	table = table_object->object.table;
+
+	for (bookmark = table->bookmarks; bookmark; bookmark = bookmark->next) {
+		if (bookmark->id == bookmark_id) break;
+	}
+	OPENCHANGE_RETVAL_IF(!bookmark, MAPI_E_INVALID_BOOKMARK, NULL);
+
+	*position = bookmark->position;
+	*row_visible = !bookmark->row_deleted;
+
+	if (bookmark->fmid) {
+		if (openchangedb_table_get_row_position(table_object->backend_object, table_object->emsmdbp_ctx->oc_ctx,
+							bookmark->fmid, false, &pos) == MAPI_E_SUCCESS) {
+			*position = pos;
+		}
+		else {
+			*row_visible = false;
+		}
+	}
+
+	if (*position >= table->denominator) {
+		*position = table->denominator;
+		*row_visible = false;
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Release a table bookmark
+
+   \param table_object pointer to the table object
+   \param bookmark_id the bookmark identifier
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_object_table_free_bookmark(struct emsmdbp_object *table_object,
+							    uint32_t bookmark_id)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_table_bookmark	*bookmark;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!table_object, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_OBJECT, NULL);
+
+	table = table_object->object.table;
+
+	for (bookmark = table->bookmarks; bookmark; bookmark = bookmark->next) {
+		if (bookmark->id == bookmark_id) break;
+	}
+	OPENCHANGE_RETVAL_IF(!bookmark, MAPI_E_INVALID_BOOKMARK, NULL);
+
+	DLIST_REMOVE(table->bookmarks, bookmark);
+	talloc_free(bookmark);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Update the bookmarks of a table after a row was inserted or
+   deleted
+
+   Bookmarks tracked by identifier are left untouched. The other
+   bookmarks follow their row, a bookmark on the deleted row then
+   refers to the row which followed it.
+
+   \param table_object pointer to the table object
+   \param position the position of the inserted or deleted row
+   \param inserted whether the row was inserted or deleted
+ */
+_PUBLIC_ void emsmdbp_object_table_move_bookmarks(struct emsmdbp_object *table_object,
+						  uint32_t position, bool inserted)
+{
+	struct emsmdbp_table_bookmark	*bookmark;
+
+	if (!table_object || table_object->type != EMSMDBP_OBJECT_TABLE) return;
+
+	for (bookmark = table_object->object.table->bookmarks; bookmark; bookmark = bookmark->next) {
+		if (bookmark->fmid || bookmark->position < position) continue;
+
+		if (inserted) {
+			bookmark->position++;
+		}
+		else if (bookmark->position > position) {
+			bookmark->position--;
+		}
+		else {
+			bookmark->row_deleted = true;
+		}
+	}
+}
+
+
+/**
+   \details Invalidate all the bookmarks of a table
+
+   \param table_object pointer to the table object
+ */
+_PUBLIC_ void emsmdbp_object_table_reset_bookmarks(struct emsmdbp_object *table_object)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_table_bookmark	*bookmark;
+
+	if (!table_object || table_object->type != EMSMDBP_OBJECT_TABLE) return;
+
+	table = table_object->object.table;
+	while ((bookmark = table->bookmarks)) {
+		DLIST_REMOVE(table->bookmarks, bookmark);
+		talloc_free(bookmark);
+	}
+}
+
 /**
    \details Initialize a message object
 
@@ -2019,6 +2282,104 @@ end:
 	return ret;
 }
 
+/**
+   \details Copy a message to another folder, whichever store hosts the
+   source and target folders
+
+   The copy is created in the target folder under the given message
+   identifier, receives a deep copy of the source message properties
+   and is saved. The source message is left untouched.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param source_folder pointer to the folder holding the message
+   \param messageID the identifier of the message to copy
+   \param target_folder pointer to the folder receiving the copy
+   \param targetMID the identifier of the copy
+
+   \return MAPISTORE_SUCCESS on success, otherwise MAPISTORE error
+ */
+_PUBLIC_ enum mapistore_error emsmdbp_object_message_copy(struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object *source_folder, uint64_t messageID, struct emsmdbp_object *target_folder, uint64_t targetMID)
+{
+	TALLOC_CTX		*local_mem_ctx;
+	struct emsmdbp_object	*source_object;
+	struct emsmdbp_object	*target_object;
+	struct SPropTagArray	props;
+	enum MAPITAGS		prop_tag = PR_ASSOCIATED;
+	void			**data_pointers;
+	enum MAPISTATUS		*retvals = NULL;
+	enum MAPISTATUS		retval;
+	enum mapistore_error	ret;
+	uint32_t		contextID;
+	bool			associated = false;
+
+	/* Sanity checks */
+	if (!emsmdbp_ctx) return MAPISTORE_ERR_INVALID_PARAMETER;
+	if (!source_folder || source_folder->type != EMSMDBP_OBJECT_FOLDER) return MAPISTORE_ERR_INVALID_PARAMETER;
+	if (!target_folder || target_folder->type != EMSMDBP_OBJECT_FOLDER) return MAPISTORE_ERR_INVALID_PARAMETER;
+
+	local_mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+
+	ret = emsmdbp_object_message_open(local_mem_ctx, emsmdbp_ctx, source_folder, source_folder->object.folder->folderID,
+					  messageID, false, &source_object, NULL);
+	if (ret != MAPISTORE_SUCCESS) {
+		goto end;
+	}
+
+	/* FAI messages remain FAI messages in the target folder */
+	props.cValues = 1;
+	props.aulPropTag = &prop_tag;
+	data_pointers = emsmdbp_object_get_properties(local_mem_ctx, emsmdbp_ctx, source_object, &props, &retvals);
+	if (data_pointers && retvals[0] == MAPI_E_SUCCESS) {
+		associated = *(bool *) data_pointers[0];
+	}
+
+	target_object = emsmdbp_object_message_init(local_mem_ctx, emsmdbp_ctx, targetMID, target_folder);
+	if (!target_object) {
+		ret = MAPISTORE_ERR_NO_MEMORY;
+		goto end;
+	}
+	target_object->object.message->read_write = true;
+
+	contextID = emsmdbp_get_contextID(target_folder);
+	if (emsmdbp_is_mapistore(target_folder)) {
+		ret = mapistore_folder_create_message(emsmdbp_ctx->mstore_ctx, contextID, target_folder->backend_object,
+						      target_object, targetMID, associated, &target_object->backend_object);
+		if (ret != MAPISTORE_SUCCESS) {
+			goto end;
+		}
+	}
+	else {
+		retval = openchangedb_message_create(target_object, emsmdbp_ctx->oc_ctx, targetMID,
+						     target_folder->object.folder->folderID, associated,
+						     &target_object->backend_object);
+		if (retval != MAPI_E_SUCCESS) {
+			ret = MAPISTORE_ERROR;
+			goto end;
+		}
+	}
+
+	if (emsmdbp_object_copy_properties(emsmdbp_ctx, source_object, target_object, NULL, true) != MAPI_E_SUCCESS) {
+		ret = MAPISTORE_ERROR;
+		goto end;
+	}
+
+	if (emsmdbp_is_mapistore(target_folder)) {
+		ret = mapistore_message_save(emsmdbp_ctx->mstore_ctx, contextID, target_object->backend_object, local_mem_ctx);
+		if (ret == MAPISTORE_SUCCESS) {
+			mapistore_indexing_record_add_mid(emsmdbp_ctx->mstore_ctx, contextID, emsmdbp_get_owner(target_folder), targetMID);
+		}
+	}
+	else {
+		retval = openchangedb_message_save(target_object->backend_object, 0);
+		ret = (retval == MAPI_E_SUCCESS) ? MAPISTORE_SUCCESS : MAPISTORE_ERROR;
+	}
+
+end:
+	talloc_free(local_mem_ctx);
+
+	return ret;
+}
+
 _PUBLIC_ struct emsmdbp_object *emsmdbp_object_message_open_attachment_table(TALLOC_CTX *mem_ctx, struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object *message_object)
 {
 	struct emsmdbp_object	*table_object = NULL;
@@ -2171,6 +2532,12 @@ _PUBLIC_ int emsmdbp_object_get_available_properties(TALLOC_CTX *mem_ctx, struct
 	}
 	
 	if (!emsmdbp_is_mapistore(object)) {
+		if (object->type == EMSMDBP_OBJECT_MESSAGE) {
+			if (openchangedb_message_get_available_properties(mem_ctx, object->backend_object, propertiesp) != MAPI_E_SUCCESS) {
+				return MAPISTORE_ERROR;
+			}
+			return MAPISTORE_SUCCESS;
+		}
 		DEBUG(5, (__location__": only mapistore is supported at this time\n"));
 		return MAPISTORE_ERROR;
 	}
@@ -0,0 +1,1224 @@
+/*
+   OpenChange Server implementation
+
+   EMSMDBP: EMSMDB Provider implementation
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+   \file emsmdbp_search.c
+
+   \brief Search folders
+
+   Search folders are openchangedb folders holding their criteria and
+   the list of matching messages (see openchangedb_search.c). The list
+   is populated by a crawl of the search scope and kept current from
+   the mapistore notifications, so the contents table of a search
+   folder is built from the stored list without scanning the mailbox.
+
+   The server has no facility to run work outside of a request: the
+   crawl is performed by steps, at the end of each EcDoRpc transaction,
+   with a budget of EMSMDBP_SEARCH_CRAWL_BUDGET messages per search
+   folder. Searches started with FOREGROUND_SEARCH are crawled to
+   completion by SetSearchCriteria.
+ */
+
+#include "mapiproxy/dcesrv_mapiproxy.h"
+#include "dcesrv_exchange_emsmdb.h"
+
+/* property values of a message, as returned by emsmdbp_object_get_properties */
+struct emsmdbp_search_values {
+	struct SPropTagArray	*columns;
+	void			**data_pointers;
+	enum MAPISTATUS		*retvals;
+};
+
+
+/**
+   \details Add the properties referenced by a restriction to a
+   property array
+
+   \param mem_ctx pointer to the memory context
+   \param columns pointer to the property array to update
+   \param res pointer to the restriction
+ */
+static void emsmdbp_search_add_columns(TALLOC_CTX *mem_ctx, struct SPropTagArray *columns,
+				       struct mapi_SRestriction *res)
+{
+	uint32_t	proptags[2];
+	uint32_t	count = 0;
+	uint32_t	i;
+	uint32_t	j;
+
+	switch (res->rt) {
+	case RES_AND:
+		for (i = 0; i < res->res.resAnd.cRes; i++) {
+			emsmdbp_search_add_columns(mem_ctx, columns, (struct mapi_SRestriction *)&res->res.resAnd.res[i]);
+		}
+		break;
+	case RES_OR:
+		for (i = 0; i < res->res.resOr.cRes; i++) {
+			emsmdbp_search_add_columns(mem_ctx, columns, (struct mapi_SRestriction *)&res->res.resOr.res[i]);
+		}
+		break;
+	case RES_NOT:
+		emsmdbp_search_add_columns(mem_ctx, columns, (struct mapi_SRestriction *)&res->res.resNot.res);
+		break;
+	case RES_CONTENT:
+		proptags[count++] = res->res.resContent.ulPropTag;
+		break;
+	case RES_PROPERTY:
+		proptags[count++] = res->res.resProperty.ulPropTag;
+		break;
+	case RES_COMPAREPROPS:
+		proptags[count++] = res->res.resCompareProps.ulPropTag1;
+		proptags[count++] = res->res.resCompareProps.ulPropTag2;
+		break;
+	case RES_BITMASK:
+		proptags[count++] = res->res.resBitmask.ulPropTag;
+		break;
+	case RES_SIZE:
+		proptags[count++] = res->res.resSize.ulPropTag;
+		break;
+	case RES_EXIST:
+		proptags[count++] = res->res.resExist.ulPropTag;
+		break;
+	case RES_COMMENT:
+		if (res->res.resComment.RestrictionPresent) {
+			emsmdbp_search_add_columns(mem_ctx, columns, (struct mapi_SRestriction *)res->res.resComment.Restriction.res);
+		}
+		break;
+	default:
+		break;
+	}
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < columns->cValues; j++) {
+			if (columns->aulPropTag[j] == proptags[i]) break;
+		}
+		if (j == columns->cValues) {
+			SPropTagArray_add(mem_ctx, columns, proptags[i]);
+		}
+	}
+}
+
+
+/**
+   \details Build the array of properties referenced by a restriction
+
+   \param mem_ctx pointer to the memory context
+   \param res pointer to the restriction
+
+   \return Allocated property array on success, otherwise NULL
+ */
+static struct SPropTagArray *emsmdbp_search_get_columns(TALLOC_CTX *mem_ctx, struct mapi_SRestriction *res)
+{
+	struct SPropTagArray	*columns;
+
+	columns = talloc_zero(mem_ctx, struct SPropTagArray);
+	if (!columns) return NULL;
+	columns->aulPropTag = talloc_zero(columns, enum MAPITAGS);
+	if (!columns->aulPropTag) {
+		talloc_free(columns);
+		return NULL;
+	}
+	emsmdbp_search_add_columns(columns, columns, res);
+
+	return columns;
+}
+
+
+/**
+   \details Retrieve a comparable value from the properties of a
+   message, see openchangedb_restriction_match
+ */
+static bool emsmdbp_search_get_value(TALLOC_CTX *mem_ctx, void *private_data,
+				     uint32_t proptag, struct openchangedb_table_value *value)
+{
+	struct emsmdbp_search_values	*values = (struct emsmdbp_search_values *)private_data;
+	struct FILETIME			*ft;
+	struct Binary_r			*bin;
+	void				*data;
+	uint32_t			i;
+
+	value->type = PT_UNSPECIFIED;
+
+	for (i = 0; i < values->columns->cValues; i++) {
+		if (values->columns->aulPropTag[i] == proptag) break;
+	}
+	if (i == values->columns->cValues || values->retvals[i] != MAPI_E_SUCCESS || !values->data_pointers[i]) {
+		return false;
+	}
+	data = values->data_pointers[i];
+
+	switch (proptag & 0xFFFF) {
+	case PT_BOOLEAN:
+		value->value.i = *(uint8_t *)data;
+		break;
+	case PT_I2:
+		value->value.i = *(uint16_t *)data;
+		break;
+	case PT_LONG:
+		value->value.i = *(uint32_t *)data;
+		break;
+	case PT_I8:
+		value->value.i = *(uint64_t *)data;
+		break;
+	case PT_SYSTIME:
+		ft = (struct FILETIME *)data;
+		value->value.i = ((uint64_t)ft->dwHighDateTime << 32) | ft->dwLowDateTime;
+		break;
+	case PT_STRING8:
+	case PT_UNICODE:
+		value->value.str = (const char *)data;
+		break;
+	case PT_BINARY:
+		bin = (struct Binary_r *)data;
+		value->value.bin.data = bin->lpb;
+		value->value.bin.length = bin->cb;
+		break;
+	default:
+		return true;
+	}
+	value->type = proptag & 0xFFFF;
+
+	return true;
+}
+
+
+/**
+   \details Open a message and retrieve a set of its properties
+
+   The message object is allocated under the returned data pointers.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param context_object pointer to the object used to open the folder
+   \param folderID the folder identifier of the message
+   \param messageID the message identifier
+   \param values pointer to the values to fill
+
+   \return true on success, otherwise false
+ */
+static bool emsmdbp_search_fetch(TALLOC_CTX *mem_ctx, struct emsmdbp_context *emsmdbp_ctx,
+				 struct emsmdbp_object *context_object,
+				 uint64_t folderID, uint64_t messageID,
+				 struct emsmdbp_search_values *values)
+{
+	TALLOC_CTX		*local_mem_ctx;
+	struct emsmdbp_object	*message_object;
+
+	local_mem_ctx = talloc_new(mem_ctx);
+	if (emsmdbp_object_message_open(local_mem_ctx, emsmdbp_ctx, context_object, folderID, messageID, false, &message_object, NULL) != MAPISTORE_SUCCESS) {
+		talloc_free(local_mem_ctx);
+		return false;
+	}
+
+	values->data_pointers = emsmdbp_object_get_properties(mem_ctx, emsmdbp_ctx, message_object, values->columns, &values->retvals);
+	if (!values->data_pointers) {
+		talloc_free(local_mem_ctx);
+		return false;
+	}
+	talloc_steal(values->data_pointers, local_mem_ctx);
+
+	return true;
+}
+
+
+/**
+   \details Evaluate a restriction against a message
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param context_object pointer to the object used to open the folder
+   \param folderID the folder identifier of the message
+   \param messageID the message identifier
+   \param res pointer to the restriction
+   \param columns pointer to the properties referenced by res
+
+   \return true if the message exists and matches, otherwise false
+ */
+static bool emsmdbp_search_match(struct emsmdbp_context *emsmdbp_ctx,
+				 struct emsmdbp_object *context_object,
+				 uint64_t folderID, uint64_t messageID,
+				 struct mapi_SRestriction *res,
+				 struct SPropTagArray *columns)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_search_values	values;
+	bool				match = false;
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_match");
+	values.columns = columns;
+	if (emsmdbp_search_fetch(mem_ctx, emsmdbp_ctx, context_object, folderID, messageID, &values)) {
+		match = openchangedb_restriction_match(mem_ctx, res, emsmdbp_search_get_value, &values);
+	}
+	talloc_free(mem_ctx);
+
+	return match;
+}
+
+
+static struct emsmdbp_search_folder *emsmdbp_search_find(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid)
+{
+	struct emsmdbp_search_folder	*search_folder;
+
+	for (search_folder = emsmdbp_ctx->search_folders; search_folder; search_folder = search_folder->next) {
+		if (search_folder->folderID == fid) {
+			return search_folder;
+		}
+	}
+
+	return NULL;
+}
+
+
+static void emsmdbp_search_drop(struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_search_folder *search_folder)
+{
+	DEBUG(5, ("[%s:%d]: search folder 0x%.16"PRIx64" no longer exists\n", __FUNCTION__, __LINE__, search_folder->folderID));
+	DLIST_REMOVE(emsmdbp_ctx->search_folders, search_folder);
+	talloc_free(search_folder);
+}
+
+
+/**
+   \details Store the search state of a search folder
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param search_folder pointer to the search folder
+   \param state the new search state
+ */
+static void emsmdbp_search_set_state(struct emsmdbp_context *emsmdbp_ctx,
+				     struct emsmdbp_search_folder *search_folder,
+				     uint32_t state)
+{
+	search_folder->state = state;
+	openchangedb_set_search_state(emsmdbp_ctx->oc_ctx, search_folder->folderID, state);
+}
+
+
+/**
+   \details Reset the crawl of a search folder to its search scope
+
+   \param search_folder pointer to the search folder
+ */
+static void emsmdbp_search_start_crawl(struct emsmdbp_search_folder *search_folder)
+{
+	talloc_free(search_folder->crawl_fids);
+	talloc_free(search_folder->crawl_mids);
+	search_folder->crawl_fids = talloc_memdup(search_folder, search_folder->scope, search_folder->scope_count * sizeof (uint64_t));
+	search_folder->crawl_fid_count = search_folder->crawl_fids ? search_folder->scope_count : 0;
+	search_folder->crawl_folderID = 0;
+	search_folder->crawl_mids = NULL;
+	search_folder->crawl_mid_count = 0;
+	search_folder->crawl_mid_idx = 0;
+}
+
+
+static void emsmdbp_search_stop_crawl(struct emsmdbp_search_folder *search_folder)
+{
+	talloc_free(search_folder->crawl_fids);
+	talloc_free(search_folder->crawl_mids);
+	search_folder->crawl_fids = NULL;
+	search_folder->crawl_fid_count = 0;
+	search_folder->crawl_mids = NULL;
+	search_folder->crawl_mid_count = 0;
+	search_folder->crawl_mid_idx = 0;
+}
+
+
+/**
+   \details Load the criteria of a search folder from openchangedb
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the search folder identifier
+
+   \return Allocated search folder on success, otherwise NULL
+ */
+static struct emsmdbp_search_folder *emsmdbp_search_folder_load(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid)
+{
+	struct emsmdbp_search_folder	*search_folder;
+	enum MAPISTATUS			retval;
+
+	search_folder = talloc_zero(emsmdbp_ctx, struct emsmdbp_search_folder);
+	if (!search_folder) return NULL;
+
+	search_folder->folderID = fid;
+	retval = openchangedb_get_search_criteria(search_folder, emsmdbp_ctx->oc_ctx, fid,
+						  &search_folder->restriction,
+						  &search_folder->scope_count,
+						  &search_folder->scope,
+						  &search_folder->flags,
+						  &search_folder->state);
+	if (retval != MAPI_E_SUCCESS) {
+		talloc_free(search_folder);
+		return NULL;
+	}
+
+	search_folder->columns = emsmdbp_search_get_columns(search_folder, search_folder->restriction);
+	if (!search_folder->columns) {
+		talloc_free(search_folder);
+		return NULL;
+	}
+
+	return search_folder;
+}
+
+
+/**
+   \details Load the search folders of the mailbox, once per session
+
+   Searches interrupted before the end of their crawl are restarted.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+ */
+static void emsmdbp_search_load(struct emsmdbp_context *emsmdbp_ctx)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_search_folder	*search_folder;
+	enum MAPISTATUS			retval;
+	uint64_t			*fids;
+	uint32_t			count;
+	uint32_t			i;
+
+	if (emsmdbp_ctx->search_loaded) return;
+	if (!emsmdbp_ctx->username || !emsmdbp_ctx->szUserDN) return;
+
+	/* the mailbox may not be provisioned before the first Logon */
+	emsmdbp_ctx->search_mailbox = emsmdbp_object_mailbox_init(emsmdbp_ctx, emsmdbp_ctx, emsmdbp_ctx->szUserDN, true);
+	if (!emsmdbp_ctx->search_mailbox) {
+		DEBUG(5, ("[%s:%d]: unable to open the mailbox of %s\n", __FUNCTION__, __LINE__, emsmdbp_ctx->username));
+		return;
+	}
+	emsmdbp_ctx->search_loaded = true;
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_load");
+	retval = openchangedb_get_search_folders(mem_ctx, emsmdbp_ctx->oc_ctx, emsmdbp_ctx->username, &count, &fids);
+	if (retval != MAPI_E_SUCCESS) {
+		talloc_free(mem_ctx);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		search_folder = emsmdbp_search_folder_load(emsmdbp_ctx, fids[i]);
+		if (!search_folder) continue;
+
+		if (search_folder->state & SEARCH_REBUILD) {
+			/* the matches found so far may be stale */
+			openchangedb_set_search_criteria(emsmdbp_ctx->oc_ctx, search_folder->folderID,
+							 search_folder->restriction,
+							 search_folder->scope_count, search_folder->scope,
+							 search_folder->flags, search_folder->state);
+			emsmdbp_search_start_crawl(search_folder);
+		}
+		DLIST_ADD_END(emsmdbp_ctx->search_folders, search_folder, struct emsmdbp_search_folder *);
+	}
+	DEBUG(5, ("[%s:%d]: %d search folders loaded\n", __FUNCTION__, __LINE__, count));
+
+	talloc_free(mem_ctx);
+}
+
+
+/**
+   \details Check whether a folder is within the scope of a search
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param search_folder pointer to the search folder
+   \param fid the folder identifier
+
+   \return true if messages of the folder are searched, otherwise false
+ */
+static bool emsmdbp_search_in_scope(struct emsmdbp_context *emsmdbp_ctx,
+				    struct emsmdbp_search_folder *search_folder,
+				    uint64_t fid)
+{
+	uint64_t	parent_fid;
+	uint32_t	depth;
+	uint16_t	i;
+
+	for (depth = 0; fid && depth < 64; depth++) {
+		if (fid == search_folder->folderID) return false;
+		for (i = 0; i < search_folder->scope_count; i++) {
+			if (search_folder->scope[i] == fid) return true;
+		}
+		if (!(search_folder->flags & RECURSIVE_SEARCH)) return false;
+		if (emsmdbp_get_parent_fid(emsmdbp_ctx, fid, &parent_fid) != MAPISTORE_SUCCESS) return false;
+		fid = parent_fid;
+	}
+
+	return false;
+}
+
+
+/**
+   \details List the children of a folder
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param folder_object pointer to the folder object
+   \param fid the folder identifier
+   \param table_type MAPISTORE_MESSAGE_TABLE or MAPISTORE_FOLDER_TABLE
+   \param fmidsp pointer on pointer to the children identifiers to return
+   \param countp pointer to the number of children to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_search_get_child_fmids(TALLOC_CTX *mem_ctx,
+						      struct emsmdbp_context *emsmdbp_ctx,
+						      struct emsmdbp_object *folder_object,
+						      uint64_t fid,
+						      enum mapistore_table_type table_type,
+						      uint64_t **fmidsp, uint32_t *countp)
+{
+	enum MAPISTATUS		retval;
+	enum mapistore_error	ret;
+	void			*table;
+	uint64_t		*fmids;
+	uint64_t		*fmid;
+	uint32_t		count;
+	uint32_t		i;
+
+	if (emsmdbp_is_mapistore(folder_object)) {
+		ret = mapistore_folder_get_child_fmids(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(folder_object),
+						       folder_object->backend_object, table_type, mem_ctx, fmidsp, countp);
+		return mapistore_error_to_mapi(ret);
+	}
+
+	retval = openchangedb_table_init(mem_ctx, table_type, fid, &table);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	retval = openchangedb_table_get_row_count(table, emsmdbp_ctx->oc_ctx, &count);
+	OPENCHANGE_RETVAL_IF(retval, retval, table);
+
+	fmids = talloc_array(mem_ctx, uint64_t, count);
+	OPENCHANGE_RETVAL_IF(!fmids, MAPI_E_NOT_ENOUGH_MEMORY, table);
+	for (i = 0; i < count; i++) {
+		retval = openchangedb_table_get_property(table, table, emsmdbp_ctx->oc_ctx,
+							 (table_type == MAPISTORE_FOLDER_TABLE) ? PR_FID : PR_MID,
+							 i, false, (void **) &fmid);
+		if (retval) {
+			talloc_free(fmids);
+			talloc_free(table);
+			return retval;
+		}
+		fmids[i] = *fmid;
+	}
+	talloc_free(table);
+
+	*fmidsp = fmids;
+	*countp = count;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Enter the next folder of the crawl: list its messages and,
+   for recursive searches, queue its subfolders
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param search_folder pointer to the search folder
+   \param mem_ctx pointer to the memory context of the folder object
+   \param folder_objectp pointer on pointer to the folder object to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS emsmdbp_search_crawl_next_folder(struct emsmdbp_context *emsmdbp_ctx,
+							struct emsmdbp_search_folder *search_folder,
+							TALLOC_CTX *mem_ctx,
+							struct emsmdbp_object **folder_objectp)
+{
+	struct emsmdbp_object	*folder_object;
+	enum MAPISTATUS		retval;
+	uint64_t		fid;
+	uint64_t		*fids;
+	uint32_t		count;
+	uint32_t		i;
+
+	fid = search_folder->crawl_fids[--search_folder->crawl_fid_count];
+
+	talloc_free(search_folder->crawl_mids);
+	search_folder->crawl_folderID = fid;
+	search_folder->crawl_mids = NULL;
+	search_folder->crawl_mid_count = 0;
+	search_folder->crawl_mid_idx = 0;
+
+	if (emsmdbp_object_open_folder_by_fid(mem_ctx, emsmdbp_ctx, emsmdbp_ctx->search_mailbox, fid, &folder_object) != MAPISTORE_SUCCESS) {
+		DEBUG(5, ("[%s:%d]: unable to open folder 0x%.16"PRIx64"\n", __FUNCTION__, __LINE__, fid));
+		return MAPI_E_NOT_FOUND;
+	}
+
+	retval = emsmdbp_search_get_child_fmids(search_folder, emsmdbp_ctx, folder_object, fid, MAPISTORE_MESSAGE_TABLE,
+						&search_folder->crawl_mids, &search_folder->crawl_mid_count);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	if (search_folder->flags & RECURSIVE_SEARCH) {
+		retval = emsmdbp_search_get_child_fmids(mem_ctx, emsmdbp_ctx, folder_object, fid, MAPISTORE_FOLDER_TABLE, &fids, &count);
+		if (retval == MAPI_E_SUCCESS && count) {
+			search_folder->crawl_fids = talloc_realloc(search_folder, search_folder->crawl_fids, uint64_t,
+								   search_folder->crawl_fid_count + count);
+			OPENCHANGE_RETVAL_IF(!search_folder->crawl_fids, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+			for (i = 0; i < count; i++) {
+				if (emsmdbp_search_find(emsmdbp_ctx, fids[i])) continue;
+				search_folder->crawl_fids[search_folder->crawl_fid_count++] = fids[i];
+			}
+		}
+	}
+
+	*folder_objectp = folder_object;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Perform a step of the crawl of a search folder
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param search_folder pointer to the search folder
+   \param budget the number of messages and folders to examine
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if the search
+   folder no longer exists
+ */
+static enum MAPISTATUS emsmdbp_search_crawl_folder(struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_search_folder *search_folder,
+						   uint32_t budget)
+{
+	TALLOC_CTX		*mem_ctx;
+	struct emsmdbp_object	*folder_object = NULL;
+	enum MAPISTATUS		retval = MAPI_E_SUCCESS;
+	uint64_t		mid;
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_crawl_folder");
+
+	while (budget) {
+		if (search_folder->crawl_mid_idx < search_folder->crawl_mid_count) {
+			if (!folder_object &&
+			    emsmdbp_object_open_folder_by_fid(mem_ctx, emsmdbp_ctx, emsmdbp_ctx->search_mailbox,
+							      search_folder->crawl_folderID, &folder_object) != MAPISTORE_SUCCESS) {
+				search_folder->crawl_mid_count = 0;
+				continue;
+			}
+			mid = search_folder->crawl_mids[search_folder->crawl_mid_idx++];
+			if (emsmdbp_search_match(emsmdbp_ctx, folder_object, search_folder->crawl_folderID, mid,
+						 search_folder->restriction, search_folder->columns)) {
+				retval = openchangedb_search_add_match(emsmdbp_ctx->oc_ctx, search_folder->folderID,
+								       search_folder->crawl_folderID, mid);
+				if (retval == MAPI_E_NOT_FOUND) break;
+			}
+			budget--;
+		}
+		else if (search_folder->crawl_fid_count) {
+			talloc_free_children(mem_ctx);
+			folder_object = NULL;
+			emsmdbp_search_crawl_next_folder(emsmdbp_ctx, search_folder, mem_ctx, &folder_object);
+			budget--;
+		}
+		else {
+			emsmdbp_search_stop_crawl(search_folder);
+			if (search_folder->flags & STATIC_SEARCH) {
+				emsmdbp_search_set_state(emsmdbp_ctx, search_folder,
+							 (search_folder->state & ~(SEARCH_RUNNING|SEARCH_REBUILD)) | SEARCH_COMPLETE);
+			}
+			else {
+				emsmdbp_search_set_state(emsmdbp_ctx, search_folder,
+							 (search_folder->state & ~SEARCH_REBUILD) | SEARCH_COMPLETE);
+			}
+			DEBUG(5, ("[%s:%d]: search folder 0x%.16"PRIx64" populated\n", __FUNCTION__, __LINE__, search_folder->folderID));
+			break;
+		}
+	}
+
+	talloc_free(mem_ctx);
+
+	return retval;
+}
+
+
+/**
+   \details Check whether a folder is a search folder
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the folder identifier
+
+   \return true if the folder was created as a search folder,
+   otherwise false
+ */
+_PUBLIC_ bool emsmdbp_search_is_search_folder(struct emsmdbp_context *emsmdbp_ctx, uint64_t fid)
+{
+	TALLOC_CTX	*mem_ctx;
+	uint32_t	*folder_type;
+	bool		ret = false;
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_is_search_folder");
+	if (openchangedb_get_folder_property(mem_ctx, emsmdbp_ctx->oc_ctx, PR_FOLDER_TYPE, fid, (void **) &folder_type) == MAPI_E_SUCCESS) {
+		ret = (*folder_type == FOLDER_SEARCH);
+	}
+	talloc_free(mem_ctx);
+
+	return ret;
+}
+
+
+/**
+   \details Set the criteria of a search folder and start the search
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the search folder identifier
+   \param res pointer to the search restriction
+   \param FolderIdCount the number of folders in FolderIds
+   \param FolderIds pointer to the folders to search, the current
+   scope is kept when FolderIdCount is 0
+   \param SearchFlags the SetSearchCriteria flags
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_set_criteria(struct emsmdbp_context *emsmdbp_ctx,
+						     uint64_t fid,
+						     struct mapi_SRestriction *res,
+						     uint16_t FolderIdCount,
+						     uint64_t *FolderIds,
+						     uint32_t SearchFlags)
+{
+	struct emsmdbp_search_folder	*search_folder;
+	enum MAPISTATUS			retval;
+	uint32_t			state;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!res, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!emsmdbp_search_is_search_folder(emsmdbp_ctx, fid), MAPI_E_NO_SUPPORT, NULL);
+
+	emsmdbp_search_load(emsmdbp_ctx);
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx->search_mailbox, MAPI_E_NOT_INITIALIZED, NULL);
+	search_folder = emsmdbp_search_find(emsmdbp_ctx, fid);
+
+	/* Step 1. Stopping a search keeps its current matches */
+	if ((SearchFlags & STOP_SEARCH) && !(SearchFlags & RESTART_SEARCH)) {
+		OPENCHANGE_RETVAL_IF(!search_folder, MAPI_E_NOT_INITIALIZED, NULL);
+		emsmdbp_search_stop_crawl(search_folder);
+		emsmdbp_search_set_state(emsmdbp_ctx, search_folder, search_folder->state & ~(SEARCH_RUNNING|SEARCH_REBUILD));
+		return MAPI_E_SUCCESS;
+	}
+
+	if (!FolderIdCount) {
+		OPENCHANGE_RETVAL_IF(!search_folder, MAPI_E_INVALID_PARAMETER, NULL);
+		FolderIdCount = search_folder->scope_count;
+		FolderIds = search_folder->scope;
+	}
+
+	/* Step 2. Store the criteria, this empties the match index */
+	state = SEARCH_RUNNING | SEARCH_REBUILD;
+	if (SearchFlags & RECURSIVE_SEARCH) {
+		state |= SEARCH_RECURSIVE;
+	}
+	if (SearchFlags & FOREGROUND_SEARCH) {
+		state |= SEARCH_FOREGROUND;
+	}
+	if (SearchFlags & STATIC_SEARCH) {
+		state |= SEARCH_STATIC;
+	}
+	retval = openchangedb_set_search_criteria(emsmdbp_ctx->oc_ctx, fid, res, FolderIdCount, FolderIds,
+						  SearchFlags & ~(STOP_SEARCH|RESTART_SEARCH), state);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* Step 3. Replace the loaded criteria */
+	if (search_folder) {
+		DLIST_REMOVE(emsmdbp_ctx->search_folders, search_folder);
+		talloc_free(search_folder);
+	}
+	search_folder = emsmdbp_search_folder_load(emsmdbp_ctx, fid);
+	OPENCHANGE_RETVAL_IF(!search_folder, MAPI_E_CALL_FAILED, NULL);
+	DLIST_ADD_END(emsmdbp_ctx->search_folders, search_folder, struct emsmdbp_search_folder *);
+
+	/* Step 4. Populate the index */
+	emsmdbp_search_start_crawl(search_folder);
+	if (SearchFlags & FOREGROUND_SEARCH) {
+		retval = emsmdbp_search_crawl_folder(emsmdbp_ctx, search_folder, (uint32_t) -1);
+		if (retval == MAPI_E_NOT_FOUND) {
+			emsmdbp_search_drop(emsmdbp_ctx, search_folder);
+			return retval;
+		}
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the criteria and state of a search folder
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param fid the search folder identifier
+   \param res pointer on pointer to the search restriction to return
+   \param FolderIdCount pointer to the number of folders to return
+   \param FolderIds pointer on pointer to the searched folders to return
+   \param SearchState pointer to the search state to return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_INITIALIZED if the
+   criteria were never set, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_get_criteria(TALLOC_CTX *mem_ctx,
+						     struct emsmdbp_context *emsmdbp_ctx,
+						     uint64_t fid,
+						     struct mapi_SRestriction **res,
+						     uint16_t *FolderIdCount,
+						     uint64_t **FolderIds,
+						     uint32_t *SearchState)
+{
+	uint32_t	SearchFlags;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+
+	emsmdbp_search_load(emsmdbp_ctx);
+
+	return openchangedb_get_search_criteria(mem_ctx, emsmdbp_ctx->oc_ctx, fid, res, FolderIdCount,
+						FolderIds, &SearchFlags, SearchState);
+}
+
+
+/**
+   \details Continue the crawl of the search folders being populated
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param budget the number of messages to examine per search folder
+ */
+_PUBLIC_ void emsmdbp_search_crawl(struct emsmdbp_context *emsmdbp_ctx, uint32_t budget)
+{
+	struct emsmdbp_search_folder	*search_folder;
+	struct emsmdbp_search_folder	*next;
+
+	if (!emsmdbp_ctx) return;
+
+	emsmdbp_search_load(emsmdbp_ctx);
+
+	for (search_folder = emsmdbp_ctx->search_folders; search_folder; search_folder = next) {
+		next = search_folder->next;
+		if (!(search_folder->state & SEARCH_REBUILD)) continue;
+		if (emsmdbp_search_crawl_folder(emsmdbp_ctx, search_folder, budget) == MAPI_E_NOT_FOUND) {
+			emsmdbp_search_drop(emsmdbp_ctx, search_folder);
+		}
+	}
+}
+
+
+/**
+   \details Update a search folder index for a created or modified
+   message
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if the search
+   folder no longer exists
+ */
+static enum MAPISTATUS emsmdbp_search_update(struct emsmdbp_context *emsmdbp_ctx,
+					     struct emsmdbp_search_folder *search_folder,
+					     uint64_t folderID, uint64_t messageID)
+{
+	if (!emsmdbp_search_in_scope(emsmdbp_ctx, search_folder, folderID)) {
+		return MAPI_E_SUCCESS;
+	}
+
+	if (emsmdbp_search_match(emsmdbp_ctx, emsmdbp_ctx->search_mailbox, folderID, messageID,
+				 search_folder->restriction, search_folder->columns)) {
+		return openchangedb_search_add_match(emsmdbp_ctx->oc_ctx, search_folder->folderID, folderID, messageID);
+	}
+
+	return openchangedb_search_del_match(emsmdbp_ctx->oc_ctx, search_folder->folderID, folderID, messageID);
+}
+
+
+/**
+   \details Update the search folder indexes from a mapistore
+   notification
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param notification pointer to the mapistore notification
+ */
+_PUBLIC_ void emsmdbp_search_notification(struct emsmdbp_context *emsmdbp_ctx,
+					  struct mapistore_notification *notification)
+{
+	struct mapistore_object_notification_parameters	*parameters;
+	struct emsmdbp_search_folder			*search_folder;
+	struct emsmdbp_search_folder			*next;
+	enum MAPISTATUS					retval;
+
+	if (!emsmdbp_ctx || !notification) return;
+	if (notification->object_type != MAPISTORE_MESSAGE) return;
+
+	emsmdbp_search_load(emsmdbp_ctx);
+
+	parameters = &notification->parameters.object_parameters;
+	for (search_folder = emsmdbp_ctx->search_folders; search_folder; search_folder = next) {
+		next = search_folder->next;
+		if (!(search_folder->state & SEARCH_RUNNING)) continue;
+
+		switch (notification->event) {
+		case MAPISTORE_OBJECT_CREATED:
+		case MAPISTORE_OBJECT_MODIFIED:
+		case MAPISTORE_OBJECT_COPIED:
+		case MAPISTORE_OBJECT_NEWMAIL:
+			retval = emsmdbp_search_update(emsmdbp_ctx, search_folder, parameters->folder_id, parameters->object_id);
+			break;
+		case MAPISTORE_OBJECT_DELETED:
+			retval = openchangedb_search_del_match(emsmdbp_ctx->oc_ctx, search_folder->folderID,
+							       parameters->folder_id, parameters->object_id);
+			break;
+		case MAPISTORE_OBJECT_MOVED:
+			retval = openchangedb_search_del_match(emsmdbp_ctx->oc_ctx, search_folder->folderID,
+							       parameters->old_folder_id, parameters->old_object_id);
+			if (retval == MAPI_E_SUCCESS) {
+				retval = emsmdbp_search_update(emsmdbp_ctx, search_folder, parameters->folder_id, parameters->object_id);
+			}
+			break;
+		default:
+			retval = MAPI_E_SUCCESS;
+			break;
+		}
+
+		if (retval == MAPI_E_NOT_FOUND) {
+			emsmdbp_search_drop(emsmdbp_ctx, search_folder);
+		}
+	}
+}
+
+
+static void emsmdbp_search_table_build_view(struct emsmdbp_search_table *search)
+{
+	uint32_t	i;
+
+	search->view_count = 0;
+	for (i = 0; i < search->row_count; i++) {
+		if (search->rows[i]->match) {
+			search->view[search->view_count++] = search->rows[i];
+		}
+	}
+}
+
+
+/**
+   \details Initialize the contents table of a search folder from its
+   match index
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param fid the search folder identifier
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_INITIALIZED if the
+   folder is not a search folder, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_table_init(struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_object *table_object,
+						   uint64_t fid)
+{
+	struct emsmdbp_search_table	*search;
+	struct emsmdbp_search_row	*row;
+	enum MAPISTATUS			retval;
+	uint64_t			*fids;
+	uint64_t			*mids;
+	uint32_t			count;
+	uint32_t			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || table_object->type != EMSMDBP_OBJECT_TABLE, MAPI_E_INVALID_PARAMETER, NULL);
+
+	search = talloc_zero(table_object->object.table, struct emsmdbp_search_table);
+	OPENCHANGE_RETVAL_IF(!search, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	retval = openchangedb_get_search_matches(search, emsmdbp_ctx->oc_ctx, fid, &count, &fids, &mids);
+	OPENCHANGE_RETVAL_IF(retval, retval, search);
+
+	search->rows = talloc_array(search, struct emsmdbp_search_row *, count + 1);
+	search->view = talloc_array(search, struct emsmdbp_search_row *, count + 1);
+	OPENCHANGE_RETVAL_IF(!search->rows || !search->view, MAPI_E_NOT_ENOUGH_MEMORY, search);
+	for (i = 0; i < count; i++) {
+		row = talloc_zero(search->rows, struct emsmdbp_search_row);
+		OPENCHANGE_RETVAL_IF(!row, MAPI_E_NOT_ENOUGH_MEMORY, search);
+		row->folderID = fids[i];
+		row->messageID = mids[i];
+		row->index = i;
+		row->match = true;
+		search->rows[i] = row;
+	}
+	search->row_count = count;
+	emsmdbp_search_table_build_view(search);
+	talloc_free(fids);
+	talloc_free(mids);
+
+	table_object->object.table->search = search;
+	table_object->object.table->denominator = search->view_count;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the properties of a search folder contents table
+   row
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param row_id the row position
+   \param retvalsp pointer on pointer to the property errors to return
+
+   \return Allocated data pointers on success, otherwise NULL
+ */
+_PUBLIC_ void **emsmdbp_search_table_get_row_props(TALLOC_CTX *mem_ctx,
+						   struct emsmdbp_context *emsmdbp_ctx,
+						   struct emsmdbp_object *table_object,
+						   uint32_t row_id,
+						   enum MAPISTATUS **retvalsp)
+{
+	struct emsmdbp_object_table	*table;
+	struct emsmdbp_search_row	*row;
+	struct emsmdbp_search_values	values;
+	struct SPropTagArray		columns;
+
+	table = table_object->object.table;
+	if (!table->search || row_id >= table->search->view_count) {
+		return NULL;
+	}
+	row = table->search->view[row_id];
+
+	columns.cValues = table->prop_count;
+	columns.aulPropTag = table->properties;
+	values.columns = &columns;
+	if (!emsmdbp_search_fetch(mem_ctx, emsmdbp_ctx, table_object->parent_object, row->folderID, row->messageID, &values)) {
+		DEBUG(5, ("[%s:%d]: message 0x%.16"PRIx64" no longer exists\n", __FUNCTION__, __LINE__, row->messageID));
+		return NULL;
+	}
+
+	if (retvalsp) {
+		*retvalsp = values.retvals;
+	}
+
+	return values.data_pointers;
+}
+
+
+static void emsmdbp_search_copy_value(TALLOC_CTX *mem_ctx, struct openchangedb_table_value *value)
+{
+	switch (value->type) {
+	case PT_STRING8:
+	case PT_UNICODE:
+		value->value.str = talloc_strdup(mem_ctx, value->value.str);
+		break;
+	case PT_BINARY:
+		value->value.bin.data = talloc_memdup(mem_ctx, value->value.bin.data, value->value.bin.length);
+		break;
+	}
+}
+
+
+static int emsmdbp_search_row_cmp(const void *p1, const void *p2)
+{
+	struct emsmdbp_search_row	*row1 = *(struct emsmdbp_search_row **)p1;
+	struct emsmdbp_search_row	*row2 = *(struct emsmdbp_search_row **)p2;
+	uint32_t			i;
+	int				result;
+
+	for (i = 0; row1->sort && i < row1->sort->cSorts; i++) {
+		result = openchangedb_table_compare_keys(&row1->keys[i], &row2->keys[i]);
+		if (result) {
+			return (row1->sort->aSort[i].ulOrder & TABLE_SORT_DESCEND) ? -result : result;
+		}
+	}
+
+	return (row1->index > row2->index) - (row1->index < row2->index);
+}
+
+
+/**
+   \details Sort the contents table of a search folder
+
+   Sort keys are read from each message of the table.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param lpSortCriteria pointer to the sort order
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_table_set_sort_order(struct emsmdbp_context *emsmdbp_ctx,
+							     struct emsmdbp_object *table_object,
+							     struct SSortOrderSet *lpSortCriteria)
+{
+	TALLOC_CTX			*mem_ctx;
+	TALLOC_CTX			*row_ctx;
+	struct emsmdbp_search_table	*search;
+	struct emsmdbp_search_row	*row;
+	struct emsmdbp_search_values	values;
+	struct SPropTagArray		*columns;
+	uint32_t			i;
+	uint16_t			j;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || !table_object->object.table->search, MAPI_E_INVALID_PARAMETER, NULL);
+
+	search = table_object->object.table->search;
+	if (!lpSortCriteria || !lpSortCriteria->cSorts) {
+		for (i = 0; i < search->row_count; i++) {
+			search->rows[i]->sort = NULL;
+		}
+	}
+	else {
+		mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_table_set_sort_order");
+		columns = talloc_zero(mem_ctx, struct SPropTagArray);
+		columns->cValues = lpSortCriteria->cSorts;
+		columns->aulPropTag = talloc_array(columns, enum MAPITAGS, lpSortCriteria->cSorts);
+		for (j = 0; j < lpSortCriteria->cSorts; j++) {
+			columns->aulPropTag[j] = lpSortCriteria->aSort[j].ulPropTag;
+		}
+		values.columns = columns;
+
+		row_ctx = talloc_new(mem_ctx);
+		for (i = 0; i < search->row_count; i++) {
+			row = search->rows[i];
+			talloc_free(row->keys);
+			row->sort = lpSortCriteria;
+			row->keys = talloc_zero_array(row, struct openchangedb_table_value, lpSortCriteria->cSorts);
+			OPENCHANGE_RETVAL_IF(!row->keys, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+			if (!emsmdbp_search_fetch(row_ctx, emsmdbp_ctx, table_object->parent_object, row->folderID, row->messageID, &values)) {
+				continue;
+			}
+			for (j = 0; j < lpSortCriteria->cSorts; j++) {
+				emsmdbp_search_get_value(row_ctx, &values, columns->aulPropTag[j], &row->keys[j]);
+				emsmdbp_search_copy_value(row->keys, &row->keys[j]);
+			}
+			talloc_free_children(row_ctx);
+		}
+		talloc_free(mem_ctx);
+	}
+
+	qsort(search->rows, search->row_count, sizeof (struct emsmdbp_search_row *), emsmdbp_search_row_cmp);
+	for (i = 0; i < search->row_count; i++) {
+		search->rows[i]->sort = NULL;
+	}
+	emsmdbp_search_table_build_view(search);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Restrict the contents table of a search folder
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param res pointer to the restriction, NULL to remove it
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_table_set_restrictions(struct emsmdbp_context *emsmdbp_ctx,
+							       struct emsmdbp_object *table_object,
+							       struct mapi_SRestriction *res)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_search_table	*search;
+	struct emsmdbp_search_row	*row;
+	struct SPropTagArray		*columns = NULL;
+	uint32_t			i;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || !table_object->object.table->search, MAPI_E_INVALID_PARAMETER, NULL);
+
+	search = table_object->object.table->search;
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_table_set_restrictions");
+	if (res) {
+		columns = emsmdbp_search_get_columns(mem_ctx, res);
+		OPENCHANGE_RETVAL_IF(!columns, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+	}
+	for (i = 0; i < search->row_count; i++) {
+		row = search->rows[i];
+		row->match = res ? emsmdbp_search_match(emsmdbp_ctx, table_object->parent_object, row->folderID, row->messageID, res, columns) : true;
+	}
+	talloc_free(mem_ctx);
+
+	emsmdbp_search_table_build_view(search);
+	table_object->object.table->denominator = search->view_count;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Find the next row of a search folder contents table
+   matching a restriction
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param table_object pointer to the table object
+   \param res pointer to the restriction rows must match
+   \param flags the search direction (DIR_FORWARD or DIR_BACKWARD)
+   \param start the position of the first row to examine
+   \param pos pointer to the position of the matching row to return
+
+   \return MAPI_E_SUCCESS on success, MAPI_E_NOT_FOUND if no row
+   matches, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS emsmdbp_search_table_find_row(struct emsmdbp_context *emsmdbp_ctx,
+						       struct emsmdbp_object *table_object,
+						       struct mapi_SRestriction *res,
+						       enum FindRow_ulFlags flags,
+						       uint32_t start,
+						       uint32_t *pos)
+{
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_search_table	*search;
+	struct emsmdbp_search_row	*row;
+	struct SPropTagArray		*columns;
+	uint32_t			i;
+	bool				found;
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!table_object || !table_object->object.table->search, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!res || !pos, MAPI_E_INVALID_PARAMETER, NULL);
+
+	search = table_object->object.table->search;
+	OPENCHANGE_RETVAL_IF(start >= search->view_count, MAPI_E_NOT_FOUND, NULL);
+
+	mem_ctx = talloc_named(NULL, 0, "emsmdbp_search_table_find_row");
+	columns = emsmdbp_search_get_columns(mem_ctx, res);
+	OPENCHANGE_RETVAL_IF(!columns, MAPI_E_NOT_ENOUGH_MEMORY, mem_ctx);
+
+	i = start;
+	for (;;) {
+		row = search->view[i];
+		found = emsmdbp_search_match(emsmdbp_ctx, table_object->parent_object, row->folderID, row->messageID, res, columns);
+		if (found) break;
+
+		if (flags & DIR_BACKWARD) {
+			if (i == 0) break;
+			i--;
+		}
+		else {
+			if (i + 1 >= search->view_count) break;
+			i++;
+		}
+	}
+	talloc_free(mem_ctx);
+
+	OPENCHANGE_RETVAL_IF(!found, MAPI_E_NOT_FOUND, NULL);
+	*pos = i;
+
+	return MAPI_E_SUCCESS;
+}
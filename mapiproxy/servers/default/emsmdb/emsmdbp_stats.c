@@ -0,0 +1,307 @@
+/*
+   OpenChange Server implementation
+
+   EMSMDBP: EMSMDB Provider implementation
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+   \file emsmdbp_stats.c
+
+   \brief Per-ROP latency and throughput statistics
+
+   Statistics are stored in a file mapped in shared memory, one file
+   per server process, so updating counters costs no system call and
+   the openchange-stats tool can read them while the server runs. The
+   file is removed when the process exits.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include "mapiproxy/dcesrv_mapiproxy.h"
+#include "dcesrv_exchange_emsmdb.h"
+#include "emsmdbp_stats.h"
+
+static struct emsmdbp_stats_ctx {
+	bool			enabled;
+	char			*path;
+	char			*filename;
+	pid_t			pid;
+	bool			registered;
+	struct emsmdbp_stats	*stats;
+} stats_ctx = { false, NULL, NULL, 0, false, NULL };
+
+
+/**
+   \details Remove the statistics file of the current process
+
+   Registered with atexit() when the first file is created. Forked
+   processes inherit the handler, so only the process owning the file
+   removes it.
+ */
+static void emsmdbp_stats_cleanup(void)
+{
+	if (!stats_ctx.stats || stats_ctx.pid != getpid()) return;
+
+	munmap(stats_ctx.stats, sizeof (struct emsmdbp_stats));
+	stats_ctx.stats = NULL;
+	if (stats_ctx.filename) {
+		unlink(stats_ctx.filename);
+		talloc_free(stats_ctx.filename);
+		stats_ctx.filename = NULL;
+	}
+}
+
+
+/**
+   \details Initialize the statistics subsystem
+
+   Statistics are only collected when the dcerpc_mapiproxy:stats
+   parametric option is set to true. Files are stored in the directory
+   specified by dcerpc_mapiproxy:stats_dir, or in the emsmdb_stats
+   subdirectory of the private directory.
+
+   \param mem_ctx pointer to the memory context
+   \param lp_ctx pointer to the loadparm context
+ */
+void emsmdbp_stats_init(TALLOC_CTX *mem_ctx, struct loadparm_context *lp_ctx)
+{
+	const char	*path;
+
+	stats_ctx.enabled = lpcfg_parm_bool(lp_ctx, NULL, "dcerpc_mapiproxy", "stats", false);
+	mapistore_backend_set_timing(stats_ctx.enabled);
+	if (stats_ctx.enabled == false) return;
+
+	path = lpcfg_parm_string(lp_ctx, NULL, "dcerpc_mapiproxy", "stats_dir");
+	if (path) {
+		stats_ctx.path = talloc_strdup(mem_ctx, path);
+	} else {
+		stats_ctx.path = talloc_asprintf(mem_ctx, "%s/%s", lpcfg_private_dir(lp_ctx), EMSMDBP_STATS_DIRNAME);
+	}
+	mkdir(stats_ctx.path, 0700);
+
+	DEBUG(3, ("[%s:%d]: ROP statistics stored in %s\n", __FUNCTION__, __LINE__, stats_ctx.path));
+}
+
+
+/**
+   \details Retrieve the statistics area of the current process
+
+   The area is mapped lazily: the server may fork after
+   initialization and each process must use its own file.
+
+   \return pointer to the statistics area on success, otherwise NULL
+ */
+static struct emsmdbp_stats *emsmdbp_stats_get(void)
+{
+	struct emsmdbp_stats	*stats;
+	char			*filename;
+	pid_t			pid;
+	int			fd;
+
+	if (stats_ctx.enabled == false) return NULL;
+
+	pid = getpid();
+	if (stats_ctx.stats && stats_ctx.pid == pid) {
+		return stats_ctx.stats;
+	}
+
+	/* Do not update nor remove the parent process area after fork */
+	stats_ctx.stats = NULL;
+	stats_ctx.pid = pid;
+	stats_ctx.filename = NULL;
+
+	filename = talloc_asprintf(NULL, "%s/%d%s", stats_ctx.path, pid, EMSMDBP_STATS_SUFFIX);
+	if (!filename) return NULL;
+
+	fd = open(filename, O_RDWR|O_CREAT|O_TRUNC, 0600);
+	if (fd == -1) {
+		DEBUG(0, ("[%s:%d]: unable to open %s\n", __FUNCTION__, __LINE__, filename));
+		talloc_free(filename);
+		stats_ctx.enabled = false;
+		return NULL;
+	}
+
+	if (ftruncate(fd, sizeof (struct emsmdbp_stats)) == -1) {
+		DEBUG(0, ("[%s:%d]: unable to resize %s\n", __FUNCTION__, __LINE__, filename));
+		close(fd);
+		unlink(filename);
+		talloc_free(filename);
+		stats_ctx.enabled = false;
+		return NULL;
+	}
+
+	stats = mmap(NULL, sizeof (struct emsmdbp_stats), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (stats == MAP_FAILED) {
+		DEBUG(0, ("[%s:%d]: unable to map %s\n", __FUNCTION__, __LINE__, filename));
+		unlink(filename);
+		talloc_free(filename);
+		stats_ctx.enabled = false;
+		return NULL;
+	}
+
+	stats->magic = EMSMDBP_STATS_MAGIC;
+	stats->version = EMSMDBP_STATS_VERSION;
+	stats->pid = pid;
+	stats->start_time = time(NULL);
+
+	stats_ctx.stats = stats;
+	stats_ctx.filename = filename;
+	if (stats_ctx.registered == false) {
+		atexit(emsmdbp_stats_cleanup);
+		stats_ctx.registered = true;
+	}
+
+	return stats;
+}
+
+
+/**
+   \details Return a monotonic timestamp used to measure latencies
+
+   \return timestamp in microseconds
+ */
+uint64_t emsmdbp_stats_now(void)
+{
+	struct timespec	ts;
+
+	if (stats_ctx.enabled == false) return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+   \details Return the histogram bucket for a given latency
+
+   \param usec latency in microseconds
+
+   \return the bucket index
+ */
+static uint32_t emsmdbp_stats_bucket(uint64_t usec)
+{
+	uint32_t	bucket;
+
+	for (bucket = 0; usec > 1 && bucket < EMSMDBP_STATS_BUCKETS - 1; bucket++) {
+		usec >>= 1;
+	}
+
+	return bucket;
+}
+
+
+/**
+   \details Record the completion of a ROP
+
+   \param opnum the ROP opnum
+   \param retval the ROP return value
+   \param usec time spent processing the ROP in microseconds
+   \param backend_usec time spent in mapistore backends while
+   processing the ROP in microseconds
+   \param response_bytes size of the ROP response
+ */
+void emsmdbp_stats_rop(uint8_t opnum, enum MAPISTATUS retval, uint64_t usec,
+		       uint64_t backend_usec, uint32_t response_bytes)
+{
+	struct emsmdbp_stats		*stats;
+	struct emsmdbp_stats_rop	*rop;
+
+	stats = emsmdbp_stats_get();
+	if (!stats) return;
+
+	rop = &stats->rops[opnum];
+	rop->calls++;
+	if (retval != MAPI_E_SUCCESS) {
+		rop->errors++;
+	}
+	rop->usec += usec;
+	if (usec > rop->usec_max) {
+		rop->usec_max = usec;
+	}
+	rop->backend_usec += backend_usec;
+	rop->response_bytes += response_bytes;
+	rop->histogram[emsmdbp_stats_bucket(usec)]++;
+}
+
+
+/**
+   \details Record the completion of an EcDoRpc transaction
+
+   \param request_bytes size of the ROP request buffer
+   \param response_bytes size of the ROP response buffer
+   \param usec time spent processing the transaction in microseconds
+   \param backend_usec time spent in mapistore backends while
+   processing the transaction in microseconds
+ */
+void emsmdbp_stats_transaction(uint32_t request_bytes, uint32_t response_bytes,
+			       uint64_t usec, uint64_t backend_usec)
+{
+	struct emsmdbp_stats	*stats;
+
+	stats = emsmdbp_stats_get();
+	if (!stats) return;
+
+	stats->transactions++;
+	stats->request_bytes += request_bytes;
+	stats->response_bytes += response_bytes;
+	stats->transaction_usec += usec;
+	stats->backend_usec += backend_usec;
+}
+
+
+/**
+   \details Record time spent marshalling or unmarshalling ROP buffers
+
+   \param usec time spent in NDR in microseconds
+ */
+void emsmdbp_stats_ndr(uint64_t usec)
+{
+	struct emsmdbp_stats	*stats;
+
+	stats = emsmdbp_stats_get();
+	if (!stats) return;
+
+	stats->ndr_usec += usec;
+}
+
+
+/**
+   \details Record an EcDoRpc call and the number of ROP buffers
+   returned in its response
+
+   \param buffers number of ROP buffers packed in the response
+ */
+void emsmdbp_stats_rpc(uint32_t buffers)
+{
+	struct emsmdbp_stats	*stats;
+
+	stats = emsmdbp_stats_get();
+	if (!stats) return;
+
+	stats->rpcs++;
+	if (buffers > 1) {
+		stats->chained_buffers += buffers - 1;
+	}
+}
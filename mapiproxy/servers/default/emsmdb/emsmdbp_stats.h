@@ -0,0 +1,72 @@
+/*
+   OpenChange Server implementation
+
+   EMSMDBP: EMSMDB Provider implementation
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef	__EMSMDBP_STATS_H
+#define	__EMSMDBP_STATS_H
+
+#include <stdint.h>
+
+/**
+   Layout of the per-process statistics file. Each emsmdb server
+   process maps its own file in shared memory and updates counters in
+   place: readers such as openchange-stats only need to map the files
+   found in the statistics directory.
+ */
+
+#define	EMSMDBP_STATS_MAGIC		0x5453434F /* "OCST" */
+#define	EMSMDBP_STATS_VERSION		2
+#define	EMSMDBP_STATS_DIRNAME		"emsmdb_stats"
+#define	EMSMDBP_STATS_SUFFIX		".stats"
+
+/* Number of ROP opnums tracked */
+#define	EMSMDBP_STATS_ROPS		256
+
+/* Latency histogram: bucket n holds calls in [2^n, 2^(n+1)[ usec */
+#define	EMSMDBP_STATS_BUCKETS		32
+
+struct emsmdbp_stats_rop {
+	uint64_t	calls;
+	uint64_t	errors;
+	uint64_t	usec;
+	uint64_t	usec_max;
+	uint64_t	backend_usec;
+	uint64_t	response_bytes;
+	uint64_t	histogram[EMSMDBP_STATS_BUCKETS];
+};
+
+struct emsmdbp_stats {
+	uint32_t			magic;
+	uint32_t			version;
+	uint32_t			pid;
+	uint32_t			reserved;
+	uint64_t			start_time;
+	uint64_t			transactions;
+	uint64_t			request_bytes;
+	uint64_t			response_bytes;
+	uint64_t			transaction_usec;
+	uint64_t			backend_usec;
+	uint64_t			ndr_usec;
+	uint64_t			rpcs;
+	uint64_t			chained_buffers;
+	struct emsmdbp_stats_rop	rops[EMSMDBP_STATS_ROPS];
+};
+
+#endif /* !__EMSMDBP_STATS_H */
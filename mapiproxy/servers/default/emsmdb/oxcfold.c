@@ -29,6 +29,7 @@
 #include "mapiproxy/libmapiproxy/libmapiproxy.h"
 #include "mapiproxy/libmapiserver/libmapiserver.h"
 #include "dcesrv_exchange_emsmdb.h"
+#include "gen_ndr/ndr_exchange.h"
 
 
 /**
@@ -216,7 +217,6 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetHierarchyTable(TALLOC_CTX *mem_ctx,
 	else {
 		/* we attach the subscription to the session object */
 		subscription_list = talloc_zero(emsmdbp_ctx->mstore_ctx, struct mapistore_subscription_list);
-		DLIST_ADD(emsmdbp_ctx->mstore_ctx->subscriptions, subscription_list);
 
 		subscription_parameters.table_type = MAPISTORE_FOLDER_TABLE;
 		subscription_parameters.folder_id = folderID;
@@ -226,7 +226,12 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetHierarchyTable(TALLOC_CTX *mem_ctx,
 							  emsmdbp_ctx->username,
 							  rec->handle, fnevTableModified, &subscription_parameters);
 		subscription_list->subscription = subscription;
-		object->object.table->subscription_list = subscription_list;
+		if (mapistore_add_subscription(emsmdbp_ctx->mstore_ctx, subscription_list) == MAPISTORE_SUCCESS) {
+			object->object.table->subscription_list = subscription_list;
+		}
+		else {
+			talloc_free(subscription_list);
+		}
 	}
 
 end:
@@ -341,7 +346,6 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetContentsTable(TALLOC_CTX *mem_ctx,
 	else {
 		/* we attach the subscription to the session object */
 		subscription_list = talloc_zero(emsmdbp_ctx->mstore_ctx, struct mapistore_subscription_list);
-		DLIST_ADD(emsmdbp_ctx->mstore_ctx->subscriptions, subscription_list);
 		
 		if ((mapi_req->u.mapi_GetContentsTable.TableFlags & TableFlags_Associated)) {
 			subscription_parameters.table_type = MAPISTORE_FAI_TABLE;
@@ -356,7 +360,12 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetContentsTable(TALLOC_CTX *mem_ctx,
 							  emsmdbp_ctx->username,
 							  rec->handle, fnevTableModified, &subscription_parameters);
 		subscription_list->subscription = subscription;
-		object->object.table->subscription_list = subscription_list;
+		if (mapistore_add_subscription(emsmdbp_ctx->mstore_ctx, subscription_list) == MAPISTORE_SUCCESS) {
+			object->object.table->subscription_list = subscription_list;
+		}
+		else {
+			talloc_free(subscription_list);
+		}
         }
 
 end:
@@ -608,6 +617,56 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopDeleteFolder(TALLOC_CTX *mem_ctx,
 }
 
 
+/**
+   \details Delete a set of messages from a mapistore folder and remove
+   them from the indexing database
+
+   The backend is called once for the whole set and the indexing
+   records are updated within a single transaction.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param folder_object pointer to the folder object
+   \param count the number of messages to delete
+   \param mids the message identifiers to delete
+   \param flags MAPISTORE_SOFT_DELETE or MAPISTORE_PERMANENT_DELETE
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfold_delete_messages(struct emsmdbp_context *emsmdbp_ctx,
+					       struct emsmdbp_object *folder_object,
+					       uint32_t count, const uint64_t *mids,
+					       uint8_t flags)
+{
+	enum mapistore_error	ret;
+	uint32_t		contextID;
+	char			*owner;
+
+	if (!count) {
+		return MAPI_E_SUCCESS;
+	}
+
+	DEBUG(5, ("exchange_emsmdb: [OXCFOLD] deleting %u messages (flags = 0x%x)\n", count, flags));
+
+	contextID = emsmdbp_get_contextID(folder_object);
+	ret = mapistore_folder_delete_messages(emsmdbp_ctx->mstore_ctx, contextID, folder_object->backend_object,
+					       count, mids, flags);
+	if (ret != MAPISTORE_SUCCESS && ret != MAPISTORE_ERR_NOT_FOUND) {
+		if (ret == MAPISTORE_ERR_DENIED) {
+			return MAPI_E_NO_ACCESS;
+		}
+		return MAPI_E_CALL_FAILED;
+	}
+
+	owner = emsmdbp_get_owner(folder_object);
+	ret = mapistore_indexing_record_del_mids(emsmdbp_ctx->mstore_ctx, contextID, owner, count, mids, flags);
+	if (ret != MAPISTORE_SUCCESS) {
+		return MAPI_E_CALL_FAILED;
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
 /**
    \details EcDoRpc DeleteMessage (0x1e) Rop. This operation (soft) deletes
    a message on the server.
@@ -633,10 +692,7 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopDeleteMessages(TALLOC_CTX *mem_ctx,
 	struct mapi_handles	*parent_folder = NULL;
 	void			*parent_folder_private_data;
 	struct emsmdbp_object	*parent_object;
-	char			*owner;
 	enum MAPISTATUS		retval;
-	uint32_t		contextID;
-	int 			i;
 
 	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] DeleteMessage (0x1e)\n"));
 
@@ -671,29 +727,10 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopDeleteMessages(TALLOC_CTX *mem_ctx,
 		goto delete_message_response;
 	}
 
-	contextID = emsmdbp_get_contextID(parent_object);
-	owner = emsmdbp_get_owner(parent_object);
-	for (i = 0; i < mapi_req->u.mapi_DeleteMessages.cn_ids; ++i) {
-		int ret;
-		uint64_t mid = mapi_req->u.mapi_DeleteMessages.message_ids[i];
-		DEBUG(0, ("MID %i to delete: 0x%.16"PRIx64"\n", i, mid));
-		ret = mapistore_folder_delete_message(emsmdbp_ctx->mstore_ctx, contextID, parent_object->backend_object, mid, MAPISTORE_SOFT_DELETE);
-		if (ret != MAPISTORE_SUCCESS && ret != MAPISTORE_ERR_NOT_FOUND) {
-			if (ret == MAPISTORE_ERR_DENIED) {
-				mapi_repl->error_code = MAPI_E_NO_ACCESS;
-			}
-			else {
-				mapi_repl->error_code = MAPI_E_CALL_FAILED;
-			}
-			goto delete_message_response;
-		}
-
-		ret = mapistore_indexing_record_del_mid(emsmdbp_ctx->mstore_ctx, contextID, owner, mid, MAPISTORE_SOFT_DELETE);
-		if (ret != MAPISTORE_SUCCESS) {
-			mapi_repl->error_code = MAPI_E_CALL_FAILED;
-			goto delete_message_response;
-		}
-	}
+	mapi_repl->error_code = oxcfold_delete_messages(emsmdbp_ctx, parent_object,
+							mapi_req->u.mapi_DeleteMessages.cn_ids,
+							mapi_req->u.mapi_DeleteMessages.message_ids,
+							MAPISTORE_SOFT_DELETE);
 
 delete_message_response:
 	*size += libmapiserver_RopDeleteMessage_size(mapi_repl);
@@ -723,6 +760,13 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopSetSearchCriteria(TALLOC_CTX *mem_ctx,
 						      struct EcDoRpc_MAPI_REPL *mapi_repl,
 						      uint32_t *handles, uint16_t *size)
 {
+	struct SetSearchCriteria_req	*request;
+	struct mapi_handles		*rec = NULL;
+	struct emsmdbp_object		*folder_object;
+	enum MAPISTATUS			retval;
+	uint32_t			handle;
+	void				*data = NULL;
+
 	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] SetSearchCriteria (0x30)\n"));
 
 	/* Sanity checks */
@@ -736,8 +780,30 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopSetSearchCriteria(TALLOC_CTX *mem_ctx,
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->error_code = MAPI_E_SUCCESS;
 
-	/* TODO: actually implement this */
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
 
+	mapi_handles_get_private_data(rec, &data);
+	folder_object = (struct emsmdbp_object *)data;
+	if (!folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER || emsmdbp_is_mapistore(folder_object)) {
+		DEBUG(5, ("  object is not a search folder\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	request = &mapi_req->u.mapi_SetSearchCriteria;
+	retval = emsmdbp_search_set_criteria(emsmdbp_ctx, folder_object->object.folder->folderID, &request->res,
+					     request->FolderIdCount, request->FolderIds, request->SearchFlags);
+	if (retval) {
+		mapi_repl->error_code = retval;
+	}
+
+end:
 	*size += libmapiserver_RopSetSearchCriteria_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
@@ -765,7 +831,19 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetSearchCriteria(TALLOC_CTX *mem_ctx,
 						      struct EcDoRpc_MAPI_REPL *mapi_repl,
 						      uint32_t *handles, uint16_t *size)
 {
-	/* struct mapi_SRestriction *res; */
+	struct GetSearchCriteria_req	*request;
+	struct GetSearchCriteria_repl	*response;
+	struct mapi_handles		*rec = NULL;
+	struct emsmdbp_object		*folder_object;
+	struct mapi_SRestriction	*res = NULL;
+	enum MAPISTATUS			retval;
+	enum ndr_err_code		ndr_err;
+	DATA_BLOB			blob;
+	uint32_t			handle;
+	uint32_t			state = 0;
+	uint64_t			*fids = NULL;
+	uint16_t			count = 0;
+	void				*data = NULL;
 
 	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] GetSearchCriteria (0x31)\n"));
 
@@ -780,82 +858,129 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetSearchCriteria(TALLOC_CTX *mem_ctx,
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->error_code = MAPI_E_SUCCESS;
 
-	/* res = NULL; */
-	mapi_repl->u.mapi_GetSearchCriteria.RestrictionDataSize = 0;
-	mapi_repl->u.mapi_GetSearchCriteria.LogonId = mapi_req->logon_id;
-	mapi_repl->u.mapi_GetSearchCriteria.FolderIdCount = 0;
-	mapi_repl->u.mapi_GetSearchCriteria.FolderIds = NULL;
-	mapi_repl->u.mapi_GetSearchCriteria.SearchFlags = 0;
+	request = &mapi_req->u.mapi_GetSearchCriteria;
+	response = &mapi_repl->u.mapi_GetSearchCriteria;
+	response->RestrictionDataSize = 0;
+	response->LogonId = mapi_req->logon_id;
+	response->FolderIdCount = 0;
+	response->FolderIds = NULL;
+	response->SearchFlags = 0;
 
-	/* TODO: actually implement this */
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(rec, &data);
+	folder_object = (struct emsmdbp_object *)data;
+	if (!folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER || emsmdbp_is_mapistore(folder_object)) {
+		DEBUG(5, ("  object is not a search folder\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
 
+	retval = emsmdbp_search_get_criteria(mem_ctx, emsmdbp_ctx, folder_object->object.folder->folderID,
+					     &res, &count, &fids, &state);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+
+	if (request->IncludeRestriction) {
+		ndr_err = ndr_push_struct_blob(&blob, mem_ctx, res, (ndr_push_flags_fn_t)ndr_push_mapi_SRestriction);
+		if (NDR_ERR_CODE_IS_SUCCESS(ndr_err) && blob.length <= 0xFFFF) {
+			response->RestrictionDataSize = blob.length;
+			response->RestrictionData = *res;
+		}
+	}
+	if (request->IncludeFolders) {
+		response->FolderIdCount = count;
+		response->FolderIds = fids;
+	}
+	response->SearchFlags = state;
+
+end:
 	*size += libmapiserver_RopGetSearchCriteria_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
 }
 
-static enum MAPISTATUS RopEmptyFolder_GenericFolder(TALLOC_CTX *mem_ctx,
-                                                    struct emsmdbp_context *emsmdbp_ctx,
-                                                    struct EmptyFolder_req request,
-                                                    struct EmptyFolder_repl *response,
-                                                    struct mapi_handles *folder)
-{
-	enum MAPISTATUS		ret = MAPI_E_SUCCESS;
-	void                    *folder_priv;
-	struct emsmdbp_object   *folder_object = NULL;
-	uint32_t                context_id;
-	enum mapistore_error	retval;
-	uint64_t		*childFolders;
-	uint32_t		childFolderCount;
-	uint32_t		i;
-	uint8_t			flags = DELETE_HARD_DELETE| DEL_MESSAGES | DEL_FOLDERS;
-	TALLOC_CTX		*local_mem_ctx;
-	void			*subfolder;
+/**
+   \details Remove the messages and subfolders of a folder
 
-	/* Step 1. Retrieve the fid for the folder, given the handle */
-	mapi_handles_get_private_data(folder, &folder_priv);
-	folder_object = (struct emsmdbp_object *) folder_priv;
-	if (!folder_object) {
-		DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder null object"));
-		return MAPI_E_NO_SUPPORT;
-	}
+   The content of mapistore folders is removed by the backend in a
+   single operation and the matching indexing records are dropped in
+   a single transaction. The content of openchangedb folders is
+   removed in a single LDB transaction, after which the backend
+   content of every mapistore root that was part of it is purged.
 
-	if (folder_object->type != EMSMDBP_OBJECT_FOLDER) {
-		DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder wrong object type: 0x%x\n", folder_object->type));
-		return MAPI_E_NO_SUPPORT;
-	}
-	context_id = emsmdbp_get_contextID(folder_object);
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param folder_object pointer to the folder object to empty
+   \param delete_associated whether FAI messages must be deleted
+   \param flags MAPISTORE_SOFT_DELETE or MAPISTORE_PERMANENT_DELETE
+   \param partial pointer to the partial completion flag to set when
+   some mapistore roots could not be purged
 
-	local_mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfold_empty_folder(struct emsmdbp_context *emsmdbp_ctx,
+					    struct emsmdbp_object *folder_object,
+					    bool delete_associated, uint8_t flags,
+					    bool *partial)
+{
+	enum MAPISTATUS		retval;
+	enum mapistore_error	ret;
+	TALLOC_CTX		*local_mem_ctx;
+	struct UI8Array_r	*fmids = NULL;
+	struct StringArrayW_r	*uris = NULL;
+	uint32_t		contextID;
+	uint32_t		i;
+	uint8_t			folder_flags;
 
-	retval = mapistore_folder_get_child_fmids(emsmdbp_ctx->mstore_ctx, context_id, folder_object->backend_object, MAPISTORE_FOLDER_TABLE, local_mem_ctx,
-						  &childFolders, &childFolderCount);
-	if (retval) {
-		DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder bad retval: 0x%x", retval));
-		ret = MAPI_E_NOT_FOUND;
-		goto end;
+	local_mem_ctx = talloc_new(NULL);
+	OPENCHANGE_RETVAL_IF(!local_mem_ctx, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	folder_flags = DEL_MESSAGES | DEL_FOLDERS;
+	if (flags == MAPISTORE_PERMANENT_DELETE) {
+		folder_flags |= DELETE_HARD_DELETE;
 	}
 
-	/* Step 3. Delete contents of the folder in mapistore */
-	for (i = 0; i < childFolderCount; ++i) {
-		retval = mapistore_folder_open_folder(emsmdbp_ctx->mstore_ctx, context_id, folder, local_mem_ctx, childFolders[i], &subfolder);
-		if (retval != MAPISTORE_SUCCESS) {
-			ret = MAPI_E_NOT_FOUND;
-			goto end;
+	if (emsmdbp_is_mapistore(folder_object)) {
+		contextID = emsmdbp_get_contextID(folder_object);
+		ret = mapistore_folder_empty(emsmdbp_ctx->mstore_ctx, contextID, folder_object->backend_object,
+					     local_mem_ctx, delete_associated, flags, &fmids);
+		if (fmids && fmids->cValues) {
+			mapistore_indexing_record_del_fmids(emsmdbp_ctx->mstore_ctx, contextID,
+							    emsmdbp_get_owner(folder_object),
+							    fmids->cValues, fmids->lpui8, flags);
 		}
-
-		retval = mapistore_folder_delete(emsmdbp_ctx->mstore_ctx, context_id, subfolder, flags);
-		if (retval) {
-			  DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder failed to delete fid 0x%.16"PRIx64" (0x%x)", childFolders[i], retval));
-			  ret = MAPI_E_NOT_FOUND;
-			  goto end;
+		if (ret != MAPISTORE_SUCCESS) {
+			DEBUG(4, ("exchange_emsmdb: [OXCFOLD] unable to empty folder 0x%.16"PRIx64" (0x%x)\n",
+				  folder_object->object.folder->folderID, ret));
+			talloc_free(local_mem_ctx);
+			return mapistore_error_to_mapi(ret);
+		}
+	} else {
+		retval = openchangedb_empty_folder(local_mem_ctx, emsmdbp_ctx->oc_ctx, folder_object->object.folder->folderID,
+						   delete_associated, &fmids, &uris);
+		OPENCHANGE_RETVAL_IF(retval, retval, local_mem_ctx);
+
+		for (i = 0; i < uris->cValues; i++) {
+			ret = emsmdbp_folder_delete_mapistore_root(emsmdbp_ctx, fmids->lpui8[i], uris->lppszW[i], folder_flags);
+			if (ret != MAPISTORE_SUCCESS) {
+				DEBUG(4, ("exchange_emsmdb: [OXCFOLD] unable to purge mapistore root %s (0x%x)\n",
+					  uris->lppszW[i], ret));
+				*partial = true;
+			}
 		}
 	}
 
-end:
 	talloc_free(local_mem_ctx);
 
-	return ret;
+	return MAPI_E_SUCCESS;
 }
 
 /**
@@ -882,8 +1007,8 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopEmptyFolder(TALLOC_CTX *mem_ctx,
 	enum MAPISTATUS                 retval;
 	struct mapi_handles             *folder = NULL;
         struct emsmdbp_object           *folder_object;
-        void                            *private_data;
-	bool                            mapistore = false;
+        void                            *private_data = NULL;
+	bool				partial = false;
 
 	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder (0x58)\n"));
 
@@ -895,6 +1020,7 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopEmptyFolder(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
 
 	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->u.mapi_EmptyFolder.PartialCompletion = 0;
 
@@ -903,39 +1029,131 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopEmptyFolder(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
 	mapi_handles_get_private_data(folder, &private_data);
         folder_object = private_data;
-
-	mapistore = emsmdbp_is_mapistore(folder_object);
-	switch (mapistore) {
-	case false:
-		/* system/special folder */
-		DEBUG(0, ("TODO Empty system/special folder\n"));
-#if 0
-                retval = RopEmptyFolder_SystemSpecialFolder(mem_ctx, emsmdbp_ctx,
-                                                           mapi_req->u.mapi_EmptyFolder,
-                                                           &mapi_repl->u.mapi_EmptyFolder);
-#endif
-		retval = MAPI_E_SUCCESS; // TODO: temporary hack.
-		mapi_repl->error_code = retval;
-		break;
-	case true:
-		/* handled by mapistore */
-		retval = RopEmptyFolder_GenericFolder(mem_ctx, emsmdbp_ctx,
-                                                      mapi_req->u.mapi_EmptyFolder,
-                                                      &mapi_repl->u.mapi_EmptyFolder,
-                                                      folder);
-		mapi_repl->error_code = retval;
-		break;
+	if (!folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER) {
+		DEBUG(4, ("exchange_emsmdb: [OXCFOLD] EmptyFolder wrong object type\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
 	}
 
+	/* Step 2. Remove the content of the folder, system folders included */
+	mapi_repl->error_code = oxcfold_empty_folder(emsmdbp_ctx, folder_object,
+						     mapi_req->u.mapi_EmptyFolder.WantDeleteAssociated,
+						     MAPISTORE_SOFT_DELETE, &partial);
+	mapi_repl->u.mapi_EmptyFolder.PartialCompletion = partial;
+
+end:
 	*size += libmapiserver_RopEmptyFolder_size(mapi_repl);
 
-	/* reply filled in above */
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details Copy or move a set of messages from a folder to another
+
+   The identifiers of the copies are allocated as a single batch. When
+   both folders live in the same mapistore context, the backend
+   processes the whole set in one call. Otherwise each message is
+   copied on the server from one store to the other and, for a move,
+   the source messages are then deleted as a set.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param source_object pointer to the source folder object
+   \param destination_object pointer to the destination folder object
+   \param count the number of messages to copy or move
+   \param mids the identifiers of the messages to copy or move
+   \param want_copy whether messages are copied rather than moved
+   \param partial pointer to the partial completion flag to set when
+   some messages could not be processed
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfold_move_copy_messages(struct emsmdbp_context *emsmdbp_ctx,
+						  struct emsmdbp_object *source_object,
+						  struct emsmdbp_object *destination_object,
+						  uint32_t count, uint64_t *mids,
+						  bool want_copy, bool *partial)
+{
+	enum MAPISTATUS		retval;
+	enum mapistore_error	ret;
+	TALLOC_CTX		*local_mem_ctx;
+	struct UI8Array_r	*targetMIDs = NULL;
+	uint64_t		*done_mids;
+	uint32_t		done_count = 0;
+	uint32_t		contextID;
+	uint32_t		i;
+
+	if (!count) {
+		return MAPI_E_SUCCESS;
+	}
+
+	local_mem_ctx = talloc_new(NULL);
+	OPENCHANGE_RETVAL_IF(!local_mem_ctx, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	/* Reserve the identifiers of the new messages in one go */
+	retval = openchangedb_get_new_folderIDs(emsmdbp_ctx->oc_ctx, local_mem_ctx, count, &targetMIDs);
+	OPENCHANGE_RETVAL_IF(retval, retval, local_mem_ctx);
+
+	contextID = emsmdbp_get_contextID(destination_object);
+	if (emsmdbp_is_mapistore(source_object) && emsmdbp_is_mapistore(destination_object)
+	    && emsmdbp_get_contextID(source_object) == contextID) {
+		ret = mapistore_folder_move_copy_messages(emsmdbp_ctx->mstore_ctx, contextID, destination_object->backend_object,
+							  source_object->backend_object, local_mem_ctx, count, mids,
+							  targetMIDs->lpui8, NULL, want_copy);
+		talloc_free(local_mem_ctx);
+		return mapistore_error_to_mapi(ret);
+	}
+
+	DEBUG(5, ("exchange_emsmdb: [OXCFOLD] %s %u messages across stores\n", want_copy ? "copying" : "moving", count));
+
+	done_mids = talloc_array(local_mem_ctx, uint64_t, count);
+	OPENCHANGE_RETVAL_IF(!done_mids, MAPI_E_NOT_ENOUGH_MEMORY, local_mem_ctx);
+
+	for (i = 0; i < count; i++) {
+		ret = emsmdbp_object_message_copy(emsmdbp_ctx, source_object, mids[i], destination_object, targetMIDs->lpui8[i]);
+		if (ret != MAPISTORE_SUCCESS) {
+			DEBUG(4, ("exchange_emsmdb: [OXCFOLD] unable to copy message 0x%.16"PRIx64" (0x%x)\n", mids[i], ret));
+			*partial = true;
+			continue;
+		}
+		done_mids[done_count] = mids[i];
+		done_count++;
+	}
+
+	/* Only the messages which were successfully copied are removed */
+	if (!want_copy && done_count) {
+		if (emsmdbp_is_mapistore(source_object)) {
+			retval = oxcfold_delete_messages(emsmdbp_ctx, source_object, done_count, done_mids,
+							 MAPISTORE_PERMANENT_DELETE);
+		}
+		else {
+			retval = openchangedb_delete_messages(emsmdbp_ctx->oc_ctx, source_object->object.folder->folderID,
+							      done_count, done_mids);
+		}
+		if (retval) {
+			DEBUG(4, ("exchange_emsmdb: [OXCFOLD] unable to remove moved messages (0x%x)\n", retval));
+			*partial = true;
+		}
+	}
+
+	talloc_free(local_mem_ctx);
 
 	return MAPI_E_SUCCESS;
 }
 
 /**
+   \details EcDoRpc MoveCopyMessages (0x33) Rop. This operation moves
+   or copies messages from a source folder to a destination folder.
 
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the MoveCopyMessages EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the MoveCopyMessages EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
 _PUBLIC_ enum MAPISTATUS EcDoRpc_RopMoveCopyMessages(TALLOC_CTX *mem_ctx,
 						     struct emsmdbp_context *emsmdbp_ctx,
@@ -945,14 +1163,11 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopMoveCopyMessages(TALLOC_CTX *mem_ctx,
 {
 	enum MAPISTATUS		retval;
 	uint32_t		handle;
-	uint32_t                contextID;
 	struct mapi_handles	*rec = NULL;
 	void			*private_data = NULL;
 	struct emsmdbp_object	*destination_object;
 	struct emsmdbp_object   *source_object;
-	uint64_t                *targetMIDs;
-        uint32_t                i;
-	bool			mapistore = false;
+	bool			partial = false;
 
 	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] RopMoveCopyMessages (0x33)\n"));
 
@@ -982,7 +1197,7 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopMoveCopyMessages(TALLOC_CTX *mem_ctx,
 
 	/* object is our destination folder */
         destination_object = private_data;
-	if (!destination_object) {
+	if (!destination_object || destination_object->type != EMSMDBP_OBJECT_FOLDER) {
 		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
 		DEBUG(5, ("  object (%x) not found: %x\n", handle, mapi_req->handle_idx));
 		goto end;
@@ -999,32 +1214,17 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopMoveCopyMessages(TALLOC_CTX *mem_ctx,
 
 	retval = mapi_handles_get_private_data(rec, &private_data);
         source_object = private_data;
-	if (!source_object) {
+	if (!source_object || source_object->type != EMSMDBP_OBJECT_FOLDER) {
 		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
 		DEBUG(5, ("  object (%x) not found: %x\n", handle, mapi_req->u.mapi_MoveCopyMessages.handle_idx));
 		goto end;
 	}
 
-	contextID = emsmdbp_get_contextID(destination_object);
-	mapistore = emsmdbp_is_mapistore(source_object);
-	if (mapistore) {
-		/* We prepare a set of new MIDs for the backend */
-		targetMIDs = talloc_array(NULL, uint64_t, mapi_req->u.mapi_MoveCopyMessages.count);
-		for (i = 0; i < mapi_req->u.mapi_MoveCopyMessages.count; i++) {
-			openchangedb_get_new_folderID(emsmdbp_ctx->oc_ctx, &targetMIDs[i]);
-		}
-
-		/* We invoke the backend method */
-		mapistore_folder_move_copy_messages(emsmdbp_ctx->mstore_ctx, contextID, destination_object->backend_object, source_object->backend_object, mem_ctx, mapi_req->u.mapi_MoveCopyMessages.count, mapi_req->u.mapi_MoveCopyMessages.message_id, targetMIDs, NULL, mapi_req->u.mapi_MoveCopyMessages.WantCopy);
-		talloc_free(targetMIDs);
-
-		/* /\* The backend might do this for us. In any case, we try to add it ourselves *\/ */
-		/* mapistore_indexing_record_add_mid(emsmdbp_ctx->mstore_ctx, contextID, targetMID); */
-	}
-	else {
-		DEBUG(0, ("["__location__"] - mapistore support not implemented yet - shouldn't occur\n"));
-		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
-	}
+	mapi_repl->error_code = oxcfold_move_copy_messages(emsmdbp_ctx, source_object, destination_object,
+							   mapi_req->u.mapi_MoveCopyMessages.count,
+							   mapi_req->u.mapi_MoveCopyMessages.message_id,
+							   mapi_req->u.mapi_MoveCopyMessages.WantCopy, &partial);
+	mapi_repl->u.mapi_MoveCopyMessages.PartialCompletion = partial;
 
 end:
 	*size += libmapiserver_RopMoveCopyMessages_size(mapi_repl);
@@ -1233,3 +1433,153 @@ end:
 
 	return MAPI_E_SUCCESS;
 }
+
+
+/**
+   \details EcDoRpc HardDeleteMessages (0x91) Rop. This operation
+   permanently deletes messages from a folder.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the HardDeleteMessages EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the HardDeleteMessages EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopHardDeleteMessages(TALLOC_CTX *mem_ctx,
+						       struct emsmdbp_context *emsmdbp_ctx,
+						       struct EcDoRpc_MAPI_REQ *mapi_req,
+						       struct EcDoRpc_MAPI_REPL *mapi_repl,
+						       uint32_t *handles, uint16_t *size)
+{
+	struct HardDeleteMessages_req	*request;
+	struct mapi_handles		*rec = NULL;
+	struct emsmdbp_object		*folder_object;
+	enum MAPISTATUS			retval;
+	uint32_t			handle;
+	void				*data = NULL;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] HardDeleteMessages (0x91)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_HardDeleteMessages;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->u.mapi_HardDeleteMessages.PartialCompletion = false;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &data);
+	folder_object = (struct emsmdbp_object *) data;
+	if (retval || !folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER) {
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	if (!emsmdbp_is_mapistore(folder_object)) {
+		DEBUG(5, ("  folder is not in mapistore\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	mapi_repl->error_code = oxcfold_delete_messages(emsmdbp_ctx, folder_object,
+							request->MessageIdCount, request->MessageIds,
+							MAPISTORE_PERMANENT_DELETE);
+
+end:
+	*size += libmapiserver_RopHardDeleteMessages_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc HardDeleteMessagesAndSubfolders (0x92) Rop. This
+   operation permanently deletes the messages and subfolders of a
+   folder, without deleting the folder itself.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the HardDeleteMessagesAndSubfolders
+   EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the HardDeleteMessagesAndSubfolders
+   EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopHardDeleteMessagesAndSubfolders(TALLOC_CTX *mem_ctx,
+								    struct emsmdbp_context *emsmdbp_ctx,
+								    struct EcDoRpc_MAPI_REQ *mapi_req,
+								    struct EcDoRpc_MAPI_REPL *mapi_repl,
+								    uint32_t *handles, uint16_t *size)
+{
+	struct HardDeleteMessagesAndSubfolders_req	*request;
+	struct HardDeleteMessagesAndSubfolders_repl	*response;
+	struct mapi_handles				*rec = NULL;
+	struct emsmdbp_object				*folder_object;
+	enum MAPISTATUS					retval;
+	uint32_t					handle;
+	bool						partial = false;
+	void						*data = NULL;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFOLD] HardDeleteMessagesAndSubfolders (0x92)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_HardDeleteMessagesAndSubfolders;
+	response = &mapi_repl->u.mapi_HardDeleteMessagesAndSubfolders;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	response->PartialCompletion = false;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &data);
+	folder_object = (struct emsmdbp_object *) data;
+	if (retval || !folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER) {
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	mapi_repl->error_code = oxcfold_empty_folder(emsmdbp_ctx, folder_object, request->WantDeleteAssociated,
+						     MAPISTORE_PERMANENT_DELETE, &partial);
+	response->PartialCompletion = partial;
+
+end:
+	*size += libmapiserver_RopHardDeleteMessagesAndSubfolders_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
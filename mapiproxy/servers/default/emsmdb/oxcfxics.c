@@ -353,6 +353,63 @@ static void oxcfxics_ndr_push_properties(struct ndr_push *ndr, struct ndr_push *
 
 }
 
+/**
+   \details Remove from a property array the properties whose type cannot
+   be serialized by oxcfxics_ndr_push_properties
+
+   \param properties pointer to the property array to filter in place
+ */
+static void oxcfxics_filter_serializable_properties(struct SPropTagArray *properties)
+{
+	uint32_t	i, j;
+	uint16_t	prop_type;
+	bool		supported;
+
+	for (i = 0, j = 0; i < properties->cValues; i++) {
+		prop_type = properties->aulPropTag[i] & 0xffff;
+		if ((prop_type & MV_FLAG)) {
+			switch (prop_type & 0x0fff) {
+			case PT_SHORT:
+			case PT_LONG:
+			case PT_I8:
+			case PT_BINARY:
+			case PT_UNICODE:
+				supported = true;
+				break;
+			default:
+				supported = false;
+			}
+		}
+		else {
+			switch (prop_type) {
+			case PT_I2:
+			case PT_LONG:
+			case PT_DOUBLE:
+			case PT_I8:
+			case PT_BOOLEAN:
+			case PT_STRING8:
+			case PT_UNICODE:
+			case PT_SVREID:
+			case PT_BINARY:
+			case PT_CLSID:
+			case PT_SYSTIME:
+				supported = true;
+				break;
+			default:
+				supported = false;
+			}
+		}
+		if (supported) {
+			properties->aulPropTag[j] = properties->aulPropTag[i];
+			j++;
+		}
+		else {
+			DEBUG(5, ("%s: skipping property %.8x\n", __FUNCTION__, properties->aulPropTag[i]));
+		}
+	}
+	properties->cValues = j;
+}
+
 static int oxcfxics_fmid_from_source_key(struct emsmdbp_context *emsmdbp_ctx, const char *owner, struct SBinary_short *source_key, uint64_t *fmidp)
 {
 	uint64_t	fmid, base;
@@ -552,7 +609,7 @@ static void oxcfxics_push_messageChange_recipients(struct emsmdbp_context *emsmd
 
 	min_string_value_buffer = oxcfxics_compute_cutmark_min_value_buffer(PT_UNICODE);
 
-	if (msg) {
+	if (msg && msg->columns) {
 		local_mem_ctx = talloc_zero(NULL, TALLOC_CTX);
 
 		if (SPropTagArray_find(*msg->columns, PidTagDisplayName, &cn_idx) == MAPI_E_NOT_FOUND
@@ -619,14 +676,13 @@ static void oxcfxics_push_messageChange_recipients(struct emsmdbp_context *emsmd
 }
 
 /* FIXME: attachment_object should be an emsmdbp_object but we lack time to create the struct */
-static void oxcfxics_push_messageChange_attachment_embedded_message(struct emsmdbp_context *emsmdbp_ctx, uint32_t contextID, struct emsmdbp_object_synccontext *synccontext, struct oxcfxics_sync_data *sync_data, void *attachment)
+static void oxcfxics_push_messageChange_attachment_embedded_message(struct emsmdbp_context *emsmdbp_ctx, uint32_t contextID, struct SPropTagArray *properties, struct oxcfxics_sync_data *sync_data, void *attachment)
 {
 	TALLOC_CTX			*mem_ctx;
 	enum mapistore_error		ret;
         struct mapistore_message	*msg;
 	void				*embedded_message;
 	uint64_t			messageID;
-	struct SPropTagArray		*properties;
 	struct mapistore_property_data  *prop_data;
 	void				**data_pointers;
 	enum MAPISTATUS			*retvals;
@@ -640,11 +696,15 @@ static void oxcfxics_push_messageChange_attachment_embedded_message(struct emsmd
 		ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, 0);
 		ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, sync_data->ndr->offset);
 
+		/* without an explicit property set, the embedded message is copied with all its properties */
+		if (properties == NULL) {
+			ret = mapistore_properties_get_available_properties(emsmdbp_ctx->mstore_ctx, contextID, embedded_message, mem_ctx, &properties);
+			if (ret != MAPISTORE_SUCCESS) {
+				properties = talloc_zero(mem_ctx, struct SPropTagArray);
+			}
+			oxcfxics_filter_serializable_properties(properties);
+		}
 
-		properties = &synccontext->properties;
-
-
-		/* ret = mapistore_properties_get_available_properties(emsmdbp_ctx->mstore_ctx, contextID, embedded_message, mem_ctx, &available_properties); */
 		prop_data = talloc_array(mem_ctx, struct mapistore_property_data, properties->cValues);
 		memset(prop_data, 0, sizeof(struct mapistore_property_data) * properties->cValues);
 
@@ -686,7 +746,7 @@ static void oxcfxics_push_messageChange_attachment_embedded_message(struct emsmd
 	talloc_free(mem_ctx);
 }
 
-static void oxcfxics_push_messageChange_attachments(struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object_synccontext *synccontext, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *message_object)
+static void oxcfxics_push_messageChange_attachments(struct emsmdbp_context *emsmdbp_ctx, struct SPropTagArray *properties, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *message_object)
 {
 	TALLOC_CTX		*mem_ctx;
 	struct emsmdbp_object	*table_object;
@@ -727,7 +787,7 @@ void			**data_pointers, *attachment_object;
 					method = *((uint32_t *) data_pointers[0]);
 					if (method == afEmbeddedMessage) {
 						mapistore_message_open_attachment(emsmdbp_ctx->mstore_ctx, contextID, message_object->backend_object, mem_ctx, i, &attachment_object);
-						oxcfxics_push_messageChange_attachment_embedded_message(emsmdbp_ctx, contextID, synccontext, sync_data, attachment_object);
+						oxcfxics_push_messageChange_attachment_embedded_message(emsmdbp_ctx, contextID, properties, sync_data, attachment_object);
 					}
 				}
 
@@ -1044,7 +1104,7 @@ static bool oxcfxics_push_messageChange(struct emsmdbp_context *emsmdbp_ctx, str
 		   StartEmbed messageContent EndEmbed */
 
 		oxcfxics_push_messageChange_recipients(emsmdbp_ctx, sync_data, message_object, msg);
-		oxcfxics_push_messageChange_attachments(emsmdbp_ctx, synccontext, sync_data, message_object);
+		oxcfxics_push_messageChange_attachments(emsmdbp_ctx, &synccontext->properties, sync_data, message_object);
 
 		synccontext->sent_objects++;
 	end_row:
@@ -1546,187 +1606,749 @@ static void oxcfxics_prepare_synccontext_with_folderChange(struct emsmdbp_object
 	talloc_free(sync_data);
 }
 
-static inline void oxcfxics_fill_ftcontext_fasttransfer_response(struct FastTransferSourceGetBuffer_repl *response, uint32_t request_buffer_size, TALLOC_CTX *mem_ctx, struct emsmdbp_object_ftcontext *ftcontext, struct emsmdbp_context *emsmdbp_ctx)
+/** FastTransfer source operations
+
+   RopFastTransferSourceCopyMessages, RopFastTransferSourceCopyFolder and
+   RopFastTransferSourceCopyProperties serialize the requested content into
+   the buffer of an ftcontext object when they are invoked. The stream is
+   then downloaded with RopFastTransferSourceGetBuffer, which splits it on
+   the cutmarks recorded along the way. */
+
+struct oxcfxics_ftsource_options {
+	struct mapi_SPropTagArray	*tags;		/* property tags passed by the client */
+	bool				include;	/* whether "tags" is an inclusion or an exclusion list */
+	bool				recipients;
+	bool				attachments;
+	bool				fai_messages;
+	bool				messages;
+	bool				subfolders;
+};
+
+/* descendant objects are always transferred with all their properties and subobjects */
+static const struct oxcfxics_ftsource_options oxcfxics_ftsource_all = { NULL, false, true, true, true, true, true };
+
+static struct oxcfxics_sync_data *oxcfxics_ftsource_data_init(TALLOC_CTX *mem_ctx, struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object *object)
 {
-	uint32_t buffer_size, min_value_buffer, mark_idx, max_cutmark;
+	struct oxcfxics_sync_data	*sync_data;
 
-	buffer_size = request_buffer_size;
+	sync_data = talloc_zero(mem_ctx, struct oxcfxics_sync_data);
+	openchangedb_get_MailboxReplica(emsmdbp_ctx->oc_ctx, emsmdbp_get_owner(object), NULL, &sync_data->replica_guid);
+	sync_data->ndr = ndr_push_init_ctx(sync_data);
+	ndr_set_flags(&sync_data->ndr->flags, LIBNDR_FLAG_NOALIGN);
+	sync_data->ndr->offset = 0;
+	sync_data->cutmarks_ndr = ndr_push_init_ctx(sync_data);
+	ndr_set_flags(&sync_data->cutmarks_ndr->flags, LIBNDR_FLAG_NOALIGN);
+	sync_data->cutmarks_ndr->offset = 0;
+	sync_data->eid_set = RAWIDSET_make(sync_data, false, false);
 
-	if (ftcontext->stream.position == 0) {
-		ftcontext->steps = 0;
-		ftcontext->total_steps = (ftcontext->stream.buffer.length / request_buffer_size) + 1;
-		ftcontext->next_cutmark_idx = 1;
-		oxcfxics_check_cutmark_buffer(ftcontext->cutmarks, &ftcontext->stream.buffer);
-		DEBUG(5, ("fast transfer buffer is %d bytes long\n", (uint32_t) ftcontext->stream.buffer.length));
+	return sync_data;
+}
+
+static void oxcfxics_ftsource_push_marker(struct oxcfxics_sync_data *sync_data, uint32_t marker)
+{
+	ndr_push_uint32(sync_data->ndr, NDR_SCALARS, marker);
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, 0);
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, sync_data->ndr->offset);
+}
+
+static void oxcfxics_ftsource_push_delprop(struct oxcfxics_sync_data *sync_data, enum MAPITAGS property)
+{
+	ndr_push_uint32(sync_data->ndr, NDR_SCALARS, MetaTagFXDelProp);
+	ndr_push_uint32(sync_data->ndr, NDR_SCALARS, property);
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, 0);
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, sync_data->ndr->offset);
+}
+
+static void oxcfxics_ftsource_push_propList(struct emsmdbp_context *emsmdbp_ctx, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *object, const struct oxcfxics_ftsource_options *options)
+{
+	TALLOC_CTX		*mem_ctx;
+	struct SPropTagArray	*properties;
+	void			**data_pointers;
+	enum MAPISTATUS		*retvals;
+	uint32_t		i, j, k;
+	bool			listed;
+
+	mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+
+	if (emsmdbp_object_get_available_properties(mem_ctx, emsmdbp_ctx, object, &properties) != MAPISTORE_SUCCESS) {
+		DEBUG(5, ("%s: no properties available on %s object\n", __FUNCTION__, emsmdbp_getstr_type(object)));
+		goto end;
 	}
-	ftcontext->steps += 1;
+	oxcfxics_filter_serializable_properties(properties);
 
-	if (ftcontext->stream.position + request_buffer_size < ftcontext->stream.buffer.length) {
-		mark_idx = ftcontext->next_cutmark_idx;
-		max_cutmark = ftcontext->stream.position + request_buffer_size;
-		/* FIXME: cutmark lookups would be faster using a binary search */
-		while (ftcontext->cutmarks[mark_idx] != 0xffffffff && ftcontext->cutmarks[mark_idx] < max_cutmark) {
-			buffer_size = ftcontext->cutmarks[mark_idx] - ftcontext->stream.position;
-			mark_idx += 2;
-		}
-		if (buffer_size < request_buffer_size && ftcontext->cutmarks[mark_idx] != 0xffffffff) {
-			min_value_buffer = ftcontext->cutmarks[mark_idx-1];
-			if (min_value_buffer && (request_buffer_size - buffer_size > min_value_buffer)) {
-				buffer_size = request_buffer_size;
+	/* property tags are compared by id, since clients do not always use the type we store */
+	for (i = 0, k = 0; i < properties->cValues; i++) {
+		listed = false;
+		if (options->tags) {
+			for (j = 0; j < options->tags->cValues; j++) {
+				if ((options->tags->aulPropTag[j] >> 16) == (properties->aulPropTag[i] >> 16)) {
+					listed = true;
+					break;
+				}
 			}
 		}
-		ftcontext->next_cutmark_idx = mark_idx;
+		if (listed == options->include) {
+			properties->aulPropTag[k] = properties->aulPropTag[i];
+			k++;
+		}
 	}
-	
-	response->TransferBuffer = emsmdbp_stream_read_buffer(&ftcontext->stream, buffer_size);
-	response->TotalStepCount = ftcontext->total_steps;
-	if (ftcontext->stream.position == ftcontext->stream.buffer.length) {
-		response->TransferStatus = TransferStatus_Done;
-		response->InProgressCount = response->TotalStepCount;
+	properties->cValues = k;
+
+	if (properties->cValues > 0) {
+		data_pointers = emsmdbp_object_get_properties(mem_ctx, emsmdbp_ctx, object, properties, &retvals);
+		if (data_pointers) {
+			oxcfxics_ndr_push_properties(sync_data->ndr, sync_data->cutmarks_ndr, emsmdbp_ctx->mstore_ctx->nprops_ctx, properties, data_pointers, retvals);
+		}
 	}
-	else {
-		response->TransferStatus = TransferStatus_Partial;
-		response->InProgressCount = ftcontext->steps;
+
+end:
+	talloc_free(mem_ctx);
+}
+
+static void oxcfxics_ftsource_push_messageContent(struct emsmdbp_context *emsmdbp_ctx, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *message_object, struct mapistore_message *msg, const struct oxcfxics_ftsource_options *options)
+{
+	/* messageContent:
+	   propList [ PidTagFXDelProp *(StartRecip propList EndToRecip) ] [ PidTagFXDelProp *(NewAttach propList [embeddedMessage] EndAttach) ] */
+	oxcfxics_ftsource_push_propList(emsmdbp_ctx, sync_data, message_object, options);
+	if (options->recipients) {
+		oxcfxics_push_messageChange_recipients(emsmdbp_ctx, sync_data, message_object, msg);
+	}
+	if (options->attachments) {
+		oxcfxics_push_messageChange_attachments(emsmdbp_ctx, NULL, sync_data, message_object);
 	}
 }
 
-static uint32_t oxcfxics_advance_cutmarks(struct emsmdbp_object_synccontext *synccontext, uint32_t request_buffer_size)
+static void oxcfxics_ftsource_push_message(struct emsmdbp_context *emsmdbp_ctx, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *folder_object, uint64_t messageID)
 {
-	uint32_t buffer_size, min_value_buffer, mark_idx, max_cutmark;
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_object		*message_object;
+	struct mapistore_message	*msg;
+	enum MAPITAGS			associated_tag = PidTagAssociated;
+	struct SPropTagArray		query_props;
+	void				**data_pointers;
+	enum MAPISTATUS			*retvals;
+	bool				fai = false;
 
-	buffer_size = request_buffer_size;
+	mem_ctx = talloc_zero(NULL, TALLOC_CTX);
 
-	mark_idx = synccontext->next_cutmark_idx;
-	max_cutmark = synccontext->stream.position + request_buffer_size;
-	/* FIXME: cutmark lookups would be faster using a binary search */
-	while (synccontext->cutmarks[mark_idx] != 0xffffffff && synccontext->cutmarks[mark_idx] < max_cutmark) {
-		buffer_size = synccontext->cutmarks[mark_idx] - synccontext->stream.position;
-		mark_idx += 2;
+	if (emsmdbp_object_message_open(mem_ctx, emsmdbp_ctx, folder_object, folder_object->object.folder->folderID, messageID, false, &message_object, &msg) != MAPISTORE_SUCCESS) {
+		DEBUG(5, ("message '%.16"PRIx64"' could not be open, skipped\n", messageID));
+		goto end;
 	}
-	if (buffer_size < request_buffer_size && synccontext->cutmarks[mark_idx] != 0xffffffff) {
-		min_value_buffer = synccontext->cutmarks[mark_idx-1];
-		if (min_value_buffer && (request_buffer_size - buffer_size > min_value_buffer)) {
-			buffer_size = request_buffer_size;
-		}
+
+	query_props.cValues = 1;
+	query_props.aulPropTag = &associated_tag;
+	data_pointers = emsmdbp_object_get_properties(mem_ctx, emsmdbp_ctx, message_object, &query_props, &retvals);
+	if (data_pointers && retvals[0] == MAPI_E_SUCCESS) {
+		fai = *(uint8_t *) data_pointers[0];
 	}
-	synccontext->next_cutmark_idx = mark_idx;
 
-	return buffer_size;
-}
+	/* message: ( StartMessage / StartFAIMsg ) messageContent EndMessage */
+	oxcfxics_ftsource_push_marker(sync_data, fai ? StartFAIMsg : StartMessage);
+	oxcfxics_ftsource_push_messageContent(emsmdbp_ctx, sync_data, message_object, msg, &oxcfxics_ftsource_all);
+	oxcfxics_ftsource_push_marker(sync_data, EndMessage);
 
+end:
+	talloc_free(mem_ctx);
+}
 
-static inline void oxcfxics_fill_synccontext_fasttransfer_response(struct FastTransferSourceGetBuffer_repl *response, uint32_t request_buffer_size, TALLOC_CTX *mem_ctx, struct emsmdbp_object_synccontext *synccontext, struct emsmdbp_object *parent_object)
+static struct UI8Array_r *oxcfxics_ftsource_get_fmids(TALLOC_CTX *mem_ctx, struct emsmdbp_context *emsmdbp_ctx, struct emsmdbp_object *folder_object, uint32_t table_type)
 {
-	char		*owner;
-	size_t		old_chunk_size, new_chunk_size;
-	uint32_t	buffer_size;
-	bool		end_of_buffer = false;
-	DATA_BLOB	joint_buffer;
+	TALLOC_CTX		*local_mem_ctx;
+	struct emsmdbp_object	*table_object;
+	struct UI8Array_r	*fmids;
+	enum MAPITAGS		id_property;
+	void			**data_pointers;
+	enum MAPISTATUS		*retvals;
+	uint32_t		i;
 
-	owner = emsmdbp_get_owner(parent_object);
+	fmids = talloc_zero(mem_ctx, struct UI8Array_r);
 
-	DEBUG(5, ("start syncstream: position = %zu, size = %zu\n", synccontext->stream.position, synccontext->stream.buffer.length));
-	if (synccontext->stream.position + request_buffer_size < synccontext->stream.buffer.length) {
-		/* the current chunk has not been "emptied" yet */
-		buffer_size = oxcfxics_advance_cutmarks(synccontext, request_buffer_size);
-		response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
+	local_mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+	table_object = emsmdbp_folder_open_table(local_mem_ctx, folder_object, table_type, 0);
+	if (!table_object) {
+		goto end;
 	}
-	else {
-		/* the current chunk not does exist or we reached its end */
-		if (synccontext->request.contents_mode) {
-			DEBUG(5, ("content mode, stage %d\n", synccontext->sync_stage));
-			if (synccontext->sync_stage == 4) {
-				/* the last chunk was the last one */
-				end_of_buffer = true;
-				response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, request_buffer_size);
-			}
-			else if (synccontext->sync_stage == 0) {
-				/* no chunk sent yet, so we create a new one */
-				oxcfxics_fill_synccontext_with_messageChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
-				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
-				if (request_buffer_size < synccontext->stream.buffer.length) {
-					buffer_size = oxcfxics_advance_cutmarks(synccontext, request_buffer_size);
-				}
-				else {
-					buffer_size = request_buffer_size;
-					if (synccontext->sync_stage == 4) {
-						end_of_buffer = true;
-					}
-					else {
-						abort();
-					}
-				}
-				response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
-			}
-			else {
-				/* we have reached the end of a middle chunk, we must thus finish it and complete the buffer with the content of the next chunk */
-				old_chunk_size = synccontext->stream.buffer.length - synccontext->stream.position;
 
-				if (old_chunk_size > 0) {
-					joint_buffer.length = old_chunk_size;
-					joint_buffer.data = talloc_memdup(mem_ctx, synccontext->stream.buffer.data + synccontext->stream.position, joint_buffer.length);
-				}
+	id_property = (table_type == MAPISTORE_FOLDER_TABLE) ? PidTagFolderId : PidTagMid;
+	table_object->object.table->prop_count = 1;
+	table_object->object.table->properties = &id_property;
+	if (emsmdbp_is_mapistore(table_object)) {
+		mapistore_table_set_columns(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(table_object), table_object->backend_object, 1, &id_property);
+	}
 
-				oxcfxics_fill_synccontext_with_messageChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
-				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
+	fmids->lpui8 = talloc_array(fmids, uint64_t, table_object->object.table->denominator);
+	for (i = 0; i < table_object->object.table->denominator; i++) {
+		data_pointers = emsmdbp_object_table_get_row_props(local_mem_ctx, emsmdbp_ctx, table_object, i, MAPISTORE_PREFILTERED_QUERY, &retvals);
+		if (data_pointers && retvals[0] == MAPI_E_SUCCESS) {
+			fmids->lpui8[fmids->cValues] = *(uint64_t *) data_pointers[0];
+			fmids->cValues++;
+		}
+	}
 
-				new_chunk_size = request_buffer_size - old_chunk_size;
-				if (synccontext->stream.buffer.length < new_chunk_size) {
-					new_chunk_size = synccontext->stream.buffer.length;
-					if (synccontext->sync_stage == 4) {
-						end_of_buffer = true;
-					}
-					else {
-						abort();
-					}
-				}
-				else {
-					new_chunk_size = oxcfxics_advance_cutmarks(synccontext, new_chunk_size);
-				}
+end:
+	talloc_free(local_mem_ctx);
 
-				if (new_chunk_size > 0) {
-					if (old_chunk_size) {
-						joint_buffer.length += new_chunk_size;
-						joint_buffer.data = talloc_realloc(mem_ctx, joint_buffer.data, uint8_t, joint_buffer.length);
-						memcpy(joint_buffer.data + old_chunk_size, synccontext->stream.buffer.data, new_chunk_size);
-						synccontext->stream.position += new_chunk_size;
-					}
-					else {
-						joint_buffer = emsmdbp_stream_read_buffer(&synccontext->stream, new_chunk_size);
-					}
-				}
-				response->TransferBuffer = joint_buffer;
+	return fmids;
+}
 
+static void oxcfxics_ftsource_push_folderContent(struct emsmdbp_context *emsmdbp_ctx, struct oxcfxics_sync_data *sync_data, struct emsmdbp_object *folder_object, const struct oxcfxics_ftsource_options *options)
+{
+	TALLOC_CTX		*mem_ctx;
+	struct UI8Array_r	*fmids;
+	struct emsmdbp_object	*subfolder_object;
+	uint32_t		i;
 
-				DEBUG(5, ("joint buffers of sizes %zu and %zu\n", old_chunk_size, new_chunk_size));
-			}
-		}
-		else {
-			buffer_size = request_buffer_size;
-			if (synccontext->stream.buffer.data) {
-				end_of_buffer = true;
-			}
-			else {
-				oxcfxics_prepare_synccontext_with_folderChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
-				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
-				DEBUG(5, ("synccontext buffer is %u bytes long\n", (uint32_t) synccontext->stream.buffer.length));
-			}
-			response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
+	/* folderContent:
+	   propList [ PidTagFXDelProp *message ] [ PidTagFXDelProp *message ] [ PidTagFXDelProp *(StartSubFld folderContent EndFolder) ] */
+	oxcfxics_ftsource_push_propList(emsmdbp_ctx, sync_data, folder_object, options);
+
+	mem_ctx = talloc_zero(NULL, TALLOC_CTX);
+
+	if (options->fai_messages) {
+		oxcfxics_ftsource_push_delprop(sync_data, PidTagFolderAssociatedContents);
+		fmids = oxcfxics_ftsource_get_fmids(mem_ctx, emsmdbp_ctx, folder_object, MAPISTORE_FAI_TABLE);
+		for (i = 0; i < fmids->cValues; i++) {
+			oxcfxics_ftsource_push_message(emsmdbp_ctx, sync_data, folder_object, fmids->lpui8[i]);
 		}
 	}
-	
-	response->TotalStepCount = synccontext->total_steps;
-	/* if (synccontext->stream.position == synccontext->stream.buffer.length) { */
-	if (end_of_buffer) {
-		response->TransferStatus = TransferStatus_Done;
-		response->InProgressCount = response->TotalStepCount;
+
+	if (options->messages) {
+		oxcfxics_ftsource_push_delprop(sync_data, PidTagContainerContents);
+		fmids = oxcfxics_ftsource_get_fmids(mem_ctx, emsmdbp_ctx, folder_object, MAPISTORE_MESSAGE_TABLE);
+		for (i = 0; i < fmids->cValues; i++) {
+			oxcfxics_ftsource_push_message(emsmdbp_ctx, sync_data, folder_object, fmids->lpui8[i]);
+		}
 	}
-	else {
-		response->TransferStatus = TransferStatus_Partial;
-		response->InProgressCount = synccontext->steps;
+
+	if (options->subfolders) {
+		oxcfxics_ftsource_push_delprop(sync_data, PidTagContainerHierarchy);
+		fmids = oxcfxics_ftsource_get_fmids(mem_ctx, emsmdbp_ctx, folder_object, MAPISTORE_FOLDER_TABLE);
+		for (i = 0; i < fmids->cValues; i++) {
+			if (emsmdbp_object_open_folder(mem_ctx, emsmdbp_ctx, folder_object, fmids->lpui8[i], &subfolder_object) != MAPISTORE_SUCCESS) {
+				DEBUG(5, ("folder '%.16"PRIx64"' could not be open, skipped\n", fmids->lpui8[i]));
+				continue;
+			}
+			oxcfxics_ftsource_push_marker(sync_data, StartSubFld);
+			oxcfxics_ftsource_push_folderContent(emsmdbp_ctx, sync_data, subfolder_object, &oxcfxics_ftsource_all);
+			oxcfxics_ftsource_push_marker(sync_data, EndFolder);
+			talloc_free(subfolder_object);
+		}
 	}
- 	DEBUG(5, ("  end syncstream: position = %zu, size = %zu", synccontext->stream.position, synccontext->stream.buffer.length));
-}
+
+	talloc_free(mem_ctx);
+}
+
+/**
+   \details Create the ftcontext object that will serve the stream built in
+   sync_data to RopFastTransferSourceGetBuffer. sync_data is released.
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfxics_ftsource_make_ftcontext(struct emsmdbp_context *emsmdbp_ctx, uint32_t parent_handle_id, struct emsmdbp_object *parent_object, struct oxcfxics_sync_data *sync_data, struct mapi_handles **object_handlep)
+{
+	enum MAPISTATUS		retval;
+	struct mapi_handles	*object_handle;
+	struct emsmdbp_object	*object;
+
+	retval = mapi_handles_add(emsmdbp_ctx->handles_ctx, parent_handle_id, &object_handle);
+	if (retval) {
+		talloc_free(sync_data);
+		return retval;
+	}
+
+	object = emsmdbp_object_ftcontext_init(object_handle, emsmdbp_ctx, parent_object);
+	if (object == NULL) {
+		DEBUG(5, ("  context object not created\n"));
+		mapi_handles_delete(emsmdbp_ctx->handles_ctx, object_handle->handle);
+		talloc_free(sync_data);
+		return MAPI_E_INVALID_OBJECT;
+	}
+
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, 0);
+	ndr_push_uint32(sync_data->cutmarks_ndr, NDR_SCALARS, 0xffffffff);
+
+	(void) talloc_reference(object, sync_data->ndr->data);
+	(void) talloc_reference(object, sync_data->cutmarks_ndr->data);
+
+	object->object.ftcontext->cutmarks = (uint32_t *) sync_data->cutmarks_ndr->data;
+	object->object.ftcontext->stream.buffer.data = sync_data->ndr->data;
+	object->object.ftcontext->stream.buffer.length = sync_data->ndr->offset;
+
+	talloc_free(sync_data);
+
+	mapi_handles_set_private_data(object_handle, object);
+	*object_handlep = object_handle;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc EcDoRpc_RopFastTransferSourceCopyMessages (0x4b) Rop. This operation initializes a FastTransfer operation to download the content of a given list of messages from a folder.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the EcDoRpc_RopFastTransferSourceCopyMessages EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the EcDoRpc_RopFastTransferSourceCopyMessages EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyMessages(TALLOC_CTX *mem_ctx,
+								   struct emsmdbp_context *emsmdbp_ctx,
+								   struct EcDoRpc_MAPI_REQ *mapi_req,
+								   struct EcDoRpc_MAPI_REPL *mapi_repl,
+								   uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS				retval;
+	struct mapi_handles			*parent_object_handle = NULL, *object_handle;
+	struct emsmdbp_object			*parent_object = NULL;
+	struct FastTransferSourceCopyMessages_req *request;
+	struct oxcfxics_sync_data		*sync_data;
+	uint32_t				parent_handle_id, i;
+	void					*data;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferSourceCopyMessages (0x4b)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_FastTransferSourceCopyMessages;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = request->handle_idx;
+
+	/* Step 1. Retrieve the source folder */
+	parent_handle_id = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, parent_handle_id, &parent_object_handle);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", parent_handle_id, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(parent_object_handle, &data);
+	parent_object = (struct emsmdbp_object *) data;
+	if (!parent_object || parent_object->type != EMSMDBP_OBJECT_FOLDER) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  object not found or not a folder\n"));
+		goto end;
+	}
+
+	if (request->CopyFlags & FastTransferCopyMessage_Move) {
+		DEBUG(5, ("  Move flag ignored: source messages are deleted by the client\n"));
+	}
+
+	/* Step 2. Serialize the messageList */
+	sync_data = oxcfxics_ftsource_data_init(NULL, emsmdbp_ctx, parent_object);
+	for (i = 0; i < request->MessageIdCount; i++) {
+		oxcfxics_ftsource_push_message(emsmdbp_ctx, sync_data, parent_object, request->MessageIds[i]);
+	}
+
+	/* Step 3. Create the download context */
+	retval = oxcfxics_ftsource_make_ftcontext(emsmdbp_ctx, parent_handle_id, parent_object, sync_data, &object_handle);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	handles[mapi_repl->handle_idx] = object_handle->handle;
+
+end:
+	*size += libmapiserver_RopFastTransferSourceCopyMessages_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc EcDoRpc_RopFastTransferSourceCopyFolder (0x4c) Rop. This operation initializes a FastTransfer operation to download the content of a folder, including its messages and optionally its subfolders.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the EcDoRpc_RopFastTransferSourceCopyFolder EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the EcDoRpc_RopFastTransferSourceCopyFolder EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyFolder(TALLOC_CTX *mem_ctx,
+								 struct emsmdbp_context *emsmdbp_ctx,
+								 struct EcDoRpc_MAPI_REQ *mapi_req,
+								 struct EcDoRpc_MAPI_REPL *mapi_repl,
+								 uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS				retval;
+	struct mapi_handles			*parent_object_handle = NULL, *object_handle;
+	struct emsmdbp_object			*parent_object = NULL;
+	struct FastTransferSourceCopyFolder_req	*request;
+	struct oxcfxics_sync_data		*sync_data;
+	struct oxcfxics_ftsource_options	options;
+	uint32_t				parent_handle_id;
+	void					*data;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferSourceCopyFolder (0x4c)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_FastTransferSourceCopyFolder;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = request->handle_idx;
+
+	/* Step 1. Retrieve the source folder */
+	parent_handle_id = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, parent_handle_id, &parent_object_handle);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", parent_handle_id, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(parent_object_handle, &data);
+	parent_object = (struct emsmdbp_object *) data;
+	if (!parent_object || parent_object->type != EMSMDBP_OBJECT_FOLDER) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  object not found or not a folder\n"));
+		goto end;
+	}
+
+	/* Step 2. Serialize the topFolder: StartTopFld folderContent EndFolder */
+	options = oxcfxics_ftsource_all;
+	options.subfolders = (request->CopyFlags & FastTransferCopyFolder_CopySubfolders) ? true : false;
+
+	sync_data = oxcfxics_ftsource_data_init(NULL, emsmdbp_ctx, parent_object);
+	oxcfxics_ftsource_push_marker(sync_data, StartTopFld);
+	oxcfxics_ftsource_push_folderContent(emsmdbp_ctx, sync_data, parent_object, &options);
+	oxcfxics_ftsource_push_marker(sync_data, EndFolder);
+
+	/* Step 3. Create the download context */
+	retval = oxcfxics_ftsource_make_ftcontext(emsmdbp_ctx, parent_handle_id, parent_object, sync_data, &object_handle);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	handles[mapi_repl->handle_idx] = object_handle->handle;
+
+end:
+	*size += libmapiserver_RopFastTransferSourceCopyFolder_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc EcDoRpc_RopFastTransferSourceCopyProperties (0x69) Rop. This operation initializes a FastTransfer operation to download an explicit list of properties, and optionally the matching subobjects, from a messaging object.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the EcDoRpc_RopFastTransferSourceCopyProperties EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the EcDoRpc_RopFastTransferSourceCopyProperties EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferSourceCopyProperties(TALLOC_CTX *mem_ctx,
+								     struct emsmdbp_context *emsmdbp_ctx,
+								     struct EcDoRpc_MAPI_REQ *mapi_req,
+								     struct EcDoRpc_MAPI_REPL *mapi_repl,
+								     uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS				retval;
+	struct mapi_handles			*parent_object_handle = NULL, *object_handle;
+	struct emsmdbp_object			*parent_object = NULL;
+	struct FastTransferSourceCopyProperties_req *request;
+	struct oxcfxics_sync_data		*sync_data;
+	struct oxcfxics_ftsource_options	options;
+	struct mapistore_message		*msg;
+	uint32_t				parent_handle_id, i;
+	void					*data;
+	bool					children;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferSourceCopyProperties (0x69)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_FastTransferSourceCopyProperties;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = request->handle_idx;
+
+	/* Step 1. Retrieve the source object */
+	parent_handle_id = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, parent_handle_id, &parent_object_handle);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", parent_handle_id, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(parent_object_handle, &data);
+	parent_object = (struct emsmdbp_object *) data;
+	if (!parent_object) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  object not found\n"));
+		goto end;
+	}
+
+	/* Step 2. The property list is an inclusion list, subobjects are
+	   transferred when their property is listed and Level is 0 */
+	memset(&options, 0, sizeof(struct oxcfxics_ftsource_options));
+	options.tags = &request->PropertyTags;
+	options.include = true;
+	children = (request->Level == 0);
+	for (i = 0; children && i < request->PropertyTags.cValues; i++) {
+		switch (request->PropertyTags.aulPropTag[i] >> 16) {
+		case (PidTagMessageRecipients >> 16):
+			options.recipients = true;
+			break;
+		case (PidTagMessageAttachments >> 16):
+			options.attachments = true;
+			break;
+		case (PidTagFolderAssociatedContents >> 16):
+			options.fai_messages = true;
+			break;
+		case (PidTagContainerContents >> 16):
+			options.messages = true;
+			break;
+		case (PidTagContainerHierarchy >> 16):
+			options.subfolders = true;
+			break;
+		}
+	}
+
+	/* Step 3. Serialize the object content */
+	sync_data = oxcfxics_ftsource_data_init(NULL, emsmdbp_ctx, parent_object);
+	switch (parent_object->type) {
+	case EMSMDBP_OBJECT_FOLDER:
+		oxcfxics_ftsource_push_folderContent(emsmdbp_ctx, sync_data, parent_object, &options);
+		break;
+	case EMSMDBP_OBJECT_MESSAGE:
+		msg = NULL;
+		if ((options.recipients || options.attachments) && emsmdbp_is_mapistore(parent_object)) {
+			mapistore_message_get_message_data(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(parent_object), parent_object->backend_object, sync_data, &msg);
+		}
+		oxcfxics_ftsource_push_messageContent(emsmdbp_ctx, sync_data, parent_object, msg, &options);
+		break;
+	default:
+		oxcfxics_ftsource_push_propList(emsmdbp_ctx, sync_data, parent_object, &options);
+	}
+
+	/* Step 4. Create the download context */
+	retval = oxcfxics_ftsource_make_ftcontext(emsmdbp_ctx, parent_handle_id, parent_object, sync_data, &object_handle);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	handles[mapi_repl->handle_idx] = object_handle->handle;
+
+end:
+	*size += libmapiserver_RopFastTransferSourceCopyProperties_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+static inline void oxcfxics_fill_ftcontext_fasttransfer_response(struct FastTransferSourceGetBuffer_repl *response, uint32_t request_buffer_size, TALLOC_CTX *mem_ctx, struct emsmdbp_object_ftcontext *ftcontext, struct emsmdbp_context *emsmdbp_ctx)
+{
+	uint32_t buffer_size, min_value_buffer, mark_idx, max_cutmark;
+
+	buffer_size = request_buffer_size;
+
+	if (ftcontext->stream.position == 0) {
+		ftcontext->steps = 0;
+		ftcontext->total_steps = (ftcontext->stream.buffer.length / request_buffer_size) + 1;
+		ftcontext->next_cutmark_idx = 1;
+		oxcfxics_check_cutmark_buffer(ftcontext->cutmarks, &ftcontext->stream.buffer);
+		DEBUG(5, ("fast transfer buffer is %d bytes long\n", (uint32_t) ftcontext->stream.buffer.length));
+	}
+	ftcontext->steps += 1;
+
+	if (ftcontext->stream.position + request_buffer_size < ftcontext->stream.buffer.length) {
+		mark_idx = ftcontext->next_cutmark_idx;
+		max_cutmark = ftcontext->stream.position + request_buffer_size;
+		/* FIXME: cutmark lookups would be faster using a binary search */
+		while (ftcontext->cutmarks[mark_idx] != 0xffffffff && ftcontext->cutmarks[mark_idx] < max_cutmark) {
+			buffer_size = ftcontext->cutmarks[mark_idx] - ftcontext->stream.position;
+			mark_idx += 2;
+		}
+		if (buffer_size < request_buffer_size && ftcontext->cutmarks[mark_idx] != 0xffffffff) {
+			min_value_buffer = ftcontext->cutmarks[mark_idx-1];
+			if (min_value_buffer && (request_buffer_size - buffer_size > min_value_buffer)) {
+				buffer_size = request_buffer_size;
+			}
+		}
+		ftcontext->next_cutmark_idx = mark_idx;
+	}
+	
+	response->TransferBuffer = emsmdbp_stream_read_buffer(&ftcontext->stream, buffer_size);
+	response->TotalStepCount = ftcontext->total_steps;
+	if (ftcontext->stream.position == ftcontext->stream.buffer.length) {
+		response->TransferStatus = TransferStatus_Done;
+		response->InProgressCount = response->TotalStepCount;
+	}
+	else {
+		response->TransferStatus = TransferStatus_Partial;
+		response->InProgressCount = ftcontext->steps;
+	}
+}
+
+static uint32_t oxcfxics_advance_cutmarks(struct emsmdbp_object_synccontext *synccontext, uint32_t request_buffer_size)
+{
+	uint32_t buffer_size, min_value_buffer, mark_idx, max_cutmark;
+
+	buffer_size = request_buffer_size;
+
+	mark_idx = synccontext->next_cutmark_idx;
+	max_cutmark = synccontext->stream.position + request_buffer_size;
+	/* FIXME: cutmark lookups would be faster using a binary search */
+	while (synccontext->cutmarks[mark_idx] != 0xffffffff && synccontext->cutmarks[mark_idx] < max_cutmark) {
+		buffer_size = synccontext->cutmarks[mark_idx] - synccontext->stream.position;
+		mark_idx += 2;
+	}
+	if (buffer_size < request_buffer_size && synccontext->cutmarks[mark_idx] != 0xffffffff) {
+		min_value_buffer = synccontext->cutmarks[mark_idx-1];
+		if (min_value_buffer && (request_buffer_size - buffer_size > min_value_buffer)) {
+			buffer_size = request_buffer_size;
+		}
+	}
+	synccontext->next_cutmark_idx = mark_idx;
+
+	return buffer_size;
+}
+
+
+static inline void oxcfxics_fill_synccontext_fasttransfer_response(struct FastTransferSourceGetBuffer_repl *response, uint32_t request_buffer_size, TALLOC_CTX *mem_ctx, struct emsmdbp_object_synccontext *synccontext, struct emsmdbp_object *parent_object)
+{
+	char		*owner;
+	size_t		old_chunk_size, new_chunk_size;
+	uint32_t	buffer_size;
+	bool		end_of_buffer = false;
+	DATA_BLOB	joint_buffer;
+
+	owner = emsmdbp_get_owner(parent_object);
+
+	DEBUG(5, ("start syncstream: position = %zu, size = %zu\n", synccontext->stream.position, synccontext->stream.buffer.length));
+	if (synccontext->stream.position + request_buffer_size < synccontext->stream.buffer.length) {
+		/* the current chunk has not been "emptied" yet */
+		buffer_size = oxcfxics_advance_cutmarks(synccontext, request_buffer_size);
+		response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
+	}
+	else {
+		/* the current chunk not does exist or we reached its end */
+		if (synccontext->request.contents_mode) {
+			DEBUG(5, ("content mode, stage %d\n", synccontext->sync_stage));
+			if (synccontext->sync_stage == 4) {
+				/* the last chunk was the last one */
+				end_of_buffer = true;
+				response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, request_buffer_size);
+			}
+			else if (synccontext->sync_stage == 0) {
+				/* no chunk sent yet, so we create a new one */
+				oxcfxics_fill_synccontext_with_messageChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
+				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
+				if (request_buffer_size < synccontext->stream.buffer.length) {
+					buffer_size = oxcfxics_advance_cutmarks(synccontext, request_buffer_size);
+				}
+				else {
+					buffer_size = request_buffer_size;
+					if (synccontext->sync_stage == 4) {
+						end_of_buffer = true;
+					}
+					else {
+						abort();
+					}
+				}
+				response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
+			}
+			else {
+				/* we have reached the end of a middle chunk, we must thus finish it and complete the buffer with the content of the next chunk */
+				old_chunk_size = synccontext->stream.buffer.length - synccontext->stream.position;
+
+				if (old_chunk_size > 0) {
+					joint_buffer.length = old_chunk_size;
+					joint_buffer.data = talloc_memdup(mem_ctx, synccontext->stream.buffer.data + synccontext->stream.position, joint_buffer.length);
+				}
+
+				oxcfxics_fill_synccontext_with_messageChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
+				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
+
+				new_chunk_size = request_buffer_size - old_chunk_size;
+				if (synccontext->stream.buffer.length < new_chunk_size) {
+					new_chunk_size = synccontext->stream.buffer.length;
+					if (synccontext->sync_stage == 4) {
+						end_of_buffer = true;
+					}
+					else {
+						abort();
+					}
+				}
+				else {
+					new_chunk_size = oxcfxics_advance_cutmarks(synccontext, new_chunk_size);
+				}
+
+				if (new_chunk_size > 0) {
+					if (old_chunk_size) {
+						joint_buffer.length += new_chunk_size;
+						joint_buffer.data = talloc_realloc(mem_ctx, joint_buffer.data, uint8_t, joint_buffer.length);
+						memcpy(joint_buffer.data + old_chunk_size, synccontext->stream.buffer.data, new_chunk_size);
+						synccontext->stream.position += new_chunk_size;
+					}
+					else {
+						joint_buffer = emsmdbp_stream_read_buffer(&synccontext->stream, new_chunk_size);
+					}
+				}
+				response->TransferBuffer = joint_buffer;
+
+
+				DEBUG(5, ("joint buffers of sizes %zu and %zu\n", old_chunk_size, new_chunk_size));
+			}
+		}
+		else {
+			buffer_size = request_buffer_size;
+			if (synccontext->stream.buffer.data) {
+				end_of_buffer = true;
+			}
+			else {
+				oxcfxics_prepare_synccontext_with_folderChange(synccontext, mem_ctx, parent_object->emsmdbp_ctx, owner, parent_object);
+				oxcfxics_check_cutmark_buffer(synccontext->cutmarks, &synccontext->stream.buffer);
+				DEBUG(5, ("synccontext buffer is %u bytes long\n", (uint32_t) synccontext->stream.buffer.length));
+			}
+			response->TransferBuffer = emsmdbp_stream_read_buffer(&synccontext->stream, buffer_size);
+		}
+	}
+	
+	response->TotalStepCount = synccontext->total_steps;
+	/* if (synccontext->stream.position == synccontext->stream.buffer.length) { */
+	if (end_of_buffer) {
+		response->TransferStatus = TransferStatus_Done;
+		response->InProgressCount = response->TotalStepCount;
+	}
+	else {
+		response->TransferStatus = TransferStatus_Partial;
+		response->InProgressCount = synccontext->steps;
+	}
+ 	DEBUG(5, ("  end syncstream: position = %zu, size = %zu", synccontext->stream.position, synccontext->stream.buffer.length));
+}
 
 
 /**
@@ -1754,6 +2376,7 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferSourceGetBuffer(TALLOC_CTX *mem_
 	struct FastTransferSourceGetBuffer_req	 *request;
 	struct FastTransferSourceGetBuffer_repl	 *response;
 	uint32_t				request_buffer_size;
+	uint16_t				available;
 	void					*data;
 
 	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferSourceGetBuffer (0x4e)\n"));
@@ -1795,6 +2418,12 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferSourceGetBuffer(TALLOC_CTX *mem_
 		request_buffer_size = request->MaximumBufferSize.MaximumBufferSize;
 	}
 
+	/* Fill what is left of the ROP buffer, without overflowing it */
+	available = emsmdbp_rop_buffer_available(emsmdbp_ctx, *size, SIZE_DFLT_MAPI_RESPONSE + SIZE_DFLT_ROPFASTTRANSFERSOURCEGETBUFFER);
+	if (available && available < request_buffer_size) {
+		request_buffer_size = available;
+	}
+
 	/* Step 3. Perform the read operation */
 	switch (object->type) {
 	case EMSMDBP_OBJECT_FTCONTEXT:
@@ -1818,6 +2447,647 @@ end:
 	return MAPI_E_SUCCESS;
 }
 
+/* FastTransfer destination: the uploaded stream is decoded with fxparser
+   and the objects it describes are written to the backend as soon as
+   they are complete. Each object gets its properties in a single
+   set_properties call. */
+
+enum oxcfxics_dest_level_type {
+	OXCFXICS_DEST_FOLDER,
+	OXCFXICS_DEST_MESSAGE,
+	OXCFXICS_DEST_RECIPIENT,
+	OXCFXICS_DEST_ATTACHMENT
+};
+
+struct oxcfxics_dest_level {
+	enum oxcfxics_dest_level_type	type;
+	TALLOC_CTX			*mem_ctx;
+	struct emsmdbp_object		*object;
+	bool				created;	/* created from the stream, saved when it ends */
+	struct SRow			props;		/* properties not written yet */
+	uint16_t			recipients_count;
+	struct SRow			*recipients;
+};
+
+struct oxcfxics_dest_data {
+	struct emsmdbp_context		*emsmdbp_ctx;
+	enum FastTransferDestConfig_SourceOperation	operation;
+	struct fx_parser_context	*parser;
+	enum MAPISTATUS			error;
+
+	struct oxcfxics_dest_level	*levels;
+	uint32_t			depth;
+	bool				end_marker;	/* the last item received closed a top-level object */
+
+	/* stream named property ids mapped to local ones, indexed by id - 0x8000 */
+	uint16_t			*namedprops;
+
+	/* statistics */
+	struct timeval			start;
+	uint32_t			messages;
+	uint32_t			attachments;
+	uint32_t			buffers;
+	uint64_t			bytes;
+};
+
+static int oxcfxics_dest_data_destructor(void *data)
+{
+	struct oxcfxics_dest_data	*dest = (struct oxcfxics_dest_data *) data;
+	struct timeval			now;
+	uint64_t			usec;
+
+	gettimeofday(&now, NULL);
+	usec = (now.tv_sec - dest->start.tv_sec) * 1000000 + (now.tv_usec - dest->start.tv_usec);
+
+	DEBUG(3, ("[%s:%d]: FastTransfer upload: %u messages, %u attachments, %"PRIu64" bytes in %u buffers, %"PRIu64" usec (%"PRIu64" messages/s, %"PRIu64" kB/s)\n",
+		  __FUNCTION__, __LINE__, dest->messages, dest->attachments, dest->bytes, dest->buffers, usec,
+		  usec ? ((uint64_t)dest->messages * 1000000) / usec : 0,
+		  usec ? (dest->bytes * 1000000) / (usec * 1024) : 0));
+
+	return 0;
+}
+
+static struct oxcfxics_dest_level *oxcfxics_dest_push_level(struct oxcfxics_dest_data *dest, enum oxcfxics_dest_level_type type)
+{
+	struct oxcfxics_dest_level	*level;
+
+	dest->levels = talloc_realloc(dest, dest->levels, struct oxcfxics_dest_level, dest->depth + 1);
+	if (!dest->levels) return NULL;
+
+	level = dest->levels + dest->depth;
+	memset(level, 0, sizeof (struct oxcfxics_dest_level));
+	level->type = type;
+	level->mem_ctx = talloc_new(dest);
+	dest->depth++;
+
+	return level;
+}
+
+static void oxcfxics_dest_pop_level(struct oxcfxics_dest_data *dest)
+{
+	dest->depth--;
+	talloc_free(dest->levels[dest->depth].mem_ctx);
+}
+
+/**
+   \details Write the properties and recipients received for an object
+
+   \param dest pointer to the destination context
+   \param level pointer to the level of the object
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfxics_dest_flush_level(struct oxcfxics_dest_data *dest, struct oxcfxics_dest_level *level)
+{
+	struct emsmdbp_context			*emsmdbp_ctx = dest->emsmdbp_ctx;
+	TALLOC_CTX				*local_mem_ctx;
+	struct SPropTagArray			*columns;
+	struct mapistore_message_recipient	*recipients;
+	const uint32_t				*recip_type;
+	enum mapistore_error			ret;
+	enum MAPISTATUS				retval;
+	uint32_t				i, j, idx;
+
+	if (level->props.cValues) {
+		retval = emsmdbp_object_set_properties(emsmdbp_ctx, level->object, &level->props);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		talloc_free(level->props.lpProps);
+		level->props.lpProps = NULL;
+		level->props.cValues = 0;
+	}
+
+	if (level->type != OXCFXICS_DEST_MESSAGE || !level->recipients_count) {
+		return MAPI_E_SUCCESS;
+	}
+
+	/* Same convention as RopModifyRecipients: PR_DISPLAY_NAME_UNICODE
+	   and PR_EMAIL_ADDRESS_UNICODE come first, followed by the union
+	   of the properties received for the recipients */
+	local_mem_ctx = talloc_new(NULL);
+	columns = talloc_zero(local_mem_ctx, struct SPropTagArray);
+	columns->cValues = 2;
+	columns->aulPropTag = talloc_array(columns, enum MAPITAGS, 3);
+	columns->aulPropTag[0] = PR_DISPLAY_NAME_UNICODE;
+	columns->aulPropTag[1] = PR_EMAIL_ADDRESS_UNICODE;
+	columns->aulPropTag[2] = 0;
+	for (i = 0; i < level->recipients_count; i++) {
+		for (j = 0; j < level->recipients[i].cValues; j++) {
+			if (SPropTagArray_find(*columns, level->recipients[i].lpProps[j].ulPropTag, &idx) != MAPI_E_SUCCESS) {
+				SPropTagArray_add(columns, columns, level->recipients[i].lpProps[j].ulPropTag);
+			}
+		}
+	}
+
+	recipients = talloc_array(local_mem_ctx, struct mapistore_message_recipient, level->recipients_count);
+	for (i = 0; i < level->recipients_count; i++) {
+		recip_type = find_SPropValue_data(&level->recipients[i], PR_RECIPIENT_TYPE);
+		recipients[i].type = recip_type ? (enum ulRecipClass) *recip_type : MAPI_TO;
+		recipients[i].username = NULL;
+		recipients[i].data = talloc_array(recipients, void *, columns->cValues);
+		for (j = 0; j < columns->cValues; j++) {
+			recipients[i].data[j] = (void *) find_SPropValue_data(&level->recipients[i], columns->aulPropTag[j]);
+		}
+		if (!recipients[i].data[0]) {
+			recipients[i].data[0] = (void *) find_SPropValue_data(&level->recipients[i], PR_DISPLAY_NAME);
+		}
+		if (!recipients[i].data[1]) {
+			recipients[i].data[1] = (void *) find_SPropValue_data(&level->recipients[i], PR_SMTP_ADDRESS_UNICODE);
+		}
+	}
+
+	ret = mapistore_message_modify_recipients(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(level->object),
+						  level->object->backend_object, columns, level->recipients_count, recipients);
+	talloc_free(local_mem_ctx);
+	OPENCHANGE_RETVAL_IF(ret == MAPISTORE_ERR_DENIED, MAPI_E_NO_ACCESS, NULL);
+	OPENCHANGE_RETVAL_IF(ret != MAPISTORE_SUCCESS, MAPI_E_CALL_FAILED, NULL);
+
+	talloc_free(level->recipients);
+	level->recipients = NULL;
+	level->recipients_count = 0;
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details Create a message in the current folder or attachment
+
+   \param dest pointer to the destination context
+   \param fai whether the message is a FAI message
+   \param embedded whether the message is embedded in the current attachment
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfxics_dest_create_message(struct oxcfxics_dest_data *dest, bool fai, bool embedded)
+{
+	struct emsmdbp_context		*emsmdbp_ctx = dest->emsmdbp_ctx;
+	struct emsmdbp_object		*parent_object;
+	struct oxcfxics_dest_level	*level;
+	struct mapistore_message	*msg;
+	enum mapistore_error		ret;
+	enum MAPISTATUS			retval;
+	uint64_t			messageID;
+	uint32_t			contextID;
+
+	parent_object = dest->levels[dest->depth - 1].object;
+	contextID = emsmdbp_get_contextID(parent_object);
+
+	retval = openchangedb_get_new_folderID(emsmdbp_ctx->oc_ctx, &messageID);
+	OPENCHANGE_RETVAL_IF(retval, MAPI_E_NO_SUPPORT, NULL);
+
+	level = oxcfxics_dest_push_level(dest, OXCFXICS_DEST_MESSAGE);
+	OPENCHANGE_RETVAL_IF(!level, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	level->created = true;
+	level->object = emsmdbp_object_message_init(level->mem_ctx, emsmdbp_ctx, messageID, parent_object);
+	OPENCHANGE_RETVAL_IF(!level->object, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	level->object->object.message->read_write = true;
+
+	if (embedded) {
+		ret = mapistore_message_attachment_create_embedded_message(emsmdbp_ctx->mstore_ctx, contextID, parent_object->backend_object,
+									   level->object, &level->object->backend_object, &msg);
+		if (ret == MAPISTORE_SUCCESS) {
+			talloc_free(msg);
+		}
+	}
+	else {
+		ret = mapistore_folder_create_message(emsmdbp_ctx->mstore_ctx, contextID, parent_object->backend_object,
+						      level->object, messageID, fai, &level->object->backend_object);
+	}
+	OPENCHANGE_RETVAL_IF(ret == MAPISTORE_ERR_DENIED, MAPI_E_NO_ACCESS, NULL);
+	OPENCHANGE_RETVAL_IF(ret != MAPISTORE_SUCCESS, MAPI_E_CALL_FAILED, NULL);
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details Write and save the message at the top of the stack
+
+   \param dest pointer to the destination context
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxcfxics_dest_save_message(struct oxcfxics_dest_data *dest)
+{
+	struct emsmdbp_context		*emsmdbp_ctx = dest->emsmdbp_ctx;
+	struct oxcfxics_dest_level	*level;
+	struct emsmdbp_object		*object;
+	enum mapistore_error		ret;
+	enum MAPISTATUS			retval;
+	uint32_t			contextID;
+
+	level = dest->levels + dest->depth - 1;
+	object = level->object;
+	retval = oxcfxics_dest_flush_level(dest, level);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	contextID = emsmdbp_get_contextID(object);
+	ret = mapistore_message_save(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, level->mem_ctx);
+	OPENCHANGE_RETVAL_IF(ret == MAPISTORE_ERR_DENIED, MAPI_E_NO_ACCESS, NULL);
+	OPENCHANGE_RETVAL_IF(ret != MAPISTORE_SUCCESS, MAPI_E_CALL_FAILED, NULL);
+
+	if (object->parent_object->type != EMSMDBP_OBJECT_ATTACHMENT) {
+		mapistore_indexing_record_add_mid(emsmdbp_ctx->mstore_ctx, contextID, emsmdbp_get_owner(object),
+						  object->object.message->messageID);
+		dest->messages++;
+	}
+
+	oxcfxics_dest_pop_level(dest);
+
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS oxcfxics_dest_handle_marker(struct oxcfxics_dest_data *dest, uint32_t marker)
+{
+	struct emsmdbp_context		*emsmdbp_ctx = dest->emsmdbp_ctx;
+	struct oxcfxics_dest_level	*level = dest->levels + dest->depth - 1;
+	struct oxcfxics_dest_level	*parent_level;
+	struct emsmdbp_object		*message_object;
+	enum MAPISTATUS			retval;
+	uint32_t			attachmentID;
+
+	switch (marker) {
+	case StartMessage:
+	case StartFAIMsg:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_FOLDER, MAPI_E_INVALID_PARAMETER, NULL);
+		return oxcfxics_dest_create_message(dest, (marker == StartFAIMsg), false);
+	case EndMessage:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_MESSAGE || !level->created, MAPI_E_INVALID_PARAMETER, NULL);
+		return oxcfxics_dest_save_message(dest);
+	case StartRecip:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_MESSAGE, MAPI_E_INVALID_PARAMETER, NULL);
+		level = oxcfxics_dest_push_level(dest, OXCFXICS_DEST_RECIPIENT);
+		OPENCHANGE_RETVAL_IF(!level, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		return MAPI_E_SUCCESS;
+	case EndToRecip:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_RECIPIENT, MAPI_E_INVALID_PARAMETER, NULL);
+		parent_level = level - 1;
+		parent_level->recipients = talloc_realloc(parent_level->mem_ctx, parent_level->recipients, struct SRow,
+							  parent_level->recipients_count + 1);
+		OPENCHANGE_RETVAL_IF(!parent_level->recipients, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		parent_level->recipients[parent_level->recipients_count] = level->props;
+		(void) talloc_steal(parent_level->recipients, level->props.lpProps);
+		parent_level->recipients_count++;
+		oxcfxics_dest_pop_level(dest);
+		return MAPI_E_SUCCESS;
+	case NewAttach:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_MESSAGE, MAPI_E_INVALID_PARAMETER, NULL);
+		message_object = level->object;
+		level = oxcfxics_dest_push_level(dest, OXCFXICS_DEST_ATTACHMENT);
+		OPENCHANGE_RETVAL_IF(!level, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		level->created = true;
+		level->object = emsmdbp_object_attachment_init(level->mem_ctx, emsmdbp_ctx, message_object->object.message->messageID,
+							       message_object);
+		OPENCHANGE_RETVAL_IF(!level->object, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		retval = mapistore_message_create_attachment(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(message_object),
+							     message_object->backend_object, level->object,
+							     &level->object->backend_object, &attachmentID);
+		OPENCHANGE_RETVAL_IF(retval, MAPI_E_CALL_FAILED, NULL);
+		level->object->object.attachment->attachmentID = attachmentID;
+		return MAPI_E_SUCCESS;
+	case EndAttach:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_ATTACHMENT, MAPI_E_INVALID_PARAMETER, NULL);
+		retval = oxcfxics_dest_flush_level(dest, level);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		oxcfxics_dest_pop_level(dest);
+		dest->attachments++;
+		return MAPI_E_SUCCESS;
+	case StartEmbed:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_ATTACHMENT, MAPI_E_INVALID_PARAMETER, NULL);
+		/* the attachment method must be known before the embedded message is created */
+		retval = oxcfxics_dest_flush_level(dest, level);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+		return oxcfxics_dest_create_message(dest, false, true);
+	case EndEmbed:
+		OPENCHANGE_RETVAL_IF(level->type != OXCFXICS_DEST_MESSAGE || !level->created, MAPI_E_INVALID_PARAMETER, NULL);
+		return oxcfxics_dest_save_message(dest);
+	default:
+		DEBUG(5, ("  marker 0x%.8x not supported in FastTransfer uploads\n", marker));
+		break;
+	}
+
+	OPENCHANGE_RETVAL_ERR(MAPI_E_NO_SUPPORT, NULL);
+}
+
+static enum MAPISTATUS oxcfxics_dest_marker(uint32_t marker, void *priv)
+{
+	struct oxcfxics_dest_data	*dest = (struct oxcfxics_dest_data *) priv;
+	enum MAPISTATUS			retval;
+
+	retval = oxcfxics_dest_handle_marker(dest, marker);
+	dest->end_marker = (retval == MAPI_E_SUCCESS && dest->depth == 1);
+
+	return retval;
+}
+
+static enum MAPISTATUS oxcfxics_dest_delprop(uint32_t proptag, void *priv)
+{
+	struct oxcfxics_dest_data	*dest = (struct oxcfxics_dest_data *) priv;
+
+	/* objects are created empty: there are no recipients nor
+	   attachments to remove */
+	dest->end_marker = false;
+
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS oxcfxics_dest_namedprop(uint32_t proptag, struct MAPINAMEID nameid, void *priv)
+{
+	struct oxcfxics_dest_data	*dest = (struct oxcfxics_dest_data *) priv;
+	struct ldb_context		*nprops_ctx = dest->emsmdbp_ctx->mstore_ctx->nprops_ctx;
+	uint16_t			propID = (proptag >> 16) - 0x8000;
+	uint16_t			mapped_id;
+
+	dest->end_marker = false;
+	if (dest->namedprops[propID]) {
+		return MAPI_E_SUCCESS;
+	}
+
+	if (mapistore_namedprops_get_mapped_id(nprops_ctx, nameid, &mapped_id) != MAPISTORE_SUCCESS) {
+		ldb_transaction_start(nprops_ctx);
+		mapped_id = mapistore_namedprops_next_unused_id(nprops_ctx);
+		if (mapped_id == 0 || mapistore_namedprops_create_id(nprops_ctx, nameid, mapped_id) != MAPISTORE_SUCCESS) {
+			ldb_transaction_cancel(nprops_ctx);
+			OPENCHANGE_RETVAL_ERR(MAPI_E_CALL_FAILED, NULL);
+		}
+		ldb_transaction_commit(nprops_ctx);
+	}
+	dest->namedprops[propID] = mapped_id;
+
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS oxcfxics_dest_property(struct SPropValue prop, void *priv)
+{
+	struct oxcfxics_dest_data	*dest = (struct oxcfxics_dest_data *) priv;
+	struct oxcfxics_dest_level	*level = dest->levels + dest->depth - 1;
+	uint16_t			propID = prop.ulPropTag >> 16;
+
+	dest->end_marker = false;
+	switch (prop.ulPropTag & 0xFFFF) {
+	case PT_OBJECT:
+	case PT_ERROR:
+	case PT_NULL:
+		return MAPI_E_SUCCESS;
+	}
+
+	/* identifiers assigned by the backend */
+	if ((level->type == OXCFXICS_DEST_RECIPIENT && prop.ulPropTag == PR_ROWID)
+	    || (level->type == OXCFXICS_DEST_ATTACHMENT && prop.ulPropTag == PR_ATTACH_NUM)) {
+		return MAPI_E_SUCCESS;
+	}
+
+	if (propID >= 0x8000) {
+		propID = dest->namedprops[propID - 0x8000];
+		if (!propID) {
+			DEBUG(5, ("  skipping unmapped named property 0x%.8x\n", prop.ulPropTag));
+			return MAPI_E_SUCCESS;
+		}
+		prop.ulPropTag = (enum MAPITAGS) ((propID << 16) | (prop.ulPropTag & 0xFFFF));
+	}
+
+	level->props.lpProps = talloc_realloc(level->mem_ctx, level->props.lpProps, struct SPropValue,
+					      level->props.cValues + 1);
+	OPENCHANGE_RETVAL_IF(!level->props.lpProps, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+	mapi_copy_spropvalues(level->props.lpProps, &prop, level->props.lpProps + level->props.cValues, 1);
+	level->props.cValues++;
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details EcDoRpc EcDoRpc_RopFastTransferDestinationConfigure (0x53)
+   Rop. This operation initializes a FastTransfer operation to upload
+   content to a given messaging object and its descendant subobjects.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the FastTransferDestinationConfigure EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the FastTransferDestinationConfigure EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferDestinationConfigure(TALLOC_CTX *mem_ctx,
+								     struct emsmdbp_context *emsmdbp_ctx,
+								     struct EcDoRpc_MAPI_REQ *mapi_req,
+								     struct EcDoRpc_MAPI_REPL *mapi_repl,
+								     uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS					retval;
+	struct mapi_handles				*parent_object_handle = NULL, *object_handle;
+	struct emsmdbp_object				*parent_object = NULL, *object;
+	struct FastTransferDestinationConfigure_req	*request;
+	struct oxcfxics_dest_data			*dest;
+	struct oxcfxics_dest_level			*level;
+	uint32_t					parent_handle_id;
+	void						*data;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferDestinationConfigure (0x53)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_FastTransferDestinationConfigure;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = request->handle_idx;
+
+	/* Step 1. Retrieve object handle */
+	parent_handle_id = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, parent_handle_id, &parent_object_handle);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", parent_handle_id, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(parent_object_handle, &data);
+	parent_object = (struct emsmdbp_object *) data;
+	if (!parent_object) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		goto end;
+	}
+
+	/* Step 2. Check whether the operation applies to the target object */
+	switch (request->SourceOperation) {
+	case FastTransferDest_CopyMessages:
+		if (parent_object->type != EMSMDBP_OBJECT_FOLDER) {
+			mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+			goto end;
+		}
+		break;
+	case FastTransferDest_CopyTo:
+	case FastTransferDest_CopyProperties:
+		if (parent_object->type != EMSMDBP_OBJECT_FOLDER
+		    && parent_object->type != EMSMDBP_OBJECT_MESSAGE
+		    && parent_object->type != EMSMDBP_OBJECT_ATTACHMENT) {
+			mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+			goto end;
+		}
+		break;
+	default:
+		DEBUG(5, ("  source operation %d not supported\n", request->SourceOperation));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	if (!emsmdbp_is_mapistore(parent_object)) {
+		DEBUG(5, ("  cannot upload content to non-mapistore object\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	/* Step 3. Create the context object */
+	retval = mapi_handles_add(emsmdbp_ctx->handles_ctx, parent_handle_id, &object_handle);
+	object = emsmdbp_object_ftcontext_init(object_handle, emsmdbp_ctx, parent_object);
+	if (object == NULL) {
+		mapi_handles_delete(emsmdbp_ctx->handles_ctx, object_handle->handle);
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  context object not created\n"));
+		goto end;
+	}
+
+	dest = talloc_zero(object->object.ftcontext, struct oxcfxics_dest_data);
+	dest->emsmdbp_ctx = emsmdbp_ctx;
+	dest->operation = request->SourceOperation;
+	dest->namedprops = talloc_zero_array(dest, uint16_t, 0x8000);
+	gettimeofday(&dest->start, NULL);
+
+	level = oxcfxics_dest_push_level(dest, (parent_object->type == EMSMDBP_OBJECT_FOLDER) ? OXCFXICS_DEST_FOLDER
+					 : (parent_object->type == EMSMDBP_OBJECT_MESSAGE) ? OXCFXICS_DEST_MESSAGE
+					 : OXCFXICS_DEST_ATTACHMENT);
+	level->object = parent_object;
+
+	dest->parser = fxparser_init(dest, dest);
+	fxparser_set_marker_callback(dest->parser, oxcfxics_dest_marker);
+	fxparser_set_delprop_callback(dest->parser, oxcfxics_dest_delprop);
+	fxparser_set_namedprop_callback(dest->parser, oxcfxics_dest_namedprop);
+	fxparser_set_property_callback(dest->parser, oxcfxics_dest_property);
+	talloc_set_destructor((void *)dest, (int (*)(void *))oxcfxics_dest_data_destructor);
+
+	object->object.ftcontext->dest_data = dest;
+
+	mapi_handles_set_private_data(object_handle, object);
+	handles[mapi_repl->handle_idx] = object_handle->handle;
+
+end:
+	*size += libmapiserver_RopFastTransferDestinationConfigure_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+   \details EcDoRpc EcDoRpc_RopFastTransferDestinationPutBuffer (0x54)
+   Rop. This operation uploads a chunk of the FastTransfer stream.
+
+   Buffers may split the stream anywhere: incomplete markers and
+   values are kept by the parser until the next buffer. Objects are
+   written to the backend as soon as their end marker is received, so
+   the memory used does not depend on the number of messages.
+
+   The streams uploaded here do not carry a terminal marker:
+   TransferStatus_Done is reported when the buffer ends right after
+   the end marker of a top-level object, with no partial data left in
+   the parser. Any other buffer is reported as TransferStatus_Partial.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the FastTransferDestinationPutBuffer EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the FastTransferDestinationPutBuffer EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFastTransferDestinationPutBuffer(TALLOC_CTX *mem_ctx,
+								     struct emsmdbp_context *emsmdbp_ctx,
+								     struct EcDoRpc_MAPI_REQ *mapi_req,
+								     struct EcDoRpc_MAPI_REPL *mapi_repl,
+								     uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS					retval;
+	struct mapi_handles				*object_handle = NULL;
+	struct emsmdbp_object				*object = NULL;
+	struct FastTransferDestinationPutBuffer_req	*request;
+	struct FastTransferDestinationPutBuffer_repl	*response;
+	struct oxcfxics_dest_data			*dest;
+	DATA_BLOB					buffer;
+	uint32_t					handle_id;
+	void						*data;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCFXICS] FastTransferDestinationPutBuffer (0x54)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_FastTransferDestinationPutBuffer;
+	response = &mapi_repl->u.mapi_FastTransferDestinationPutBuffer;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+
+	/* Step 1. Retrieve object handle */
+	handle_id = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle_id, &object_handle);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle_id, mapi_req->handle_idx));
+		goto end;
+	}
+
+	mapi_handles_get_private_data(object_handle, &data);
+	object = (struct emsmdbp_object *) data;
+	if (!object || object->type != EMSMDBP_OBJECT_FTCONTEXT || !object->object.ftcontext->dest_data) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  object not found or not a FastTransfer destination context\n"));
+		goto end;
+	}
+	dest = (struct oxcfxics_dest_data *) object->object.ftcontext->dest_data;
+
+	/* Step 2. Feed the parser */
+	if (dest->error == MAPI_E_SUCCESS) {
+		buffer = request->TransferBuffer;
+		dest->error = fxparser_parse(dest->parser, &buffer);
+		dest->buffers++;
+		dest->bytes += request->TransferBuffer.length;
+	}
+
+	/* Step 3. Write the properties of the target object and report progress */
+	if (dest->error == MAPI_E_SUCCESS && dest->depth == 1) {
+		dest->error = oxcfxics_dest_flush_level(dest, dest->levels);
+	}
+
+	if (dest->error != MAPI_E_SUCCESS) {
+		DEBUG(5, ("  FastTransfer upload failed: 0x%.8x\n", dest->error));
+		mapi_repl->error_code = dest->error;
+		goto end;
+	}
+
+	response->TransferStatus = (dest->depth == 1 && dest->end_marker && fxparser_is_idle(dest->parser))
+		? TransferStatus_Done : TransferStatus_Partial;
+	response->InProgressCount = dest->messages & 0xFFFF;
+	response->TotalStepCount = response->InProgressCount;
+	response->Reserved = 0;
+	response->BufferUsedCount = request->TransferBuffer.length;
+
+	DEBUG(5, ("  %u messages, %"PRIu64" bytes received\n", dest->messages, dest->bytes));
+
+end:
+	*size += libmapiserver_RopFastTransferDestinationPutBuffer_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
 /**
    \details EcDoRpc EcDoRpc_RopSyncConfigure (0x70) Rop.
 
@@ -1589,3 +1589,129 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopOpenEmbeddedMessage(TALLOC_CTX *mem_ctx,
 
 	return MAPI_E_SUCCESS;	
 }
+
+
+/**
+   \details EcDoRpc SetReadFlags (0x66) Rop. This operation sets or
+   clears the read flag on several messages of a folder at once.
+
+   The messages are updated with a single mapistore operation and the
+   change numbers of the read state changes are allocated in one batch.
+   WantAsynchronous is ignored: the operation always completes before
+   the response is sent.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the SetReadFlags EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the SetReadFlags EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSetReadFlags(TALLOC_CTX *mem_ctx,
+						 struct emsmdbp_context *emsmdbp_ctx,
+						 struct EcDoRpc_MAPI_REQ *mapi_req,
+						 struct EcDoRpc_MAPI_REPL *mapi_repl,
+						 uint32_t *handles, uint16_t *size)
+{
+	struct SetReadFlags_req		*request;
+	struct SetReadFlags_repl	*response;
+	enum MAPISTATUS			retval;
+	enum mapistore_error		ret;
+	uint32_t			handle;
+	struct mapi_handles		*rec = NULL;
+	struct emsmdbp_object		*folder_object = NULL;
+	struct UI8Array_r		*cns = NULL;
+	uint32_t			contextID;
+	uint32_t			count;
+	void				*data;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCMSG] SetReadFlags (0x66)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_SetReadFlags;
+	response = &mapi_repl->u.mapi_SetReadFlags;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	response->PartialCompletion = false;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &data);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
+		goto end;
+	}
+
+	folder_object = (struct emsmdbp_object *) data;
+	if (!folder_object || folder_object->type != EMSMDBP_OBJECT_FOLDER) {
+		DEBUG(5, ("  no object or object is not a folder\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	if (!emsmdbp_is_mapistore(folder_object)) {
+		DEBUG(5, ("  folder is not in mapistore\n"));
+		mapi_repl->error_code = MAPI_E_NO_SUPPORT;
+		goto end;
+	}
+
+	contextID = emsmdbp_get_contextID(folder_object);
+
+	/* A MessageIdCount of 0 applies the flags to every message of the folder */
+	if (request->MessageIdCount) {
+		count = request->MessageIdCount;
+	} else {
+		ret = mapistore_folder_get_child_count(emsmdbp_ctx->mstore_ctx, contextID, folder_object->backend_object,
+						       MAPISTORE_MESSAGE_TABLE, &count);
+		if (ret != MAPISTORE_SUCCESS) {
+			mapi_repl->error_code = mapistore_error_to_mapi(ret);
+			goto end;
+		}
+	}
+	if (!count) {
+		goto end;
+	}
+
+	/* Only read state changes are given a change number, and only
+	   backends updating the folder in a single call use them */
+	if (!(request->ReadFlags & (GENERATE_RECEIPT_ONLY|CLEAR_RN_PENDING|CLEAR_NRN_PENDING))
+	    && mapistore_folder_has_set_read_flags(emsmdbp_ctx->mstore_ctx, contextID)) {
+		retval = openchangedb_get_new_changeNumbers(emsmdbp_ctx->oc_ctx, mem_ctx, count, &cns);
+		if (retval) {
+			mapi_repl->error_code = retval;
+			goto end;
+		}
+	}
+
+	ret = mapistore_folder_set_read_flags(emsmdbp_ctx->mstore_ctx, contextID, folder_object->backend_object,
+					      request->ReadFlags, request->MessageIdCount,
+					      request->MessageIdCount ? request->MessageIds : NULL, cns);
+	if (ret != MAPISTORE_SUCCESS) {
+		DEBUG(5, ("  unable to update every message: %s\n", mapistore_errstr(ret)));
+		response->PartialCompletion = true;
+	}
+
+end:
+	*size += libmapiserver_RopSetReadFlags_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
@@ -107,7 +107,6 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopRegisterNotification(TALLOC_CTX *mem_ctx,
         /* we attach the subscription to the session object.
            note: a mapistore_subscription can exist without a corresponding emsmdbp_object (tables) */
         subscription_list = talloc_zero(emsmdbp_ctx->mstore_ctx, struct mapistore_subscription_list);
-        DLIST_ADD(emsmdbp_ctx->mstore_ctx->subscriptions, subscription_list);
 
         subscription_parameters.folder_id = mapi_req->u.mapi_RegisterNotification.FolderId.ID;
         subscription_parameters.object_id = mapi_req->u.mapi_RegisterNotification.MessageId.ID;
@@ -119,8 +118,12 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopRegisterNotification(TALLOC_CTX *mem_ctx,
 						  mapi_req->u.mapi_RegisterNotification.NotificationFlags,
 						  &subscription_parameters);
         subscription_list->subscription = subscription;
-
-        subscription_object->object.subscription->subscription_list = subscription_list;
+        if (mapistore_add_subscription(emsmdbp_ctx->mstore_ctx, subscription_list) == MAPISTORE_SUCCESS) {
+                subscription_object->object.subscription->subscription_list = subscription_list;
+        }
+        else {
+                talloc_free(subscription_list);
+        }
 
 end:
 	*size += libmapiserver_RopRegisterNotification_size();
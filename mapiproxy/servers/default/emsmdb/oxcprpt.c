@@ -1105,6 +1105,435 @@ end:
 	return MAPI_E_SUCCESS;
 }
 
+
+/**
+   \details EcDoRpc CopyToStream (0x3a) Rop. This operation copies a
+   number of bytes from the current position of the source stream to
+   the current position of the destination stream.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the CopyToStream EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the CopyToStream EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopCopyToStream(TALLOC_CTX *mem_ctx,
+						 struct emsmdbp_context *emsmdbp_ctx,
+						 struct EcDoRpc_MAPI_REQ *mapi_req,
+						 struct EcDoRpc_MAPI_REPL *mapi_repl,
+						 uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*rec = NULL;
+	void				*private_data;
+	struct emsmdbp_object		*source_object;
+	struct emsmdbp_object		*dest_object;
+	struct CopyToStream_req		*request;
+	struct emsmdbp_stream		*source_stream;
+	uint32_t			handle, byte_count;
+	DATA_BLOB			buffer;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCPRPT] CopyToStream (0x3a)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_CopyToStream;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->u.mapi_CopyToStream.ReadByteCount = 0;
+	mapi_repl->u.mapi_CopyToStream.WrittenByteCount = 0;
+
+	/* Step 1. Retrieve the source stream */
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	source_object = (struct emsmdbp_object *) private_data;
+	if (!source_object || source_object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid source object\n"));
+		goto end;
+	}
+
+	/* Step 2. Retrieve the destination stream */
+	handle = handles[request->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, request->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	dest_object = (struct emsmdbp_object *) private_data;
+	if (!dest_object || dest_object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid destination object\n"));
+		goto end;
+	}
+
+	if (!dest_object->object.stream->read_write) {
+		mapi_repl->error_code = MAPI_E_NO_ACCESS;
+		goto end;
+	}
+
+	/* Step 3. Copy the bytes directly from one stream buffer to the other */
+	source_stream = &source_object->object.stream->stream;
+	byte_count = source_stream->buffer.length - source_stream->position;
+	if (request->ByteCount < byte_count) {
+		byte_count = request->ByteCount;
+	}
+	buffer = emsmdbp_stream_read_buffer(source_stream, byte_count);
+	if (buffer.length > 0) {
+		/* the source buffer may be reallocated by the write */
+		if (source_object == dest_object) {
+			buffer.data = talloc_memdup(mem_ctx, buffer.data, buffer.length);
+		}
+		emsmdbp_stream_write_buffer(dest_object->object.stream, &dest_object->object.stream->stream, buffer);
+		dest_object->object.stream->needs_commit = true;
+	}
+
+	mapi_repl->u.mapi_CopyToStream.ReadByteCount = buffer.length;
+	mapi_repl->u.mapi_CopyToStream.WrittenByteCount = buffer.length;
+
+end:
+	*size += libmapiserver_RopCopyToStream_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc CloneStream (0x3b) Rop. This operation creates a
+   new stream object with the same content and seek position as an
+   existing one.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the CloneStream EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the CloneStream EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopCloneStream(TALLOC_CTX *mem_ctx,
+						struct emsmdbp_context *emsmdbp_ctx,
+						struct EcDoRpc_MAPI_REQ *mapi_req,
+						struct EcDoRpc_MAPI_REPL *mapi_repl,
+						uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*rec = NULL;
+	struct mapi_handles		*clone_rec = NULL;
+	void				*private_data;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object		*clone_object;
+	struct emsmdbp_object_stream	*stream;
+	uint32_t			handle;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCPRPT] CloneStream (0x3b)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->u.mapi_CloneStream.handle_idx;
+
+	/* Step 1. Retrieve the stream to clone */
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	object = (struct emsmdbp_object *) private_data;
+	if (!object || object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid object\n"));
+		goto end;
+	}
+
+	/* Step 2. Create the clone as a sibling of the original stream,
+	   so that it survives the release of the original handle */
+	clone_object = emsmdbp_object_stream_init(NULL, emsmdbp_ctx, object->parent_object);
+	if (!clone_object) {
+		mapi_repl->error_code = MAPI_E_NOT_ENOUGH_RESOURCES;
+		goto end;
+	}
+
+	stream = object->object.stream;
+	clone_object->object.stream->property = stream->property;
+	clone_object->object.stream->read_write = stream->read_write;
+	/* Uncommitted writes are part of the cloned content and must be
+	   committed when the clone is released */
+	clone_object->object.stream->needs_commit = stream->needs_commit;
+	clone_object->object.stream->stream.position = stream->stream.position;
+	clone_object->object.stream->stream.buffer.length = stream->stream.buffer.length;
+	if (stream->stream.buffer.length) {
+		clone_object->object.stream->stream.buffer.data = talloc_memdup(clone_object->object.stream, stream->stream.buffer.data, stream->stream.buffer.length);
+	}
+	else {
+		clone_object->object.stream->stream.buffer.data = talloc_zero(clone_object->object.stream, uint8_t);
+	}
+
+	retval = mapi_handles_add(emsmdbp_ctx->handles_ctx, rec->parent_handle, &clone_rec);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		talloc_free(clone_object);
+		goto end;
+	}
+	(void) talloc_reference(clone_rec, clone_object);
+	handles[mapi_repl->handle_idx] = clone_rec->handle;
+	mapi_handles_set_private_data(clone_rec, clone_object);
+	talloc_free(clone_object);
+
+end:
+	*size += libmapiserver_RopCloneStream_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc LockRegionStream (0x5b) Rop. This operation locks a
+   range of bytes in a stream.
+
+   Stream objects hold a private copy of the property value, which is
+   only written back on commit. No other stream can observe the locked
+   range, so locks are validated and accepted without being recorded.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the LockRegionStream EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the LockRegionStream EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopLockRegionStream(TALLOC_CTX *mem_ctx,
+						     struct emsmdbp_context *emsmdbp_ctx,
+						     struct EcDoRpc_MAPI_REQ *mapi_req,
+						     struct EcDoRpc_MAPI_REPL *mapi_repl,
+						     uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*rec = NULL;
+	void				*private_data;
+	struct emsmdbp_object		*object;
+	uint32_t			handle;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCPRPT] LockRegionStream (0x5b)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	object = (struct emsmdbp_object *) private_data;
+	if (!object || object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid object\n"));
+		goto end;
+	}
+
+	DEBUG(5, ("  region %"PRIu64"+%"PRIu64" (flags: 0x%x)\n", mapi_req->u.mapi_LockRegionStream.RegionOffset,
+		  mapi_req->u.mapi_LockRegionStream.RegionSize, mapi_req->u.mapi_LockRegionStream.LockFlags));
+
+end:
+	*size += libmapiserver_RopLockRegionStream_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc UnlockRegionStream (0x5c) Rop. This operation
+   unlocks a range of bytes previously locked with LockRegionStream.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the UnlockRegionStream EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the UnlockRegionStream EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopUnlockRegionStream(TALLOC_CTX *mem_ctx,
+						       struct emsmdbp_context *emsmdbp_ctx,
+						       struct EcDoRpc_MAPI_REQ *mapi_req,
+						       struct EcDoRpc_MAPI_REPL *mapi_repl,
+						       uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*rec = NULL;
+	void				*private_data;
+	struct emsmdbp_object		*object;
+	uint32_t			handle;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCPRPT] UnlockRegionStream (0x5c)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	object = (struct emsmdbp_object *) private_data;
+	if (!object || object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid object\n"));
+		goto end;
+	}
+
+end:
+	*size += libmapiserver_RopUnlockRegionStream_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc WriteAndCommitStream (0x90) Rop. This operation
+   writes bytes to a stream and commits the stream to its parent
+   object in a single round trip.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the WriteAndCommitStream EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the WriteAndCommitStream EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopWriteAndCommitStream(TALLOC_CTX *mem_ctx,
+							 struct emsmdbp_context *emsmdbp_ctx,
+							 struct EcDoRpc_MAPI_REQ *mapi_req,
+							 struct EcDoRpc_MAPI_REPL *mapi_repl,
+							 uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*rec = NULL;
+	void				*private_data;
+	struct emsmdbp_object		*object;
+	uint32_t			handle;
+	struct WriteAndCommitStream_req	*request;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCPRPT] WriteAndCommitStream (0x90)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->u.mapi_WriteAndCommitStream.WrittenSize = 0;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &rec);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(rec, &private_data);
+	object = (struct emsmdbp_object *) private_data;
+	if (!object || object->type != EMSMDBP_OBJECT_STREAM) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  invalid object\n"));
+		goto end;
+	}
+
+	if (!object->object.stream->read_write) {
+		mapi_repl->error_code = MAPI_E_NO_ACCESS;
+		goto end;
+	}
+
+	request = &mapi_req->u.mapi_WriteAndCommitStream;
+	if (request->data.length > 0) {
+		emsmdbp_stream_write_buffer(object->object.stream, &object->object.stream->stream, request->data);
+		mapi_repl->u.mapi_WriteAndCommitStream.WrittenSize = request->data.length;
+	}
+
+	object->object.stream->needs_commit = true;
+	emsmdbp_object_stream_commit(object);
+
+end:
+	*size += libmapiserver_RopWriteAndCommitStream_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
 /**
    \details EcDoRpc GetPropertyIdsFromNames (0x56) Rop. This operation
    gets property IDs for specified property names.
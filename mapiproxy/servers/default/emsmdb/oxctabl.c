@@ -125,6 +125,530 @@ end:
 }
 
 
+/**
+   \details Encode a table bookmark as returned to the client: the
+   bookmark identifier, as a little-endian uint32_t
+
+   \param mem_ctx pointer to the memory context
+   \param bookmark_id the bookmark identifier
+   \param bookmark pointer to the bookmark blob to fill
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_push_bookmark(TALLOC_CTX *mem_ctx, uint32_t bookmark_id,
+					     struct SBinary_short *bookmark)
+{
+	bookmark->lpb = talloc_array(mem_ctx, uint8_t, sizeof (uint32_t));
+	OPENCHANGE_RETVAL_IF(!bookmark->lpb, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	bookmark->cb = sizeof (uint32_t);
+	bookmark->lpb[0] = bookmark_id & 0xFF;
+	bookmark->lpb[1] = (bookmark_id >> 8) & 0xFF;
+	bookmark->lpb[2] = (bookmark_id >> 16) & 0xFF;
+	bookmark->lpb[3] = (bookmark_id >> 24) & 0xFF;
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Decode a table bookmark sent by the client
+
+   \param bookmark pointer to the bookmark blob
+   \param bookmark_id pointer to the bookmark identifier to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI_E_INVALID_BOOKMARK
+ */
+static enum MAPISTATUS oxctabl_pull_bookmark(struct SBinary_short *bookmark, uint32_t *bookmark_id)
+{
+	OPENCHANGE_RETVAL_IF(bookmark->cb != sizeof (uint32_t) || !bookmark->lpb, MAPI_E_INVALID_BOOKMARK, NULL);
+
+	*bookmark_id = bookmark->lpb[0] | (bookmark->lpb[1] << 8) |
+		(bookmark->lpb[2] << 16) | ((uint32_t)bookmark->lpb[3] << 24);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Apply a sort order to the backend table and move its
+   cursor back to the beginning. The categorized view is left to the
+   caller.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param criteria pointer to the sort order to apply
+   \param status pointer to the TableStatus to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_sort_backend(struct emsmdbp_context *emsmdbp_ctx,
+					    struct emsmdbp_object *object,
+					    struct SSortOrderSet *criteria,
+					    uint8_t *status)
+{
+	struct emsmdbp_object_table	*table = object->object.table;
+	enum MAPISTATUS			retval;
+
+        /* we reset the cursor to the beginning of the table */
+        table->numerator = 0;
+
+	/* sorting the table invalidates bookmarks */
+	emsmdbp_object_table_reset_bookmarks(object);
+
+	*status = TBLSTAT_COMPLETE;
+	table->status = TBLSTAT_COMPLETE;
+
+	/* If parent folder has a mapistore context */
+	if (emsmdbp_is_mapistore(object)) {
+		retval = mapistore_table_set_sort_order(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(object), object->backend_object, criteria, status);
+	} else if (table->search) {
+		retval = emsmdbp_search_table_set_sort_order(emsmdbp_ctx, object, criteria);
+	} else {
+		/* Parent folder doesn't have any mapistore context associated */
+		retval = openchangedb_table_set_sort_order(object->backend_object, criteria);
+	}
+
+	return retval;
+}
+
+
+/**
+   \details Apply a sort order to a table and move its cursor back to
+   the beginning
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param criteria pointer to the sort order to apply
+   \param status pointer to the TableStatus to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_sort_table(struct emsmdbp_context *emsmdbp_ctx,
+					  struct emsmdbp_object *object,
+					  struct SSortOrderSet *criteria,
+					  uint8_t *status)
+{
+	enum MAPISTATUS			retval;
+
+	retval = oxctabl_sort_backend(emsmdbp_ctx, object, criteria, status);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* group the sorted rows when categories are requested */
+	return emsmdbp_category_table_init(emsmdbp_ctx, object, criteria);
+}
+
+
+/**
+   \details Copy a restriction
+
+   Restrictions pulled from a ROP request only live until the reply is
+   sent.
+
+   \param mem_ctx pointer to the memory context
+   \param res pointer to the restriction to copy
+
+   \return Allocated copy of the restriction on success, otherwise NULL
+ */
+static struct mapi_SRestriction *oxctabl_copy_restriction(TALLOC_CTX *mem_ctx,
+							  struct mapi_SRestriction *res)
+{
+	struct mapi_SRestriction	*copy;
+	enum ndr_err_code		ndr_err;
+	DATA_BLOB			blob;
+
+	copy = talloc_zero(mem_ctx, struct mapi_SRestriction);
+	if (!copy) return NULL;
+
+	ndr_err = ndr_push_struct_blob(&blob, copy, res, (ndr_push_flags_fn_t)ndr_push_mapi_SRestriction);
+	if (NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		ndr_err = ndr_pull_struct_blob(&blob, copy, copy, (ndr_pull_flags_fn_t)ndr_pull_mapi_SRestriction);
+	}
+	talloc_free(blob.data);
+	if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		talloc_free(copy);
+		return NULL;
+	}
+
+	return copy;
+}
+
+
+/**
+   \details Apply a restriction to the backend table and update its
+   row count. The categorized view is left to the caller.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param res pointer to the restriction to apply
+   \param status pointer to the TableStatus to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_restrict_backend(struct emsmdbp_context *emsmdbp_ctx,
+						struct emsmdbp_object *object,
+						struct mapi_SRestriction *res,
+						uint8_t *status)
+{
+	struct emsmdbp_object_table	*table = object->object.table;
+	enum MAPISTATUS			retval;
+	uint32_t			contextID;
+
+	*status = TBLSTAT_COMPLETE;
+	table->status = TBLSTAT_COMPLETE;
+	table->restricted = true;
+
+	/* keep the committed restriction, FindRow may have to restore it */
+	talloc_free(table->restriction);
+	table->restriction = oxctabl_copy_restriction(table, res);
+	OPENCHANGE_RETVAL_IF(!table->restriction, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+
+	/* If parent folder has a mapistore context */
+	if (emsmdbp_is_mapistore(object)) {
+		contextID = emsmdbp_get_contextID(object);
+		retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, res, status);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+		mapistore_table_get_row_count(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, MAPISTORE_PREFILTERED_QUERY, &table->denominator);
+	} else if (table->search) {
+		retval = emsmdbp_search_table_set_restrictions(emsmdbp_ctx, object, res);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+	} else {
+		/* Parent folder doesn't have any mapistore context associated */
+		retval = openchangedb_table_set_restrictions(object->backend_object, res);
+		OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+		openchangedb_table_get_row_count(object->backend_object, emsmdbp_ctx->oc_ctx, &table->denominator);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Apply a restriction to a table and update its row count
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param res pointer to the restriction to apply
+   \param status pointer to the TableStatus to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_restrict_table(struct emsmdbp_context *emsmdbp_ctx,
+					      struct emsmdbp_object *object,
+					      struct mapi_SRestriction *res,
+					      uint8_t *status)
+{
+	enum MAPISTATUS			retval;
+
+	retval = oxctabl_restrict_backend(emsmdbp_ctx, object, res, status);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* the categorized view is built from the restricted rows */
+	return emsmdbp_category_table_rebuild(emsmdbp_ctx, object);
+}
+
+
+/* number of backend rows grouped into the categorized view by each
+   run of an asynchronous operation */
+#define	OXCTABL_ASYNC_ROWS	256
+
+/**
+   \details Retrieve the TableStatus of a table. An asynchronous
+   operation is reported until its categorized view has been built.
+
+   \param table pointer to the table
+
+   \return the TableStatus of the table
+ */
+static uint8_t oxctabl_async_status(struct emsmdbp_object_table *table)
+{
+	struct emsmdbp_table_async	*async = table->async;
+
+	if (!async) return table->status;
+
+	/* the restriction runs first */
+	if (async->restriction) return TBLSTAT_RESTRICTING;
+	if (async->sort) return TBLSTAT_SORTING;
+
+	return async->status;
+}
+
+
+/**
+   \details Drop the pending asynchronous operations of a table. An
+   operation which has started to run is never dropped.
+
+   \param table pointer to the table
+   \param sort whether a pending sort must be dropped
+   \param restriction whether a pending restriction must be dropped
+ */
+static void oxctabl_async_cancel(struct emsmdbp_object_table *table, bool sort, bool restriction)
+{
+	struct emsmdbp_table_async	*async = table->async;
+
+	if (!async || async->started) return;
+
+	if (sort && async->sort) {
+		talloc_free(async->sort);
+		async->sort = NULL;
+	}
+	if (restriction && async->restriction) {
+		talloc_free(async->restriction);
+		async->restriction = NULL;
+	}
+
+	if (!async->sort && !async->restriction) {
+		talloc_free(async->te);
+		talloc_free(async);
+		table->async = NULL;
+	}
+}
+
+
+/**
+   \details Run the next step of the asynchronous operations of a
+   table: the pending restriction, then the pending sort, each one
+   followed by the build of the categorized view, max_rows backend rows
+   at a time.
+
+   The backend restriction and sort are run in a single step: the
+   mapistore and openchangedb table interfaces cannot be interrupted.
+
+   \param async pointer to the asynchronous operations
+   \param max_rows the maximum number of backend rows read by the step
+   \param donep pointer to the boolean set when no work is left
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_async_step(struct emsmdbp_table_async *async,
+					  uint32_t max_rows,
+					  bool *donep)
+{
+	struct emsmdbp_object		*object = async->table_object;
+	struct emsmdbp_object_table	*table = object->object.table;
+	enum MAPISTATUS			retval;
+	uint8_t				status;
+	bool				done;
+
+	*donep = false;
+	async->started = true;
+
+	if (async->build) {
+		retval = emsmdbp_category_build_step(async->emsmdbp_ctx, object, async->build, max_rows, &done);
+		if (retval) {
+			table->status = (async->status == TBLSTAT_SORTING) ? TBLSTAT_SORT_ERROR : TBLSTAT_RESTRICT_ERROR;
+			return retval;
+		}
+		if (done) {
+			talloc_free(async->build);
+			async->build = NULL;
+		}
+	} else if (async->restriction) {
+		DEBUG(5, ("exchange_emsmdb: [OXCTABL] running asynchronous restriction on table %p\n", object));
+		async->status = TBLSTAT_RESTRICTING;
+		retval = oxctabl_restrict_backend(async->emsmdbp_ctx, object, async->restriction, &status);
+		talloc_free(async->restriction);
+		async->restriction = NULL;
+		/* a pending sort builds a new categorized view anyway */
+		if (retval == MAPI_E_SUCCESS && !async->sort) {
+			retval = emsmdbp_category_table_rebuild_start(async, async->emsmdbp_ctx, object, &async->build);
+		}
+		if (retval) {
+			table->status = TBLSTAT_RESTRICT_ERROR;
+			return retval;
+		}
+	} else if (async->sort) {
+		DEBUG(5, ("exchange_emsmdb: [OXCTABL] running asynchronous sort on table %p\n", object));
+		async->status = TBLSTAT_SORTING;
+		retval = oxctabl_sort_backend(async->emsmdbp_ctx, object, async->sort, &status);
+		if (retval == MAPI_E_SUCCESS) {
+			retval = emsmdbp_category_table_init_start(async, async->emsmdbp_ctx, object, async->sort, &async->build);
+		}
+		talloc_free(async->sort);
+		async->sort = NULL;
+		if (retval) {
+			table->status = TBLSTAT_SORT_ERROR;
+			return retval;
+		}
+	}
+
+	*donep = (!async->restriction && !async->sort && !async->build);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Complete the asynchronous operations of a table which have
+   started to run, so the caller never sees a backend table and a
+   categorized view which are out of step. Operations which have not
+   started yet are left pending.
+
+   \param table pointer to the table
+ */
+static void oxctabl_async_complete(struct emsmdbp_object_table *table)
+{
+	struct emsmdbp_table_async	*async = table->async;
+	enum MAPISTATUS			retval;
+	bool				done;
+
+	if (!async || !async->started) return;
+
+	do {
+		retval = oxctabl_async_step(async, OXCTABL_ASYNC_ROWS, &done);
+	} while (retval == MAPI_E_SUCCESS && !done);
+
+	talloc_free(async->te);
+	talloc_free(async);
+	table->async = NULL;
+}
+
+
+/**
+   \details Run the asynchronous operations of a table. This is called
+   from the connection event loop once the EcDoRpc reply which
+   requested them has been sent, and runs again from the event loop
+   until no work is left, so other requests are served in between.
+ */
+static void oxctabl_async_handler(struct tevent_context *ev,
+				  struct tevent_timer *te,
+				  struct timeval current_time,
+				  void *private_data)
+{
+	struct emsmdbp_table_async	*async = (struct emsmdbp_table_async *) private_data;
+	struct emsmdbp_object		*object = async->table_object;
+	struct emsmdbp_object_table	*table = object->object.table;
+	enum MAPISTATUS			retval;
+	bool				done;
+
+	/* the timer is released by tevent once the handler returns */
+	async->te = NULL;
+
+	retval = oxctabl_async_step(async, OXCTABL_ASYNC_ROWS, &done);
+	if (retval == MAPI_E_SUCCESS && !done) {
+		async->te = tevent_add_timer(ev, object, tevent_timeval_zero(), oxctabl_async_handler, async);
+		if (async->te) return;
+
+		DEBUG(5, ("exchange_emsmdb: [OXCTABL] unable to reschedule table %p, completing synchronously\n", object));
+		oxctabl_async_complete(table);
+		return;
+	}
+
+	talloc_free(async);
+	table->async = NULL;
+}
+
+
+/**
+   \details Defer a sort or a restriction of a table to the connection
+   event loop. A sort and a restriction may be pending together; the
+   restriction is applied first.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param sort pointer to the sort order to apply or NULL
+   \param res pointer to the restriction to apply or NULL
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_async_schedule(struct emsmdbp_context *emsmdbp_ctx,
+					      struct emsmdbp_object *object,
+					      struct SSortOrderSet *sort,
+					      struct mapi_SRestriction *res)
+{
+	struct emsmdbp_object_table	*table = object->object.table;
+	struct emsmdbp_table_async	*async;
+
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx->ev, MAPI_E_NO_SUPPORT, NULL);
+
+	async = table->async;
+	if (!async) {
+		async = talloc_zero(object, struct emsmdbp_table_async);
+		OPENCHANGE_RETVAL_IF(!async, MAPI_E_NOT_ENOUGH_MEMORY, NULL);
+		async->emsmdbp_ctx = emsmdbp_ctx;
+		async->table_object = object;
+		async->te = tevent_add_timer(emsmdbp_ctx->ev, object, tevent_timeval_zero(),
+					     oxctabl_async_handler, async);
+		OPENCHANGE_RETVAL_IF(!async->te, MAPI_E_CALL_FAILED, async);
+		table->async = async;
+	}
+
+	/* The request only lives until the reply is sent: keep a copy */
+	if (sort) {
+		talloc_free(async->sort);
+		async->sort = talloc_zero(async, struct SSortOrderSet);
+		if (!async->sort) {
+			oxctabl_async_cancel(table, false, false);
+			return MAPI_E_NOT_ENOUGH_MEMORY;
+		}
+		*async->sort = *sort;
+		async->sort->aSort = talloc_memdup(async->sort, sort->aSort, sort->cSorts * sizeof (struct SSortOrder));
+	}
+	if (res) {
+		talloc_free(async->restriction);
+		async->restriction = oxctabl_copy_restriction(async, res);
+		if (!async->restriction) {
+			oxctabl_async_cancel(table, false, false);
+			return MAPI_E_INVALID_PARAMETER;
+		}
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the table object of a ROP request. Asynchronous
+   operations which have started to run on the table are completed.
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the EcDoRpc_MAPI_REQ structure
+   \param handles pointer to the MAPI handles array
+   \param objectp pointer to the table object to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_get_table(struct emsmdbp_context *emsmdbp_ctx,
+					 struct EcDoRpc_MAPI_REQ *mapi_req,
+					 uint32_t *handles,
+					 struct emsmdbp_object **objectp)
+{
+	enum MAPISTATUS		retval;
+	struct mapi_handles	*parent;
+	struct emsmdbp_object	*object;
+	uint32_t		handle;
+	void			*data = NULL;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		return MAPI_E_INVALID_OBJECT;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	if (retval) {
+		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
+		return retval;
+	}
+
+	/* Ensure referring object exists and is a table */
+	object = (struct emsmdbp_object *) data;
+	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		DEBUG(5, ("  missing object or not table\n"));
+		return MAPI_E_INVALID_OBJECT;
+	}
+
+	oxctabl_async_complete(object->object.table);
+
+	*objectp = object;
+
+	return MAPI_E_SUCCESS;
+}
+
+
 /**
    \details EcDoRpc SortTable (0x13) Rop. This operation defines the
    order of rows of a table based on sort criteria.
@@ -169,12 +693,6 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopSortTable(TALLOC_CTX *mem_ctx,
 	mapi_repl->error_code = MAPI_E_SUCCESS;
 	mapi_repl->u.mapi_SortTable.TableStatus = TBLSTAT_COMPLETE;
 
-	if ((mapi_req->u.mapi_SortTable.SortTableFlags & TBL_ASYNC)) {
-                DEBUG(5, ("  requested async operation -> failure\n"));
-                mapi_repl->error_code = MAPI_E_UNKNOWN_FLAGS;
-                goto end;
-        }
-
 	handle = handles[mapi_req->handle_idx];
 	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
 	if (retval) {
@@ -208,35 +726,32 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopSortTable(TALLOC_CTX *mem_ctx,
 		goto end;
 	}
 
-	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
-
-        /* we reset the cursor to the beginning of the table */
-        table->numerator = 0;
+	request = &mapi_req->u.mapi_SortTable;
 
-        /* TODO: we should invalidate current bookmarks on the table */
+	/* operations which have started to run are never merged or dropped */
+	oxctabl_async_complete(table);
 
-	/* If parent folder has a mapistore context */
-	request = &mapi_req->u.mapi_SortTable;
-	if (emsmdbp_is_mapistore(object)) {
-		status = TBLSTAT_COMPLETE;
-		retval = mapistore_table_set_sort_order(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(object), object->backend_object, &request->lpSortCriteria, &status);
-                if (retval) {
-			mapi_repl->error_code = retval;
-			goto end;
-		}
-		mapi_repl->u.mapi_SortTable.TableStatus = status;
-	} else {
-		/* Parent folder doesn't have any mapistore context associated */
-		status = TBLSTAT_COMPLETE;
-		mapi_repl->u.mapi_SortTable.TableStatus = status;
-		retval = openchangedb_table_set_sort_order(object->backend_object, &request->lpSortCriteria);
-		if (retval) {
-			mapi_repl->error_code = retval;
+	/* Asynchronous sort: the committed sort order is kept until it runs */
+	if ((request->SortTableFlags & TBL_ASYNC)) {
+		retval = oxctabl_async_schedule(emsmdbp_ctx, object, &request->lpSortCriteria, NULL);
+		if (retval == MAPI_E_SUCCESS) {
+			mapi_repl->u.mapi_SortTable.TableStatus = TBLSTAT_SORTING;
 			goto end;
 		}
+		DEBUG(5, ("  unable to defer the sort (0x%x), sorting synchronously\n", retval));
 	}
-        
-end:
+
+	/* A synchronous sort supersedes a pending asynchronous one */
+	oxctabl_async_cancel(table, true, false);
+
+	retval = oxctabl_sort_table(emsmdbp_ctx, object, &request->lpSortCriteria, &status);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	mapi_repl->u.mapi_SortTable.TableStatus = status;
+
+end:
 	*size += libmapiserver_RopSortTable_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
@@ -263,16 +778,928 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopRestrict(TALLOC_CTX *mem_ctx,
 					     struct EcDoRpc_MAPI_REPL *mapi_repl,
 					     uint32_t *handles, uint16_t *size)
 {
-	enum MAPISTATUS			retval;
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	struct Restrict_req		request;
+	uint32_t			handle;
+	void				*data = NULL;
+	uint8_t				status;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] Restrict (0x14)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+	
+	request = mapi_req->u.mapi_Restrict;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->u.mapi_Restrict.TableStatus = TBLSTAT_COMPLETE;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
+		goto end;
+	}
+	object = (struct emsmdbp_object *) data;
+
+	/* Ensure referring object exists and is a table */
+	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  missing object or not table\n"));
+		goto end;
+	}
+
+	table = object->object.table;
+	OPENCHANGE_RETVAL_IF(!table, MAPI_E_INVALID_PARAMETER, NULL);
+
+	if (table->ulType == MAPISTORE_RULE_TABLE) {
+		table->restricted = true;
+		DEBUG(5, ("  query on rules table are all faked right now\n"));
+		goto end;
+	}
+
+	/* operations which have started to run are never merged or dropped */
+	oxctabl_async_complete(table);
+
+	/* Asynchronous restriction: the committed rows are kept until it runs */
+	if ((request.RestrictFlags & TBL_ASYNC)) {
+		retval = oxctabl_async_schedule(emsmdbp_ctx, object, NULL, &request.restrictions);
+		if (retval == MAPI_E_SUCCESS) {
+			mapi_repl->u.mapi_Restrict.TableStatus = TBLSTAT_RESTRICTING;
+			goto end;
+		}
+		DEBUG(5, ("  unable to defer the restriction (0x%x), restricting synchronously\n", retval));
+	}
+
+	/* A synchronous restriction supersedes a pending asynchronous one */
+	oxctabl_async_cancel(table, false, true);
+
+	retval = oxctabl_restrict_table(emsmdbp_ctx, object, &request.restrictions, &status);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	mapi_repl->u.mapi_Restrict.TableStatus = status;
+
+end:
+	*size += libmapiserver_RopRestrict_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;	
+}
+
+
+/**
+   \details EcDoRpc QueryRows (0x15) Rop. This operation retrieves
+   rows from a table.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the QueryRows EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the QueryRows EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryRows(TALLOC_CTX *mem_ctx,
+					      struct emsmdbp_context *emsmdbp_ctx,
+					      struct EcDoRpc_MAPI_REQ *mapi_req,
+					      struct EcDoRpc_MAPI_REPL *mapi_repl,
+					      uint32_t *handles, uint16_t *size)
+{
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	struct QueryRows_req		*request;
+	struct QueryRows_repl		*response;
+	enum MAPISTATUS			retval;
+	void				*data;
+	enum MAPISTATUS			*retvals;
+	void				**data_pointers;
+	uint32_t			count, max;
+	uint32_t			handle;
+	uint32_t			i = 0;
+	uint32_t			row_start;
+	uint16_t			available;
+	bool				truncated = false;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] QueryRows (0x15)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_QueryRows;
+	response = &mapi_repl->u.mapi_QueryRows;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_NOT_FOUND;
+	
+	response->RowData.length = 0;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	if (retval) {
+		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
+		goto end;
+	}
+
+	object = (struct emsmdbp_object *) data;
+
+	/* Ensure referring object exists and is a table */
+	if (!object) {
+		DEBUG(5, ("  missing object\n"));
+		goto end;
+	}
+	if (object->type != EMSMDBP_OBJECT_TABLE) {
+		DEBUG(5, ("  unhandled object type: %d\n", object->type));
+		goto end;
+	}
+
+	table = object->object.table;
+	oxctabl_async_complete(table);
+
+	count = 0;
+	if (table->ulType == MAPISTORE_RULE_TABLE) {
+		DEBUG(5, ("  query on rules table are all faked right now\n"));
+		goto finish;
+	}
+
+	/* Ensure we are in a case which we can handle, until the featureset is complete. */
+	if (!request->ForwardRead) {
+		DEBUG(0, ("  !ForwardRead is not supported yet\n"));
+		abort();
+	}
+
+	/* Rows are returned until RowCount is reached or the ROP buffer is full */
+	available = emsmdbp_rop_buffer_available(emsmdbp_ctx, *size, SIZE_DFLT_MAPI_RESPONSE + SIZE_DFLT_ROPQUERYROWS);
+
+        /* Lookup the properties */
+	max = table->numerator + request->RowCount;
+	if (max > table->denominator) {
+		max = table->denominator;
+	}
+        for (i = table->numerator; i < max; i++) {
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, object, i, MAPISTORE_PREFILTERED_QUERY, &retvals);
+		if (data_pointers) {
+			row_start = response->RowData.length;
+			emsmdbp_fill_table_row_blob(mem_ctx, emsmdbp_ctx,
+						    &response->RowData, table->prop_count,
+						    table->properties, data_pointers, retvals);
+			talloc_free(retvals);
+			talloc_free(data_pointers);
+			/* the first row is always returned */
+			if (count && response->RowData.length > available) {
+				response->RowData.length = row_start;
+				truncated = true;
+				break;
+			}
+			count++;
+		}
+		else {
+			count = 0;
+			goto finish;
+		}
+	}
+
+finish:
+	if ((request->QueryRowsFlags & TBL_NOADVANCE) != TBL_NOADVANCE) {
+		table->numerator = i;
+	}
+
+	/* QueryRows reply parameters */
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	response->RowCount = count;
+	if (count) {
+		if ((!truncated && count < request->RowCount) || (table->numerator > (table->denominator - 2))) {
+			response->Origin = BOOKMARK_END;
+		} else {
+			response->Origin = BOOKMARK_CURRENT;
+		}
+		/* dump_data(0, response.RowData.data, response.RowData.length); */
+	} else {
+		/* useless code for the moment */
+		if (table->restricted) {
+			response->Origin = BOOKMARK_BEGINNING;	
+		}
+		else {
+			response->Origin = BOOKMARK_END;
+		}
+		response->RowData.length = 0;
+		response->RowData.data = NULL;
+		DEBUG(5, ("%s: returning empty data set\n", __location__));
+	}
+
+end:
+	*size += libmapiserver_RopQueryRows_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc GetStatus (0x16) Rop. This operation retrieves the
+   status of the asynchronous operations of a table: TBLSTAT_SORTING
+   or TBLSTAT_RESTRICTING is reported while work is left, including the
+   build of the categorized view.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the GetStatus EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the GetStatus EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetStatus(TALLOC_CTX *mem_ctx,
+					      struct emsmdbp_context *emsmdbp_ctx,
+					      struct EcDoRpc_MAPI_REQ *mapi_req,
+					      struct EcDoRpc_MAPI_REPL *mapi_repl,
+					      uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	uint32_t			handle;
+	void				*data = NULL;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] GetStatus (0x16)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->u.mapi_GetStatus.TableStatus = TBLSTAT_COMPLETE;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	object = (struct emsmdbp_object *) data;
+	if (retval || !object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  missing object or not table\n"));
+		goto end;
+	}
+
+	table = object->object.table;
+	mapi_repl->u.mapi_GetStatus.TableStatus = oxctabl_async_status(table);
+
+end:
+	*size += libmapiserver_RopGetStatus_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc QueryPosition (0x17) Rop. This operation returns
+   the location of cursor in the table.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the QueryPosition EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the QueryPosition EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryPosition(TALLOC_CTX *mem_ctx,
+						  struct emsmdbp_context *emsmdbp_ctx,
+						  struct EcDoRpc_MAPI_REQ *mapi_req,
+						  struct EcDoRpc_MAPI_REPL *mapi_repl,
+						  uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	void				*data;
+	uint32_t			handle;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] QueryPosition (0x17)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+	
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_NOT_FOUND;
+	
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	if (retval) {
+		DEBUG(5, ("  no private data or object is not a table"));
+		goto end;
+	}
+	object = (struct emsmdbp_object *) data;
+
+	/* Ensure object exists and is table type */
+	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		DEBUG(5, ("  no object or object is not a table\n"));
+		goto end;
+	}
+
+	table = object->object.table;
+	oxctabl_async_complete(table);
+
+        mapi_repl->u.mapi_QueryPosition.Numerator = table->numerator;
+	mapi_repl->u.mapi_QueryPosition.Denominator = table->denominator;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+
+end:
+	*size += libmapiserver_RopQueryPosition_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc SeekRow (0x18) Rop. This operation moves the
+   cursor to a specific position in a table.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the SeekRow EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the SeekRow EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSeekRow(TALLOC_CTX *mem_ctx,
+					    struct emsmdbp_context *emsmdbp_ctx,
+					    struct EcDoRpc_MAPI_REQ *mapi_req,
+					    struct EcDoRpc_MAPI_REPL *mapi_repl,
+					    uint32_t *handles, uint16_t *size)
+{
+	uint32_t			handle;
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	void				*data;
+        int32_t                         next_position;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] SeekRow (0x18)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+	
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->u.mapi_SeekRow.HasSoughtLess = 0;
+	mapi_repl->u.mapi_SeekRow.RowsSought = 0;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
+		goto end;
+	}
+	object = (struct emsmdbp_object *) data;
+
+	/* Ensure object exists and is table type */
+	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  no object or object is not a table\n"));
+		goto end;
+	}
+
+	/* We don't handle backward/forward yet , just go through the
+	 * entire table, nor do we handle bookmarks */
+
+	table = object->object.table;
+	oxctabl_async_complete(table);
+	if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_BEGINNING) {
+                next_position = mapi_req->u.mapi_SeekRow.offset;
+	}
+	else if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_CURRENT) {
+                next_position = table->numerator + mapi_req->u.mapi_SeekRow.offset;
+	}
+	else if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_END) {
+                next_position = table->denominator - 1 + mapi_req->u.mapi_SeekRow.offset;
+	}
+	else {
+                next_position = 0;
+		mapi_repl->error_code = MAPI_E_NOT_FOUND;
+		DEBUG(5, ("  unhandled 'origin' type: %d\n", mapi_req->u.mapi_SeekRow.origin));
+	}
+
+        if (mapi_repl->error_code == MAPI_E_SUCCESS) {
+                if (next_position < 0) {
+                        next_position = 0;
+                        mapi_repl->u.mapi_SeekRow.HasSoughtLess = 1;
+                }
+                else if (next_position >= table->denominator) {
+                        next_position = table->denominator - 1;
+                        mapi_repl->u.mapi_SeekRow.HasSoughtLess = 1;
+                }
+                if (mapi_req->u.mapi_SeekRow.WantRowMovedCount) {
+                        mapi_repl->u.mapi_SeekRow.RowsSought = (next_position - table->numerator);
+                }
+                else {
+                        mapi_repl->u.mapi_SeekRow.RowsSought = 0;
+                }
+                table->numerator = next_position;
+        }
+
+end:
+	*size += libmapiserver_RopSeekRow_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc SeekRowBookmark (0x19) Rop. This operation moves
+   the table cursor relatively to a bookmarked row.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the SeekRowBookmark EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the SeekRowBookmark EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSeekRowBookmark(TALLOC_CTX *mem_ctx,
+						    struct emsmdbp_context *emsmdbp_ctx,
+						    struct EcDoRpc_MAPI_REQ *mapi_req,
+						    struct EcDoRpc_MAPI_REPL *mapi_repl,
+						    uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct emsmdbp_object		*object = NULL;
+	struct emsmdbp_object_table	*table;
+	struct SeekRowBookmark_req	*request;
+	struct SeekRowBookmark_repl	*response;
+	uint32_t			bookmark_id;
+	uint32_t			start;
+	int64_t				next_position;
+	bool				row_visible;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] SeekRowBookmark (0x19)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_SeekRowBookmark;
+	response = &mapi_repl->u.mapi_SeekRowBookmark;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+
+	response->RowNoLongerVisible = 0;
+	response->HasSoughtLess = 0;
+	response->RowsSought = 0;
+
+	retval = oxctabl_get_table(emsmdbp_ctx, mapi_req, handles, &object);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	table = object->object.table;
+
+	retval = oxctabl_pull_bookmark(&request->Bookmark, &bookmark_id);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+
+	/* when the row is gone, start refers to the row which followed it */
+	retval = emsmdbp_object_table_get_bookmark(object, bookmark_id, &start, &row_visible);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	response->RowNoLongerVisible = !row_visible;
+
+	next_position = (int64_t)start + (int32_t)request->RowCount;
+	if (next_position < 0) {
+		next_position = 0;
+		response->HasSoughtLess = 1;
+	}
+	else if (next_position > table->denominator) {
+		next_position = table->denominator;
+		response->HasSoughtLess = 1;
+	}
+	if (request->WantRowMovedCount) {
+		response->RowsSought = (uint32_t)(next_position - start);
+	}
+	table->numerator = next_position;
+
+end:
+	*size += libmapiserver_RopSeekRowBookmark_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc SeekRowApprox (0x1a) Rop. This operation moves the
+   table cursor to a fractional position of the table, as given by a
+   scrollbar.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the SeekRowApprox EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the SeekRowApprox EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSeekRowApprox(TALLOC_CTX *mem_ctx,
+						  struct emsmdbp_context *emsmdbp_ctx,
+						  struct EcDoRpc_MAPI_REQ *mapi_req,
+						  struct EcDoRpc_MAPI_REPL *mapi_repl,
+						  uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct emsmdbp_object		*object = NULL;
+	struct emsmdbp_object_table	*table;
+	struct SeekRowApprox_req	*request;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] SeekRowApprox (0x1a)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	request = &mapi_req->u.mapi_SeekRowApprox;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+
+	retval = oxctabl_get_table(emsmdbp_ctx, mapi_req, handles, &object);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+	table = object->object.table;
+
+	if (!request->ulDenominator) {
+		mapi_repl->error_code = MAPI_E_INVALID_PARAMETER;
+		goto end;
+	}
+
+	/* numerator == denominator is the end of the table */
+	if (request->ulNumerator >= request->ulDenominator) {
+		table->numerator = table->denominator;
+	}
+	else {
+		table->numerator = ((uint64_t)table->denominator * request->ulNumerator) / request->ulDenominator;
+	}
+
+end:
+	*size += libmapiserver_RopSeekRowApprox_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc CreateBookmark (0x1b) Rop. This operation creates
+   a bookmark on the current row of a table.
+
+   Bookmarks on openchangedb tables are tracked by row identifier.
+   Other bookmarks record a position and are best-effort: they only
+   follow the row insertions and deletions reported by table
+   notifications, so a later Restrict, ExpandRow, CollapseRow or a
+   change to a categorized view may leave them on a different row.
+   SortTable and ResetTable invalidate every bookmark.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the CreateBookmark EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the CreateBookmark EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopCreateBookmark(TALLOC_CTX *mem_ctx,
+						   struct emsmdbp_context *emsmdbp_ctx,
+						   struct EcDoRpc_MAPI_REQ *mapi_req,
+						   struct EcDoRpc_MAPI_REPL *mapi_repl,
+						   uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct emsmdbp_object		*object = NULL;
+	struct SBinary_short		*bookmark;
+	uint32_t			bookmark_id;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] CreateBookmark (0x1b)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	bookmark = &mapi_repl->u.mapi_CreateBookmark.bookmark;
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	bookmark->cb = 0;
+	bookmark->lpb = NULL;
+
+	retval = oxctabl_get_table(emsmdbp_ctx, mapi_req, handles, &object);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+
+	retval = emsmdbp_object_table_create_bookmark(object, object->object.table->numerator, &bookmark_id);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+
+	retval = oxctabl_push_bookmark(mem_ctx, bookmark_id, bookmark);
+	if (retval) {
+		emsmdbp_object_table_free_bookmark(object, bookmark_id);
+		mapi_repl->error_code = retval;
+		goto end;
+	}
+
+end:
+	*size += libmapiserver_RopCreateBookmark_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details EcDoRpc Abort (0x38) Rop. This operation cancels the
+   asynchronous operations pending on a table. The table keeps its
+   committed sort order and restriction. Operations which have started
+   to run cannot be aborted.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the Abort EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the Abort EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopAbort(TALLOC_CTX *mem_ctx,
+					  struct emsmdbp_context *emsmdbp_ctx,
+					  struct EcDoRpc_MAPI_REQ *mapi_req,
+					  struct EcDoRpc_MAPI_REPL *mapi_repl,
+					  uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_handles		*parent;
+	struct emsmdbp_object		*object;
+	struct emsmdbp_object_table	*table;
+	uint32_t			handle;
+	void				*data = NULL;
+
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] Abort (0x38)\n"));
+
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
+
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->u.mapi_Abort.TableStatus = TBLSTAT_COMPLETE;
+
+	handle = handles[mapi_req->handle_idx];
+	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	if (retval) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		goto end;
+	}
+
+	retval = mapi_handles_get_private_data(parent, &data);
+	object = (struct emsmdbp_object *) data;
+	if (retval || !object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  missing object or not table\n"));
+		goto end;
+	}
+
+	table = object->object.table;
+	if (!table->async || table->async->started) {
+		mapi_repl->error_code = MAPI_E_UNABLE_TO_ABORT;
+		goto end;
+	}
+
+	mapi_repl->u.mapi_Abort.TableStatus = oxctabl_async_status(table);
+	oxctabl_async_cancel(table, true, true);
+	table->status = TBLSTAT_COMPLETE;
+
+end:
+	*size += libmapiserver_RopAbort_size(mapi_repl);
+
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Find a matching row by scanning the table rows
+
+   This is the fallback used with backends which don't implement the
+   find_row operation: the restriction is set on the backend table and
+   rows are fetched one at a time using live filtering. The restriction
+   committed on the table is restored once the scan is over.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param object pointer to the table object
+   \param request pointer to the FindRow request
+   \param start position of the first row to examine
+   \param pos pointer to the position of the matching row to return
+   \param row pointer to the DATA_BLOB holding the matching row
+
+   \return true if a row was found, otherwise false
+ */
+static bool oxctabl_find_row_scan(TALLOC_CTX *mem_ctx,
+				  struct emsmdbp_context *emsmdbp_ctx,
+				  struct emsmdbp_object *object,
+				  struct FindRow_req *request,
+				  uint32_t start, uint32_t *pos,
+				  DATA_BLOB *row)
+{
+	struct emsmdbp_object_table	*table;
+	enum MAPISTATUS			*retvals;
+	void				**data_pointers;
+	uint32_t			contextID;
+	uint32_t			i;
+	uint8_t				status = 0;
+	bool				found = false;
+
+	table = object->object.table;
+	contextID = emsmdbp_get_contextID(object);
+
+	mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, &request->res, &status);
+
+	i = start;
+	for (;;) {
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, object, i, MAPISTORE_LIVEFILTERED_QUERY, &retvals);
+		if (data_pointers) {
+			emsmdbp_fill_table_row_blob(mem_ctx, emsmdbp_ctx, row, table->prop_count,
+						    table->properties, data_pointers, retvals);
+			talloc_free(retvals);
+			talloc_free(data_pointers);
+			*pos = i;
+			found = true;
+			break;
+		}
+
+		if (request->ulFlags & DIR_BACKWARD) {
+			if (i == 0) break;
+			i--;
+		}
+		else {
+			if (i + 1 >= table->denominator) break;
+			i++;
+		}
+	}
+
+	mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, table->restriction, &status);
+
+	return found;
+}
+
+
+/**
+   \details EcDoRpc FindRow (0x4f) Rop. This operation moves the
+   cursor to a row in a table that matches specific search criteria.
+
+   The search starts at the origin (beginning, current row, end or a
+   bookmark) and moves forward or backward. Rows are searched by
+   openchangedb or by the mapistore backend when it implements the
+   find_row operation, otherwise the rows are scanned one at a time.
+
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the FindRow EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the FindRow EcDoRpc_MAPI_REPL structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFindRow(TALLOC_CTX *mem_ctx,
+					    struct emsmdbp_context *emsmdbp_ctx,
+					    struct EcDoRpc_MAPI_REQ *mapi_req,
+					    struct EcDoRpc_MAPI_REPL *mapi_repl,
+					    uint32_t *handles, uint16_t *size)
+{
 	struct mapi_handles		*parent;
 	struct emsmdbp_object		*object;
 	struct emsmdbp_object_table	*table;
-	struct Restrict_req		request;
-	uint32_t			handle, contextID;
+	struct FindRow_req		*request;
+	enum MAPISTATUS			retval;
+	enum mapistore_error		ret;
 	void				*data = NULL;
-	uint8_t				status;
+	enum MAPISTATUS			*retvals;
+	void				**data_pointers;
+	uint32_t			handle;
+	uint32_t			bookmark_id;
+	uint32_t			start;
+	uint32_t			pos = 0;
+	DATA_BLOB			row;
+	bool				backward;
+	bool				row_visible = true;
+	bool				found = false;
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] Restrict (0x14)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] FindRow (0x4f)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -280,13 +1707,16 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopRestrict(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
-	
-	request = mapi_req->u.mapi_Restrict;
 
+	request = &mapi_req->u.mapi_FindRow;
+	
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->error_code = MAPI_E_SUCCESS;
-	mapi_repl->u.mapi_Restrict.TableStatus = TBLSTAT_COMPLETE;
+	mapi_repl->u.mapi_FindRow.RowNoLongerVisible = 0;
+	mapi_repl->u.mapi_FindRow.HasRowData = 0;
+	mapi_repl->u.mapi_FindRow.row.length = 0;
+	mapi_repl->u.mapi_FindRow.row.data = NULL;
 
 	handle = handles[mapi_req->handle_idx];
 	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
@@ -304,81 +1734,153 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopRestrict(TALLOC_CTX *mem_ctx,
 	}
 	object = (struct emsmdbp_object *) data;
 
-	/* Ensure referring object exists and is a table */
+	/* Ensure object exists and is table type */
 	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
 		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  missing object or not table\n"));
+		DEBUG(5, ("  no object or object is not a table\n"));
 		goto end;
 	}
 
 	table = object->object.table;
-	OPENCHANGE_RETVAL_IF(!table, MAPI_E_INVALID_PARAMETER, NULL);
-
-	table->restricted = true;
 	if (table->ulType == MAPISTORE_RULE_TABLE) {
 		DEBUG(5, ("  query on rules table are all faked right now\n"));
 		goto end;
 	}
- 
-	/* If parent folder has a mapistore context */
-	if (emsmdbp_is_mapistore(object)) {
-		status = TBLSTAT_COMPLETE;
-		contextID = emsmdbp_get_contextID(object);
-		retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, &request.restrictions, &status);
-                if (retval) {
-                        mapi_repl->error_code = retval;
+	oxctabl_async_complete(table);
+
+	/* Step 1. Retrieve the position the search starts from */
+	backward = (request->ulFlags & DIR_BACKWARD) ? true : false;
+	switch (request->origin) {
+	case BOOKMARK_BEGINNING:
+		start = 0;
+		break;
+	case BOOKMARK_CURRENT:
+		start = table->numerator;
+		break;
+	case BOOKMARK_END:
+		start = table->denominator;
+		break;
+	case BOOKMARK_USER:
+		retval = oxctabl_pull_bookmark(&request->bookmark, &bookmark_id);
+		if (retval) {
+			mapi_repl->error_code = retval;
+			goto end;
+		}
+		retval = emsmdbp_object_table_get_bookmark(object, bookmark_id, &start, &row_visible);
+		if (retval) {
+			mapi_repl->error_code = retval;
 			goto end;
 		}
+		if (!row_visible) {
+			mapi_repl->u.mapi_FindRow.RowNoLongerVisible = 1;
+			/* start refers to the row following the bookmarked one */
+			if (backward) {
+				if (start == 0) {
+					mapi_repl->error_code = MAPI_E_NOT_FOUND;
+					goto end;
+				}
+				start--;
+			}
+		}
+		break;
+	default:
+		mapi_repl->error_code = MAPI_E_INVALID_PARAMETER;
+		DEBUG(5, ("  unhandled 'origin' type: %d\n", request->origin));
+		goto end;
+	}
 
-		mapistore_table_get_row_count(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, MAPISTORE_PREFILTERED_QUERY, &object->object.table->denominator);
-		
-		mapi_repl->u.mapi_Restrict.TableStatus = status;
+	if (backward && start >= table->denominator) {
+		start = table->denominator - 1;
+	}
+	if (start >= table->denominator) {
+		mapi_repl->error_code = MAPI_E_NOT_FOUND;
+		goto end;
+	}
 
-		/* Parent folder doesn't have any mapistore context associated */
-	} else {
-		DEBUG(0, ("not mapistore Restrict: Not implemented yet\n"));
+	/* Step 2. Search the matching row */
+	memset (&row, 0, sizeof(DATA_BLOB));
+	if (emsmdbp_is_mapistore(object)) {
+		ret = mapistore_table_find_row(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(object), object->backend_object,
+					       &request->res, request->ulFlags, start, &pos);
+		if (ret == MAPISTORE_SUCCESS) {
+			found = true;
+		}
+		else if (ret == MAPISTORE_ERR_NOT_IMPLEMENTED) {
+			found = oxctabl_find_row_scan(mem_ctx, emsmdbp_ctx, object, request, start, &pos, &row);
+		}
+	}
+	else if (table->search) {
+		retval = emsmdbp_search_table_find_row(emsmdbp_ctx, object, &request->res, request->ulFlags, start, &pos);
+		found = (retval == MAPI_E_SUCCESS);
+	}
+	else {
+		retval = openchangedb_table_find_row(object->backend_object, emsmdbp_ctx->oc_ctx, &request->res,
+						     request->ulFlags, start, &pos);
+		found = (retval == MAPI_E_SUCCESS);
+	}
+
+	if (!found) {
+		mapi_repl->error_code = MAPI_E_NOT_FOUND;
 		goto end;
 	}
 
+	/* Step 3. Move the cursor to the row and fetch it */
+	table->numerator = pos;
+	if (!row.length) {
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, object, pos, MAPISTORE_PREFILTERED_QUERY, &retvals);
+		if (!data_pointers) {
+			mapi_repl->error_code = MAPI_E_NOT_FOUND;
+			goto end;
+		}
+		emsmdbp_fill_table_row_blob(mem_ctx, emsmdbp_ctx, &row, table->prop_count,
+					    table->properties, data_pointers, retvals);
+		talloc_free(retvals);
+		talloc_free(data_pointers);
+	}
+
+	mapi_repl->u.mapi_FindRow.HasRowData = 1;
+	mapi_repl->u.mapi_FindRow.row.length = row.length;
+	mapi_repl->u.mapi_FindRow.row.data = row.data;
+
 end:
-	*size += libmapiserver_RopRestrict_size(mapi_repl);
+	*size += libmapiserver_RopFindRow_size(mapi_repl);
 
-	return MAPI_E_SUCCESS;	
+	return MAPI_E_SUCCESS;
 }
 
-
 /**
-   \details EcDoRpc QueryRows (0x15) Rop. This operation retrieves
-   rows from a table.
+   \details EcDoRpc ResetTable (0x81) Rop. This operation resets the
+   table as follows:
+     - Removes the existing column set, restriction, and sort order (ignored) from the table.
+     - Invalidates bookmarks.
+     - Resets the cursor to the beginning of the table.
 
    \param mem_ctx pointer to the memory context
    \param emsmdbp_ctx pointer to the emsmdb provider context
-   \param mapi_req pointer to the QueryRows EcDoRpc_MAPI_REQ structure
-   \param mapi_repl pointer to the QueryRows EcDoRpc_MAPI_REPL
+   \param mapi_req pointer to the SetColumns EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the SetColumns EcDoRpc_MAPI_REPL
    structure
    \param handles pointer to the MAPI handles array
    \param size pointer to the mapi_response size to update
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
-_PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryRows(TALLOC_CTX *mem_ctx,
-					      struct emsmdbp_context *emsmdbp_ctx,
-					      struct EcDoRpc_MAPI_REQ *mapi_req,
-					      struct EcDoRpc_MAPI_REPL *mapi_repl,
-					      uint32_t *handles, uint16_t *size)
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopResetTable(TALLOC_CTX *mem_ctx,
+					       struct emsmdbp_context *emsmdbp_ctx,
+					       struct EcDoRpc_MAPI_REQ *mapi_req,
+					       struct EcDoRpc_MAPI_REPL *mapi_repl,
+					       uint32_t *handles, uint16_t *size)
 {
+	enum MAPISTATUS			retval;
 	struct mapi_handles		*parent;
 	struct emsmdbp_object		*object;
 	struct emsmdbp_object_table	*table;
-	struct QueryRows_req		*request;
-	struct QueryRows_repl		*response;
-	enum MAPISTATUS			retval;
 	void				*data;
-	enum MAPISTATUS			*retvals;
-	void				**data_pointers;
-	uint32_t			count, max;
-	uint32_t			handle;
-	uint32_t			i = 0;
+	uint32_t			handle, contextID;
+	uint8_t				status; /* ignored */
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] QueryRows (0x15)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] ResetTable (0x81)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -386,15 +1888,11 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryRows(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
-
-	request = &mapi_req->u.mapi_QueryRows;
-	response = &mapi_repl->u.mapi_QueryRows;
-
+	
+	/* Initialize default empty ResetTable reply */
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
-	mapi_repl->error_code = MAPI_E_NOT_FOUND;
-	
-	response->RowData.length = 0;
+	*size += libmapiserver_RopResetTable_size(mapi_repl);
 
 	handle = handles[mapi_req->handle_idx];
 	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
@@ -406,119 +1904,96 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryRows(TALLOC_CTX *mem_ctx,
 
 	retval = mapi_handles_get_private_data(parent, &data);
 	if (retval) {
+		mapi_repl->error_code = retval;
 		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
 		goto end;
 	}
 
 	object = (struct emsmdbp_object *) data;
-
 	/* Ensure referring object exists and is a table */
-	if (!object) {
-		DEBUG(5, ("  missing object\n"));
-		goto end;
-	}
-	if (object->type != EMSMDBP_OBJECT_TABLE) {
-		DEBUG(5, ("  unhandled object type: %d\n", object->type));
+	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
+		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
+		DEBUG(5, ("  missing object or not table\n"));
 		goto end;
 	}
 
-	table = object->object.table;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
 
-	count = 0;
+	table = object->object.table;
 	if (table->ulType == MAPISTORE_RULE_TABLE) {
 		DEBUG(5, ("  query on rules table are all faked right now\n"));
-		goto finish;
-	}
-
-	/* Ensure we are in a case which we can handle, until the featureset is complete. */
-	if (!request->ForwardRead) {
-		DEBUG(0, ("  !ForwardRead is not supported yet\n"));
-		abort();
 	}
+	else {
+		/* 1.0. cancel pending asynchronous operations */
+		oxctabl_async_complete(table);
+		oxctabl_async_cancel(table, true, true);
+		table->status = TBLSTAT_COMPLETE;
 
-        /* Lookup the properties */
-	max = table->numerator + request->RowCount;
-	if (max > table->denominator) {
-		max = table->denominator;
-	}
-        for (i = table->numerator; i < max; i++) {
-		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, object, i, MAPISTORE_PREFILTERED_QUERY, &retvals);
-		if (data_pointers) {
-			emsmdbp_fill_table_row_blob(mem_ctx, emsmdbp_ctx,
-						    &response->RowData, table->prop_count,
-						    table->properties, data_pointers, retvals);
-			talloc_free(retvals);
-			talloc_free(data_pointers);
-			count++;
-		}
-		else {
-			count = 0;
-			goto finish;
+		/* 1.1. removes the existing column set */
+		if (table->properties) {
+			talloc_free(table->properties);
+			table->properties = NULL;
+			table->prop_count = 0;
 		}
-	}
 
-finish:
-	if ((request->QueryRowsFlags & TBL_NOADVANCE) != TBL_NOADVANCE) {
-		table->numerator = i;
-	}
+		/* 1.2. drop the categorized view */
+		talloc_free(table->categories);
+		table->categories = NULL;
 
-	/* QueryRows reply parameters */
-	mapi_repl->error_code = MAPI_E_SUCCESS;
-	response->RowCount = count;
-	if (count) {
-		if ((count < request->RowCount) || (table->numerator > (table->denominator - 2))) {
-			response->Origin = BOOKMARK_END;
+		/* 1.3. empty restrictions */
+		talloc_free(table->restriction);
+		table->restriction = NULL;
+		table->restricted = false;
+		if (emsmdbp_is_mapistore(object)) {
+			contextID = emsmdbp_get_contextID(object);
+			retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, NULL, &status);
+			mapistore_table_get_row_count(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, MAPISTORE_PREFILTERED_QUERY, &object->object.table->denominator);
+		} else if (table->search) {
+			emsmdbp_search_table_set_restrictions(emsmdbp_ctx, object, NULL);
 		} else {
-			response->Origin = BOOKMARK_CURRENT;
-		}
-		/* dump_data(0, response.RowData.data, response.RowData.length); */
-	} else {
-		/* useless code for the moment */
-		if (table->restricted) {
-			response->Origin = BOOKMARK_BEGINNING;	
-		}
-		else {
-			response->Origin = BOOKMARK_END;
+			openchangedb_table_set_restrictions(object->backend_object, NULL);
+			openchangedb_table_get_row_count(object->backend_object, emsmdbp_ctx->oc_ctx, &table->denominator);
 		}
-		response->RowData.length = 0;
-		response->RowData.data = NULL;
-		DEBUG(5, ("%s: returning empty data set\n", __location__));
+
+		/* 2. invalidate bookmarks */
+		emsmdbp_object_table_reset_bookmarks(object);
+
+		/* 3. reset the cursor to the beginning of the table. */
+		table->numerator = 0;
 	}
 
 end:
-	*size += libmapiserver_RopQueryRows_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
 }
 
 
 /**
-   \details EcDoRpc QueryPosition (0x17) Rop. This operation returns
-   the location of cursor in the table.
+   \details EcDoRpc FreeBookmark (0x89) Rop. This operation releases a
+   bookmark of a table.
 
    \param mem_ctx pointer to the memory context
    \param emsmdbp_ctx pointer to the emsmdb provider context
-   \param mapi_req pointer to the QueryPosition EcDoRpc_MAPI_REQ structure
-   \param mapi_repl pointer to the QueryPosition EcDoRpc_MAPI_REPL structure
+   \param mapi_req pointer to the FreeBookmark EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the FreeBookmark EcDoRpc_MAPI_REPL
+   structure
    \param handles pointer to the MAPI handles array
    \param size pointer to the mapi_response size to update
 
    \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
-_PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryPosition(TALLOC_CTX *mem_ctx,
-						  struct emsmdbp_context *emsmdbp_ctx,
-						  struct EcDoRpc_MAPI_REQ *mapi_req,
-						  struct EcDoRpc_MAPI_REPL *mapi_repl,
-						  uint32_t *handles, uint16_t *size)
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFreeBookmark(TALLOC_CTX *mem_ctx,
+						 struct emsmdbp_context *emsmdbp_ctx,
+						 struct EcDoRpc_MAPI_REQ *mapi_req,
+						 struct EcDoRpc_MAPI_REPL *mapi_repl,
+						 uint32_t *handles, uint16_t *size)
 {
 	enum MAPISTATUS			retval;
-	struct mapi_handles		*parent;
-	struct emsmdbp_object		*object;
-	struct emsmdbp_object_table	*table;
-	void				*data;
-	uint32_t			handle;
+	struct emsmdbp_object		*object = NULL;
+	uint32_t			bookmark_id;
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] QueryPosition (0x17)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] FreeBookmark (0x89)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -526,73 +2001,100 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopQueryPosition(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
-	
+
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
-	mapi_repl->error_code = MAPI_E_NOT_FOUND;
-	
-	handle = handles[mapi_req->handle_idx];
-	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+
+	retval = oxctabl_get_table(emsmdbp_ctx, mapi_req, handles, &object);
 	if (retval) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		mapi_repl->error_code = retval;
 		goto end;
 	}
 
-	retval = mapi_handles_get_private_data(parent, &data);
+	retval = oxctabl_pull_bookmark(&mapi_req->u.mapi_FreeBookmark.bookmark, &bookmark_id);
 	if (retval) {
-		DEBUG(5, ("  no private data or object is not a table"));
+		mapi_repl->error_code = retval;
 		goto end;
 	}
-	object = (struct emsmdbp_object *) data;
 
-	/* Ensure object exists and is table type */
-	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
-		DEBUG(5, ("  no object or object is not a table\n"));
+	retval = emsmdbp_object_table_free_bookmark(object, bookmark_id);
+	if (retval) {
+		mapi_repl->error_code = retval;
 		goto end;
 	}
 
-	table = object->object.table;
+end:
+	*size += libmapiserver_RopFreeBookmark_size(mapi_repl);
 
-        mapi_repl->u.mapi_QueryPosition.Numerator = table->numerator;
-	mapi_repl->u.mapi_QueryPosition.Denominator = table->denominator;
-	mapi_repl->error_code = MAPI_E_SUCCESS;
+	return MAPI_E_SUCCESS;
+}
+
+
+/**
+   \details Retrieve the categorized table object of a ROP request
+
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the EcDoRpc_MAPI_REQ structure
+   \param handles pointer to the MAPI handles array
+   \param objectp pointer to the table object to return
+
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+static enum MAPISTATUS oxctabl_get_categorized_table(struct emsmdbp_context *emsmdbp_ctx,
+						     struct EcDoRpc_MAPI_REQ *mapi_req,
+						     uint32_t *handles,
+						     struct emsmdbp_object **objectp)
+{
+	enum MAPISTATUS		retval;
 
-end:
-	*size += libmapiserver_RopQueryPosition_size(mapi_repl);
+	retval = oxctabl_get_table(emsmdbp_ctx, mapi_req, handles, objectp);
+	OPENCHANGE_RETVAL_IF(retval, retval, NULL);
+
+	/* Only tables sorted with categories have category rows */
+	if (!(*objectp)->object.table->categories) {
+		DEBUG(5, ("  table is not categorized\n"));
+		return MAPI_E_NO_SUPPORT;
+	}
 
 	return MAPI_E_SUCCESS;
 }
 
 
 /**
-   \details EcDoRpc SeekRow (0x18) Rop. This operation moves the
-   cursor to a specific position in a table.
+   \details EcDoRpc ExpandRow (0x59) Rop. This operation expands a
+   collapsed category of a table and returns the rows which are added
+   to the view.
 
    \param mem_ctx pointer to the memory context
    \param emsmdbp_ctx pointer to the emsmdb provider context
-   \param mapi_req pointer to the SeekRow EcDoRpc_MAPI_REQ structure
-   \param mapi_repl pointer to the SeekRow EcDoRpc_MAPI_REPL structure
+   \param mapi_req pointer to the ExpandRow EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the ExpandRow EcDoRpc_MAPI_REPL structure
    \param handles pointer to the MAPI handles array
    \param size pointer to the mapi_response size to update
 
    \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
-_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSeekRow(TALLOC_CTX *mem_ctx,
-					    struct emsmdbp_context *emsmdbp_ctx,
-					    struct EcDoRpc_MAPI_REQ *mapi_req,
-					    struct EcDoRpc_MAPI_REPL *mapi_repl,
-					    uint32_t *handles, uint16_t *size)
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopExpandRow(TALLOC_CTX *mem_ctx,
+					      struct emsmdbp_context *emsmdbp_ctx,
+					      struct EcDoRpc_MAPI_REQ *mapi_req,
+					      struct EcDoRpc_MAPI_REPL *mapi_repl,
+					      uint32_t *handles, uint16_t *size)
 {
-	uint32_t			handle;
 	enum MAPISTATUS			retval;
-	struct mapi_handles		*parent;
-	struct emsmdbp_object		*object;
+	struct emsmdbp_object		*object = NULL;
 	struct emsmdbp_object_table	*table;
-	void				*data;
-        int32_t                         next_position;
+	struct ExpandRow_req		*request;
+	struct ExpandRow_repl		*response;
+	enum MAPISTATUS			*retvals;
+	void				**data_pointers;
+	uint32_t			position;
+	uint32_t			count;
+	uint32_t			row_start;
+	uint32_t			i;
+	uint16_t			available;
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] SeekRow (0x18)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] ExpandRow (0x59)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -600,116 +2102,90 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopSeekRow(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
-	
+
+	request = &mapi_req->u.mapi_ExpandRow;
+	response = &mapi_repl->u.mapi_ExpandRow;
+
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->error_code = MAPI_E_SUCCESS;
-	mapi_repl->u.mapi_SeekRow.HasSoughtLess = 0;
-	mapi_repl->u.mapi_SeekRow.RowsSought = 0;
 
-	handle = handles[mapi_req->handle_idx];
-	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
-	if (retval) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
-		goto end;
-	}
+	response->ExpandedRowCount = 0;
+	response->RowCount = 0;
+	response->RowData.length = 0;
+	response->RowData.data = NULL;
 
-	retval = mapi_handles_get_private_data(parent, &data);
+	retval = oxctabl_get_categorized_table(emsmdbp_ctx, mapi_req, handles, &object);
 	if (retval) {
 		mapi_repl->error_code = retval;
-		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
 		goto end;
 	}
-	object = (struct emsmdbp_object *) data;
+	table = object->object.table;
 
-	/* Ensure object exists and is table type */
-	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  no object or object is not a table\n"));
+	retval = emsmdbp_category_table_expand(object, request->CategoryId, &position, &count);
+	if (retval) {
+		mapi_repl->error_code = retval;
 		goto end;
 	}
+	response->ExpandedRowCount = count;
 
-	/* We don't handle backward/forward yet , just go through the
-	 * entire table, nor do we handle bookmarks */
+	/* Rows are returned until MaxRowCount is reached or the ROP buffer is full */
+	available = emsmdbp_rop_buffer_available(emsmdbp_ctx, *size, SIZE_DFLT_MAPI_RESPONSE + SIZE_DFLT_ROPEXPANDROW);
 
-	table = object->object.table;
-	if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_BEGINNING) {
-                next_position = mapi_req->u.mapi_SeekRow.offset;
-	}
-	else if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_CURRENT) {
-                next_position = table->numerator + mapi_req->u.mapi_SeekRow.offset;
-	}
-	else if (mapi_req->u.mapi_SeekRow.origin == BOOKMARK_END) {
-                next_position = table->denominator - 1 + mapi_req->u.mapi_SeekRow.offset;
+	if (count > request->MaxRowCount) {
+		count = request->MaxRowCount;
 	}
-	else {
-                next_position = 0;
-		mapi_repl->error_code = MAPI_E_NOT_FOUND;
-		DEBUG(5, ("  unhandled 'origin' type: %d\n", mapi_req->u.mapi_SeekRow.origin));
+	for (i = 0; i < count; i++) {
+		data_pointers = emsmdbp_object_table_get_row_props(mem_ctx, emsmdbp_ctx, object, position + 1 + i,
+								   MAPISTORE_PREFILTERED_QUERY, &retvals);
+		if (!data_pointers) break;
+
+		row_start = response->RowData.length;
+		emsmdbp_fill_table_row_blob(mem_ctx, emsmdbp_ctx, &response->RowData,
+					    table->prop_count, table->properties,
+					    data_pointers, retvals);
+		talloc_free(retvals);
+		talloc_free(data_pointers);
+		/* the first row is always returned */
+		if (response->RowCount && response->RowData.length > available) {
+			response->RowData.length = row_start;
+			break;
+		}
+		response->RowCount++;
 	}
 
-        if (mapi_repl->error_code == MAPI_E_SUCCESS) {
-                if (next_position < 0) {
-                        next_position = 0;
-                        mapi_repl->u.mapi_SeekRow.HasSoughtLess = 1;
-                }
-                else if (next_position >= table->denominator) {
-                        next_position = table->denominator - 1;
-                        mapi_repl->u.mapi_SeekRow.HasSoughtLess = 1;
-                }
-                if (mapi_req->u.mapi_SeekRow.WantRowMovedCount) {
-                        mapi_repl->u.mapi_SeekRow.RowsSought = (next_position - table->numerator);
-                }
-                else {
-                        mapi_repl->u.mapi_SeekRow.RowsSought = 0;
-                }
-                table->numerator = next_position;
-        }
-
 end:
-	*size += libmapiserver_RopSeekRow_size(mapi_repl);
+	*size += libmapiserver_RopExpandRow_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
 }
 
 
 /**
-   \details EcDoRpc FindRow (0x4f) Rop. This operation moves the
-   cursor to a row in a table that matches specific search criteria.
+   \details EcDoRpc CollapseRow (0x5a) Rop. This operation collapses
+   an expanded category of a table.
 
    \param mem_ctx pointer to the memory context
    \param emsmdbp_ctx pointer to the emsmdb provider context
-   \param mapi_req pointer to the FindRow EcDoRpc_MAPI_REQ structure
-   \param mapi_repl pointer to the FindRow EcDoRpc_MAPI_REPL structure
+   \param mapi_req pointer to the CollapseRow EcDoRpc_MAPI_REQ structure
+   \param mapi_repl pointer to the CollapseRow EcDoRpc_MAPI_REPL structure
    \param handles pointer to the MAPI handles array
    \param size pointer to the mapi_response size to update
 
    \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
-_PUBLIC_ enum MAPISTATUS EcDoRpc_RopFindRow(TALLOC_CTX *mem_ctx,
-					    struct emsmdbp_context *emsmdbp_ctx,
-					    struct EcDoRpc_MAPI_REQ *mapi_req,
-					    struct EcDoRpc_MAPI_REPL *mapi_repl,
-					    uint32_t *handles, uint16_t *size)
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopCollapseRow(TALLOC_CTX *mem_ctx,
+						struct emsmdbp_context *emsmdbp_ctx,
+						struct EcDoRpc_MAPI_REQ *mapi_req,
+						struct EcDoRpc_MAPI_REPL *mapi_repl,
+						uint32_t *handles, uint16_t *size)
 {
-	struct mapi_handles		*parent;
-	struct emsmdbp_object		*object;
-	struct emsmdbp_object_table	*table;
-	struct FindRow_req		request;
 	enum MAPISTATUS			retval;
-	void				*data = NULL;
-	enum MAPISTATUS			*retvals;
-	void				**data_pointers;
-	uint32_t			handle;
-	DATA_BLOB			row;
-	uint32_t			property;
-	uint8_t				flagged;
-	uint8_t				status = 0;
-	uint32_t			i;
-	bool				found = false;
+	struct emsmdbp_object		*object = NULL;
+	uint32_t			position;
+	uint32_t			count;
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] FindRow (0x4f)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] CollapseRow (0x5a)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -718,233 +2194,122 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopFindRow(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
 
-	request = mapi_req->u.mapi_FindRow;
-	
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
 	mapi_repl->error_code = MAPI_E_SUCCESS;
-	mapi_repl->u.mapi_FindRow.RowNoLongerVisible = 0;
-	mapi_repl->u.mapi_FindRow.HasRowData = 0;
-	mapi_repl->u.mapi_FindRow.row.length = 0;
-	mapi_repl->u.mapi_FindRow.row.data = NULL;
+	mapi_repl->u.mapi_CollapseRow.CollapsedRowCount = 0;
 
-	handle = handles[mapi_req->handle_idx];
-	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	retval = oxctabl_get_categorized_table(emsmdbp_ctx, mapi_req, handles, &object);
 	if (retval) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		mapi_repl->error_code = retval;
 		goto end;
 	}
 
-	retval = mapi_handles_get_private_data(parent, &data);
+	retval = emsmdbp_category_table_collapse(object, mapi_req->u.mapi_CollapseRow.CategoryId, &position, &count);
 	if (retval) {
 		mapi_repl->error_code = retval;
-		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
-		goto end;
-	}
-	object = (struct emsmdbp_object *) data;
-
-	/* Ensure object exists and is table type */
-	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  no object or object is not a table\n"));
 		goto end;
 	}
+	mapi_repl->u.mapi_CollapseRow.CollapsedRowCount = count;
 
-	/* We don't handle backward/forward yet , just go through the
-	 * entire table, nor do we handle bookmarks */
-
-	table = object->object.table;
-	if (table->ulType == MAPISTORE_RULE_TABLE) {
-		DEBUG(5, ("  query on rules table are all faked right now\n"));
-		goto end;
-	}
+end:
+	*size += libmapiserver_RopCollapseRow_size(mapi_repl);
 
-	if (mapi_req->u.mapi_FindRow.origin == BOOKMARK_BEGINNING) {
-		table->numerator = 0;
-	}
-	if (mapi_req->u.mapi_FindRow.ulFlags == DIR_BACKWARD) {
-		DEBUG(5, ("  only DIR_FORWARD is supported right now, using work-around\n"));
-		table->numerator = 0;
-	}
+	return MAPI_E_SUCCESS;
+}
 
-	memset (&row, 0, sizeof(DATA_BLOB));
 
-	switch (emsmdbp_is_mapistore(object)) {
-	case true:
-		/* Restrict rows to be fetched */
-		retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(object), object->backend_object, &request.res, &status);
-		/* Then fetch rows */
-		/* Lookup the properties and check if we need to flag the PropertyRow blob */
-
-		while (!found && table->numerator < table->denominator) {
-                        flagged = 0;
-
-			data_pointers = emsmdbp_object_table_get_row_props(NULL, emsmdbp_ctx, object, table->numerator, MAPISTORE_LIVEFILTERED_QUERY, &retvals);
-			if (data_pointers) {
-				found = true;
-				for (i = 0; i < table->prop_count; i++) {
-					if (retvals[i] != MAPI_E_SUCCESS) {
-						flagged = 1;
-					}
-				}
+/**
+   \details EcDoRpc GetCollapseState (0x6b) Rop. This operation saves
+   the expanded state of the categories of a table.
 
-				if (flagged) {
-					libmapiserver_push_property(mem_ctx, 
-								    0x0000000b, (const void *)&flagged,
-								    &row, 0, 0, 0);
-				}
-				else {
-					libmapiserver_push_property(mem_ctx, 
-								    0x00000000, (const void *)&flagged,
-								    &row, 0, 1, 0);
-				}
-                                
-				/* Push the properties */
-				for (i = 0; i < table->prop_count; i++) {
-					property = table->properties[i];
-					retval = retvals[i];
-					if (retval == MAPI_E_NOT_FOUND) {
-						property = (property & 0xFFFF0000) + PT_ERROR;
-						data = &retval;
-					}
-					else {
-						data = data_pointers[i];
-					}
-                                
-					libmapiserver_push_property(mem_ctx,
-								    property, data, &row,
-								    flagged?PT_ERROR:0, flagged, 0);
-				}
-				talloc_free(retvals);
-				talloc_free(data_pointers);
-                        }
-                        else {
-				table->numerator++;
-			}
-		}
+   \param mem_ctx pointer to the memory context
+   \param emsmdbp_ctx pointer to the emsmdb provider context
+   \param mapi_req pointer to the GetCollapseState EcDoRpc_MAPI_REQ
+   structure
+   \param mapi_repl pointer to the GetCollapseState EcDoRpc_MAPI_REPL
+   structure
+   \param handles pointer to the MAPI handles array
+   \param size pointer to the mapi_response size to update
 
-		retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, emsmdbp_get_contextID(object), object->backend_object, NULL, &status);
+   \return MAPI_E_SUCCESS on success, otherwise MAPI error
+ */
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopGetCollapseState(TALLOC_CTX *mem_ctx,
+						     struct emsmdbp_context *emsmdbp_ctx,
+						     struct EcDoRpc_MAPI_REQ *mapi_req,
+						     struct EcDoRpc_MAPI_REPL *mapi_repl,
+						     uint32_t *handles, uint16_t *size)
+{
+	enum MAPISTATUS			retval;
+	struct emsmdbp_object		*object = NULL;
+	struct GetCollapseState_req	*request;
 
-		/* Adjust parameters */
-		if (found) {
-			mapi_repl->u.mapi_FindRow.HasRowData = 1;
-		}
-		else {
-                        mapi_repl->error_code = MAPI_E_NOT_FOUND;
-		}
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] GetCollapseState (0x6b)\n"));
 
-		mapi_repl->u.mapi_FindRow.row.length = row.length;
-		mapi_repl->u.mapi_FindRow.row.data = row.data;
+	/* Sanity checks */
+	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_req, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
+	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
 
-		break;
-	case false:
-		memset (&row, 0, sizeof(DATA_BLOB));
-		DEBUG(0, ("FindRow for openchangedb\n"));
-		/* Restrict rows to be fetched */
-		retval = openchangedb_table_set_restrictions(object->backend_object, &request.res);
-		/* Then fetch rows */
-		/* Lookup the properties and check if we need to flag the PropertyRow blob */
-		while (!found && table->numerator < table->denominator) {
-                        flagged = 0;
-
-			data_pointers = emsmdbp_object_table_get_row_props(NULL, emsmdbp_ctx, object, table->numerator, MAPISTORE_LIVEFILTERED_QUERY, &retvals);
-			if (data_pointers) {
-				found = true;
-				for (i = 0; i < table->prop_count; i++) {
-					if (retvals[i] != MAPI_E_SUCCESS) {
-						flagged = 1;
-					}
-				}
+	request = &mapi_req->u.mapi_GetCollapseState;
 
-				if (flagged) {
-					libmapiserver_push_property(mem_ctx, 
-								    0x0000000b, (const void *)&flagged,
-								    &row, 0, 0, 0);
-				}
-				else {
-					libmapiserver_push_property(mem_ctx, 
-								    0x00000000, (const void *)&flagged,
-								    &row, 0, 1, 0);
-				}
-                                
-				/* Push the properties */
-				for (i = 0; i < table->prop_count; i++) {
-					property = table->properties[i];
-					retval = retvals[i];
-					if (retval == MAPI_E_NOT_FOUND) {
-						property = (property & 0xFFFF0000) + PT_ERROR;
-						data = &retval;
-					}
-					else {
-						data = data_pointers[i];
-					}
-                                
-					libmapiserver_push_property(mem_ctx,
-								    property, data, &row,
-								    flagged?PT_ERROR:0, flagged, 0);
-				}
-				talloc_free(retvals);
-				talloc_free(data_pointers);
-                        } else {
-				table->numerator++;
-			}
-		}
-		/* Reset restrictions */
-		openchangedb_table_set_restrictions(object->backend_object, NULL);
+	mapi_repl->opnum = mapi_req->opnum;
+	mapi_repl->handle_idx = mapi_req->handle_idx;
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	mapi_repl->u.mapi_GetCollapseState.CollapseState.cb = 0;
+	mapi_repl->u.mapi_GetCollapseState.CollapseState.lpb = NULL;
 
-		/* Adjust parameters */
-		if (found) {
-			mapi_repl->u.mapi_FindRow.HasRowData = 1;
-		}
-		else {
-                        mapi_repl->error_code = MAPI_E_NOT_FOUND;
-		}
+	retval = oxctabl_get_categorized_table(emsmdbp_ctx, mapi_req, handles, &object);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
+	}
 
-		mapi_repl->u.mapi_FindRow.row.length = row.length;
-		mapi_repl->u.mapi_FindRow.row.data = row.data;
-		break;
+	retval = emsmdbp_category_table_get_state(mem_ctx, object, request->RowId, request->RowInstanceNumber,
+						  &mapi_repl->u.mapi_GetCollapseState.CollapseState);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
 	}
 
 end:
-	*size += libmapiserver_RopFindRow_size(mapi_repl);
+	*size += libmapiserver_RopGetCollapseState_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
 }
 
+
 /**
-   \details EcDoRpc ResetTable (0x81) Rop. This operation resets the
-   table as follows:
-     - Removes the existing column set, restriction, and sort order (ignored) from the table.
-     - Invalidates bookmarks. (ignored)
-     - Resets the cursor to the beginning of the table.
+   \details EcDoRpc SetCollapseState (0x6c) Rop. This operation
+   restores the expanded state of the categories of a table and returns
+   a bookmark on the row saved with the state.
 
    \param mem_ctx pointer to the memory context
    \param emsmdbp_ctx pointer to the emsmdb provider context
-   \param mapi_req pointer to the SetColumns EcDoRpc_MAPI_REQ
+   \param mapi_req pointer to the SetCollapseState EcDoRpc_MAPI_REQ
    structure
-   \param mapi_repl pointer to the SetColumns EcDoRpc_MAPI_REPL
+   \param mapi_repl pointer to the SetCollapseState EcDoRpc_MAPI_REPL
    structure
    \param handles pointer to the MAPI handles array
    \param size pointer to the mapi_response size to update
 
    \return MAPI_E_SUCCESS on success, otherwise MAPI error
  */
-_PUBLIC_ enum MAPISTATUS EcDoRpc_RopResetTable(TALLOC_CTX *mem_ctx,
-					       struct emsmdbp_context *emsmdbp_ctx,
-					       struct EcDoRpc_MAPI_REQ *mapi_req,
-					       struct EcDoRpc_MAPI_REPL *mapi_repl,
-					       uint32_t *handles, uint16_t *size)
+_PUBLIC_ enum MAPISTATUS EcDoRpc_RopSetCollapseState(TALLOC_CTX *mem_ctx,
+						     struct emsmdbp_context *emsmdbp_ctx,
+						     struct EcDoRpc_MAPI_REQ *mapi_req,
+						     struct EcDoRpc_MAPI_REPL *mapi_repl,
+						     uint32_t *handles, uint16_t *size)
 {
 	enum MAPISTATUS			retval;
-	struct mapi_handles		*parent;
-	struct emsmdbp_object		*object;
-	struct emsmdbp_object_table	*table;
-	void				*data;
-	uint32_t			handle, contextID;
-	uint8_t				status; /* ignored */
+	struct emsmdbp_object		*object = NULL;
+	struct SBinary_short		*bookmark;
+	uint32_t			position;
+	uint32_t			bookmark_id;
 
-	DEBUG(4, ("exchange_emsmdb: [OXCTABL] ResetTable (0x81)\n"));
+	DEBUG(4, ("exchange_emsmdb: [OXCTABL] SetCollapseState (0x6c)\n"));
 
 	/* Sanity checks */
 	OPENCHANGE_RETVAL_IF(!emsmdbp_ctx, MAPI_E_NOT_INITIALIZED, NULL);
@@ -952,64 +2317,41 @@ _PUBLIC_ enum MAPISTATUS EcDoRpc_RopResetTable(TALLOC_CTX *mem_ctx,
 	OPENCHANGE_RETVAL_IF(!mapi_repl, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!handles, MAPI_E_INVALID_PARAMETER, NULL);
 	OPENCHANGE_RETVAL_IF(!size, MAPI_E_INVALID_PARAMETER, NULL);
-	
-	/* Initialize default empty ResetTable reply */
+
+	bookmark = &mapi_repl->u.mapi_SetCollapseState.bookmark;
+
 	mapi_repl->opnum = mapi_req->opnum;
 	mapi_repl->handle_idx = mapi_req->handle_idx;
-	*size += libmapiserver_RopResetTable_size(mapi_repl);
+	mapi_repl->error_code = MAPI_E_SUCCESS;
+	bookmark->cb = 0;
+	bookmark->lpb = NULL;
 
-	handle = handles[mapi_req->handle_idx];
-	retval = mapi_handles_search(emsmdbp_ctx->handles_ctx, handle, &parent);
+	retval = oxctabl_get_categorized_table(emsmdbp_ctx, mapi_req, handles, &object);
 	if (retval) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  handle (%x) not found: %x\n", handle, mapi_req->handle_idx));
+		mapi_repl->error_code = retval;
 		goto end;
 	}
 
-	retval = mapi_handles_get_private_data(parent, &data);
+	retval = emsmdbp_category_table_set_state(emsmdbp_ctx, object, &mapi_req->u.mapi_SetCollapseState.CollapseState, &position);
 	if (retval) {
 		mapi_repl->error_code = retval;
-		DEBUG(5, ("  handle data not found, idx = %x\n", mapi_req->handle_idx));
 		goto end;
 	}
 
-	object = (struct emsmdbp_object *) data;
-	/* Ensure referring object exists and is a table */
-	if (!object || (object->type != EMSMDBP_OBJECT_TABLE)) {
-		mapi_repl->error_code = MAPI_E_INVALID_OBJECT;
-		DEBUG(5, ("  missing object or not table\n"));
+	retval = emsmdbp_object_table_create_bookmark(object, position, &bookmark_id);
+	if (retval) {
+		mapi_repl->error_code = retval;
 		goto end;
 	}
 
-	mapi_repl->error_code = MAPI_E_SUCCESS;
-
-	table = object->object.table;
-	if (table->ulType == MAPISTORE_RULE_TABLE) {
-		DEBUG(5, ("  query on rules table are all faked right now\n"));
-	}
-	else {
-		/* 1.1. removes the existing column set */
-		if (table->properties) {
-			talloc_free(table->properties);
-			table->properties = NULL;
-			table->prop_count = 0;
-		}
-
-		/* 1.2. empty restrictions */
-		if (emsmdbp_is_mapistore(object)) {
-			contextID = emsmdbp_get_contextID(object);
-			retval = mapistore_table_set_restrictions(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, NULL, &status);
-			mapistore_table_get_row_count(emsmdbp_ctx->mstore_ctx, contextID, object->backend_object, MAPISTORE_PREFILTERED_QUERY, &object->object.table->denominator);
-		} else {
-			DEBUG(0, ("  mapistore Restrict: Not implemented yet\n"));
-			goto end;
-		}
-
-		/* 3. reset the cursor to the beginning of the table. */
-		table->numerator = 0;
+	retval = oxctabl_push_bookmark(mem_ctx, bookmark_id, bookmark);
+	if (retval) {
+		mapi_repl->error_code = retval;
+		goto end;
 	}
 
 end:
+	*size += libmapiserver_RopSetCollapseState_size(mapi_repl);
 
 	return MAPI_E_SUCCESS;
 }
@@ -27,13 +27,117 @@
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
 
-_PUBLIC_ void obfuscate_data(uint8_t *data, uint32_t size, uint8_t salt)
+/*
+  Obfuscation XORs every byte of the request and response buffers with
+  a salt (0xA5 for RHEF_XorMagic). The widest vector unit available is
+  selected at runtime, with a word-at-a-time fallback.
+*/
+
+static void obfuscate_copy_generic(uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t salt)
+{
+	uint64_t	mask = 0x0101010101010101ULL * salt;
+	uint64_t	word;
+	uint32_t	i;
+
+	for (i = 0; i + sizeof (word) <= size; i += sizeof (word)) {
+		memcpy(&word, src + i, sizeof (word));
+		word ^= mask;
+		memcpy(dst + i, &word, sizeof (word));
+	}
+	for (; i < size; i++) {
+		dst[i] = src[i] ^ salt;
+	}
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define	OBFUSCATE_X86	1
+
+__attribute__((target("sse2")))
+static void obfuscate_copy_sse2(uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t salt)
+{
+	__m128i		mask = _mm_set1_epi8((char)salt);
+	__m128i		v;
+	uint32_t	i;
+
+	for (i = 0; i + sizeof (v) <= size; i += sizeof (v)) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(v, mask));
+	}
+	obfuscate_copy_generic(dst + i, src + i, size - i, salt);
+}
+
+__attribute__((target("avx2")))
+static void obfuscate_copy_avx2(uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t salt)
+{
+	__m256i		mask = _mm256_set1_epi8((char)salt);
+	__m256i		v;
+	uint32_t	i;
+
+	for (i = 0; i + sizeof (v) <= size; i += sizeof (v)) {
+		v = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(v, mask));
+	}
+	obfuscate_copy_generic(dst + i, src + i, size - i, salt);
+}
+#endif
+
+static void (*obfuscate_copy_fn)(uint8_t *, const uint8_t *, uint32_t, uint8_t);
+
+static void obfuscate_select(void)
 {
-	uint32_t i;
+#ifdef OBFUSCATE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		obfuscate_copy_fn = obfuscate_copy_avx2;
+		return;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		obfuscate_copy_fn = obfuscate_copy_sse2;
+		return;
+	}
+#endif
+	obfuscate_copy_fn = obfuscate_copy_generic;
+}
+
+/**
+   \details Copy a buffer and obfuscate it in a single pass
 
-	for (i=0; i<size; i++) {
-		data[i] ^= salt;
+   \param dst pointer to the destination buffer
+   \param src pointer to the source buffer, may be equal to dst
+   \param size number of bytes to copy
+   \param salt value every byte is XORed with
+ */
+_PUBLIC_ void obfuscate_copy(uint8_t *dst, const uint8_t *src, uint32_t size, uint8_t salt)
+{
+	if (!obfuscate_copy_fn) {
+		obfuscate_select();
 	}
+	obfuscate_copy_fn(dst, src, size, salt);
+}
+
+_PUBLIC_ void obfuscate_data(uint8_t *data, uint32_t size, uint8_t salt)
+{
+	obfuscate_copy(data, data, size, salt);
+}
+
+/**
+   \details Push an obfuscated copy of a buffer
+
+   \param ndr pointer to the NDR push context
+   \param data pointer to the data to push
+   \param size number of bytes to push
+   \param salt value every byte is XORed with
+
+   \return NDR_ERR_SUCCESS on success, otherwise NDR error
+ */
+_PUBLIC_ enum ndr_err_code ndr_push_obfuscated_bytes(struct ndr_push *ndr, const uint8_t *data, uint32_t size, uint8_t salt)
+{
+	NDR_CHECK(ndr_push_expand(ndr, size));
+	obfuscate_copy(ndr->data + ndr->offset, data, size, salt);
+	ndr->offset += size;
+
+	return NDR_ERR_SUCCESS;
 }
 
 ssize_t lzxpress_compress(const uint8_t *input,
@@ -569,7 +673,7 @@ enum ndr_err_code ndr_push_mapi_response(struct ndr_push *ndr, int ndr_flags, co
 
 enum ndr_err_code ndr_pull_mapi_request(struct ndr_pull *ndr, int ndr_flags, struct mapi_request *r)
 {
-	uint32_t length,count;
+	uint32_t length,count,size;
 	uint32_t cntr_mapi_req_0;
 	TALLOC_CTX *_mem_save_mapi_req_0;
 	TALLOC_CTX *_mem_save_handles_0;
@@ -588,13 +692,20 @@ enum ndr_err_code ndr_pull_mapi_request(struct ndr_pull *ndr, int ndr_flags, str
 	if (r->length > sizeof (uint16_t)) {
 		NDR_CHECK(ndr_pull_subcontext_start(ndr, &_ndr_mapi_req, 0, r->length - 2));
 		_mem_save_mapi_req_0 = NDR_PULL_GET_MEM_CTX(_ndr_mapi_req);
-		r->mapi_req = talloc_zero(_mem_save_mapi_req_0, struct EcDoRpc_MAPI_REQ);
+		/* grow the array geometrically rather than once per ROP */
+		size = 8;
+		r->mapi_req = talloc_array(_mem_save_mapi_req_0, struct EcDoRpc_MAPI_REQ, size);
+		NDR_ERR_HAVE_NO_MEMORY(r->mapi_req);
 		for (cntr_mapi_req_0 = 0; _ndr_mapi_req->offset < _ndr_mapi_req->data_size - 2; cntr_mapi_req_0++) {
+			if (cntr_mapi_req_0 + 1 >= size) {
+				size *= 2;
+				r->mapi_req = talloc_realloc(_mem_save_mapi_req_0, r->mapi_req, struct EcDoRpc_MAPI_REQ, size);
+				NDR_ERR_HAVE_NO_MEMORY(r->mapi_req);
+			}
+			memset(&r->mapi_req[cntr_mapi_req_0], 0, sizeof (struct EcDoRpc_MAPI_REQ));
 			NDR_CHECK(ndr_pull_EcDoRpc_MAPI_REQ(_ndr_mapi_req, NDR_SCALARS, &r->mapi_req[cntr_mapi_req_0]));
-			r->mapi_req = talloc_realloc(_mem_save_mapi_req_0, r->mapi_req, struct EcDoRpc_MAPI_REQ, cntr_mapi_req_0 + 2);
 		}
-		r->mapi_req = talloc_realloc(_mem_save_mapi_req_0, r->mapi_req, struct EcDoRpc_MAPI_REQ, cntr_mapi_req_0 + 2);
-		r->mapi_req[cntr_mapi_req_0].opnum = 0;
+		memset(&r->mapi_req[cntr_mapi_req_0], 0, sizeof (struct EcDoRpc_MAPI_REQ));
 		
 		if (_ndr_mapi_req->offset != r->length - 2) {
 			return NDR_ERR_BUFSIZE;
@@ -952,8 +1063,10 @@ _PUBLIC_ enum ndr_err_code ndr_push_EcDoRpc(struct ndr_push *ndr, int flags, con
 				struct ndr_push *_ndr_mapi_request;
 				NDR_CHECK(ndr_push_subcontext_start(ndr, &_ndr_mapi_request, 4, -1));
 				NDR_CHECK(ndr_push_mapi_request(_ndr_mapi_request, NDR_SCALARS|NDR_BUFFERS, r->in.mapi_request));
-				obfuscate_data(_ndr_mapi_request->data, _ndr_mapi_request->offset, 0xA5);
-				NDR_CHECK(ndr_push_subcontext_end(ndr, _ndr_mapi_request, 4, -1));
+				/* same as ndr_push_subcontext_end(), obfuscating while copying */
+				NDR_CHECK(ndr_push_uint32(ndr, NDR_SCALARS, _ndr_mapi_request->offset));
+				NDR_CHECK(ndr_push_obfuscated_bytes(ndr, _ndr_mapi_request->data, _ndr_mapi_request->offset, 0xA5));
+				talloc_free(_ndr_mapi_request);
 			}
 			ndr->flags = _flags_save_mapi_request;
 		}
@@ -980,8 +1093,10 @@ _PUBLIC_ enum ndr_err_code ndr_push_EcDoRpc(struct ndr_push *ndr, int flags, con
 				struct ndr_push *_ndr_mapi_response;
 				NDR_CHECK(ndr_push_subcontext_start(ndr, &_ndr_mapi_response, 4, -1));
 				NDR_CHECK(ndr_push_mapi_response(_ndr_mapi_response, NDR_SCALARS|NDR_BUFFERS, r->out.mapi_response));
-				obfuscate_data(_ndr_mapi_response->data, _ndr_mapi_response->alloc_size, 0xA5);
-				NDR_CHECK(ndr_push_subcontext_end(ndr, _ndr_mapi_response, 4, -1));
+				/* same as ndr_push_subcontext_end(), obfuscating while copying */
+				NDR_CHECK(ndr_push_uint32(ndr, NDR_SCALARS, _ndr_mapi_response->offset));
+				NDR_CHECK(ndr_push_obfuscated_bytes(ndr, _ndr_mapi_response->data, _ndr_mapi_response->offset, 0xA5));
+				talloc_free(_ndr_mapi_response);
 			}
 			ndr->flags = _flags_save_mapi_response;
 		}
@@ -2120,6 +2235,56 @@ _PUBLIC_ void ndr_print_RestrictionVariable(struct ndr_print *ndr, const char *n
 	}
 }
 
+/*
+  Stream data carried by requests is not copied: the DATA_BLOB points
+  into the buffer being pulled, which stays valid until the
+  transaction is complete. ROP handlers copy what they need to keep.
+*/
+
+static enum ndr_err_code ndr_pull_DATA_BLOB_view(struct ndr_pull *ndr, uint32_t length, DATA_BLOB *blob)
+{
+	NDR_PULL_NEED_BYTES(ndr, length);
+	blob->data = length ? ndr->data + ndr->offset : NULL;
+	blob->length = length;
+	ndr->offset += length;
+
+	return NDR_ERR_SUCCESS;
+}
+
+enum ndr_err_code ndr_pull_WriteStream_req(struct ndr_pull *ndr, int ndr_flags, struct WriteStream_req *r)
+{
+	uint16_t	length;
+
+	if (ndr_flags & NDR_SCALARS) {
+		NDR_CHECK(ndr_pull_uint16(ndr, NDR_SCALARS, &length));
+		NDR_CHECK(ndr_pull_DATA_BLOB_view(ndr, length, &r->data));
+	}
+
+	return NDR_ERR_SUCCESS;
+}
+
+enum ndr_err_code ndr_pull_WriteAndCommitStream_req(struct ndr_pull *ndr, int ndr_flags, struct WriteAndCommitStream_req *r)
+{
+	uint16_t	length;
+
+	if (ndr_flags & NDR_SCALARS) {
+		NDR_CHECK(ndr_pull_uint16(ndr, NDR_SCALARS, &length));
+		NDR_CHECK(ndr_pull_DATA_BLOB_view(ndr, length, &r->data));
+	}
+
+	return NDR_ERR_SUCCESS;
+}
+
+enum ndr_err_code ndr_pull_FastTransferDestinationPutBuffer_req(struct ndr_pull *ndr, int ndr_flags, struct FastTransferDestinationPutBuffer_req *r)
+{
+	if (ndr_flags & NDR_SCALARS) {
+		NDR_CHECK(ndr_pull_uint16(ndr, NDR_SCALARS, &r->TransferBufferSize));
+		NDR_CHECK(ndr_pull_DATA_BLOB_view(ndr, r->TransferBufferSize, &r->TransferBuffer));
+	}
+
+	return NDR_ERR_SUCCESS;
+}
+
 enum ndr_err_code ndr_push_Release_req(struct ndr_push *ndr, int ndr_flags, const struct Release_req *r)
 {
 	return NDR_ERR_SUCCESS;
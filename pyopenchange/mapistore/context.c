@@ -105,7 +105,6 @@ static PyObject *py_MAPIStoreContext_register_subscription(PyMAPIStoreContextObj
 	 * existing mapistore_notification.c implementation */
 	if (ret == MAPISTORE_SUCCESS) {
 		subscription_list = talloc_zero(self->mstore_ctx, struct mapistore_subscription_list);
-		DLIST_ADD(self->mstore_ctx->subscriptions, subscription_list);
 
 		subscription_params.folder_id = n.FolderID;
 		subscription_params.object_id = n.MessageID;
@@ -121,6 +120,10 @@ static PyObject *py_MAPIStoreContext_register_subscription(PyMAPIStoreContextObj
 							  random_int, n.NotificationFlags, 
 							  &subscription_params);
 		subscription_list->subscription = subscription;
+		ret = mapistore_add_subscription(self->mstore_ctx, subscription_list);
+		if (ret != MAPISTORE_SUCCESS) {
+			talloc_free(subscription_list);
+		}
 	}
 
 	return PyInt_FromLong(!ret ? random_int : -1);
@@ -0,0 +1,129 @@
+/*
+   OpenChange benchmark helpers
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testprogs/bench.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/**
+   \file bench.c
+
+   \brief Timing and result helpers shared by the bench_* programs
+
+   Every benchmark checks the behaviour it measures with bench_check()
+   and exits through bench_result(), so a run fails as soon as the
+   measured code returns wrong results, whatever its speed.
+ */
+
+/**
+   \details Retrieve the monotonic clock
+
+   \return the current time in microseconds
+ */
+uint64_t bench_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/**
+   \details Convert a count measured over a duration to a rate
+
+   \param count the number of items processed
+   \param usec the duration in microseconds
+
+   \return the number of items per second, 0 if the duration is 0
+ */
+uint64_t bench_rate(uint64_t count, uint64_t usec)
+{
+	if (!usec) return 0;
+
+	return (count * 1000000) / usec;
+}
+
+
+/**
+   \details Retrieve the maximum resident set size of the process
+
+   \return the maximum resident set size in kB
+ */
+long bench_maxrss(void)
+{
+	struct rusage	usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss;
+}
+
+
+/**
+   \details Check a benchmark expectation and report it when it fails
+
+   \param errors pointer to the error counter to increment on failure
+   \param cond the expectation
+   \param fmt format of the message printed on failure
+
+   \return cond
+ */
+bool bench_check(uint32_t *errors, bool cond, const char *fmt, ...)
+{
+	va_list	ap;
+
+	if (cond) return true;
+
+	va_start(ap, fmt);
+	printf("FAILED: ");
+	vprintf(fmt, ap);
+	printf("\n");
+	va_end(ap);
+	(*errors)++;
+
+	return false;
+}
+
+
+/**
+   \details Print the result of a benchmark
+
+   \param errors the number of failed checks
+
+   \return the exit code of the benchmark
+ */
+int bench_result(uint32_t errors)
+{
+	if (errors) {
+		printf("FAILURE: %u error(s)\n", errors);
+		return 1;
+	}
+
+	printf("SUCCESS\n");
+
+	return 0;
+}
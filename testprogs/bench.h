@@ -0,0 +1,36 @@
+/*
+   OpenChange benchmark helpers
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef	__BENCH_H__
+#define	__BENCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define	BENCH_DEFAULT_PROFDB	"%s/.openchange/profiles.ldb"
+
+uint64_t	bench_now(void);
+uint64_t	bench_rate(uint64_t, uint64_t);
+long		bench_maxrss(void);
+bool		bench_check(uint32_t *, bool, const char *, ...) __attribute__ ((format (printf, 3, 4)));
+int		bench_result(uint32_t);
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,372 @@
+/*
+   Benchmark bulk message import
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libmapi/libmapi.h"
+#include "libmapi/fxics.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+
+/**
+   \file bench_fximport.c
+
+   \brief Measure message import throughput
+
+   Messages with one recipient, a body of a given size and optionally
+   an attachment are imported in the receive folder of the default
+   profile, either with the FastTransfer bulk import API or with one
+   CreateMessage, SetProps, ModifyRecipients, CreateAttach and
+   SaveChanges sequence per message.
+
+   The number of messages in the folder must grow by the number of
+   imported messages, and the bulk import must report every message
+   and upload them in buffers no larger than the requested size.
+ */
+
+struct bench_data {
+	struct SPropValue		props[4];
+	struct SPropValue		recip_props[3];
+	struct SRow			recip_row;
+	struct SRowSet			recipients;
+	struct SPropValue		attach_props[3];
+	struct fx_import_attachment	attachment;
+	struct fx_import_message	message;
+	char				*body;
+	struct Binary_r			attach_bin;
+	uint64_t			bytes;
+};
+
+/**
+   \details Build the message imported by both methods
+
+   \param mem_ctx pointer to the memory context
+   \param data pointer to the message data to fill
+   \param body_size size of the message body
+   \param attach_size size of the attachment, 0 for no attachment
+ */
+static void bench_message(TALLOC_CTX *mem_ctx, struct bench_data *data, uint32_t body_size, uint32_t attach_size)
+{
+	uint32_t	i;
+	uint32_t	flags = MSGFLAG_READ;
+	uint32_t	recip_type = MAPI_TO;
+	uint32_t	attach_method = ATTACH_BY_VALUE;
+
+	data->body = talloc_array(mem_ctx, char, body_size + 1);
+	for (i = 0; i < body_size; i++) {
+		data->body[i] = 'a' + (i % 26);
+	}
+	data->body[body_size] = '\0';
+
+	set_SPropValue_proptag(&data->props[0], PR_MESSAGE_CLASS_UNICODE, (const void *)"IPM.Note");
+	set_SPropValue_proptag(&data->props[1], PR_SUBJECT_UNICODE, (const void *)"bench_fximport");
+	set_SPropValue_proptag(&data->props[2], PR_BODY_UNICODE, (const void *)data->body);
+	set_SPropValue_proptag(&data->props[3], PR_MESSAGE_FLAGS, (const void *)&flags);
+
+	set_SPropValue_proptag(&data->recip_props[0], PR_RECIPIENT_TYPE, (const void *)&recip_type);
+	set_SPropValue_proptag(&data->recip_props[1], PR_DISPLAY_NAME_UNICODE, (const void *)"bench_fximport");
+	set_SPropValue_proptag(&data->recip_props[2], PR_SMTP_ADDRESS_UNICODE, (const void *)"bench@example.com");
+	data->recip_row.cValues = 3;
+	data->recip_row.lpProps = data->recip_props;
+	data->recipients.cRows = 1;
+	data->recipients.aRow = &data->recip_row;
+
+	memset(&data->message, 0, sizeof (struct fx_import_message));
+	data->message.cValues = 4;
+	data->message.lpProps = data->props;
+	data->message.recipients = &data->recipients;
+	data->bytes = body_size;
+
+	if (attach_size) {
+		data->attach_bin.cb = attach_size;
+		data->attach_bin.lpb = talloc_array(mem_ctx, uint8_t, attach_size);
+		for (i = 0; i < attach_size; i++) {
+			data->attach_bin.lpb[i] = i & 0xFF;
+		}
+		set_SPropValue_proptag(&data->attach_props[0], PR_ATTACH_METHOD, (const void *)&attach_method);
+		set_SPropValue_proptag(&data->attach_props[1], PR_ATTACH_FILENAME_UNICODE, (const void *)"bench.bin");
+		set_SPropValue_proptag(&data->attach_props[2], PR_ATTACH_DATA_BIN, (const void *)&data->attach_bin);
+		data->attachment.cValues = 3;
+		data->attachment.lpProps = data->attach_props;
+		data->attachment.embedded = NULL;
+		data->message.attachment_count = 1;
+		data->message.attachments = &data->attachment;
+		data->bytes += attach_size;
+	}
+}
+
+static enum MAPISTATUS bench_import(TALLOC_CTX *mem_ctx, mapi_object_t *obj_folder,
+				    struct bench_data *data, uint32_t count, uint16_t buffer_size,
+				    uint32_t *errors)
+{
+	enum MAPISTATUS			retval;
+	struct fx_import_context	*ctx;
+	uint32_t			messages;
+	uint32_t			buffers;
+	uint64_t			bytes;
+	uint32_t			i;
+
+	retval = fximport_init(mem_ctx, obj_folder, &ctx);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	retval = fximport_set_buffer_size(ctx, buffer_size);
+	for (i = 0; retval == MAPI_E_SUCCESS && i < count; i++) {
+		retval = fximport_add_message(ctx, &data->message);
+	}
+	if (retval == MAPI_E_SUCCESS) {
+		retval = fximport_commit(ctx);
+	}
+
+	fximport_get_stats(ctx, &messages, &buffers, &bytes);
+	printf("import:    %u messages, %u buffers, %"PRIu64" bytes uploaded\n", messages, buffers, bytes);
+	talloc_free(ctx);
+
+	if (retval == MAPI_E_SUCCESS) {
+		bench_check(errors, messages == count, "%u messages imported instead of %u", messages, count);
+		bench_check(errors, buffers && bytes <= (uint64_t)buffers * buffer_size,
+			    "%"PRIu64" bytes uploaded in %u buffers of %u bytes", bytes, buffers, buffer_size);
+		bench_check(errors, bytes >= data->bytes * count,
+			    "%"PRIu64" bytes uploaded for %"PRIu64" bytes of data", bytes, data->bytes * count);
+	}
+
+	return retval;
+}
+
+static enum MAPISTATUS bench_classic(mapi_object_t *obj_folder, struct bench_data *data, uint32_t count)
+{
+	enum MAPISTATUS		retval = MAPI_E_SUCCESS;
+	mapi_object_t		obj_message;
+	mapi_object_t		obj_attach;
+	uint32_t		i;
+
+	for (i = 0; retval == MAPI_E_SUCCESS && i < count; i++) {
+		mapi_object_init(&obj_message);
+		retval = CreateMessage(obj_folder, &obj_message);
+		if (retval != MAPI_E_SUCCESS) break;
+
+		retval = SetProps(&obj_message, 0, data->props, data->message.cValues);
+		if (retval == MAPI_E_SUCCESS) {
+			retval = ModifyRecipients(&obj_message, &data->recipients);
+		}
+		if (retval == MAPI_E_SUCCESS && data->message.attachment_count) {
+			mapi_object_init(&obj_attach);
+			retval = CreateAttach(&obj_message, &obj_attach);
+			if (retval == MAPI_E_SUCCESS) {
+				retval = SetProps(&obj_attach, 0, data->attach_props, data->attachment.cValues);
+			}
+			if (retval == MAPI_E_SUCCESS) {
+				retval = SaveChangesAttachment(&obj_message, &obj_attach, KeepOpenReadOnly);
+			}
+			mapi_object_release(&obj_attach);
+		}
+		if (retval == MAPI_E_SUCCESS) {
+			retval = SaveChangesMessage(obj_folder, &obj_message, KeepOpenReadOnly);
+		}
+		mapi_object_release(&obj_message);
+	}
+
+	return retval;
+}
+
+static void bench_report(const char *name, uint32_t count, uint64_t bytes, uint64_t usec)
+{
+	printf("%-9s  %u messages in %"PRIu64" usec: %"PRIu64" messages/s, %.2f MB/s\n",
+	       name, count, usec,
+	       bench_rate(count, usec), (double)bench_rate(bytes * count, usec) / (1024 * 1024));
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX			*mem_ctx;
+	enum MAPISTATUS			retval;
+	struct mapi_context		*mapi_ctx;
+	struct mapi_session		*session = NULL;
+	struct bench_data		data;
+	mapi_object_t			obj_store;
+	mapi_object_t			obj_folder;
+	mapi_id_t			fid;
+	poptContext			pc;
+	int				opt;
+	int				exit_code = 0;
+	uint64_t			start;
+	uint32_t			errors = 0;
+	uint32_t			unread;
+	uint32_t			before;
+	uint32_t			after;
+	const char			*opt_profdb = NULL;
+	char				*opt_profname = NULL;
+	const char			*opt_password = NULL;
+	const char			*opt_debug = NULL;
+	uint32_t			opt_messages = 1000;
+	uint32_t			opt_body = 4096;
+	uint32_t			opt_attach = 0;
+	uint32_t			opt_buffer = FXIMPORT_BUFFER_SIZE;
+	bool				opt_classic = false;
+
+	enum { OPT_PROFILE_DB=1000, OPT_PROFILE, OPT_PASSWORD, OPT_DEBUG, OPT_MESSAGES,
+	       OPT_BODY, OPT_ATTACH, OPT_BUFFER, OPT_CLASSIC };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "database", 'f', POPT_ARG_STRING, NULL, OPT_PROFILE_DB, "set the profile database path", "PATH" },
+		{ "profile", 'p', POPT_ARG_STRING, NULL, OPT_PROFILE, "set the profile name", "PROFILE" },
+		{ "password", 'P', POPT_ARG_STRING, NULL, OPT_PASSWORD, "set the profile password", "PASSWORD" },
+		{ "debuglevel", 'd', POPT_ARG_STRING, NULL, OPT_DEBUG, "set the debug level", "LEVEL" },
+		{ "messages", 'm', POPT_ARG_STRING, NULL, OPT_MESSAGES, "number of messages (default: 1000)", "COUNT" },
+		{ "body", 'b', POPT_ARG_STRING, NULL, OPT_BODY, "body size in bytes (default: 4096)", "BYTES" },
+		{ "attach", 'a', POPT_ARG_STRING, NULL, OPT_ATTACH, "attachment size in bytes (default: none)", "BYTES" },
+		{ "buffer", 0, POPT_ARG_STRING, NULL, OPT_BUFFER, "FXPutBuffer size (default: 0x7800)", "BYTES" },
+		{ "classic", 0, POPT_ARG_NONE, NULL, OPT_CLASSIC, "also import messages one at a time for comparison", NULL },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	mem_ctx = talloc_named(NULL, 0, "bench_fximport");
+
+	pc = poptGetContext("bench_fximport", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_PROFILE_DB:
+			opt_profdb = poptGetOptArg(pc);
+			break;
+		case OPT_PROFILE:
+			opt_profname = talloc_strdup(mem_ctx, poptGetOptArg(pc));
+			break;
+		case OPT_PASSWORD:
+			opt_password = poptGetOptArg(pc);
+			break;
+		case OPT_DEBUG:
+			opt_debug = poptGetOptArg(pc);
+			break;
+		case OPT_MESSAGES:
+			opt_messages = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_BODY:
+			opt_body = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_ATTACH:
+			opt_attach = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_BUFFER:
+			opt_buffer = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_CLASSIC:
+			opt_classic = true;
+			break;
+		}
+	}
+	poptFreeContext(pc);
+
+	if (!opt_buffer || opt_buffer > FXIMPORT_BUFFER_SIZE) {
+		fprintf(stderr, "Invalid buffer size\n");
+		exit (1);
+	}
+
+	if (!opt_profdb) {
+		opt_profdb = talloc_asprintf(mem_ctx, BENCH_DEFAULT_PROFDB, getenv("HOME"));
+	}
+
+	retval = MAPIInitialize(&mapi_ctx, opt_profdb);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("MAPIInitialize", retval);
+		exit (1);
+	}
+
+	if (opt_debug) {
+		SetMAPIDebugLevel(mapi_ctx, atoi(opt_debug));
+	}
+
+	mapi_object_init(&obj_store);
+	mapi_object_init(&obj_folder);
+
+	if (!opt_profname) {
+		retval = GetDefaultProfile(mapi_ctx, &opt_profname);
+		if (retval != MAPI_E_SUCCESS) {
+			printf("No profile specified and no default profile found\n");
+			exit_code = 1;
+			goto cleanup;
+		}
+	}
+
+	retval = MapiLogonEx(mapi_ctx, &session, opt_profname, opt_password);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("MapiLogonEx", retval);
+		exit_code = 1;
+		goto cleanup;
+	}
+
+	retval = OpenMsgStore(session, &obj_store);
+	if (retval == MAPI_E_SUCCESS) {
+		retval = GetReceiveFolder(&obj_store, &fid, NULL);
+	}
+	if (retval == MAPI_E_SUCCESS) {
+		retval = OpenFolder(&obj_store, fid, &obj_folder);
+	}
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("OpenFolder", retval);
+		exit_code = 1;
+		goto cleanup;
+	}
+
+	bench_message(mem_ctx, &data, opt_body, opt_attach);
+
+	retval = GetFolderItemsCount(&obj_folder, &unread, &before);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("GetFolderItemsCount", retval);
+		exit_code = 1;
+		goto cleanup;
+	}
+
+	start = bench_now();
+	retval = bench_import(mem_ctx, &obj_folder, &data, opt_messages, opt_buffer, &errors);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("fximport", retval);
+		exit_code = 1;
+		goto cleanup;
+	}
+	bench_report("fximport", opt_messages, data.bytes, bench_now() - start);
+
+	if (opt_classic) {
+		start = bench_now();
+		retval = bench_classic(&obj_folder, &data, opt_messages);
+		if (retval != MAPI_E_SUCCESS) {
+			mapi_errstr("classic", retval);
+			exit_code = 1;
+			goto cleanup;
+		}
+		bench_report("classic", opt_messages, data.bytes, bench_now() - start);
+	}
+
+	retval = GetFolderItemsCount(&obj_folder, &unread, &after);
+	if (bench_check(&errors, retval == MAPI_E_SUCCESS, "unable to count the folder messages")) {
+		bench_check(&errors, after - before == opt_messages * (opt_classic ? 2 : 1),
+			    "%u messages added to the folder instead of %u", after - before,
+			    opt_messages * (opt_classic ? 2 : 1));
+	}
+	exit_code = bench_result(errors);
+
+cleanup:
+	mapi_object_release(&obj_folder);
+	mapi_object_release(&obj_store);
+	MAPIUninitialize(mapi_ctx);
+	talloc_free(mem_ctx);
+
+	return exit_code;
+}
@@ -0,0 +1,261 @@
+/*
+   Benchmark the FastTransfer stream parser
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libmapi/libmapi.h"
+#include "libmapi/fxics.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+
+/**
+   \file bench_fxparser.c
+
+   \brief Parse a large synthetic FastTransfer stream
+
+   The stream is a sequence of messages, each with one attachment,
+   generated on the fly and fed to the parser in FXGetBuffer sized
+   chunks. The resident set size is sampled while parsing: it must not
+   grow with the size of the stream. Every marker, property and
+   attachment byte must be reported, and the subject must be decoded
+   intact across buffer boundaries.
+ */
+
+#define	BENCH_SUBJECT	"fxparser benchmark"
+
+struct bench_ctx {
+	uint64_t	markers;
+	uint64_t	properties;
+	uint64_t	chunks;
+	uint64_t	attach_bytes;
+	uint32_t	errors;
+};
+
+static enum MAPISTATUS bench_marker(uint32_t marker, void *priv)
+{
+	struct bench_ctx	*bench = priv;
+
+	bench->markers++;
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS bench_property(struct SPropValue prop, void *priv)
+{
+	struct bench_ctx	*bench = priv;
+
+	bench->properties++;
+	if (prop.ulPropTag == PR_ATTACH_DATA_BIN) {
+		bench->attach_bytes += prop.value.bin.cb;
+	}
+	if (prop.ulPropTag == PR_SUBJECT_UNICODE) {
+		bench_check(&bench->errors, prop.value.lpszW && !strcmp(prop.value.lpszW, BENCH_SUBJECT),
+			    "subject decoded as \"%s\"", prop.value.lpszW ? prop.value.lpszW : "(null)");
+	}
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS bench_stream(uint32_t proptag, uint32_t offset, uint32_t length,
+				    DATA_BLOB chunk, void *priv)
+{
+	struct bench_ctx	*bench = priv;
+
+	bench->chunks++;
+	if (proptag == PR_ATTACH_DATA_BIN) {
+		bench->attach_bytes += chunk.length;
+	}
+	if (offset + chunk.length == length) {
+		bench->properties++;
+	}
+	return MAPI_E_SUCCESS;
+}
+
+static void push_uint32(DATA_BLOB *blob, uint32_t val)
+{
+	blob->data[blob->length++] = val & 0xFF;
+	blob->data[blob->length++] = (val >> 8) & 0xFF;
+	blob->data[blob->length++] = (val >> 16) & 0xFF;
+	blob->data[blob->length++] = (val >> 24) & 0xFF;
+}
+
+/**
+   \details Build the FastTransfer serialization of one message
+
+   \param mem_ctx pointer to the memory context
+   \param attach_size size of the attachment data
+
+   \return the serialized message
+ */
+static DATA_BLOB bench_message(TALLOC_CTX *mem_ctx, uint32_t attach_size)
+{
+	const char	*subject = BENCH_SUBJECT;
+	DATA_BLOB	blob;
+	uint32_t	i;
+
+	blob.data = talloc_array(mem_ctx, uint8_t, attach_size + 256);
+	blob.length = 0;
+
+	push_uint32(&blob, StartMessage);
+	push_uint32(&blob, PR_MESSAGE_FLAGS);
+	push_uint32(&blob, 0x1);
+	push_uint32(&blob, PR_SUBJECT_UNICODE);
+	push_uint32(&blob, (strlen(subject) + 1) * 2);
+	for (i = 0; i <= strlen(subject); i++) {
+		blob.data[blob.length++] = subject[i];
+		blob.data[blob.length++] = 0;
+	}
+	push_uint32(&blob, NewAttach);
+	push_uint32(&blob, PR_ATTACH_NUM);
+	push_uint32(&blob, 0);
+	push_uint32(&blob, PR_ATTACH_DATA_BIN);
+	push_uint32(&blob, attach_size);
+	for (i = 0; i < attach_size; i++) {
+		blob.data[blob.length++] = i & 0xFF;
+	}
+	push_uint32(&blob, EndAttach);
+	push_uint32(&blob, EndMessage);
+
+	return blob;
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX			*mem_ctx;
+	struct fx_parser_context	*parser;
+	struct bench_ctx		bench;
+	enum MAPISTATUS			retval;
+	poptContext			pc;
+	int				opt;
+	DATA_BLOB			message;
+	DATA_BLOB			buffer;
+	uint64_t			total;
+	uint64_t			target;
+	uint64_t			messages = 0;
+	uint64_t			start;
+	uint64_t			usec;
+	uint32_t			offset = 0;
+	uint32_t			opt_size = 2048;
+	uint32_t			opt_attach = 4 * 1024 * 1024;
+	uint32_t			opt_buffer = 0x7800;
+	bool				opt_stream = true;
+	long				rss_early = 0;
+	long				rss_final;
+
+	enum { OPT_SIZE=1000, OPT_ATTACH, OPT_BUFFER, OPT_NOSTREAM };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "size", 's', POPT_ARG_STRING, NULL, OPT_SIZE, "stream size in MB (default: 2048)", "MB" },
+		{ "attach", 'a', POPT_ARG_STRING, NULL, OPT_ATTACH, "attachment size in bytes (default: 4MB)", "BYTES" },
+		{ "buffer", 'b', POPT_ARG_STRING, NULL, OPT_BUFFER, "FastTransfer buffer size (default: 0x7800)", "BYTES" },
+		{ "no-stream", 0, POPT_ARG_NONE, NULL, OPT_NOSTREAM, "buffer attachments instead of streaming them", NULL },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	pc = poptGetContext("bench_fxparser", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_SIZE:
+			opt_size = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_ATTACH:
+			opt_attach = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_BUFFER:
+			opt_buffer = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_NOSTREAM:
+			opt_stream = false;
+			break;
+		}
+	}
+	poptFreeContext(pc);
+
+	if (!opt_buffer) {
+		fprintf(stderr, "Invalid buffer size\n");
+		exit (1);
+	}
+
+	mem_ctx = talloc_named(NULL, 0, "bench_fxparser");
+	memset(&bench, 0, sizeof (struct bench_ctx));
+
+	message = bench_message(mem_ctx, opt_attach);
+
+	parser = fxparser_init(mem_ctx, &bench);
+	fxparser_set_marker_callback(parser, bench_marker);
+	fxparser_set_property_callback(parser, bench_property);
+	if (opt_stream) {
+		fxparser_set_stream_callback(parser, bench_stream, 0x1000);
+	}
+
+	target = (uint64_t)opt_size * 1024 * 1024;
+	start = bench_now();
+	for (total = 0; total < target || offset; total += buffer.length) {
+		/* feed the message template as a circular stream */
+		buffer.data = message.data + offset;
+		buffer.length = message.length - offset;
+		if (buffer.length > opt_buffer) {
+			buffer.length = opt_buffer;
+		}
+		offset += buffer.length;
+		if (offset == message.length) {
+			offset = 0;
+			messages++;
+		}
+
+		retval = fxparser_parse(parser, &buffer);
+		if (retval != MAPI_E_SUCCESS) {
+			mapi_errstr("fxparser_parse", retval);
+			exit (1);
+		}
+
+		if (!rss_early && total >= target / 10) {
+			rss_early = bench_maxrss();
+		}
+	}
+	usec = bench_now() - start;
+	rss_final = bench_maxrss();
+
+	printf("stream:        %"PRIu64" bytes, %"PRIu64" messages\n", total, messages);
+	printf("mode:          %s\n", opt_stream ? "streamed attachments" : "buffered attachments");
+	printf("markers:       %"PRIu64"\n", bench.markers);
+	printf("properties:    %"PRIu64"\n", bench.properties);
+	printf("chunks:        %"PRIu64"\n", bench.chunks);
+	printf("time:          %"PRIu64" usec (%"PRIu64" MB/s)\n", usec,
+	       bench_rate(total, usec) / (1024 * 1024));
+	printf("max RSS:       %ld kB after 10%%, %ld kB at end\n", rss_early, rss_final);
+
+	talloc_free(mem_ctx);
+
+	/* StartMessage, NewAttach, EndAttach and EndMessage */
+	bench_check(&bench.errors, bench.markers == messages * 4,
+		    "%"PRIu64" markers for %"PRIu64" messages", bench.markers, messages);
+	/* PR_MESSAGE_FLAGS, PR_SUBJECT_UNICODE, PR_ATTACH_NUM and PR_ATTACH_DATA_BIN */
+	bench_check(&bench.errors, bench.properties == messages * 4,
+		    "%"PRIu64" properties for %"PRIu64" messages", bench.properties, messages);
+	bench_check(&bench.errors, bench.attach_bytes == messages * opt_attach,
+		    "%"PRIu64" attachment bytes for %"PRIu64" messages", bench.attach_bytes, messages);
+
+	/* memory must not grow with the stream size */
+	bench_check(&bench.errors, rss_final - rss_early <= 4096,
+		    "RSS grew by %ld kB", rss_final - rss_early);
+
+	return bench_result(bench.errors);
+}
@@ -0,0 +1,294 @@
+/*
+   Benchmark the decoding of EcDoRpcExt2 ROP requests
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libmapi/libmapi.h"
+#include <ndr.h>
+#include "gen_ndr/ndr_exchange.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+
+/**
+   \file bench_ndr_mapi.c
+
+   \brief Measure allocations and throughput of the mapi_request decoder
+
+   Each capture is the NDR_IN part of a recorded EcDoRpcExt2 call, as
+   found in utils/mapitest/data/lzxpress. The rgbIn buffer of every
+   capture is decoded repeatedly, with each request allocated either
+   from a plain talloc context or from a talloc pool sized from the
+   request length, as the emsmdb server does.
+
+   A synthetic request made of many WriteStream ROPs is decoded first:
+   every ROP must be returned, followed by the terminating entry, and
+   the stream data must point into the request buffer instead of being
+   copied.
+ */
+
+#define	BENCH_DATADIR		"utils/mapitest/data/lzxpress"
+#define	BENCH_POOL_BASE		0x10000
+#define	BENCH_STREAM_ROPS	100
+
+struct bench_capture {
+	const char	*filename;
+	uint8_t		*rgbIn;
+	uint32_t	cbIn;
+	uint8_t		*scratch;
+	uint32_t	rops;
+	size_t		blocks;
+};
+
+static bool bench_load(TALLOC_CTX *mem_ctx, const char *filename, struct bench_capture *capture)
+{
+	struct ndr_pull		*ndr_pull;
+	struct EcDoRpcExt2	r;
+	enum ndr_err_code	ndr_err;
+	DATA_BLOB		blob;
+	size_t			size;
+
+	blob.data = (uint8_t *) file_load(filename, &size, 0, mem_ctx);
+	if (!blob.data) {
+		perror(filename);
+		return false;
+	}
+	blob.length = size;
+
+	ndr_pull = ndr_pull_init_blob(&blob, mem_ctx);
+	ndr_pull->flags |= LIBNDR_FLAG_REF_ALLOC;
+	ndr_err = ndr_pull_EcDoRpcExt2(ndr_pull, NDR_IN, &r);
+	if (!NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		fprintf(stderr, "%s: not an EcDoRpcExt2 request\n", filename);
+		return false;
+	}
+
+	capture->filename = filename;
+	capture->rgbIn = talloc_memdup(mem_ctx, r.in.rgbIn, r.in.cbIn);
+	capture->cbIn = r.in.cbIn;
+	capture->scratch = talloc_array(mem_ctx, uint8_t, r.in.cbIn);
+	talloc_free(ndr_pull);
+	talloc_free(blob.data);
+
+	return true;
+}
+
+/**
+   \details Decode a capture once
+
+   \return true on success, otherwise false
+ */
+static bool bench_decode(struct bench_capture *capture, bool pool, uint32_t ratio, bool count)
+{
+	TALLOC_CTX		*mem_ctx;
+	struct ndr_pull		*ndr_pull;
+	struct mapi2k7_request	request;
+	enum ndr_err_code	ndr_err;
+	DATA_BLOB		blob;
+	uint32_t		i;
+
+	/* Obfuscated requests are decoded in place */
+	memcpy(capture->scratch, capture->rgbIn, capture->cbIn);
+	blob.data = capture->scratch;
+	blob.length = capture->cbIn;
+
+	if (pool) {
+		mem_ctx = talloc_pool(NULL, BENCH_POOL_BASE + capture->cbIn * ratio);
+	} else {
+		mem_ctx = talloc_new(NULL);
+	}
+
+	ndr_pull = ndr_pull_init_blob(&blob, mem_ctx);
+	ndr_set_flags(&ndr_pull->flags, LIBNDR_FLAG_NOALIGN|LIBNDR_FLAG_REF_ALLOC);
+	ndr_err = ndr_pull_mapi2k7_request(ndr_pull, NDR_SCALARS|NDR_BUFFERS, &request);
+
+	if (count && NDR_ERR_CODE_IS_SUCCESS(ndr_err)) {
+		capture->blocks = talloc_total_blocks(mem_ctx);
+		for (i = 0, capture->rops = 0; request.mapi_request->mapi_req && request.mapi_request->mapi_req[i].opnum; i++) {
+			capture->rops++;
+		}
+	}
+	talloc_free(mem_ctx);
+
+	return NDR_ERR_CODE_IS_SUCCESS(ndr_err);
+}
+
+/**
+   \details Decode a request of BENCH_STREAM_ROPS WriteStream ROPs and
+   check the decoded ROPs and their stream data
+
+   \param mem_ctx pointer to the memory context
+   \param errors pointer to the error counter
+ */
+static void bench_check_stream_views(TALLOC_CTX *mem_ctx, uint32_t *errors)
+{
+	struct ndr_push			*ndr_push;
+	struct ndr_pull			*ndr_pull;
+	struct mapi_request		request;
+	struct WriteStream_req		*req;
+	enum ndr_err_code		ndr_err;
+	DATA_BLOB			blob;
+	uint8_t				data[BENCH_STREAM_ROPS];
+	uint16_t			length;
+	uint32_t			i;
+
+	/* opnum, logon_id, handle_idx and i + 1 bytes of data per ROP */
+	length = 2;
+	for (i = 0; i < BENCH_STREAM_ROPS; i++) {
+		length += 3 + 2 + i + 1;
+	}
+
+	/* mapi_len, length, the ROPs and one handle */
+	ndr_push = ndr_push_init_ctx(mem_ctx);
+	ndr_set_flags(&ndr_push->flags, LIBNDR_FLAG_NOALIGN);
+	ndr_push_uint32(ndr_push, NDR_SCALARS, length + 4);
+	ndr_push_uint16(ndr_push, NDR_SCALARS, length);
+	for (i = 0; i < BENCH_STREAM_ROPS; i++) {
+		memset(data, i & 0xFF, i + 1);
+		ndr_push_uint8(ndr_push, NDR_SCALARS, op_MAPI_WriteStream);
+		ndr_push_uint8(ndr_push, NDR_SCALARS, 0);
+		ndr_push_uint8(ndr_push, NDR_SCALARS, 0);
+		ndr_push_uint16(ndr_push, NDR_SCALARS, i + 1);
+		ndr_push_bytes(ndr_push, data, i + 1);
+	}
+	ndr_push_uint32(ndr_push, NDR_SCALARS, 0x1234);
+	blob = ndr_push_blob(ndr_push);
+
+	ndr_pull = ndr_pull_init_blob(&blob, ndr_push);
+	ndr_set_flags(&ndr_pull->flags, LIBNDR_FLAG_NOALIGN|LIBNDR_FLAG_REF_ALLOC);
+	ndr_err = ndr_pull_mapi_request(ndr_pull, NDR_SCALARS|NDR_BUFFERS, &request);
+	if (!bench_check(errors, NDR_ERR_CODE_IS_SUCCESS(ndr_err), "unable to decode %u WriteStream ROPs", BENCH_STREAM_ROPS)) {
+		talloc_free(ndr_push);
+		return;
+	}
+
+	for (i = 0; request.mapi_req[i].opnum; i++) {
+		req = &request.mapi_req[i].u.mapi_WriteStream;
+		if (!bench_check(errors, req->data.length == i + 1, "ROP %u: %zu bytes of stream data", i, req->data.length)) {
+			break;
+		}
+		bench_check(errors, req->data.data > blob.data && req->data.data + req->data.length <= blob.data + blob.length,
+			    "ROP %u: stream data copied out of the request", i);
+		memset(data, i & 0xFF, i + 1);
+		bench_check(errors, !memcmp(req->data.data, data, i + 1), "ROP %u: wrong stream data", i);
+	}
+	bench_check(errors, i == BENCH_STREAM_ROPS, "%u ROPs decoded instead of %u", i, BENCH_STREAM_ROPS);
+	bench_check(errors, request.handles && request.handles[0] == 0x1234, "handle array not decoded");
+
+	talloc_free(ndr_push);
+}
+
+static uint64_t bench_run(struct bench_capture *captures, uint32_t count, uint32_t iterations,
+			  bool pool, uint32_t ratio, uint32_t *errors)
+{
+	uint64_t		start;
+	uint64_t		usec;
+	uint64_t		bytes = 0;
+	uint32_t		i;
+	uint32_t		j;
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < count; j++) {
+			if (!bench_decode(&captures[j], pool, ratio, false)) {
+				(*errors)++;
+			}
+			bytes += captures[j].cbIn;
+		}
+	}
+	usec = bench_now() - start;
+
+	printf("%-7s %u requests in %"PRIu64" usec: %"PRIu64" requests/s, %"PRIu64" kB/s\n",
+	       pool ? "pool" : "talloc", iterations * count, usec,
+	       bench_rate((uint64_t)iterations * count, usec), bench_rate(bytes, usec) / 1024);
+
+	return usec;
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX		*mem_ctx;
+	poptContext		pc;
+	int			opt;
+	const char		**files;
+	const char		*default_files[] = {
+		BENCH_DATADIR "/001_Outlook_2007_in_ModifyRecipients_comp.dat",
+		BENCH_DATADIR "/002_Outlook_2007_in_Tables_operations_comp.dat",
+		NULL
+	};
+	struct bench_capture	*captures;
+	uint32_t		count;
+	uint32_t		i;
+	uint32_t		opt_iterations = 100000;
+	uint32_t		opt_ratio = 8;
+	uint32_t		errors = 0;
+
+	enum { OPT_ITERATIONS=1000, OPT_RATIO };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "iterations", 'i', POPT_ARG_STRING, NULL, OPT_ITERATIONS, "number of times each capture is decoded (default: 100000)", "COUNT" },
+		{ "ratio", 'r', POPT_ARG_STRING, NULL, OPT_RATIO, "pool size per request byte (default: 8)", "RATIO" },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	pc = poptGetContext("bench_ndr_mapi", argc, argv, long_options, 0);
+	poptSetOtherOptionHelp(pc, "[CAPTURE...]");
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_ITERATIONS:
+			opt_iterations = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_RATIO:
+			opt_ratio = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		}
+	}
+
+	files = poptGetArgs(pc);
+	if (!files) {
+		files = default_files;
+	}
+
+	mem_ctx = talloc_named(NULL, 0, "bench_ndr_mapi");
+	bench_check_stream_views(mem_ctx, &errors);
+
+	for (count = 0; files[count]; count++);
+	captures = talloc_zero_array(mem_ctx, struct bench_capture, count);
+	for (i = 0; i < count; i++) {
+		if (!bench_load(mem_ctx, files[i], &captures[i])) {
+			exit (1);
+		}
+		if (!bench_decode(&captures[i], false, opt_ratio, true)) {
+			fprintf(stderr, "%s: unable to decode rgbIn\n", files[i]);
+			exit (1);
+		}
+		printf("%s: %u bytes, %u ROPs, %zu talloc blocks\n", captures[i].filename,
+		       captures[i].cbIn, captures[i].rops, captures[i].blocks);
+	}
+
+	bench_run(captures, count, opt_iterations, false, opt_ratio, &errors);
+	bench_run(captures, count, opt_iterations, true, opt_ratio, &errors);
+
+	talloc_free(mem_ctx);
+	poptFreeContext(pc);
+
+	return bench_result(errors);
+}
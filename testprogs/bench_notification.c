@@ -0,0 +1,346 @@
+/*
+   Benchmark notification delivery for many sessions in one thread
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libmapi/libmapi.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+#include <tevent.h>
+#include <poll.h>
+
+/**
+   \file bench_notification.c
+
+   \brief Deliver notifications to many sessions from a single thread
+
+   Opens a number of sessions on the same mailbox, subscribes to new
+   messages in the Inbox of each of them and waits for notifications
+   from one event loop: a poll() set of notification sockets, or the
+   libmapi event context when asynchronous notifications are used. A
+   message is then created in the Inbox and the time needed for every
+   session to receive the notification is reported. Every session must
+   receive exactly one notification.
+ */
+
+struct bench_session {
+	struct mapi_session	*session;
+	mapi_object_t		obj_store;
+	mapi_object_t		obj_inbox;
+	uint32_t		connection;
+	uint32_t		received;
+	bool			pending;
+	struct bench_ctx	*bench;
+};
+
+struct bench_ctx {
+	struct bench_session	*sessions;
+	uint32_t		count;
+	uint32_t		notified;
+	uint32_t		errors;
+};
+
+static int bench_callback(uint16_t NotificationType, void *NotificationData, void *private_data)
+{
+	struct bench_session	*bs = private_data;
+
+	if (!bs->received) {
+		bs->bench->notified++;
+	}
+	bs->received++;
+
+	return 0;
+}
+
+static void bench_async_done(struct tevent_req *req)
+{
+	struct bench_session	*bs = tevent_req_callback_data(req, struct bench_session);
+	enum MAPISTATUS		retval;
+	uint32_t		flag = 0;
+
+	retval = RegisterAsyncNotificationRecv(req, &flag);
+	talloc_free(req);
+	bs->pending = false;
+	if (retval != MAPI_E_SUCCESS) {
+		bs->bench->errors++;
+		return;
+	}
+
+	if (flag) {
+		DispatchNotifications(bs->session);
+	}
+
+	/* Keep watching the mailbox */
+	req = RegisterAsyncNotificationSend(bs->session, bs->session);
+	if (!req) {
+		bs->bench->errors++;
+		return;
+	}
+	tevent_req_set_callback(req, bench_async_done, bs);
+	bs->pending = true;
+}
+
+static enum MAPISTATUS bench_open(struct mapi_context *mapi_ctx, struct bench_session *bs,
+				  const char *profname, const char *password, bool async)
+{
+	enum MAPISTATUS		retval;
+	struct tevent_req	*req;
+	mapi_id_t		fid;
+
+	retval = MapiLogonEx(mapi_ctx, &bs->session, profname, password);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	mapi_object_init(&bs->obj_store);
+	retval = OpenMsgStore(bs->session, &bs->obj_store);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	retval = GetReceiveFolder(&bs->obj_store, &fid, NULL);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	mapi_object_init(&bs->obj_inbox);
+	retval = OpenFolder(&bs->obj_store, fid, &bs->obj_inbox);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	if (async) {
+		req = RegisterAsyncNotificationSend(bs->session, bs->session);
+		if (!req) return MAPI_E_CALL_FAILED;
+		tevent_req_set_callback(req, bench_async_done, bs);
+		bs->pending = true;
+	} else {
+		retval = RegisterNotification(bs->session);
+		if (retval != MAPI_E_SUCCESS) return retval;
+	}
+
+	return Subscribe(&bs->obj_inbox, &bs->connection, fnevObjectCreated, false,
+			 (mapi_notify_callback_t)bench_callback, bs);
+}
+
+static enum MAPISTATUS bench_create_message(mapi_object_t *obj_inbox, mapi_id_t *mid)
+{
+	enum MAPISTATUS		retval;
+	mapi_object_t		obj_message;
+	struct SPropValue	props[1];
+
+	mapi_object_init(&obj_message);
+	retval = CreateMessage(obj_inbox, &obj_message);
+	if (retval != MAPI_E_SUCCESS) return retval;
+
+	set_SPropValue_proptag(&props[0], PR_SUBJECT, (const void *)"bench_notification");
+	retval = SetProps(&obj_message, 0, props, 1);
+	if (retval == MAPI_E_SUCCESS) {
+		retval = SaveChangesMessage(obj_inbox, &obj_message, KeepOpenReadOnly);
+	}
+	*mid = mapi_object_get_id(&obj_message);
+	mapi_object_release(&obj_message);
+
+	return retval;
+}
+
+/**
+   \details Wait for notification sockets and process the pending
+   notifications of the sessions signaled as readable
+
+   \param bench pointer to the benchmark context
+   \param pfds poll set with one entry per session
+   \param timeout poll timeout in milliseconds
+ */
+static void bench_poll(struct bench_ctx *bench, struct pollfd *pfds, int timeout)
+{
+	uint32_t	i;
+	int		ret;
+
+	ret = poll(pfds, bench->count, timeout);
+	if (ret <= 0) return;
+
+	for (i = 0; i < bench->count; i++) {
+		if (!(pfds[i].revents & POLLIN)) continue;
+		if (ProcessPendingNotifications(bench->sessions[i].session) != MAPI_E_SUCCESS) {
+			bench->errors++;
+		}
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX			*mem_ctx;
+	enum MAPISTATUS			retval;
+	struct mapi_context		*mapi_ctx;
+	struct tevent_context		*ev;
+	struct bench_ctx		bench;
+	struct pollfd			*pfds = NULL;
+	poptContext			pc;
+	int				opt;
+	const char			*opt_profdb = NULL;
+	char				*opt_profname = NULL;
+	const char			*opt_password = NULL;
+	const char			*opt_debug = NULL;
+	uint32_t			opt_sessions = 100;
+	uint32_t			opt_timeout = 60;
+	bool				opt_async = false;
+	mapi_id_t			mid;
+	uint64_t			start;
+	uint64_t			usec;
+	uint64_t			deadline;
+	uint32_t			i;
+	int				exit_code = 0;
+
+	enum { OPT_PROFILE_DB=1000, OPT_PROFILE, OPT_PASSWORD, OPT_DEBUG, OPT_SESSIONS, OPT_TIMEOUT, OPT_ASYNC };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "database", 'f', POPT_ARG_STRING, NULL, OPT_PROFILE_DB, "set the profile database path", "PATH" },
+		{ "profile", 'p', POPT_ARG_STRING, NULL, OPT_PROFILE, "set the profile name", "PROFILE" },
+		{ "password", 'P', POPT_ARG_STRING, NULL, OPT_PASSWORD, "set the profile password", "PASSWORD" },
+		{ "debuglevel", 'd', POPT_ARG_STRING, NULL, OPT_DEBUG, "set the debug level", "LEVEL" },
+		{ "sessions", 's', POPT_ARG_STRING, NULL, OPT_SESSIONS, "number of sessions (default: 100)", "COUNT" },
+		{ "timeout", 't', POPT_ARG_STRING, NULL, OPT_TIMEOUT, "delivery timeout in seconds (default: 60)", "SECONDS" },
+		{ "async", 'a', POPT_ARG_NONE, NULL, OPT_ASYNC, "use EcDoAsyncWaitEx instead of UDP notifications", NULL },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	mem_ctx = talloc_named(NULL, 0, "bench_notification");
+	memset(&bench, 0, sizeof (struct bench_ctx));
+
+	pc = poptGetContext("bench_notification", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_PROFILE_DB:
+			opt_profdb = poptGetOptArg(pc);
+			break;
+		case OPT_PROFILE:
+			opt_profname = talloc_strdup(mem_ctx, poptGetOptArg(pc));
+			break;
+		case OPT_PASSWORD:
+			opt_password = poptGetOptArg(pc);
+			break;
+		case OPT_DEBUG:
+			opt_debug = poptGetOptArg(pc);
+			break;
+		case OPT_SESSIONS:
+			opt_sessions = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_TIMEOUT:
+			opt_timeout = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_ASYNC:
+			opt_async = true;
+			break;
+		}
+	}
+	poptFreeContext(pc);
+
+	if (!opt_sessions) {
+		fprintf(stderr, "Invalid number of sessions\n");
+		exit (1);
+	}
+
+	if (!opt_profdb) {
+		opt_profdb = talloc_asprintf(mem_ctx, BENCH_DEFAULT_PROFDB, getenv("HOME"));
+	}
+
+	retval = MAPIInitialize(&mapi_ctx, opt_profdb);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("MAPIInitialize", retval);
+		exit (1);
+	}
+
+	if (opt_debug) {
+		SetMAPIDebugLevel(mapi_ctx, atoi(opt_debug));
+	}
+
+	if (!opt_profname) {
+		retval = GetDefaultProfile(mapi_ctx, &opt_profname);
+		if (retval != MAPI_E_SUCCESS) {
+			printf("No profile specified and no default profile found\n");
+			exit_code = 1;
+			goto cleanup;
+		}
+	}
+
+	GetEventContext(mapi_ctx, &ev);
+
+	/* Step 1. Open the sessions and subscribe to new messages */
+	bench.sessions = talloc_zero_array(mem_ctx, struct bench_session, opt_sessions);
+	start = bench_now();
+	for (i = 0; i < opt_sessions; i++) {
+		bench.sessions[i].bench = &bench;
+		retval = bench_open(mapi_ctx, &bench.sessions[i], opt_profname, opt_password, opt_async);
+		if (retval != MAPI_E_SUCCESS) {
+			printf("session %u: ", i);
+			mapi_errstr("bench_open", retval);
+			exit_code = 1;
+			goto cleanup;
+		}
+		bench.count++;
+	}
+	usec = bench_now() - start;
+	printf("opened %u sessions in %"PRIu64" usec (%s notifications)\n", bench.count, usec,
+	       opt_async ? "asynchronous" : "UDP");
+
+	if (!opt_async) {
+		pfds = talloc_zero_array(mem_ctx, struct pollfd, bench.count);
+		for (i = 0; i < bench.count; i++) {
+			GetNotificationFd(bench.sessions[i].session, &pfds[i].fd);
+			pfds[i].events = POLLIN;
+		}
+	}
+
+	/* Step 2. Create a message and wait for every session to be notified */
+	retval = bench_create_message(&bench.sessions[0].obj_inbox, &mid);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("bench_create_message", retval);
+		exit_code = 1;
+		goto cleanup;
+	}
+
+	start = bench_now();
+	deadline = start + (uint64_t)opt_timeout * 1000000;
+	while (bench.notified < bench.count && bench_now() < deadline) {
+		if (opt_async) {
+			tevent_loop_once(ev);
+		} else {
+			bench_poll(&bench, pfds, 100);
+		}
+	}
+	usec = bench_now() - start;
+
+	printf("%u/%u sessions notified in %"PRIu64" usec (%"PRIu64" usec per session)\n",
+	       bench.notified, bench.count, usec, usec / bench.count);
+
+	DeleteMessage(&bench.sessions[0].obj_inbox, &mid, 1);
+
+	for (i = 0; i < bench.count; i++) {
+		bench_check(&bench.errors, bench.sessions[i].received == 1,
+			    "session %u: %u notification(s)", i, bench.sessions[i].received);
+	}
+	exit_code = bench_result(bench.errors);
+
+cleanup:
+	for (i = 0; i < bench.count; i++) {
+		Unsubscribe(bench.sessions[i].session, bench.sessions[i].connection);
+		mapi_object_release(&bench.sessions[i].obj_inbox);
+		mapi_object_release(&bench.sessions[i].obj_store);
+	}
+	MAPIUninitialize(mapi_ctx);
+	talloc_free(mem_ctx);
+
+	return exit_code;
+}
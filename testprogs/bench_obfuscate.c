@@ -0,0 +1,187 @@
+/*
+   Benchmark the RHEF_XorMagic obfuscation of ROP buffers
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libmapi/libmapi.h"
+#include "libmapi/libmapi_private.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+
+/**
+   \file bench_obfuscate.c
+
+   \brief Measure the obfuscation throughput in bytes per second
+
+   Compares a byte-at-a-time loop with obfuscate_data() (in place) and
+   obfuscate_copy() (copy and obfuscate in one pass, as done when
+   building rgbIn and rgbOut). Both are first checked against the byte
+   loop for every small size and alignment, then on the benchmark
+   buffer.
+ */
+
+#define	BENCH_SALT	0xA5
+
+static void bench_obfuscate_bytes(uint8_t *data, uint32_t size, uint8_t salt)
+{
+	uint32_t	i;
+
+	for (i = 0; i < size; i++) {
+		data[i] ^= salt;
+	}
+}
+
+static void bench_report(const char *name, uint32_t size, uint32_t iterations, uint64_t usec)
+{
+	printf("%-16s %8u bytes: %"PRIu64" MB/s\n", name, size,
+	       bench_rate((uint64_t)size * iterations, usec) / 1000000);
+}
+
+/**
+   \details Check obfuscate_data and obfuscate_copy against the byte
+   loop for the sizes and alignments which exercise their head and
+   tail handling
+
+   \param mem_ctx pointer to the memory context
+   \param errors pointer to the error counter
+ */
+static void bench_check_alignments(TALLOC_CTX *mem_ctx, uint32_t *errors)
+{
+	uint8_t		*src;
+	uint8_t		*dst;
+	uint8_t		*ref;
+	uint32_t	size;
+	uint32_t	offset;
+	uint32_t	i;
+
+	src = talloc_array(mem_ctx, uint8_t, 128);
+	dst = talloc_array(mem_ctx, uint8_t, 128);
+	ref = talloc_array(mem_ctx, uint8_t, 128);
+	for (i = 0; i < 128; i++) {
+		src[i] = (uint8_t) random();
+	}
+
+	for (size = 0; size <= 80; size++) {
+		for (offset = 0; offset < 16; offset++) {
+			memcpy(ref, src, 128);
+			bench_obfuscate_bytes(ref + offset, size, BENCH_SALT);
+
+			/* bytes around the buffer must be left untouched */
+			memcpy(dst, src, 128);
+			obfuscate_data(dst + offset, size, BENCH_SALT);
+			bench_check(errors, !memcmp(dst, ref, 128),
+				    "obfuscate_data: %u bytes at offset %u", size, offset);
+
+			memcpy(dst, src, 128);
+			obfuscate_copy(dst + offset, src + (offset ^ 5), size, BENCH_SALT);
+			memcpy(ref, src, 128);
+			memcpy(ref + offset, src + (offset ^ 5), size);
+			bench_obfuscate_bytes(ref + offset, size, BENCH_SALT);
+			bench_check(errors, !memcmp(dst, ref, 128),
+				    "obfuscate_copy: %u bytes at offset %u", size, offset);
+		}
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX		*mem_ctx;
+	poptContext		pc;
+	int			opt;
+	uint8_t			*src;
+	uint8_t			*dst;
+	uint8_t			*ref;
+	uint64_t		start;
+	uint32_t		i;
+	uint32_t		opt_size = 0x8000;
+	uint32_t		opt_iterations = 20000;
+	uint32_t		errors = 0;
+
+	enum { OPT_SIZE=1000, OPT_ITERATIONS };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "size", 's', POPT_ARG_STRING, NULL, OPT_SIZE, "buffer size (default: 32768)", "BYTES" },
+		{ "iterations", 'i', POPT_ARG_STRING, NULL, OPT_ITERATIONS, "number of passes (default: 20000)", "COUNT" },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	pc = poptGetContext("bench_obfuscate", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_SIZE:
+			opt_size = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_ITERATIONS:
+			opt_iterations = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		}
+	}
+
+	mem_ctx = talloc_named(NULL, 0, "bench_obfuscate");
+	src = talloc_array(mem_ctx, uint8_t, opt_size + 1);
+	dst = talloc_array(mem_ctx, uint8_t, opt_size + 1);
+	ref = talloc_array(mem_ctx, uint8_t, opt_size + 1);
+	for (i = 0; i < opt_size + 1; i++) {
+		src[i] = (uint8_t) random();
+	}
+
+	/* Check every variant against the reference, aligned or not */
+	bench_check_alignments(mem_ctx, &errors);
+	memcpy(ref, src, opt_size + 1);
+	bench_obfuscate_bytes(ref, opt_size + 1, BENCH_SALT);
+	memcpy(dst, src, opt_size + 1);
+	obfuscate_data(dst + 1, opt_size, BENCH_SALT);
+	obfuscate_data(dst, 1, BENCH_SALT);
+	bench_check(&errors, !memcmp(dst, ref, opt_size + 1), "obfuscate_data output differs");
+	obfuscate_copy(dst, src + 1, opt_size, BENCH_SALT);
+	bench_check(&errors, !memcmp(dst, ref + 1, opt_size), "obfuscate_copy output differs");
+
+	start = bench_now();
+	for (i = 0; i < opt_iterations; i++) {
+		bench_obfuscate_bytes(dst, opt_size, BENCH_SALT);
+	}
+	bench_report("byte loop", opt_size, opt_iterations, bench_now() - start);
+
+	start = bench_now();
+	for (i = 0; i < opt_iterations; i++) {
+		obfuscate_data(dst, opt_size, BENCH_SALT);
+	}
+	bench_report("obfuscate_data", opt_size, opt_iterations, bench_now() - start);
+
+	start = bench_now();
+	for (i = 0; i < opt_iterations; i++) {
+		memcpy(dst, src, opt_size);
+		bench_obfuscate_bytes(dst, opt_size, BENCH_SALT);
+	}
+	bench_report("copy+byte loop", opt_size, opt_iterations, bench_now() - start);
+
+	start = bench_now();
+	for (i = 0; i < opt_iterations; i++) {
+		obfuscate_copy(dst, src, opt_size, BENCH_SALT);
+	}
+	bench_report("obfuscate_copy", opt_size, opt_iterations, bench_now() - start);
+
+	talloc_free(mem_ctx);
+	poptFreeContext(pc);
+
+	return bench_result(errors);
+}
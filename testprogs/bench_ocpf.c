@@ -0,0 +1,284 @@
+/*
+   Benchmark OCPF message creation
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libocpf/ocpf.h"
+#include "testprogs/bench.h"
+
+#include <popt.h>
+#include <talloc.h>
+#include <pthread.h>
+
+/**
+   \file bench_ocpf.c
+
+   \brief Measure how many property arrays per second can be built
+   from an OCPF file
+
+   Worker threads build the properties of a message from the same
+   OCPF file, binding a different subject to each message. The file is
+   either parsed for every message, or parsed once and retrieved from
+   the template cache. Named properties are mapped to fake property
+   identifiers so the benchmark does not need a server.
+
+   Every message must carry the subject bound to it, and the same
+   number of properties as a message built by a single thread from a
+   freshly parsed file.
+ */
+
+#define	BENCH_DEFAULT_FILE	"libocpf/examples/sample_appointment.ocpf"
+
+struct bench_worker {
+	pthread_t		thread;
+	const char		*filename;
+	const char		*variable;
+	bool			cached;
+	uint32_t		expected;
+	uint32_t		messages;
+	uint32_t		properties;
+	uint32_t		errors;
+};
+
+/**
+   \details Map the named properties of a template without a server
+
+   \param mem_ctx pointer to the memory context
+   \param tmpl pointer to the template
+
+   \return the property tags array, or NULL if the template has no
+   named properties
+ */
+static struct SPropTagArray *bench_map_names(TALLOC_CTX *mem_ctx, struct ocpf_template *tmpl)
+{
+	struct mapi_nameid	*nameid;
+	struct SPropTagArray	*SPropTagArray;
+	uint32_t		i;
+
+	if (ocpf_template_get_nameid(mem_ctx, tmpl, &nameid) != MAPI_E_SUCCESS) {
+		return NULL;
+	}
+
+	SPropTagArray = talloc_zero(mem_ctx, struct SPropTagArray);
+	SPropTagArray->cValues = nameid->count;
+	SPropTagArray->aulPropTag = talloc_array(SPropTagArray, enum MAPITAGS, nameid->count);
+	for (i = 0; i < nameid->count; i++) {
+		SPropTagArray->aulPropTag[i] = (enum MAPITAGS)((0x8000 + i) << 16);
+	}
+	mapi_nameid_SPropTagArray(nameid, SPropTagArray);
+	talloc_free(nameid);
+
+	return SPropTagArray;
+}
+
+/**
+   \details Build the properties of a message and check them
+
+   \param mem_ctx pointer to the memory context
+   \param filename the OCPF file
+   \param variable the name of the variable bound to the message
+   \param cached whether the template is retrieved from the cache
+   \param id the message number
+   \param expected the expected number of properties, 0 to skip the check
+   \param errors pointer to the error counter
+
+   \return the number of properties, 0 on error
+ */
+static uint32_t bench_message(TALLOC_CTX *mem_ctx, const char *filename, const char *variable,
+			      bool cached, uint32_t id, uint32_t expected, uint32_t *errors)
+{
+	struct ocpf_template	*tmpl;
+	struct SPropTagArray	*named;
+	struct SPropValue	*lpProps;
+	struct ocpf_binding	binding;
+	enum MAPISTATUS		retval;
+	const char		*value;
+	uint32_t		cValues = 0;
+	uint32_t		i;
+	bool			found = false;
+	int			ret;
+
+	if (cached) {
+		ret = ocpf_template_cache_get(filename, &tmpl);
+	} else {
+		ret = ocpf_template_load(filename, &tmpl);
+	}
+	if (!bench_check(errors, ret == OCPF_SUCCESS, "%s: unable to load template", filename)) {
+		return 0;
+	}
+
+	binding.name = variable;
+	binding.value = talloc_asprintf(mem_ctx, "[OCPF] bench_ocpf message %u", id);
+
+	named = bench_map_names(mem_ctx, tmpl);
+	retval = ocpf_template_instantiate(mem_ctx, tmpl, named, &binding, 1, &lpProps, &cValues);
+	if (bench_check(errors, retval == MAPI_E_SUCCESS && cValues, "message %u: unable to build properties", id)) {
+		for (i = 0; i < cValues && !found; i++) {
+			switch (lpProps[i].ulPropTag & 0xFFFF) {
+			case PT_UNICODE:
+				value = lpProps[i].value.lpszW;
+				break;
+			case PT_STRING8:
+				value = lpProps[i].value.lpszA;
+				break;
+			default:
+				value = NULL;
+				break;
+			}
+			found = value && !strcmp(value, binding.value);
+		}
+		bench_check(errors, found, "message %u: $%s not bound", id, variable);
+		bench_check(errors, !expected || cValues == expected,
+			    "message %u: %u properties instead of %u", id, cValues, expected);
+	} else {
+		cValues = 0;
+	}
+
+	ocpf_template_release(tmpl);
+	talloc_free_children(mem_ctx);
+
+	return cValues;
+}
+
+static void *bench_worker(void *priv)
+{
+	struct bench_worker	*worker = priv;
+	TALLOC_CTX		*mem_ctx;
+	uint32_t		i;
+
+	mem_ctx = talloc_named(NULL, 0, "bench_worker");
+
+	for (i = 0; i < worker->messages; i++) {
+		worker->properties += bench_message(mem_ctx, worker->filename, worker->variable, worker->cached,
+						    i, worker->expected, &worker->errors);
+	}
+
+	talloc_free(mem_ctx);
+
+	return NULL;
+}
+
+/**
+   \details Run the workers and return the throughput
+
+   \return the number of messages per second
+ */
+static uint64_t bench_run(const char *filename, const char *variable, bool cached, uint32_t expected,
+			  uint32_t threads, uint32_t messages, uint32_t *errors)
+{
+	struct bench_worker	*workers;
+	uint64_t		start;
+	uint64_t		usec;
+	uint32_t		i;
+
+	workers = talloc_zero_array(NULL, struct bench_worker, threads);
+
+	start = bench_now();
+	for (i = 0; i < threads; i++) {
+		workers[i].filename = filename;
+		workers[i].variable = variable;
+		workers[i].cached = cached;
+		workers[i].expected = expected;
+		workers[i].messages = messages / threads;
+		if (pthread_create(&workers[i].thread, NULL, bench_worker, &workers[i])) {
+			fprintf(stderr, "Unable to create thread %u\n", i);
+			exit (1);
+		}
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		*errors += workers[i].errors;
+	}
+	usec = bench_now() - start;
+
+	talloc_free(workers);
+
+	printf("%-8s %u threads: %u messages in %"PRIu64" usec\n", cached ? "cached" : "parsed",
+	       threads, (messages / threads) * threads, usec);
+
+	return bench_rate((messages / threads) * threads, usec);
+}
+
+int main(int argc, const char *argv[])
+{
+	poptContext		pc;
+	int			opt;
+	const char		*opt_file = BENCH_DEFAULT_FILE;
+	const char		*opt_variable = "subject";
+	uint32_t		opt_messages = 10000;
+	uint32_t		opt_threads = 4;
+	uint32_t		errors = 0;
+	uint32_t		expected;
+	TALLOC_CTX		*mem_ctx;
+	uint64_t		parsed;
+	uint64_t		cached;
+
+	enum { OPT_FILE=1000, OPT_VARIABLE, OPT_MESSAGES, OPT_THREADS };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "file", 'f', POPT_ARG_STRING, NULL, OPT_FILE, "OCPF file (default: " BENCH_DEFAULT_FILE ")", "PATH" },
+		{ "variable", 'v', POPT_ARG_STRING, NULL, OPT_VARIABLE, "string variable bound for each message (default: subject)", "NAME" },
+		{ "messages", 'm', POPT_ARG_STRING, NULL, OPT_MESSAGES, "number of messages (default: 10000)", "COUNT" },
+		{ "threads", 't', POPT_ARG_STRING, NULL, OPT_THREADS, "number of worker threads (default: 4)", "COUNT" },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	pc = poptGetContext("bench_ocpf", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_FILE:
+			opt_file = poptGetOptArg(pc);
+			break;
+		case OPT_VARIABLE:
+			opt_variable = poptGetOptArg(pc);
+			break;
+		case OPT_MESSAGES:
+			opt_messages = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		case OPT_THREADS:
+			opt_threads = strtoul(poptGetOptArg(pc), NULL, 0);
+			break;
+		}
+	}
+
+	if (!opt_threads || opt_messages < opt_threads) {
+		fprintf(stderr, "Invalid number of threads or messages\n");
+		exit (1);
+	}
+
+	mem_ctx = talloc_named(NULL, 0, "bench_ocpf");
+	expected = bench_message(mem_ctx, opt_file, opt_variable, false, 0, 0, &errors);
+	talloc_free(mem_ctx);
+	if (!expected) {
+		poptFreeContext(pc);
+		return bench_result(errors);
+	}
+
+	parsed = bench_run(opt_file, opt_variable, false, expected, opt_threads, opt_messages, &errors);
+	cached = bench_run(opt_file, opt_variable, true, expected, opt_threads, opt_messages, &errors);
+	ocpf_template_cache_flush();
+
+	printf("parsed:  %"PRIu64" messages/s\n", parsed);
+	printf("cached:  %"PRIu64" messages/s\n", cached);
+
+	poptFreeContext(pc);
+
+	return bench_result(errors);
+}
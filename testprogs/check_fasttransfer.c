@@ -187,7 +187,11 @@ static enum MAPISTATUS mapistore_namedprop(uint32_t proptag, struct MAPINAMEID n
 static enum MAPISTATUS mapistore_property(struct SPropValue prop, void *priv)
 {
 	struct mapistore_output_ctx *mapistore = priv;
-	SRow_addprop(mapistore->proplist, prop);
+	struct SPropValue copy;
+
+	/* the parser releases property values once delivered */
+	mapi_copy_spropvalues(mapistore->proplist, &prop, &copy, 1);
+	SRow_addprop(mapistore->proplist, copy);
 	return MAPI_E_SUCCESS;
 }
 
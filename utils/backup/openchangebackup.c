@@ -63,11 +63,97 @@ failed:
 uint32_t ocb_release(struct ocb_context *ocb_ctx)
 {
 	OCB_RETVAL_IF(!ocb_ctx, "subsystem not initialized\n", NULL);
+	ocb_flush(ocb_ctx);
 	talloc_free(ocb_ctx);
 
 	return 0;
 }
 
+/**
+ * Set the number of records committed per LDB transaction.
+ *
+ * Records are kept in memory until batch_size of them are pending,
+ * so the database lock is only held while they are written. When
+ * replace is set, existing records are overwritten instead of being
+ * skipped (incremental backups).
+ */
+void ocb_set_batch(struct ocb_context *ocb_ctx, uint32_t batch_size, bool replace)
+{
+	if (!ocb_ctx) return;
+
+	ocb_flush(ocb_ctx);
+	talloc_free(ocb_ctx->pending);
+	ocb_ctx->pending = NULL;
+
+	ocb_ctx->batch_size = batch_size;
+	ocb_ctx->replace = replace;
+	if (batch_size > 1) {
+		ocb_ctx->pending = talloc_array(ocb_ctx, struct ldb_message *, batch_size);
+		if (!ocb_ctx->pending) {
+			ocb_ctx->batch_size = 0;
+		}
+	}
+}
+
+/**
+ * Add a message to the database, replacing the existing record if
+ * requested
+ */
+static int ocb_add_message(struct ocb_context *ocb_ctx, struct ldb_message *msg)
+{
+	int		ret;
+
+	ret = ldb_add(ocb_ctx->ldb_ctx, msg);
+	if (ret == LDB_ERR_ENTRY_ALREADY_EXISTS && ocb_ctx->replace == true) {
+		ret = ldb_delete(ocb_ctx->ldb_ctx, msg->dn);
+		if (ret == LDB_SUCCESS) {
+			ret = ldb_add(ocb_ctx->ldb_ctx, msg);
+		}
+	}
+	if (ret != LDB_SUCCESS) {
+		DEBUG(3, ("LDB operation failed: %s\n", ldb_errstring(ocb_ctx->ldb_ctx)));
+	}
+
+	return ret;
+}
+
+/**
+ * Write all pending records in a single transaction. The transaction
+ * is cancelled if any record can't be written, so a batch is either
+ * written entirely or not at all.
+ */
+uint32_t ocb_flush(struct ocb_context *ocb_ctx)
+{
+	uint32_t	i;
+	int		ret;
+
+	/* sanity checks */
+	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	if (!ocb_ctx->pending_count) return 0;
+	OCB_RETVAL_IF(!ocb_ctx->ldb_ctx, "LDB context not initialized", NULL);
+
+	ret = ldb_transaction_start(ocb_ctx->ldb_ctx);
+	OCB_RETVAL_IF(ret != LDB_SUCCESS, "Unable to start transaction", NULL);
+
+	for (i = 0; i < ocb_ctx->pending_count; i++) {
+		if (ocb_add_message(ocb_ctx, ocb_ctx->pending[i]) != LDB_SUCCESS) {
+			DEBUG(3, ("[OCB] record %d of %d could not be written, batch cancelled\n",
+				  i + 1, ocb_ctx->pending_count));
+			ldb_transaction_cancel(ocb_ctx->ldb_ctx);
+			talloc_free_children(ocb_ctx->pending);
+			ocb_ctx->pending_count = 0;
+			return -1;
+		}
+	}
+
+	ret = ldb_transaction_commit(ocb_ctx->ldb_ctx);
+	talloc_free_children(ocb_ctx->pending);
+	ocb_ctx->pending_count = 0;
+	OCB_RETVAL_IF(ret != LDB_SUCCESS, "Unable to commit transaction", NULL);
+
+	return 0;
+}
+
 /**
  * init and prepare a record
  */
@@ -75,46 +161,98 @@ uint32_t ocb_release(struct ocb_context *ocb_ctx)
 int ocb_record_init(struct ocb_context *ocb_ctx, const char *objclass, const char *dn, 
 		    const char *id, struct mapi_SPropValue_array *props)
 {
-	TALLOC_CTX		*mem_ctx;
+	/* sanity check */
+	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	OCB_RETVAL_IF(!dn, "Not a valid DN", NULL);
+	OCB_RETVAL_IF(!id, "Not a valid ID", NULL);
+
+	if (ocb_record_new(ocb_ctx, objclass) == -1) return -1;
+
+	return ocb_record_set_dn(ocb_ctx, dn, id);
+}
+
+/**
+ * Start a record whose DN is not known yet: properties can be added
+ * before ocb_record_set_dn is called
+ */
+int ocb_record_new(struct ocb_context *ocb_ctx, const char *objclass)
+{
+	/* sanity check */
+	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	OCB_RETVAL_IF(!objclass, "Not a valid objectClass", NULL);
+
+	ocb_ctx->msg = ldb_msg_new((TALLOC_CTX *)ocb_ctx);
+	OCB_RETVAL_IF(!ocb_ctx->msg, "Not enough memory", NULL);
+
+	/* add filters attributes */
+	ldb_msg_add_string(ocb_ctx->msg, "objectClass", objclass);
+
+	return 0;
+}
+
+/**
+ * Set the DN and cn of the current record. The record is discarded
+ * if it already exists in the database, unless existing records are
+ * being replaced.
+ */
+int ocb_record_set_dn(struct ocb_context *ocb_ctx, const char *dn, const char *id)
+{
 	struct ldb_context	*ldb_ctx;
-	struct ldb_result	*res;
-	enum ldb_scope		scope = LDB_SCOPE_SUBTREE;
+	struct ldb_result	*res = NULL;
 	struct ldb_dn		*basedn;
-	const char * const     	attrs[] = { "*", NULL };
+	const char * const     	attrs[] = { "cn", NULL };
+	int			ret;
 
 	/* sanity check */
 	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	OCB_RETVAL_IF(!ocb_ctx->msg, "Message not initialized", NULL);
 	OCB_RETVAL_IF(!dn, "Not a valid DN", NULL);
 	OCB_RETVAL_IF(!id, "Not a valid ID", NULL);
 
-	mem_ctx = (TALLOC_CTX *)ocb_ctx;
 	ldb_ctx = ocb_ctx->ldb_ctx;
 
-	/* Check if the record already exists */
-	ldb_search(ldb_ctx, mem_ctx, &res, ldb_get_default_basedn(ldb_ctx), scope, attrs, "%s", dn);
-	OCB_RETVAL_IF(res->msgs, "Record already exists", NULL);
-
 	/* Retrieve the record basedn */
-	basedn = ldb_dn_new(ldb_ctx, ldb_ctx, dn);
-	OCB_RETVAL_IF(!ldb_dn_validate(basedn), "Invalid DN", NULL);
+	basedn = ldb_dn_new(ocb_ctx->msg, ldb_ctx, dn);
+	if (!ldb_dn_validate(basedn)) {
+		DEBUG(3, ("[OCB] Invalid DN\n"));
+		ocb_record_discard(ocb_ctx);
+		return -1;
+	}
 
-	ocb_ctx->msg = ldb_msg_new(mem_ctx);
-	ocb_ctx->msg->dn = ldb_dn_copy(mem_ctx, basedn);
+	/* Check if the record already exists */
+	if (ocb_ctx->replace == false) {
+		ret = ldb_search(ldb_ctx, ocb_ctx->msg, &res, basedn, LDB_SCOPE_BASE, attrs, NULL);
+		if (ret == LDB_SUCCESS && res->count) {
+			DEBUG(3, ("[OCB] Record already exists\n"));
+			ocb_record_discard(ocb_ctx);
+			return -1;
+		}
+		talloc_free(res);
+	}
+
+	ocb_ctx->msg->dn = basedn;
 
 	/* add records for cn */
-	ldb_msg_add_string(ocb_ctx->msg, "cn", id);
+	ldb_msg_add_string(ocb_ctx->msg, "cn", talloc_strdup(ocb_ctx->msg, id));
 
-	/* add filters attributes */
-	ldb_msg_add_string(ocb_ctx->msg, "objectClass", objclass);
+	return 0;
+}
 
-	talloc_free(basedn);
+/**
+ * Drop the current record
+ */
+void ocb_record_discard(struct ocb_context *ocb_ctx)
+{
+	if (!ocb_ctx) return;
 
-	return 0;
+	talloc_free(ocb_ctx->msg);
+	ocb_ctx->msg = NULL;
 }
 
 
 /**
- * Commit the record with all its attributes: single transaction
+ * Commit the record with all its attributes. The record is written
+ * immediately, or queued until the current batch is full.
  */
 uint32_t ocb_record_commit(struct ocb_context *ocb_ctx)
 {
@@ -124,15 +262,23 @@ uint32_t ocb_record_commit(struct ocb_context *ocb_ctx)
 	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
 	OCB_RETVAL_IF(!ocb_ctx->ldb_ctx, "LDB context not initialized", NULL);
 	OCB_RETVAL_IF(!ocb_ctx->msg, "Message not initialized", NULL);
+	OCB_RETVAL_IF(!ocb_ctx->msg->dn, "DN not set", NULL);
+
+	if (ocb_ctx->batch_size > 1) {
+		ocb_ctx->pending[ocb_ctx->pending_count++] = talloc_steal(ocb_ctx->pending, ocb_ctx->msg);
+		ocb_ctx->msg = NULL;
+		if (ocb_ctx->pending_count == ocb_ctx->batch_size) {
+			return ocb_flush(ocb_ctx);
+		}
+		return 0;
+	}
 
-	ret = ldb_add(ocb_ctx->ldb_ctx, ocb_ctx->msg);
+	ret = ocb_add_message(ocb_ctx, ocb_ctx->msg);
+	ocb_record_discard(ocb_ctx);
 	if (ret != LDB_SUCCESS) {
-		DEBUG(3, ("LDB operation failed: %s\n", ldb_errstring(ocb_ctx->ldb_ctx)));
 		return -1;
 	}
 
-	talloc_free(ocb_ctx->msg);
-
 	return 0;
 }
 
@@ -172,10 +318,14 @@ uint32_t ocb_record_add_property(struct ocb_context *ocb_ctx,
 		ldb_msg_add_fmt(ocb_ctx->msg, attr, "%hd", lpProp->value.i);
 		break;
 	case PT_STRING8:
-		ldb_msg_add_string(ocb_ctx->msg, attr, lpProp->value.lpszA);
+		if (lpProp->value.lpszA) {
+			ldb_msg_add_string(ocb_ctx->msg, attr, talloc_strdup(mem_ctx, lpProp->value.lpszA));
+		}
 		break;
 	case PT_UNICODE:
-		ldb_msg_add_string(ocb_ctx->msg, attr, lpProp->value.lpszW);
+		if (lpProp->value.lpszW) {
+			ldb_msg_add_string(ocb_ctx->msg, attr, talloc_strdup(mem_ctx, lpProp->value.lpszW));
+		}
 		break;
 	case PT_ERROR: /* We shouldn't need to backup error properties */
 		return 0;
@@ -221,7 +371,7 @@ uint32_t ocb_record_add_property(struct ocb_context *ocb_ctx,
 	case PT_MV_STRING8:
 		for (i = 0; i < lpProp->value.MVszA.cValues; i++) {
 			ldb_msg_add_string(ocb_ctx->msg, attr, 
-					   lpProp->value.MVszA.strings[i].lppszA);
+					   talloc_strdup(mem_ctx, lpProp->value.MVszA.strings[i].lppszA));
 		}
 		break;
 	default:
@@ -233,6 +383,120 @@ uint32_t ocb_record_add_property(struct ocb_context *ocb_ctx,
 	return 0;
 }
 
+/**
+ * Decode a base64 encoded state attribute
+ */
+static void ocb_state_get_blob(TALLOC_CTX *mem_ctx, struct ldb_message *msg,
+			       const char *attr, DATA_BLOB *blob)
+{
+	const char	*str;
+	int		len;
+
+	str = ldb_msg_find_attr_as_string(msg, attr, NULL);
+	if (!str) return;
+
+	blob->data = (uint8_t *)talloc_strdup(mem_ctx, str);
+	len = ldb_base64_decode((char *)blob->data);
+	if (len < 0) {
+		talloc_free(blob->data);
+		blob->data = NULL;
+		return;
+	}
+	blob->length = len;
+}
+
+/**
+ * Load the ICS state stored for a folder. Empty blobs are returned
+ * when no state was saved yet.
+ */
+int ocb_state_load(struct ocb_context *ocb_ctx, TALLOC_CTX *mem_ctx,
+		   const char *id, struct ocb_ics_state *state)
+{
+	struct ldb_result	*res = NULL;
+	struct ldb_dn		*dn;
+	const char * const     	attrs[] = { "*", NULL };
+	int			ret;
+
+	/* sanity checks */
+	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	OCB_RETVAL_IF(!id, "Not a valid ID", NULL);
+	OCB_RETVAL_IF(!state, "Not a valid state", NULL);
+
+	memset(state, 0, sizeof (struct ocb_ics_state));
+
+	dn = ldb_dn_new_fmt(mem_ctx, ocb_ctx->ldb_ctx, "cn=%s,%s", id, OCB_ICSSTATE_DN);
+	ret = ldb_search(ocb_ctx->ldb_ctx, mem_ctx, &res, dn, LDB_SCOPE_BASE, attrs, NULL);
+	talloc_free(dn);
+	if (ret != LDB_SUCCESS || !res->count) {
+		talloc_free(res);
+		return 0;
+	}
+
+	ocb_state_get_blob(mem_ctx, res->msgs[0], "idsetGiven", &state->idset_given);
+	ocb_state_get_blob(mem_ctx, res->msgs[0], "cnsetSeen", &state->cnset_seen);
+	ocb_state_get_blob(mem_ctx, res->msgs[0], "cnsetSeenFAI", &state->cnset_seen_fai);
+	ocb_state_get_blob(mem_ctx, res->msgs[0], "cnsetRead", &state->cnset_read);
+	talloc_free(res);
+
+	return 0;
+}
+
+/**
+ * Save the ICS state of a folder. Pending records are written first,
+ * so the stored state never covers records missing from the database.
+ */
+int ocb_state_save(struct ocb_context *ocb_ctx, const char *id, struct ocb_ics_state *state)
+{
+	struct ldb_message	*msg;
+	DATA_BLOB		*blobs[4];
+	const char		*attrs[] = { "idsetGiven", "cnsetSeen", "cnsetSeenFAI", "cnsetRead" };
+	uint32_t		i;
+	int			ret;
+
+	/* sanity checks */
+	OCB_RETVAL_IF(!ocb_ctx, "Subsystem not initialized", NULL);
+	OCB_RETVAL_IF(!id, "Not a valid ID", NULL);
+	OCB_RETVAL_IF(!state, "Not a valid state", NULL);
+	OCB_RETVAL_IF(ocb_flush(ocb_ctx), "Unable to write pending records", NULL);
+
+	msg = ldb_msg_new((TALLOC_CTX *)ocb_ctx);
+	OCB_RETVAL_IF(!msg, "Not enough memory", NULL);
+	msg->dn = ldb_dn_new_fmt(msg, ocb_ctx->ldb_ctx, "cn=%s,%s", id, OCB_ICSSTATE_DN);
+	ldb_msg_add_string(msg, "cn", talloc_strdup(msg, id));
+	ldb_msg_add_string(msg, "objectClass", OCB_OBJCLASS_ICSSTATE);
+
+	blobs[0] = &state->idset_given;
+	blobs[1] = &state->cnset_seen;
+	blobs[2] = &state->cnset_seen_fai;
+	blobs[3] = &state->cnset_read;
+	for (i = 0; i < 4; i++) {
+		if (blobs[i]->length) {
+			ldb_msg_add_string(msg, attrs[i],
+					   ldb_base64_encode(msg, (char *)blobs[i]->data, blobs[i]->length));
+		}
+	}
+
+	ret = ldb_transaction_start(ocb_ctx->ldb_ctx);
+	OCB_RETVAL_IF(ret != LDB_SUCCESS, "Unable to start transaction", msg);
+
+	ret = ldb_delete(ocb_ctx->ldb_ctx, msg->dn);
+	if (ret == LDB_SUCCESS || ret == LDB_ERR_NO_SUCH_OBJECT) {
+		ret = ldb_add(ocb_ctx->ldb_ctx, msg);
+	}
+	if (ret != LDB_SUCCESS) {
+		DEBUG(3, ("LDB operation failed: %s\n", ldb_errstring(ocb_ctx->ldb_ctx)));
+		ldb_transaction_cancel(ocb_ctx->ldb_ctx);
+		talloc_free(msg);
+		return -1;
+	}
+
+	ret = ldb_transaction_commit(ocb_ctx->ldb_ctx);
+	talloc_free(msg);
+	OCB_RETVAL_IF(ret != LDB_SUCCESS, "Unable to commit transaction", NULL);
+
+	return 0;
+}
+
 /**
  * Retrieve UUID from Sbinary_short struct
  * Generally used to map PR_STORE_KEY to a string
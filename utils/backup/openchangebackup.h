@@ -44,6 +44,18 @@
 struct ocb_context {
 	struct ldb_context	*ldb_ctx;	/* ldb database context */
 	struct ldb_message	*msg;		/* pointer on record msg */
+	struct ldb_message	**pending;	/* records waiting for the next transaction */
+	uint32_t		pending_count;
+	uint32_t		batch_size;	/* records per transaction */
+	bool			replace;	/* replace existing records */
+};
+
+/* ICS synchronization state of a folder */
+struct ocb_ics_state {
+	DATA_BLOB		idset_given;
+	DATA_BLOB		cnset_seen;
+	DATA_BLOB		cnset_seen_fai;
+	DATA_BLOB		cnset_read;
 };
 
 /* Prototypes */
@@ -61,11 +73,20 @@ __BEGIN_DECLS
 struct ocb_context	*ocb_init(TALLOC_CTX *, const char *);
 uint32_t		ocb_release(struct ocb_context *);
 
+void			ocb_set_batch(struct ocb_context *, uint32_t, bool);
+uint32_t		ocb_flush(struct ocb_context *);
+
 int			ocb_record_init(struct ocb_context *, const char *, 
 					const char *, const char *, struct mapi_SPropValue_array *);
+int			ocb_record_new(struct ocb_context *, const char *);
+int			ocb_record_set_dn(struct ocb_context *, const char *, const char *);
+void			ocb_record_discard(struct ocb_context *);
 uint32_t		ocb_record_commit(struct ocb_context *);
 uint32_t		ocb_record_add_property(struct ocb_context *, struct mapi_SPropValue *);
 
+int			ocb_state_load(struct ocb_context *, TALLOC_CTX *, const char *, struct ocb_ics_state *);
+int			ocb_state_save(struct ocb_context *, const char *, struct ocb_ics_state *);
+
 char			*get_record_uuid(TALLOC_CTX *, const struct SBinary_short *);
 char			*get_MAPI_uuid(TALLOC_CTX *, const struct SBinary_short *);
 char			*get_MAPI_store_guid(TALLOC_CTX *, const struct SBinary_short *);
@@ -94,5 +115,11 @@ do {						\
 #define	OCB_OBJCLASS_CONTAINER	"container"
 #define	OCB_OBJCLASS_MESSAGE	"message"
 #define	OCB_OBJCLASS_ATTACHMENT	"attachment"
+#define	OCB_OBJCLASS_ICSSTATE	"icsState"
+
+/* ICS states are stored under cn=<folder uuid>,OCB_ICSSTATE_DN */
+#define	OCB_ICSSTATE_DN		"cn=ics-state"
+
+#define	OCB_DEFAULT_BATCH	1000
 
 #endif /* __OPENCHANGEBACKUP_H__ */
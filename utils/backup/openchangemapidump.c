@@ -21,6 +21,7 @@
 */
 
 #include "libmapi/libmapi.h"
+#include "libmapi/fxics.h"
 #include <popt.h>
 #include <param.h>
 
@@ -29,8 +30,39 @@
 
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/wait.h>
 #include <fcntl.h>
 #include <time.h>
+#include <unistd.h>
+
+/* MetaTagIdsetGiven is declared as PT_LONG but serialized as an IDSET */
+#define	MetaTagIdsetGivenBinary		0x40170102
+
+/* Folder backed up by a FastTransfer worker */
+struct mapidump_folder {
+	mapi_id_t	fid;
+	char		*dn;
+	char		*uuid;
+	uint32_t	count;
+	uint32_t	worker;
+};
+
+struct mapidump_folder_list {
+	struct mapidump_folder	*folders;
+	uint32_t		count;
+};
+
+struct mapidump_options {
+	const char	*profdb;
+	const char	*profname;
+	const char	*password;
+	const char	*backupdb;
+	const char	*debug;
+	bool		dumpdata;
+	bool		incremental;
+	uint32_t	batch;
+	uint32_t	workers;
+};
 
 /**
  * write attachment to the database
@@ -243,7 +275,8 @@ static enum MAPISTATUS mapidump_walk_container(TALLOC_CTX *mem_ctx,
 					       mapi_object_t *obj_parent,
 					       mapi_id_t folder_id,
 					       char *parentdn,
-					       int count)
+					       int count,
+					       struct mapidump_folder_list *list)
 {
 	enum MAPISTATUS			retval;
 	struct SPropTagArray		*SPropTagArray;
@@ -284,12 +317,23 @@ static enum MAPISTATUS mapidump_walk_container(TALLOC_CTX *mem_ctx,
 
 	/* Write entry for container */
 	mapidump_write_container(ocb_ctx, &props, containerdn, uuid);
-	talloc_free(uuid);
 
 	/* Get Contents Table if PR_CONTENT_COUNT >= 1 */
 	if (child_content && *child_content >= 1) {
-		retval = mapidump_walk_content(mem_ctx, ocb_ctx, &obj_folder, containerdn);
+		if (list) {
+			/* content is downloaded later by the FastTransfer workers */
+			list->folders = talloc_realloc(list, list->folders, struct mapidump_folder, list->count + 1);
+			list->folders[list->count].fid = folder_id;
+			list->folders[list->count].dn = talloc_strdup(list, containerdn);
+			list->folders[list->count].uuid = talloc_strdup(list, uuid);
+			list->folders[list->count].count = *child_content;
+			list->folders[list->count].worker = 0;
+			list->count++;
+		} else {
+			retval = mapidump_walk_content(mem_ctx, ocb_ctx, &obj_folder, containerdn);
+		}
 	}
+	talloc_free(uuid);
 
 	/* Get Container Table if PR_FOLDER_CHILD_COUNT >= 1 */
 
@@ -309,7 +353,7 @@ static enum MAPISTATUS mapidump_walk_container(TALLOC_CTX *mem_ctx,
 		while ((retval = QueryRows(&obj_htable, rcount, TBL_ADVANCE, &rowset) != MAPI_E_NOT_FOUND) && rowset.cRows) {
 			for (i = 0; i < rowset.cRows; i++) {
 				fid = (const uint64_t *)find_SPropValue_data(&rowset.aRow[i], PR_FID);
-				retval = mapidump_walk_container(mem_ctx, ocb_ctx, &obj_folder, *fid, containerdn, count + 1);
+				retval = mapidump_walk_container(mem_ctx, ocb_ctx, &obj_folder, *fid, containerdn, count + 1, list);
 			}
 		}
 	} 
@@ -321,12 +365,14 @@ static enum MAPISTATUS mapidump_walk_container(TALLOC_CTX *mem_ctx,
 }
 
 /**
- * Walk through known mapi folders
+ * Walk through known mapi folders. When list is set, only containers
+ * are written and the folders with content are added to the list.
  */
 
 static enum MAPISTATUS mapidump_walk(TALLOC_CTX *mem_ctx,
 					       struct ocb_context *ocb_ctx,
-					       mapi_object_t *obj_store)
+					       mapi_object_t *obj_store,
+					       struct mapidump_folder_list *list)
 {
 	enum MAPISTATUS			retval;
 	mapi_id_t			id_mailbox;
@@ -335,7 +381,552 @@ static enum MAPISTATUS mapidump_walk(TALLOC_CTX *mem_ctx,
 				  olFolderTopInformationStore);
 	MAPI_RETVAL_IF(retval, GetLastError(), NULL);
 
-	return mapidump_walk_container(mem_ctx, ocb_ctx, obj_store, id_mailbox, NULL, 0);
+	return mapidump_walk_container(mem_ctx, ocb_ctx, obj_store, id_mailbox, NULL, 0, list);
+}
+
+
+/**
+ * FastTransfer engine
+ *
+ * Folder content is downloaded with FXCopyFolder (or ICSSyncConfigure
+ * for incremental backups) and decoded by fxparser while it is
+ * received. Records are built directly from the parser callbacks: a
+ * record is committed as soon as the first child object (recipient,
+ * attachment, embedded message) or the end marker is seen, so only
+ * one record is in memory at a time.
+ */
+
+#define	MAPIDUMP_FX_MAXDEPTH	16
+#define	MAPIDUMP_STATE_CHUNK	0x4000
+
+enum mapidump_fx_mode {
+	MAPIDUMP_FX_RECORD,
+	MAPIDUMP_FX_DISCARD,
+	MAPIDUMP_FX_STATE
+};
+
+struct mapidump_fx_frame {
+	TALLOC_CTX		*mem_ctx;
+	const char		*objclass;	/* NULL if properties are not stored */
+	bool			open;		/* record being built in ocb_ctx->msg */
+	char			*dn;		/* set once the record is committed */
+	DATA_BLOB		source_key;
+	DATA_BLOB		record_key;
+	uint32_t		attach_num;
+	bool			has_attach_num;
+};
+
+struct mapidump_fx {
+	struct ocb_context		*ocb_ctx;
+	enum mapidump_fx_mode		mode;
+	uint32_t			level;
+	struct mapidump_fx_frame	frames[MAPIDUMP_FX_MAXDEPTH];
+	struct ocb_ics_state		state;
+	uint32_t			records;
+	bool				failed;
+};
+
+/**
+ * Compute the unique identifier of a record from the properties
+ * received so far
+ */
+static char *mapidump_fx_uuid(struct mapidump_fx *fx, struct mapidump_fx_frame *frame)
+{
+	struct SBinary_short	bin;
+
+	if (frame->source_key.length == 22) {
+		bin.cb = frame->source_key.length;
+		bin.lpb = frame->source_key.data;
+		return get_MAPI_uuid(frame->mem_ctx, &bin);
+	}
+
+	if (frame->record_key.length) {
+		bin.cb = frame->record_key.length;
+		bin.lpb = frame->record_key.data;
+		return get_record_uuid(frame->mem_ctx, &bin);
+	}
+
+	if (frame->has_attach_num) {
+		return talloc_asprintf(frame->mem_ctx, "%.8X", frame->attach_num);
+	}
+
+	return talloc_asprintf(frame->mem_ctx, "%.8X%.8X", (uint32_t)getpid(), ++fx->records);
+}
+
+/**
+ * Commit the record of the current frame
+ */
+static void mapidump_fx_commit(struct mapidump_fx *fx)
+{
+	struct mapidump_fx_frame	*frame = &fx->frames[fx->level];
+	char				*uuid;
+	char				*dn;
+
+	if (frame->open == false) return;
+	frame->open = false;
+
+	if (fx->failed == true) {
+		ocb_record_discard(fx->ocb_ctx);
+		return;
+	}
+
+	uuid = mapidump_fx_uuid(fx, frame);
+	dn = talloc_asprintf(frame->mem_ctx, "cn=%s,%s", uuid, fx->frames[fx->level - 1].dn);
+	if (ocb_record_set_dn(fx->ocb_ctx, dn, uuid) == -1) {
+		/* existing record: its children are skipped too */
+		return;
+	}
+	if (ocb_record_commit(fx->ocb_ctx) != 0) {
+		/* the ICS state must not be saved over missing records */
+		fx->failed = true;
+		return;
+	}
+	frame->dn = dn;
+}
+
+/**
+ * Start a child object of the current frame
+ */
+static enum MAPISTATUS mapidump_fx_push(struct mapidump_fx *fx, const char *objclass)
+{
+	struct mapidump_fx_frame	*frame;
+
+	/* properties of the parent object are complete */
+	mapidump_fx_commit(fx);
+
+	if (fx->level + 1 >= MAPIDUMP_FX_MAXDEPTH) {
+		DEBUG(0, ("FastTransfer stream nested too deeply\n"));
+		fx->failed = true;
+		return MAPI_E_CALL_FAILED;
+	}
+
+	fx->level++;
+	frame = &fx->frames[fx->level];
+	memset(frame, 0, sizeof (struct mapidump_fx_frame));
+	frame->mem_ctx = talloc_new(fx);
+	frame->objclass = objclass;
+	if (objclass && fx->frames[fx->level - 1].dn) {
+		frame->open = (ocb_record_new(fx->ocb_ctx, objclass) == 0);
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+ * End the current object
+ */
+static void mapidump_fx_pop(struct mapidump_fx *fx)
+{
+	if (!fx->level) return;
+
+	mapidump_fx_commit(fx);
+	talloc_free(fx->frames[fx->level].mem_ctx);
+	fx->level--;
+}
+
+/**
+ * End all objects up to the folder
+ */
+static void mapidump_fx_unwind(struct mapidump_fx *fx)
+{
+	while (fx->level) {
+		mapidump_fx_pop(fx);
+	}
+}
+
+static enum MAPISTATUS mapidump_fx_marker(uint32_t marker, void *priv)
+{
+	struct mapidump_fx	*fx = priv;
+
+	switch (marker) {
+	case StartMessage:
+	case StartFAIMsg:
+	case StartEmbed:
+		return mapidump_fx_push(fx, OCB_OBJCLASS_MESSAGE);
+	case NewAttach:
+		return mapidump_fx_push(fx, OCB_OBJCLASS_ATTACHMENT);
+	case StartRecip:
+		/* recipients are not stored, as with the table walk */
+		return mapidump_fx_push(fx, NULL);
+	case EndMessage:
+	case EndEmbed:
+	case EndAttach:
+	case EndToRecip:
+		mapidump_fx_pop(fx);
+		break;
+	case IncrSyncChg:
+	case IncrSyncChgPartial:
+		mapidump_fx_unwind(fx);
+		fx->mode = MAPIDUMP_FX_RECORD;
+		return mapidump_fx_push(fx, OCB_OBJCLASS_MESSAGE);
+	case IncrSyncStateBegin:
+		mapidump_fx_unwind(fx);
+		fx->mode = MAPIDUMP_FX_STATE;
+		break;
+	case IncrSyncDel:
+	case IncrSyncRead:
+	case IncrSyncProgressMode:
+	case IncrSyncProgressPerMsg:
+	case IncrSyncStateEnd:
+	case IncrSyncEnd:
+		mapidump_fx_unwind(fx);
+		fx->mode = MAPIDUMP_FX_DISCARD;
+		break;
+	}
+
+	return MAPI_E_SUCCESS;
+}
+
+static enum MAPISTATUS mapidump_fx_property(struct SPropValue prop, void *priv)
+{
+	struct mapidump_fx		*fx = priv;
+	struct mapidump_fx_frame	*frame = &fx->frames[fx->level];
+	struct mapi_SPropValue		mapi_prop;
+	DATA_BLOB			*blob = NULL;
+
+	switch (fx->mode) {
+	case MAPIDUMP_FX_DISCARD:
+		return MAPI_E_SUCCESS;
+	case MAPIDUMP_FX_STATE:
+		switch (prop.ulPropTag) {
+		case MetaTagIdsetGivenBinary:
+			blob = &fx->state.idset_given;
+			break;
+		case MetaTagCnsetSeen:
+			blob = &fx->state.cnset_seen;
+			break;
+		case MetaTagCnsetSeenFAI:
+			blob = &fx->state.cnset_seen_fai;
+			break;
+		case MetaTagCnsetRead:
+			blob = &fx->state.cnset_read;
+			break;
+		default:
+			return MAPI_E_SUCCESS;
+		}
+		blob->length = prop.value.bin.cb;
+		blob->data = talloc_memdup(fx, prop.value.bin.lpb, prop.value.bin.cb);
+		return MAPI_E_SUCCESS;
+	case MAPIDUMP_FX_RECORD:
+		break;
+	}
+
+	if (frame->open == false) return MAPI_E_SUCCESS;
+
+	/* keep the properties identifying the record */
+	switch (prop.ulPropTag) {
+	case PR_SOURCE_KEY:
+		blob = &frame->source_key;
+		break;
+	case PR_RECORD_KEY:
+		blob = &frame->record_key;
+		break;
+	case PR_SEARCH_KEY:
+		if (!frame->record_key.length) {
+			blob = &frame->record_key;
+		}
+		break;
+	case PR_ATTACH_NUM:
+		frame->attach_num = prop.value.l;
+		frame->has_attach_num = true;
+		break;
+	default:
+		break;
+	}
+	if (blob) {
+		blob->length = prop.value.bin.cb;
+		blob->data = talloc_memdup(frame->mem_ctx, prop.value.bin.lpb, prop.value.bin.cb);
+	}
+
+	/* values are only valid during the callback: ocb copies them */
+	memset(&mapi_prop, 0, sizeof (struct mapi_SPropValue));
+	cast_mapi_SPropValue(frame->mem_ctx, &mapi_prop, &prop);
+	ocb_record_add_property(fx->ocb_ctx, &mapi_prop);
+
+	return MAPI_E_SUCCESS;
+}
+
+/**
+ * Download and store a FastTransfer stream
+ */
+static enum MAPISTATUS mapidump_fx_download(struct mapidump_fx *fx, mapi_object_t *obj_ctx)
+{
+	enum MAPISTATUS			retval = MAPI_E_SUCCESS;
+	struct fx_parser_context	*parser;
+	enum TransferStatus		status = TransferStatus_Partial;
+	uint16_t			progress;
+	uint16_t			total;
+	DATA_BLOB			buffer;
+
+	parser = fxparser_init(fx, fx);
+	fxparser_set_marker_callback(parser, mapidump_fx_marker);
+	fxparser_set_property_callback(parser, mapidump_fx_property);
+	retval = fxparser_set_tag_mapping(parser, MetaTagIdsetGiven, MetaTagIdsetGivenBinary);
+	if (retval != MAPI_E_SUCCESS) {
+		talloc_free(parser);
+		return retval;
+	}
+
+	while (status != TransferStatus_Done) {
+		retval = FXGetBuffer(obj_ctx, 0, &status, &progress, &total, &buffer);
+		if (retval != MAPI_E_SUCCESS) break;
+		if (status == TransferStatus_Error) {
+			talloc_free(buffer.data);
+			retval = MAPI_E_CALL_FAILED;
+			break;
+		}
+		retval = fxparser_parse(parser, &buffer);
+		talloc_free(buffer.data);
+		if (retval != MAPI_E_SUCCESS) break;
+	}
+
+	if (retval != MAPI_E_SUCCESS) {
+		fx->failed = true;
+	}
+	mapidump_fx_unwind(fx);
+	talloc_free(parser);
+
+	if (retval == MAPI_E_SUCCESS && fx->failed == true) {
+		retval = MAPI_E_CALL_FAILED;
+	}
+
+	return retval;
+}
+
+/**
+ * Upload one property of a stored ICS state
+ */
+static enum MAPISTATUS mapidump_fx_upload_state(mapi_object_t *obj_sync, uint32_t property,
+						DATA_BLOB *blob)
+{
+	enum MAPISTATUS		retval;
+	DATA_BLOB		chunk;
+	uint32_t		offset;
+
+	if (!blob->length) return MAPI_E_SUCCESS;
+
+	retval = ICSSyncUploadStateBegin(obj_sync, (enum StateProperty)property, blob->length);
+	MAPI_RETVAL_IF(retval, retval, NULL);
+
+	for (offset = 0; offset < blob->length; offset += chunk.length) {
+		chunk.data = blob->data + offset;
+		chunk.length = blob->length - offset;
+		if (chunk.length > MAPIDUMP_STATE_CHUNK) {
+			chunk.length = MAPIDUMP_STATE_CHUNK;
+		}
+		retval = ICSSyncUploadStateContinue(obj_sync, chunk);
+		MAPI_RETVAL_IF(retval, retval, NULL);
+	}
+
+	return ICSSyncUploadStateEnd(obj_sync);
+}
+
+/**
+ * Backup the content of a folder with FastTransfer. Incremental
+ * backups only download the messages changed since the ICS state
+ * stored for the folder, and store the new state once the changes
+ * are written.
+ */
+static enum MAPISTATUS mapidump_fx_folder(TALLOC_CTX *mem_ctx,
+					  struct ocb_context *ocb_ctx,
+					  mapi_object_t *obj_store,
+					  struct mapidump_folder *folder,
+					  bool incremental)
+{
+	enum MAPISTATUS			retval;
+	struct mapidump_fx		*fx;
+	struct ocb_ics_state		state;
+	struct SPropTagArray		*SPropTagArray;
+	DATA_BLOB			restriction;
+	mapi_object_t			obj_folder;
+	mapi_object_t			obj_ctx;
+
+	fx = talloc_zero(mem_ctx, struct mapidump_fx);
+	fx->ocb_ctx = ocb_ctx;
+	fx->mode = MAPIDUMP_FX_RECORD;
+	fx->frames[0].dn = folder->dn;
+
+	mapi_object_init(&obj_folder);
+	mapi_object_init(&obj_ctx);
+
+	retval = OpenFolder(obj_store, folder->fid, &obj_folder);
+	if (retval != MAPI_E_SUCCESS) goto end;
+
+	if (incremental == true) {
+		ocb_state_load(ocb_ctx, fx, folder->uuid, &state);
+
+		SPropTagArray = set_SPropTagArray(fx, 0x0);
+		restriction.length = 0;
+		restriction.data = NULL;
+		retval = ICSSyncConfigure(&obj_folder, Contents, FastTransfer_Unicode,
+					  SynchronizationFlag_Unicode | SynchronizationFlag_NoDeletions |
+					  SynchronizationFlag_FAI | SynchronizationFlag_Normal |
+					  SynchronizationFlag_BestBody,
+					  Eid | Cn, restriction, SPropTagArray, &obj_ctx);
+		if (retval != MAPI_E_SUCCESS) goto end;
+
+		retval = mapidump_fx_upload_state(&obj_ctx, MetaTagIdsetGiven, &state.idset_given);
+		if (retval != MAPI_E_SUCCESS) goto end;
+		retval = mapidump_fx_upload_state(&obj_ctx, MetaTagCnsetSeen, &state.cnset_seen);
+		if (retval != MAPI_E_SUCCESS) goto end;
+		retval = mapidump_fx_upload_state(&obj_ctx, MetaTagCnsetSeenFAI, &state.cnset_seen_fai);
+		if (retval != MAPI_E_SUCCESS) goto end;
+		retval = mapidump_fx_upload_state(&obj_ctx, MetaTagCnsetRead, &state.cnset_read);
+		if (retval != MAPI_E_SUCCESS) goto end;
+	} else {
+		retval = FXCopyFolder(&obj_folder, 0, FastTransfer_Unicode, &obj_ctx);
+		if (retval != MAPI_E_SUCCESS) goto end;
+	}
+
+	retval = mapidump_fx_download(fx, &obj_ctx);
+	if (retval == MAPI_E_SUCCESS && incremental == true) {
+		if (ocb_state_save(ocb_ctx, folder->uuid, &fx->state) != 0) {
+			retval = MAPI_E_CALL_FAILED;
+		}
+	}
+
+end:
+	mapi_object_release(&obj_ctx);
+	mapi_object_release(&obj_folder);
+	talloc_free(fx);
+
+	return retval;
+}
+
+/**
+ * Backup the folders assigned to a worker on its own session
+ */
+static int mapidump_fx_worker(TALLOC_CTX *mem_ctx, struct mapidump_options *opts,
+			      struct mapidump_folder_list *list, uint32_t worker)
+{
+	enum MAPISTATUS			retval;
+	struct mapi_context		*mapi_ctx;
+	struct mapi_session		*session = NULL;
+	struct ocb_context		*ocb_ctx;
+	mapi_object_t			obj_store;
+	uint32_t			failed = 0;
+	uint32_t			i;
+
+	retval = MAPIInitialize(&mapi_ctx, opts->profdb);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("MAPIInitialize", retval);
+		return 1;
+	}
+
+	SetMAPIDumpData(mapi_ctx, opts->dumpdata);
+	if (opts->debug) {
+		SetMAPIDebugLevel(mapi_ctx, atoi(opts->debug));
+	}
+
+	retval = MapiLogonProvider(mapi_ctx, &session, opts->profname, opts->password, PROVIDER_ID_EMSMDB);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("MapiLogonEx", retval);
+		MAPIUninitialize(mapi_ctx);
+		return 1;
+	}
+
+	mapi_object_init(&obj_store);
+	retval = OpenMsgStore(session, &obj_store);
+	if (retval != MAPI_E_SUCCESS) {
+		mapi_errstr("OpenMsgStore", retval);
+		MAPIUninitialize(mapi_ctx);
+		return 1;
+	}
+
+	if (!(ocb_ctx = ocb_init(mem_ctx, opts->backupdb))) {
+		mapi_object_release(&obj_store);
+		MAPIUninitialize(mapi_ctx);
+		return 1;
+	}
+	ocb_set_batch(ocb_ctx, opts->batch, opts->incremental);
+
+	for (i = 0; i < list->count; i++) {
+		if (list->folders[i].worker != worker) continue;
+		retval = mapidump_fx_folder(mem_ctx, ocb_ctx, &obj_store, &list->folders[i], opts->incremental);
+		if (retval != MAPI_E_SUCCESS) {
+			fprintf(stderr, "Unable to backup %s: %s\n", list->folders[i].dn, mapi_get_errstr(retval));
+			failed++;
+		}
+	}
+
+	if (ocb_flush(ocb_ctx) != 0) {
+		fprintf(stderr, "Unable to write the last records to the backup database\n");
+		failed++;
+	}
+	ocb_release(ocb_ctx);
+	mapi_object_release(&obj_store);
+	MAPIUninitialize(mapi_ctx);
+
+	return failed ? 1 : 0;
+}
+
+static int mapidump_folder_cmp(const void *a, const void *b)
+{
+	const struct mapidump_folder	*fa = a;
+	const struct mapidump_folder	*fb = b;
+
+	if (fa->count == fb->count) return 0;
+	return (fa->count < fb->count) ? 1 : -1;
+}
+
+/**
+ * Backup folder content with workers running on separate sessions
+ *
+ * Folders are assigned largest first to the least loaded worker.
+ * Workers write to the same database: records are batched so the
+ * database lock is only held while a batch is written.
+ */
+static int mapidump_fx_run(TALLOC_CTX *mem_ctx, struct mapidump_options *opts,
+			   struct mapidump_folder_list *list)
+{
+	uint64_t	*load;
+	uint32_t	i;
+	uint32_t	w;
+	uint32_t	best;
+	pid_t		pid;
+	int		status;
+	int		ret = 0;
+
+	if (!list->count) return 0;
+	if (opts->workers > list->count) {
+		opts->workers = list->count;
+	}
+
+	qsort(list->folders, list->count, sizeof (struct mapidump_folder), mapidump_folder_cmp);
+	load = talloc_zero_array(mem_ctx, uint64_t, opts->workers);
+	for (i = 0; i < list->count; i++) {
+		for (w = 1, best = 0; w < opts->workers; w++) {
+			if (load[w] < load[best]) best = w;
+		}
+		list->folders[i].worker = best;
+		load[best] += list->folders[i].count;
+	}
+	talloc_free(load);
+
+	if (opts->workers == 1) {
+		return mapidump_fx_worker(mem_ctx, opts, list, 0);
+	}
+
+	for (w = 0; w < opts->workers; w++) {
+		switch (pid = fork()) {
+		case -1:
+			perror("fork");
+			ret = 1;
+			break;
+		case 0:
+			exit(mapidump_fx_worker(mem_ctx, opts, list, w));
+		default:
+			break;
+		}
+	}
+
+	while ((pid = wait(&status)) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+			ret = 1;
+		}
+	}
+
+	return ret;
 }
 
 
@@ -346,9 +937,12 @@ int main(int argc, const char *argv[])
 	struct ocb_context		*ocb_ctx = NULL;
 	struct mapi_context		*mapi_ctx;
 	struct mapi_session		*session = NULL;
+	struct mapidump_options		opts;
+	struct mapidump_folder_list	*list = NULL;
 	mapi_object_t			obj_store;
 	poptContext			pc;
 	int				opt;
+	int				ret = 0;
 	/* command line options */
 	const char			*opt_profdb = NULL;
 	char				*opt_profname = NULL;
@@ -356,10 +950,15 @@ int main(int argc, const char *argv[])
 	const char			*opt_backupdb = NULL;
 	const char			*opt_debug = NULL;
 	bool				opt_dumpdata = false;
+	bool				opt_fasttransfer = false;
+	bool				opt_incremental = false;
+	uint32_t			opt_workers = 1;
+	uint32_t			opt_batch = OCB_DEFAULT_BATCH;
 
 	enum {OPT_PROFILE_DB=1000, OPT_PROFILE, OPT_PASSWORD, 
 	      OPT_MAILBOX, OPT_CONFIG, OPT_BACKUPDB, OPT_PF,
-	      OPT_DEBUG, OPT_DUMPDATA};
+	      OPT_DEBUG, OPT_DUMPDATA, OPT_FASTTRANSFER, OPT_WORKERS,
+	      OPT_INCREMENTAL, OPT_BATCH};
 
 	struct poptOption long_options[] = {
 		POPT_AUTOHELP
@@ -369,6 +968,10 @@ int main(int argc, const char *argv[])
 		{"backup-db", 'b', POPT_ARG_STRING, NULL, OPT_BACKUPDB, "set the openchangebackup store path", NULL},
 		{"debuglevel", 0, POPT_ARG_STRING, NULL, OPT_DEBUG, "set the debug level", NULL},
 		{"dump-data", 0, POPT_ARG_NONE, NULL, OPT_DUMPDATA, "dump the hex data", NULL},
+		{"fast-transfer", 'F', POPT_ARG_NONE, NULL, OPT_FASTTRANSFER, "download folder content with FastTransfer", NULL},
+		{"workers", 'w', POPT_ARG_STRING, NULL, OPT_WORKERS, "number of FastTransfer folder workers (default: 1)", "N"},
+		{"incremental", 'i', POPT_ARG_NONE, NULL, OPT_INCREMENTAL, "only download changes since the last incremental backup", NULL},
+		{"batch", 0, POPT_ARG_STRING, NULL, OPT_BATCH, "number of records per database transaction (default: 1000)", "N"},
 		POPT_OPENCHANGE_VERSION
 		{ NULL, 0, 0, NULL, 0, NULL, NULL }
 	};
@@ -397,9 +1000,28 @@ int main(int argc, const char *argv[])
 		case OPT_BACKUPDB:
 			opt_backupdb = poptGetOptArg(pc);
 			break;
+		case OPT_FASTTRANSFER:
+			opt_fasttransfer = true;
+			break;
+		case OPT_WORKERS:
+			opt_workers = strtoul(poptGetOptArg(pc), NULL, 10);
+			opt_fasttransfer = true;
+			break;
+		case OPT_INCREMENTAL:
+			opt_incremental = true;
+			opt_fasttransfer = true;
+			break;
+		case OPT_BATCH:
+			opt_batch = strtoul(poptGetOptArg(pc), NULL, 10);
+			break;
 		}
 	}
 
+	if (!opt_workers) {
+		fprintf(stderr, "Invalid number of workers\n");
+		exit (1);
+	}
+
 	/* Sanity check on options */
 	if (!opt_profdb) {
 		opt_profdb = talloc_asprintf(mem_ctx, DEFAULT_PROFDB, getenv("HOME"));
@@ -441,6 +1063,18 @@ int main(int argc, const char *argv[])
 		talloc_free(mem_ctx);
 		exit(-1);
 	}
+	ocb_set_batch(ocb_ctx, opt_batch, opt_incremental);
+
+	/* FastTransfer workers open their own session */
+	opts.profdb = opt_profdb;
+	opts.profname = talloc_strdup(mem_ctx, opt_profname);
+	opts.password = opt_password;
+	opts.backupdb = opt_backupdb;
+	opts.debug = opt_debug;
+	opts.dumpdata = opt_dumpdata;
+	opts.incremental = opt_incremental;
+	opts.batch = opt_batch;
+	opts.workers = opt_workers;
 
 	/* We only need to log on EMSMDB to backup Mailbox store or Public Folders */
 	retval = MapiLogonProvider(mapi_ctx, &session, opt_profname, opt_password, PROVIDER_ID_EMSMDB);
@@ -458,13 +1092,20 @@ int main(int argc, const char *argv[])
 		exit (1);
 	}
 
-	retval = mapidump_walk(mem_ctx, ocb_ctx, &obj_store);
+	if (opt_fasttransfer == true) {
+		list = talloc_zero(mem_ctx, struct mapidump_folder_list);
+	}
+	retval = mapidump_walk(mem_ctx, ocb_ctx, &obj_store, list);
 
 	/* Uninitialize MAPI and OCB subsystem */
 	mapi_object_release(&obj_store);
 	MAPIUninitialize(mapi_ctx);
 	ocb_release(ocb_ctx);
+
+	if (list && retval == MAPI_E_SUCCESS) {
+		ret = mapidump_fx_run(mem_ctx, &opts, list);
+	}
 	talloc_free(mem_ctx);
 
-	return 0;
+	return ret;
 }
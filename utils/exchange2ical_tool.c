@@ -20,6 +20,7 @@
 */
 
 #include "libexchange2ical/libexchange2ical.h"
+#include <time.h>
 
 static void getRange(const char *range, struct tm *start, struct tm *end)
 {
@@ -47,6 +48,15 @@ static void getRange(const char *range, struct tm *start, struct tm *end)
 	return;
 }
 
+static uint64_t get_usec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 static char* read_stream(char *s, size_t size, void *d) 
 { 
   char *c = fgets(s, size, (FILE*)d);
@@ -69,6 +79,7 @@ int main(int argc, const char *argv[])
 	const char			*opt_icalsync = NULL;
 	const char			*opt_range = NULL;
 	bool				opt_dumpdata = false;
+	bool				opt_timing = false;
 	FILE 	 			*fp = NULL;
 	mapi_id_t			fid;
 	struct mapi_context		*mapi_ctx;
@@ -80,10 +91,11 @@ int main(int argc, const char *argv[])
 	icalcomponent			*ical;
 	icalcomponent			*vevent;
 	TALLOC_CTX			*mem_ctx;
+	uint64_t			usec;
 
 	
 
-	enum { OPT_PROFILE_DB=1000, OPT_PROFILE, OPT_PASSWORD, OPT_DEBUG, OPT_DUMPDATA, OPT_FILENAME, OPT_RANGE, OPT_ICALSYNC };
+	enum { OPT_PROFILE_DB=1000, OPT_PROFILE, OPT_PASSWORD, OPT_DEBUG, OPT_DUMPDATA, OPT_FILENAME, OPT_RANGE, OPT_ICALSYNC, OPT_TIMING };
 
 	struct poptOption long_options[] = {
 		POPT_AUTOHELP
@@ -95,6 +107,7 @@ int main(int argc, const char *argv[])
 		{ "range",	'R', POPT_ARG_STRING, NULL, OPT_RANGE,		"set the range of accepted start dates", 	NULL },
 		{ "debuglevel",	'd', POPT_ARG_STRING, NULL, OPT_DEBUG,		"set the debug level",				NULL },
 		{ "dump-data",	  0, POPT_ARG_NONE,   NULL, OPT_DUMPDATA,	"dump the hex data",				NULL },
+		{ "timing",	  0, POPT_ARG_NONE,   NULL, OPT_TIMING,		"report the export time on stderr",		NULL },
 		POPT_OPENCHANGE_VERSION
 		{ NULL,		  0, 0,		      NULL, 0,			NULL,					NULL }
 	};
@@ -128,6 +141,9 @@ int main(int argc, const char *argv[])
 		case OPT_DUMPDATA:
 			opt_dumpdata = true;
 			break;
+		case OPT_TIMING:
+			opt_timing = true;
+			break;
 		}
 	}
 	
@@ -207,12 +223,19 @@ int main(int argc, const char *argv[])
 		}
 	}
 	
+	usec = get_usec();
 	if(opt_range){
 		getRange(opt_range, &start, &end);
 		vcal = Exchange2IcalRange(&obj_folder, &start, &end);
 	} else {
 		vcal = Exchange2Ical(&obj_folder);
 	}
+	usec = get_usec() - usec;
+
+	if (opt_timing) {
+		fprintf(stderr, "exported %d events in %"PRIu64" usec\n",
+			vcal ? icalcomponent_count_components(vcal, ICAL_VEVENT_COMPONENT) : 0, usec);
+	}
 
 
 	if(vcal){				
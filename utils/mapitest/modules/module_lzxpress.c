@@ -88,8 +88,6 @@ _PUBLIC_ bool mapitest_lzxpress_validate_test_001(struct mapitest *mt)
 	ndr_pull = ndr_pull_init_blob(&blob, mt->mem_ctx);
 	ndr_set_flags(&ndr_pull->flags, LIBNDR_FLAG_NOALIGN|LIBNDR_FLAG_REF_ALLOC);
 	ndr_err = ndr_pull_mapi2k7_request(ndr_pull, NDR_SCALARS|NDR_BUFFERS, &request);
-	talloc_free(blob.data);
-	talloc_free(ndr_pull);
 	status = ndr_map_error2ntstatus(ndr_err);
 	if (NT_STATUS_IS_OK(status)) {
 		DEBUG(0, ("Success\n"));
@@ -99,6 +97,9 @@ _PUBLIC_ bool mapitest_lzxpress_validate_test_001(struct mapitest *mt)
 	ndr_push = ndr_push_init_ctx(mt->mem_ctx);
 	ndr_set_flags(&ndr_push->flags, LIBNDR_FLAG_NOALIGN|LIBNDR_FLAG_REF_ALLOC);
 	ndr_push_mapi_request(ndr_push, NDR_SCALARS|NDR_BUFFERS, request.mapi_request);
+	/* stream data in the request points into the pulled buffers */
+	talloc_free(blob.data);
+	talloc_free(ndr_pull);
 	ndr_comp = ndr_push_init_ctx(mt->mem_ctx);
 	ndr_push_lzxpress_compress(ndr_comp, ndr_push);
 	
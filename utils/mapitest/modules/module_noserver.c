@@ -1256,3 +1256,260 @@ _PUBLIC_ bool mapitest_noserver_proptagvalue(struct mapitest *mt)
 
 	return true;
 }
+
+#define	MT_COPYPROPS_COUNT	20
+
+/**
+   \details Build one property of every type the FastTransfer parser
+   delivers to its property callback, PT_OBJECT excepted: the parser
+   returns it as a binary overlaid on the object member, and callbacks
+   drop it.
+
+   \param mem_ctx pointer to the memory context
+   \param props pointer to an array of MT_COPYPROPS_COUNT properties
+ */
+static void mapitest_noserver_copyprops_fill(TALLOC_CTX *mem_ctx, struct SPropValue *props)
+{
+	struct FlatUID_r	*guid;
+	uint32_t		i;
+
+	memset(props, 0, sizeof (struct SPropValue) * MT_COPYPROPS_COUNT);
+
+	props[0].ulPropTag = PROP_TAG(PT_NULL, 0x6700);
+	props[1].ulPropTag = PROP_TAG(PT_SHORT, 0x6701);
+	props[1].value.i = 0x1234;
+	props[2].ulPropTag = PROP_TAG(PT_LONG, 0x6702);
+	props[2].value.l = 0x12345678;
+	props[3].ulPropTag = PROP_TAG(PT_DOUBLE, 0x6703);
+	props[3].value.dbl = 3;
+	props[4].ulPropTag = PROP_TAG(PT_BOOLEAN, 0x6704);
+	props[4].value.b = true;
+	props[5].ulPropTag = PROP_TAG(PT_I8, 0x6705);
+	props[5].value.d = 0x123456789ABCDEF0ULL;
+	props[6].ulPropTag = PROP_TAG(PT_ERROR, 0x6706);
+	props[6].value.err = MAPI_E_NOT_FOUND;
+	props[7].ulPropTag = PROP_TAG(PT_SYSTIME, 0x6707);
+	props[7].value.ft.dwLowDateTime = 0x12975909;
+	props[7].value.ft.dwHighDateTime = 0x01C5E2A4;
+	props[8].ulPropTag = PROP_TAG(PT_STRING8, 0x6708);
+	props[8].value.lpszA = talloc_strdup(mem_ctx, "string8 value");
+	props[9].ulPropTag = PROP_TAG(PT_UNICODE, 0x6709);
+	props[9].value.lpszW = talloc_strdup(mem_ctx, "unicode value");
+
+	props[10].ulPropTag = PROP_TAG(PT_CLSID, 0x670A);
+	props[10].value.lpguid = talloc_zero(mem_ctx, struct FlatUID_r);
+	for (i = 0; i < 16; i++) {
+		props[10].value.lpguid->ab[i] = i;
+	}
+
+	props[11].ulPropTag = PROP_TAG(PT_SVREID, 0x670B);
+	props[11].value.bin.cb = 21;
+	props[11].value.bin.lpb = talloc_array(mem_ctx, uint8_t, 21);
+	for (i = 0; i < 21; i++) {
+		props[11].value.bin.lpb[i] = 0x80 + i;
+	}
+
+	props[12].ulPropTag = PROP_TAG(PT_BINARY, 0x670C);
+	props[12].value.bin.cb = 9;
+	props[12].value.bin.lpb = talloc_array(mem_ctx, uint8_t, 9);
+	for (i = 0; i < 9; i++) {
+		props[12].value.bin.lpb[i] = 0x40 + i;
+	}
+
+	props[13].ulPropTag = PROP_TAG(PT_MV_SHORT, 0x670D);
+	props[13].value.MVi.cValues = 3;
+	props[13].value.MVi.lpi = talloc_array(mem_ctx, uint16_t, 3);
+	for (i = 0; i < 3; i++) {
+		props[13].value.MVi.lpi[i] = 0x100 + i;
+	}
+
+	props[14].ulPropTag = PROP_TAG(PT_MV_LONG, 0x670E);
+	props[14].value.MVl.cValues = 3;
+	props[14].value.MVl.lpl = talloc_array(mem_ctx, uint32_t, 3);
+	for (i = 0; i < 3; i++) {
+		props[14].value.MVl.lpl[i] = 0x10000 + i;
+	}
+
+	props[15].ulPropTag = PROP_TAG(PT_MV_SYSTIME, 0x670F);
+	props[15].value.MVft.cValues = 2;
+	props[15].value.MVft.lpft = talloc_array(mem_ctx, struct FILETIME, 2);
+	for (i = 0; i < 2; i++) {
+		props[15].value.MVft.lpft[i].dwLowDateTime = 0x1000 + i;
+		props[15].value.MVft.lpft[i].dwHighDateTime = 0x2000 + i;
+	}
+
+	props[16].ulPropTag = PROP_TAG(PT_MV_STRING8, 0x6710);
+	props[16].value.MVszA.cValues = 2;
+	props[16].value.MVszA.lppszA = talloc_array(mem_ctx, const char *, 2);
+	props[16].value.MVszA.lppszA[0] = talloc_strdup(props[16].value.MVszA.lppszA, "first string8");
+	props[16].value.MVszA.lppszA[1] = talloc_strdup(props[16].value.MVszA.lppszA, "second string8");
+
+	props[17].ulPropTag = PROP_TAG(PT_MV_UNICODE, 0x6711);
+	props[17].value.MVszW.cValues = 2;
+	props[17].value.MVszW.lppszW = talloc_array(mem_ctx, const char *, 2);
+	props[17].value.MVszW.lppszW[0] = talloc_strdup(props[17].value.MVszW.lppszW, "first unicode");
+	props[17].value.MVszW.lppszW[1] = talloc_strdup(props[17].value.MVszW.lppszW, "second unicode");
+
+	props[18].ulPropTag = PROP_TAG(PT_MV_BINARY, 0x6712);
+	props[18].value.MVbin.cValues = 2;
+	props[18].value.MVbin.lpbin = talloc_array(mem_ctx, struct Binary_r, 2);
+	for (i = 0; i < 2; i++) {
+		props[18].value.MVbin.lpbin[i].cb = 4 + i;
+		props[18].value.MVbin.lpbin[i].lpb = talloc_array(props[18].value.MVbin.lpbin, uint8_t, 4 + i);
+		memset(props[18].value.MVbin.lpbin[i].lpb, 0xA0 + i, 4 + i);
+	}
+
+	props[19].ulPropTag = PROP_TAG(PT_MV_CLSID, 0x6713);
+	props[19].value.MVguid.cValues = 2;
+	props[19].value.MVguid.lpguid = talloc_array(mem_ctx, struct FlatUID_r *, 2);
+	for (i = 0; i < 2; i++) {
+		guid = talloc_zero(props[19].value.MVguid.lpguid, struct FlatUID_r);
+		memset(guid->ab, 0xC0 + i, 16);
+		props[19].value.MVguid.lpguid[i] = guid;
+	}
+}
+
+/**
+   \details Compare a copied property with its reference and check
+   that every pointer of the copy belongs to the copy memory context
+
+   \param mem_ctx the memory context of the copy
+   \param copy pointer to the copied property
+   \param ref pointer to the reference property
+
+   \return true if the copy is complete, otherwise false
+ */
+static bool mapitest_noserver_copyprops_check(TALLOC_CTX *mem_ctx, struct SPropValue *copy, struct SPropValue *ref)
+{
+	uint32_t	i;
+
+	if (copy->ulPropTag != ref->ulPropTag) {
+		return false;
+	}
+
+	switch (ref->ulPropTag & 0xFFFF) {
+	case PT_NULL:
+		return true;
+	case PT_SHORT:
+		return copy->value.i == ref->value.i;
+	case PT_LONG:
+		return copy->value.l == ref->value.l;
+	case PT_DOUBLE:
+		return !memcmp(&copy->value.dbl, &ref->value.dbl, sizeof (ref->value.dbl));
+	case PT_BOOLEAN:
+		return copy->value.b == ref->value.b;
+	case PT_I8:
+		return copy->value.d == ref->value.d;
+	case PT_ERROR:
+		return copy->value.err == ref->value.err;
+	case PT_SYSTIME:
+		return !memcmp(&copy->value.ft, &ref->value.ft, sizeof (struct FILETIME));
+	case PT_STRING8:
+		return talloc_is_parent(mem_ctx, copy->value.lpszA) && !strcmp(copy->value.lpszA, ref->value.lpszA);
+	case PT_UNICODE:
+		return talloc_is_parent(mem_ctx, copy->value.lpszW) && !strcmp(copy->value.lpszW, ref->value.lpszW);
+	case PT_CLSID:
+		return talloc_is_parent(mem_ctx, copy->value.lpguid)
+			&& !memcmp(copy->value.lpguid, ref->value.lpguid, sizeof (struct FlatUID_r));
+	case PT_SVREID:
+	case PT_BINARY:
+		return copy->value.bin.cb == ref->value.bin.cb && talloc_is_parent(mem_ctx, copy->value.bin.lpb)
+			&& !memcmp(copy->value.bin.lpb, ref->value.bin.lpb, ref->value.bin.cb);
+	case PT_MV_SHORT:
+		return copy->value.MVi.cValues == ref->value.MVi.cValues && talloc_is_parent(mem_ctx, copy->value.MVi.lpi)
+			&& !memcmp(copy->value.MVi.lpi, ref->value.MVi.lpi, sizeof (uint16_t) * ref->value.MVi.cValues);
+	case PT_MV_LONG:
+		return copy->value.MVl.cValues == ref->value.MVl.cValues && talloc_is_parent(mem_ctx, copy->value.MVl.lpl)
+			&& !memcmp(copy->value.MVl.lpl, ref->value.MVl.lpl, sizeof (uint32_t) * ref->value.MVl.cValues);
+	case PT_MV_SYSTIME:
+		return copy->value.MVft.cValues == ref->value.MVft.cValues && talloc_is_parent(mem_ctx, copy->value.MVft.lpft)
+			&& !memcmp(copy->value.MVft.lpft, ref->value.MVft.lpft, sizeof (struct FILETIME) * ref->value.MVft.cValues);
+	case PT_MV_STRING8:
+		if (copy->value.MVszA.cValues != ref->value.MVszA.cValues) return false;
+		for (i = 0; i < ref->value.MVszA.cValues; i++) {
+			if (!talloc_is_parent(mem_ctx, copy->value.MVszA.lppszA[i])
+			    || strcmp(copy->value.MVszA.lppszA[i], ref->value.MVszA.lppszA[i])) {
+				return false;
+			}
+		}
+		return true;
+	case PT_MV_UNICODE:
+		if (copy->value.MVszW.cValues != ref->value.MVszW.cValues) return false;
+		for (i = 0; i < ref->value.MVszW.cValues; i++) {
+			if (!talloc_is_parent(mem_ctx, copy->value.MVszW.lppszW[i])
+			    || strcmp(copy->value.MVszW.lppszW[i], ref->value.MVszW.lppszW[i])) {
+				return false;
+			}
+		}
+		return true;
+	case PT_MV_BINARY:
+		if (copy->value.MVbin.cValues != ref->value.MVbin.cValues) return false;
+		for (i = 0; i < ref->value.MVbin.cValues; i++) {
+			if (copy->value.MVbin.lpbin[i].cb != ref->value.MVbin.lpbin[i].cb
+			    || !talloc_is_parent(mem_ctx, copy->value.MVbin.lpbin[i].lpb)
+			    || memcmp(copy->value.MVbin.lpbin[i].lpb, ref->value.MVbin.lpbin[i].lpb, ref->value.MVbin.lpbin[i].cb)) {
+				return false;
+			}
+		}
+		return true;
+	case PT_MV_CLSID:
+		if (copy->value.MVguid.cValues != ref->value.MVguid.cValues) return false;
+		for (i = 0; i < ref->value.MVguid.cValues; i++) {
+			if (!talloc_is_parent(mem_ctx, copy->value.MVguid.lpguid[i])
+			    || memcmp(copy->value.MVguid.lpguid[i], ref->value.MVguid.lpguid[i], sizeof (struct FlatUID_r))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/**
+     \details Test the mapi_copy_spropvalues() function
+
+   This function:
+   -# Builds one property of every type the FastTransfer parser returns
+   -# Copies the properties and releases the source values, as the
+      parser does after each property callback
+   -# Checks that the copies are complete and owned by the destination
+
+   \param mt pointer on the top-level mapitest structure
+
+   \return true on success, otherwise false
+*/
+_PUBLIC_ bool mapitest_noserver_copyprops(struct mapitest *mt)
+{
+	TALLOC_CTX		*src_ctx;
+	TALLOC_CTX		*dst_ctx;
+	struct SPropValue	ref[MT_COPYPROPS_COUNT];
+	struct SPropValue	src[MT_COPYPROPS_COUNT];
+	struct SPropValue	*dst;
+	uint32_t		i;
+	bool			ret = true;
+
+	src_ctx = talloc_named(NULL, 0, "mapitest_noserver_copyprops source");
+	dst_ctx = talloc_named(mt->mem_ctx, 0, "mapitest_noserver_copyprops destination");
+
+	mapitest_noserver_copyprops_fill(dst_ctx, ref);
+	mapitest_noserver_copyprops_fill(src_ctx, src);
+
+	dst = talloc_array(dst_ctx, struct SPropValue, MT_COPYPROPS_COUNT);
+	mapi_copy_spropvalues(dst, src, dst, MT_COPYPROPS_COUNT);
+	talloc_free(src_ctx);
+
+	for (i = 0; i < MT_COPYPROPS_COUNT; i++) {
+		if (!mapitest_noserver_copyprops_check(dst, &dst[i], &ref[i])) {
+			mapitest_print(mt, "* %-40s: [FAILURE] 0x%.8x\n", "mapi_copy_spropvalues", ref[i].ulPropTag);
+			ret = false;
+		}
+	}
+	if (ret) {
+		mapitest_print(mt, "* %-40s: [SUCCESS]\n", "mapi_copy_spropvalues");
+	}
+
+	talloc_free(dst_ctx);
+
+	return ret;
+}
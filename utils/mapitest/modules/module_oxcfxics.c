@@ -152,6 +152,156 @@ cleanup:
 	return ret;
 }
 
+/**
+   \details Test the FastTransferDestinationPutBuffer (0x54) operation
+   with a message split across many buffers
+
+   This function:
+   -# Log on private message store
+   -# Creates a test folder
+   -# Uploads a message with a PT_SVREID property in small buffers
+   -# Opens the uploaded message and checks its properties
+ */
+_PUBLIC_ bool mapitest_oxcfxics_DestPutBuffer(struct mapitest *mt)
+{
+	enum MAPISTATUS			retval;
+	struct mt_common_tf_ctx		*context;
+	mapi_object_t			obj_htable;
+	mapi_object_t			destfolder;
+	mapi_object_t			obj_ctable;
+	mapi_object_t			obj_message;
+	struct fx_import_context	*fx_ctx = NULL;
+	struct fx_import_message	message;
+	struct SPropValue		props[3];
+	struct SPropTagArray		*SPropTagArray;
+	struct SPropValue		*lpProps;
+	struct SRow			aRow;
+	struct SRowSet			SRowSet;
+	struct Binary_r			svreid;
+	const struct Binary_r		*bin;
+	const char			*subject;
+	uint8_t				svreid_data[21];
+	uint32_t			count;
+	uint32_t			i;
+	bool				ret = true;
+
+	/* Logon */
+	if (! mapitest_common_setup(mt, &obj_htable, NULL)) {
+		return false;
+	}
+
+	context = mt->priv;
+
+	/* Create destfolder */
+	mapi_object_init(&destfolder);
+	mapi_object_init(&obj_ctable);
+	mapi_object_init(&obj_message);
+	retval = CreateFolder(&(context->obj_test_folder), FOLDER_GENERIC,
+			      "DestPutBufferFolder", NULL /*folder comment*/,
+			      OPEN_IF_EXISTS, &destfolder);
+	mapitest_print_retval_clean(mt, "Create DestPutBufferFolder", retval);
+	if (retval != MAPI_E_SUCCESS) {
+		ret = false;
+		goto cleanup;
+	}
+
+	/* Upload the message in buffers smaller than its values */
+	for (i = 0; i < sizeof (svreid_data); i++) {
+		svreid_data[i] = 0x80 + i;
+	}
+	svreid.cb = sizeof (svreid_data);
+	svreid.lpb = svreid_data;
+	set_SPropValue_proptag(&props[0], PR_MESSAGE_CLASS_UNICODE, (const void *)"IPM.Note");
+	set_SPropValue_proptag(&props[1], PR_SUBJECT_UNICODE, (const void *)MT_MAIL_SUBJECT);
+	set_SPropValue_proptag(&props[2], PidTagSentMailSvrEID, (const void *)&svreid);
+	memset(&message, 0, sizeof (struct fx_import_message));
+	message.cValues = 3;
+	message.lpProps = props;
+
+	retval = fximport_init(mt->mem_ctx, &destfolder, &fx_ctx);
+	mapitest_print_retval_clean(mt, "fximport_init", retval);
+	if (retval != MAPI_E_SUCCESS) {
+		ret = false;
+		goto cleanup;
+	}
+	retval = fximport_set_buffer_size(fx_ctx, 8);
+	if (retval == MAPI_E_SUCCESS) {
+		retval = fximport_add_message(fx_ctx, &message);
+	}
+	if (retval == MAPI_E_SUCCESS) {
+		retval = fximport_commit(fx_ctx);
+	}
+	mapitest_print_retval_clean(mt, "FXPutBuffer", retval);
+	if (retval != MAPI_E_SUCCESS) {
+		ret = false;
+		goto cleanup;
+	}
+
+	/* Open the uploaded message */
+	retval = GetContentsTable(&destfolder, &obj_ctable, 0, &count);
+	mapitest_print_retval_clean(mt, "GetContentsTable", retval);
+	if (retval != MAPI_E_SUCCESS || count != 1) {
+		ret = false;
+		goto cleanup;
+	}
+
+	SPropTagArray = set_SPropTagArray(mt->mem_ctx, 0x1, PR_MID);
+	retval = SetColumns(&obj_ctable, SPropTagArray);
+	MAPIFreeBuffer(SPropTagArray);
+	if (retval == MAPI_E_SUCCESS) {
+		retval = QueryRows(&obj_ctable, 1, TBL_NOADVANCE, &SRowSet);
+	}
+	mapitest_print_retval_clean(mt, "QueryRows", retval);
+	if (retval != MAPI_E_SUCCESS || SRowSet.cRows != 1) {
+		ret = false;
+		goto cleanup;
+	}
+
+	retval = OpenMessage(&destfolder, mapi_object_get_id(&destfolder),
+			     SRowSet.aRow[0].lpProps[0].value.d, &obj_message, 0);
+	mapitest_print_retval_clean(mt, "OpenMessage", retval);
+	if (retval != MAPI_E_SUCCESS) {
+		ret = false;
+		goto cleanup;
+	}
+
+	/* Check the uploaded properties */
+	SPropTagArray = set_SPropTagArray(mt->mem_ctx, 0x2, PR_SUBJECT_UNICODE, PidTagSentMailSvrEID);
+	retval = GetProps(&obj_message, MAPI_UNICODE, SPropTagArray, &lpProps, &count);
+	MAPIFreeBuffer(SPropTagArray);
+	mapitest_print_retval_clean(mt, "GetProps", retval);
+	if (retval != MAPI_E_SUCCESS) {
+		ret = false;
+		goto cleanup;
+	}
+
+	aRow.cValues = count;
+	aRow.lpProps = lpProps;
+	subject = find_SPropValue_data(&aRow, PR_SUBJECT_UNICODE);
+	if (!subject || strcmp(subject, MT_MAIL_SUBJECT)) {
+		mapitest_print(mt, "* %-35s: unexpected subject\n", "PR_SUBJECT_UNICODE");
+		ret = false;
+	}
+
+	bin = find_SPropValue_data(&aRow, PidTagSentMailSvrEID);
+	if (!bin || bin->cb != svreid.cb || memcmp(bin->lpb, svreid.lpb, svreid.cb)) {
+		mapitest_print(mt, "* %-35s: unexpected value\n", "PidTagSentMailSvrEID");
+		ret = false;
+	}
+	MAPIFreeBuffer(lpProps);
+
+cleanup:
+	/* Cleanup and release */
+	talloc_free(fx_ctx);
+	mapi_object_release(&obj_message);
+	mapi_object_release(&obj_ctable);
+	mapi_object_release(&destfolder);
+	mapi_object_release(&obj_htable);
+	mapitest_common_cleanup(mt);
+
+	return ret;
+}
+
 /**
    \details Test the FastTransferCopyFolder (0x4C), FastTransferGetBuffer (0x4E) and TellVersion (0x86) operations
 
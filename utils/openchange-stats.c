@@ -0,0 +1,272 @@
+/*
+   Dump OpenChange EMSMDB server ROP statistics
+
+   OpenChange Project
+
+   Copyright (C) agent 2026
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "mapiproxy/servers/default/emsmdb/emsmdbp_stats.h"
+#include <talloc.h>
+#include <core/ntstatus.h>
+#include <popt.h>
+#include <param.h>
+
+/**
+   \file openchange-stats.c
+
+   \brief Aggregate and dump the per-ROP statistics collected by the
+   emsmdb server processes
+ */
+
+/**
+   \details Merge the statistics of one server process
+
+   \param total pointer to the aggregated statistics
+   \param filename path of the statistics file to merge
+   \param alive_only only merge statistics from running processes
+
+   \return true on success, otherwise false
+ */
+static bool stats_merge(struct emsmdbp_stats *total, const char *filename, bool alive_only)
+{
+	struct emsmdbp_stats	*stats;
+	struct stat		st;
+	uint32_t		i;
+	uint32_t		j;
+	int			fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1) return false;
+
+	if (fstat(fd, &st) == -1 || st.st_size != sizeof (struct emsmdbp_stats)) {
+		close(fd);
+		return false;
+	}
+
+	stats = mmap(NULL, sizeof (struct emsmdbp_stats), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (stats == MAP_FAILED) return false;
+
+	if (stats->magic != EMSMDBP_STATS_MAGIC || stats->version != EMSMDBP_STATS_VERSION) {
+		munmap(stats, sizeof (struct emsmdbp_stats));
+		return false;
+	}
+
+	if (alive_only && kill(stats->pid, 0) == -1 && errno == ESRCH) {
+		munmap(stats, sizeof (struct emsmdbp_stats));
+		return false;
+	}
+
+	if (!total->start_time || stats->start_time < total->start_time) {
+		total->start_time = stats->start_time;
+	}
+	total->transactions += stats->transactions;
+	total->request_bytes += stats->request_bytes;
+	total->response_bytes += stats->response_bytes;
+	total->transaction_usec += stats->transaction_usec;
+	total->backend_usec += stats->backend_usec;
+	total->ndr_usec += stats->ndr_usec;
+	total->rpcs += stats->rpcs;
+	total->chained_buffers += stats->chained_buffers;
+
+	for (i = 0; i < EMSMDBP_STATS_ROPS; i++) {
+		total->rops[i].calls += stats->rops[i].calls;
+		total->rops[i].errors += stats->rops[i].errors;
+		total->rops[i].usec += stats->rops[i].usec;
+		if (stats->rops[i].usec_max > total->rops[i].usec_max) {
+			total->rops[i].usec_max = stats->rops[i].usec_max;
+		}
+		total->rops[i].backend_usec += stats->rops[i].backend_usec;
+		total->rops[i].response_bytes += stats->rops[i].response_bytes;
+		for (j = 0; j < EMSMDBP_STATS_BUCKETS; j++) {
+			total->rops[i].histogram[j] += stats->rops[i].histogram[j];
+		}
+	}
+
+	munmap(stats, sizeof (struct emsmdbp_stats));
+
+	return true;
+}
+
+
+/**
+   \details Estimate a latency percentile from the histogram
+
+   \param rop pointer to the ROP statistics
+   \param percent the percentile to compute
+
+   \return upper bound of the bucket holding the percentile, in
+   microseconds
+ */
+static uint64_t stats_percentile(struct emsmdbp_stats_rop *rop, uint32_t percent)
+{
+	uint64_t	threshold;
+	uint64_t	count;
+	uint32_t	i;
+
+	threshold = (rop->calls * percent + 99) / 100;
+	for (i = 0, count = 0; i < EMSMDBP_STATS_BUCKETS; i++) {
+		count += rop->histogram[i];
+		if (count >= threshold) {
+			return (uint64_t)2 << i;
+		}
+	}
+
+	return rop->usec_max;
+}
+
+
+/**
+   \details Print the aggregated statistics
+
+   \param total pointer to the aggregated statistics
+   \param processes number of server processes merged
+   \param histogram whether latency histograms should be printed
+ */
+static void stats_dump(struct emsmdbp_stats *total, uint32_t processes, bool histogram)
+{
+	struct emsmdbp_stats_rop	*rop;
+	uint32_t			i;
+	uint32_t			j;
+
+	printf("Processes:          %u\n", processes);
+	printf("RPC calls:          %"PRIu64"\n", total->rpcs);
+	printf("Transactions:       %"PRIu64"\n", total->transactions);
+	printf("  chained buffers:  %"PRIu64"\n", total->chained_buffers);
+	printf("Request bytes:      %"PRIu64"\n", total->request_bytes);
+	printf("Response bytes:     %"PRIu64"\n", total->response_bytes);
+	printf("Transaction time:   %"PRIu64" usec\n", total->transaction_usec);
+	printf("  mapistore:        %"PRIu64" usec\n", total->backend_usec);
+	printf("  server:           %"PRIu64" usec\n", total->transaction_usec - total->backend_usec);
+	printf("NDR time:           %"PRIu64" usec\n\n", total->ndr_usec);
+
+	printf("%-6s %10s %8s %10s %10s %10s %10s %9s %10s\n", "ROP", "calls", "errors",
+	       "avg(us)", "p50(us)", "p99(us)", "max(us)", "backend%", "avg bytes");
+	for (i = 0; i < EMSMDBP_STATS_ROPS; i++) {
+		rop = &total->rops[i];
+		if (!rop->calls) continue;
+
+		printf("0x%.2x   %10"PRIu64" %8"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %8"PRIu64"%% %10"PRIu64"\n",
+		       i, rop->calls, rop->errors, rop->usec / rop->calls,
+		       stats_percentile(rop, 50), stats_percentile(rop, 99), rop->usec_max,
+		       rop->usec ? (rop->backend_usec * 100) / rop->usec : 0,
+		       rop->response_bytes / rop->calls);
+
+		if (histogram == false) continue;
+		for (j = 0; j < EMSMDBP_STATS_BUCKETS; j++) {
+			if (!rop->histogram[j]) continue;
+			printf("\t< %10"PRIu64" us: %"PRIu64"\n", (uint64_t)2 << j, rop->histogram[j]);
+		}
+	}
+}
+
+
+int main(int argc, const char *argv[])
+{
+	TALLOC_CTX		*mem_ctx;
+	struct loadparm_context	*lp_ctx;
+	struct emsmdbp_stats	*total;
+	poptContext		pc;
+	int			opt;
+	DIR			*dir;
+	struct dirent		*entry;
+	char			*filename;
+	const char		*opt_dir = NULL;
+	bool			opt_histogram = false;
+	bool			opt_all = false;
+	uint32_t		processes = 0;
+	size_t			len;
+
+	enum { OPT_DIR=1000, OPT_HISTOGRAM, OPT_ALL };
+
+	struct poptOption long_options[] = {
+		POPT_AUTOHELP
+		{ "stats-dir", 'D', POPT_ARG_STRING, NULL, OPT_DIR, "set the statistics directory", "PATH" },
+		{ "histogram", 'H', POPT_ARG_NONE, NULL, OPT_HISTOGRAM, "dump latency histograms", NULL },
+		{ "all", 'a', POPT_ARG_NONE, NULL, OPT_ALL, "include terminated processes", NULL },
+		{ NULL, 0, 0, NULL, 0, NULL, NULL }
+	};
+
+	mem_ctx = talloc_named(NULL, 0, "openchange-stats");
+	lp_ctx = loadparm_init_global(true);
+
+	pc = poptGetContext("openchange-stats", argc, argv, long_options, 0);
+	while ((opt = poptGetNextOpt(pc)) != -1) {
+		switch (opt) {
+		case OPT_DIR:
+			opt_dir = poptGetOptArg(pc);
+			break;
+		case OPT_HISTOGRAM:
+			opt_histogram = true;
+			break;
+		case OPT_ALL:
+			opt_all = true;
+			break;
+		}
+	}
+
+	if (!opt_dir) {
+		opt_dir = lpcfg_parm_string(lp_ctx, NULL, "dcerpc_mapiproxy", "stats_dir");
+		if (!opt_dir) {
+			opt_dir = talloc_asprintf(mem_ctx, "%s/%s", lpcfg_private_dir(lp_ctx), EMSMDBP_STATS_DIRNAME);
+		}
+	}
+
+	dir = opendir(opt_dir);
+	if (!dir) {
+		fprintf(stderr, "Unable to open statistics directory %s: %s\n", opt_dir, strerror(errno));
+		poptFreeContext(pc);
+		talloc_free(mem_ctx);
+		exit (1);
+	}
+
+	total = talloc_zero(mem_ctx, struct emsmdbp_stats);
+	while ((entry = readdir(dir))) {
+		len = strlen(entry->d_name);
+		if (len <= strlen(EMSMDBP_STATS_SUFFIX) ||
+		    strcmp(entry->d_name + len - strlen(EMSMDBP_STATS_SUFFIX), EMSMDBP_STATS_SUFFIX)) {
+			continue;
+		}
+		filename = talloc_asprintf(mem_ctx, "%s/%s", opt_dir, entry->d_name);
+		if (stats_merge(total, filename, !opt_all) == true) {
+			processes++;
+		}
+		talloc_free(filename);
+	}
+	closedir(dir);
+
+	stats_dump(total, processes, opt_histogram);
+
+	poptFreeContext(pc);
+	talloc_free(mem_ctx);
+
+	return 0;
+}